@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include <stdlib.h>
+
+#include <board.h>
+
+#ifdef RT_USING_FINSH
+#include <msh.h>
+#endif
+
+#if defined(RT_USING_DFS) && defined(RT_USING_DFS_ELMFAT) && defined(BSP_USING_HOST_BLK)
+#include <dfs_fs.h>
+#endif
+
+#define SIM_MAIN_THREAD_STACK_SIZE  8192
+#define SIM_MAIN_THREAD_PRIORITY    (RT_THREAD_PRIORITY_MAX / 3)
+
+static void sim_mount(void)
+{
+#if defined(RT_USING_DFS) && defined(RT_USING_DFS_ELMFAT) && defined(BSP_USING_HOST_BLK)
+    if (rt_device_find(BSP_HOST_BLK_NAME) == RT_NULL)
+    {
+        return;
+    }
+
+    if (dfs_mount(BSP_HOST_BLK_NAME, "/", "elm", 0, RT_NULL) != 0)
+    {
+        rt_kprintf("mount %s failed, format it by 'mkfs -t elm %s' and reboot\n",
+                   BSP_HOST_BLK_NAME, BSP_HOST_BLK_NAME);
+    }
+#endif
+}
+
+static void sim_main_thread_entry(void *parameter)
+{
+#ifdef RT_USING_COMPONENTS_INIT
+    rt_components_init();
+#endif
+
+#ifdef RT_USING_SMP
+    rt_hw_secondary_cpu_up();
+#endif
+
+    sim_mount();
+
+#ifdef RT_USING_FINSH
+    /* the batch mode, such as 'rtthread.elf -c "utest_run testcases.perf"' */
+    if (bsp_options.command != RT_NULL)
+    {
+        int result;
+        char *command = rt_strdup(bsp_options.command);
+
+        RT_ASSERT(command != RT_NULL);
+        result = msh_exec(command, rt_strlen(command));
+        rt_free(command);
+
+        /* some commands return void, only the failure of msh is reported */
+        exit(result < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+#endif
+}
+
+void rt_application_init(void)
+{
+    rt_thread_t tid;
+
+    tid = rt_thread_create("main", sim_main_thread_entry, RT_NULL,
+                           SIM_MAIN_THREAD_STACK_SIZE, SIM_MAIN_THREAD_PRIORITY, 20);
+    RT_ASSERT(tid != RT_NULL);
+
+    rt_thread_startup(tid);
+}
+
+/* the same as the one of the components, without the main() of the user */
+int rtthread_startup(void)
+{
+    rt_hw_interrupt_disable();
+
+    rt_hw_board_init();
+    rt_show_version();
+
+    rt_system_timer_init();
+    rt_system_scheduler_init();
+#ifdef RT_USING_SIGNALS
+    rt_system_signal_init();
+#endif
+
+    rt_application_init();
+
+    rt_system_timer_thread_init();
+    rt_thread_idle_init();
+
+#ifdef RT_USING_SMP
+    rt_hw_spin_lock(&_cpus_lock);
+#endif
+
+    rt_system_scheduler_start();
+
+    /* never reach here */
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (rt_hw_board_options(argc, argv) != RT_EOK)
+    {
+        return EXIT_FAILURE;
+    }
+
+    rtthread_startup();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <board.h>
+
+struct bsp_options bsp_options;
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-d image] [-c command]\n"
+           "  -d image    the image file of the block device\n"
+           "  -c command  run the command of msh and exit\n", name);
+}
+
+int rt_hw_board_options(int argc, char **argv)
+{
+    int opt;
+
+    bsp_options.argc = argc;
+    bsp_options.argv = argv;
+#ifdef BSP_USING_HOST_BLK
+    bsp_options.blk_path = BSP_HOST_BLK_PATH;
+#endif
+
+    while ((opt = getopt(argc, argv, "d:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            bsp_options.blk_path = optarg;
+            break;
+        case 'c':
+            bsp_options.command = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return -RT_EINVAL;
+        }
+    }
+
+    return RT_EOK;
+}
+
+void rt_hw_board_init(void)
+{
+    void *heap;
+
+    rt_hw_interrupt_init();
+
+    /* the heap is allocated from the host before any thread runs */
+    heap = malloc(BSP_HEAP_SIZE * 1024 * 1024);
+    RT_ASSERT(heap != RT_NULL);
+    rt_system_heap_init(heap, (void *)((rt_ubase_t)heap + BSP_HEAP_SIZE * 1024 * 1024));
+
+#ifdef RT_USING_IDLE_HOOK
+    rt_thread_idle_sethook(rt_hw_cpu_idle);
+#endif
+
+#ifdef RT_USING_COMPONENTS_INIT
+    rt_components_board_init();
+#endif
+
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_DEVICE)
+    rt_console_set_device(RT_CONSOLE_DEVICE_NAME);
+#endif
+}
+
+void rt_hw_cpu_shutdown(void)
+{
+    exit(EXIT_SUCCESS);
+}
+
+void rt_hw_cpu_reset(void)
+{
+    execv("/proc/self/exe", bsp_options.argv);
+    exit(EXIT_FAILURE);
+}
+
+static int cmd_exit(int argc, char **argv)
+{
+    exit(argc > 1 ? atoi(argv[1]) : EXIT_SUCCESS);
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_exit, exit, exit the simulator);
+
+static int cmd_reboot(int argc, char **argv)
+{
+    rt_hw_cpu_reset();
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_reboot, reboot, restart the simulator);
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <rtdef.h>
+#include <cpuport.h>
+
+#define BSP_IRQ_CONSOLE     (SIM_IRQ_DEVICE_BASE + 0)
+
+/* the options of the command line */
+struct bsp_options
+{
+    int argc;
+    char **argv;
+
+    /* -d <file>: the image file of the block device */
+    const char *blk_path;
+    /* -c <command>: run the command of msh and exit */
+    const char *command;
+};
+
+extern struct bsp_options bsp_options;
+
+int rt_hw_board_options(int argc, char **argv);
+void rt_hw_board_init(void);
+
+#endif /* __BOARD_H__ */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <board.h>
+
+#define DBG_TAG "drv.blk"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#define HOST_BLK_SECTOR_SIZE    512
+
+struct host_blk_device
+{
+    struct rt_device parent;
+
+    int fd;
+    rt_uint64_t sector_count;
+};
+
+static struct host_blk_device host_blk;
+
+static rt_ssize_t host_blk_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    ssize_t ret;
+    struct host_blk_device *blk = (struct host_blk_device *)dev;
+
+    if (pos + size > blk->sector_count)
+    {
+        return 0;
+    }
+
+    /* the calls of the host block the thread only, as a DMA transfer does */
+    ret = pread(blk->fd, buffer, size * HOST_BLK_SECTOR_SIZE, (off_t)pos * HOST_BLK_SECTOR_SIZE);
+
+    return ret < 0 ? 0 : ret / HOST_BLK_SECTOR_SIZE;
+}
+
+static rt_ssize_t host_blk_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    ssize_t ret;
+    struct host_blk_device *blk = (struct host_blk_device *)dev;
+
+    if (pos + size > blk->sector_count)
+    {
+        return 0;
+    }
+
+    ret = pwrite(blk->fd, buffer, size * HOST_BLK_SECTOR_SIZE, (off_t)pos * HOST_BLK_SECTOR_SIZE);
+
+    return ret < 0 ? 0 : ret / HOST_BLK_SECTOR_SIZE;
+}
+
+static rt_err_t host_blk_control(rt_device_t dev, int cmd, void *args)
+{
+    rt_err_t status = RT_EOK;
+    struct host_blk_device *blk = (struct host_blk_device *)dev;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+        {
+            struct rt_device_blk_geometry *geometry = (struct rt_device_blk_geometry *)args;
+
+            if (geometry == RT_NULL)
+            {
+                status = -RT_ERROR;
+                break;
+            }
+
+            geometry->bytes_per_sector = HOST_BLK_SECTOR_SIZE;
+            geometry->block_size = HOST_BLK_SECTOR_SIZE;
+            geometry->sector_count = blk->sector_count;
+        }
+        break;
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        fdatasync(blk->fd);
+        break;
+    default:
+        status = -RT_EINVAL;
+        break;
+    }
+
+    return status;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops host_blk_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    host_blk_read,
+    host_blk_write,
+    host_blk_control
+};
+#endif
+
+int rt_hw_host_blk_init(void)
+{
+    int fd;
+    struct stat st;
+    const char *path = bsp_options.blk_path;
+    rt_device_t dev = &host_blk.parent;
+
+    if (path == RT_NULL)
+    {
+        return -RT_ENOSYS;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        LOG_E("open the image %s failed", path);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -RT_EIO;
+    }
+
+    /* a new image is sparse, it is formatted by mkfs in the simulator */
+    if (st.st_size == 0)
+    {
+        st.st_size = (off_t)BSP_HOST_BLK_SIZE * 1024 * 1024;
+        if (ftruncate(fd, st.st_size) != 0)
+        {
+            LOG_E("create the image %s failed", path);
+            close(fd);
+            return -RT_EIO;
+        }
+    }
+
+    host_blk.fd = fd;
+    host_blk.sector_count = st.st_size / HOST_BLK_SECTOR_SIZE;
+
+    dev->type = RT_Device_Class_Block;
+#ifdef RT_USING_DEVICE_OPS
+    dev->ops = &host_blk_ops;
+#else
+    dev->read = host_blk_read;
+    dev->write = host_blk_write;
+    dev->control = host_blk_control;
+#endif
+
+    LOG_I("%s: %s, %u MB", BSP_HOST_BLK_NAME, path, (rt_uint32_t)(st.st_size >> 20));
+
+    return rt_device_register(dev, BSP_HOST_BLK_NAME, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_STANDALONE);
+}
+INIT_DEVICE_EXPORT(rt_hw_host_blk_init);
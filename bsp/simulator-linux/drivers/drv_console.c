@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <board.h>
+
+#define CONSOLE_RX_BUFSZ    256
+
+struct sim_console
+{
+    struct rt_device parent;
+
+    /* written by the host reader thread, read by the threads of RT-Thread */
+    char rx_buf[CONSOLE_RX_BUFSZ];
+    volatile rt_uint32_t rx_put;
+    volatile rt_uint32_t rx_get;
+};
+
+static struct sim_console console;
+static struct termios console_termios;
+
+static void console_termios_restore(void)
+{
+    tcsetattr(STDIN_FILENO, TCSANOW, &console_termios);
+}
+
+static void console_termios_init(void)
+{
+    struct termios raw;
+
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &console_termios) != 0)
+    {
+        return;
+    }
+
+    /* finsh echoes and edits the line itself, ^C still kills the simulator */
+    raw = console_termios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0)
+    {
+        atexit(console_termios_restore);
+    }
+}
+
+static void *console_rx_entry(void *parameter)
+{
+    char ch;
+    rt_uint32_t put;
+
+    rt_hw_host_thread_init();
+
+    while (read(STDIN_FILENO, &ch, 1) == 1)
+    {
+        put = console.rx_put;
+
+        /* drop the input when the buffer is full, as an overrun UART does */
+        if (put - __atomic_load_n(&console.rx_get, __ATOMIC_ACQUIRE) < CONSOLE_RX_BUFSZ)
+        {
+            console.rx_buf[put % CONSOLE_RX_BUFSZ] = ch;
+            __atomic_store_n(&console.rx_put, put + 1, __ATOMIC_RELEASE);
+        }
+
+        rt_hw_interrupt_raise(BSP_IRQ_CONSOLE, 1);
+    }
+
+    /* EOF of the host, the console has no more input */
+    return RT_NULL;
+}
+
+static void console_isr(int vector, void *param)
+{
+    rt_device_t dev = &console.parent;
+
+    if (dev->rx_indicate != RT_NULL)
+    {
+        dev->rx_indicate(dev, console.rx_put - console.rx_get);
+    }
+}
+
+static rt_ssize_t console_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    rt_size_t i;
+    rt_uint32_t get;
+    char *ptr = (char *)buffer;
+
+    for (i = 0; i < size; i++)
+    {
+        get = console.rx_get;
+
+        if (get == __atomic_load_n(&console.rx_put, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+
+        ptr[i] = console.rx_buf[get % CONSOLE_RX_BUFSZ];
+        __atomic_store_n(&console.rx_get, get + 1, __ATOMIC_RELEASE);
+    }
+
+    return i;
+}
+
+static rt_ssize_t console_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    ssize_t ret;
+    rt_size_t done = 0;
+
+    while (done < size)
+    {
+        ret = write(STDOUT_FILENO, (const char *)buffer + done, size - done);
+        if (ret <= 0)
+        {
+            break;
+        }
+        done += ret;
+    }
+
+    return done;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops console_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    console_read,
+    console_write,
+    RT_NULL
+};
+#endif
+
+void rt_hw_console_output(const char *str)
+{
+    console_write(RT_NULL, 0, str, rt_strlen(str));
+}
+
+int rt_hw_console_init(void)
+{
+    pthread_t pthread;
+    rt_device_t dev = &console.parent;
+
+    dev->type = RT_Device_Class_Char;
+#ifdef RT_USING_DEVICE_OPS
+    dev->ops = &console_ops;
+#else
+    dev->read = console_read;
+    dev->write = console_write;
+#endif
+    rt_device_register(dev, RT_CONSOLE_DEVICE_NAME, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_STREAM);
+
+    rt_hw_interrupt_install(BSP_IRQ_CONSOLE, console_isr, RT_NULL, "console");
+
+    console_termios_init();
+
+    if (pthread_create(&pthread, RT_NULL, console_rx_entry, RT_NULL) == 0)
+    {
+        pthread_detach(pthread);
+    }
+
+    return RT_EOK;
+}
+INIT_BOARD_EXPORT(rt_hw_console_init);
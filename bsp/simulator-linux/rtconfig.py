@@ -0,0 +1,50 @@
+import os
+import platform
+
+# toolchains options
+ARCH        ='sim'
+CPU         ='posix'
+CROSS_TOOL  = 'gcc'
+PLATFORM    = 'gcc'
+EXEC_PATH   = os.getenv('RTT_EXEC_PATH') or '/usr/bin'
+BUILD       = 'debug'
+
+if PLATFORM == 'gcc':
+    # toolchains of the host
+    PREFIX  = os.getenv('RTT_CC_PREFIX') or ''
+    CC      = PREFIX + 'gcc'
+    CXX     = PREFIX + 'g++'
+    CPP     = PREFIX + 'cpp'
+    AS      = PREFIX + 'gcc'
+    AR      = PREFIX + 'ar'
+    LINK    = PREFIX + 'gcc'
+    TARGET_EXT = 'elf'
+    SIZE    = PREFIX + 'size'
+    OBJDUMP = PREFIX + 'objdump'
+    OBJCPY  = PREFIX + 'objcopy'
+    STRIP   = PREFIX + 'strip'
+    DEVICE  = ' -pthread -ffunction-sections -fdata-sections -fno-strict-aliasing'
+    if platform.machine() in ['x86_64', 'i386', 'i686']:
+        # no padding between the entries of the tables in the sections
+        DEVICE += ' -malign-data=abi'
+
+    CPPFLAGS= ' -E -P -x assembler-with-cpp'
+    CXXFLAGS= DEVICE + ' -Wall -fdiagnostics-color=always'
+    CFLAGS  = DEVICE + ' -Wall -Wno-cpp -std=gnu99 -D_GNU_SOURCE -fdiagnostics-color=always'
+    AFLAGS  = ' -c' + ' -x assembler-with-cpp'
+    # link.lds only adds the sections of RT-Thread to the default script of the host
+    LFLAGS  = DEVICE + ' -Wl,--gc-sections,-Map=rtthread.map,-cref -T link.lds'
+    CPATH   = ''
+    LPATH   = ''
+
+    if BUILD == 'debug':
+        CFLAGS   += ' -O0 -g'
+        CXXFLAGS += ' -O0 -g'
+        AFLAGS   += ' -g'
+    else:
+        CFLAGS   += ' -O2'
+        CXXFLAGS += ' -O2'
+    CXXFLAGS += ' -Woverloaded-virtual -fno-exceptions -fno-rtti'
+
+DUMP_ACTION = OBJDUMP + ' -D -S $TARGET > rtt.asm\n'
+POST_ACTION = SIZE + ' $TARGET \n'
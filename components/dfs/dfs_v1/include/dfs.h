@@ -106,6 +106,8 @@ void fd_release(int fd);
 
 void fd_init(struct dfs_file *fd);
 int fd_associate(struct dfs_fdtable *fdt, int fd, struct dfs_file *file);
+int fdt_fd_associate_file(struct dfs_fdtable *fdt, int startfd, struct dfs_file *file);
+void fd_file_put(struct dfs_file *file);
 int fd_get_fd_index(struct dfs_file *file);
 
 struct dfs_fdtable *dfs_fdtable_get(void);
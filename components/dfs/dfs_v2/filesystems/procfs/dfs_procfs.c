@@ -0,0 +1,1187 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * procfs exports the kernel counters as text files:
+ *
+ * /meminfo, /uptime, /stat, /interrupts, /slabinfo, /buddyinfo, /net/dev
+ * /<pid>/stat, /<pid>/status, /<pid>/maps, /<pid>/fd/<fd>, /self
+ *
+ * The content of a file is generated into a buffer of the opened file when it
+ * is read from the offset 0, so a collector can keep the file opened and poll
+ * it with lseek(fd, 0, SEEK_SET) and read(). The generators take no lock of
+ * the file system, and only take the lock of an object for a short snapshot.
+ * The netdev list is walked under RCU. The pid table and the thread list of a
+ * process are protected by rt_hw_interrupt_disable() in the kernel, which is
+ * the global _cpus_lock on SMP, so it is held for the lookup and the copy of
+ * one process only.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_file.h>
+
+#ifdef RT_USING_SMART
+#include <lwp.h>
+#endif
+#ifdef ARCH_MM_MMU
+#include <mmu.h>
+#include <mm_aspace.h>
+#include <mm_page.h>
+#endif
+#ifdef RT_USING_PIC
+#include <drivers/pic.h>
+#endif
+#ifdef RT_USING_NETDEV
+#include <netdev_ipaddr.h>
+#include <netdev.h>
+#endif
+
+#include "dfs_procfs.h"
+
+#define DBG_TAG    "procfs"
+#define DBG_LVL    DBG_WARNING
+#include <rtdbg.h>
+
+#ifdef RT_USING_SMP
+#define PROCFS_CPUS_NR      RT_CPUS_NR
+#else
+#define PROCFS_CPUS_NR      1
+#endif
+
+struct procfs_buf
+{
+    char *data;
+    rt_size_t size;
+    rt_size_t len;
+};
+
+enum procfs_type
+{
+    PROCFS_ROOT,
+    PROCFS_FILE,            /* a global file */
+    PROCFS_NET,
+    PROCFS_PID,             /* the directory of a process */
+    PROCFS_PID_FILE,
+    PROCFS_FD,
+    PROCFS_FD_FILE,
+};
+
+struct procfs_node;
+
+struct procfs_entry
+{
+    const char *name;
+    int (*show)(struct procfs_buf *buf, struct procfs_node *node);
+};
+
+struct procfs_node
+{
+    enum procfs_type type;
+    const struct procfs_entry *entry;
+    pid_t pid;
+    int fd;
+};
+
+/* the state of an opened file */
+struct procfs_file
+{
+    struct procfs_node node;
+    struct procfs_buf buf;
+    int index;              /* the position of a directory */
+};
+
+static int procfs_printf(struct procfs_buf *buf, const char *fmt, ...)
+{
+    int len;
+    char *data;
+    rt_size_t size;
+    va_list args;
+
+    while (1)
+    {
+        va_start(args, fmt);
+        len = rt_vsnprintf(buf->data + buf->len, buf->size - buf->len, fmt, args);
+        va_end(args);
+
+        if (buf->len + len < buf->size)
+        {
+            buf->len += len;
+            return len;
+        }
+
+        /* grow the buffer and format again */
+        for (size = buf->size * 2; size <= buf->len + len; size *= 2)
+        {
+        }
+        data = (char *)rt_realloc(buf->data, size);
+        if (data == RT_NULL)
+        {
+            buf->data[buf->len] = '\0';
+            return -ENOMEM;
+        }
+        buf->data = data;
+        buf->size = size;
+    }
+}
+
+/* global files */
+
+static int procfs_meminfo_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+#ifdef ARCH_MM_MMU
+    rt_size_t total_nr, free_nr;
+
+    rt_page_get_info(&total_nr, &free_nr);
+    procfs_printf(buf, "MemTotal:    %10lu kB\n", (unsigned long)(total_nr * (ARCH_PAGE_SIZE >> 10)));
+    procfs_printf(buf, "MemFree:     %10lu kB\n", (unsigned long)(free_nr * (ARCH_PAGE_SIZE >> 10)));
+#endif /* ARCH_MM_MMU */
+#ifdef RT_USING_HEAP
+    {
+        rt_size_t total = 0, used = 0, max_used = 0;
+
+        rt_memory_info(&total, &used, &max_used);
+        procfs_printf(buf, "HeapTotal:   %10lu kB\n", (unsigned long)(total >> 10));
+        procfs_printf(buf, "HeapUsed:    %10lu kB\n", (unsigned long)(used >> 10));
+        procfs_printf(buf, "HeapMaxUsed: %10lu kB\n", (unsigned long)(max_used >> 10));
+    }
+#endif /* RT_USING_HEAP */
+
+    return 0;
+}
+
+static int procfs_uptime_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    rt_tick_t tick = rt_tick_get();
+    rt_uint64_t idle = 0;
+
+#ifdef RT_USING_CPU_USAGE
+    int cpu;
+    struct rt_cpu_usage usage;
+
+    for (cpu = 0; cpu < PROCFS_CPUS_NR; cpu++)
+    {
+        if (rt_cpu_usage_get(cpu, &usage) == RT_EOK)
+        {
+            idle += rt_cpu_usage_to_ns(usage.idle) / 10000000;
+        }
+    }
+#endif /* RT_USING_CPU_USAGE */
+
+    procfs_printf(buf, "%lu.%02lu %lu.%02lu\n",
+                  (unsigned long)(tick / RT_TICK_PER_SECOND),
+                  (unsigned long)(tick % RT_TICK_PER_SECOND * 100 / RT_TICK_PER_SECOND),
+                  (unsigned long)(idle / 100), (unsigned long)(idle % 100));
+
+    return 0;
+}
+
+#ifdef RT_USING_CPU_USAGE
+/* the times are in ticks as the USER_HZ of Linux */
+static unsigned long procfs_clock2tick(rt_uint64_t clock)
+{
+    return (unsigned long)(rt_cpu_usage_to_ns(clock) / (1000000000ULL / RT_TICK_PER_SECOND));
+}
+
+static void procfs_cpu_show(struct procfs_buf *buf, const char *name, struct rt_cpu_usage *usage)
+{
+    /* user nice system idle iowait irq softirq */
+    procfs_printf(buf, "%-5s%lu 0 %lu %lu 0 %lu 0\n", name,
+                  procfs_clock2tick(usage->user), procfs_clock2tick(usage->system),
+                  procfs_clock2tick(usage->idle), procfs_clock2tick(usage->irq));
+}
+
+static int procfs_stat_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int cpu;
+    char name[RT_NAME_MAX];
+    struct rt_cpu_usage total, usage[PROCFS_CPUS_NR];
+
+    rt_memset(&total, 0, sizeof(total));
+    rt_memset(usage, 0, sizeof(usage));
+    for (cpu = 0; cpu < PROCFS_CPUS_NR; cpu++)
+    {
+        rt_cpu_usage_get(cpu, &usage[cpu]);
+        total.user += usage[cpu].user;
+        total.system += usage[cpu].system;
+        total.irq += usage[cpu].irq;
+        total.idle += usage[cpu].idle;
+    }
+
+    procfs_cpu_show(buf, "cpu", &total);
+    for (cpu = 0; cpu < PROCFS_CPUS_NR; cpu++)
+    {
+        rt_snprintf(name, sizeof(name), "cpu%d", cpu);
+        procfs_cpu_show(buf, name, &usage[cpu]);
+    }
+
+    return 0;
+}
+#endif /* RT_USING_CPU_USAGE */
+
+#if defined(RT_USING_PIC) && defined(RT_USING_INTERRUPT_INFO)
+static int procfs_interrupts_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int irq, cpu;
+    struct rt_pic_irq_stat stat;
+
+    procfs_printf(buf, "%5s", "");
+    for (cpu = 0; cpu < PROCFS_CPUS_NR; cpu++)
+    {
+        procfs_printf(buf, "       CPU%-2d", cpu);
+    }
+    procfs_printf(buf, "\n");
+
+    for (irq = 0; irq < MAX_HANDLERS; irq++)
+    {
+        if (rt_pic_irq_get_stat(irq, &stat) != RT_EOK)
+        {
+            continue;
+        }
+
+        procfs_printf(buf, "%4d:", stat.irq);
+        for (cpu = 0; cpu < PROCFS_CPUS_NR; cpu++)
+        {
+            procfs_printf(buf, " %11lu", (unsigned long)stat.counter[cpu]);
+        }
+        procfs_printf(buf, "  %-8s %5d  %s\n", stat.pic_name, stat.hwirq, stat.name);
+    }
+
+    return 0;
+}
+#endif /* RT_USING_PIC && RT_USING_INTERRUPT_INFO */
+
+#ifdef RT_USING_SLAB
+static int procfs_slabinfo_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int i, index, count;
+    rt_object_t *objects;
+    struct rt_slab_info info;
+
+    procfs_printf(buf, "# %-*s %10s %8s %10s %10s\n", RT_NAME_MAX - 2, "name",
+                  "chunk_size", "zones", "chunks", "inuse");
+
+    count = rt_object_get_length(RT_Object_Class_Memory);
+    if (count <= 0)
+    {
+        return 0;
+    }
+
+    objects = (rt_object_t *)rt_calloc(count, sizeof(rt_object_t));
+    if (objects == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+    count = rt_object_get_pointers(RT_Object_Class_Memory, objects, count);
+
+    for (i = 0; i < count; i++)
+    {
+        rt_mem_t mem = (rt_mem_t)objects[i];
+
+        if (rt_strcmp(mem->algorithm, "slab") != 0)
+        {
+            continue;
+        }
+
+        for (index = 0; rt_slab_get_info(mem, index, &info) != -RT_EINVAL; index++)
+        {
+            if (info.chunk_size == 0)
+            {
+                continue;
+            }
+            procfs_printf(buf, "%-*.*s %10u %8u %10u %10u\n", RT_NAME_MAX, RT_NAME_MAX,
+                          mem->parent.name, info.chunk_size, info.zones, info.chunks, info.inuse);
+        }
+    }
+    rt_free(objects);
+
+    return 0;
+}
+#endif /* RT_USING_SLAB */
+
+#ifdef ARCH_MM_MMU
+static int procfs_buddyinfo_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int order;
+    rt_size_t low[RT_PAGE_MAX_ORDER], high[RT_PAGE_MAX_ORDER];
+
+    rt_page_get_buddyinfo(low, high);
+
+    procfs_printf(buf, "Node 0, zone %8s", "Low");
+    for (order = 0; order < RT_PAGE_MAX_ORDER; order++)
+    {
+        procfs_printf(buf, " %6lu", (unsigned long)low[order]);
+    }
+    procfs_printf(buf, "\nNode 0, zone %8s", "High");
+    for (order = 0; order < RT_PAGE_MAX_ORDER; order++)
+    {
+        procfs_printf(buf, " %6lu", (unsigned long)high[order]);
+    }
+    procfs_printf(buf, "\n");
+
+    return 0;
+}
+#endif /* ARCH_MM_MMU */
+
+#ifdef RT_USING_NETDEV
+/* copy the index-th network interface, the list is walked under RCU like the netdev lookups */
+static rt_err_t procfs_netdev_get(int index, char *name, struct netdev_stats *stats)
+{
+#ifndef RT_USING_RCU
+    rt_base_t level;
+#endif
+    rt_slist_t *node;
+    struct netdev *first;
+    rt_err_t err = -RT_EEMPTY;
+
+#ifdef RT_USING_RCU
+    rt_rcu_read_lock();
+#else
+    level = rt_hw_interrupt_disable();
+#endif /* RT_USING_RCU */
+    first = rt_rcu_dereference(netdev_list);
+    for (node = first ? &(first->list) : RT_NULL; node; node = rt_slist_next_rcu(node))
+    {
+        if (index-- == 0)
+        {
+            struct netdev *netdev = rt_slist_entry(node, struct netdev, list);
+
+            rt_strncpy(name, netdev->name, RT_NAME_MAX);
+            netdev_get_stats(netdev, stats);
+            err = RT_EOK;
+            break;
+        }
+    }
+#ifdef RT_USING_RCU
+    rt_rcu_read_unlock();
+#else
+    rt_hw_interrupt_enable(level);
+#endif /* RT_USING_RCU */
+
+    return err;
+}
+
+static int procfs_netdev_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int index;
+    char name[RT_NAME_MAX + 1];
+    struct netdev_stats stats;
+
+    procfs_printf(buf, "Inter-|   Receive                            |  Transmit\n");
+    procfs_printf(buf, " face |bytes    packets errs drop fifo frame|bytes    packets errs drop fifo colls\n");
+
+    name[RT_NAME_MAX] = '\0';
+    for (index = 0; procfs_netdev_get(index, name, &stats) == RT_EOK; index++)
+    {
+        procfs_printf(buf, "%6s: %8lu %7lu    0 %4lu    0     0 %8lu %7lu %4lu    0    0     0\n", name,
+                      (unsigned long)stats.rx_bytes, (unsigned long)stats.rx_packets,
+                      (unsigned long)stats.rx_dropped, (unsigned long)stats.tx_bytes,
+                      (unsigned long)stats.tx_packets, (unsigned long)stats.tx_errors);
+    }
+
+    return 0;
+}
+
+static const struct procfs_entry _net_entries[] =
+{
+    {"dev", procfs_netdev_show},
+};
+#endif /* RT_USING_NETDEV */
+
+static const struct procfs_entry _global_entries[] =
+{
+    {"meminfo", procfs_meminfo_show},
+    {"uptime", procfs_uptime_show},
+#ifdef RT_USING_CPU_USAGE
+    {"stat", procfs_stat_show},
+#endif
+#if defined(RT_USING_PIC) && defined(RT_USING_INTERRUPT_INFO)
+    {"interrupts", procfs_interrupts_show},
+#endif
+#ifdef RT_USING_SLAB
+    {"slabinfo", procfs_slabinfo_show},
+#endif
+#ifdef ARCH_MM_MMU
+    {"buddyinfo", procfs_buddyinfo_show},
+#endif
+};
+
+/* process files */
+
+#ifdef RT_USING_SMART
+struct procfs_task
+{
+    char state;
+    pid_t ppid;
+    int threads;
+    int priority;
+};
+
+/* get the process with a reference, RT_NULL if it is gone, the pid table is under the global lock */
+static struct rt_lwp *procfs_lwp_get(pid_t pid)
+{
+    rt_base_t level;
+    struct rt_lwp *lwp;
+
+    level = rt_hw_interrupt_disable();
+    lwp = lwp_from_pid(pid);
+    if (lwp)
+    {
+        lwp_ref_inc(lwp);
+    }
+    rt_hw_interrupt_enable(level);
+
+    return lwp;
+}
+
+static void procfs_task_get(struct rt_lwp *lwp, struct procfs_task *task)
+{
+    rt_base_t level;
+    rt_list_t *list;
+    rt_thread_t thread;
+
+    rt_memset(task, 0, sizeof(*task));
+    task->state = 'Z';
+
+    level = rt_hw_interrupt_disable();
+    if (lwp->parent)
+    {
+        task->ppid = lwp->parent->pid;
+    }
+    rt_list_for_each(list, &lwp->t_grp)
+    {
+        thread = rt_list_entry(list, struct rt_thread, sibling);
+        if (task->threads++ != 0)
+        {
+            continue;
+        }
+
+        /* the state of the process is the one of the main thread */
+        task->priority = thread->current_priority;
+        switch (thread->stat & RT_THREAD_STAT_MASK)
+        {
+        case RT_THREAD_CLOSE:
+            task->state = 'Z';
+            break;
+        case RT_THREAD_SUSPEND_UNINTERRUPTIBLE:
+            task->state = 'D';
+            break;
+        case RT_THREAD_SUSPEND_INTERRUPTIBLE:
+        case RT_THREAD_SUSPEND_KILLABLE:
+            task->state = 'S';
+            break;
+        default:
+            task->state = 'R';
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (lwp->finish)
+    {
+        task->state = 'Z';
+    }
+}
+
+static int procfs_pid_stat_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    struct rt_lwp *lwp;
+    struct procfs_task task;
+    unsigned long utime = 0, stime = 0, cutime = 0, cstime = 0;
+    unsigned long vsz = 0, rss = 0;
+
+    lwp = procfs_lwp_get(node->pid);
+    if (lwp == RT_NULL)
+    {
+        return -ESRCH;
+    }
+
+    procfs_task_get(lwp, &task);
+#ifdef RT_USING_CPU_USAGE
+    {
+        rt_uint64_t user, system;
+
+        lwp_cpu_time(lwp, &user, &system);
+        utime = procfs_clock2tick(user);
+        stime = procfs_clock2tick(system);
+        lwp_children_cpu_time(lwp, &user, &system);
+        cutime = procfs_clock2tick(user);
+        cstime = procfs_clock2tick(system);
+    }
+#endif /* RT_USING_CPU_USAGE */
+#ifdef ARCH_MM_MMU
+    if (!lwp->finish)
+    {
+        struct lwp_mem_stat stat;
+
+        lwp_mem_stat_get(lwp, &stat);
+        vsz = stat.vsz;
+        rss = stat.rss >> ARCH_PAGE_SHIFT;
+    }
+#endif /* ARCH_MM_MMU */
+
+    /* pid comm state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt
+     * utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss */
+    procfs_printf(buf, "%d (%s) %c %d %d %d 0 0 0 0 0 0 0 %lu %lu %lu %lu %d 0 %d 0 0 %lu %lu\n",
+                  lwp->pid, lwp->cmd, task.state, task.ppid, lwp->__pgrp, lwp->session,
+                  utime, stime, cutime, cstime, task.priority, task.threads, vsz, rss);
+    lwp_ref_dec(lwp);
+
+    return 0;
+}
+
+static int procfs_pid_status_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    struct rt_lwp *lwp;
+    struct procfs_task task;
+
+    lwp = procfs_lwp_get(node->pid);
+    if (lwp == RT_NULL)
+    {
+        return -ESRCH;
+    }
+
+    procfs_task_get(lwp, &task);
+    procfs_printf(buf, "Name:\t%s\n", lwp->cmd);
+    procfs_printf(buf, "State:\t%c\n", task.state);
+    procfs_printf(buf, "Pid:\t%d\n", lwp->pid);
+    procfs_printf(buf, "PPid:\t%d\n", task.ppid);
+    procfs_printf(buf, "Threads:\t%d\n", task.threads);
+#ifdef ARCH_MM_MMU
+    if (!lwp->finish)
+    {
+        struct lwp_mem_stat stat;
+
+        lwp_mem_stat_get(lwp, &stat);
+        procfs_printf(buf, "VmSize:\t%8lu kB\n", (unsigned long)(stat.vsz >> 10));
+        procfs_printf(buf, "VmRSS:\t%8lu kB\n", (unsigned long)(stat.rss >> 10));
+        procfs_printf(buf, "VmData:\t%8lu kB\n", (unsigned long)(stat.heap >> 10));
+    }
+#ifdef LWP_USING_MEM_GROUP
+    if (lwp->mgroup)
+    {
+        procfs_printf(buf, "MemGroup:\t%s\n", lwp->mgroup->name);
+    }
+#endif /* LWP_USING_MEM_GROUP */
+#endif /* ARCH_MM_MMU */
+    lwp_ref_dec(lwp);
+
+    return 0;
+}
+
+#ifdef ARCH_MM_MMU
+static int procfs_maps_walk(rt_varea_t varea, void *arg)
+{
+    char write = 'w';
+    const char *name = "";
+    struct procfs_buf *buf = (struct procfs_buf *)arg;
+
+    if (varea->mem_obj && varea->mem_obj->get_name)
+    {
+        name = varea->mem_obj->get_name(varea);
+    }
+#ifdef MMU_MAP_U_RO
+    if (varea->attr == MMU_MAP_U_RO)
+    {
+        write = '-';
+    }
+#endif
+
+    procfs_printf(buf, "%08lx-%08lx r%c%c%c %08lx %s\n",
+                  (unsigned long)varea->start, (unsigned long)varea->start + varea->size, write,
+                  (varea->flag & MMF_TEXT) ? 'x' : '-', (varea->flag & MMF_MAP_PRIVATE) ? 'p' : 's',
+                  (unsigned long)varea->offset << ARCH_PAGE_SHIFT, name);
+
+    return 0;
+}
+
+static int procfs_pid_maps_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    struct rt_lwp *lwp;
+
+    lwp = procfs_lwp_get(node->pid);
+    if (lwp == RT_NULL)
+    {
+        return -ESRCH;
+    }
+
+    /* only the lock of the address space is taken by the walk */
+    if (!lwp->finish && lwp->aspace)
+    {
+        rt_aspace_traversal(lwp->aspace, procfs_maps_walk, buf);
+    }
+    lwp_ref_dec(lwp);
+
+    return 0;
+}
+#endif /* ARCH_MM_MMU */
+
+static int procfs_fd_show(struct procfs_buf *buf, struct procfs_node *node)
+{
+    int err = -ENOENT;
+    struct rt_lwp *lwp;
+    struct dfs_file *file;
+
+    lwp = procfs_lwp_get(node->pid);
+    if (lwp == RT_NULL)
+    {
+        return -ESRCH;
+    }
+
+    /* the fd table is protected by the lock of files, hold it for the copy only */
+    dfs_file_lock();
+    if (node->fd < lwp->fdt.maxfd)
+    {
+        file = lwp->fdt.fds[node->fd];
+        if (file && file->vnode)
+        {
+            procfs_printf(buf, "%s\n", file->vnode->fullpath ? file->vnode->fullpath : "");
+            err = 0;
+        }
+    }
+    dfs_file_unlock();
+    lwp_ref_dec(lwp);
+
+    return err;
+}
+
+static const struct procfs_entry _pid_entries[] =
+{
+    {"stat", procfs_pid_stat_show},
+    {"status", procfs_pid_status_show},
+#ifdef ARCH_MM_MMU
+    {"maps", procfs_pid_maps_show},
+#endif
+};
+
+static const struct procfs_entry _fd_entry = {"fd", procfs_fd_show};
+#endif /* RT_USING_SMART */
+
+/* path lookup */
+
+/* get the next name of a path, return RT_FALSE at the end */
+static rt_bool_t procfs_path_next(const char **path, char *name)
+{
+    int len = 0;
+    const char *p = *path;
+
+    while (*p == '/')
+    {
+        p++;
+    }
+    while (*p && *p != '/')
+    {
+        if (len < DIRENT_NAME_MAX - 1)
+        {
+            name[len++] = *p;
+        }
+        p++;
+    }
+    name[len] = '\0';
+    *path = p;
+
+    return len != 0;
+}
+
+static const struct procfs_entry *procfs_entry_find(const struct procfs_entry *entries, int nr, const char *name)
+{
+    int i;
+
+    for (i = 0; i < nr; i++)
+    {
+        if (rt_strcmp(entries[i].name, name) == 0)
+        {
+            return &entries[i];
+        }
+    }
+
+    return RT_NULL;
+}
+
+#ifdef RT_USING_SMART
+/* parse a decimal number, -1 if it is not */
+static int procfs_number(const char *name)
+{
+    int value = 0;
+
+    if (*name == '\0')
+    {
+        return -1;
+    }
+    for (; *name; name++)
+    {
+        if (*name < '0' || *name > '9' || value > INT32_MAX / 10)
+        {
+            return -1;
+        }
+        value = value * 10 + (*name - '0');
+    }
+
+    return value;
+}
+#endif /* RT_USING_SMART */
+
+static int procfs_lookup(const char *path, struct procfs_node *node)
+{
+    char name[DIRENT_NAME_MAX];
+
+    rt_memset(node, 0, sizeof(*node));
+    node->type = PROCFS_ROOT;
+    if (!procfs_path_next(&path, name))
+    {
+        return 0;
+    }
+
+    node->entry = procfs_entry_find(_global_entries, RT_ARRAY_SIZE(_global_entries), name);
+    if (node->entry)
+    {
+        node->type = PROCFS_FILE;
+        return procfs_path_next(&path, name) ? -ENOTDIR : 0;
+    }
+
+#ifdef RT_USING_NETDEV
+    if (rt_strcmp(name, "net") == 0)
+    {
+        node->type = PROCFS_NET;
+        if (!procfs_path_next(&path, name))
+        {
+            return 0;
+        }
+
+        node->entry = procfs_entry_find(_net_entries, RT_ARRAY_SIZE(_net_entries), name);
+        if (node->entry == RT_NULL)
+        {
+            return -ENOENT;
+        }
+        node->type = PROCFS_FILE;
+        return procfs_path_next(&path, name) ? -ENOTDIR : 0;
+    }
+#endif /* RT_USING_NETDEV */
+
+#ifdef RT_USING_SMART
+    if (rt_strcmp(name, "self") == 0)
+    {
+        struct rt_lwp *lwp = lwp_self();
+
+        node->pid = lwp ? lwp->pid : -1;
+    }
+    else
+    {
+        node->pid = procfs_number(name);
+    }
+    if (node->pid <= 0 || lwp_from_pid(node->pid) == RT_NULL)
+    {
+        return -ENOENT;
+    }
+
+    node->type = PROCFS_PID;
+    if (!procfs_path_next(&path, name))
+    {
+        return 0;
+    }
+
+    if (rt_strcmp(name, "fd") == 0)
+    {
+        node->type = PROCFS_FD;
+        if (!procfs_path_next(&path, name))
+        {
+            return 0;
+        }
+
+        node->fd = procfs_number(name);
+        if (node->fd < 0)
+        {
+            return -ENOENT;
+        }
+        node->type = PROCFS_FD_FILE;
+        node->entry = &_fd_entry;
+        return procfs_path_next(&path, name) ? -ENOTDIR : 0;
+    }
+
+    node->entry = procfs_entry_find(_pid_entries, RT_ARRAY_SIZE(_pid_entries), name);
+    if (node->entry == RT_NULL)
+    {
+        return -ENOENT;
+    }
+    node->type = PROCFS_PID_FILE;
+    return procfs_path_next(&path, name) ? -ENOTDIR : 0;
+#else
+    return -ENOENT;
+#endif /* RT_USING_SMART */
+}
+
+rt_inline rt_bool_t procfs_is_dir(struct procfs_node *node)
+{
+    return node->type == PROCFS_ROOT || node->type == PROCFS_NET ||
+           node->type == PROCFS_PID || node->type == PROCFS_FD;
+}
+
+/* file operations */
+
+static int dfs_procfs_open(struct dfs_file *file)
+{
+    int err;
+    struct procfs_node node;
+    struct procfs_file *pfile;
+
+    if ((file->flags & O_ACCMODE) != O_RDONLY || (file->flags & O_CREAT))
+    {
+        return -EROFS;
+    }
+
+    err = procfs_lookup(file->vnode->path, &node);
+    if (err < 0)
+    {
+        return err;
+    }
+    if ((file->flags & O_DIRECTORY) && !procfs_is_dir(&node))
+    {
+        return -ENOTDIR;
+    }
+
+    /* the vnode is shared by the opened files of the path, keep the state in the file */
+    pfile = (struct procfs_file *)rt_calloc(1, sizeof(struct procfs_file));
+    if (pfile == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+    pfile->node = node;
+    file->data = pfile;
+    file->pos = 0;
+    file->vnode->size = 0;
+
+    return 0;
+}
+
+static int dfs_procfs_close(struct dfs_file *file)
+{
+    struct procfs_file *pfile = (struct procfs_file *)file->data;
+
+    if (pfile)
+    {
+        rt_free(pfile->buf.data);
+        rt_free(pfile);
+        file->data = RT_NULL;
+    }
+
+    return 0;
+}
+
+static int dfs_procfs_read(struct dfs_file *file, void *buf, size_t count)
+{
+    int err;
+    rt_size_t length;
+    struct procfs_file *pfile = (struct procfs_file *)file->data;
+
+    if (pfile == RT_NULL)
+    {
+        return -EBADF;
+    }
+    if (procfs_is_dir(&pfile->node))
+    {
+        return -EISDIR;
+    }
+
+    /* generate a new content when read from the start */
+    if (file->pos == 0 || pfile->buf.data == RT_NULL)
+    {
+        if (pfile->buf.data == RT_NULL)
+        {
+            pfile->buf.data = (char *)rt_malloc(PROCFS_BUF_SIZE);
+            if (pfile->buf.data == RT_NULL)
+            {
+                return -ENOMEM;
+            }
+            pfile->buf.size = PROCFS_BUF_SIZE;
+        }
+        pfile->buf.len = 0;
+        pfile->buf.data[0] = '\0';
+
+        err = pfile->node.entry->show(&pfile->buf, &pfile->node);
+        if (err < 0)
+        {
+            pfile->buf.len = 0;
+            return err;
+        }
+    }
+
+    if (file->pos >= pfile->buf.len)
+    {
+        return 0;
+    }
+
+    length = pfile->buf.len - file->pos;
+    if (length > count)
+    {
+        length = count;
+    }
+    rt_memcpy(buf, pfile->buf.data + file->pos, length);
+    file->pos += length;
+
+    return length;
+}
+
+static int dfs_procfs_lseek(struct dfs_file *file, off_t offset)
+{
+    struct procfs_file *pfile = (struct procfs_file *)file->data;
+
+    if (pfile == RT_NULL || offset < 0)
+    {
+        return -EINVAL;
+    }
+    if (procfs_is_dir(&pfile->node))
+    {
+        /* rewind the directory only */
+        if (offset != 0)
+        {
+            return -EINVAL;
+        }
+        pfile->index = 0;
+    }
+
+    return offset;
+}
+
+static void procfs_dirent_fill(struct dirent *d, rt_uint8_t type, const char *name)
+{
+    d->d_type = type;
+    d->d_reclen = (rt_uint16_t)sizeof(struct dirent);
+    rt_strncpy(d->d_name, name, DIRENT_NAME_MAX - 1);
+    d->d_name[DIRENT_NAME_MAX - 1] = '\0';
+    d->d_namlen = rt_strlen(d->d_name);
+}
+
+/* fill the index-th entry of a directory, return RT_FALSE at the end */
+static rt_bool_t procfs_dirent_get(struct procfs_file *pfile, int *index, struct dirent *d)
+{
+    int i = *index;
+#ifdef RT_USING_SMART
+    char name[16];
+#endif
+
+    switch (pfile->node.type)
+    {
+    case PROCFS_ROOT:
+        if (i < RT_ARRAY_SIZE(_global_entries))
+        {
+            procfs_dirent_fill(d, DT_REG, _global_entries[i].name);
+            break;
+        }
+        i -= RT_ARRAY_SIZE(_global_entries);
+#ifdef RT_USING_NETDEV
+        if (i == 0)
+        {
+            procfs_dirent_fill(d, DT_DIR, "net");
+            break;
+        }
+        i -= 1;
+#endif /* RT_USING_NETDEV */
+#ifdef RT_USING_SMART
+        if (i == 0)
+        {
+            procfs_dirent_fill(d, DT_DIR, "self");
+            break;
+        }
+        i -= 1;
+
+        /* the slots of the pid table, the pid is read without touching the process */
+        {
+            struct lwp_avl_struct *pids = lwp_get_pid_ary();
+
+            for (; i < RT_LWP_MAX_NR; i++, (*index)++)
+            {
+                if (pids[i].data)
+                {
+                    rt_snprintf(name, sizeof(name), "%d", (int)pids[i].avl_key);
+                    procfs_dirent_fill(d, DT_DIR, name);
+                    break;
+                }
+            }
+            if (i < RT_LWP_MAX_NR)
+            {
+                break;
+            }
+        }
+#endif /* RT_USING_SMART */
+        return RT_FALSE;
+
+#ifdef RT_USING_NETDEV
+    case PROCFS_NET:
+        if (i >= RT_ARRAY_SIZE(_net_entries))
+        {
+            return RT_FALSE;
+        }
+        procfs_dirent_fill(d, DT_REG, _net_entries[i].name);
+        break;
+#endif /* RT_USING_NETDEV */
+
+#ifdef RT_USING_SMART
+    case PROCFS_PID:
+        if (i < RT_ARRAY_SIZE(_pid_entries))
+        {
+            procfs_dirent_fill(d, DT_REG, _pid_entries[i].name);
+            break;
+        }
+        if (i == RT_ARRAY_SIZE(_pid_entries))
+        {
+            procfs_dirent_fill(d, DT_DIR, "fd");
+            break;
+        }
+        return RT_FALSE;
+
+    case PROCFS_FD:
+    {
+        struct rt_lwp *lwp = procfs_lwp_get(pfile->node.pid);
+        rt_bool_t found = RT_FALSE;
+
+        if (lwp == RT_NULL)
+        {
+            return RT_FALSE;
+        }
+
+        dfs_file_lock();
+        for (; i < lwp->fdt.maxfd; i++, (*index)++)
+        {
+            if (lwp->fdt.fds[i])
+            {
+                found = RT_TRUE;
+                break;
+            }
+        }
+        dfs_file_unlock();
+        lwp_ref_dec(lwp);
+
+        if (!found)
+        {
+            return RT_FALSE;
+        }
+        rt_snprintf(name, sizeof(name), "%d", i);
+        procfs_dirent_fill(d, DT_REG, name);
+        break;
+    }
+#endif /* RT_USING_SMART */
+
+    default:
+        return RT_FALSE;
+    }
+
+    (*index)++;
+
+    return RT_TRUE;
+}
+
+static int dfs_procfs_getdents(struct dfs_file *file, struct dirent *dirp, uint32_t count)
+{
+    rt_uint32_t index;
+    struct procfs_file *pfile = (struct procfs_file *)file->data;
+
+    if (pfile == RT_NULL || !procfs_is_dir(&pfile->node))
+    {
+        return -ENOTDIR;
+    }
+
+    /* make integer count */
+    count = (count / sizeof(struct dirent));
+    if (count == 0)
+    {
+        return -EINVAL;
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        if (!procfs_dirent_get(pfile, &pfile->index, dirp + index))
+        {
+            break;
+        }
+    }
+    file->pos = pfile->index;
+
+    return index * sizeof(struct dirent);
+}
+
+/* file system operations */
+
+static int dfs_procfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data)
+{
+    return RT_EOK;
+}
+
+static int dfs_procfs_unmount(struct dfs_filesystem *fs)
+{
+    return RT_EOK;
+}
+
+static int dfs_procfs_statfs(struct dfs_filesystem *fs, struct statfs *buf)
+{
+    rt_memset(buf, 0, sizeof(struct statfs));
+    buf->f_bsize = 512;
+
+    return RT_EOK;
+}
+
+static int dfs_procfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
+{
+    int err;
+    struct procfs_node node;
+
+    err = procfs_lookup(path, &node);
+    if (err < 0)
+    {
+        return err;
+    }
+
+    rt_memset(st, 0, sizeof(struct stat));
+    if (procfs_is_dir(&node))
+    {
+        st->st_mode = S_IFDIR | S_IRUSR | S_IRGRP | S_IROTH | S_IXUSR | S_IXGRP | S_IXOTH;
+    }
+    else
+    {
+        st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+    }
+
+    return RT_EOK;
+}
+
+static const struct dfs_file_ops _procfs_fops =
+{
+    dfs_procfs_open,
+    dfs_procfs_close,
+    RT_NULL,                    /* ioctl */
+    dfs_procfs_read,
+    RT_NULL,                    /* write */
+    RT_NULL,                    /* flush */
+    dfs_procfs_lseek,
+    dfs_procfs_getdents,
+    RT_NULL,                    /* poll */
+};
+
+static const struct dfs_filesystem_ops _procfs =
+{
+    "procfs",
+    DFS_FS_FLAG_DEFAULT,
+    &_procfs_fops,
+    dfs_procfs_mount,
+    dfs_procfs_unmount,
+    RT_NULL,                    /* mkfs */
+    dfs_procfs_statfs,
+    RT_NULL,                    /* unlink */
+    dfs_procfs_stat,
+    RT_NULL,                    /* rename */
+};
+
+int dfs_procfs_init(void)
+{
+    /* register proc file system */
+    return dfs_register(&_procfs);
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __DFS_PROCFS_H__
+#define __DFS_PROCFS_H__
+
+#include <rtthread.h>
+
+/* the initial size of the buffer of a file, grown when needed */
+#define PROCFS_BUF_SIZE     1024
+
+int dfs_procfs_init(void);
+
+#endif /* __DFS_PROCFS_H__ */
@@ -100,6 +100,8 @@ struct dfs_file *fdt_fd_get(struct dfs_fdtable* fdt, int fd);
 void fdt_fd_release(struct dfs_fdtable* fdt, int fd);
 int fd_new(void);
 int fd_associate(struct dfs_fdtable *fdt, int fd, struct dfs_file *file);
+int fdt_fd_associate_file(struct dfs_fdtable *fdt, int startfd, struct dfs_file *file);
+void fd_file_put(struct dfs_file *file);
 struct dfs_file *fd_get(int fd);
 int fd_get_fd_index(struct dfs_file *file);
 void fd_release(int fd);
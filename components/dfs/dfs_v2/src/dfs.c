@@ -8,6 +8,7 @@
  * 2005-02-22     Bernard      The first version.
  * 2017-12-11     Bernard      Use rt_free to instead of free in fd_is_open().
  * 2018-03-20     Heyuanjie    dynamic allocation FD
+ * 2023-10-18     RT-Thread    Add fdt_fd_associate_file() for the files passed by sockets
  */
 
 #include <dfs.h>
@@ -82,6 +83,13 @@ int dfs_init(void)
     }
 #endif
 
+#ifdef RT_USING_DFS_PROCFS
+    {
+        extern int dfs_procfs_init(void);
+        dfs_procfs_init();
+    }
+#endif
+
 #ifdef RT_USING_DFS_DEVFS
     {
         extern int devfs_init(void);
@@ -195,12 +203,28 @@ static int fd_slot_expand(struct dfs_fdtable *fdt, int fd)
     return fd;
 }
 
+/* the fds of a process are limited by its RLIMIT_NOFILE */
+static int fd_slot_limit(struct dfs_fdtable *fdt)
+{
+#ifdef RT_USING_SMART
+    struct rt_lwp *lwp = lwp_self();
+
+    if (lwp && fdt == &lwp->fdt && lwp->rlim[LWP_RLIMIT_NOFILE].rlim_cur < DFS_FD_MAX)
+    {
+        return (int)lwp->rlim[LWP_RLIMIT_NOFILE].rlim_cur;
+    }
+#endif /* RT_USING_SMART */
+
+    return DFS_FD_MAX;
+}
+
 static int fd_slot_alloc(struct dfs_fdtable *fdt, int startfd)
 {
     int idx;
+    int limit = fd_slot_limit(fdt);
 
     /* find an empty fd slot */
-    for (idx = startfd; idx < (int)fdt->maxfd; idx++)
+    for (idx = startfd; idx < (int)fdt->maxfd && idx < limit; idx++)
     {
         if (fdt->fds[idx] == RT_NULL)
         {
@@ -213,7 +237,7 @@ static int fd_slot_alloc(struct dfs_fdtable *fdt, int startfd)
     {
         idx = startfd;
     }
-    if (fd_slot_expand(fdt, idx) < 0)
+    if (idx >= limit || fd_slot_expand(fdt, idx) < 0)
     {
         return -1;
     }
@@ -320,6 +344,28 @@ struct dfs_file *fd_get(int fd)
     return fdt_fd_get(fdt, fd);
 }
 
+/* drop a reference of the file with dfs_file_lock held, it is freed with the last one */
+static void fd_file_unref(struct dfs_file *file)
+{
+    file->ref_count--;
+
+    /* clear this fd entry */
+    if (file->ref_count == 0)
+    {
+        struct dfs_vnode *vnode = file->vnode;
+        if (vnode)
+        {
+            vnode->ref_count--;
+            if(vnode->ref_count == 0)
+            {
+                rt_free(vnode);
+                file->vnode = RT_NULL;
+            }
+        }
+        rt_free(file);
+    }
+}
+
 /**
  * @ingroup Fd
  *
@@ -350,23 +396,7 @@ void fdt_fd_release(struct dfs_fdtable* fdt, int fd)
     /* check fd */
     RT_ASSERT(fd_slot->magic == DFS_FD_MAGIC);
 
-    fd_slot->ref_count--;
-
-    /* clear this fd entry */
-    if (fd_slot->ref_count == 0)
-    {
-        struct dfs_vnode *vnode = fd_slot->vnode;
-        if (vnode)
-        {
-            vnode->ref_count--;
-            if(vnode->ref_count == 0)
-            {
-                rt_free(vnode);
-                fd_slot->vnode = RT_NULL;
-            }
-        }
-        rt_free(fd_slot);
-    }
+    fd_file_unref(fd_slot);
     dfs_file_unlock();
 }
 
@@ -573,7 +603,7 @@ int fd_associate(struct dfs_fdtable *fdt, int fd, struct dfs_file *file)
 
     dfs_file_lock();
     /* check old fd */
-    if ((fd < 0) || (fd >= fdt->maxfd))
+    if ((fd < 0) || (fd >= fdt->maxfd) || (fd >= fd_slot_limit(fdt)))
     {
         goto exit;
     }
@@ -591,6 +621,64 @@ exit:
     return retfd;
 }
 
+/**
+ * @ingroup Fd
+ *
+ * This function will associate the opened file with the lowest free file
+ * descriptor not less than startfd, such as a file received by a socket.
+ *
+ * @return -1 on failed or the file descriptor.
+ */
+int fdt_fd_associate_file(struct dfs_fdtable *fdt, int startfd, struct dfs_file *file)
+{
+    int fd;
+
+    if (!file || !fdt)
+    {
+        return -1;
+    }
+
+    dfs_file_lock();
+    fd = fd_slot_alloc(fdt, startfd);
+    if (fd >= 0)
+    {
+        /* inc ref_count */
+        file->ref_count++;
+        fdt->fds[fd] = file;
+    }
+    dfs_file_unlock();
+
+    return fd;
+}
+
+/**
+ * @ingroup Fd
+ *
+ * This function will release a reference of the opened file which is not
+ * associated with any file descriptor, such as a file in flight on a socket.
+ * The file is closed and freed with the last reference.
+ */
+void fd_file_put(struct dfs_file *file)
+{
+    RT_ASSERT(file != NULL);
+
+    dfs_file_lock();
+    if (file->ref_count > 1)
+    {
+        fd_file_unref(file);
+        dfs_file_unlock();
+        return;
+    }
+    dfs_file_unlock();
+
+    /* the last reference, as close() does */
+    dfs_file_close(file);
+
+    dfs_file_lock();
+    fd_file_unref(file);
+    dfs_file_unlock();
+}
+
 void fd_init(struct dfs_file *fd)
 {
     if (fd)
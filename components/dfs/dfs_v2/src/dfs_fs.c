@@ -80,18 +80,37 @@ struct dfs_filesystem *dfs_filesystem_lookup(const char *path)
     struct dfs_filesystem *iter;
     struct dfs_filesystem *fs = NULL;
     uint32_t fspath, prefixlen;
+#ifdef RT_USING_RCU
+    const char *mnt_path;
+#endif /* RT_USING_RCU */
 
     prefixlen = 0;
 
     RT_ASSERT(path);
 
     /* lock filesystem */
+#ifdef RT_USING_RCU
+    /* the path of an entry is published last by mount, and freed by unmount
+     * after a grace period, so the table is looked up without the lock */
+    rt_rcu_read_lock();
+#else
     dfs_lock();
+#endif /* RT_USING_RCU */
 
     /* lookup it in the filesystem table */
     for (iter = &filesystem_table[0];
             iter < &filesystem_table[DFS_FILESYSTEMS_MAX]; iter++)
     {
+#ifdef RT_USING_RCU
+        mnt_path = rt_rcu_dereference(iter->path);
+        if ((mnt_path == NULL) || (iter->ops == NULL))
+            continue;
+
+        fspath = strlen(mnt_path);
+        if ((fspath < prefixlen)
+            || (strncmp(mnt_path, path, fspath) != 0))
+            continue;
+#else
         if ((iter->path == NULL) || (iter->ops == NULL))
             continue;
 
@@ -99,6 +118,7 @@ struct dfs_filesystem *dfs_filesystem_lookup(const char *path)
         if ((fspath < prefixlen)
             || (strncmp(iter->path, path, fspath) != 0))
             continue;
+#endif /* RT_USING_RCU */
 
         /* check next path separator */
         if (fspath > 1 && (strlen(path) > fspath) && (path[fspath] != '/'))
@@ -108,11 +128,34 @@ struct dfs_filesystem *dfs_filesystem_lookup(const char *path)
         prefixlen = fspath;
     }
 
+#ifdef RT_USING_RCU
+    rt_rcu_read_unlock();
+#else
     dfs_unlock();
+#endif /* RT_USING_RCU */
 
     return fs;
 }
 
+/*
+ * remove the entry from the lookup, the path is returned to free, with the
+ * filesystem table locked.
+ */
+static char *dfs_filesystem_unpublish(struct dfs_filesystem *fs)
+{
+    char *path = fs->path;
+
+#ifdef RT_USING_RCU
+    rt_rcu_assign_pointer(fs->path, NULL);
+    /* wait for the lookups still on the entry */
+    rt_rcu_synchronize();
+#else
+    fs->path = NULL;
+#endif /* RT_USING_RCU */
+
+    return path;
+}
+
 /**
  * this function will return the mounted path for specified device.
  *
@@ -310,11 +353,16 @@ int dfs_mount(const char   *device_name,
     }
 
     /* register file system */
-    fs->path   = fullpath;
     fs->ops    = *ops;
     fs->dev_id = dev_id;
     /* For UFS, record the real filesystem name */
     fs->data = (void *) filesystemtype;
+    /* publish the entry to the lookup at last */
+#ifdef RT_USING_RCU
+    rt_rcu_assign_pointer(fs->path, fullpath);
+#else
+    fs->path   = fullpath;
+#endif /* RT_USING_RCU */
 
     /* release filesystem_table lock */
     dfs_unlock();
@@ -327,6 +375,7 @@ int dfs_mount(const char   *device_name,
         {
             /* The underlying device has error, clear the entry. */
             dfs_lock();
+            dfs_filesystem_unpublish(fs);
             rt_memset(fs, 0, sizeof(struct dfs_filesystem));
 
             goto err1;
@@ -343,6 +392,7 @@ int dfs_mount(const char   *device_name,
         /* mount failed */
         dfs_lock();
         /* clear filesystem table entry */
+        dfs_filesystem_unpublish(fs);
         rt_memset(fs, 0, sizeof(struct dfs_filesystem));
 
         goto err1;
@@ -404,7 +454,7 @@ int dfs_unmount(const char *specialfile)
         rt_device_close(fs->dev_id);
 
     if (fs->path != NULL)
-        rt_free(fs->path);
+        rt_free(dfs_filesystem_unpublish(fs));
 
     /* clear this filesystem table entry */
     rt_memset(fs, 0, sizeof(struct dfs_filesystem));
@@ -593,7 +643,7 @@ int dfs_unmount_device(rt_device_t dev)
         rt_device_close(fs->dev_id);
 
     if (fs->path != NULL)
-        rt_free(fs->path);
+        rt_free(dfs_filesystem_unpublish(fs));
 
     /* clear this filesystem table entry */
     rt_memset(fs, 0, sizeof(struct dfs_filesystem));
@@ -413,6 +413,9 @@ rt_uint8_t rt_pci_irq_slot(struct rt_pci_device *pdev, rt_uint8_t *pinp);
 
 void rt_pci_assign_irq(struct rt_pci_device *pdev);
 
+void rt_pci_set_master(struct rt_pci_device *pdev);
+void rt_pci_clear_master(struct rt_pci_device *pdev);
+
 void rt_pci_intx(struct rt_pci_device *pdev, rt_bool_t enable);
 rt_bool_t rt_pci_check_and_mask_intx(struct rt_pci_device *pdev);
 rt_bool_t rt_pci_check_and_unmask_intx(struct rt_pci_device *pdev);
@@ -125,6 +125,9 @@ struct rt_pic_irq
     struct rt_pci_msi_desc *msi_desc;
 
     struct rt_pic_isr isr;
+#ifdef RT_USING_INTERRUPT_INFO
+    rt_ubase_t counter[RT_CPUS_NR];     /* handled times on each cpu */
+#endif
 
     struct rt_spinlock rw_lock;
 
@@ -132,6 +135,17 @@ struct rt_pic_irq
     struct rt_pic_irq *parent;
 };
 
+#ifdef RT_USING_INTERRUPT_INFO
+struct rt_pic_irq_stat
+{
+    int irq;
+    int hwirq;
+    const char *pic_name;
+    char name[RT_NAME_MAX];             /* name of the first handler */
+    rt_ubase_t counter[RT_CPUS_NR];
+};
+#endif /* RT_USING_INTERRUPT_INFO */
+
 void rt_pic_default_name(struct rt_pic *pic);
 struct rt_pic *rt_pic_dynamic_cast(void *ptr);
 
@@ -162,6 +176,9 @@ rt_err_t rt_pic_detach_irq(int irq, void *uid);
 rt_err_t rt_pic_add_traps(rt_bool_t (*handler)(void *), void *data);
 rt_err_t rt_pic_do_traps(void);
 rt_err_t rt_pic_handle_isr(struct rt_pic_irq *pirq);
+#ifdef RT_USING_INTERRUPT_INFO
+rt_err_t rt_pic_irq_get_stat(int irq, struct rt_pic_irq_stat *stat);
+#endif
 
 /* User-implemented extensions */
 rt_err_t rt_pic_user_extends(struct rt_pic *pic);
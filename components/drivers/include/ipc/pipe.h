@@ -12,6 +12,21 @@
 
 #include <rtthread.h>
 
+#ifdef RT_USING_POSIX_PIPE_PAGE
+#define PIPE_BUF_GIFT   0x01    /* a page referenced from a process, never appended */
+
+/**
+ * A page in the buffer of pipe
+ */
+struct rt_pipe_buf
+{
+    void *page;                 /* kernel address of the page */
+    rt_uint32_t offset;         /* offset of the data in the page */
+    rt_uint32_t len;            /* length of the data */
+    rt_uint32_t flags;
+};
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+
 /**
  * Pipe Device
  */
@@ -24,14 +39,26 @@ struct rt_pipe_device
     int pipeno; /* for unamed pipe */
 #endif
 
+#ifdef RT_USING_POSIX_PIPE_PAGE
+    /* ring of pages in pipe device, the pages are allocated when written */
+    struct rt_pipe_buf *bufs;
+    rt_uint32_t nr_bufs;        /* the limit of pages */
+    rt_uint32_t head;           /* the page to be read */
+    rt_uint32_t nr_used;        /* the pages with data */
+    rt_size_t data_len;
+    void *spare;                /* a page read out, kept for the next write */
+#else
     /* ring buffer in pipe device */
     struct rt_ringbuffer *fifo;
-    rt_uint16_t bufsz;
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+    rt_size_t bufsz;
 
     rt_wqueue_t reader_queue;
     rt_wqueue_t writer_queue;
     int writer;
     int reader;
+    int reader_waiting;         /* readers blocked on an empty pipe */
+    int writer_waiting;         /* writers blocked on a full pipe */
 
     struct rt_mutex lock;
 };
@@ -39,5 +66,8 @@ typedef struct rt_pipe_device rt_pipe_t;
 
 rt_pipe_t *rt_pipe_create(const char *name, int bufsz);
 int rt_pipe_delete(const char *name);
+#ifdef RT_USING_POSIX_PIPE_PAGE
+int rt_pipe_put_page(int fildes, void *page, rt_size_t len);
+#endif /* RT_USING_POSIX_PIPE_PAGE */
 
 #endif /* PIPE_H__ */
@@ -21,6 +21,7 @@ enum
 {
     RT_WORK_STATE_PENDING    = 0x0001,     /* Work item pending state */
     RT_WORK_STATE_SUBMITTING = 0x0002,     /* Work item submitting state */
+    RT_WORK_STATE_ACTIVE     = 0x0004,     /* Work item is pending in a worker pool */
 };
 
 /**
@@ -31,6 +32,16 @@ enum
     RT_WORK_TYPE_DELAYED     = 0x0001,
 };
 
+/**
+ * workqueue flags of rt_workqueue_alloc()
+ */
+enum
+{
+    RT_WORKQUEUE_UNBOUND     = 0x0001,     /* run in the unbound pool, for the long works */
+    RT_WORKQUEUE_HIGHPRI     = 0x0002,     /* run in the high priority pools */
+    RT_WORKQUEUE_UNORDERED   = 0x0004,     /* run up to max_active works at the same time */
+};
+
 /* workqueue implementation */
 struct rt_workqueue
 {
@@ -39,7 +50,14 @@ struct rt_workqueue
     struct rt_work *work_current; /* current work */
 
     struct rt_semaphore sem;
-    rt_thread_t    work_thread;
+    rt_thread_t    work_thread;   /* RT_NULL if the works run in the worker pools */
+
+#ifdef RT_USING_WORKQUEUE_POOL
+    rt_uint16_t    flags;
+    rt_uint16_t    max_active;    /* the works in the pools at the same time */
+    rt_uint16_t    nr_active;
+    rt_uint16_t    nr_waiting;    /* the threads waiting for a completion */
+#endif /* RT_USING_WORKQUEUE_POOL */
 };
 
 struct rt_work
@@ -52,6 +70,9 @@ struct rt_work
     rt_uint16_t type;
     struct rt_timer timer;
     struct rt_workqueue *workqueue;
+#ifdef RT_USING_WORKQUEUE_POOL
+    rt_uint16_t cpu;              /* the cpu the work is queued on */
+#endif /* RT_USING_WORKQUEUE_POOL */
 };
 
 #ifdef RT_USING_HEAP
@@ -67,6 +88,10 @@ rt_err_t rt_workqueue_cancel_work(struct rt_workqueue *queue, struct rt_work *wo
 rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue *queue, struct rt_work *work);
 rt_err_t rt_workqueue_cancel_all_work(struct rt_workqueue *queue);
 rt_err_t rt_workqueue_urgent_work(struct rt_workqueue *queue, struct rt_work *work);
+#ifdef RT_USING_WORKQUEUE_POOL
+struct rt_workqueue *rt_workqueue_alloc(rt_uint16_t flags, rt_uint16_t max_active);
+void rt_workqueue_worker_sleeping(struct rt_thread *thread);
+#endif /* RT_USING_WORKQUEUE_POOL */
 
 #ifdef RT_USING_SYSTEM_WORKQUEUE
 rt_err_t rt_work_submit(struct rt_work *work, rt_tick_t ticks);
@@ -13,6 +13,271 @@
 #include <stdint.h>
 #include <sys/errno.h>
 
+#ifdef RT_USING_POSIX_PIPE_PAGE
+#include <mm_page.h>
+#include <mmu.h>
+
+/**
+ * The buffer of pipe is a ring of page references. A page is allocated when
+ * the data is written and freed when it is read out, so an idle pipe holds
+ * no memory beyond one spare page. rt_pipe_put_page() appends a page without
+ * copying it, the page is referenced and never appended by the writes after.
+ */
+
+static void _pipe_page_release(rt_pipe_t *pipe, struct rt_pipe_buf *pbuf)
+{
+    if (!(pbuf->flags & PIPE_BUF_GIFT) && pipe->spare == RT_NULL)
+    {
+        pipe->spare = pbuf->page;
+    }
+    else
+    {
+        rt_pages_free(pbuf->page, 0);
+    }
+    pbuf->page = RT_NULL;
+}
+
+static int _pipe_buf_create(rt_pipe_t *pipe)
+{
+    pipe->nr_bufs = pipe->bufsz >> ARCH_PAGE_SHIFT;
+    pipe->bufs = rt_calloc(pipe->nr_bufs, sizeof(struct rt_pipe_buf));
+    if (pipe->bufs == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+    pipe->head = 0;
+    pipe->nr_used = 0;
+    pipe->data_len = 0;
+
+    return RT_EOK;
+}
+
+static void _pipe_buf_destroy(rt_pipe_t *pipe)
+{
+    if (pipe->bufs == RT_NULL)
+    {
+        return;
+    }
+
+    while (pipe->nr_used)
+    {
+        _pipe_page_release(pipe, &pipe->bufs[pipe->head]);
+        pipe->head = (pipe->head + 1) % pipe->nr_bufs;
+        pipe->nr_used--;
+    }
+    if (pipe->spare)
+    {
+        rt_pages_free(pipe->spare, 0);
+        pipe->spare = RT_NULL;
+    }
+    rt_free(pipe->bufs);
+    pipe->bufs = RT_NULL;
+    pipe->data_len = 0;
+}
+
+rt_inline rt_bool_t _pipe_buf_ready(rt_pipe_t *pipe)
+{
+    return pipe->bufs != RT_NULL;
+}
+
+rt_inline rt_size_t _pipe_data_len(rt_pipe_t *pipe)
+{
+    return pipe->data_len;
+}
+
+/* the last page, or RT_NULL if the data can't be appended to it */
+static struct rt_pipe_buf *_pipe_buf_tail(rt_pipe_t *pipe)
+{
+    struct rt_pipe_buf *pbuf;
+
+    if (pipe->nr_used == 0)
+    {
+        return RT_NULL;
+    }
+
+    pbuf = &pipe->bufs[(pipe->head + pipe->nr_used - 1) % pipe->nr_bufs];
+    if ((pbuf->flags & PIPE_BUF_GIFT) || pbuf->offset + pbuf->len >= ARCH_PAGE_SIZE)
+    {
+        return RT_NULL;
+    }
+
+    return pbuf;
+}
+
+static rt_size_t _pipe_space_len(rt_pipe_t *pipe)
+{
+    rt_size_t len;
+    struct rt_pipe_buf *pbuf;
+
+    len = (rt_size_t)(pipe->nr_bufs - pipe->nr_used) << ARCH_PAGE_SHIFT;
+    pbuf = _pipe_buf_tail(pipe);
+    if (pbuf)
+    {
+        len += ARCH_PAGE_SIZE - pbuf->offset - pbuf->len;
+    }
+
+    return len;
+}
+
+/* return the length written, or -ENOMEM if there is no page for an empty pipe */
+static int _pipe_buf_put(rt_pipe_t *pipe, const void *buf, rt_size_t count)
+{
+    rt_size_t len, put = 0;
+    struct rt_pipe_buf *pbuf;
+    const rt_uint8_t *src = buf;
+
+    pbuf = _pipe_buf_tail(pipe);
+    if (pbuf)
+    {
+        len = ARCH_PAGE_SIZE - pbuf->offset - pbuf->len;
+        len = len < count ? len : count;
+        rt_memcpy((rt_uint8_t *)pbuf->page + pbuf->offset + pbuf->len, src, len);
+        pbuf->len += len;
+        put += len;
+    }
+
+    while (put < count && pipe->nr_used < pipe->nr_bufs)
+    {
+        void *page = pipe->spare;
+
+        if (page)
+        {
+            pipe->spare = RT_NULL;
+        }
+        else
+        {
+            page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+            if (page == RT_NULL)
+            {
+                /* the reader frees the pages, unless there is nothing to read */
+                if (put == 0 && pipe->nr_used == 0)
+                {
+                    return -ENOMEM;
+                }
+                break;
+            }
+        }
+
+        len = count - put < ARCH_PAGE_SIZE ? count - put : ARCH_PAGE_SIZE;
+        rt_memcpy(page, src + put, len);
+
+        pbuf = &pipe->bufs[(pipe->head + pipe->nr_used) % pipe->nr_bufs];
+        pbuf->page = page;
+        pbuf->offset = 0;
+        pbuf->len = len;
+        pbuf->flags = 0;
+        pipe->nr_used++;
+        put += len;
+    }
+    pipe->data_len += put;
+
+    return put;
+}
+
+static int _pipe_buf_get(rt_pipe_t *pipe, void *buf, rt_size_t count)
+{
+    rt_size_t len, got = 0;
+    struct rt_pipe_buf *pbuf;
+    rt_uint8_t *dst = buf;
+
+    while (got < count && pipe->nr_used)
+    {
+        pbuf = &pipe->bufs[pipe->head];
+        len = count - got < pbuf->len ? count - got : pbuf->len;
+        rt_memcpy(dst + got, (rt_uint8_t *)pbuf->page + pbuf->offset, len);
+        pbuf->offset += len;
+        pbuf->len -= len;
+        got += len;
+
+        if (pbuf->len == 0)
+        {
+            _pipe_page_release(pipe, pbuf);
+            pipe->head = (pipe->head + 1) % pipe->nr_bufs;
+            pipe->nr_used--;
+        }
+    }
+    pipe->data_len -= got;
+
+    return got;
+}
+
+/* change the limit of pages, the pages with data are kept in order */
+static int _pipe_buf_resize(rt_pipe_t *pipe, rt_size_t size)
+{
+    rt_uint32_t i, nr_bufs;
+    struct rt_pipe_buf *bufs;
+
+    nr_bufs = RT_ALIGN(size, ARCH_PAGE_SIZE) >> ARCH_PAGE_SHIFT;
+    nr_bufs = nr_bufs ? nr_bufs : 1;
+    if (nr_bufs == pipe->nr_bufs)
+    {
+        return RT_EOK;
+    }
+    if (nr_bufs < pipe->nr_used)
+    {
+        return -EBUSY;
+    }
+
+    bufs = rt_calloc(nr_bufs, sizeof(struct rt_pipe_buf));
+    if (bufs == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+    for (i = 0; i < pipe->nr_used; i++)
+    {
+        bufs[i] = pipe->bufs[(pipe->head + i) % pipe->nr_bufs];
+    }
+    rt_free(pipe->bufs);
+    pipe->bufs = bufs;
+    pipe->nr_bufs = nr_bufs;
+    pipe->head = 0;
+    pipe->bufsz = (rt_size_t)nr_bufs << ARCH_PAGE_SHIFT;
+
+    return RT_EOK;
+}
+#else
+static int _pipe_buf_create(rt_pipe_t *pipe)
+{
+    pipe->fifo = rt_ringbuffer_create(pipe->bufsz);
+
+    return pipe->fifo == RT_NULL ? -RT_ENOMEM : RT_EOK;
+}
+
+static void _pipe_buf_destroy(rt_pipe_t *pipe)
+{
+    if (pipe->fifo != RT_NULL)
+    {
+        rt_ringbuffer_destroy(pipe->fifo);
+    }
+    pipe->fifo = RT_NULL;
+}
+
+rt_inline rt_bool_t _pipe_buf_ready(rt_pipe_t *pipe)
+{
+    return pipe->fifo != RT_NULL;
+}
+
+#define _pipe_data_len(pipe)                rt_ringbuffer_data_len((pipe)->fifo)
+#define _pipe_space_len(pipe)               rt_ringbuffer_space_len((pipe)->fifo)
+#define _pipe_buf_put(pipe, buf, count)     rt_ringbuffer_put((pipe)->fifo, (buf), (count))
+#define _pipe_buf_get(pipe, buf, count)     rt_ringbuffer_get((pipe)->fifo, (buf), (count))
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+
+/*
+ * The readers and writers wake up each other only when the other side is
+ * blocked, either in read/write or in poll. The waiting count is changed
+ * under the pipe lock, so the wakeup is not lost.
+ */
+rt_inline rt_bool_t _pipe_reader_waiting(rt_pipe_t *pipe)
+{
+    return pipe->reader_waiting || !rt_list_isempty(&pipe->reader_queue.waiting_list);
+}
+
+rt_inline rt_bool_t _pipe_writer_waiting(rt_pipe_t *pipe)
+{
+    return pipe->writer_waiting || !rt_list_isempty(&pipe->writer_queue.waiting_list);
+}
+
 #if defined(RT_USING_POSIX_DEVIO) && defined(RT_USING_POSIX_PIPE)
 #include <unistd.h>
 #include <fcntl.h>
@@ -21,6 +286,11 @@
 #include <dfs_file.h>
 #include <resource_id.h>
 
+#ifndef F_SETPIPE_SZ
+#define F_SETPIPE_SZ    1031
+#define F_GETPIPE_SZ    1032
+#endif
+
 /* check RT_UNAMED_PIPE_NUMBER */
 
 #ifndef RT_UNAMED_PIPE_NUMBER
@@ -76,10 +346,9 @@ static int pipe_fops_open(struct dfs_file *fd)
     }
     if (fd->vnode->ref_count == 1)
     {
-        pipe->fifo = rt_ringbuffer_create(pipe->bufsz);
-        if (pipe->fifo == RT_NULL)
+        rc = _pipe_buf_create(pipe);
+        if (rc != RT_EOK)
         {
-            rc = -RT_ENOMEM;
             goto __exit;
         }
     }
@@ -129,11 +398,7 @@ static int pipe_fops_close(struct dfs_file *fd)
 
     if (fd->vnode->ref_count == 1)
     {
-        if (pipe->fifo != RT_NULL)
-        {
-            rt_ringbuffer_destroy(pipe->fifo);
-        }
-        pipe->fifo = RT_NULL;
+        _pipe_buf_destroy(pipe);
     }
 
     rt_mutex_release(&pipe->lock);
@@ -158,11 +423,16 @@ static int pipe_fops_close(struct dfs_file *fd)
  *
  *               FIONWRITE       The command to get the number of bytes can be written to the pipe.
  *
+ *               F_SETPIPE_SZ    The command to set the limit of the pipe buffer, for page buffers only.
+ *
+ *               F_GETPIPE_SZ    The command to get the limit of the pipe buffer, for page buffers only.
+ *
  * @param    args is the pointer to the data to store the read data.
  *
  * @return   Return the operation status.
  *           When the return value is 0, it means the operation is successful.
  *           When the return value is -EINVAL, it means the command is invalid.
+ *           For F_SETPIPE_SZ and F_GETPIPE_SZ, the limit is returned.
  */
 static int pipe_fops_ioctl(struct dfs_file *fd, int cmd, void *args)
 {
@@ -174,11 +444,36 @@ static int pipe_fops_ioctl(struct dfs_file *fd, int cmd, void *args)
     switch (cmd)
     {
     case FIONREAD:
-        *((int*)args) = rt_ringbuffer_data_len(pipe->fifo);
+        rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
+        *((int*)args) = _pipe_data_len(pipe);
+        rt_mutex_release(&pipe->lock);
         break;
     case FIONWRITE:
-        *((int*)args) = rt_ringbuffer_space_len(pipe->fifo);
+        rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
+        *((int*)args) = _pipe_space_len(pipe);
+        rt_mutex_release(&pipe->lock);
         break;
+#ifdef RT_USING_POSIX_PIPE_PAGE
+    case F_SETPIPE_SZ:
+        if ((rt_size_t)args > RT_USING_POSIX_PIPE_MAX_SIZE)
+        {
+            ret = -EPERM;
+            break;
+        }
+        rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
+        ret = _pipe_buf_resize(pipe, (rt_size_t)args);
+        if (ret == RT_EOK)
+        {
+            ret = pipe->bufsz;
+        }
+        rt_mutex_release(&pipe->lock);
+        /* more space for the blocked writers */
+        rt_wqueue_wakeup(&pipe->writer_queue, (void*)POLLOUT);
+        break;
+    case F_GETPIPE_SZ:
+        ret = pipe->bufsz;
+        break;
+#endif /* RT_USING_POSIX_PIPE_PAGE */
     default:
         ret = -EINVAL;
         break;
@@ -204,6 +499,7 @@ static int pipe_fops_read(struct dfs_file *fd, void *buf, size_t count)
 {
     int len = 0;
     rt_pipe_t *pipe;
+    int wakeup = 0;
 
     pipe = (rt_pipe_t *)fd->vnode->data;
 
@@ -212,7 +508,7 @@ static int pipe_fops_read(struct dfs_file *fd, void *buf, size_t count)
 
     while (1)
     {
-        len = rt_ringbuffer_get(pipe->fifo, buf, count);
+        len = _pipe_buf_get(pipe, buf, count);
 
         if (len > 0 || pipe->writer == 0)
         {
@@ -226,18 +522,25 @@ static int pipe_fops_read(struct dfs_file *fd, void *buf, size_t count)
                 goto out;
             }
 
+            pipe->reader_waiting++;
             rt_mutex_release(&pipe->lock);
-            rt_wqueue_wakeup(&pipe->writer_queue, (void*)POLLOUT);
             rt_wqueue_wait(&pipe->reader_queue, 0, -1);
             rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
+            pipe->reader_waiting--;
         }
     }
 
     /* wakeup writer */
-    rt_wqueue_wakeup(&pipe->writer_queue, (void*)POLLOUT);
+    wakeup = len > 0 && _pipe_writer_waiting(pipe);
 
 out:
     rt_mutex_release(&pipe->lock);
+
+    if (wakeup)
+    {
+        rt_wqueue_wakeup(&pipe->writer_queue, (void*)POLLOUT);
+    }
+
     return len;
 }
 
@@ -252,6 +555,7 @@ out:
  *
  * @return   Return the length of data written.
  *           When the return value is -EAGAIN, it means O_NONBLOCK is enabled and there are no space to be written.
+ *           When the return value is -ENOMEM, it means no page can be allocated for an empty pipe.
  *           When the return value is -EPIPE, it means there is no thread that has the pipe open for reading.
  */
 static int pipe_fops_write(struct dfs_file *fd, const void *buf, size_t count)
@@ -274,10 +578,18 @@ static int pipe_fops_write(struct dfs_file *fd, const void *buf, size_t count)
 
     while (1)
     {
-        len = rt_ringbuffer_put(pipe->fifo, pbuf, count - ret);
+        len = _pipe_buf_put(pipe, pbuf, count - ret);
+        if (len < 0)
+        {
+            if (ret == 0)
+            {
+                ret = len;
+            }
+
+            break;
+        }
         ret +=  len;
         pbuf += len;
-        wakeup = 1;
 
         if (ret == count)
         {
@@ -296,12 +608,19 @@ static int pipe_fops_write(struct dfs_file *fd, const void *buf, size_t count)
             }
         }
 
+        wakeup = _pipe_reader_waiting(pipe);
+        pipe->writer_waiting++;
         rt_mutex_release(&pipe->lock);
-        rt_wqueue_wakeup(&pipe->reader_queue, (void*)POLLIN);
+        if (wakeup)
+        {
+            rt_wqueue_wakeup(&pipe->reader_queue, (void*)POLLIN);
+        }
         /* pipe full, waiting on suspended write list */
         rt_wqueue_wait(&pipe->writer_queue, 0, -1);
         rt_mutex_take(&pipe->lock, -1);
+        pipe->writer_waiting--;
     }
+    wakeup = ret > 0 && _pipe_reader_waiting(pipe);
     rt_mutex_release(&pipe->lock);
 
     if (wakeup)
@@ -348,9 +667,11 @@ static int pipe_fops_poll(struct dfs_file *fd, rt_pollreq_t *req)
         break;
     }
 
+    /* checked under the lock after the poll is added, see _pipe_reader_waiting() */
+    rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
     if (mode & 1)
     {
-        if (rt_ringbuffer_data_len(pipe->fifo) != 0)
+        if (_pipe_data_len(pipe) != 0)
         {
             mask |= POLLIN;
         }
@@ -358,11 +679,12 @@ static int pipe_fops_poll(struct dfs_file *fd, rt_pollreq_t *req)
 
     if (mode & 2)
     {
-        if (rt_ringbuffer_space_len(pipe->fifo) != 0)
+        if (_pipe_space_len(pipe) != 0)
         {
             mask |= POLLOUT;
         }
     }
+    rt_mutex_release(&pipe->lock);
 
     return mask;
 }
@@ -379,6 +701,84 @@ static const struct dfs_file_ops pipe_fops =
     RT_NULL,
     pipe_fops_poll,
 };
+
+#ifdef RT_USING_POSIX_PIPE_PAGE
+/**
+ * @brief    This function will append a page to a pipe without copying it.
+ *           The page is read out as it is when it is reached by the readers,
+ *           so the owner must not change it until then.
+ *
+ * @param    fildes is the file descriptor of the pipe opened for writing.
+ *
+ * @param    page is the kernel address of the page, the caller holds a reference of it.
+ *
+ * @param    len is the length of data from the start of the page.
+ *
+ * @return   Return the length appended, the reference is taken over by the pipe.
+ *           When the return value is -EBADF, it means the file descriptor is not a pipe opened for writing.
+ *           When the return value is -EINVAL, it means the length is larger than a page.
+ *           When the return value is -EAGAIN, it means O_NONBLOCK is enabled and the pipe is full.
+ */
+int rt_pipe_put_page(int fildes, void *page, rt_size_t len)
+{
+    struct dfs_file *fd;
+    rt_pipe_t *pipe;
+    struct rt_pipe_buf *pbuf;
+    int wakeup;
+
+    fd = fd_get(fildes);
+    if (fd == RT_NULL || fd->vnode == RT_NULL || fd->vnode->fops != &pipe_fops ||
+        (fd->flags & O_ACCMODE) == O_RDONLY)
+    {
+        return -EBADF;
+    }
+    if (len == 0 || len > ARCH_PAGE_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    pipe = (rt_pipe_t *)fd->vnode->data;
+    rt_mutex_take(&pipe->lock, -1);
+
+    while (pipe->nr_used == pipe->nr_bufs)
+    {
+        if (fd->flags & O_NONBLOCK)
+        {
+            rt_mutex_release(&pipe->lock);
+            return -EAGAIN;
+        }
+
+        wakeup = _pipe_reader_waiting(pipe);
+        pipe->writer_waiting++;
+        rt_mutex_release(&pipe->lock);
+        if (wakeup)
+        {
+            rt_wqueue_wakeup(&pipe->reader_queue, (void*)POLLIN);
+        }
+        rt_wqueue_wait(&pipe->writer_queue, 0, -1);
+        rt_mutex_take(&pipe->lock, -1);
+        pipe->writer_waiting--;
+    }
+
+    pbuf = &pipe->bufs[(pipe->head + pipe->nr_used) % pipe->nr_bufs];
+    pbuf->page = page;
+    pbuf->offset = 0;
+    pbuf->len = len;
+    pbuf->flags = PIPE_BUF_GIFT;
+    pipe->nr_used++;
+    pipe->data_len += len;
+
+    wakeup = _pipe_reader_waiting(pipe);
+    rt_mutex_release(&pipe->lock);
+
+    if (wakeup)
+    {
+        rt_wqueue_wakeup(&pipe->reader_queue, (void*)POLLIN);
+    }
+
+    return len;
+}
+#endif /* RT_USING_POSIX_PIPE_PAGE */
 #endif /* defined(RT_USING_POSIX_DEVIO) && defined(RT_USING_POSIX_PIPE) */
 
 /**
@@ -406,13 +806,9 @@ rt_err_t rt_pipe_open(rt_device_t device, rt_uint16_t oflag)
 
     rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
 
-    if (pipe->fifo == RT_NULL)
+    if (!_pipe_buf_ready(pipe))
     {
-        pipe->fifo = rt_ringbuffer_create(pipe->bufsz);
-        if (pipe->fifo == RT_NULL)
-        {
-            ret = -RT_ENOMEM;
-        }
+        ret = _pipe_buf_create(pipe);
     }
 
     rt_mutex_release(&pipe->lock);
@@ -440,8 +836,7 @@ rt_err_t rt_pipe_close(rt_device_t device)
     }
     rt_mutex_take(&pipe->lock, RT_WAITING_FOREVER);
 
-    rt_ringbuffer_destroy(pipe->fifo);
-    pipe->fifo = RT_NULL;
+    _pipe_buf_destroy(pipe);
 
     rt_mutex_release(&pipe->lock);
 
@@ -483,7 +878,7 @@ rt_ssize_t rt_pipe_read(rt_device_t device, rt_off_t pos, void *buffer, rt_size_
 
     while (read_bytes < count)
     {
-        int len = rt_ringbuffer_get(pipe->fifo, &pbuf[read_bytes], count - read_bytes);
+        int len = _pipe_buf_get(pipe, &pbuf[read_bytes], count - read_bytes);
         if (len <= 0)
         {
             break;
@@ -531,7 +926,7 @@ rt_ssize_t rt_pipe_write(rt_device_t device, rt_off_t pos, const void *buffer, r
 
     while (write_bytes < count)
     {
-        int len = rt_ringbuffer_put(pipe->fifo, &pbuf[write_bytes], count - write_bytes);
+        int len = _pipe_buf_put(pipe, &pbuf[write_bytes], count - write_bytes);
         if (len <= 0)
         {
             break;
@@ -579,7 +974,7 @@ const static struct rt_device_ops pipe_ops =
  *
  * @param    name is the name of pipe device.
  *
- * @param    bufsz is the size of pipe buffer.
+ * @param    bufsz is the size of pipe buffer, rounded up to pages for page buffers.
  *
  * @return   Return the pointer to the pipe device.
  *           When the return value is RT_NULL, it means the initialization failed.
@@ -603,8 +998,13 @@ rt_pipe_t *rt_pipe_create(const char *name, int bufsz)
     pipe->writer = 0;
     pipe->reader = 0;
 
+#ifdef RT_USING_POSIX_PIPE_PAGE
+    RT_ASSERT(bufsz <= RT_USING_POSIX_PIPE_MAX_SIZE);
+    pipe->bufsz = RT_ALIGN(bufsz > 0 ? bufsz : 1, ARCH_PAGE_SIZE);
+#else
     RT_ASSERT(bufsz < 0xFFFF);
     pipe->bufsz = bufsz;
+#endif /* RT_USING_POSIX_PIPE_PAGE */
 
     dev = &pipe->parent;
     dev->type = RT_Device_Class_Pipe;
@@ -669,12 +1069,8 @@ int rt_pipe_delete(const char *name)
 #endif
             rt_device_unregister(device);
 
-            /* close fifo ringbuffer */
-            if (pipe->fifo)
-            {
-                rt_ringbuffer_destroy(pipe->fifo);
-                pipe->fifo = RT_NULL;
-            }
+            /* close fifo buffer */
+            _pipe_buf_destroy(pipe);
             rt_free(pipe);
         }
         else
@@ -9,6 +9,7 @@
  * 2021-08-01     Meco Man     remove rt_delayed_work_init()
  * 2021-08-14     Jackistang   add comments for function interface
  * 2022-01-16     Meco Man     add rt_work_urgent()
+ * 2023-10-18     RT-Thread    add the concurrency-managed worker pools
  */
 
 #include <rthw.h>
@@ -89,6 +90,576 @@ static void _workqueue_thread_entry(void *parameter)
     }
 }
 
+#ifdef RT_USING_WORKQUEUE_POOL
+
+#ifdef RT_USING_SMP
+#define WQ_CPUS_NR              RT_CPUS_NR
+#define WQ_CPU_ID()             rt_hw_cpu_id()
+#else
+#define WQ_CPUS_NR              1
+#define WQ_CPU_ID()             0
+#endif /* RT_USING_SMP */
+
+#define WQ_POOL_UNBOUND         WQ_CPUS_NR
+#define WQ_POOL_IDLE_TIMEOUT    (RT_TICK_PER_SECOND * 5)
+#define WQ_BUSY_HASH_NR         16
+
+struct rt_worker_pool
+{
+    rt_uint16_t cpu;                /* WQ_POOL_UNBOUND for the unbound pool */
+    rt_uint8_t  priority;
+    rt_uint8_t  highpri;
+    rt_list_t   work_list;          /* the active works to run */
+    rt_list_t   idle_list;          /* the idle workers, the latest one first */
+    rt_list_t   busy_list;          /* the workers woken up or running a work */
+    rt_uint16_t nr_pending;
+    rt_uint16_t nr_workers;
+    rt_uint16_t nr_idle;
+    rt_uint16_t worker_id;
+};
+
+struct rt_worker
+{
+    rt_list_t   node;               /* in the idle or the busy list of the pool */
+    rt_list_t   hnode;              /* in the busy hash while it runs a work */
+    rt_thread_t thread;
+    struct rt_worker_pool *pool;
+    struct rt_work *current;        /* the running work */
+    rt_tick_t   idle_tick;          /* when the worker became idle */
+    rt_bool_t   exiting;
+};
+
+/* the bound pools of each cpu and the unbound pool, normal and high priority */
+static struct rt_worker_pool _wq_pools[WQ_CPUS_NR + 1][2];
+/* the workers running a work, hashed by the work */
+static rt_list_t _wq_busy_hash[WQ_BUSY_HASH_NR];
+static struct rt_semaphore _wq_manager_sem;
+/* wakes up the manager for a worker blocked in the scheduler, where it can't be released */
+static struct rt_timer _wq_manager_timer;
+static rt_thread_t _wq_manager;
+
+static void _wq_worker_entry(void *parameter);
+
+rt_inline rt_bool_t _wq_pooled(struct rt_workqueue *queue)
+{
+    return queue->work_thread == RT_NULL;
+}
+
+rt_inline struct rt_worker_pool *_wq_pool_get(struct rt_workqueue *queue, int cpu)
+{
+    return &_wq_pools[(queue->flags & RT_WORKQUEUE_UNBOUND) ? WQ_POOL_UNBOUND : cpu]
+                     [(queue->flags & RT_WORKQUEUE_HIGHPRI) ? 1 : 0];
+}
+
+rt_inline rt_list_t *_wq_busy_head(struct rt_work *work)
+{
+    return &_wq_busy_hash[((rt_ubase_t)work / sizeof(void *)) % WQ_BUSY_HASH_NR];
+}
+
+/*
+ * Whether the work is running in a worker. It is looked up by the work in the
+ * busy hash rather than recorded in the work, as the work may be freed by its
+ * own function and is never touched after it ran.
+ */
+static rt_bool_t _wq_work_running(struct rt_work *work)
+{
+    struct rt_worker *worker;
+
+    rt_list_for_each_entry(worker, _wq_busy_head(work), hnode)
+    {
+        if (worker->current == work)
+        {
+            return RT_TRUE;
+        }
+    }
+
+    return RT_FALSE;
+}
+
+/* wake up the threads waiting for the works of the queue, the interrupt is disabled */
+static void _wq_queue_complete(struct rt_workqueue *queue)
+{
+    rt_uint16_t nr_waiting = queue->nr_waiting;
+
+    /* the waiters are switched to after the queue is no longer touched */
+    rt_enter_critical();
+    queue->nr_waiting = 0;
+    while (nr_waiting--)
+    {
+        rt_sem_release(&(queue->sem));
+    }
+    rt_exit_critical();
+}
+
+/*
+ * Wait for a work of the queue to complete, it is called and returns with the
+ * interrupt disabled. The waiter is counted before the interrupt is enabled,
+ * so a completion in between is not missed.
+ */
+static rt_base_t _wq_queue_wait(struct rt_workqueue *queue, rt_base_t level)
+{
+    queue->nr_waiting++;
+    rt_hw_interrupt_enable(level);
+    rt_sem_take(&(queue->sem), RT_WAITING_FOREVER);
+
+    return rt_hw_interrupt_disable();
+}
+
+/*
+ * Whether the pool needs another worker for the pending works. The blocked
+ * workers are not counted, so a work sleeping on I/O does not hold the others.
+ * The bound pool keeps one worker runnable, the unbound pool keeps a runnable
+ * worker for each pending work.
+ */
+static rt_bool_t _wq_pool_need_worker(struct rt_worker_pool *pool)
+{
+    struct rt_worker *worker;
+    int runnable = 0, waking = 0;
+
+    if (pool->nr_pending == 0)
+    {
+        return RT_FALSE;
+    }
+
+    rt_list_for_each_entry(worker, &pool->busy_list, node)
+    {
+        if ((worker->thread->stat & RT_THREAD_SUSPEND_MASK) != RT_THREAD_SUSPEND_MASK)
+        {
+            runnable++;
+            if (worker->current == RT_NULL)
+            {
+                waking++;
+            }
+        }
+    }
+
+    if (pool->cpu != WQ_POOL_UNBOUND)
+    {
+        return runnable == 0;
+    }
+
+    return waking < pool->nr_pending;
+}
+
+/* wake up an idle worker of the pool, it never schedules */
+static rt_bool_t _wq_pool_wake_idle(struct rt_worker_pool *pool)
+{
+    struct rt_worker *worker;
+
+    if (rt_list_isempty(&pool->idle_list))
+    {
+        return RT_FALSE;
+    }
+
+    worker = rt_list_first_entry(&pool->idle_list, struct rt_worker, node);
+    rt_list_remove(&(worker->node));
+    rt_list_insert_before(&pool->busy_list, &(worker->node));
+    pool->nr_idle--;
+    rt_thread_resume(worker->thread);
+
+    return RT_TRUE;
+}
+
+/* wake up an idle worker, or ask the manager for a new one */
+static void _wq_pool_kick(struct rt_worker_pool *pool)
+{
+    if (!_wq_pool_need_worker(pool))
+    {
+        return;
+    }
+
+    if (!_wq_pool_wake_idle(pool) && pool->nr_workers < RT_WORKQUEUE_POOL_MAX_WORKERS)
+    {
+        rt_sem_release(&_wq_manager_sem);
+    }
+}
+
+/**
+ * @brief Called by the scheduler when a thread blocks, with the interrupt
+ *        disabled. The works left behind a blocked worker get an idle worker,
+ *        or the manager is woken up on the next tick to start a new one.
+ *
+ * @param thread is the thread to be suspended.
+ */
+void rt_workqueue_worker_sleeping(struct rt_thread *thread)
+{
+    struct rt_worker *worker;
+    struct rt_worker_pool *pool;
+
+    if (thread->entry != (void *)_wq_worker_entry)
+    {
+        return;
+    }
+
+    /* an idle worker blocks without any work */
+    worker = (struct rt_worker *)thread->parameter;
+    pool = worker->pool;
+    if (worker->current == RT_NULL || !_wq_pool_need_worker(pool))
+    {
+        return;
+    }
+
+    if (!_wq_pool_wake_idle(pool) && pool->nr_workers < RT_WORKQUEUE_POOL_MAX_WORKERS &&
+        !(_wq_manager_timer.parent.flag & RT_TIMER_FLAG_ACTIVATED))
+    {
+        rt_timer_start(&_wq_manager_timer);
+    }
+}
+
+/* move an inactive work to its pool */
+static void _wq_pool_insert(struct rt_workqueue *queue, struct rt_work *work, rt_bool_t urgent)
+{
+    struct rt_worker_pool *pool = _wq_pool_get(queue, work->cpu);
+
+    queue->nr_active++;
+    work->flags |= RT_WORK_STATE_ACTIVE;
+    if (urgent)
+    {
+        rt_list_insert_after(&pool->work_list, &(work->list));
+    }
+    else
+    {
+        rt_list_insert_before(&pool->work_list, &(work->list));
+    }
+    pool->nr_pending++;
+
+    _wq_pool_kick(pool);
+}
+
+/* move the inactive works of the queue to the pools until max_active */
+static void _wq_queue_activate(struct rt_workqueue *queue)
+{
+    struct rt_work *work;
+
+    while (queue->nr_active < queue->max_active && !rt_list_isempty(&queue->work_list))
+    {
+        work = rt_list_first_entry(&queue->work_list, struct rt_work, list);
+        rt_list_remove(&(work->list));
+        _wq_pool_insert(queue, work, RT_FALSE);
+    }
+}
+
+/* queue a work on the current cpu, the interrupt is disabled */
+static void _wq_queue_work(struct rt_workqueue *queue, struct rt_work *work, rt_bool_t urgent)
+{
+    work->flags |= RT_WORK_STATE_PENDING;
+    work->workqueue = queue;
+    work->cpu = WQ_CPU_ID();
+
+    if (queue->nr_active < queue->max_active)
+    {
+        _wq_pool_insert(queue, work, urgent);
+    }
+    else if (urgent)
+    {
+        rt_list_insert_after(&queue->work_list, &(work->list));
+    }
+    else
+    {
+        rt_list_insert_before(&queue->work_list, &(work->list));
+    }
+}
+
+static void _wq_worker_entry(void *parameter)
+{
+    rt_base_t level;
+    rt_uint16_t idle;
+    struct rt_work *work, *queued;
+    struct rt_workqueue *queue;
+    struct rt_worker *worker = (struct rt_worker *)parameter;
+    struct rt_worker_pool *pool = worker->pool;
+
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        if (worker->exiting)
+        {
+            /* it has been removed from the pool by the manager */
+            rt_hw_interrupt_enable(level);
+            RT_KERNEL_FREE(worker);
+            return;
+        }
+
+        /* a work is never run by two workers at the same time */
+        work = RT_NULL;
+        rt_list_for_each_entry(queued, &pool->work_list, list)
+        {
+            if (!_wq_work_running(queued))
+            {
+                work = queued;
+                break;
+            }
+        }
+
+        if (work == RT_NULL)
+        {
+            /* no work to do, become idle, the manager stops the idle workers left over */
+            rt_list_remove(&(worker->node));
+            rt_list_insert_after(&pool->idle_list, &(worker->node));
+            pool->nr_idle++;
+            worker->idle_tick = rt_tick_get();
+            rt_thread_suspend_with_flag(rt_thread_self(), RT_UNINTERRUPTIBLE);
+            idle = pool->nr_idle;
+            rt_hw_interrupt_enable(level);
+            if (idle == 2)
+            {
+                /* the manager sleeps until the first worker left over */
+                rt_sem_release(&_wq_manager_sem);
+            }
+            rt_schedule();
+            continue;
+        }
+
+        rt_list_remove(&(work->list));
+        pool->nr_pending--;
+        work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_ACTIVE);
+        queue = work->workqueue;
+        work->workqueue = RT_NULL;
+        worker->current = work;
+        rt_list_insert_after(_wq_busy_head(work), &(worker->hnode));
+
+        /* the works left may need another worker */
+        _wq_pool_kick(pool);
+        rt_hw_interrupt_enable(level);
+
+        /* do work */
+        work->work_func(work, work->work_data);
+
+        level = rt_hw_interrupt_disable();
+        rt_list_remove(&(worker->hnode));
+        worker->current = RT_NULL;
+        queue->nr_active--;
+        _wq_queue_activate(queue);
+        /* ack work completion, the queue may be destroyed once it is unlocked */
+        _wq_queue_complete(queue);
+        rt_hw_interrupt_enable(level);
+    }
+}
+
+static rt_err_t _wq_worker_create(struct rt_worker_pool *pool)
+{
+    rt_base_t level;
+    struct rt_worker *worker;
+    char name[RT_NAME_MAX];
+
+    worker = (struct rt_worker *)RT_KERNEL_MALLOC(sizeof(struct rt_worker));
+    if (worker == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    if (pool->cpu == WQ_POOL_UNBOUND)
+    {
+        rt_snprintf(name, sizeof(name), "kworker/u:%d%s", pool->worker_id++, pool->highpri ? "H" : "");
+    }
+    else
+    {
+        rt_snprintf(name, sizeof(name), "kworker/%d:%d%s", pool->cpu, pool->worker_id++, pool->highpri ? "H" : "");
+    }
+
+    worker->pool = pool;
+    rt_list_init(&(worker->hnode));
+    worker->current = RT_NULL;
+    worker->idle_tick = 0;
+    worker->exiting = RT_FALSE;
+    worker->thread = rt_thread_create(name, _wq_worker_entry, worker,
+                                      RT_WORKQUEUE_POOL_STACKSIZE, pool->priority, 10);
+    if (worker->thread == RT_NULL)
+    {
+        RT_KERNEL_FREE(worker);
+        return -RT_ENOMEM;
+    }
+
+#ifdef RT_USING_SMP
+    if (pool->cpu != WQ_POOL_UNBOUND)
+    {
+        rt_thread_control(worker->thread, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)pool->cpu);
+    }
+#endif /* RT_USING_SMP */
+
+    /* it is woken up to look for the works */
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&pool->busy_list, &(worker->node));
+    pool->nr_workers++;
+    rt_hw_interrupt_enable(level);
+
+    rt_thread_startup(worker->thread);
+
+    return RT_EOK;
+}
+
+static void _wq_manager_timeout(void *parameter)
+{
+    rt_sem_release(&_wq_manager_sem);
+}
+
+/*
+ * The manager starts the workers when the running works block, and stops the
+ * workers idle for a while. It is woken up by the pools, by a worker blocked
+ * with the works left, or when the oldest idle worker times out.
+ */
+static void _wq_manager_entry(void *parameter)
+{
+    rt_base_t level;
+    rt_int32_t timeout;
+    rt_tick_t idle;
+    rt_bool_t create;
+    struct rt_worker *worker;
+    struct rt_worker_pool *pool;
+    int cpu, pri;
+
+    while (1)
+    {
+        timeout = RT_WAITING_FOREVER;
+
+        for (cpu = 0; cpu <= WQ_POOL_UNBOUND; cpu++)
+        {
+            for (pri = 0; pri < 2; pri++)
+            {
+                pool = &_wq_pools[cpu][pri];
+
+                level = rt_hw_interrupt_disable();
+                create = RT_FALSE;
+                if (_wq_pool_need_worker(pool))
+                {
+                    if (!rt_list_isempty(&pool->idle_list))
+                    {
+                        _wq_pool_kick(pool);
+                    }
+                    else if (pool->nr_workers < RT_WORKQUEUE_POOL_MAX_WORKERS)
+                    {
+                        create = RT_TRUE;
+                    }
+                }
+
+                /* stop the oldest idle worker, one is kept for the next work */
+                if (pool->nr_idle > 1)
+                {
+                    worker = rt_list_entry(pool->idle_list.prev, struct rt_worker, node);
+                    if (rt_tick_get() - worker->idle_tick >= WQ_POOL_IDLE_TIMEOUT)
+                    {
+                        rt_list_remove(&(worker->node));
+                        pool->nr_idle--;
+                        pool->nr_workers--;
+                        worker->exiting = RT_TRUE;
+                        rt_thread_resume(worker->thread);
+                    }
+                }
+
+                /* sleep until the next idle worker times out */
+                if (pool->nr_idle > 1)
+                {
+                    worker = rt_list_entry(pool->idle_list.prev, struct rt_worker, node);
+                    idle = rt_tick_get() - worker->idle_tick;
+                    idle = idle < WQ_POOL_IDLE_TIMEOUT ? WQ_POOL_IDLE_TIMEOUT - idle : 1;
+                    if (timeout == RT_WAITING_FOREVER || (rt_tick_t)timeout > idle)
+                    {
+                        timeout = (rt_int32_t)idle;
+                    }
+                }
+                rt_hw_interrupt_enable(level);
+
+                if (create)
+                {
+                    _wq_worker_create(pool);
+                }
+            }
+        }
+
+        rt_sem_take(&_wq_manager_sem, timeout);
+        /* the requests are handled by one pass */
+        while (rt_sem_trytake(&_wq_manager_sem) == RT_EOK);
+    }
+}
+
+/**
+ * @brief Initialize the worker pools and start the manager.
+ *
+ * @return RT_EOK on success, -RT_ENOMEM if it fails to create the threads.
+ */
+static int rt_workqueue_pool_init(void)
+{
+    int cpu, pri;
+    struct rt_worker_pool *pool;
+
+    if (_wq_manager != RT_NULL)
+    {
+        return RT_EOK;
+    }
+
+    for (cpu = 0; cpu <= WQ_POOL_UNBOUND; cpu++)
+    {
+        for (pri = 0; pri < 2; pri++)
+        {
+            pool = &_wq_pools[cpu][pri];
+            pool->cpu = cpu;
+            pool->highpri = pri;
+            pool->priority = pri ? RT_WORKQUEUE_POOL_HIGHPRI_PRIORITY : RT_WORKQUEUE_POOL_PRIORITY;
+            rt_list_init(&pool->work_list);
+            rt_list_init(&pool->idle_list);
+            rt_list_init(&pool->busy_list);
+            pool->nr_pending = 0;
+            pool->nr_workers = 0;
+            pool->nr_idle = 0;
+            pool->worker_id = 0;
+        }
+    }
+    for (cpu = 0; cpu < WQ_BUSY_HASH_NR; cpu++)
+    {
+        rt_list_init(&_wq_busy_hash[cpu]);
+    }
+
+    rt_sem_init(&_wq_manager_sem, "kwmgr", 0, RT_IPC_FLAG_FIFO);
+    rt_timer_init(&_wq_manager_timer, "kwmgr", _wq_manager_timeout, RT_NULL, 1,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+    _wq_manager = rt_thread_create("kwmgr", _wq_manager_entry, RT_NULL,
+                                   2048, RT_WORKQUEUE_POOL_HIGHPRI_PRIORITY, 10);
+    if (_wq_manager == RT_NULL)
+    {
+        rt_timer_detach(&_wq_manager_timer);
+        rt_sem_detach(&_wq_manager_sem);
+        return -RT_ENOMEM;
+    }
+    rt_thread_startup(_wq_manager);
+
+    return RT_EOK;
+}
+INIT_PREV_EXPORT(rt_workqueue_pool_init);
+
+#endif /* RT_USING_WORKQUEUE_POOL */
+
+/* remove a pending work from its list */
+static void _workqueue_work_dequeue(struct rt_work *work)
+{
+    rt_list_remove(&(work->list));
+
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (work->flags & RT_WORK_STATE_ACTIVE)
+    {
+        struct rt_workqueue *queue = work->workqueue;
+
+        _wq_pool_get(queue, work->cpu)->nr_pending--;
+        work->flags &= ~RT_WORK_STATE_ACTIVE;
+        queue->nr_active--;
+        _wq_queue_activate(queue);
+    }
+#endif /* RT_USING_WORKQUEUE_POOL */
+
+    work->flags &= ~RT_WORK_STATE_PENDING;
+}
+
+rt_inline rt_bool_t _workqueue_work_running(struct rt_workqueue *queue, struct rt_work *work)
+{
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (_wq_pooled(queue))
+    {
+        return _wq_work_running(work);
+    }
+#endif /* RT_USING_WORKQUEUE_POOL */
+
+    return queue->work_current == work;
+}
+
 static rt_err_t _workqueue_submit_work(struct rt_workqueue *queue,
                                        struct rt_work *work, rt_tick_t ticks)
 {
@@ -97,11 +668,20 @@ static rt_err_t _workqueue_submit_work(struct rt_workqueue *queue,
     level = rt_hw_interrupt_disable();
 
     /* remove list */
-    rt_list_remove(&(work->list));
-    work->flags &= ~RT_WORK_STATE_PENDING;
+    _workqueue_work_dequeue(work);
 
     if (ticks == 0)
     {
+#ifdef RT_USING_WORKQUEUE_POOL
+        if (_wq_pooled(queue))
+        {
+            _wq_queue_work(queue, work, RT_FALSE);
+            rt_hw_interrupt_enable(level);
+            rt_schedule();
+            return RT_EOK;
+        }
+#endif /* RT_USING_WORKQUEUE_POOL */
+
         rt_list_insert_after(queue->work_list.prev, &(work->list));
         work->flags |= RT_WORK_STATE_PENDING;
         work->workqueue = queue;
@@ -152,8 +732,7 @@ static rt_err_t _workqueue_cancel_work(struct rt_workqueue *queue, struct rt_wor
     rt_err_t err;
 
     level = rt_hw_interrupt_disable();
-    rt_list_remove(&(work->list));
-    work->flags &= ~RT_WORK_STATE_PENDING;
+    _workqueue_work_dequeue(work);
     /* Timer started */
     if (work->flags & RT_WORK_STATE_SUBMITTING)
     {
@@ -161,7 +740,7 @@ static rt_err_t _workqueue_cancel_work(struct rt_workqueue *queue, struct rt_wor
         rt_timer_detach(&(work->timer));
         work->flags &= ~RT_WORK_STATE_SUBMITTING;
     }
-    err = queue->work_current != work ? RT_EOK : -RT_EBUSY;
+    err = _workqueue_work_running(queue, work) ? -RT_EBUSY : RT_EOK;
     work->workqueue = RT_NULL;
     rt_hw_interrupt_enable(level);
     return err;
@@ -182,6 +761,15 @@ static void _delayed_work_timeout_handler(void *parameter)
     work->flags &= ~RT_WORK_STATE_SUBMITTING;
     /* remove delay list */
     rt_list_remove(&(work->list));
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (_wq_pooled(queue))
+    {
+        _wq_queue_work(queue, work, RT_FALSE);
+        rt_hw_interrupt_enable(level);
+        rt_schedule();
+        return;
+    }
+#endif /* RT_USING_WORKQUEUE_POOL */
     /* insert work queue */
     if (queue->work_current != work)
     {
@@ -250,6 +838,12 @@ struct rt_workqueue *rt_workqueue_create(const char *name, rt_uint16_t stack_siz
         rt_list_init(&(queue->delayed_list));
         queue->work_current = RT_NULL;
         rt_sem_init(&(queue->sem), "wqueue", 0, RT_IPC_FLAG_FIFO);
+#ifdef RT_USING_WORKQUEUE_POOL
+        queue->flags = 0;
+        queue->max_active = 1;
+        queue->nr_active = 0;
+        queue->nr_waiting = 0;
+#endif /* RT_USING_WORKQUEUE_POOL */
 
         /* create the work thread */
         queue->work_thread = rt_thread_create(name, _workqueue_thread_entry, queue, stack_size, priority, 10);
@@ -265,6 +859,55 @@ struct rt_workqueue *rt_workqueue_create(const char *name, rt_uint16_t stack_siz
     return queue;
 }
 
+#ifdef RT_USING_WORKQUEUE_POOL
+/**
+ * @brief Allocate a work queue running in the shared worker pools.
+ *
+ * @param flags is the RT_WORKQUEUE_* flags. The works run on the cpu they are
+ *        submitted on, or in the unbound pool with RT_WORKQUEUE_UNBOUND.
+ *
+ * @param max_active is the maximum number of the works running at the same
+ *        time with RT_WORKQUEUE_UNORDERED, 0 for the default. The works run
+ *        one by one in order without RT_WORKQUEUE_UNORDERED.
+ *
+ * @return Return a pointer to the workqueue object. It will return RT_NULL if failed.
+ */
+struct rt_workqueue *rt_workqueue_alloc(rt_uint16_t flags, rt_uint16_t max_active)
+{
+    struct rt_workqueue *queue = RT_NULL;
+
+    if (rt_workqueue_pool_init() != RT_EOK)
+    {
+        return RT_NULL;
+    }
+
+    queue = (struct rt_workqueue *)RT_KERNEL_MALLOC(sizeof(struct rt_workqueue));
+    if (queue != RT_NULL)
+    {
+        rt_list_init(&(queue->work_list));
+        rt_list_init(&(queue->delayed_list));
+        queue->work_current = RT_NULL;
+        queue->work_thread = RT_NULL;
+        rt_sem_init(&(queue->sem), "wqueue", 0, RT_IPC_FLAG_FIFO);
+
+        if (!(flags & RT_WORKQUEUE_UNORDERED))
+        {
+            max_active = 1;
+        }
+        else if (max_active == 0)
+        {
+            max_active = RT_WORKQUEUE_POOL_MAX_ACTIVE;
+        }
+        queue->flags = flags;
+        queue->max_active = max_active;
+        queue->nr_active = 0;
+        queue->nr_waiting = 0;
+    }
+
+    return queue;
+}
+#endif /* RT_USING_WORKQUEUE_POOL */
+
 /**
  * @brief Destroy a work queue.
  *
@@ -277,6 +920,21 @@ rt_err_t rt_workqueue_destroy(struct rt_workqueue *queue)
     RT_ASSERT(queue != RT_NULL);
 
     rt_workqueue_cancel_all_work(queue);
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (_wq_pooled(queue))
+    {
+        rt_base_t level;
+
+        /* wait for the running works */
+        level = rt_hw_interrupt_disable();
+        while (queue->nr_active != 0)
+        {
+            level = _wq_queue_wait(queue, level);
+        }
+        rt_hw_interrupt_enable(level);
+    }
+    else
+#endif /* RT_USING_WORKQUEUE_POOL */
     rt_thread_delete(queue->work_thread);
     rt_sem_detach(&(queue->sem));
     RT_KERNEL_FREE(queue);
@@ -344,8 +1002,19 @@ rt_err_t rt_workqueue_urgent_work(struct rt_workqueue *queue, struct rt_work *wo
 
     level = rt_hw_interrupt_disable();
     /* NOTE: the work MUST be initialized firstly */
-    rt_list_remove(&(work->list));
+    _workqueue_work_dequeue(work);
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (_wq_pooled(queue))
+    {
+        _wq_queue_work(queue, work, RT_TRUE);
+        rt_hw_interrupt_enable(level);
+        rt_schedule();
+        return RT_EOK;
+    }
+#endif /* RT_USING_WORKQUEUE_POOL */
     rt_list_insert_after(&queue->work_list, &(work->list));
+    work->flags |= RT_WORK_STATE_PENDING;
+    work->workqueue = queue;
     /* whether the workqueue is doing work */
     if (queue->work_current == RT_NULL &&
             ((queue->work_thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK))
@@ -395,6 +1064,20 @@ rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue *queue, struct rt_wor
     RT_ASSERT(queue != RT_NULL);
     RT_ASSERT(work != RT_NULL);
 
+#ifdef RT_USING_WORKQUEUE_POOL
+    if (_wq_pooled(queue))
+    {
+        rt_base_t level;
+
+        level = rt_hw_interrupt_disable();
+        while (_workqueue_cancel_work(queue, work) == -RT_EBUSY)
+        {
+            level = _wq_queue_wait(queue, level);
+        }
+        rt_hw_interrupt_enable(level);
+    }
+    else
+#endif /* RT_USING_WORKQUEUE_POOL */
     if (queue->work_current == work) /* it's current work in the queue */
     {
         /* wait for work completion */
@@ -434,6 +1117,31 @@ rt_err_t rt_workqueue_cancel_all_work(struct rt_workqueue *queue)
         work = rt_list_first_entry(&queue->delayed_list, struct rt_work, list);
         _workqueue_cancel_work(queue, work);
     }
+#ifdef RT_USING_WORKQUEUE_POOL
+    /* cancel the works in the pools */
+    if (_wq_pooled(queue))
+    {
+        int cpu, pri;
+
+        for (cpu = 0; cpu <= WQ_POOL_UNBOUND; cpu++)
+        {
+            for (pri = 0; pri < 2; pri++)
+            {
+                rt_list_t *node = _wq_pools[cpu][pri].work_list.next;
+
+                while (node != &_wq_pools[cpu][pri].work_list)
+                {
+                    work = rt_list_entry(node, struct rt_work, list);
+                    node = node->next;
+                    if (work->workqueue == queue)
+                    {
+                        _workqueue_cancel_work(queue, work);
+                    }
+                }
+            }
+        }
+    }
+#endif /* RT_USING_WORKQUEUE_POOL */
     rt_exit_critical();
 
     return RT_EOK;
@@ -491,8 +1199,13 @@ static int rt_work_sys_workqueue_init(void)
     if (sys_workq != RT_NULL)
         return RT_EOK;
 
+#ifdef RT_USING_WORKQUEUE_POOL
+    /* the works run on the submitting cpu, a blocked work does not hold the others */
+    sys_workq = rt_workqueue_alloc(RT_WORKQUEUE_UNORDERED, 0);
+#else
     sys_workq = rt_workqueue_create("sys workq", RT_SYSTEM_WORKQUEUE_STACKSIZE,
                                     RT_SYSTEM_WORKQUEUE_PRIORITY);
+#endif /* RT_USING_WORKQUEUE_POOL */
     RT_ASSERT(sys_workq != RT_NULL);
 
     return RT_EOK;
@@ -73,6 +73,7 @@ void gic_common_sgi_config(void *base, void *data, int irq_base)
 
         DECLARE_GIC_IPI(RT_SCHEDULE_IPI, 0);
         DECLARE_GIC_IPI(RT_STOP_IPI, 1);
+        DECLARE_GIC_IPI(RT_SMP_CALL_IPI, 2);
 
 #undef DECLARE_GIC_IPI
     }
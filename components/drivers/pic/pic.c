@@ -30,6 +30,7 @@ static int _ipi_hash[] =
 #ifdef RT_USING_SMP
     [RT_SCHEDULE_IPI] = RT_SCHEDULE_IPI,
     [RT_STOP_IPI] = RT_STOP_IPI,
+    [RT_SMP_CALL_IPI] = RT_SMP_CALL_IPI,
 #endif
 };
 
@@ -529,7 +530,12 @@ rt_err_t rt_pic_handle_isr(struct rt_pic_irq *pirq)
         action->handler(pirq->irq, action->param);
     #ifdef RT_USING_INTERRUPT_INFO
         action->counter++;
+    #ifdef RT_USING_SMP
+        pirq->counter[rt_hw_cpu_id()]++;
+    #else
+        pirq->counter[0]++;
     #endif
+    #endif /* RT_USING_INTERRUPT_INFO */
 
         if (!rt_list_isempty(handler_nodes))
         {
@@ -554,6 +560,41 @@ rt_err_t rt_pic_handle_isr(struct rt_pic_irq *pirq)
     return err;
 }
 
+#ifdef RT_USING_INTERRUPT_INFO
+/**
+ * @brief Get a snapshot of the counters of an irq, the counters are only
+ *        written by the cpu handling the irq, so no lock is taken.
+ *
+ * @param irq the irq number, from 0 to MAX_HANDLERS - 1.
+ * @param stat the buffer of the snapshot.
+ *
+ * @return RT_EOK on success, -RT_EEMPTY if the irq has no handler.
+ */
+rt_err_t rt_pic_irq_get_stat(int irq, struct rt_pic_irq_stat *stat)
+{
+    struct rt_pic_irq *pirq;
+
+    if (irq < 0 || irq >= MAX_HANDLERS || !stat)
+    {
+        return -RT_EINVAL;
+    }
+
+    pirq = &_pirq_hash[irq];
+    if (!pirq->pic || !pirq->isr.action.handler)
+    {
+        return -RT_EEMPTY;
+    }
+
+    stat->irq = pirq->irq;
+    stat->hwirq = pirq->hwirq;
+    stat->pic_name = pirq->pic->ops->name;
+    rt_strncpy(stat->name, pirq->isr.action.name, RT_NAME_MAX);
+    rt_memcpy(stat->counter, pirq->counter, sizeof(stat->counter));
+
+    return RT_EOK;
+}
+#endif /* RT_USING_INTERRUPT_INFO */
+
 rt_weak rt_err_t rt_pic_user_extends(struct rt_pic *pic)
 {
     return -RT_ENOSYS;
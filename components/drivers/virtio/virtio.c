@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2023-10-18     RT-Thread    dispatch to the transport of the device
  */
 
 #include <rtthread.h>
@@ -16,13 +17,19 @@
 rt_inline void _virtio_dev_check(struct virtio_device *dev)
 {
     RT_ASSERT(dev != RT_NULL);
-    RT_ASSERT(dev->mmio_config != RT_NULL);
+    RT_ASSERT(dev->trans != RT_NULL || dev->mmio_config != RT_NULL);
 }
 
 void virtio_reset_device(struct virtio_device *dev)
 {
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        dev->trans->set_status(dev, 0);
+        return;
+    }
+
     dev->mmio_config->status = 0;
 }
 
@@ -30,6 +37,12 @@ void virtio_status_acknowledge_driver(struct virtio_device *dev)
 {
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        dev->trans->set_status(dev, dev->trans->get_status(dev) | VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+        return;
+    }
+
     dev->mmio_config->status |= VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER;
 }
 
@@ -37,6 +50,12 @@ void virtio_status_driver_ok(struct virtio_device *dev)
 {
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        dev->trans->set_status(dev, dev->trans->get_status(dev) | VIRTIO_STATUS_FEATURES_OK | VIRTIO_STATUS_DRIVER_OK);
+        return;
+    }
+
     dev->mmio_config->status |= VIRTIO_STATUS_FEATURES_OK | VIRTIO_STATUS_DRIVER_OK;
 }
 
@@ -46,6 +65,12 @@ void virtio_interrupt_ack(struct virtio_device *dev)
 
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        dev->trans->interrupt_ack(dev);
+        return;
+    }
+
     status = dev->mmio_config->interrupt_status;
 
     if (status != 0)
@@ -58,9 +83,103 @@ rt_bool_t virtio_has_feature(struct virtio_device *dev, rt_uint32_t feature_bit)
 {
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        return !!(dev->trans->get_features(dev) & (1ULL << feature_bit));
+    }
+
     return !!(dev->mmio_config->device_features & (1UL << feature_bit));
 }
 
+/**
+ * @brief Write the features the driver accepts and set FEATURES_OK, the
+ *        device should have been acknowledged.
+ *
+ * @param dev is the virtio device.
+ *
+ * @param unsupported is the mask of the features the driver does not accept.
+ *
+ * @return RT_EOK on success, -RT_ERROR if the device rejects the features.
+ */
+rt_err_t virtio_negotiate_features(struct virtio_device *dev, rt_uint64_t unsupported)
+{
+    rt_uint64_t features;
+
+    _virtio_dev_check(dev);
+
+    if (dev->trans)
+    {
+        features = dev->trans->get_features(dev) & ~unsupported;
+        dev->trans->set_features(dev, features);
+        dev->trans->set_status(dev, dev->trans->get_status(dev) | VIRTIO_STATUS_FEATURES_OK);
+
+        if (!(dev->trans->get_status(dev) & VIRTIO_STATUS_FEATURES_OK))
+        {
+            dev->trans->set_status(dev, dev->trans->get_status(dev) | VIRTIO_STATUS_FAILED);
+            return -RT_ERROR;
+        }
+
+        return RT_EOK;
+    }
+
+    /* the legacy mmio device sets FEATURES_OK with DRIVER_OK */
+    dev->mmio_config->driver_features = dev->mmio_config->device_features & ~(rt_uint32_t)unsupported;
+
+    return RT_EOK;
+}
+
+/**
+ * @brief Get the device specific configuration space.
+ */
+void *virtio_device_config(struct virtio_device *dev)
+{
+    _virtio_dev_check(dev);
+
+    if (dev->trans)
+    {
+        return dev->trans->get_config(dev);
+    }
+
+    return (void *)dev->mmio_config->config;
+}
+
+/**
+ * @brief Install the interrupt handler of a queue. The mmio device has only
+ *        one interrupt for all the queues, so the handler of the first call is
+ *        installed, the transports with the vector for each queue install the
+ *        handler to the vector of the queue.
+ *
+ * @param dev is the virtio device.
+ *
+ * @param queue_index is the index of the queue.
+ *
+ * @param handler is the interrupt handler.
+ *
+ * @param param is the parameter of the handler.
+ *
+ * @param name is the name of the interrupt.
+ *
+ * @return RT_EOK on success, or the error of the transport.
+ */
+rt_err_t virtio_queue_irq_install(struct virtio_device *dev, rt_uint32_t queue_index,
+        rt_isr_handler_t handler, void *param, const char *name)
+{
+    _virtio_dev_check(dev);
+
+    if (dev->trans)
+    {
+        return dev->trans->irq_install(dev, queue_index, handler, param, name);
+    }
+
+    if (queue_index == 0)
+    {
+        rt_hw_interrupt_install(dev->irq, handler, param, name);
+        rt_hw_interrupt_umask(dev->irq);
+    }
+
+    return RT_EOK;
+}
+
 rt_err_t virtio_queues_alloc(struct virtio_device *dev, rt_size_t queues_num)
 {
     _virtio_dev_check(dev);
@@ -95,8 +214,15 @@ rt_err_t virtio_queue_init(struct virtio_device *dev, rt_uint32_t queue_index, r
 
     _virtio_dev_check(dev);
 
-    RT_ASSERT(dev->mmio_config->queue_num_max > 0);
-    RT_ASSERT(dev->mmio_config->queue_num_max > queue_index);
+    if (dev->trans)
+    {
+        RT_ASSERT(dev->trans->queue_max(dev, queue_index) >= ring_size);
+    }
+    else
+    {
+        RT_ASSERT(dev->mmio_config->queue_num_max > 0);
+        RT_ASSERT(dev->mmio_config->queue_num_max > queue_index);
+    }
     /* ring_size is power of 2 */
     RT_ASSERT(ring_size > 0);
     RT_ASSERT(((ring_size - 1) & ring_size) == 0);
@@ -122,11 +248,14 @@ rt_err_t virtio_queue_init(struct virtio_device *dev, rt_uint32_t queue_index, r
 
     rt_memset(pages, 0, pages_total_size);
 
-    dev->mmio_config->guest_page_size = VIRTIO_PAGE_SIZE;
-    dev->mmio_config->queue_sel = queue_index;
-    dev->mmio_config->queue_num = ring_size;
-    dev->mmio_config->queue_align = VIRTIO_PAGE_SIZE;
-    dev->mmio_config->queue_pfn = VIRTIO_VA2PA(pages) >> VIRTIO_PAGE_SHIFT;
+    if (!dev->trans)
+    {
+        dev->mmio_config->guest_page_size = VIRTIO_PAGE_SIZE;
+        dev->mmio_config->queue_sel = queue_index;
+        dev->mmio_config->queue_num = ring_size;
+        dev->mmio_config->queue_align = VIRTIO_PAGE_SIZE;
+        dev->mmio_config->queue_pfn = VIRTIO_VA2PA(pages) >> VIRTIO_PAGE_SHIFT;
+    }
 
     queue->num = ring_size;
     queue->desc = (struct virtq_desc *)((rt_ubase_t)pages);
@@ -144,6 +273,16 @@ rt_err_t virtio_queue_init(struct virtio_device *dev, rt_uint32_t queue_index, r
 
     queue->free_count = ring_size;
 
+    /* the transport programs the addresses of the rings */
+    if (dev->trans && dev->trans->queue_setup(dev, queue_index) != RT_EOK)
+    {
+        rt_free(queue->free);
+        rt_free_align(pages);
+        queue->num = 0;
+
+        return -RT_ERROR;
+    }
+
     return RT_EOK;
 }
 
@@ -153,19 +292,30 @@ void virtio_queue_destroy(struct virtio_device *dev, rt_uint32_t queue_index)
 
     _virtio_dev_check(dev);
 
-    RT_ASSERT(dev->mmio_config->queue_num_max > 0);
-    RT_ASSERT(dev->mmio_config->queue_num_max > queue_index);
+    if (!dev->trans)
+    {
+        RT_ASSERT(dev->mmio_config->queue_num_max > 0);
+        RT_ASSERT(dev->mmio_config->queue_num_max > queue_index);
+    }
 
     queue = &dev->queues[queue_index];
 
     RT_ASSERT(queue->num > 0);
 
+    /* stop the device from using the rings before they are freed */
+    if (dev->trans)
+    {
+        dev->trans->queue_release(dev, queue_index);
+    }
+    else
+    {
+        dev->mmio_config->queue_sel = queue_index;
+        dev->mmio_config->queue_pfn = RT_NULL;
+    }
+
     rt_free(queue->free);
     rt_free_align((void *)queue->desc);
 
-    dev->mmio_config->queue_sel = queue_index;
-    dev->mmio_config->queue_pfn = RT_NULL;
-
     queue->num = 0;
     queue->desc = RT_NULL;
     queue->avail = RT_NULL;
@@ -176,6 +326,12 @@ void virtio_queue_notify(struct virtio_device *dev, rt_uint32_t queue_index)
 {
     _virtio_dev_check(dev);
 
+    if (dev->trans)
+    {
+        dev->trans->queue_notify(dev, queue_index);
+        return;
+    }
+
     dev->mmio_config->queue_notify = queue_index;
 }
 
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-9-16      GuEe-GUI     the first version
  * 2021-11-11     GuEe-GUI     modify to virtio common interface
+ * 2023-10-18     RT-Thread    add the transport interface for virtio-pci
  */
 
 #ifndef __VIRTIO_H__
@@ -141,6 +142,27 @@ enum
     VIRTIO_DEVICE_TYPE_SIZE
 };
 
+struct virtio_device;
+
+/* the transport other than the mmio, such as the virtio-pci */
+struct virtio_transport_ops
+{
+    rt_uint8_t (*get_status)(struct virtio_device *dev);
+    void (*set_status)(struct virtio_device *dev, rt_uint8_t status);
+    rt_uint64_t (*get_features)(struct virtio_device *dev);
+    void (*set_features)(struct virtio_device *dev, rt_uint64_t features);
+    void *(*get_config)(struct virtio_device *dev);
+
+    rt_size_t (*queue_max)(struct virtio_device *dev, rt_uint32_t queue_index);
+    rt_err_t (*queue_setup)(struct virtio_device *dev, rt_uint32_t queue_index);
+    void (*queue_release)(struct virtio_device *dev, rt_uint32_t queue_index);
+    void (*queue_notify)(struct virtio_device *dev, rt_uint32_t queue_index);
+
+    rt_uint32_t (*interrupt_ack)(struct virtio_device *dev);
+    rt_err_t (*irq_install)(struct virtio_device *dev, rt_uint32_t queue_index,
+            rt_isr_handler_t handler, void *param, const char *name);
+};
+
 struct virtio_device
 {
     rt_uint32_t irq;
@@ -154,6 +176,10 @@ struct virtio_device
         struct virtio_mmio_config *mmio_config;
     };
 
+    /* RT_NULL for the mmio transport */
+    const struct virtio_transport_ops *trans;
+    void *trans_priv;
+
 #ifdef RT_USING_SMP
     struct rt_spinlock spinlock;
 #endif
@@ -162,12 +188,18 @@ struct virtio_device
 };
 
 typedef rt_err_t (*virtio_device_init_handler)(rt_ubase_t *mmio_base, rt_uint32_t irq);
+/* the transport is a template of the virtio_device, it is copied to the device */
+typedef rt_err_t (*virtio_device_probe_handler)(struct virtio_device *transport);
 
 void virtio_reset_device(struct virtio_device *dev);
 void virtio_status_acknowledge_driver(struct virtio_device *dev);
 void virtio_status_driver_ok(struct virtio_device *dev);
 void virtio_interrupt_ack(struct virtio_device *dev);
 rt_bool_t virtio_has_feature(struct virtio_device *dev, rt_uint32_t feature_bit);
+rt_err_t virtio_negotiate_features(struct virtio_device *dev, rt_uint64_t unsupported);
+void *virtio_device_config(struct virtio_device *dev);
+rt_err_t virtio_queue_irq_install(struct virtio_device *dev, rt_uint32_t queue_index,
+        rt_isr_handler_t handler, void *param, const char *name);
 
 rt_err_t virtio_queues_alloc(struct virtio_device *dev, rt_size_t queues_num);
 void virtio_queues_free(struct virtio_device *dev);
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-9-16      GuEe-GUI     the first version
  * 2021-11-11     GuEe-GUI     using virtio common interface
+ * 2023-10-18     RT-Thread    probe on any virtio transport
  */
 
 #include <rthw.h>
@@ -171,14 +172,23 @@ static void virtio_blk_isr(int irqno, void *param)
 #endif
 }
 
-rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
+/**
+ * @brief Probe a virtio block device on a transport.
+ *
+ * @param transport is the template of the virtio device, it is copied to the
+ *        block device.
+ *
+ * @return RT_EOK on success, or the error code.
+ */
+rt_err_t rt_virtio_blk_probe(struct virtio_device *transport)
 {
+    rt_err_t err;
     static int dev_no = 0;
     char dev_name[RT_NAME_MAX];
     struct virtio_device *virtio_dev;
     struct virtio_blk_device *virtio_blk_dev;
 
-    virtio_blk_dev = rt_malloc(sizeof(struct virtio_blk_device));
+    virtio_blk_dev = rt_calloc(1, sizeof(struct virtio_blk_device));
 
     if (virtio_blk_dev == RT_NULL)
     {
@@ -186,10 +196,7 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     }
 
     virtio_dev = &virtio_blk_dev->virtio_dev;
-    virtio_dev->irq = irq;
-    virtio_dev->mmio_base = mmio_base;
-
-    virtio_blk_dev->config = (struct virtio_blk_config *)virtio_dev->mmio_config->config;
+    *virtio_dev = *transport;
 
 #ifdef RT_USING_SMP
     rt_spin_lock_init(&virtio_dev->spinlock);
@@ -199,7 +206,7 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     virtio_status_acknowledge_driver(virtio_dev);
 
     /* Negotiate features */
-    virtio_dev->mmio_config->driver_features = virtio_dev->mmio_config->device_features & ~(
+    err = virtio_negotiate_features(virtio_dev,
             (1 << VIRTIO_BLK_F_RO) |
             (1 << VIRTIO_BLK_F_MQ) |
             (1 << VIRTIO_BLK_F_SCSI) |
@@ -208,8 +215,13 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
             (1 << VIRTIO_F_RING_EVENT_IDX) |
             (1 << VIRTIO_F_RING_INDIRECT_DESC));
 
-    /* Tell device that feature negotiation is complete and we're completely ready */
-    virtio_status_driver_ok(virtio_dev);
+    if (err != RT_EOK)
+    {
+        rt_free(virtio_blk_dev);
+        return err;
+    }
+
+    virtio_blk_dev->config = (struct virtio_blk_config *)virtio_device_config(virtio_dev);
 
     if (virtio_queues_alloc(virtio_dev, 1) != RT_EOK)
     {
@@ -236,8 +248,10 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 
     rt_snprintf(dev_name, RT_NAME_MAX, "virtio-blk%d", dev_no++);
 
-    rt_hw_interrupt_install(irq, virtio_blk_isr, virtio_blk_dev, dev_name);
-    rt_hw_interrupt_umask(irq);
+    virtio_queue_irq_install(virtio_dev, VIRTIO_BLK_QUEUE, virtio_blk_isr, virtio_blk_dev, dev_name);
+
+    /* Tell device that feature negotiation is complete and we're completely ready */
+    virtio_status_driver_ok(virtio_dev);
 
     return rt_device_register((rt_device_t)virtio_blk_dev, dev_name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE);
 
@@ -250,4 +264,14 @@ _alloc_fail:
     }
     return -RT_ENOMEM;
 }
+
+rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
+{
+    struct virtio_device transport = { 0 };
+
+    transport.irq = irq;
+    transport.mmio_base = mmio_base;
+
+    return rt_virtio_blk_probe(&transport);
+}
 #endif /* RT_USING_VIRTIO_BLK */
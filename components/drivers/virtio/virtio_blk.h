@@ -101,5 +101,6 @@ struct virtio_blk_device
 };
 
 rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq);
+rt_err_t rt_virtio_blk_probe(struct virtio_device *transport);
 
 #endif /* __VIRTIO_BLK_H__ */
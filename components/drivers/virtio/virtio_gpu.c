@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2023-10-18     RT-Thread    add damage tracking and asynchronous flush
  */
 
 #include <rthw.h>
@@ -16,6 +17,10 @@
 
 #include <virtio_gpu.h>
 
+#if defined(ARCH_ARMV8) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 static struct virtio_gpu_device *_primary_virtio_gpu_dev = RT_NULL;
 
 static rt_ubase_t _pixel_format_convert(rt_ubase_t format, rt_bool_t to_virtio_gpu_format)
@@ -68,20 +73,14 @@ static void virtio_gpu_ctrl_send_command(struct virtio_gpu_device *virtio_gpu_de
     void *ret_res = ((rt_uint8_t *)addr + cmd_len);
     struct virtio_device *virtio_dev = &virtio_gpu_dev->virtio_dev;
 
-#ifdef RT_USING_SMP
+    /* The isr frees the descriptors of the asynchronous commands, lock it on UP as well */
     rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
 
     while (virtio_alloc_desc_chain(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, 2, idx))
     {
-#ifdef RT_USING_SMP
         rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
         rt_thread_yield();
-
-#ifdef RT_USING_SMP
         level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
     }
 
     rt_memcpy(&virtio_gpu_dev->gpu_request, cmd, cmd_len);
@@ -102,23 +101,94 @@ static void virtio_gpu_ctrl_send_command(struct virtio_gpu_device *virtio_gpu_de
 
     while (virtio_gpu_dev->info[idx[0]].ctrl_valid)
     {
-#ifdef RT_USING_SMP
         rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
         rt_thread_yield();
-
-#ifdef RT_USING_SMP
         level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
     }
 
     virtio_free_desc_chain(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, idx[0]);
 
     rt_memcpy(res, ret_res, res_len);
 
-#ifdef RT_USING_SMP
     rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+}
+
+/**
+ * @brief Submit a command without waiting for its response, the descriptors
+ *        are freed by the isr when the command is completed.
+ *
+ * @param fence_id is the fence of the command, or 0 for no fence.
+ *
+ * @param notify is whether to notify the device, the commands of a batch
+ *        only notify it once with the last one.
+ */
+static void virtio_gpu_ctrl_submit_async(struct virtio_gpu_device *virtio_gpu_dev,
+        struct virtio_gpu_ctrl_hdr *cmd, rt_size_t cmd_len, rt_uint64_t fence_id, rt_bool_t notify)
+{
+    rt_base_t level;
+    rt_uint16_t idx[2];
+    struct virtio_device *virtio_dev = &virtio_gpu_dev->virtio_dev;
+
+    if (fence_id != 0)
+    {
+        cmd->flags |= VIRTIO_GPU_FLAG_FENCE;
+        cmd->fence_id = fence_id;
+    }
+
+    level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
+
+    while (virtio_alloc_desc_chain(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, 2, idx))
+    {
+        /* The submitted commands of this batch may not be notified yet */
+        virtio_queue_notify(virtio_dev, VIRTIO_GPU_QUEUE_CTRL);
+
+        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
+        rt_thread_yield();
+        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
+    }
+
+    rt_memcpy(&virtio_gpu_dev->info[idx[0]].ctrl_cmd, cmd, cmd_len);
+    rt_memset(&virtio_gpu_dev->info[idx[0]].ctrl_res, 0, sizeof(struct virtio_gpu_ctrl_hdr));
+
+    virtio_fill_desc(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, idx[0],
+            VIRTIO_VA2PA(&virtio_gpu_dev->info[idx[0]].ctrl_cmd), cmd_len, VIRTQ_DESC_F_NEXT, idx[1]);
+
+    virtio_fill_desc(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, idx[1],
+            VIRTIO_VA2PA(&virtio_gpu_dev->info[idx[0]].ctrl_res), sizeof(struct virtio_gpu_ctrl_hdr),
+            VIRTQ_DESC_F_WRITE, 0);
+
+    virtio_gpu_dev->info[idx[0]].ctrl_fence_id = fence_id;
+    virtio_gpu_dev->info[idx[0]].ctrl_async = RT_TRUE;
+    virtio_gpu_dev->info[idx[0]].ctrl_valid = RT_TRUE;
+
+    virtio_submit_chain(virtio_dev, VIRTIO_GPU_QUEUE_CTRL, idx[0]);
+
+    if (notify)
+    {
+        virtio_queue_notify(virtio_dev, VIRTIO_GPU_QUEUE_CTRL);
+    }
+
+    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
+}
+
+/* Called in the isr with the lock of the device */
+static void virtio_gpu_ctrl_async_done(struct virtio_gpu_device *virtio_gpu_dev, rt_uint16_t id)
+{
+    if (virtio_gpu_dev->info[id].ctrl_res.type != VIRTIO_GPU_RESP_OK_NODATA)
+    {
+        virtio_gpu_dev->async_status = -RT_ERROR;
+    }
+
+    /* The commands are completed in order, the fences are increasing */
+    if (virtio_gpu_dev->info[id].ctrl_fence_id != 0)
+    {
+        virtio_gpu_dev->fence_done = virtio_gpu_dev->info[id].ctrl_fence_id;
+    }
+
+    virtio_gpu_dev->info[id].ctrl_async = RT_FALSE;
+    virtio_gpu_dev->info[id].ctrl_valid = RT_FALSE;
+
+    virtio_free_desc_chain(&virtio_gpu_dev->virtio_dev, VIRTIO_GPU_QUEUE_CTRL, id);
 }
 
 static void virtio_gpu_cursor_send_command(struct virtio_gpu_device *virtio_gpu_dev,
@@ -324,19 +394,163 @@ static rt_err_t virtio_gpu_transfer_to_host_2d(struct virtio_gpu_device *virtio_
     return -RT_ERROR;
 }
 
-static rt_err_t virtio_gpu_gfx_flush_2d(struct virtio_gpu_device *virtio_gpu_dev, rt_uint32_t resource_id,
-        rt_uint32_t x, rt_uint32_t y, rt_uint32_t width, rt_uint32_t height)
+static rt_uint64_t _damage_area(const struct virtio_gpu_damage_rect *rect)
 {
-    rt_err_t status = virtio_gpu_transfer_to_host_2d(virtio_gpu_dev, resource_id, x, y, width, height, 0);
+    return (rt_uint64_t)(rect->x2 - rect->x1) * (rect->y2 - rect->y1);
+}
 
-    if (status == RT_EOK)
+static void _damage_union(struct virtio_gpu_damage_rect *rect, const struct virtio_gpu_damage_rect *other)
+{
+    rect->x1 = rt_min(rect->x1, other->x1);
+    rect->y1 = rt_min(rect->y1, other->y1);
+    rect->x2 = rt_max(rect->x2, other->x2);
+    rect->y2 = rt_max(rect->y2, other->y2);
+}
+
+/**
+ * @brief Add a damaged region of the framebuffer. The regions are merged if
+ *        the bounding box of them is not larger than the sum of them, or the
+ *        ones growing the least are merged if there are too many of them.
+ */
+static void virtio_gpu_damage_add(struct virtio_gpu_device *virtio_gpu_dev,
+        rt_uint32_t x1, rt_uint32_t y1, rt_uint32_t x2, rt_uint32_t y2)
+{
+    rt_base_t level;
+    rt_uint32_t i, best;
+    rt_int64_t waste, best_waste;
+    struct virtio_gpu_damage_rect rect, merged;
+    struct virtio_gpu_damage_rect *damage = virtio_gpu_dev->damage;
+
+    rect.x1 = x1;
+    rect.y1 = y1;
+    rect.x2 = rt_min(x2, virtio_gpu_dev->pmode.r.width);
+    rect.y2 = rt_min(y2, virtio_gpu_dev->pmode.r.height);
+
+    if (virtio_gpu_dev->framebuffer == RT_NULL || rect.x1 >= rect.x2 || rect.y1 >= rect.y2)
     {
-        status = virtio_gpu_flush_resource(virtio_gpu_dev, resource_id, x, y, width, height);
+        return;
     }
 
+    level = rt_spin_lock_irqsave(&virtio_gpu_dev->damage_lock);
+
+    for (;;)
+    {
+        best = virtio_gpu_dev->damage_nr;
+        best_waste = 0;
+
+        for (i = 0; i < virtio_gpu_dev->damage_nr; ++i)
+        {
+            merged = damage[i];
+            _damage_union(&merged, &rect);
+
+            waste = (rt_int64_t)_damage_area(&merged) - _damage_area(&damage[i]) - _damage_area(&rect);
+
+            if (waste <= 0 || best == virtio_gpu_dev->damage_nr || waste < best_waste)
+            {
+                best = i;
+                best_waste = waste;
+
+                if (waste <= 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (best == virtio_gpu_dev->damage_nr ||
+            (best_waste > 0 && virtio_gpu_dev->damage_nr < VIRTIO_GPU_DAMAGE_RECTS))
+        {
+            damage[virtio_gpu_dev->damage_nr++] = rect;
+            break;
+        }
+
+        /* Take the region out, and add the merged one again as it may be merged with the others */
+        _damage_union(&rect, &damage[best]);
+        damage[best] = damage[--virtio_gpu_dev->damage_nr];
+    }
+
+    rt_spin_unlock_irqrestore(&virtio_gpu_dev->damage_lock, level);
+}
+
+/**
+ * @brief Transfer the damaged regions to the host and flush the bounding box
+ *        of them. The commands are submitted without waiting, and the flush
+ *        is fenced, RTGRAPHIC_CTRL_WAIT_VSYNC waits for the fence.
+ *
+ * @return the error of the asynchronous commands completed since last time.
+ */
+static rt_err_t virtio_gpu_damage_flush(struct virtio_gpu_device *virtio_gpu_dev)
+{
+    rt_err_t status;
+    rt_base_t level;
+    rt_uint32_t i, nr, pitch;
+    struct virtio_gpu_damage_rect damage[VIRTIO_GPU_DAMAGE_RECTS], bound;
+    struct virtio_gpu_transfer_to_host_2d transfer;
+    struct virtio_gpu_resource_flush flush;
+
+    level = rt_spin_lock_irqsave(&virtio_gpu_dev->damage_lock);
+
+    nr = virtio_gpu_dev->damage_nr;
+    rt_memcpy(damage, virtio_gpu_dev->damage, nr * sizeof(damage[0]));
+    virtio_gpu_dev->damage_nr = 0;
+
+    rt_spin_unlock_irqrestore(&virtio_gpu_dev->damage_lock, level);
+
+    if (nr > 0)
+    {
+        pitch = virtio_gpu_dev->pmode.r.width * VIRTIO_GPU_FORMAT_PIXEL;
+        bound = damage[0];
+
+        for (i = 0; i < nr; ++i)
+        {
+            rt_memset(&transfer, 0, sizeof(transfer));
+
+            transfer.hdr.type = VIRTIO_GPU_CMD_TRANSFER_TO_HOST_2D;
+            transfer.r.x = damage[i].x1;
+            transfer.r.y = damage[i].y1;
+            transfer.r.width = damage[i].x2 - damage[i].x1;
+            transfer.r.height = damage[i].y2 - damage[i].y1;
+            /* The offset of the first pixel of the region in the backing */
+            transfer.offset = damage[i].y1 * pitch + damage[i].x1 * VIRTIO_GPU_FORMAT_PIXEL;
+            transfer.resource_id = virtio_gpu_dev->display_resource_id;
+
+            virtio_gpu_ctrl_submit_async(virtio_gpu_dev, &transfer.hdr, sizeof(transfer), 0, RT_FALSE);
+
+            _damage_union(&bound, &damage[i]);
+        }
+
+        rt_memset(&flush, 0, sizeof(flush));
+
+        flush.hdr.type = VIRTIO_GPU_CMD_RESOURCE_FLUSH;
+        flush.r.x = bound.x1;
+        flush.r.y = bound.y1;
+        flush.r.width = bound.x2 - bound.x1;
+        flush.r.height = bound.y2 - bound.y1;
+        flush.resource_id = virtio_gpu_dev->display_resource_id;
+
+        virtio_gpu_ctrl_submit_async(virtio_gpu_dev, &flush.hdr, sizeof(flush), ++virtio_gpu_dev->fence_id, RT_TRUE);
+    }
+
+    level = rt_spin_lock_irqsave(&virtio_gpu_dev->virtio_dev.spinlock);
+
+    status = virtio_gpu_dev->async_status;
+    virtio_gpu_dev->async_status = RT_EOK;
+
+    rt_spin_unlock_irqrestore(&virtio_gpu_dev->virtio_dev.spinlock, level);
+
     return status;
 }
 
+static void virtio_gpu_wait_fence(struct virtio_gpu_device *virtio_gpu_dev)
+{
+    rt_uint64_t fence_id = virtio_gpu_dev->fence_id;
+
+    while (virtio_gpu_dev->fence_done < fence_id)
+    {
+        rt_thread_yield();
+    }
+}
+
 static rt_err_t virtio_gpu_update_cursor(struct virtio_gpu_device *virtio_gpu_dev, rt_uint32_t scanout_id,
         rt_uint32_t resource_id, rt_uint32_t hot_x, rt_uint32_t hot_y)
 {
@@ -468,6 +682,7 @@ static rt_ssize_t virtio_gpu_read(rt_device_t dev, rt_off_t pos, void *buffer, r
 
 static rt_ssize_t virtio_gpu_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
 {
+    rt_uint32_t pitch;
     struct virtio_gpu_device *virtio_gpu_dev = (struct virtio_gpu_device *)dev;
 
     if (virtio_gpu_dev->framebuffer == RT_NULL || pos + size >= virtio_gpu_dev->smem_len)
@@ -481,6 +696,14 @@ static rt_ssize_t virtio_gpu_write(rt_device_t dev, rt_off_t pos, const void *bu
 
     rt_mutex_release(&virtio_gpu_dev->rw_mutex);
 
+    pitch = virtio_gpu_dev->pmode.r.width * VIRTIO_GPU_FORMAT_PIXEL;
+
+    if (pitch != 0 && size != 0)
+    {
+        virtio_gpu_damage_add(virtio_gpu_dev, 0, pos / pitch,
+                virtio_gpu_dev->pmode.r.width, (pos + size + pitch - 1) / pitch);
+    }
+
     return size;
 }
 
@@ -495,6 +718,20 @@ static rt_err_t virtio_gpu_control(rt_device_t dev, int cmd, void *args)
 
         _primary_virtio_gpu_dev = virtio_gpu_dev;
 
+        return status;
+    case VIRTIO_DEVICE_CTRL_GPU_FLUSH:
+
+        rt_mutex_take(&virtio_gpu_dev->ops_mutex, RT_WAITING_FOREVER);
+
+        status = virtio_gpu_damage_flush(virtio_gpu_dev);
+
+        rt_mutex_release(&virtio_gpu_dev->ops_mutex);
+
+        return status;
+    case RTGRAPHIC_CTRL_WAIT_VSYNC:
+
+        virtio_gpu_wait_fence(virtio_gpu_dev);
+
         return status;
     }
 
@@ -515,8 +752,14 @@ static rt_err_t virtio_gpu_control(rt_device_t dev, int cmd, void *args)
                 break;
             }
 
-            status = virtio_gpu_gfx_flush_2d(virtio_gpu_dev, virtio_gpu_dev->display_resource_id,
-                    info->x, info->y, info->width, info->height);
+            virtio_gpu_damage_add(virtio_gpu_dev, info->x, info->y,
+                    info->x + info->width, info->y + info->height);
+
+            rt_mutex_take(&virtio_gpu_dev->ops_mutex, RT_WAITING_FOREVER);
+
+            status = virtio_gpu_damage_flush(virtio_gpu_dev);
+
+            rt_mutex_release(&virtio_gpu_dev->ops_mutex);
         }
         break;
     case RTGRAPHIC_CTRL_GET_INFO:
@@ -678,6 +921,31 @@ const static struct rt_device_ops virtio_gpu_ops =
 };
 #endif
 
+static void _fill32(rt_uint32_t *dst, rt_uint32_t color, rt_size_t count)
+{
+#if defined(ARCH_ARMV8) && defined(__ARM_NEON)
+    uint32x4_t value = vdupq_n_u32(color);
+
+    for (; count >= 16; count -= 16, dst += 16)
+    {
+        vst1q_u32(dst, value);
+        vst1q_u32(dst + 4, value);
+        vst1q_u32(dst + 8, value);
+        vst1q_u32(dst + 12, value);
+    }
+
+    for (; count >= 4; count -= 4, dst += 4)
+    {
+        vst1q_u32(dst, value);
+    }
+#endif /* ARCH_ARMV8 && __ARM_NEON */
+
+    while (count--)
+    {
+        *dst++ = color;
+    }
+}
+
 static void virtio_gpu_set_pixel(const char *pixel, int x, int y)
 {
     rt_uint8_t *fb;
@@ -691,6 +959,8 @@ static void virtio_gpu_set_pixel(const char *pixel, int x, int y)
     fb = (rt_uint8_t *)virtio_gpu_dev->framebuffer;
     fb += (y * virtio_gpu_dev->pmode.r.width + x) * VIRTIO_GPU_FORMAT_PIXEL;
     *((rt_uint32_t *)fb) = *((rt_uint32_t *)pixel);
+
+    virtio_gpu_damage_add(virtio_gpu_dev, x, y, x + 1, y + 1);
 }
 
 static void virtio_gpu_get_pixel(char *pixel, int x, int y)
@@ -709,7 +979,6 @@ static void virtio_gpu_get_pixel(char *pixel, int x, int y)
 
 static void virtio_gpu_draw_hline(const char *pixel, int x1, int x2, int y)
 {
-    int i;
     rt_uint8_t *fb;
     rt_uint32_t color = *((rt_uint32_t *)pixel);
     struct virtio_gpu_device *virtio_gpu_dev = _primary_virtio_gpu_dev;
@@ -730,12 +999,9 @@ static void virtio_gpu_draw_hline(const char *pixel, int x1, int x2, int y)
     fb = (rt_uint8_t *)virtio_gpu_dev->framebuffer;
     fb += (y * virtio_gpu_dev->pmode.r.width + x1) * VIRTIO_GPU_FORMAT_PIXEL;
 
-    for (i = x1; i < x2; ++i)
-    {
-        *((rt_uint32_t *)fb) = color;
+    _fill32((rt_uint32_t *)fb, color, x2 - x1);
 
-        fb += VIRTIO_GPU_FORMAT_PIXEL;
-    }
+    virtio_gpu_damage_add(virtio_gpu_dev, x1, y, x2, y + 1);
 }
 
 static void virtio_gpu_draw_vline(const char *pixel, int x, int y1, int y2)
@@ -770,13 +1036,13 @@ static void virtio_gpu_draw_vline(const char *pixel, int x, int y1, int y2)
 
         fb += pitch;
     }
+
+    virtio_gpu_damage_add(virtio_gpu_dev, x, y1, x + 1, y2);
 }
 
 static void virtio_gpu_blit_line(const char *pixel, int x, int y, rt_size_t size)
 {
-    int i;
     rt_uint8_t *fb;
-    rt_uint32_t *colors = (rt_uint32_t *)pixel;
     struct virtio_gpu_device *virtio_gpu_dev = _primary_virtio_gpu_dev;
 
     if (virtio_gpu_dev == RT_NULL || virtio_gpu_dev->pmode_id == VIRTIO_GPU_INVALID_PMODE_ID || x < 0 || y < 0)
@@ -787,11 +1053,9 @@ static void virtio_gpu_blit_line(const char *pixel, int x, int y, rt_size_t size
     fb = (rt_uint8_t *)virtio_gpu_dev->framebuffer;
     fb += (y * virtio_gpu_dev->pmode.r.width + x) * VIRTIO_GPU_FORMAT_PIXEL;
 
-    for (i = 0; i < size; ++i)
-    {
-        *((rt_uint32_t *)fb) = *colors++;
-        fb += VIRTIO_GPU_FORMAT_PIXEL;
-    }
+    rt_memcpy(fb, pixel, size * VIRTIO_GPU_FORMAT_PIXEL);
+
+    virtio_gpu_damage_add(virtio_gpu_dev, x, y, x + size, y + 1);
 }
 
 static struct rt_device_graphic_ops virtio_gpu_graphic_ops =
@@ -823,7 +1087,14 @@ static void virtio_gpu_isr(int irqno, void *param)
         rt_hw_dsb();
         id = queue_ctrl->used->ring[queue_ctrl->used_idx % queue_ctrl->num].id;
 
-        virtio_gpu_dev->info[id].ctrl_valid = RT_FALSE;
+        if (virtio_gpu_dev->info[id].ctrl_async)
+        {
+            virtio_gpu_ctrl_async_done(virtio_gpu_dev, id);
+        }
+        else
+        {
+            virtio_gpu_dev->info[id].ctrl_valid = RT_FALSE;
+        }
 
         queue_ctrl->used_idx++;
     }
@@ -859,6 +1130,7 @@ rt_err_t rt_virtio_gpu_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 
     virtio_dev = &virtio_gpu_dev->virtio_dev;
     virtio_dev->irq = irq;
+    virtio_dev->trans = RT_NULL;
     virtio_dev->mmio_base = mmio_base;
 
     virtio_gpu_dev->pmode_id = VIRTIO_GPU_INVALID_PMODE_ID;
@@ -868,10 +1140,16 @@ rt_err_t rt_virtio_gpu_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     virtio_gpu_dev->framebuffer = RT_NULL;
     virtio_gpu_dev->smem_len = 0;
     virtio_gpu_dev->cursor_enable = RT_FALSE;
+    virtio_gpu_dev->damage_nr = 0;
+    virtio_gpu_dev->fence_id = 0;
+    virtio_gpu_dev->fence_done = 0;
+    virtio_gpu_dev->async_status = RT_EOK;
+    rt_memset(virtio_gpu_dev->info, 0, sizeof(virtio_gpu_dev->info));
 
 #ifdef RT_USING_SMP
     rt_spin_lock_init(&virtio_dev->spinlock);
 #endif
+    rt_spin_lock_init(&virtio_gpu_dev->damage_lock);
 
     virtio_reset_device(virtio_dev);
     virtio_status_acknowledge_driver(virtio_dev);
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2023-10-18     RT-Thread    add damage tracking and asynchronous flush
  */
 
 #ifndef __VIRTIO_GPU_H__
@@ -33,6 +34,7 @@
 #define VIRTIO_GPU_CURSOR_HEIGHT    64
 #define VIRTIO_GPU_CURSOR_IMG_SIZE  (VIRTIO_GPU_CURSOR_WIDTH * VIRTIO_GPU_CURSOR_HEIGHT * VIRTIO_GPU_FORMAT_PIXEL)
 #define VIRTIO_GPU_INVALID_PMODE_ID RT_UINT32_MAX
+#define VIRTIO_GPU_DAMAGE_RECTS     8
 
 /* GPU control */
 
@@ -360,6 +362,13 @@ struct virtio_gpu_update_cursor
     rt_uint32_t padding;
 };
 
+/* The region [x1, x2) * [y1, y2) of the framebuffer */
+struct virtio_gpu_damage_rect
+{
+    rt_uint32_t x1, y1;
+    rt_uint32_t x2, y2;
+};
+
 struct virtio_gpu_device
 {
     struct rt_device parent;
@@ -380,6 +389,16 @@ struct virtio_gpu_device
     void *framebuffer;
     rt_uint32_t smem_len;
 
+    /* Damaged regions of the framebuffer, which are not transferred to the host */
+    struct rt_spinlock damage_lock;
+    rt_uint32_t damage_nr;
+    struct virtio_gpu_damage_rect damage[VIRTIO_GPU_DAMAGE_RECTS];
+
+    /* Asynchronous commands, the last flush of the damage is fenced */
+    rt_uint64_t fence_id;
+    volatile rt_uint64_t fence_done;
+    rt_err_t async_status;
+
     /* Cursor image info */
     rt_bool_t cursor_enable;
     struct rt_mutex ops_mutex;
@@ -391,8 +410,18 @@ struct virtio_gpu_device
     struct
     {
         rt_bool_t ctrl_valid;
+        rt_bool_t ctrl_async;
         rt_bool_t cursor_valid;
 
+        /* The asynchronous commands are not copied to the shared gpu_request */
+        rt_uint64_t ctrl_fence_id;
+        union
+        {
+            struct virtio_gpu_transfer_to_host_2d transfer;
+            struct virtio_gpu_resource_flush flush;
+        } ctrl_cmd;
+        struct virtio_gpu_ctrl_hdr ctrl_res;
+
         struct virtio_gpu_update_cursor cursor_cmd;
     } info[VIRTIO_GPU_QUEUE_SIZE];
 };
@@ -407,6 +436,8 @@ enum
     VIRTIO_DEVICE_CTRL_CURSOR_SETUP,
     VIRTIO_DEVICE_CTRL_CURSOR_SET_IMG,
     VIRTIO_DEVICE_CTRL_CURSOR_MOVE,
+
+    VIRTIO_DEVICE_CTRL_GPU_FLUSH,
 };
 
 #endif /* __VIRTIO_GPU_H__ */
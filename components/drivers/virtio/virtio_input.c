@@ -356,6 +356,7 @@ rt_err_t rt_virtio_input_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 
     virtio_dev = &virtio_input_dev->virtio_dev;
     virtio_dev->irq = irq;
+    virtio_dev->trans = RT_NULL;
     virtio_dev->mmio_base = mmio_base;
 
     virtio_input_dev->config = (struct virtio_input_config *)virtio_dev->mmio_config->config;
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2023-10-18     RT-Thread    probe on any virtio transport
  */
 
 #include <rthw.h>
@@ -233,25 +234,31 @@ static void virtio_net_isr(int irqno, void *param)
 #endif
 }
 
-rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
+/**
+ * @brief Probe a virtio network device on a transport.
+ *
+ * @param transport is the template of the virtio device, it is copied to the
+ *        network device.
+ *
+ * @return RT_EOK on success, or the error code.
+ */
+rt_err_t rt_virtio_net_probe(struct virtio_device *transport)
 {
+    rt_err_t err;
     static int dev_no = 0;
     char dev_name[RT_NAME_MAX];
     struct virtio_device *virtio_dev;
     struct virtio_net_device *virtio_net_dev;
 
-    virtio_net_dev = rt_malloc(sizeof(struct virtio_net_device));
+    virtio_net_dev = rt_calloc(1, sizeof(struct virtio_net_device));
 
     if (virtio_net_dev == RT_NULL)
     {
-        goto _alloc_fail;
+        return -RT_ENOMEM;
     }
 
     virtio_dev = &virtio_net_dev->virtio_dev;
-    virtio_dev->irq = irq;
-    virtio_dev->mmio_base = mmio_base;
-
-    virtio_net_dev->config = (struct virtio_net_config *)virtio_dev->mmio_config->config;
+    *virtio_dev = *transport;
 
 #ifdef RT_USING_SMP
     rt_spin_lock_init(&virtio_dev->spinlock);
@@ -260,11 +267,17 @@ rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     virtio_reset_device(virtio_dev);
     virtio_status_acknowledge_driver(virtio_dev);
 
-    virtio_dev->mmio_config->driver_features = virtio_dev->mmio_config->device_features & ~(
+    err = virtio_negotiate_features(virtio_dev,
             (1 << VIRTIO_NET_F_CTRL_VQ) |
             (1 << VIRTIO_F_RING_EVENT_IDX));
 
-    virtio_status_driver_ok(virtio_dev);
+    if (err != RT_EOK)
+    {
+        rt_free(virtio_net_dev);
+        return err;
+    }
+
+    virtio_net_dev->config = (struct virtio_net_config *)virtio_device_config(virtio_dev);
 
     if (virtio_queues_alloc(virtio_dev, 2) != RT_EOK)
     {
@@ -298,8 +311,10 @@ rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 
     rt_snprintf(dev_name, RT_NAME_MAX, "virtio-net%d", dev_no++);
 
-    rt_hw_interrupt_install(irq, virtio_net_isr, virtio_net_dev, dev_name);
-    rt_hw_interrupt_umask(irq);
+    /* only the rx queue interrupts, the tx queue is set no interrupt */
+    virtio_queue_irq_install(virtio_dev, VIRTIO_NET_QUEUE_RX, virtio_net_isr, virtio_net_dev, dev_name);
+
+    virtio_status_driver_ok(virtio_dev);
 
     return eth_device_init(&virtio_net_dev->parent, dev_name);
 
@@ -312,4 +327,14 @@ _alloc_fail:
     }
     return -RT_ENOMEM;
 }
+
+rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
+{
+    struct virtio_device transport = { 0 };
+
+    transport.irq = irq;
+    transport.mmio_base = mmio_base;
+
+    return rt_virtio_net_probe(&transport);
+}
 #endif /* RT_USING_VIRTIO_NET */
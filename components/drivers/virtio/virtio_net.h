@@ -113,6 +113,7 @@ struct virtio_net_device
 };
 
 rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq);
+rt_err_t rt_virtio_net_probe(struct virtio_device *transport);
 
 #endif /* RT_USING_VIRTIO_NET */
 
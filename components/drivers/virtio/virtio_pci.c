@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <cpuport.h>
+
+#define DBG_TAG "virtio.pci"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#include <virtio.h>
+#include <virtio_pci.h>
+
+#ifdef RT_USING_VIRTIO_BLK
+#include <virtio_blk.h>
+#endif
+#ifdef RT_USING_VIRTIO_NET
+#include <virtio_net.h>
+#endif
+
+#define raw_to_virtio_pci(dev) ((struct virtio_pci_device *)(dev)->trans_priv)
+
+static virtio_device_probe_handler virtio_pci_probe_handlers[] =
+{
+#ifdef RT_USING_VIRTIO_BLK
+    [VIRTIO_DEVICE_ID_BLOCK] = rt_virtio_blk_probe,
+#endif
+#ifdef RT_USING_VIRTIO_NET
+    [VIRTIO_DEVICE_ID_NET] = rt_virtio_net_probe,
+#endif
+};
+
+static rt_uint8_t virtio_pci_get_status(struct virtio_device *dev)
+{
+    return raw_to_virtio_pci(dev)->common->device_status;
+}
+
+static void virtio_pci_set_status(struct virtio_device *dev, rt_uint8_t status)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    vp_dev->common->device_status = status;
+
+    if (status == 0)
+    {
+        /* The device acknowledges the reset when it reads back 0 */
+        while (vp_dev->common->device_status)
+        {
+            rt_hw_cpu_relax();
+        }
+    }
+}
+
+static rt_uint64_t virtio_pci_get_features(struct virtio_device *dev)
+{
+    rt_uint64_t features;
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    vp_dev->common->device_feature_select = 0;
+    features = vp_dev->common->device_feature;
+    vp_dev->common->device_feature_select = 1;
+    features |= (rt_uint64_t)vp_dev->common->device_feature << 32;
+
+    return features;
+}
+
+static void virtio_pci_set_features(struct virtio_device *dev, rt_uint64_t features)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    vp_dev->common->driver_feature_select = 0;
+    vp_dev->common->driver_feature = (rt_uint32_t)features;
+    vp_dev->common->driver_feature_select = 1;
+    vp_dev->common->driver_feature = (rt_uint32_t)(features >> 32);
+}
+
+static void *virtio_pci_get_config(struct virtio_device *dev)
+{
+    return raw_to_virtio_pci(dev)->device;
+}
+
+static rt_size_t virtio_pci_queue_max(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    if (queue_index >= vp_dev->queues_num)
+    {
+        return 0;
+    }
+
+    vp_dev->common->queue_select = queue_index;
+
+    return vp_dev->common->queue_size;
+}
+
+/* queue 0 ~ n are spread on the vectors 1 ~ n, vector 0 is for the config changes */
+static rt_uint16_t virtio_pci_queue_vector(struct virtio_pci_device *vp_dev, rt_uint32_t queue_index)
+{
+    if (vp_dev->msix_vectors == 0)
+    {
+        return VIRTIO_MSI_NO_VECTOR;
+    }
+
+    if (vp_dev->msix_vectors == 1)
+    {
+        return VIRTIO_MSI_CONFIG_VECTOR;
+    }
+
+    return 1 + queue_index % (vp_dev->msix_vectors - 1);
+}
+
+static rt_err_t virtio_pci_queue_setup(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    rt_uint16_t vector;
+    rt_uint64_t desc, driver, device;
+    struct virtq *queue = &dev->queues[queue_index];
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+    volatile struct virtio_pci_common_cfg *common = vp_dev->common;
+
+    if (queue_index >= vp_dev->queues_num)
+    {
+        return -RT_EINVAL;
+    }
+
+    desc = VIRTIO_VA2PA(queue->desc);
+    driver = VIRTIO_VA2PA(queue->avail);
+    device = VIRTIO_VA2PA(queue->used);
+
+    common->queue_select = queue_index;
+    common->queue_size = queue->num;
+    common->queue_desc_lo = (rt_uint32_t)desc;
+    common->queue_desc_hi = (rt_uint32_t)(desc >> 32);
+    common->queue_driver_lo = (rt_uint32_t)driver;
+    common->queue_driver_hi = (rt_uint32_t)(driver >> 32);
+    common->queue_device_lo = (rt_uint32_t)device;
+    common->queue_device_hi = (rt_uint32_t)(device >> 32);
+
+    vector = virtio_pci_queue_vector(vp_dev, queue_index);
+    common->queue_msix_vector = vector;
+
+    /* The device could fail to allocate the resource for the vector */
+    if (common->queue_msix_vector != vector)
+    {
+        LOG_E("%s: queue %d vector %d is rejected",
+                rt_dm_dev_get_name(&vp_dev->pdev->parent), queue_index, vector);
+
+        return -RT_EBUSY;
+    }
+
+    vp_dev->notify[queue_index] = vp_dev->notify_base +
+            common->queue_notify_off * vp_dev->notify_off_multiplier;
+
+    if ((rt_ubase_t)vp_dev->notify[queue_index] + sizeof(rt_uint16_t) >
+        (rt_ubase_t)vp_dev->notify_base + vp_dev->notify_len)
+    {
+        return -RT_EINVAL;
+    }
+
+    common->queue_enable = 1;
+
+    return RT_EOK;
+}
+
+static void virtio_pci_queue_release(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    /* The queue can't be disabled, it is stopped by the reset of the device */
+    vp_dev->common->queue_select = queue_index;
+    vp_dev->common->queue_msix_vector = VIRTIO_MSI_NO_VECTOR;
+    vp_dev->notify[queue_index] = RT_NULL;
+}
+
+static void virtio_pci_queue_notify(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    rt_hw_dsb();
+    HWREG16(vp_dev->notify[queue_index]) = queue_index;
+}
+
+static rt_uint32_t virtio_pci_interrupt_ack(struct virtio_device *dev)
+{
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    /* The ISR status is not used by the MSI-X, reading it acks the INTx */
+    if (vp_dev->msix_vectors)
+    {
+        return VIRTIO_PCI_ISR_QUEUE;
+    }
+
+    return *vp_dev->isr;
+}
+
+static rt_err_t virtio_pci_irq_install(struct virtio_device *dev, rt_uint32_t queue_index,
+        rt_isr_handler_t handler, void *param, const char *name)
+{
+    int irq;
+    rt_err_t err;
+    struct virtio_pci_device *vp_dev = raw_to_virtio_pci(dev);
+
+    if (vp_dev->msix_vectors)
+    {
+        irq = vp_dev->msix_entries[virtio_pci_queue_vector(vp_dev, queue_index)].irq;
+    }
+    else
+    {
+        /* All the queues share the INTx, the handler of the first queue is installed */
+        if (vp_dev->intx_installed)
+        {
+            return RT_EOK;
+        }
+        irq = vp_dev->pdev->irq;
+    }
+
+    err = rt_pic_attach_irq(irq, handler, param, name, RT_IRQ_F_NONE);
+
+    if (err)
+    {
+        return err;
+    }
+
+#ifdef RT_USING_SMP
+    if (vp_dev->msix_vectors)
+    {
+        RT_DECLARE_IRQ_AFFINITY(affinity) = { 0 };
+
+        /* Spread the queues on the cpus, so they complete in parallel */
+        RT_IRQ_AFFINITY_SET(affinity, queue_index % RT_CPUS_NR);
+        rt_pic_irq_set_affinity(irq, affinity);
+    }
+#endif /* RT_USING_SMP */
+
+    rt_pic_irq_enable(irq);
+
+    if (!vp_dev->msix_vectors)
+    {
+        vp_dev->intx_installed = RT_TRUE;
+    }
+
+    return RT_EOK;
+}
+
+static const struct virtio_transport_ops virtio_pci_trans_ops =
+{
+    .get_status = virtio_pci_get_status,
+    .set_status = virtio_pci_set_status,
+    .get_features = virtio_pci_get_features,
+    .set_features = virtio_pci_set_features,
+    .get_config = virtio_pci_get_config,
+    .queue_max = virtio_pci_queue_max,
+    .queue_setup = virtio_pci_queue_setup,
+    .queue_release = virtio_pci_queue_release,
+    .queue_notify = virtio_pci_queue_notify,
+    .interrupt_ack = virtio_pci_interrupt_ack,
+    .irq_install = virtio_pci_irq_install,
+};
+
+static void *virtio_pci_map_cap(struct virtio_pci_device *vp_dev, rt_uint8_t pos,
+        rt_uint32_t min_len, rt_uint32_t *out_len)
+{
+    rt_uint8_t bar;
+    rt_uint32_t offset, length;
+    struct rt_pci_device *pdev = vp_dev->pdev;
+
+    rt_pci_read_config_u8(pdev, pos + VIRTIO_PCI_CAP_BAR, &bar);
+    rt_pci_read_config_u32(pdev, pos + VIRTIO_PCI_CAP_OFFSET, &offset);
+    rt_pci_read_config_u32(pdev, pos + VIRTIO_PCI_CAP_LENGTH, &length);
+
+    if (bar >= VIRTIO_PCI_BAR_NR || length < min_len ||
+        offset + length > pdev->resource[bar].size)
+    {
+        return RT_NULL;
+    }
+
+    /* Map each BAR only once, the structures may share a BAR */
+    if (!vp_dev->bars[bar])
+    {
+        vp_dev->bars[bar] = rt_pci_iomap(pdev, bar);
+
+        if (!vp_dev->bars[bar])
+        {
+            return RT_NULL;
+        }
+    }
+
+    if (out_len)
+    {
+        *out_len = length;
+    }
+
+    return vp_dev->bars[bar] + offset;
+}
+
+static rt_err_t virtio_pci_parse_caps(struct virtio_pci_device *vp_dev)
+{
+    rt_uint8_t pos, type;
+    struct rt_pci_device *pdev = vp_dev->pdev;
+
+    for (pos = rt_pci_find_capability(pdev, PCIY_VENDOR); pos;
+         pos = rt_pci_find_next_capability(pdev, pos, PCIY_VENDOR))
+    {
+        rt_pci_read_config_u8(pdev, pos + VIRTIO_PCI_CAP_CFG_TYPE, &type);
+
+        /* The first capability of each type is preferred */
+        switch (type)
+        {
+        case VIRTIO_PCI_CAP_COMMON_CFG:
+            if (!vp_dev->common)
+            {
+                vp_dev->common = virtio_pci_map_cap(vp_dev, pos,
+                        sizeof(struct virtio_pci_common_cfg), RT_NULL);
+            }
+            break;
+        case VIRTIO_PCI_CAP_NOTIFY_CFG:
+            if (!vp_dev->notify_base)
+            {
+                rt_pci_read_config_u32(pdev, pos + VIRTIO_PCI_NOTIFY_CAP_MULT,
+                        &vp_dev->notify_off_multiplier);
+                vp_dev->notify_base = virtio_pci_map_cap(vp_dev, pos,
+                        sizeof(rt_uint16_t), &vp_dev->notify_len);
+            }
+            break;
+        case VIRTIO_PCI_CAP_ISR_CFG:
+            if (!vp_dev->isr)
+            {
+                vp_dev->isr = virtio_pci_map_cap(vp_dev, pos, sizeof(rt_uint8_t), RT_NULL);
+            }
+            break;
+        case VIRTIO_PCI_CAP_DEVICE_CFG:
+            if (!vp_dev->device)
+            {
+                vp_dev->device = virtio_pci_map_cap(vp_dev, pos, 0, RT_NULL);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* The device config is optional */
+    if (!vp_dev->common || !vp_dev->notify_base || !vp_dev->isr)
+    {
+        return -RT_ENOSYS;
+    }
+
+    return RT_EOK;
+}
+
+static void virtio_pci_setup_vectors(struct virtio_pci_device *vp_dev)
+{
+#ifdef RT_PCI_MSI
+    rt_ssize_t count, nvec;
+    struct rt_pci_device *pdev = vp_dev->pdev;
+
+    count = rt_pci_msix_vector_count(pdev);
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    /* One for the config changes and one for each queue if possible */
+    nvec = rt_min_t(rt_ssize_t, vp_dev->queues_num + 1, count);
+
+    vp_dev->msix_entries = rt_calloc(nvec, sizeof(*vp_dev->msix_entries));
+
+    if (!vp_dev->msix_entries)
+    {
+        return;
+    }
+
+    rt_pci_msix_entry_index_linear(vp_dev->msix_entries, nvec);
+
+    if (rt_pci_msix_enable_range_affinity(pdev, vp_dev->msix_entries, 1, nvec, RT_NULL) != nvec)
+    {
+        LOG_W("%s: MSI-X is unavailable, fall back to INTx", rt_dm_dev_get_name(&pdev->parent));
+
+        rt_free(vp_dev->msix_entries);
+        vp_dev->msix_entries = RT_NULL;
+
+        return;
+    }
+
+    vp_dev->msix_vectors = nvec;
+    vp_dev->common->msix_config = VIRTIO_MSI_CONFIG_VECTOR;
+#endif /* RT_PCI_MSI */
+}
+
+static void virtio_pci_release(struct virtio_pci_device *vp_dev)
+{
+    int i;
+
+#ifdef RT_PCI_MSI
+    if (vp_dev->msix_vectors)
+    {
+        rt_pci_msix_disable(vp_dev->pdev);
+    }
+#endif
+
+    for (i = 0; i < VIRTIO_PCI_BAR_NR; ++i)
+    {
+        if (vp_dev->bars[i])
+        {
+            rt_iounmap(vp_dev->bars[i]);
+        }
+    }
+
+    if (vp_dev->msix_entries)
+    {
+        rt_free(vp_dev->msix_entries);
+    }
+
+    if (vp_dev->notify)
+    {
+        rt_free(vp_dev->notify);
+    }
+
+    rt_free(vp_dev);
+}
+
+static rt_err_t virtio_pci_probe(struct rt_pci_device *pdev)
+{
+    rt_err_t err;
+    struct virtio_device transport = { 0 };
+    struct virtio_pci_device *vp_dev;
+
+    vp_dev = rt_calloc(1, sizeof(*vp_dev));
+
+    if (!vp_dev)
+    {
+        return -RT_ENOMEM;
+    }
+
+    vp_dev->pdev = pdev;
+
+    if (pdev->device >= VIRTIO_PCI_DEVICE_ID_MODERN_BASE &&
+        pdev->device <= VIRTIO_PCI_DEVICE_ID_MODERN_END)
+    {
+        vp_dev->device_id = pdev->device - VIRTIO_PCI_DEVICE_ID_MODERN_BASE;
+    }
+    else if (pdev->device >= VIRTIO_PCI_DEVICE_ID_LEGACY_BASE &&
+             pdev->device <= VIRTIO_PCI_DEVICE_ID_LEGACY_END)
+    {
+        vp_dev->device_id = pdev->subsystem_device;
+    }
+    else
+    {
+        err = -RT_ENOSYS;
+        goto _fail;
+    }
+
+    if (vp_dev->device_id >= RT_ARRAY_SIZE(virtio_pci_probe_handlers) ||
+        !virtio_pci_probe_handlers[vp_dev->device_id])
+    {
+        LOG_D("%s: device %d is not supported", rt_dm_dev_get_name(&pdev->parent), vp_dev->device_id);
+
+        err = -RT_ENOSYS;
+        goto _fail;
+    }
+
+    /* The legacy only devices have no capabilities of the modern interface */
+    if ((err = virtio_pci_parse_caps(vp_dev)))
+    {
+        LOG_W("%s: modern interface is not found", rt_dm_dev_get_name(&pdev->parent));
+
+        goto _fail;
+    }
+
+    vp_dev->queues_num = vp_dev->common->num_queues;
+    vp_dev->notify = rt_calloc(vp_dev->queues_num, sizeof(*vp_dev->notify));
+
+    if (!vp_dev->notify)
+    {
+        err = -RT_ENOMEM;
+        goto _fail;
+    }
+
+    rt_pci_set_master(pdev);
+
+    virtio_pci_setup_vectors(vp_dev);
+
+    transport.irq = pdev->irq;
+    transport.trans = &virtio_pci_trans_ops;
+    transport.trans_priv = vp_dev;
+
+    if (!(virtio_pci_get_features(&transport) & (1ULL << VIRTIO_F_VERSION_1)))
+    {
+        err = -RT_ENOSYS;
+        goto _fail;
+    }
+
+    pdev->parent.user_data = vp_dev;
+
+    if ((err = virtio_pci_probe_handlers[vp_dev->device_id](&transport)))
+    {
+        virtio_pci_set_status(&transport, 0);
+        pdev->parent.user_data = RT_NULL;
+
+        goto _fail;
+    }
+
+    LOG_D("%s: device %d, %d queues, %d vectors", rt_dm_dev_get_name(&pdev->parent),
+            vp_dev->device_id, vp_dev->queues_num, vp_dev->msix_vectors);
+
+    return RT_EOK;
+
+_fail:
+    virtio_pci_release(vp_dev);
+
+    return err;
+}
+
+static const struct rt_pci_device_id virtio_pci_ids[] =
+{
+    { RT_PCI_DEVICE_ID(PCI_VENDOR_ID_REDHAT_QUMRANET, PCI_ANY_ID), },
+    { /* sentinel */ }
+};
+
+static struct rt_pci_driver virtio_pci_driver =
+{
+    .name = "virtio-pci",
+
+    .ids = virtio_pci_ids,
+    .probe = virtio_pci_probe,
+};
+RT_PCI_DRIVER_EXPORT(virtio_pci_driver);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __VIRTIO_PCI_H__
+#define __VIRTIO_PCI_H__
+
+#include <rtdef.h>
+
+#define VIRTIO_PCI_DEVICE_ID_LEGACY_BASE    0x1000  /* transitional devices, 0x1000 ~ 0x103f */
+#define VIRTIO_PCI_DEVICE_ID_LEGACY_END     0x103f
+#define VIRTIO_PCI_DEVICE_ID_MODERN_BASE    0x1040  /* modern devices, 0x1040 + device id */
+#define VIRTIO_PCI_DEVICE_ID_MODERN_END     0x107f
+
+/* the vendor specific capability of the virtio structures */
+#define VIRTIO_PCI_CAP_CFG_TYPE             3       /* rt_uint8_t */
+#define VIRTIO_PCI_CAP_BAR                  4       /* rt_uint8_t */
+#define VIRTIO_PCI_CAP_OFFSET               8       /* rt_uint32_t */
+#define VIRTIO_PCI_CAP_LENGTH               12      /* rt_uint32_t */
+#define VIRTIO_PCI_NOTIFY_CAP_MULT          16      /* rt_uint32_t, only in the notify capability */
+
+#define VIRTIO_PCI_CAP_COMMON_CFG           1
+#define VIRTIO_PCI_CAP_NOTIFY_CFG           2
+#define VIRTIO_PCI_CAP_ISR_CFG              3
+#define VIRTIO_PCI_CAP_DEVICE_CFG           4
+#define VIRTIO_PCI_CAP_PCI_CFG              5
+
+#define VIRTIO_PCI_ISR_QUEUE                0x1
+#define VIRTIO_PCI_ISR_CONFIG               0x2
+
+#define VIRTIO_MSI_NO_VECTOR                0xffff
+#define VIRTIO_MSI_CONFIG_VECTOR            0
+
+#define VIRTIO_PCI_BAR_NR                   6
+
+struct virtio_pci_common_cfg
+{
+    /* About the whole device */
+    rt_uint32_t device_feature_select;      /* read-write */
+    rt_uint32_t device_feature;             /* read-only for driver */
+    rt_uint32_t driver_feature_select;      /* read-write */
+    rt_uint32_t driver_feature;             /* read-write */
+    rt_uint16_t msix_config;                /* read-write */
+    rt_uint16_t num_queues;                 /* read-only for driver */
+    rt_uint8_t device_status;               /* read-write */
+    rt_uint8_t config_generation;           /* read-only for driver */
+
+    /* About a specific virtqueue */
+    rt_uint16_t queue_select;               /* read-write */
+    rt_uint16_t queue_size;                 /* read-write, power of 2, or 0 */
+    rt_uint16_t queue_msix_vector;          /* read-write */
+    rt_uint16_t queue_enable;               /* read-write */
+    rt_uint16_t queue_notify_off;           /* read-only for driver */
+    rt_uint32_t queue_desc_lo;              /* read-write */
+    rt_uint32_t queue_desc_hi;              /* read-write */
+    rt_uint32_t queue_driver_lo;            /* read-write */
+    rt_uint32_t queue_driver_hi;            /* read-write */
+    rt_uint32_t queue_device_lo;            /* read-write */
+    rt_uint32_t queue_device_hi;            /* read-write */
+} __attribute__((packed));
+
+struct virtio_pci_device
+{
+    struct rt_pci_device *pdev;
+
+    void *bars[VIRTIO_PCI_BAR_NR];
+
+    volatile struct virtio_pci_common_cfg *common;
+    volatile rt_uint8_t *isr;
+    void *device;
+    void *notify_base;
+    rt_uint32_t notify_off_multiplier;
+    rt_uint32_t notify_len;
+
+    rt_uint32_t device_id;
+    rt_uint16_t queues_num;
+    /* the notify address of each queue */
+    void **notify;
+
+    /* 0 if the device uses the INTx */
+    int msix_vectors;
+    struct rt_pci_msix_entry *msix_entries;
+    rt_bool_t intx_installed;
+};
+
+#endif /* __VIRTIO_PCI_H__ */
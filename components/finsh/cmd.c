@@ -30,6 +30,7 @@
  *                             Provide protection for the "first layer of objects" when list_*
  * 2020-04-07     chenhui      add clear
  * 2022-07-02     Stanley Lwin add list command
+ * 2023-10-18     RT-Thread    show the contention statistics in list_mutex
  */
 
 #include <rthw.h>
@@ -166,9 +167,9 @@ long list_thread(void)
     maxlen = RT_NAME_MAX;
 
 #ifdef RT_USING_SMP
-    rt_kprintf("%-*.*s cpu bind pri  status      sp     stack size max used left tick  error\n", maxlen, maxlen, item_title);
+    rt_kprintf("%-*.*s cpu affinity  pri  status      sp     stack size max used left tick  error\n", maxlen, maxlen, item_title);
     object_split(maxlen);
-    rt_kprintf(" --- ---- ---  ------- ---------- ----------  ------  ---------- ---\n");
+    rt_kprintf(" --- -------- ----  ------- ---------- ----------  ------  ---------- ---\n");
 #else
     rt_kprintf("%-*.*s pri  status      sp     stack size max used left tick  error\n", maxlen, maxlen, item_title);
     object_split(maxlen);
@@ -204,9 +205,9 @@ long list_thread(void)
 
 #ifdef RT_USING_SMP
                     if (thread->oncpu != RT_CPU_DETACHED)
-                        rt_kprintf("%-*.*s %3d %3d %4d ", maxlen, RT_NAME_MAX, thread->parent.name, thread->oncpu, thread->bind_cpu, thread->current_priority);
+                        rt_kprintf("%-*.*s %3d %8lx %4d ", maxlen, RT_NAME_MAX, thread->parent.name, thread->oncpu, (rt_ubase_t)thread->cpu_affinity, thread->current_priority);
                     else
-                        rt_kprintf("%-*.*s N/A %3d %4d ", maxlen, RT_NAME_MAX, thread->parent.name, thread->bind_cpu, thread->current_priority);
+                        rt_kprintf("%-*.*s N/A %8lx %4d ", maxlen, RT_NAME_MAX, thread->parent.name, (rt_ubase_t)thread->cpu_affinity, thread->current_priority);
 
 #else
                     rt_kprintf("%-*.*s %3d ", maxlen, RT_NAME_MAX, thread->parent.name, thread->current_priority);
@@ -408,9 +409,15 @@ long list_mutex(void)
 
     maxlen = RT_NAME_MAX;
 
+#ifdef RT_USING_MUTEX_STAT
+    rt_kprintf("%-*.*s   owner  hold priority  contend     spun    slept suspend thread \n", maxlen, maxlen, item_title);
+    object_split(maxlen);
+    rt_kprintf(" -------- ---- -------- -------- -------- -------- --------------\n");
+#else
     rt_kprintf("%-*.*s   owner  hold priority suspend thread \n", maxlen, maxlen, item_title);
     object_split(maxlen);
     rt_kprintf(" -------- ---- -------- --------------\n");
+#endif /* RT_USING_MUTEX_STAT */
 
     do
     {
@@ -433,6 +440,21 @@ long list_mutex(void)
                 rt_hw_interrupt_enable(level);
 
                 m = (struct rt_mutex *)obj;
+#ifdef RT_USING_MUTEX_STAT
+                rt_kprintf("%-*.*s %-8.*s %04d %8d %8d %8d %8d  %04d ",
+                       maxlen, RT_NAME_MAX,
+                       m->parent.parent.name,
+                       RT_NAME_MAX,
+                       m->owner ? m->owner->parent.name : "(NULL)",
+                       m->hold,
+                       m->priority,
+                       m->contended,
+                       m->spun,
+                       m->slept,
+                       rt_list_len(&m->parent.suspend_thread));
+                show_wait_queue(&(m->parent.suspend_thread));
+                rt_kprintf("\n");
+#else
                 if (!rt_list_isempty(&m->parent.suspend_thread))
                 {
                     rt_kprintf("%-*.*s %-8.*s %04d %8d  %04d ",
@@ -457,6 +479,7 @@ long list_mutex(void)
                            m->priority,
                            rt_list_len(&m->parent.suspend_thread));
                 }
+#endif /* RT_USING_MUTEX_STAT */
             }
         }
     }
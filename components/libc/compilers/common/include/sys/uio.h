@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __SYS_UIO_H__
+#define __SYS_UIO_H__
+
+#include <rtconfig.h>
+
+#ifdef RT_USING_MUSLLIBC
+#include_next <sys/uio.h>
+#else
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct iovec
+{
+    void   *iov_base;
+    size_t  iov_len;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RT_USING_MUSLLIBC */
+
+#endif /* __SYS_UIO_H__ */
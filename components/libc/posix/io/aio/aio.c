@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2017/12/30     Bernard      The first version.
+ * 2023-10-18     RT-Thread    run the requests in the worker pools
+ * 2023-10-18     RT-Thread    add lio_listio() and aio_suspend()
  */
 
 #include <rtthread.h>
@@ -18,6 +20,106 @@
 
 struct rt_workqueue* aio_queue = NULL;
 
+/* the longest timeout of aio_suspend(), in ticks */
+#define AIO_TICKS_MAX   (RT_TICK_MAX / 2 - 1)
+
+/* aio_state of a request, a request in a list of lio_listio() has no work of its own */
+#define AIO_STATE_WORK      0   /* queued as a work */
+#define AIO_STATE_LISTED    1   /* waiting in a list */
+#define AIO_STATE_RUNNING   2   /* transferred by the work of the list */
+
+/* the seek and the transfer of the requests on the same fd are serialized */
+#define AIO_FD_LOCK_NR  8
+static struct rt_mutex aio_fd_lock[AIO_FD_LOCK_NR];
+
+rt_inline struct rt_mutex *aio_fd_lock_get(int fd)
+{
+    return &aio_fd_lock[(unsigned int)fd % AIO_FD_LOCK_NR];
+}
+
+/* the threads in aio_suspend(), each one is woken up on the completions */
+struct aio_waiter
+{
+    rt_list_t node;
+    struct rt_semaphore sem;
+};
+static rt_list_t aio_waiters = RT_LIST_OBJECT_INIT(aio_waiters);
+
+/* a list of requests submitted by lio_listio(), run by one work */
+struct aio_batch
+{
+    struct rt_work work;
+    int nent;
+    struct aiocb *list[];
+};
+
+/* the request is in progress from now on */
+static void aio_submit(struct aiocb *cb, int state)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    cb->aio_result = -EINPROGRESS;
+    cb->aio_state = state;
+    rt_hw_interrupt_enable(level);
+}
+
+static void aio_complete(struct aiocb *cb, int result)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    cb->aio_result = result;
+    rt_hw_interrupt_enable(level);
+}
+
+/* wake up the waiters once for the requests completed */
+static void aio_complete_notify(void)
+{
+    rt_base_t level;
+    struct aio_waiter *waiter;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each_entry(waiter, &aio_waiters, node)
+    {
+        rt_sem_release(&waiter->sem);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/*
+ * Transfer the data of a request with the fd lock held. The file is at *pos
+ * after the last request of the same fd, or *pos is -1 if it is unknown, so
+ * the sequential requests do not seek.
+ */
+static int aio_transfer(struct aiocb *cb, int is_write, int append, off_t *pos)
+{
+    int len;
+
+    if (!append && *pos != cb->aio_offset)
+    {
+        if (lseek(cb->aio_fildes, cb->aio_offset, SEEK_SET) < 0)
+        {
+            *pos = -1;
+            return errno;
+        }
+    }
+
+    if (is_write)
+        len = write(cb->aio_fildes, (const void *)cb->aio_buf, cb->aio_nbytes);
+    else
+        len = read(cb->aio_fildes, (void *)cb->aio_buf, cb->aio_nbytes);
+
+    if (len < 0)
+    {
+        *pos = -1;
+        return errno;
+    }
+
+    *pos = append ? -1 : cb->aio_offset + len;
+    return len;
+}
+
 /**
  * The aio_cancel() function shall attempt to cancel one or more asynchronous I/O
  * requests currently outstanding against file descriptor fildes. The aiocbp
@@ -42,19 +144,58 @@ struct rt_workqueue* aio_queue = NULL;
  */
 int aio_cancel(int fd, struct aiocb *cb)
 {
-    rt_err_t ret;
+    int ret;
+    rt_base_t level;
 
     if (!cb) return -EINVAL;
     if (cb->aio_fildes != fd) return -EINVAL;
 
-    ret = rt_workqueue_cancel_work_sync(aio_queue, &(cb->aio_work));
-    if (ret == RT_EOK)
+    level = rt_hw_interrupt_disable();
+    if (cb->aio_result != -EINPROGRESS)
     {
-        errno = -ECANCELED;
-        return -1;
+        ret = AIO_ALLDONE;
     }
+    else if (cb->aio_state == AIO_STATE_RUNNING)
+    {
+        /* the work of the list is transferring it */
+        ret = AIO_NOTCANCELED;
+    }
+    else if (cb->aio_state == AIO_STATE_LISTED)
+    {
+        /* the work of the list skips it */
+        cb->aio_result = ECANCELED;
+        ret = AIO_CANCELED;
+    }
+    else
+    {
+        ret = -1;
+    }
+    rt_hw_interrupt_enable(level);
 
-    return 0;
+    if (ret == -1)
+    {
+        /* it is done once a running work is waited for */
+        rt_workqueue_cancel_work_sync(aio_queue, &(cb->aio_work));
+
+        level = rt_hw_interrupt_disable();
+        if (cb->aio_result == -EINPROGRESS)
+        {
+            cb->aio_result = ECANCELED;
+            ret = AIO_CANCELED;
+        }
+        else
+        {
+            ret = AIO_ALLDONE;
+        }
+        rt_hw_interrupt_enable(level);
+    }
+
+    if (ret == AIO_CANCELED)
+    {
+        aio_complete_notify();
+    }
+
+    return ret;
 }
 
 /**
@@ -130,18 +271,16 @@ static void aio_fync_work(struct rt_work* work, void* work_data)
     else
         cb->aio_result = 0;
     rt_hw_interrupt_enable(level);
+    aio_complete_notify();
 
     return ;
 }
 
 int aio_fsync(int op, struct aiocb *cb)
 {
-    rt_base_t level;
     if (!cb) return -EINVAL;
 
-    level = rt_hw_interrupt_disable();
-    cb->aio_result = -EINPROGRESS;
-    rt_hw_interrupt_enable(level);
+    aio_submit(cb, AIO_STATE_WORK);
 
     rt_work_init(&(cb->aio_work), aio_fync_work, cb);
     rt_workqueue_dowork(aio_queue, &(cb->aio_work));
@@ -151,24 +290,18 @@ int aio_fsync(int op, struct aiocb *cb)
 
 static void aio_read_work(struct rt_work* work, void* work_data)
 {
-    int len;
-    rt_base_t level;
-    uint8_t *buf_ptr;
+    int result;
+    off_t pos = -1;
     struct aiocb *cb = (struct aiocb*)work_data;
 
-    buf_ptr = (uint8_t*)cb->aio_buf;
-
     /* seek to offset */
-    lseek(cb->aio_fildes, cb->aio_offset, SEEK_SET);
-    len = read(cb->aio_fildes, &buf_ptr[cb->aio_offset], cb->aio_nbytes);
+    rt_mutex_take(aio_fd_lock_get(cb->aio_fildes), RT_WAITING_FOREVER);
+    result = aio_transfer(cb, 0, 0, &pos);
+    rt_mutex_release(aio_fd_lock_get(cb->aio_fildes));
 
     /* modify result */
-    level = rt_hw_interrupt_disable();
-    if (len <= 0)
-        cb->aio_result = errno;
-    else
-        cb->aio_result = len;
-    rt_hw_interrupt_enable(level);
+    aio_complete(cb, result);
+    aio_complete_notify();
 
     return ;
 }
@@ -222,14 +355,10 @@ static void aio_read_work(struct rt_work* work, void* work_data)
  */
 int aio_read(struct aiocb *cb)
 {
-    rt_base_t level;
-
     if (!cb) return -EINVAL;
     if (cb->aio_offset < 0) return -EINVAL;
 
-    level = rt_hw_interrupt_disable();
-    cb->aio_result = -EINPROGRESS;
-    rt_hw_interrupt_enable(level);
+    aio_submit(cb, AIO_STATE_WORK);
 
     /* en-queue read work */
     rt_work_init(&(cb->aio_work), aio_read_work, cb);
@@ -287,35 +416,109 @@ ssize_t  aio_return(struct aiocb *cb)
 int aio_suspend(const struct aiocb *const list[], int nent,
              const struct timespec *timeout)
 {
-    return -ENOSYS;
+    int i, done = 0;
+    rt_base_t level;
+    rt_int32_t ticks = RT_WAITING_FOREVER;
+    rt_tick_t start = rt_tick_get(), elapsed;
+    struct aio_waiter waiter;
+
+    if (!list || nent <= 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (timeout)
+    {
+        if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        /* round up to ticks, a longer timeout than the timer takes is clamped */
+        if (timeout->tv_sec >= AIO_TICKS_MAX / RT_TICK_PER_SECOND)
+        {
+            ticks = AIO_TICKS_MAX;
+        }
+        else
+        {
+            ticks = timeout->tv_sec * RT_TICK_PER_SECOND +
+                    ((rt_int64_t)timeout->tv_nsec * RT_TICK_PER_SECOND + 999999999) / 1000000000;
+        }
+    }
+
+    /* it is on the list before the check, no completion is missed */
+    rt_sem_init(&waiter.sem, "aio_w", 0, RT_IPC_FLAG_FIFO);
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&aio_waiters, &waiter.node);
+    rt_hw_interrupt_enable(level);
+
+    while (1)
+    {
+        for (i = 0; i < nent; i++)
+        {
+            if (list[i] && list[i]->aio_result != -EINPROGRESS)
+            {
+                done = 1;
+                break;
+            }
+        }
+        if (done)
+        {
+            break;
+        }
+
+        if (ticks != RT_WAITING_FOREVER)
+        {
+            elapsed = rt_tick_get() - start;
+            if (elapsed >= (rt_tick_t)ticks)
+            {
+                break;
+            }
+            if (rt_sem_take(&waiter.sem, ticks - elapsed) != RT_EOK)
+            {
+                /* check once more */
+                ticks = 0;
+                start = rt_tick_get();
+            }
+        }
+        else
+        {
+            rt_sem_take(&waiter.sem, RT_WAITING_FOREVER);
+        }
+    }
+
+    level = rt_hw_interrupt_disable();
+    rt_list_remove(&waiter.node);
+    rt_hw_interrupt_enable(level);
+    rt_sem_detach(&waiter.sem);
+
+    if (!done)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    return 0;
 }
 
 static void aio_write_work(struct rt_work* work, void* work_data)
 {
-    rt_base_t level;
-    int len, oflags;
-    uint8_t *buf_ptr;
+    int result, oflags;
+    off_t pos = -1;
     struct aiocb *cb = (struct aiocb*)work_data;
 
-    buf_ptr = (uint8_t*)cb->aio_buf;
-
     /* whether seek offset */
+    rt_mutex_take(aio_fd_lock_get(cb->aio_fildes), RT_WAITING_FOREVER);
     oflags = fcntl(cb->aio_fildes, F_GETFL, 0);
-    if ((oflags & O_APPEND) == 0)
-    {
-        lseek(cb->aio_fildes, SEEK_SET, cb->aio_offset);
-    }
 
     /* write data */
-    len = write(cb->aio_fildes, buf_ptr, cb->aio_nbytes);
+    result = aio_transfer(cb, 1, oflags & O_APPEND, &pos);
+    rt_mutex_release(aio_fd_lock_get(cb->aio_fildes));
 
     /* modify result */
-    level = rt_hw_interrupt_disable();
-    if (len <= 0)
-        cb->aio_result = errno;
-    else
-        cb->aio_result = len;
-    rt_hw_interrupt_enable(level);
+    aio_complete(cb, result);
+    aio_complete_notify();
 
     return;
 }
@@ -362,19 +565,16 @@ static void aio_write_work(struct rt_work* work, void* work_data)
 int aio_write(struct aiocb *cb)
 {
     int oflags;
-    rt_base_t level;
 
     if (!cb || (cb->aio_buf == NULL)) return -EINVAL;
 
     /* check access mode */
     oflags = fcntl(cb->aio_fildes, F_GETFL, 0);
-    if ((oflags & O_ACCMODE) != O_WRONLY ||
+    if ((oflags & O_ACCMODE) != O_WRONLY &&
         (oflags & O_ACCMODE) != O_RDWR)
         return -EINVAL;
 
-    level = rt_hw_interrupt_disable();
-    cb->aio_result = -EINPROGRESS;
-    rt_hw_interrupt_enable(level);
+    aio_submit(cb, AIO_STATE_WORK);
 
     rt_work_init(&(cb->aio_work), aio_write_work, cb);
     rt_workqueue_dowork(aio_queue, &(cb->aio_work));
@@ -447,15 +647,162 @@ int aio_write(struct aiocb *cb)
  * address prior to all asynchronous I/O being completed, then the behavior is
  * undefined.
  */
+static void aio_batch_run(struct aio_batch *batch)
+{
+    int i, fd = -1, append = 0, running;
+    rt_base_t level;
+    off_t pos = -1;
+    struct aiocb *cb;
+    struct rt_mutex *lock = RT_NULL;
+
+    for (i = 0; i < batch->nent; i++)
+    {
+        cb = batch->list[i];
+
+        /* the fd lock is held for the following requests of the same fd */
+        if (cb->aio_fildes != fd)
+        {
+            if (lock)
+            {
+                rt_mutex_release(lock);
+            }
+            fd = cb->aio_fildes;
+            lock = aio_fd_lock_get(fd);
+            rt_mutex_take(lock, RT_WAITING_FOREVER);
+            append = fcntl(fd, F_GETFL, 0) & O_APPEND;
+            pos = -1;
+        }
+
+        /* it can't be cancelled once it is running, skip it if it has been cancelled */
+        level = rt_hw_interrupt_disable();
+        running = cb->aio_result == -EINPROGRESS;
+        if (running)
+        {
+            cb->aio_state = AIO_STATE_RUNNING;
+        }
+        rt_hw_interrupt_enable(level);
+        if (!running)
+        {
+            continue;
+        }
+
+        aio_complete(cb, aio_transfer(cb, cb->aio_lio_opcode == LIO_WRITE,
+                                      cb->aio_lio_opcode == LIO_WRITE ? append : 0, &pos));
+    }
+
+    if (lock)
+    {
+        rt_mutex_release(lock);
+    }
+
+    /* the completions of the list are notified once */
+    aio_complete_notify();
+}
+
+static void aio_batch_work(struct rt_work* work, void* work_data)
+{
+    struct aio_batch *batch = (struct aio_batch *)work_data;
+
+    aio_batch_run(batch);
+    rt_free(batch);
+}
+
 int lio_listio(int mode, struct aiocb * const list[], int nent,
             struct sigevent *sig)
 {
-    return -ENOSYS;
+    int i, oflags, failed = 0;
+    struct aiocb *cb;
+    struct aio_batch *batch;
+
+    if ((mode != LIO_WAIT && mode != LIO_NOWAIT) || !list || nent < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    batch = rt_malloc(sizeof(struct aio_batch) + nent * sizeof(struct aiocb *));
+    if (!batch)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    batch->nent = 0;
+
+    for (i = 0; i < nent; i++)
+    {
+        cb = list[i];
+        if (!cb || cb->aio_lio_opcode == LIO_NOP)
+        {
+            continue;
+        }
+
+        if ((cb->aio_lio_opcode != LIO_READ && cb->aio_lio_opcode != LIO_WRITE) ||
+            cb->aio_buf == NULL || cb->aio_offset < 0)
+        {
+            cb->aio_result = EINVAL;
+            failed = 1;
+            continue;
+        }
+
+        /* check access mode */
+        oflags = fcntl(cb->aio_fildes, F_GETFL, 0);
+        if (oflags < 0 || (cb->aio_lio_opcode == LIO_WRITE &&
+            (oflags & O_ACCMODE) != O_WRONLY && (oflags & O_ACCMODE) != O_RDWR))
+        {
+            cb->aio_result = EBADF;
+            failed = 1;
+            continue;
+        }
+
+        /* aio_cancel() marks it and the work of the list skips it */
+        aio_submit(cb, AIO_STATE_LISTED);
+        batch->list[batch->nent++] = cb;
+    }
+
+    if (batch->nent == 0)
+    {
+        rt_free(batch);
+    }
+    else if (mode == LIO_WAIT)
+    {
+        /* the caller waits anyway, the list is run without a worker */
+        aio_batch_run(batch);
+        rt_free(batch);
+    }
+    else
+    {
+        /* the whole list is one work, the requests are run in order */
+        rt_work_init(&(batch->work), aio_batch_work, batch);
+        rt_workqueue_dowork(aio_queue, &(batch->work));
+    }
+
+    /* the status of each request is got by aio_error() */
+    if (failed)
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    return 0;
 }
 
 int aio_system_init(void)
 {
+    int i;
+    char name[RT_NAME_MAX];
+
+    for (i = 0; i < AIO_FD_LOCK_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "aio%d", i);
+        rt_mutex_init(&aio_fd_lock[i], name, RT_IPC_FLAG_PRIO);
+    }
+
+#ifdef RT_USING_WORKQUEUE_POOL
+    /* the requests run concurrently, a request blocked on I/O does not hold the others */
+    aio_queue = rt_workqueue_alloc(RT_WORKQUEUE_UNBOUND | RT_WORKQUEUE_UNORDERED, 0);
+#else
     aio_queue = rt_workqueue_create("aio", 2048, RT_THREAD_PRIORITY_MAX/2);
+#endif /* RT_USING_WORKQUEUE_POOL */
     RT_ASSERT(aio_queue != NULL);
 
     return 0;
@@ -15,6 +15,24 @@
 #include <sys/signal.h>
 #include <rtdevice.h>
 
+#ifndef LIO_READ
+/* aio_lio_opcode of lio_listio() */
+#define LIO_READ        0
+#define LIO_WRITE       1
+#define LIO_NOP         2
+
+/* mode of lio_listio() */
+#define LIO_WAIT        0
+#define LIO_NOWAIT      1
+#endif
+
+#ifndef AIO_CANCELED
+/* return value of aio_cancel() */
+#define AIO_CANCELED    0
+#define AIO_NOTCANCELED 1
+#define AIO_ALLDONE     2
+#endif
+
 struct aiocb
 {
     int aio_fildes;         /* File descriptor. */
@@ -27,6 +45,7 @@ struct aiocb
     int aio_lio_opcode;     /* Operation to be performed. */
 
     int aio_result;
+    int aio_state;          /* Queued as a work or in a list of lio_listio(). */
     struct rt_work aio_work;
 };
 
@@ -7,6 +7,7 @@
  * Date           Author      Notes
  * 2018/08/29     Bernard     first version
  * 2021/04/23     chunyexixiaoyu    distinguish 32-bit and 64-bit
+ * 2023-10-18     RT-Thread   cache the kernel symbols resolved for the relocations
  */
 
 #include "dlmodule.h"
@@ -16,12 +17,53 @@
 #define DBG_LVL    DBG_INFO
 #include <rtdbg.h>          // must after of DEBUG_ENABLE or some other options
 
+/*
+ * The kernel addresses of the undefined symbols of a symbol table, indexed
+ * like the table, so a symbol used by many relocations is only looked up once
+ * while loading the module.
+ */
+struct dlmodule_symcache
+{
+    Elf_Sym    *symtab;
+    rt_ubase_t  count;
+    Elf_Addr   *addr;
+};
+
+static void dlmodule_symcache_bind(struct dlmodule_symcache *cache, void *module_ptr, rt_ubase_t symtab_index)
+{
+    Elf_Sym *symtab = (Elf_Sym *)((rt_uint8_t *)module_ptr + shdr[symtab_index].sh_offset);
+
+    if (cache->symtab == symtab)
+        return;
+
+    rt_free(cache->addr);
+    cache->symtab = symtab;
+    cache->count = shdr[symtab_index].sh_size / sizeof(Elf_Sym);
+    /* look up without the cache if there is no memory */
+    cache->addr = (Elf_Addr *)rt_calloc(cache->count, sizeof(Elf_Addr));
+}
+
+static Elf_Addr dlmodule_symcache_find(struct dlmodule_symcache *cache, Elf_Sym *sym, const char *name)
+{
+    rt_ubase_t index = sym - cache->symtab;
+
+    if (cache->addr == RT_NULL || index >= cache->count)
+        return (Elf_Addr)dlmodule_symbol_find(name);
+
+    if (cache->addr[index] == 0)
+        cache->addr[index] = (Elf_Addr)dlmodule_symbol_find(name);
+
+    return cache->addr[index];
+}
+
 rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_ptr)
 {
     rt_bool_t linked   = RT_FALSE;
+    rt_bool_t unsolved = RT_FALSE;
     rt_ubase_t  index, module_size = 0;
     Elf_Addr vstart_addr, vend_addr;
     rt_bool_t has_vstart;
+    struct dlmodule_symcache cache = {RT_NULL, 0, RT_NULL};
 
     RT_ASSERT(module_ptr != RT_NULL);
 
@@ -124,7 +166,6 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_pt
         Elf_Sym *symtab;
         Elf_Rel *rel;
         rt_uint8_t *strtab;
-        static rt_bool_t unsolved = RT_FALSE;
         #if (defined(__arm__) || defined(__i386__) || (__riscv_xlen == 32))
         if (!IS_REL(shdr[index]))
             continue;
@@ -142,6 +183,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_pt
         strtab = (rt_uint8_t *)module_ptr +
                  shdr[shdr[shdr[index].sh_link].sh_link].sh_offset;
         nr_reloc = (rt_ubase_t)(shdr[index].sh_size / sizeof(Elf_Rel));
+        dlmodule_symcache_bind(&cache, module_ptr, shdr[index].sh_link);
 
         /* relocate every items */
         for (i = 0; i < nr_reloc; i ++)
@@ -166,7 +208,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_pt
 
                 LOG_D("relocate symbol: %s", strtab + sym->st_name);
                 /* need to resolve symbol in kernel symbol table */
-                addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                addr = dlmodule_symcache_find(&cache, sym, (const char *)(strtab + sym->st_name));
                 if (addr == 0)
                 {
                     LOG_E("Module: can't find %s in kernel symbol table", strtab + sym->st_name);
@@ -181,9 +223,13 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_pt
         }
 
         if (unsolved)
-            return -RT_ERROR;
+            break;
     }
 
+    rt_free(cache.addr);
+    if (unsolved)
+        return -RT_ERROR;
+
     /* construct module symbol table */
     for (index = 0; index < elf_module->e_shnum; index ++)
     {
@@ -278,6 +324,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
     rt_ubase_t index, rodata_addr = 0, bss_addr = 0, data_addr = 0;
     rt_ubase_t module_addr = 0, module_size = 0;
     rt_uint8_t *ptr, *strtab, *shstrab;
+    struct dlmodule_symcache cache = {RT_NULL, 0, RT_NULL};
 
     /* get the ELF image size */
     for (index = 0; index < elf_module->e_shnum; index ++)
@@ -342,7 +389,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
             rt_memcpy(ptr,
                       (rt_uint8_t *)elf_module + shdr[index].sh_offset,
                       shdr[index].sh_size);
-            rodata_addr = (rt_uint32_t)ptr;
+            rodata_addr = (rt_ubase_t)ptr;
             LOG_D("load rodata 0x%x, size %d, rodata 0x%x", ptr,
                 shdr[index].sh_size, *(rt_uint32_t *)data_addr);
             ptr += shdr[index].sh_size;
@@ -354,7 +401,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
             rt_memcpy(ptr,
                       (rt_uint8_t *)elf_module + shdr[index].sh_offset,
                       shdr[index].sh_size);
-            data_addr = (rt_uint32_t)ptr;
+            data_addr = (rt_ubase_t)ptr;
             LOG_D("load data 0x%x, size %d, data 0x%x", ptr,
                 shdr[index].sh_size, *(rt_uint32_t *)data_addr);
             ptr += shdr[index].sh_size;
@@ -364,7 +411,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
         if (IS_NOPROG(shdr[index]) && IS_AW(shdr[index]))
         {
             rt_memset(ptr, 0, shdr[index].sh_size);
-            bss_addr = (rt_uint32_t)ptr;
+            bss_addr = (rt_ubase_t)ptr;
             LOG_D("load bss 0x%x, size %d", ptr, shdr[index].sh_size);
         }
     }
@@ -399,6 +446,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
         shstrab  = (rt_uint8_t *)module_ptr +
                    shdr[elf_module->e_shstrndx].sh_offset;
         nr_reloc = (rt_uint32_t)(shdr[index].sh_size / sizeof(Elf_Rel));
+        dlmodule_symcache_bind(&cache, module_ptr, shdr[index].sh_link);
 
         /* relocate every items */
         for (i = 0; i < nr_reloc; i ++)
@@ -468,7 +516,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
                     LOG_D("relocate symbol: %s", strtab + sym->st_name);
 
                     /* need to resolve symbol in kernel symbol table */
-                    addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                    addr = dlmodule_symcache_find(&cache, sym, (const char *)(strtab + sym->st_name));
                     if (addr != (Elf_Addr)RT_NULL)
                     {
                         dlmodule_relocate(module, rel, addr);
@@ -489,5 +537,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule* module, void *module
         }
     }
 
+    rt_free(cache.addr);
+
     return RT_EOK;
 }
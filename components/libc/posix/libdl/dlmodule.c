@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author      Notes
  * 2018/08/29     Bernard     first version
+ * 2023-10-18     RT-Thread   hash index of the kernel symbol table, use the image in place
  */
 
 #include <rthw.h>
@@ -20,6 +21,8 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
+#include <sys/ioctl.h>
+#include <dfs_file.h>
 #endif
 
 #define DBG_TAG    "DLMD"
@@ -29,6 +32,19 @@
 static struct rt_module_symtab *_rt_module_symtab_begin = RT_NULL;
 static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
 
+/*
+ * The hash index of the kernel symbol table, built at boot. The symbols in a
+ * bucket are chained by their index, and the hash of each symbol is kept to
+ * skip most of the string compares. The symbols are looked up linearly if the
+ * index can't be allocated.
+ */
+#define DLMODULE_SYMTAB_NIL     0xffff
+
+static rt_uint32_t  _rt_module_symtab_nbucket = 0;
+static rt_uint16_t *_rt_module_symtab_bucket  = RT_NULL;
+static rt_uint16_t *_rt_module_symtab_chain   = RT_NULL;
+static rt_uint32_t *_rt_module_symtab_hash    = RT_NULL;
+
 #if defined(__IAR_SYSTEMS_ICC__) /* for IAR compiler */
     #pragma section="RTMSymTab"
 #endif
@@ -423,38 +439,65 @@ struct rt_dlmodule *rt_module_self(void)
     return dlmodule_self();
 }
 
-struct rt_dlmodule* dlmodule_load(const char* filename)
-{
 #ifdef RT_USING_POSIX_FS
-    int fd = -1, length = 0;
-#endif
-    rt_err_t ret = RT_EOK;
+/* the image of the module is used in place if the file system keeps the
+ * file in memory (e.g. romfs), otherwise it is read into the heap */
+static rt_uint8_t *_dlmodule_image_load(const char *filename, rt_bool_t *in_place)
+{
+    int fd, length;
+    rt_ubase_t addr = 0;
     rt_uint8_t *module_ptr = RT_NULL;
-    struct rt_dlmodule *module = RT_NULL;
 
-#ifdef RT_USING_POSIX_FS
+    *in_place = RT_FALSE;
+
     fd = open(filename, O_RDONLY, 0);
-    if (fd >= 0)
-    {
-        length = lseek(fd, 0, SEEK_END);
-        lseek(fd, 0, SEEK_SET);
+    if (fd < 0) return RT_NULL;
 
-        if (length == 0) goto __exit;
+    length = lseek(fd, 0, SEEK_END);
+    lseek(fd, 0, SEEK_SET);
 
-        module_ptr = (uint8_t*) rt_malloc (length);
-        if (!module_ptr) goto __exit;
+    if (length > 0)
+    {
+        if (ioctl(fd, RT_FIOGETADDR, &addr) == 0 && addr != 0)
+        {
+            module_ptr = (rt_uint8_t *)addr;
+            *in_place = RT_TRUE;
+        }
+        else
+        {
+            module_ptr = (rt_uint8_t *)rt_malloc(length);
+            if (module_ptr && read(fd, module_ptr, length) != length)
+            {
+                rt_free(module_ptr);
+                module_ptr = RT_NULL;
+            }
+        }
+    }
 
-        if (read(fd, module_ptr, length) != length)
-            goto __exit;
+    /* close file and release fd */
+    close(fd);
 
-        /* close file and release fd */
-        close(fd);
-        fd = -1;
-    }
-    else
+    return module_ptr;
+}
+#endif
+
+static void _dlmodule_image_release(rt_uint8_t *module_ptr, rt_bool_t in_place)
+{
+    if (!in_place)
     {
-        goto __exit;
+        rt_free(module_ptr);
     }
+}
+
+struct rt_dlmodule* dlmodule_load(const char* filename)
+{
+    rt_err_t ret = RT_EOK;
+    rt_uint8_t *module_ptr = RT_NULL;
+    rt_bool_t in_place = RT_FALSE;
+    struct rt_dlmodule *module = RT_NULL;
+
+#ifdef RT_USING_POSIX_FS
+    module_ptr = _dlmodule_image_load(filename, &in_place);
 #endif
 
     if (!module_ptr) goto __exit;
@@ -500,7 +543,7 @@ struct rt_dlmodule* dlmodule_load(const char* filename)
     if (ret != RT_EOK) goto __exit;
 
     /* release module data */
-    rt_free(module_ptr);
+    _dlmodule_image_release(module_ptr, in_place);
 
     /* increase module reference count */
     module->nref ++;
@@ -524,10 +567,7 @@ struct rt_dlmodule* dlmodule_load(const char* filename)
     return module;
 
 __exit:
-#ifdef RT_USING_POSIX_FS
-    if (fd >= 0) close(fd);
-#endif
-    if (module_ptr) rt_free(module_ptr);
+    if (module_ptr) _dlmodule_image_release(module_ptr, in_place);
     if (module) dlmodule_destroy(module);
 
     return RT_NULL;
@@ -575,11 +615,9 @@ struct rt_dlmodule* dlmodule_exec(const char* pgname, const char* cmd, int cmd_s
 #if defined(RT_USING_CUSTOM_DLMODULE)
 struct rt_dlmodule* dlmodule_load_custom(const char* filename, struct rt_dlmodule_ops* ops)
 {
-#ifdef RT_USING_POSIX_FS
-    int fd = -1, length = 0;
-#endif
     rt_err_t ret = RT_EOK;
     rt_uint8_t *module_ptr = RT_NULL;
+    rt_bool_t in_place = RT_FALSE;
     struct rt_dlmodule *module = RT_NULL;
 
     if (ops)
@@ -591,28 +629,7 @@ struct rt_dlmodule* dlmodule_load_custom(const char* filename, struct rt_dlmodul
 #ifdef RT_USING_POSIX_FS
     else
     {
-        fd = open(filename, O_RDONLY, 0);
-        if (fd >= 0)
-        {
-            length = lseek(fd, 0, SEEK_END);
-            lseek(fd, 0, SEEK_SET);
-
-            if (length == 0) goto __exit;
-
-            module_ptr = (uint8_t*) rt_malloc (length);
-            if (!module_ptr) goto __exit;
-
-            if (read(fd, module_ptr, length) != length)
-                goto __exit;
-
-            /* close file and release fd */
-            close(fd);
-            fd = -1;
-        }
-        else
-        {
-            goto __exit;
-        }
+        module_ptr = _dlmodule_image_load(filename, &in_place);
     }
 #endif
 
@@ -665,7 +682,7 @@ struct rt_dlmodule* dlmodule_load_custom(const char* filename, struct rt_dlmodul
     }
     else
     {
-        rt_free(module_ptr);
+        _dlmodule_image_release(module_ptr, in_place);
     }
 
     /* increase module reference count */
@@ -690,9 +707,6 @@ struct rt_dlmodule* dlmodule_load_custom(const char* filename, struct rt_dlmodul
     return module;
 
 __exit:
-#ifdef RT_USING_POSIX_FS
-    if (fd >= 0) close(fd);
-#endif
     if (module_ptr)
     {
         if (ops)
@@ -701,7 +715,7 @@ __exit:
         }
         else
         {
-            rt_free(module_ptr);
+            _dlmodule_image_release(module_ptr, in_place);
         }
     }
 
@@ -792,20 +806,82 @@ void dlmodule_exit(int ret_code)
     rt_exit_critical();
 }
 
-rt_uint32_t dlmodule_symbol_find(const char *sym_str)
+/* the hash of the GNU hash section of ELF */
+static rt_uint32_t _dlmodule_symbol_hash(const char *name)
+{
+    rt_uint32_t h = 5381;
+
+    while (*name)
+    {
+        h = (h << 5) + h + (rt_uint8_t)*name++;
+    }
+
+    return h;
+}
+
+rt_ubase_t dlmodule_symbol_find(const char *sym_str)
 {
     /* find in kernel symbol table */
     struct rt_module_symtab *index;
+    rt_uint32_t hash;
+    rt_uint16_t i;
+
+    if (_rt_module_symtab_bucket != RT_NULL)
+    {
+        hash = _dlmodule_symbol_hash(sym_str);
+
+        for (i = _rt_module_symtab_bucket[hash & (_rt_module_symtab_nbucket - 1)];
+             i != DLMODULE_SYMTAB_NIL; i = _rt_module_symtab_chain[i])
+        {
+            index = _rt_module_symtab_begin + i;
+            if (_rt_module_symtab_hash[i] == hash && rt_strcmp(index->name, sym_str) == 0)
+                return (rt_ubase_t)index->addr;
+        }
+
+        return 0;
+    }
 
     for (index = _rt_module_symtab_begin; index != _rt_module_symtab_end; index ++)
     {
         if (rt_strcmp(index->name, sym_str) == 0)
-            return (rt_uint32_t)index->addr;
+            return (rt_ubase_t)index->addr;
     }
 
     return 0;
 }
 
+static void _dlmodule_symtab_index(void)
+{
+    rt_uint32_t i, nsym, nbucket, slot;
+
+    nsym = _rt_module_symtab_end - _rt_module_symtab_begin;
+    if (nsym == 0 || nsym >= DLMODULE_SYMTAB_NIL) return;
+
+    /* two symbols per bucket on average */
+    for (nbucket = 1; nbucket * 2 < nsym; nbucket <<= 1);
+
+    _rt_module_symtab_hash = (rt_uint32_t *)rt_malloc(nsym * sizeof(rt_uint32_t) +
+                                                      (nsym + nbucket) * sizeof(rt_uint16_t));
+    if (_rt_module_symtab_hash == RT_NULL)
+    {
+        LOG_W("no memory for the index of %d symbols", nsym);
+        return;
+    }
+    _rt_module_symtab_chain = (rt_uint16_t *)(_rt_module_symtab_hash + nsym);
+    _rt_module_symtab_bucket = _rt_module_symtab_chain + nsym;
+    _rt_module_symtab_nbucket = nbucket;
+
+    rt_memset(_rt_module_symtab_bucket, 0xff, nbucket * sizeof(rt_uint16_t));
+    /* link from the end, so the first one of the duplicated symbols wins */
+    for (i = nsym; i > 0; i--)
+    {
+        _rt_module_symtab_hash[i - 1] = _dlmodule_symbol_hash(_rt_module_symtab_begin[i - 1].name);
+        slot = _rt_module_symtab_hash[i - 1] & (nbucket - 1);
+        _rt_module_symtab_chain[i - 1] = _rt_module_symtab_bucket[slot];
+        _rt_module_symtab_bucket[slot] = (rt_uint16_t)(i - 1);
+    }
+}
+
 int rt_system_dlmodule_init(void)
 {
 #if defined(__GNUC__) && !defined(__CC_ARM)
@@ -825,6 +901,8 @@ int rt_system_dlmodule_init(void)
     _rt_module_symtab_end   = __section_end("RTMSymTab");
 #endif
 
+    _dlmodule_symtab_index();
+
     return 0;
 }
 INIT_COMPONENT_EXPORT(rt_system_dlmodule_init);
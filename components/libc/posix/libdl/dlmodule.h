@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018/08/11     Bernard      the first version
+ * 2023-10-18     RT-Thread    return the symbol address in rt_ubase_t
  */
 
 #ifndef RT_DL_MODULE_H__
@@ -40,7 +41,7 @@ struct rt_dlmodule
     int ret_code;
 
     /* VMA base address for the first LOAD segment */
-    rt_uint32_t vstart_addr;
+    rt_ubase_t vstart_addr;
 
     /* module entry, RT_NULL for dynamic library */
     rt_dlmodule_entry_func_t  entry_addr;
@@ -82,6 +83,6 @@ void dlmodule_exit(int ret_code);
 
 struct rt_dlmodule *dlmodule_find(const char *name);
 
-rt_uint32_t dlmodule_symbol_find(const char *sym_str);
+rt_ubase_t dlmodule_symbol_find(const char *sym_str);
 
 #endif
@@ -1040,6 +1040,10 @@ void lwp_cleanup(struct rt_thread *tid)
     level = rt_hw_interrupt_disable();
     lwp = (struct rt_lwp *)tid->lwp;
 
+#ifdef RT_USING_CPU_USAGE
+    lwp_cpu_time_collect(lwp, tid);
+#endif
+
     lwp_tid_put(tid->tid);
     rt_list_remove(&tid->sibling);
     rt_hw_interrupt_enable(level);
@@ -1232,6 +1236,19 @@ pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
                 //lwp->tgroup_leader = &thread; //add thread group leader for lwp
                 lwp->__pgrp = tid;
                 lwp->session = self_lwp->session;
+#ifdef RT_USING_SMP
+                /* the cpu affinity is inherited by the child process */
+                lwp->cpu_affinity = self_lwp->cpu_affinity;
+                rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)lwp->cpu_affinity);
+#endif
+#ifdef RT_USING_SCHED_GROUP
+                /* so is the scheduling group */
+                lwp->sgroup = rt_sched_group_get(self_lwp->sgroup);
+#endif
+                rt_memcpy(lwp->rlim, self_lwp->rlim, sizeof(lwp->rlim));
+#ifdef LWP_USING_MEM_GROUP
+                lwp_mem_group_inherit(lwp, self_lwp->mgroup);
+#endif
                 /* lwp add to children link */
                 lwp->sibling = self_lwp->first_child;
                 self_lwp->first_child = lwp;
@@ -1315,6 +1332,9 @@ pid_t lwp_execve(char *filename, int debug, int argc, char **argv, char **envp)
             rt_memset(thread->user_stack, '#', thread->user_stack_size);
 #endif /* not defined ARCH_MM_MMU */
             rt_list_insert_after(&lwp->t_grp, &thread->sibling);
+#ifdef RT_USING_SCHED_GROUP
+            rt_sched_group_attach(lwp->sgroup, thread);
+#endif
 
             if (debug && rt_dbg_ops)
             {
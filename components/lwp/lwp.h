@@ -32,6 +32,7 @@
 
 #ifdef ARCH_MM_MMU
 #include "lwp_shm.h"
+#include "lwp_mem.h"
 
 #include "mmu.h"
 #include "page.h"
@@ -64,6 +65,20 @@ struct rt_lwp_objs
     struct rt_mem_obj mem_obj;
 };
 
+/* resource limits, the numbers are the same as RLIMIT_* of the libc */
+#define LWP_RLIMIT_DATA     2
+#define LWP_RLIMIT_NOFILE   7
+#define LWP_RLIMIT_AS       9
+#define LWP_RLIMIT_NR       16
+
+#define LWP_RLIM_INFINITY   (~0ULL)
+
+struct lwp_rlimit
+{
+    rt_uint64_t rlim_cur;
+    rt_uint64_t rlim_max;
+};
+
 struct rt_lwp
 {
 #ifdef ARCH_MM_MMU
@@ -77,11 +92,12 @@ struct rt_lwp
 #endif
 
 #ifdef RT_USING_SMP
-    int bind_cpu;
+    rt_ubase_t cpu_affinity;
 #endif
 
     uint8_t lwp_type;
-    uint8_t reserv[3];
+    uint8_t oom_exempt; /* never chosen by the OOM killer */
+    uint8_t reserv[2];
 
     struct rt_lwp *parent;
     struct rt_lwp *first_child;
@@ -133,6 +149,22 @@ struct rt_lwp
     uint64_t generation;
     unsigned int asid;
 #endif
+
+#ifdef RT_USING_SCHED_GROUP
+    struct rt_sched_group *sgroup; /* scheduling group of the threads, RT_NULL for the kernel group */
+#endif
+
+    struct lwp_rlimit rlim[LWP_RLIMIT_NR];
+#ifdef LWP_USING_MEM_GROUP
+    struct lwp_mem_group *mgroup;  /* memory group charged with the pages, RT_NULL for none */
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+    rt_uint64_t utime;  /* user time of exited threads */
+    rt_uint64_t stime;  /* system time of exited threads */
+    rt_uint64_t cutime; /* user time of waited children */
+    rt_uint64_t cstime; /* system time of waited children */
+#endif
 };
 
 struct rt_lwp *lwp_self(void);
@@ -167,6 +199,23 @@ void lwp_aspace_switch(struct rt_thread *thread);
 void lwp_user_setting_save(rt_thread_t thread);
 void lwp_user_setting_restore(rt_thread_t thread);
 int lwp_setaffinity(pid_t pid, int cpu);
+int lwp_set_cpu_affinity(pid_t pid, rt_ubase_t cpu_affinity);
+int lwp_get_cpu_affinity(pid_t pid, rt_ubase_t *cpu_affinity);
+#ifdef RT_USING_SCHED_GROUP
+int lwp_sched_group_attach(pid_t pid, rt_sched_group_t group);
+
+/*
+ * the commands of sys_sched_group_ctl(cmd, name, arg0, arg1), only the init
+ * process may use the commands other than attach. A process may attach itself
+ * and its children except the init process, and an unprivileged one only to
+ * a group under its own group.
+ */
+#define LWP_SCHED_GROUP_CREATE      0   /* create the group name, arg0 is the name of the parent, 0 for the root */
+#define LWP_SCHED_GROUP_DELETE      1   /* delete the group name, which is not in use */
+#define LWP_SCHED_GROUP_SET_SHARES  2   /* arg0 is the cpu shares of the group name */
+#define LWP_SCHED_GROUP_SET_QUOTA   3   /* arg0 is the quota and arg1 is the period in us, 0 for the default */
+#define LWP_SCHED_GROUP_ATTACH      4   /* move the process arg0 to the group name, RT_NULL for the kernel group */
+#endif
 
 #ifdef ARCH_MM_MMU
 struct __pthread {
@@ -17,6 +17,10 @@
 #include <dfs_file.h>
 #include <poll.h>
 
+#ifndef RT_CH_MSG_SLOTS_NR
+#define RT_CH_MSG_SLOTS_NR  8
+#endif
+
 /**
  * the IPC channel states
  */
@@ -30,12 +34,15 @@ enum
 /**
  * IPC message structure.
  *
- * They are allocated and released in the similar way like 'rt_chfd'.
+ * The queued messages are allocated from the slots of the channel first, then
+ * from the global pool. The messages to a blocked thread are not allocated,
+ * they are copied to the message on the stack of the thread directly.
  */
 struct rt_ipc_msg
 {
     struct rt_channel_msg msg;                           /**< the payload of msg */
     rt_list_t mlist;                                     /**< the msg list */
+    rt_channel_t ch;                                     /**< the owner of the slot, RT_NULL for the global pool */
     rt_uint8_t need_reply;                               /**< whether msg wait reply*/
 };
 typedef struct rt_ipc_msg *rt_ipc_msg_t;
@@ -45,13 +52,19 @@ static int rt_ipc_msg_used = 0;                                 /* first unalloc
 static struct rt_ipc_msg ipc_msg_pool[RT_CH_MSG_MAX_NR];        /* initial message array */
 
 /**
- * Allocate an IPC message from the statically-allocated array.
+ * Allocate an IPC message from the slots of the channel, or from the
+ * statically-allocated array if all the slots are used.
  */
-static rt_ipc_msg_t _ipc_msg_alloc(void)
+static rt_ipc_msg_t _ipc_msg_alloc(rt_channel_t ch)
 {
     rt_ipc_msg_t p = (rt_ipc_msg_t)RT_NULL;
 
-    if (_ipc_msg_free_list)                         /* use the released chain first */
+    if (ch->msg_free)                               /* use the slots of the channel first */
+    {
+        p = (rt_ipc_msg_t)ch->msg_free;
+        ch->msg_free = p->msg.sender;               /* emtry payload as a pointer */
+    }
+    else if (_ipc_msg_free_list)                    /* use the released chain first */
     {
         p = _ipc_msg_free_list;
         _ipc_msg_free_list = (rt_ipc_msg_t)p->msg.sender; /* emtry payload as a pointer */
@@ -59,18 +72,71 @@ static rt_ipc_msg_t _ipc_msg_alloc(void)
     else if (rt_ipc_msg_used < RT_CH_MSG_MAX_NR)
     {
         p = &ipc_msg_pool[rt_ipc_msg_used];
+        p->ch = RT_NULL;
         rt_ipc_msg_used++;
     }
     return p;
 }
 
 /**
- * Put a released IPC message back to the released chain.
+ * Put a released IPC message back to the slots of its channel or the released
+ * chain.
  */
 static void _ipc_msg_free(rt_ipc_msg_t p_msg)
 {
-    p_msg->msg.sender = (void*)_ipc_msg_free_list;
-    _ipc_msg_free_list = p_msg;
+    if (p_msg->ch)
+    {
+        p_msg->msg.sender = p_msg->ch->msg_free;
+        p_msg->ch->msg_free = (void*)p_msg;
+    }
+    else
+    {
+        p_msg->msg.sender = (void*)_ipc_msg_free_list;
+        _ipc_msg_free_list = p_msg;
+    }
+}
+
+/**
+ * Allocate the message slots of a new channel, the channel works with the
+ * global pool only if it fails.
+ */
+static void _ipc_msg_slots_init(rt_channel_t ch)
+{
+    int i;
+    rt_ipc_msg_t slots;
+
+    ch->msg_free = RT_NULL;
+    ch->msg_slots = rt_malloc(RT_CH_MSG_SLOTS_NR * sizeof(struct rt_ipc_msg));
+    slots = (rt_ipc_msg_t)ch->msg_slots;
+
+    for (i = 0; slots && i < RT_CH_MSG_SLOTS_NR; i++)
+    {
+        slots[i].ch = ch;
+        _ipc_msg_free(&slots[i]);
+    }
+}
+
+/**
+ * Release the unhandled messages and the message slots of a closed channel.
+ */
+static void _ipc_msg_slots_deinit(rt_channel_t ch)
+{
+    rt_ipc_msg_t msg;
+
+    /* all ipc msg will lost */
+    while (!rt_list_isempty(&ch->wait_msg))
+    {
+        msg = rt_list_entry(ch->wait_msg.next, struct rt_ipc_msg, mlist);
+        rt_list_remove(&msg->mlist);
+        _ipc_msg_free(msg);
+    }
+
+    if (ch->msg_slots)
+    {
+        rt_free(ch->msg_slots);
+        ch->msg_slots = RT_NULL;
+        ch->msg_free = RT_NULL;
+    }
 }
 
 /**
@@ -217,6 +283,7 @@ rt_channel_t rt_raw_channel_open(const char *name, int flags)
         rt_list_init(&ch->wait_msg);            /* unhandled messages */
         rt_list_init(&ch->wait_thread);         /* suspended senders */
         rt_wqueue_init(&ch->reader_queue);      /* reader poll queue */
+        _ipc_msg_slots_init(ch);                /* message slots */
         ch->reply = RT_NULL;
         ch->stat = RT_IPC_STAT_IDLE;            /* no suspended threads */
         ch->ref = 1;
@@ -265,7 +332,7 @@ rt_err_t rt_raw_channel_close(rt_channel_t ch)
         rt_channel_list_resume_all(&ch->wait_thread);
 
         /* all ipc msg will lost */
-        rt_list_init(&ch->wait_msg);
+        _ipc_msg_slots_deinit(ch);
 
         rt_object_delete(&ch->parent.parent);   /* release the IPC channel structure */
     }
@@ -403,13 +470,19 @@ static int _ipc_msg_fd_new(void *file)
 
 /**
  * Send data through an IPC channel, wait for the reply or not.
+ *
+ * If the receiver is blocked on the channel, the message is copied to it
+ * directly, and the sender waiting for the reply switches to the receiver on
+ * this cpu without going through the ready queue.
  */
 static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_msg_t data, int need_reply, rt_channel_msg_t data_ret, rt_int32_t time)
 {
     rt_ipc_msg_t msg;
-    struct rt_thread *thread_recv, *thread_send = 0;
+    struct rt_ipc_msg msg_reply;
+    struct rt_thread *thread_recv = RT_NULL, *thread_send = 0;
     register rt_base_t temp;
     rt_err_t ret;
+    rt_bool_t handoff = RT_FALSE;
     void (*old_timeout_func)(void *) = 0;
 
     if (need_reply)
@@ -435,12 +508,23 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
         return -RT_ETIMEOUT;
     }
 
-    /* allocate an IPC message */
-    msg = _ipc_msg_alloc();
-    if (!msg)
+    if (ch->stat == RT_IPC_STAT_WAIT)
     {
-        rt_hw_interrupt_enable(temp);
-        return -RT_ENOMEM;
+        /* the message is copied to the first suspended receiver */
+        RT_ASSERT(ch->parent.suspend_thread.next != &ch->parent.suspend_thread);
+
+        thread_recv = rt_list_entry(ch->parent.suspend_thread.next, struct rt_thread, tlist);
+        msg = (rt_ipc_msg_t)thread_recv->msg_ret;
+    }
+    else
+    {
+        /* allocate an IPC message */
+        msg = _ipc_msg_alloc(ch);
+        if (!msg)
+        {
+            rt_hw_interrupt_enable(temp);
+            return -RT_ENOMEM;
+        }
     }
 
     /* IPC message : file descriptor */
@@ -455,6 +539,7 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
     {
         thread_send = rt_thread_self();
         thread_send->error = RT_EOK;
+        thread_send->msg_ret = &msg_reply;  /* the reply is copied here */
     }
 
     switch (ch->stat)
@@ -467,6 +552,7 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
                 if (ret != RT_EOK)
                 {
                     _ipc_msg_free(msg);
+                    thread_send->msg_ret = RT_NULL;
                     rt_hw_interrupt_enable(temp);
                     return ret;
                 }
@@ -494,18 +580,15 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
             break;
         case RT_IPC_STAT_WAIT:
             /*
-             * If there are suspended receivers on the IPC channel, transfer the
-             * pointer of the message to the first receiver directly and wake it
-             * up.
+             * If there are suspended receivers on the IPC channel, the message
+             * has been copied to the first receiver, wake it up.
              */
-            RT_ASSERT(ch->parent.suspend_thread.next != &ch->parent.suspend_thread);
-
             if (need_reply)
             {
                 ret = rt_channel_list_suspend(&ch->wait_thread, thread_send);
                 if (ret != RT_EOK)
                 {
-                    _ipc_msg_free(msg);
+                    thread_send->msg_ret = RT_NULL;
                     rt_hw_interrupt_enable(temp);
                     return ret;
                 }
@@ -531,10 +614,7 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
             {
                 ch->stat = RT_IPC_STAT_IDLE;
             }
-            thread_recv = rt_list_entry(ch->parent.suspend_thread.next, struct rt_thread, tlist);
-            thread_recv->msg_ret = msg;     /* to the first suspended receiver */
             thread_recv->error = RT_EOK;
-            rt_channel_list_resume(&ch->parent.suspend_thread);
             break;
         default:
             break;
@@ -544,10 +624,29 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
     {
         _rt_channel_check_wq_wakup(ch);
     }
+
+    if (thread_recv)
+    {
+        /*
+         * The sender blocked for the reply switches to the receiver directly,
+         * the channel may be closed after that, it should not be accessed.
+         */
+        if (need_reply && rt_schedule_switch_to(thread_recv) == RT_EOK)
+        {
+            handoff = RT_TRUE;
+        }
+        else
+        {
+            rt_channel_list_resume(&ch->parent.suspend_thread);
+        }
+    }
     rt_hw_interrupt_enable(temp);
 
-    /* reschedule in order to let the potential receivers run */
-    rt_schedule();
+    if (!handoff)
+    {
+        /* reschedule in order to let the potential receivers run */
+        rt_schedule();
+    }
 
     if (need_reply)
     {
@@ -559,6 +658,7 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
                     old_timeout_func);
         }
         ret = thread_send->error;
+        thread_send->msg_ret = RT_NULL;
         rt_hw_interrupt_enable(temp);
 
         if (ret != RT_EOK)
@@ -568,11 +668,7 @@ static rt_err_t _rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_ms
 
         /* If the sender gets the chance to run, the requested reply must be valid. */
         RT_ASSERT(data_ret != RT_NULL);
-        *data_ret = ((rt_ipc_msg_t)(thread_send->msg_ret))->msg;   /* extract data */
-        temp = rt_hw_interrupt_disable();
-        _ipc_msg_free(thread_send->msg_ret);    /* put back the message to kernel */
-        rt_hw_interrupt_enable(temp);
-        thread_send->msg_ret = RT_NULL;
+        *data_ret = msg_reply.msg;  /* extract data */
     }
 
     return RT_EOK;
@@ -603,11 +699,11 @@ rt_err_t rt_raw_channel_send_recv_timeout(rt_channel_t ch, rt_channel_msg_t data
 }
 
 /**
- * Reply to the waiting sender and wake it up.
+ * Reply to the waiting sender and wake it up, the reply is copied to the
+ * sender directly.
  */
 rt_err_t rt_raw_channel_reply(rt_channel_t ch, rt_channel_msg_t data)
 {
-    rt_ipc_msg_t msg;
     struct rt_thread *thread;
     register rt_base_t temp;
 
@@ -636,18 +732,8 @@ rt_err_t rt_raw_channel_reply(rt_channel_t ch, rt_channel_msg_t data)
         return -RT_ERROR;
     }
 
-    /* allocate an IPC message */
-    msg = _ipc_msg_alloc();
-    if (!msg)
-    {
-        rt_hw_interrupt_enable(temp);
-        return -RT_ENOMEM;
-    }
-
-    rt_ipc_msg_init(msg, data, 0);
-
     thread = ch->reply;
-    thread->msg_ret = msg;          /* transfer the reply to the sender */
+    rt_ipc_msg_init((rt_ipc_msg_t)thread->msg_ret, data, 0);  /* transfer the reply to the sender */
     rt_thread_resume(thread);       /* wake up the sender */
     ch->stat = RT_IPC_STAT_IDLE;
     ch->reply = RT_NULL;
@@ -699,6 +785,7 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
 {
     struct rt_thread *thread;
     rt_ipc_msg_t msg_ret;
+    struct rt_ipc_msg msg_recv;
     register rt_base_t temp;
     rt_err_t ret;
     void (*old_timeout_func)(void *) = 0;
@@ -762,6 +849,7 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
         rt_thread_wakeup_set(thread, wakeup_receiver, (void*)ch);
         ch->stat = RT_IPC_STAT_WAIT;/* no valid suspended senders */
         thread->error = RT_EOK;
+        thread->msg_ret = &msg_recv;/* the message is copied here by the sender */
         if (time > 0)
         {
             rt_timer_control(&(thread->thread_timer),
@@ -788,19 +876,18 @@ static rt_err_t _rt_raw_channel_recv_timeout(rt_channel_t ch, rt_channel_msg_t d
                     old_timeout_func);
         }
         ret = thread->error;
+        thread->msg_ret = RT_NULL;
         if ( ret != RT_EOK)
         {
             rt_hw_interrupt_enable(temp);
             return ret;
         }
-        /* If waked up, the received message has been store into the thread. */
-        *data = ((rt_ipc_msg_t)(thread->msg_ret))->msg;    /* extract data */
+        /* If waked up, the received message has been copied to the stack. */
+        *data = msg_recv.msg;       /* extract data */
         if (data->type == RT_CHANNEL_FD)
         {
             data->u.fd.fd = _ipc_msg_fd_new(data->u.fd.file);
         }
-        _ipc_msg_free(thread->msg_ret);     /* put back the message to kernel */
-        thread->msg_ret = RT_NULL;
     }
 
     rt_hw_interrupt_enable(temp);
@@ -935,7 +1022,7 @@ static int channel_fops_close(struct dfs_file *file)
             rt_channel_list_resume_all(&ch->wait_thread);
 
             /* all ipc msg will lost */
-            rt_list_init(&ch->wait_msg);
+            _ipc_msg_slots_deinit(ch);
 
             rt_object_delete(&ch->parent.parent);   /* release the IPC channel structure */
         }
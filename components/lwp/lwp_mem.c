@@ -0,0 +1,613 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <rtatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARCH_MM_MMU
+
+#include <lwp.h>
+#include <lwp_arch.h>
+#include <lwp_mem.h>
+#include <lwp_signal.h>
+
+#define DBG_TAG "LwP.mem"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+/**
+ * @brief Get the memory usage of a process.
+ *
+ * @param lwp is the process.
+ *
+ * @param stat is the memory usage returned.
+ */
+void lwp_mem_stat_get(struct rt_lwp *lwp, struct lwp_mem_stat *stat)
+{
+    rt_memset(stat, 0, sizeof(*stat));
+
+    if (lwp->aspace)
+    {
+        stat->vsz = lwp->aspace->vsz;
+        stat->rss = lwp->aspace->rss << ARCH_PAGE_SHIFT;
+    }
+    if (lwp->end_heap > USER_HEAP_VADDR)
+    {
+        stat->heap = lwp->end_heap - USER_HEAP_VADDR;
+    }
+}
+
+static rt_bool_t _rlimit_exceeded(struct rt_lwp *lwp, int resource, rt_uint64_t size)
+{
+    rt_uint64_t limit = lwp->rlim[resource].rlim_cur;
+
+    return limit != LWP_RLIM_INFINITY && size > limit;
+}
+
+/**
+ * @brief Check RLIMIT_AS of a process before its address space is grown.
+ *
+ * @param lwp is the process.
+ *
+ * @param size is the bytes to be mapped.
+ *
+ * @return RT_EOK if the address space can be grown, -RT_ENOMEM if not.
+ */
+rt_err_t lwp_mem_as_check(struct rt_lwp *lwp, rt_size_t size)
+{
+    if (lwp->aspace && _rlimit_exceeded(lwp, LWP_RLIMIT_AS, (rt_uint64_t)lwp->aspace->vsz + size))
+    {
+        LOG_D("pid %d: RLIMIT_AS exceeded", lwp_to_pid(lwp));
+        return -RT_ENOMEM;
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * @brief Check RLIMIT_DATA of a process before its heap is grown.
+ *
+ * @param lwp is the process.
+ *
+ * @param size is the bytes to be added to the heap.
+ *
+ * @return RT_EOK if the heap can be grown, -RT_ENOMEM if not.
+ */
+rt_err_t lwp_mem_data_check(struct rt_lwp *lwp, rt_size_t size)
+{
+    rt_uint64_t heap = lwp->end_heap - USER_HEAP_VADDR;
+
+    if (_rlimit_exceeded(lwp, LWP_RLIMIT_DATA, heap + size))
+    {
+        LOG_D("pid %d: RLIMIT_DATA exceeded", lwp_to_pid(lwp));
+        return -RT_ENOMEM;
+    }
+
+    return RT_EOK;
+}
+
+#ifdef LWP_USING_MEM_GROUP
+
+static rt_list_t _mgroup_list = RT_LIST_OBJECT_INIT(_mgroup_list);
+
+static lwp_mem_group_t _mgroup_find(const char *name)
+{
+    rt_list_t *node;
+    lwp_mem_group_t group;
+
+    rt_list_for_each(node, &_mgroup_list)
+    {
+        group = rt_list_entry(node, struct lwp_mem_group, list);
+        if (rt_strncmp(group->name, name, RT_NAME_MAX) == 0)
+        {
+            return group;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/**
+ * @brief Create a memory group.
+ *
+ * @param name is the name of the group.
+ *
+ * @param limit is the maximum pages charged by the processes in the group,
+ *        0 for no limit.
+ *
+ * @return the group, RT_NULL if the name is in use or out of memory.
+ */
+lwp_mem_group_t lwp_mem_group_create(const char *name, rt_size_t limit)
+{
+    lwp_mem_group_t group;
+    rt_base_t level;
+
+    group = (lwp_mem_group_t)rt_malloc(sizeof(struct lwp_mem_group));
+    if (group == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    rt_memset(group, 0, sizeof(*group));
+    rt_strncpy(group->name, name, RT_NAME_MAX);
+    group->limit = limit;
+    rt_list_init(&group->list);
+
+    level = rt_hw_interrupt_disable();
+    if (_mgroup_find(name))
+    {
+        rt_hw_interrupt_enable(level);
+        rt_free(group);
+        return RT_NULL;
+    }
+    rt_list_insert_before(&_mgroup_list, &group->list);
+    rt_hw_interrupt_enable(level);
+
+    return group;
+}
+
+/**
+ * @brief Delete a memory group.
+ *
+ * @param group is the group.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if there are processes in the group.
+ */
+rt_err_t lwp_mem_group_delete(lwp_mem_group_t group)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (group->ref)
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+    rt_list_remove(&group->list);
+    rt_hw_interrupt_enable(level);
+
+    rt_free(group);
+    return RT_EOK;
+}
+
+/**
+ * @brief Find a memory group by name.
+ *
+ * @param name is the name of the group.
+ *
+ * @return the group, RT_NULL if not found.
+ */
+lwp_mem_group_t lwp_mem_group_find(const char *name)
+{
+    lwp_mem_group_t group;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    group = _mgroup_find(name);
+    rt_hw_interrupt_enable(level);
+
+    return group;
+}
+
+/**
+ * @brief Set the limit of a memory group, the pages charged already are
+ *        not reclaimed until more pages are requested.
+ *
+ * @param group is the group.
+ *
+ * @param limit is the maximum pages, 0 for no limit.
+ *
+ * @return RT_EOK.
+ */
+rt_err_t lwp_mem_group_set_limit(lwp_mem_group_t group, rt_size_t limit)
+{
+    group->limit = limit;
+    return RT_EOK;
+}
+
+/**
+ * @brief Set the memory group of a process, the pages charged by the
+ *        process are moved to the new group.
+ *
+ * @param lwp is the process.
+ *
+ * @param group is the group, RT_NULL for none.
+ */
+void lwp_mem_group_inherit(struct rt_lwp *lwp, lwp_mem_group_t group)
+{
+    lwp_mem_group_t old;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    old = lwp->mgroup;
+    if (group)
+    {
+        group->ref++;
+    }
+    lwp->mgroup = group;
+    if (lwp->aspace)
+    {
+        rt_aspace_rss_group_set(lwp->aspace, group ? &group->usage : RT_NULL);
+    }
+    if (old)
+    {
+        old->ref--;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Release the memory group of an exited process, whose address
+ *        space is freed already.
+ *
+ * @param lwp is the process.
+ */
+void lwp_mem_group_release(struct rt_lwp *lwp)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (lwp->mgroup)
+    {
+        lwp->mgroup->ref--;
+        lwp->mgroup = RT_NULL;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Move a process to a memory group, the processes created by it
+ *        later are in the group too.
+ *
+ * @param pid is the process id, 0 for the current process.
+ *
+ * @param group is the group, RT_NULL for none.
+ *
+ * @return 0 on success, -1 if the process is not found.
+ */
+int lwp_mem_group_attach(pid_t pid, lwp_mem_group_t group)
+{
+    struct rt_lwp *lwp;
+    rt_base_t level;
+    int ret = -1;
+
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
+    if (lwp && !lwp->finish)
+    {
+        lwp_mem_group_inherit(lwp, group);
+        ret = 0;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+/**
+ * @brief Exempt a process from the OOM killer, such as a daemon the system
+ *        depends on. The init process is always exempt. The processes
+ *        created by it are not exempt.
+ *
+ * @param pid is the process id, 0 for the current process.
+ *
+ * @param exempt is RT_TRUE to exempt the process, RT_FALSE to clear it.
+ *
+ * @return 0 on success, -1 if the process is not found.
+ */
+int lwp_oom_exempt(pid_t pid, rt_bool_t exempt)
+{
+    struct rt_lwp *lwp;
+    rt_base_t level;
+    int ret = -1;
+
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
+    if (lwp && !lwp->finish)
+    {
+        lwp->oom_exempt = exempt ? 1 : 0;
+        ret = 0;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+/* the process with the most resident pages in the group, or in the system */
+static struct rt_lwp *_oom_victim(lwp_mem_group_t group)
+{
+    struct lwp_avl_struct *pids = lwp_get_pid_ary();
+    struct rt_lwp *victim = RT_NULL;
+    struct rt_lwp *lwp;
+    rt_size_t rss, max = 0;
+    int index;
+
+    for (index = 0; index < RT_LWP_MAX_NR; index++)
+    {
+        lwp = (struct rt_lwp *)pids[index].data;
+        if (!lwp || lwp->finish || !lwp->aspace)
+        {
+            continue;
+        }
+        /* killing init or a critical daemon takes the whole system down */
+        if (lwp_to_pid(lwp) == 1 || lwp->oom_exempt)
+        {
+            continue;
+        }
+        if (group && lwp->mgroup != group)
+        {
+            continue;
+        }
+
+        rss = lwp->aspace->rss;
+        if (rss > max)
+        {
+            max = rss;
+            victim = lwp;
+        }
+    }
+
+    return victim;
+}
+
+static pid_t _oom_kill(lwp_mem_group_t group, rt_aspace_t *aspace)
+{
+    struct rt_lwp *victim;
+    rt_base_t level;
+    rt_size_t rss = 0;
+    pid_t pid = 0;
+
+    level = rt_hw_interrupt_disable();
+    victim = _oom_victim(group);
+    if (victim)
+    {
+        pid = lwp_to_pid(victim);
+        rss = victim->aspace->rss;
+        *aspace = victim->aspace;
+        if (group)
+        {
+            group->nr_oom++;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (pid)
+    {
+        LOG_W("out of memory%s%.*s: kill pid %d, rss %d KB", group ? " in group " : "",
+              RT_NAME_MAX, group ? group->name : "", pid, (int)(rss << ARCH_PAGE_SHIFT >> 10));
+        lwp_kill(pid, SIGKILL);
+    }
+
+    return pid;
+}
+
+/**
+ * @brief Kill the process with the most resident pages.
+ *
+ * @param group is the memory group to choose the victim from, RT_NULL for
+ *        all the processes.
+ *
+ * @return the process id of the victim, 0 if there's no process to kill.
+ */
+pid_t lwp_oom_kill(lwp_mem_group_t group)
+{
+    rt_aspace_t aspace;
+
+    return _oom_kill(group, &aspace);
+}
+
+/**
+ * @brief Reclaim the memory by the OOM killer on a failure of page allocation
+ *        for an address space.
+ *
+ * @param aspace is the address space requesting the page.
+ *
+ * @return RT_EOK if another process is killed and the allocation can be tried
+ *         again, -RT_ENOMEM if not.
+ */
+rt_err_t lwp_oom_reclaim(rt_aspace_t aspace)
+{
+    rt_aspace_t victim = RT_NULL;
+
+    if (_oom_kill(RT_NULL, &victim) == 0 || victim == aspace)
+    {
+        return -RT_ENOMEM;
+    }
+
+    /* give the victim a chance to exit and free its pages */
+    rt_thread_mdelay(LWP_OOM_WAIT_MS);
+    return RT_EOK;
+}
+
+/**
+ * @brief Check the limit of the memory group before a page is charged to
+ *        an address space, the largest process of the group is killed if
+ *        the limit is reached.
+ *
+ * @param aspace is the address space requesting the page.
+ *
+ * @return RT_EOK if the page can be charged, -RT_ENOMEM if not.
+ */
+rt_err_t lwp_mem_charge(rt_aspace_t aspace)
+{
+    lwp_mem_group_t group;
+    rt_aspace_t victim;
+    int retry;
+
+    if (aspace->rss_group == RT_NULL)
+    {
+        return RT_EOK;
+    }
+
+    group = rt_container_of(aspace->rss_group, struct lwp_mem_group, usage);
+    for (retry = 0; group->limit && (rt_size_t)rt_atomic_load(&group->usage) >= group->limit; retry++)
+    {
+        /* the victim is the requester itself, or doesn't exit in time */
+        if (retry == 2 || _oom_kill(group, &victim) == 0 || victim == aspace)
+        {
+            return -RT_ENOMEM;
+        }
+        rt_thread_mdelay(LWP_OOM_WAIT_MS);
+    }
+
+    return RT_EOK;
+}
+
+static void _mgroup_list_show(void)
+{
+    rt_list_t *node;
+    lwp_mem_group_t group;
+    rt_base_t level;
+
+    rt_kprintf("%-*.s   usage(KB)   limit(KB)  oom\n", RT_NAME_MAX, "group");
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &_mgroup_list)
+    {
+        group = rt_list_entry(node, struct lwp_mem_group, list);
+        rt_kprintf("%-*.*s %11d %11d %4d\n", RT_NAME_MAX, RT_NAME_MAX, group->name,
+                   (int)((rt_size_t)rt_atomic_load(&group->usage) << ARCH_PAGE_SHIFT >> 10),
+                   (int)(group->limit << ARCH_PAGE_SHIFT >> 10), group->nr_oom);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static rt_size_t _kb_to_pages(const char *kb)
+{
+    return ((rt_size_t)atol(kb) << 10) >> ARCH_PAGE_SHIFT;
+}
+
+static void cmd_mem_group(int argc, char **argv)
+{
+    lwp_mem_group_t group = RT_NULL;
+
+    if (argc == 1)
+    {
+        _mgroup_list_show();
+        return;
+    }
+
+    if (argc >= 3)
+    {
+        group = lwp_mem_group_find(argv[2]);
+    }
+
+    if (argc >= 3 && !strcmp(argv[1], "create"))
+    {
+        if (lwp_mem_group_create(argv[2], argc > 3 ? _kb_to_pages(argv[3]) : 0) == RT_NULL)
+        {
+            rt_kprintf("failed to create group %s\n", argv[2]);
+        }
+    }
+    else if (argc >= 3 && group == RT_NULL)
+    {
+        rt_kprintf("group %s not found\n", argv[2]);
+    }
+    else if (argc == 3 && !strcmp(argv[1], "delete"))
+    {
+        if (lwp_mem_group_delete(group) != RT_EOK)
+        {
+            rt_kprintf("group %s is in use\n", argv[2]);
+        }
+    }
+    else if (argc == 4 && !strcmp(argv[1], "limit"))
+    {
+        lwp_mem_group_set_limit(group, _kb_to_pages(argv[3]));
+    }
+    else if (argc == 4 && !strcmp(argv[1], "attach"))
+    {
+        if (lwp_mem_group_attach((pid_t)atoi(argv[3]), group) != 0)
+        {
+            rt_kprintf("pid %s not found\n", argv[3]);
+        }
+    }
+    else
+    {
+        rt_kprintf("Usage: mem_group [create name [limit_kb] | delete name | limit name limit_kb | attach name pid]\n");
+    }
+}
+MSH_CMD_EXPORT_ALIAS(cmd_mem_group, mem_group, manage the memory groups of processes);
+
+static void cmd_oom_exempt(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        rt_kprintf("Usage: oom_exempt pid [0|1]\n");
+        return;
+    }
+
+    if (lwp_oom_exempt((pid_t)atoi(argv[1]), argc == 2 || atoi(argv[2]) != 0) != 0)
+    {
+        rt_kprintf("pid %s not found\n", argv[1]);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(cmd_oom_exempt, oom_exempt, exempt a process from the OOM killer);
+#endif /* LWP_USING_MEM_GROUP */
+
+static void _lwp_mem_show(struct rt_lwp *lwp)
+{
+    struct lwp_mem_stat stat;
+    int i;
+    static const char *const names[] = {"data", "nofile", "as"};
+    static const int resources[] = {LWP_RLIMIT_DATA, LWP_RLIMIT_NOFILE, LWP_RLIMIT_AS};
+
+    lwp_mem_stat_get(lwp, &stat);
+    rt_kprintf("Name:    %.*s\n", RT_NAME_MAX, lwp->cmd);
+    rt_kprintf("Pid:     %d\n", lwp_to_pid(lwp));
+    rt_kprintf("VmSize:  %d kB\n", (int)(stat.vsz >> 10));
+    rt_kprintf("VmRSS:   %d kB\n", (int)(stat.rss >> 10));
+    rt_kprintf("VmHeap:  %d kB\n", (int)(stat.heap >> 10));
+#ifdef LWP_USING_MEM_GROUP
+    rt_kprintf("Group:   %.*s\n", RT_NAME_MAX, lwp->mgroup ? lwp->mgroup->name : "-");
+#endif
+
+    for (i = 0; i < sizeof(resources) / sizeof(resources[0]); i++)
+    {
+        struct lwp_rlimit *rlim = &lwp->rlim[resources[i]];
+
+        rt_kprintf("Limit %-7s", names[i]);
+        if (rlim->rlim_cur == LWP_RLIM_INFINITY)
+            rt_kprintf(" unlimited");
+        else
+            rt_kprintf(" %lu", (unsigned long)rlim->rlim_cur);
+        if (rlim->rlim_max == LWP_RLIM_INFINITY)
+            rt_kprintf(" unlimited\n");
+        else
+            rt_kprintf(" %lu\n", (unsigned long)rlim->rlim_max);
+    }
+}
+
+static void cmd_lwp_mem(int argc, char **argv)
+{
+    struct rt_lwp *lwp;
+    rt_base_t level;
+
+    if (argc != 2)
+    {
+        rt_kprintf("Usage: lwp_mem pid\n");
+        return;
+    }
+
+    level = rt_hw_interrupt_disable();
+    lwp = lwp_from_pid((pid_t)atoi(argv[1]));
+    if (lwp)
+    {
+        _lwp_mem_show(lwp);
+    }
+    else
+    {
+        rt_kprintf("pid %s not found\n", argv[1]);
+    }
+    rt_hw_interrupt_enable(level);
+}
+MSH_CMD_EXPORT_ALIAS(cmd_lwp_mem, lwp_mem, show the memory usage and limits of a process);
+
+#endif /* ARCH_MM_MMU */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+#ifndef  __LWP_MEM_H__
+#define  __LWP_MEM_H__
+
+#include <rtthread.h>
+#include <mm_aspace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rt_lwp;
+
+/* the memory usage of a process */
+struct lwp_mem_stat
+{
+    rt_size_t vsz;          /* bytes of the address space mapped */
+    rt_size_t rss;          /* bytes of the page frames resident */
+    rt_size_t heap;         /* bytes of the heap grown by brk */
+};
+
+void lwp_mem_stat_get(struct rt_lwp *lwp, struct lwp_mem_stat *stat);
+rt_err_t lwp_mem_as_check(struct rt_lwp *lwp, rt_size_t size);
+rt_err_t lwp_mem_data_check(struct rt_lwp *lwp, rt_size_t size);
+
+#ifdef LWP_USING_MEM_GROUP
+struct lwp_mem_group
+{
+    char name[RT_NAME_MAX];
+    rt_atomic_t usage;      /* pages charged by the processes of the group */
+    rt_size_t limit;        /* pages, 0 for no limit */
+    rt_uint32_t nr_oom;     /* times of the OOM killer run for the group */
+
+    int ref;
+    rt_list_t list;
+};
+typedef struct lwp_mem_group *lwp_mem_group_t;
+
+lwp_mem_group_t lwp_mem_group_create(const char *name, rt_size_t limit);
+rt_err_t lwp_mem_group_delete(lwp_mem_group_t group);
+lwp_mem_group_t lwp_mem_group_find(const char *name);
+rt_err_t lwp_mem_group_set_limit(lwp_mem_group_t group, rt_size_t limit);
+int lwp_mem_group_attach(pid_t pid, lwp_mem_group_t group);
+void lwp_mem_group_inherit(struct rt_lwp *lwp, lwp_mem_group_t group);
+void lwp_mem_group_release(struct rt_lwp *lwp);
+
+int lwp_oom_exempt(pid_t pid, rt_bool_t exempt);
+pid_t lwp_oom_kill(lwp_mem_group_t group);
+rt_err_t lwp_oom_reclaim(rt_aspace_t aspace);
+rt_err_t lwp_mem_charge(rt_aspace_t aspace);
+#endif /* LWP_USING_MEM_GROUP */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /*__LWP_MEM_H__*/
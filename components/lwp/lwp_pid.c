@@ -306,6 +306,24 @@ void lwp_user_object_dup(struct rt_lwp *dst_lwp, struct rt_lwp *src_lwp)
     lwp_user_object_unlock(src_lwp);
 }
 
+/**
+ * @brief Set the resource limits of a new process to the defaults.
+ *
+ * @param lwp is the process.
+ */
+void lwp_rlimit_init(struct rt_lwp *lwp)
+{
+    int i;
+
+    for (i = 0; i < LWP_RLIMIT_NR; i++)
+    {
+        lwp->rlim[i].rlim_cur = LWP_RLIM_INFINITY;
+        lwp->rlim[i].rlim_max = LWP_RLIM_INFINITY;
+    }
+    lwp->rlim[LWP_RLIMIT_NOFILE].rlim_cur = DFS_FD_MAX;
+    lwp->rlim[LWP_RLIMIT_NOFILE].rlim_max = DFS_FD_MAX;
+}
+
 struct rt_lwp* lwp_new(void)
 {
     pid_t pid;
@@ -328,6 +346,10 @@ struct rt_lwp* lwp_new(void)
     lwp->address_search_head = RT_NULL;
     rt_wqueue_init(&lwp->wait_queue);
     lwp->ref = 1;
+#ifdef RT_USING_SMP
+    lwp->cpu_affinity = RT_CPU_MASK;
+#endif
+    lwp_rlimit_init(lwp);
 
     level = rt_hw_interrupt_disable();
     pid = lwp_pid_get();
@@ -389,6 +411,11 @@ void lwp_free(struct rt_lwp* lwp)
     lwp_user_object_clear(lwp);
     lwp_user_object_lock_destroy(lwp);
 
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_put(lwp->sgroup);
+    lwp->sgroup = RT_NULL;
+#endif
+
     /* free data section */
     if (lwp->data_entry != RT_NULL)
     {
@@ -421,6 +448,9 @@ void lwp_free(struct rt_lwp* lwp)
 #ifdef ARCH_MM_MMU
     lwp_unmap_user_space(lwp);
 #endif
+#ifdef LWP_USING_MEM_GROUP
+    lwp_mem_group_release(lwp);
+#endif
 
     level = rt_hw_interrupt_disable();
     /* for children */
@@ -674,6 +704,10 @@ pid_t waitpid(pid_t pid, int *status, int options)
     {
         struct rt_lwp **lwp_node;
 
+#ifdef RT_USING_CPU_USAGE
+        lwp_self->cutime += lwp->utime + lwp->cutime;
+        lwp_self->cstime += lwp->stime + lwp->cstime;
+#endif
         *status = lwp->lwp_ret;
         lwp_node = &lwp_self->first_child;
         while (*lwp_node != lwp)
@@ -692,6 +726,56 @@ quit:
     return ret;
 }
 
+#ifdef RT_USING_CPU_USAGE
+/* accumulate the cpu time of an exiting thread into its process */
+void lwp_cpu_time_collect(struct rt_lwp *lwp, rt_thread_t thread)
+{
+    rt_base_t level;
+    rt_uint64_t utime, stime;
+
+    rt_thread_cpu_time(thread, &utime, &stime);
+
+    level = rt_hw_interrupt_disable();
+    lwp->utime += utime;
+    lwp->stime += stime;
+    rt_hw_interrupt_enable(level);
+}
+
+void lwp_cpu_time(struct rt_lwp *lwp, rt_uint64_t *utime, rt_uint64_t *stime)
+{
+    rt_base_t level;
+    rt_list_t *list;
+    rt_uint64_t user, system;
+
+    level = rt_hw_interrupt_disable();
+    user = lwp->utime;
+    system = lwp->stime;
+    rt_list_for_each(list, &lwp->t_grp)
+    {
+        rt_uint64_t thread_utime, thread_stime;
+        rt_thread_t thread = rt_list_entry(list, struct rt_thread, sibling);
+
+        rt_thread_cpu_time(thread, &thread_utime, &thread_stime);
+        user += thread_utime;
+        system += thread_stime;
+    }
+    rt_hw_interrupt_enable(level);
+
+    *utime = user;
+    *stime = system;
+}
+
+void lwp_children_cpu_time(struct rt_lwp *lwp, rt_uint64_t *utime, rt_uint64_t *stime)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    *utime = lwp->cutime;
+    *stime = lwp->cstime;
+    rt_hw_interrupt_enable(level);
+}
+#endif /* RT_USING_CPU_USAGE */
+
 #ifdef RT_USING_FINSH
 /* copy from components/finsh/cmd.c */
 static void object_split(int len)
@@ -822,6 +906,24 @@ long list_process(void)
             }
         }
     }
+
+#ifdef ARCH_MM_MMU
+    rt_kprintf("\n%-*.s %-*.s    vsz(KB)    rss(KB)   heap(KB)\n", 4, "PID", maxlen, "CMD");
+    object_split(4);rt_kprintf(" ");object_split(maxlen);rt_kprintf(" ");
+    rt_kprintf(                  "---------- ---------- ----------\n");
+    for (index = 0; index < RT_LWP_MAX_NR; index++)
+    {
+        struct rt_lwp *lwp = (struct rt_lwp *)lwp_pid_ary[index].data;
+        struct lwp_mem_stat stat;
+
+        if (lwp && !lwp->finish)
+        {
+            lwp_mem_stat_get(lwp, &stat);
+            rt_kprintf("%4d %-*.*s %10d %10d %10d\n", lwp_to_pid(lwp), maxlen, RT_NAME_MAX, lwp->cmd,
+                       (int)(stat.vsz >> 10), (int)(stat.rss >> 10), (int)(stat.heap >> 10));
+        }
+    }
+#endif /* ARCH_MM_MMU */
     return 0;
 }
 MSH_CMD_EXPORT(list_process, list process);
@@ -1062,24 +1164,24 @@ void lwp_wait_subthread_exit(void)
     }
 }
 
-static int _lwp_setaffinity(pid_t pid, int cpu)
+static int _lwp_setaffinity(pid_t pid, rt_ubase_t cpu_affinity)
 {
     struct rt_lwp *lwp;
     int ret = -1;
 
-    lwp = lwp_from_pid(pid);
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
     if (lwp)
     {
 #ifdef RT_USING_SMP
         rt_list_t *list;
 
-        lwp->bind_cpu = cpu;
+        lwp->cpu_affinity = cpu_affinity;
         for (list = lwp->t_grp.next; list != &lwp->t_grp; list = list->next)
         {
             rt_thread_t thread;
 
             thread = rt_list_entry(list, struct rt_thread, sibling);
-            rt_thread_control(thread, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_size_t)cpu);
+            rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)cpu_affinity);
         }
 #endif
         ret = 0;
@@ -1087,23 +1189,168 @@ static int _lwp_setaffinity(pid_t pid, int cpu)
     return ret;
 }
 
-int lwp_setaffinity(pid_t pid, int cpu)
+/**
+ * @brief Set the mask of cpus the threads of a process could run on, the
+ *        threads created by the process later inherit it.
+ *
+ * @param pid is the process id, 0 for the current process.
+ *
+ * @param cpu_affinity is the cpu mask, bit n for the cpu n.
+ *
+ * @return 0 on success, -1 if the process is not found or the mask has no
+ *         cpu available.
+ */
+int lwp_set_cpu_affinity(pid_t pid, rt_ubase_t cpu_affinity)
 {
     rt_base_t level;
     int ret;
 
 #ifdef RT_USING_SMP
-    if (cpu < 0 || cpu > RT_CPUS_NR)
+    cpu_affinity &= RT_CPU_MASK;
+    if (cpu_affinity == 0)
     {
-        cpu = RT_CPUS_NR;
+        return -1;
     }
 #endif
     level = rt_hw_interrupt_disable();
-    ret = _lwp_setaffinity(pid, cpu);
+    ret = _lwp_setaffinity(pid, cpu_affinity);
     rt_hw_interrupt_enable(level);
     return ret;
 }
 
+/**
+ * @brief Get the mask of cpus the threads of a process could run on.
+ *
+ * @param pid is the process id, 0 for the current process.
+ *
+ * @param cpu_affinity is the cpu mask returned.
+ *
+ * @return 0 on success, -1 if the process is not found.
+ */
+int lwp_get_cpu_affinity(pid_t pid, rt_ubase_t *cpu_affinity)
+{
+    struct rt_lwp *lwp;
+    rt_base_t level;
+    int ret = -1;
+
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
+    if (lwp)
+    {
+#ifdef RT_USING_SMP
+        *cpu_affinity = lwp->cpu_affinity;
+#else
+        *cpu_affinity = 1;
+#endif
+        ret = 0;
+    }
+    rt_hw_interrupt_enable(level);
+    return ret;
+}
+
+int lwp_setaffinity(pid_t pid, int cpu)
+{
+#ifdef RT_USING_SMP
+    if (cpu >= 0 && cpu < RT_CPUS_NR)
+    {
+        return lwp_set_cpu_affinity(pid, 1UL << cpu);
+    }
+    return lwp_set_cpu_affinity(pid, RT_CPU_MASK);
+#else
+    return lwp_set_cpu_affinity(pid, 1);
+#endif
+}
+
+#ifdef RT_USING_SCHED_GROUP
+/**
+ * @brief Move a process to a scheduling group, the threads of the process
+ *        and the threads and processes created by it later are in the group.
+ *
+ * @param pid is the process id, 0 for the current process.
+ *
+ * @param group is the scheduling group, RT_NULL for the kernel group.
+ *
+ * @return 0 on success, -1 if the process is not found.
+ */
+int lwp_sched_group_attach(pid_t pid, rt_sched_group_t group)
+{
+    struct rt_lwp *lwp;
+    struct rt_sched_group *old;
+    rt_list_t *list;
+    rt_base_t level;
+    int ret = -1;
+
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
+    if (lwp)
+    {
+        old = lwp->sgroup;
+        lwp->sgroup = rt_sched_group_get(group);
+        rt_sched_group_put(old);
+
+        for (list = lwp->t_grp.next; list != &lwp->t_grp; list = list->next)
+        {
+            rt_thread_t thread;
+
+            thread = rt_list_entry(list, struct rt_thread, sibling);
+            rt_sched_group_attach(group, thread);
+        }
+        ret = 0;
+    }
+    rt_hw_interrupt_enable(level);
+    return ret;
+}
+
+static void cmd_sched_group(int argc, char** argv)
+{
+    int pid, ret;
+    struct rt_lwp *lwp;
+    rt_sched_group_t group;
+    rt_base_t level;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Useage: sched_group pid [group]\n");
+        return;
+    }
+
+    pid = atoi(argv[1]);
+    if (argc > 2)
+    {
+        /* the reference keeps the group from being deleted */
+        level = rt_hw_interrupt_disable();
+        group = rt_sched_group_get(rt_sched_group_find(argv[2]));
+        rt_hw_interrupt_enable(level);
+        if (group == RT_NULL)
+        {
+            rt_kprintf("group %s not found\n", argv[2]);
+            return;
+        }
+        ret = lwp_sched_group_attach((pid_t)pid, group);
+        rt_sched_group_put(group);
+        if (ret != 0)
+        {
+            rt_kprintf("pid %d not found\n", pid);
+            return;
+        }
+    }
+
+    level = rt_hw_interrupt_disable();
+    lwp = lwp_from_pid((pid_t)pid);
+    if (lwp)
+    {
+        rt_kprintf("pid %d scheduling group: %.*s\n", pid, RT_NAME_MAX,
+                   lwp->sgroup ? lwp->sgroup->name : "kernel");
+    }
+    else
+    {
+        rt_kprintf("pid %d not found\n", pid);
+    }
+    rt_hw_interrupt_enable(level);
+}
+MSH_CMD_EXPORT_ALIAS(cmd_sched_group, sched_group, show or set the scheduling group of a process);
+#endif /* RT_USING_SCHED_GROUP */
+
 #ifdef RT_USING_SMP
 static void cmd_cpu_bind(int argc, char** argv)
 {
@@ -1121,4 +1368,37 @@ static void cmd_cpu_bind(int argc, char** argv)
     lwp_setaffinity((pid_t)pid, cpu);
 }
 MSH_CMD_EXPORT_ALIAS(cmd_cpu_bind, cpu_bind, set a process bind to a cpu);
+
+static void cmd_cpu_affinity(int argc, char** argv)
+{
+    int pid;
+    rt_ubase_t cpu_affinity;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Useage: cpu_affinity pid [mask]\n");
+        return;
+    }
+
+    pid = atoi(argv[1]);
+    if (argc > 2)
+    {
+        cpu_affinity = strtoul(argv[2], RT_NULL, 16);
+        if (lwp_set_cpu_affinity((pid_t)pid, cpu_affinity) != 0)
+        {
+            rt_kprintf("set affinity of pid %d to 0x%lx failed\n", pid, cpu_affinity);
+            return;
+        }
+    }
+
+    if (lwp_get_cpu_affinity((pid_t)pid, &cpu_affinity) == 0)
+    {
+        rt_kprintf("pid %d affinity mask: 0x%lx\n", pid, cpu_affinity);
+    }
+    else
+    {
+        rt_kprintf("pid %d not found\n", pid);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(cmd_cpu_affinity, cpu_affinity, show or set the cpu affinity mask of a process);
 #endif
@@ -21,6 +21,7 @@ struct lwp_avl_struct *lwp_get_pid_ary(void);
 
 struct rt_lwp* lwp_new(void);
 void lwp_free(struct rt_lwp* lwp);
+void lwp_rlimit_init(struct rt_lwp *lwp);
 
 int lwp_ref_inc(struct rt_lwp *lwp);
 int lwp_ref_dec(struct rt_lwp *lwp);
@@ -45,6 +46,12 @@ rt_err_t lwp_user_object_delete(struct rt_lwp *lwp, rt_object_t object);
 void lwp_user_object_clear(struct rt_lwp *lwp);
 void lwp_user_object_dup(struct rt_lwp *dst_lwp, struct rt_lwp *src_lwp);
 
+#ifdef RT_USING_CPU_USAGE
+void lwp_cpu_time_collect(struct rt_lwp *lwp, rt_thread_t thread);
+void lwp_cpu_time(struct rt_lwp *lwp, rt_uint64_t *utime, rt_uint64_t *stime);
+void lwp_children_cpu_time(struct rt_lwp *lwp, rt_uint64_t *utime, rt_uint64_t *stime);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef ARCH_MM_MMU
+#include <lwp.h>
+#include <lwp_shm.h>
+#include <lwp_ring.h>
+
+#include <fcntl.h>
+
+static int _ring_channel_open(const char *prefix, const char *name, int flags)
+{
+    char ch_name[RT_NAME_MAX];
+
+    /* the name is truncated at the end, the prefix keeps the doorbells different */
+    rt_snprintf(ch_name, sizeof(ch_name), "%s%s", prefix, name);
+
+    return rt_channel_open(ch_name, flags);
+}
+
+/**
+ * @brief Open a ring channel in the kernel, the shared memory and the
+ *        doorbells are the same as the ones the processes attach.
+ *
+ * @param ring is the ring to initialize.
+ *
+ * @param name is the name of the ring.
+ *
+ * @param size is the size of the shared memory, it is rounded up to pages.
+ *
+ * @param slot_size is the maximum payload of a slot.
+ *
+ * @param flags is O_CREAT to create the ring if it does not exist.
+ *
+ * @return RT_EOK on success, -RT_ENOMEM if it fails to allocate, -RT_EINVAL
+ *         if the ring is not formatted or the size is too small.
+ */
+rt_err_t lwp_ring_open(struct lwp_ring *ring, const char *name, rt_size_t size, rt_size_t slot_size, int flags)
+{
+    int id;
+    void *mem;
+    rt_err_t err;
+    int create = (flags & O_CREAT) ? 1 : 0;
+
+    id = lwp_shmget(lwp_ring_key(name), size, create);
+    if (id < 0)
+    {
+        return -RT_ENOMEM;
+    }
+
+    mem = lwp_shminfo(id);
+    if (mem == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    if (create && ((struct lwp_ring_hdr *)mem)->magic != LWP_RING_MAGIC)
+    {
+        if (lwp_ring_format(mem, size, slot_size) == 0)
+        {
+            lwp_shmrm(id);
+            return -RT_EINVAL;
+        }
+    }
+
+    ring->data_fd = _ring_channel_open(LWP_RING_DATA_PREFIX, name, O_CREAT);
+    ring->space_fd = _ring_channel_open(LWP_RING_SPACE_PREFIX, name, O_CREAT);
+    ring->shm_id = id;
+
+    err = lwp_ring_attach(ring, mem, ring->data_fd, ring->space_fd);
+    if (ring->data_fd < 0 || ring->space_fd < 0)
+    {
+        err = -RT_ENOMEM;
+    }
+
+    if (err != RT_EOK)
+    {
+        lwp_ring_close(ring);
+    }
+
+    return err;
+}
+
+/**
+ * @brief Close a ring channel opened by lwp_ring_open(), the shared memory
+ *        is kept until lwp_ring_unlink().
+ */
+rt_err_t lwp_ring_close(struct lwp_ring *ring)
+{
+    if (ring->data_fd >= 0)
+    {
+        rt_channel_close(ring->data_fd);
+        ring->data_fd = -1;
+    }
+    if (ring->space_fd >= 0)
+    {
+        rt_channel_close(ring->space_fd);
+        ring->space_fd = -1;
+    }
+    ring->hdr = RT_NULL;
+    ring->slots = RT_NULL;
+
+    return RT_EOK;
+}
+
+/**
+ * @brief Release the shared memory of a ring, it is kept if any process
+ *        still maps it.
+ */
+rt_err_t lwp_ring_unlink(const char *name)
+{
+    int id;
+
+    id = lwp_shmget(lwp_ring_key(name), 0, 0);
+    if (id < 0)
+    {
+        return -RT_ENOENT;
+    }
+
+    return lwp_shmrm(id) == 0 ? RT_EOK : -RT_ERROR;
+}
+
+#endif /* ARCH_MM_MMU */
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The ring channel: a single-producer single-consumer ring of fixed-size
+ * slots in a shared memory. The slots are filled and read in place, and the
+ * indexes are updated without syscalls. A channel message is sent as the
+ * doorbell only when the peer is idle on the ring.
+ *
+ * The layout and the operations in this file do not depend on the kernel, so
+ * it is shared by the kernel and the user space. A process attaches a ring
+ * named "name" with the existing syscalls:
+ *
+ *   id = shmget(lwp_ring_key("name"), size, 1);
+ *   mem = shmat(id, NULL);
+ *   data_fd = channel_open(LWP_RING_DATA_PREFIX "name", O_CREAT);
+ *   space_fd = channel_open(LWP_RING_SPACE_PREFIX "name", O_CREAT);
+ *   lwp_ring_format(mem, size, slot_size);      (only by the creator)
+ *   lwp_ring_attach(&ring, mem, data_fd, space_fd);
+ *
+ * The kernel threads could use lwp_ring_open() instead.
+ */
+
+#ifndef LWP_RING_H__
+#define LWP_RING_H__
+
+#include <rtthread.h>
+#include <lwp_ipc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LWP_RING_MAGIC          0x474e4952  /* "RING" */
+#define LWP_RING_CACHE_LINE     64
+
+#define LWP_RING_DATA_PREFIX    "d."        /* the doorbell of the consumer */
+#define LWP_RING_SPACE_PREFIX   "s."        /* the doorbell of the producer */
+
+/* the shared header of a ring, the indexes are free running */
+struct lwp_ring_hdr
+{
+    rt_uint32_t magic;
+    rt_uint32_t slot_nr;                    /* power of 2 */
+    rt_uint32_t slot_size;                  /* the maximum payload of a slot */
+    rt_uint32_t slot_stride;                /* the distance between slots */
+    rt_uint8_t  reserved0[LWP_RING_CACHE_LINE - 16];
+
+    /* written by the producer */
+    rt_uint32_t head;                       /* the next slot to produce */
+    rt_uint32_t producer_idle;              /* the producer waits for free slots */
+    rt_uint8_t  reserved1[LWP_RING_CACHE_LINE - 8];
+
+    /* written by the consumer */
+    rt_uint32_t tail;                       /* the next slot to consume */
+    rt_uint32_t consumer_idle;              /* the consumer waits for data */
+    rt_uint8_t  reserved2[LWP_RING_CACHE_LINE - 8];
+};
+
+struct lwp_ring_slot
+{
+    rt_uint32_t length;                     /* the length of the payload */
+    rt_uint32_t reserved;
+    rt_uint8_t  data[];
+};
+
+/* the view of a ring in a process */
+struct lwp_ring
+{
+    struct lwp_ring_hdr *hdr;
+    rt_uint8_t *slots;
+    int data_fd;
+    int space_fd;
+    int shm_id;
+};
+typedef struct lwp_ring *lwp_ring_t;
+
+/* the shared memory key of the ring name, FNV-1a */
+rt_inline rt_size_t lwp_ring_key(const char *name)
+{
+    rt_uint32_t hash = 0x811c9dc5;
+
+    while (*name)
+    {
+        hash ^= (rt_uint8_t)*name++;
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Format a shared memory as a ring.
+ *
+ * @param mem is the shared memory.
+ *
+ * @param size is the size of the shared memory.
+ *
+ * @param slot_size is the maximum payload of a slot.
+ *
+ * @return the number of the slots, or 0 if the memory is too small.
+ */
+rt_inline rt_uint32_t lwp_ring_format(void *mem, rt_size_t size, rt_size_t slot_size)
+{
+    struct lwp_ring_hdr *hdr = (struct lwp_ring_hdr *)mem;
+    rt_uint32_t stride, slot_nr;
+
+    stride = RT_ALIGN(sizeof(struct lwp_ring_slot) + slot_size, LWP_RING_CACHE_LINE);
+    if (size <= sizeof(*hdr) || slot_size == 0)
+    {
+        return 0;
+    }
+
+    slot_nr = (size - sizeof(*hdr)) / stride;
+    while (slot_nr & (slot_nr - 1))
+    {
+        slot_nr &= slot_nr - 1;
+    }
+    if (slot_nr == 0)
+    {
+        return 0;
+    }
+
+    hdr->magic = 0;
+    hdr->slot_nr = slot_nr;
+    hdr->slot_size = slot_size;
+    hdr->slot_stride = stride;
+    hdr->head = 0;
+    hdr->producer_idle = 0;
+    hdr->tail = 0;
+    hdr->consumer_idle = 0;
+    __atomic_store_n(&hdr->magic, LWP_RING_MAGIC, __ATOMIC_RELEASE);
+
+    return slot_nr;
+}
+
+rt_inline rt_err_t lwp_ring_attach(struct lwp_ring *ring, void *mem, int data_fd, int space_fd)
+{
+    struct lwp_ring_hdr *hdr = (struct lwp_ring_hdr *)mem;
+
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != LWP_RING_MAGIC)
+    {
+        return -RT_EINVAL;
+    }
+
+    ring->hdr = hdr;
+    ring->slots = (rt_uint8_t *)mem + sizeof(*hdr);
+    ring->data_fd = data_fd;
+    ring->space_fd = space_fd;
+
+    return RT_EOK;
+}
+
+rt_inline struct lwp_ring_slot *lwp_ring_slot(struct lwp_ring *ring, rt_uint32_t index)
+{
+    return (struct lwp_ring_slot *)(ring->slots + (index & (ring->hdr->slot_nr - 1)) * ring->hdr->slot_stride);
+}
+
+/* ring the doorbell if the peer is idle */
+rt_inline void lwp_ring_doorbell(rt_uint32_t *idle, int fd)
+{
+    struct rt_channel_msg msg;
+
+    /* pairs with the fence in lwp_ring_idle_wait() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(idle, __ATOMIC_RELAXED) && __atomic_exchange_n(idle, 0, __ATOMIC_ACQ_REL))
+    {
+        msg.type = RT_CHANNEL_RAW;
+        msg.u.d = RT_NULL;
+        rt_channel_send(fd, &msg);
+    }
+}
+
+/* wait for the doorbell until the ring is not empty (or not full) */
+rt_inline rt_err_t lwp_ring_idle_wait(struct lwp_ring *ring, rt_uint32_t *idle, int fd,
+        rt_bool_t for_space, rt_int32_t timeout)
+{
+    struct rt_channel_msg msg;
+    struct lwp_ring_hdr *hdr = ring->hdr;
+    rt_uint32_t used;
+    rt_err_t err = RT_EOK;
+
+    for (;;)
+    {
+        used = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+        if (for_space ? used < hdr->slot_nr : used != 0)
+        {
+            break;
+        }
+
+        __atomic_store_n(idle, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        used = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+        if (for_space ? used < hdr->slot_nr : used != 0)
+        {
+            /* the peer has taken the idle flag, eat its doorbell to keep them paired */
+            if (__atomic_exchange_n(idle, 0, __ATOMIC_ACQ_REL) == 0)
+            {
+                rt_channel_recv(fd, &msg);
+            }
+            break;
+        }
+
+        err = rt_channel_recv_timeout(fd, &msg, timeout);
+        if (err != RT_EOK)
+        {
+            if (__atomic_exchange_n(idle, 0, __ATOMIC_ACQ_REL) == 0)
+            {
+                rt_channel_recv(fd, &msg);
+            }
+            break;
+        }
+    }
+
+    return err;
+}
+
+/**
+ * @brief Get the next free slot to fill in place.
+ *
+ * @return the payload of the slot, or RT_NULL if the ring is full.
+ */
+rt_inline void *lwp_ring_produce_prepare(struct lwp_ring *ring)
+{
+    struct lwp_ring_hdr *hdr = ring->hdr;
+    rt_uint32_t head = hdr->head;
+
+    if (head - __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE) >= hdr->slot_nr)
+    {
+        return RT_NULL;
+    }
+
+    return lwp_ring_slot(ring, head)->data;
+}
+
+/**
+ * @brief Publish the slot got by lwp_ring_produce_prepare() to the consumer.
+ *
+ * @param length is the length of the payload in the slot.
+ */
+rt_inline void lwp_ring_produce_commit(struct lwp_ring *ring, rt_uint32_t length)
+{
+    struct lwp_ring_hdr *hdr = ring->hdr;
+    rt_uint32_t head = hdr->head;
+
+    lwp_ring_slot(ring, head)->length = length;
+    __atomic_store_n(&hdr->head, head + 1, __ATOMIC_RELEASE);
+
+    lwp_ring_doorbell(&hdr->consumer_idle, ring->data_fd);
+}
+
+/**
+ * @brief Get the next slot to read in place.
+ *
+ * @param length is used to return the length of the payload.
+ *
+ * @return the payload of the slot, or RT_NULL if the ring is empty.
+ */
+rt_inline void *lwp_ring_consume_peek(struct lwp_ring *ring, rt_uint32_t *length)
+{
+    struct lwp_ring_hdr *hdr = ring->hdr;
+    rt_uint32_t tail = hdr->tail;
+    struct lwp_ring_slot *slot;
+
+    if (__atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return RT_NULL;
+    }
+
+    slot = lwp_ring_slot(ring, tail);
+    if (length)
+    {
+        *length = slot->length;
+    }
+
+    return slot->data;
+}
+
+/**
+ * @brief Give the slot got by lwp_ring_consume_peek() back to the producer.
+ */
+rt_inline void lwp_ring_consume_release(struct lwp_ring *ring)
+{
+    struct lwp_ring_hdr *hdr = ring->hdr;
+
+    __atomic_store_n(&hdr->tail, hdr->tail + 1, __ATOMIC_RELEASE);
+
+    lwp_ring_doorbell(&hdr->producer_idle, ring->space_fd);
+}
+
+/* wait until there is a free slot */
+rt_inline rt_err_t lwp_ring_produce_wait(struct lwp_ring *ring, rt_int32_t timeout)
+{
+    return lwp_ring_idle_wait(ring, &ring->hdr->producer_idle, ring->space_fd, RT_TRUE, timeout);
+}
+
+/* wait until there is a slot to consume */
+rt_inline rt_err_t lwp_ring_consume_wait(struct lwp_ring *ring, rt_int32_t timeout)
+{
+    return lwp_ring_idle_wait(ring, &ring->hdr->consumer_idle, ring->data_fd, RT_FALSE, timeout);
+}
+
+rt_err_t lwp_ring_open(struct lwp_ring *ring, const char *name, rt_size_t size, rt_size_t slot_size, int flags);
+rt_err_t lwp_ring_close(struct lwp_ring *ring);
+rt_err_t lwp_ring_unlink(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWP_RING_H__ */
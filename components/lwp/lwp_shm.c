@@ -41,11 +41,15 @@ static const char *get_shm_name(rt_varea_t varea)
     return "user.shm";
 }
 
+/* varea->data is set if the pages are charged to the address space */
+#define SHM_PAGES_CHARGED   ((void *)1)
+
 static void on_shm_varea_open(struct rt_varea *varea)
 {
     struct lwp_shm_struct *shm;
     shm = rt_container_of(varea->mem_obj, struct lwp_shm_struct, mem_obj);
     shm->ref += 1;
+    varea->data = RT_NULL;
 }
 
 static void on_shm_varea_close(struct rt_varea *varea)
@@ -53,6 +57,12 @@ static void on_shm_varea_close(struct rt_varea *varea)
     struct lwp_shm_struct *shm;
     shm = rt_container_of(varea->mem_obj, struct lwp_shm_struct, mem_obj);
     shm->ref -= 1;
+
+    if (varea->data == SHM_PAGES_CHARGED)
+    {
+        rt_aspace_rss_uncharge(varea->aspace, shm->size >> ARCH_PAGE_SHIFT);
+        varea->data = RT_NULL;
+    }
 }
 
 static void on_shm_page_fault(struct rt_varea *varea, struct rt_aspace_fault_msg *msg)
@@ -71,6 +81,12 @@ static void on_shm_page_fault(struct rt_varea *varea, struct rt_aspace_fault_msg
         msg->response.status = MM_FAULT_STATUS_OK_MAPPED;
         msg->response.size = shm->size;
         msg->response.vaddr = page;
+
+        if (varea->data != SHM_PAGES_CHARGED)
+        {
+            rt_aspace_rss_charge(varea->aspace, shm->size >> ARCH_PAGE_SHIFT);
+            varea->data = SHM_PAGES_CHARGED;
+        }
     }
 
     return ;
@@ -287,7 +303,7 @@ static void *_lwp_shmat(int id, void *shm_vaddr)
 
     /* map the shared memory into the address space of the current thread */
     lwp = lwp_self();
-    if (!lwp)
+    if (!lwp || lwp_mem_as_check(lwp, p->size) != RT_EOK)
     {
         return RT_NULL;
     }
@@ -427,7 +443,7 @@ void *_lwp_shminfo(int id)
     }
     p = (struct lwp_shm_struct *)node_key->data; /* p = _shm_ary[id]; */
 
-    return (void *)((char *)p->addr - PV_OFFSET);     /* get the virtual address */
+    return (void *)p->addr;     /* get the virtual address */
 }
 
 /* A wrapping function: get the virtual address of a shared memory. */
@@ -11,6 +11,7 @@
  * 2021-02-12     lizhirui     add 64-bit support for sys_brk
  * 2021-02-20     lizhirui     fix some warnings
  * 2023-03-13     WangXiaoyao  Format & fix syscall return value
+ * 2023-10-18     RT-Thread    Pass the whole sockaddr_un of AF_UNIX
  */
 #define _GNU_SOURCE
 /* RT-Thread System call */
@@ -76,6 +77,23 @@
 #include "lwp_ipc_internal.h"
 #include <sched.h>
 
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE  6
+#endif
+
+/* the attributes of sched_setattr, compatible with linux */
+struct sched_attr
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;     /* in nanoseconds */
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
 #ifndef GRND_NONBLOCK
 #define GRND_NONBLOCK   0x0001
 #endif /* GRND_NONBLOCK */
@@ -1369,7 +1387,7 @@ rt_thread_t sys_thread_create(void *arg[])
     }
 
 #ifdef RT_USING_SMP
-    thread->bind_cpu = lwp->bind_cpu;
+    rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)lwp->cpu_affinity);
 #endif
     thread->cleanup = lwp_cleanup;
     thread->user_entry = (void (*)(void *))arg[1];
@@ -1421,6 +1439,9 @@ rt_thread_t sys_thread_create(void *arg[])
 
     level = rt_hw_interrupt_disable();
     rt_list_insert_after(&lwp->t_grp, &thread->sibling);
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_attach(lwp->sgroup, thread);
+#endif
     rt_hw_interrupt_enable(level);
 
     return thread;
@@ -1537,7 +1558,7 @@ long _sys_clone(void *arg[])
     }
 
 #ifdef RT_USING_SMP
-    thread->bind_cpu = lwp->bind_cpu;
+    rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)lwp->cpu_affinity);
 #endif
     thread->cleanup = lwp_cleanup;
     thread->user_entry = RT_NULL;
@@ -1566,6 +1587,9 @@ long _sys_clone(void *arg[])
 
     level = rt_hw_interrupt_disable();
     rt_list_insert_after(&lwp->t_grp, &thread->sibling);
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_attach(lwp->sgroup, thread);
+#endif
     rt_hw_interrupt_enable(level);
 
     /* copy origin stack */
@@ -1620,6 +1644,12 @@ static void lwp_struct_copy(struct rt_lwp *dst, struct rt_lwp *src)
     dst->tty = src->tty;
     rt_memcpy(dst->cmd, src->cmd, RT_NAME_MAX);
 
+#ifdef RT_USING_SMP
+    dst->cpu_affinity = src->cpu_affinity;
+#endif
+
+    rt_memcpy(dst->rlim, src->rlim, sizeof dst->rlim);
+
     dst->sa_flags = src->sa_flags;
     dst->signal_mask = src->signal_mask;
     rt_memcpy(dst->signal_handler, src->signal_handler, sizeof dst->signal_handler);
@@ -1694,6 +1724,11 @@ sysret_t _sys_fork(void)
 
     self_lwp = lwp_self();
 
+#ifdef LWP_USING_MEM_GROUP
+    /* the pages duplicated are charged to the memory group of the parent */
+    lwp_mem_group_inherit(lwp, self_lwp->mgroup);
+#endif
+
     /* copy process */
     if (_copy_process(lwp, self_lwp) != 0)
     {
@@ -1734,11 +1769,18 @@ sysret_t _sys_fork(void)
     thread->thread_idr = self_thread->thread_idr;
     thread->lwp = (void *)lwp;
     thread->tid = tid;
+#ifdef RT_USING_SMP
+    rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)lwp->cpu_affinity);
+#endif
 
     level = rt_hw_interrupt_disable();
 
     /* add thread to lwp process */
     rt_list_insert_after(&lwp->t_grp, &thread->sibling);
+#ifdef RT_USING_SCHED_GROUP
+    lwp->sgroup = rt_sched_group_get(self_lwp->sgroup);
+    rt_sched_group_attach(lwp->sgroup, thread);
+#endif
 
     /* lwp add to children link */
     lwp->sibling = self_lwp->first_child;
@@ -2376,6 +2418,10 @@ sysret_t sys_execve(const char *path, char *const argv[], char *const envp[])
         _swap_lwp_data(lwp, new_lwp, struct rt_lwp_objs *, lwp_obj);
 
         _swap_lwp_data(lwp, new_lwp, size_t, end_heap);
+#ifdef LWP_USING_MEM_GROUP
+        /* charge the new address space to the memory group */
+        lwp_mem_group_inherit(lwp, lwp->mgroup);
+#endif
 #endif
         _swap_lwp_data(lwp, new_lwp, uint8_t, lwp_type);
         _swap_lwp_data(lwp, new_lwp, void *, text_entry);
@@ -2732,10 +2778,43 @@ sysret_t sys_accept(int socket, struct musl_sockaddr *addr, socklen_t *addrlen)
     return ret;
 }
 
+#ifdef SAL_USING_AF_UNIX
+/* the path of AF_UNIX is longer than struct sockaddr, it's copied as a whole */
+static int sockaddr_un_from_user(const struct musl_sockaddr *name, socklen_t namelen, struct sockaddr_un *kname)
+{
+    uint16_t family;
+
+    if (namelen < sizeof(family))
+    {
+        return 0;
+    }
+    lwp_get_from_user(&family, (void *)name, sizeof(family));
+    if (family != AF_UNIX)
+    {
+        return 0;
+    }
+
+    if (namelen > sizeof(struct sockaddr_un))
+    {
+        namelen = sizeof(struct sockaddr_un);
+    }
+    /* the sun_path is at the same offset of the both */
+    rt_memset(kname, 0, sizeof(*kname));
+    lwp_get_from_user(kname, (void *)name, namelen);
+    kname->sa_len = namelen;
+    kname->sa_family = AF_UNIX;
+
+    return 1;
+}
+#endif /* SAL_USING_AF_UNIX */
+
 sysret_t sys_bind(int socket, const struct musl_sockaddr *name, socklen_t namelen)
 {
     struct sockaddr sa;
     struct musl_sockaddr kname;
+#ifdef SAL_USING_AF_UNIX
+    struct sockaddr_un kname_un;
+#endif /* SAL_USING_AF_UNIX */
 
     if (!lwp_user_accessable((void *)name, namelen))
     {
@@ -2743,9 +2822,9 @@ sysret_t sys_bind(int socket, const struct musl_sockaddr *name, socklen_t namele
     }
 
 #ifdef SAL_USING_AF_UNIX
-    if (name->sa_family  == AF_UNIX)
+    if (sockaddr_un_from_user(name, namelen, &kname_un))
     {
-        namelen = sizeof(struct sockaddr);
+        return bind(socket, (struct sockaddr *)&kname_un, kname_un.sa_len);
     }
 #endif /* SAL_USING_AF_UNIX */
 
@@ -2869,6 +2948,9 @@ sysret_t sys_connect(int socket, const struct musl_sockaddr *name, socklen_t nam
     int ret;
     struct sockaddr sa;
     struct musl_sockaddr kname;
+#ifdef SAL_USING_AF_UNIX
+    struct sockaddr_un kname_un;
+#endif /* SAL_USING_AF_UNIX */
 
     if (!lwp_user_accessable((void *)name, namelen))
     {
@@ -2876,9 +2958,10 @@ sysret_t sys_connect(int socket, const struct musl_sockaddr *name, socklen_t nam
     }
 
 #ifdef SAL_USING_AF_UNIX
-    if (name->sa_family  == AF_UNIX)
+    if (sockaddr_un_from_user(name, namelen, &kname_un))
     {
-        namelen = sizeof(struct sockaddr);
+        ret = connect(socket, (struct sockaddr *)&kname_un, kname_un.sa_len);
+        return (ret < 0 ? GET_ERRNO() : ret);
     }
 #endif /* SAL_USING_AF_UNIX */
 
@@ -3088,6 +3171,364 @@ sysret_t sys_send(int socket, const void *dataptr, size_t size, int flags)
     return (ret < 0 ? GET_ERRNO() : ret);
 }
 
+#ifdef ARCH_MM_MMU
+#define MSG_IOV_MAX         1024
+#define MSG_CONTROL_MAX     4096
+
+/* the layout of struct msghdr in user space */
+struct musl_msghdr
+{
+    void *msg_name;
+    socklen_t msg_namelen;
+    struct iovec *msg_iov;
+#ifdef ARCH_CPU_64BIT
+    int msg_iovlen, __pad1;
+    void *msg_control;
+    socklen_t msg_controllen, __pad2;
+#else
+    int msg_iovlen;
+    void *msg_control;
+    socklen_t msg_controllen;
+#endif /* ARCH_CPU_64BIT */
+    int msg_flags;
+};
+
+/* the layout of struct cmsghdr in user space, its data is at the same offset */
+struct musl_cmsghdr
+{
+    socklen_t cmsg_len;
+#ifdef ARCH_CPU_64BIT
+    int __pad1;
+#endif /* ARCH_CPU_64BIT */
+    int cmsg_level;
+    int cmsg_type;
+};
+
+/* the kernel copy of a user msghdr */
+struct msghdr_kcopy
+{
+    struct msghdr msg;
+    struct iovec *uiov;     /* the iov array of user space */
+    void *buf;              /* the iov array, the data and the control in kernel */
+};
+
+/* convert the headers of the ancillary data in place */
+static void cmsg_from_musl(void *control, socklen_t controllen)
+{
+    char *pos = control;
+    char *end = pos + controllen;
+    struct musl_cmsghdr ucmsg;
+    struct cmsghdr *cmsg;
+
+    while (pos + sizeof(ucmsg) <= end)
+    {
+        memcpy(&ucmsg, pos, sizeof(ucmsg));
+        cmsg = (struct cmsghdr *)pos;
+        cmsg->cmsg_len = ucmsg.cmsg_len;
+        cmsg->cmsg_level = ucmsg.cmsg_level == INTF_SOL_SOCKET ? IMPL_SOL_SOCKET : ucmsg.cmsg_level;
+        cmsg->cmsg_type = ucmsg.cmsg_type;
+        if (ucmsg.cmsg_len < sizeof(ucmsg))
+        {
+            break;
+        }
+        pos += CMSG_ALIGN(ucmsg.cmsg_len);
+    }
+}
+
+static void cmsg_to_musl(void *control, socklen_t controllen)
+{
+    char *pos = control;
+    char *end = pos + controllen;
+    struct musl_cmsghdr ucmsg;
+    struct cmsghdr *cmsg;
+
+    while (pos + sizeof(ucmsg) <= end)
+    {
+        cmsg = (struct cmsghdr *)pos;
+        ucmsg.cmsg_len = cmsg->cmsg_len;
+#ifdef ARCH_CPU_64BIT
+        ucmsg.__pad1 = 0;
+#endif /* ARCH_CPU_64BIT */
+        ucmsg.cmsg_level = cmsg->cmsg_level == IMPL_SOL_SOCKET ? INTF_SOL_SOCKET : cmsg->cmsg_level;
+        ucmsg.cmsg_type = cmsg->cmsg_type;
+        memcpy(pos, &ucmsg, sizeof(ucmsg));
+        if (ucmsg.cmsg_len < sizeof(ucmsg))
+        {
+            break;
+        }
+        pos += CMSG_ALIGN(ucmsg.cmsg_len);
+    }
+}
+
+static void msghdr_kcopy_free(struct msghdr_kcopy *kcopy)
+{
+    if (kcopy->buf)
+    {
+        kmem_put(kcopy->buf);
+    }
+    if (kcopy->uiov)
+    {
+        kmem_put(kcopy->uiov);
+    }
+}
+
+/*
+ * copy the iov array and the control of a user msghdr into the kernel, the
+ * data of the iov is copied as well if copy_data is set.
+ */
+static int msghdr_from_user(struct msghdr_kcopy *kcopy, const struct musl_msghdr *umsg, int copy_data)
+{
+    int i;
+    size_t iov_size, total = 0;
+    struct iovec *kiov;
+    char *data;
+
+    rt_memset(kcopy, 0, sizeof(*kcopy));
+
+    if (umsg->msg_iovlen < 0 || umsg->msg_iovlen > MSG_IOV_MAX ||
+        umsg->msg_controllen > MSG_CONTROL_MAX)
+    {
+        return -EINVAL;
+    }
+    if (umsg->msg_controllen && !lwp_user_accessable(umsg->msg_control, umsg->msg_controllen))
+    {
+        return -EFAULT;
+    }
+
+    iov_size = umsg->msg_iovlen * sizeof(struct iovec);
+    if (iov_size)
+    {
+        if (!lwp_user_accessable(umsg->msg_iov, iov_size))
+        {
+            return -EFAULT;
+        }
+        kcopy->uiov = kmem_get(iov_size);
+        if (!kcopy->uiov)
+        {
+            return -ENOMEM;
+        }
+        lwp_get_from_user(kcopy->uiov, umsg->msg_iov, iov_size);
+
+        for (i = 0; i < umsg->msg_iovlen; i++)
+        {
+            if (kcopy->uiov[i].iov_len > INT_MAX - total)
+            {
+                msghdr_kcopy_free(kcopy);
+                return -EINVAL;
+            }
+            if (!lwp_user_accessable(kcopy->uiov[i].iov_base, kcopy->uiov[i].iov_len))
+            {
+                msghdr_kcopy_free(kcopy);
+                return -EFAULT;
+            }
+            total += kcopy->uiov[i].iov_len;
+        }
+    }
+
+    /* the control is ahead of the data to keep it aligned */
+    kcopy->buf = kmem_get(CMSG_ALIGN(umsg->msg_controllen) + iov_size + total + 1);
+    if (!kcopy->buf)
+    {
+        msghdr_kcopy_free(kcopy);
+        return -ENOMEM;
+    }
+
+    if (umsg->msg_controllen)
+    {
+        kcopy->msg.msg_control = kcopy->buf;
+        kcopy->msg.msg_controllen = umsg->msg_controllen;
+        if (copy_data)
+        {
+            lwp_get_from_user(kcopy->msg.msg_control, umsg->msg_control, umsg->msg_controllen);
+            cmsg_from_musl(kcopy->msg.msg_control, umsg->msg_controllen);
+        }
+    }
+
+    kiov = (struct iovec *)((char *)kcopy->buf + CMSG_ALIGN(umsg->msg_controllen));
+    data = (char *)kiov + iov_size;
+    for (i = 0; i < umsg->msg_iovlen; i++)
+    {
+        kiov[i].iov_base = data;
+        kiov[i].iov_len = kcopy->uiov[i].iov_len;
+        if (copy_data)
+        {
+            lwp_get_from_user(data, kcopy->uiov[i].iov_base, kiov[i].iov_len);
+        }
+        data += kiov[i].iov_len;
+    }
+    kcopy->msg.msg_iov = kiov;
+    kcopy->msg.msg_iovlen = umsg->msg_iovlen;
+
+    return 0;
+}
+#endif /* ARCH_MM_MMU */
+
+sysret_t sys_sendmsg(int socket, const struct musl_msghdr *msg, int flags)
+{
+#ifdef ARCH_MM_MMU
+    int ret;
+    int flgs;
+    struct musl_msghdr umsg;
+    struct msghdr_kcopy kcopy;
+    union
+    {
+        struct sockaddr sa;
+#ifdef SAL_USING_AF_UNIX
+        struct sockaddr_un un;
+#endif /* SAL_USING_AF_UNIX */
+    } kname;
+
+    if (!lwp_user_accessable((void *)msg, sizeof(umsg)))
+    {
+        return -EFAULT;
+    }
+    lwp_get_from_user(&umsg, (void *)msg, sizeof(umsg));
+
+    if (umsg.msg_name && !lwp_user_accessable(umsg.msg_name, umsg.msg_namelen))
+    {
+        return -EFAULT;
+    }
+
+    ret = msghdr_from_user(&kcopy, &umsg, 1);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (umsg.msg_name)
+    {
+#ifdef SAL_USING_AF_UNIX
+        if (sockaddr_un_from_user(umsg.msg_name, umsg.msg_namelen, &kname.un))
+        {
+            kcopy.msg.msg_namelen = kname.un.sa_len;
+        }
+        else
+#endif /* SAL_USING_AF_UNIX */
+        {
+            struct musl_sockaddr musl_name = {0};
+
+            lwp_get_from_user(&musl_name, umsg.msg_name,
+                umsg.msg_namelen < sizeof(musl_name) ? umsg.msg_namelen : sizeof(musl_name));
+            sockaddr_tolwip(&musl_name, &kname.sa);
+            kcopy.msg.msg_namelen = umsg.msg_namelen;
+        }
+        kcopy.msg.msg_name = &kname;
+    }
+
+    flgs = netflags_muslc_2_lwip(flags);
+    ret = sendmsg(socket, &kcopy.msg, flgs);
+    if (ret < 0)
+    {
+        ret = GET_ERRNO();
+    }
+
+    msghdr_kcopy_free(&kcopy);
+
+    return ret;
+#else
+    return -ENOSYS;
+#endif /* ARCH_MM_MMU */
+}
+
+sysret_t sys_recvmsg(int socket, struct musl_msghdr *msg, int flags)
+{
+#ifdef ARCH_MM_MMU
+    int ret, i;
+    int flgs;
+    size_t left, len;
+    struct musl_msghdr umsg;
+    struct msghdr_kcopy kcopy;
+    union
+    {
+        struct sockaddr sa;
+        struct musl_sockaddr musl;
+#ifdef SAL_USING_AF_UNIX
+        struct sockaddr_un un;
+#endif /* SAL_USING_AF_UNIX */
+    } kname;
+
+    if (!lwp_user_accessable((void *)msg, sizeof(umsg)))
+    {
+        return -EFAULT;
+    }
+    lwp_get_from_user(&umsg, (void *)msg, sizeof(umsg));
+
+    if (umsg.msg_name && !lwp_user_accessable(umsg.msg_name, umsg.msg_namelen))
+    {
+        return -EFAULT;
+    }
+
+    ret = msghdr_from_user(&kcopy, &umsg, 0);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    rt_memset(&kname, 0, sizeof(kname));
+    if (umsg.msg_name)
+    {
+        kcopy.msg.msg_name = &kname;
+        kcopy.msg.msg_namelen = sizeof(kname);
+    }
+
+    flgs = netflags_muslc_2_lwip(flags);
+    ret = recvmsg(socket, &kcopy.msg, flgs);
+    if (ret < 0)
+    {
+        ret = GET_ERRNO();
+        goto __exit;
+    }
+
+    /* copy the data back to the iov of user space */
+    left = ret;
+    for (i = 0; i < umsg.msg_iovlen && left > 0; i++)
+    {
+        len = kcopy.msg.msg_iov[i].iov_len < left ? kcopy.msg.msg_iov[i].iov_len : left;
+        lwp_put_to_user(kcopy.uiov[i].iov_base, kcopy.msg.msg_iov[i].iov_base, len);
+        left -= len;
+    }
+
+    if (umsg.msg_name)
+    {
+#ifdef SAL_USING_AF_UNIX
+        if (kname.sa.sa_family == AF_UNIX)
+        {
+            /* the sun_path is at the same offset of the both */
+            kname.musl.sa_family = AF_UNIX;
+        }
+        else
+#endif /* SAL_USING_AF_UNIX */
+        {
+            struct sockaddr sa = kname.sa;
+
+            sockaddr_tomusl(&sa, &kname.musl);
+        }
+        if (kcopy.msg.msg_namelen < umsg.msg_namelen)
+        {
+            umsg.msg_namelen = kcopy.msg.msg_namelen;
+        }
+        lwp_put_to_user(umsg.msg_name, &kname, umsg.msg_namelen);
+    }
+
+    if (umsg.msg_controllen)
+    {
+        cmsg_to_musl(kcopy.msg.msg_control, kcopy.msg.msg_controllen);
+        lwp_put_to_user(umsg.msg_control, kcopy.msg.msg_control, kcopy.msg.msg_controllen);
+    }
+
+    umsg.msg_controllen = kcopy.msg.msg_controllen;
+    umsg.msg_flags = kcopy.msg.msg_flags;
+    lwp_put_to_user(msg, &umsg, sizeof(umsg));
+
+__exit:
+    msghdr_kcopy_free(&kcopy);
+
+    return ret;
+#else
+    return -ENOSYS;
+#endif /* ARCH_MM_MMU */
+}
+
 sysret_t sys_socket(int domain, int type, int protocol)
 {
     int fd = -1;
@@ -3117,6 +3558,44 @@ out:
     return (fd < 0 ? GET_ERRNO() : fd);
 }
 
+sysret_t sys_socketpair(int domain, int type, int protocol, int fd[2])
+{
+    int ret;
+    int nonblock = 0;
+    int kfd[2];
+
+    if (!lwp_user_accessable((void *)fd, sizeof(kfd)))
+    {
+        return -EFAULT;
+    }
+
+    /* not support SOCK_CLOEXEC type */
+    if (type & SOCK_CLOEXEC)
+    {
+        type &= ~SOCK_CLOEXEC;
+    }
+    if (type & SOCK_NONBLOCK)
+    {
+        nonblock = 1;
+        type &= ~SOCK_NONBLOCK;
+    }
+
+    ret = socketpair(domain, type, protocol, kfd);
+    if (ret < 0)
+    {
+        return GET_ERRNO();
+    }
+    if (nonblock)
+    {
+        fcntl(kfd[0], F_SETFL, O_NONBLOCK);
+        fcntl(kfd[1], F_SETFL, O_NONBLOCK);
+    }
+
+    lwp_put_to_user(fd, kfd, sizeof(kfd));
+
+    return 0;
+}
+
 sysret_t sys_closesocket(int socket)
 {
     return closesocket(socket);
@@ -3912,12 +4391,65 @@ sysret_t sys_clock_settime(clockid_t clk, const struct timespec *ts)
 #endif
 }
 
-sysret_t sys_clock_gettime(clockid_t clk, struct timespec *ts)
+#ifdef RT_USING_CPU_USAGE
+static void _cpu_time_to_timespec(rt_uint64_t time, struct timespec *ts)
 {
-    int ret = 0;
-#ifdef ARCH_MM_MMU
-    size_t size = sizeof(struct timespec);
-    struct timespec *kts = NULL;
+    rt_uint64_t ns = rt_cpu_usage_to_ns(time);
+
+    ts->tv_sec = ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+#endif /* RT_USING_CPU_USAGE */
+
+/* the clocks measuring cpu time of calling thread or process */
+static int _cpu_time_clock_gettime(clockid_t clk, struct timespec *ts)
+{
+#ifdef RT_USING_CPU_USAGE
+    rt_uint64_t utime, stime;
+
+    if (clk == CLOCK_THREAD_CPUTIME_ID)
+    {
+        rt_thread_cpu_time(rt_thread_self(), &utime, &stime);
+    }
+    else if (clk == CLOCK_PROCESS_CPUTIME_ID)
+    {
+        lwp_cpu_time(lwp_self(), &utime, &stime);
+    }
+    else
+    {
+        return -ENOSYS;
+    }
+
+    _cpu_time_to_timespec(utime + stime, ts);
+
+    return 0;
+#else
+    return -ENOSYS;
+#endif /* RT_USING_CPU_USAGE */
+}
+
+static int _cpu_time_clock_getres(clockid_t clk, struct timespec *ts)
+{
+#ifdef RT_USING_CPU_USAGE
+    if (clk == CLOCK_THREAD_CPUTIME_ID || clk == CLOCK_PROCESS_CPUTIME_ID)
+    {
+        rt_uint64_t ns = 1000000000ULL / rt_cpu_usage_clock_freq();
+
+        ts->tv_sec = 0;
+        ts->tv_nsec = ns ? ns : 1;
+
+        return 0;
+    }
+#endif /* RT_USING_CPU_USAGE */
+    return -ENOSYS;
+}
+
+sysret_t sys_clock_gettime(clockid_t clk, struct timespec *ts)
+{
+    int ret = 0;
+#ifdef ARCH_MM_MMU
+    size_t size = sizeof(struct timespec);
+    struct timespec *kts = NULL;
 
     if (!lwp_user_accessable((void *)ts, size))
     {
@@ -3930,7 +4462,11 @@ sysret_t sys_clock_gettime(clockid_t clk, struct timespec *ts)
         return -ENOMEM;
     }
 
-    ret = clock_gettime(clk, kts);
+    ret = _cpu_time_clock_gettime(clk, kts);
+    if (ret == -ENOSYS)
+    {
+        ret = clock_gettime(clk, kts);
+    }
     if (ret != -1)
         lwp_put_to_user(ts, kts, size);
 
@@ -3947,7 +4483,11 @@ sysret_t sys_clock_gettime(clockid_t clk, struct timespec *ts)
     {
         return -EFAULT;
     }
-    ret = clock_gettime(clk, ts);
+    ret = _cpu_time_clock_gettime(clk, ts);
+    if (ret == -ENOSYS)
+    {
+        ret = clock_gettime(clk, ts);
+    }
     return (ret < 0 ? GET_ERRNO() : ret);
 #endif
 }
@@ -3994,7 +4534,11 @@ sysret_t sys_clock_getres(clockid_t clk, struct timespec *ts)
         return -EFAULT;
     }
 
-    ret = clock_getres(clk, &kts);
+    ret = _cpu_time_clock_getres(clk, &kts);
+    if (ret == -ENOSYS)
+    {
+        ret = clock_getres(clk, &kts);
+    }
 
     if (ret != -1)
         lwp_put_to_user(ts, &kts, size);
@@ -4003,7 +4547,11 @@ sysret_t sys_clock_getres(clockid_t clk, struct timespec *ts)
     {
         return -EFAULT;
     }
-    ret = clock_getres(clk, ts);
+    ret = _cpu_time_clock_getres(clk, ts);
+    if (ret == -ENOSYS)
+    {
+        ret = clock_getres(clk, ts);
+    }
 #endif
     return (ret < 0 ? GET_ERRNO() : ret);
 }
@@ -4048,45 +4596,241 @@ struct rlimit {
 #define RLIMIT_MEMLOCK 8
 #define RLIMIT_AS      9
 
+static int _rlimit_get(struct rt_lwp *lwp, unsigned int resource, struct rlimit *rlim)
+{
+    if (resource >= LWP_RLIMIT_NR)
+    {
+        return -EINVAL;
+    }
+
+    /* RLIMIT_NOFILE is checked by the fd allocation */
+    rlim->rlim_cur = lwp->rlim[resource].rlim_cur;
+    rlim->rlim_max = lwp->rlim[resource].rlim_max;
+
+    return 0;
+}
+
+static int _rlimit_set(struct rt_lwp *lwp, unsigned int resource, const struct rlimit *rlim)
+{
+    rt_base_t level;
+    int ret = 0;
+
+    if (resource >= LWP_RLIMIT_NR || rlim->rlim_cur > rlim->rlim_max)
+    {
+        return -EINVAL;
+    }
+
+    level = rt_hw_interrupt_disable();
+    /* the hard limit can only be lowered */
+    if (rlim->rlim_max > lwp->rlim[resource].rlim_max)
+    {
+        ret = -EPERM;
+    }
+    else
+    {
+        lwp->rlim[resource].rlim_cur = rlim->rlim_cur;
+        lwp->rlim[resource].rlim_max = rlim->rlim_max;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
 sysret_t sys_prlimit64(pid_t pid,
         unsigned int resource,
         const struct rlimit *new_rlim,
         struct rlimit *old_rlim)
 {
-    return -ENOSYS;
+    struct rt_lwp *lwp;
+    struct rlimit krlim;
+    rt_base_t level;
+    int ret = 0;
+
+    if ((new_rlim && !lwp_user_accessable((void *)new_rlim, sizeof(struct rlimit))) ||
+        (old_rlim && !lwp_user_accessable((void *)old_rlim, sizeof(struct rlimit))))
+    {
+        return -EFAULT;
+    }
+
+    /* the process is kept by the reference until the limits are done */
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : lwp_self();
+    if (lwp)
+    {
+        lwp_ref_inc(lwp);
+    }
+    rt_hw_interrupt_enable(level);
+    if (!lwp)
+    {
+        return -ESRCH;
+    }
+
+    if (old_rlim)
+    {
+        ret = _rlimit_get(lwp, resource, &krlim);
+        if (ret == 0)
+        {
+            lwp_put_to_user(old_rlim, &krlim, sizeof(krlim));
+        }
+    }
+
+    if (new_rlim && ret == 0)
+    {
+        lwp_get_from_user(&krlim, (void *)new_rlim, sizeof(krlim));
+        ret = _rlimit_set(lwp, resource, &krlim);
+    }
+    lwp_ref_dec(lwp);
+
+    return ret;
 }
 
 sysret_t sys_getrlimit(unsigned int resource, unsigned long rlim[2])
 {
-    int ret = -1;
+    int ret;
+    struct rlimit krlim;
+    unsigned long krlim_ul[2];
 
     if (!lwp_user_accessable((void *)rlim, sizeof(unsigned long [2])))
     {
         return -EFAULT;
     }
-    switch (resource)
+
+    ret = _rlimit_get(lwp_self(), resource, &krlim);
+    if (ret == 0)
     {
-    case RLIMIT_NOFILE:
-        {
-            struct dfs_fdtable *fdt = dfs_fdtable_get();
+        krlim_ul[0] = (unsigned long)krlim.rlim_cur;
+        krlim_ul[1] = (unsigned long)krlim.rlim_max;
+        lwp_put_to_user(rlim, krlim_ul, sizeof(krlim_ul));
+    }
 
-            dfs_file_lock();
-            rlim[0] = fdt->maxfd;
-            dfs_file_unlock();
-            rlim[1] = DFS_FD_MAX;
-            ret = 0;
-        }
+    return ret;
+}
+
+sysret_t sys_setrlimit(unsigned int resource, struct rlimit *rlim)
+{
+    struct rlimit krlim;
+
+    if (!lwp_user_accessable((void *)rlim, sizeof(struct rlimit)))
+    {
+        return -EFAULT;
+    }
+    lwp_get_from_user(&krlim, rlim, sizeof(krlim));
+
+    return _rlimit_set(lwp_self(), resource, &krlim);
+}
+
+#define RUSAGE_SELF     0
+#define RUSAGE_CHILDREN (-1)
+#define RUSAGE_THREAD   1
+
+struct rusage {
+    struct timeval ru_utime;
+    struct timeval ru_stime;
+    long ru_maxrss;
+    long ru_ixrss;
+    long ru_idrss;
+    long ru_isrss;
+    long ru_minflt;
+    long ru_majflt;
+    long ru_nswap;
+    long ru_inblock;
+    long ru_oublock;
+    long ru_msgsnd;
+    long ru_msgrcv;
+    long ru_nsignals;
+    long ru_nvcsw;
+    long ru_nivcsw;
+    long __reserved[16];
+};
+
+struct tms {
+    long tms_utime;
+    long tms_stime;
+    long tms_cutime;
+    long tms_cstime;
+};
+
+/* clock ticks of times(), fixed as USER_HZ by libc */
+#define LWP_CLK_TCK     100
+
+#ifdef RT_USING_CPU_USAGE
+static void _cpu_time_to_timeval(rt_uint64_t time, struct timeval *tv)
+{
+    rt_uint64_t us = rt_cpu_usage_to_ns(time) / 1000;
+
+    tv->tv_sec = us / 1000000;
+    tv->tv_usec = us % 1000000;
+}
+
+static long _cpu_time_to_clock(rt_uint64_t time)
+{
+    return (long)(rt_cpu_usage_to_ns(time) / (1000000000ULL / LWP_CLK_TCK));
+}
+#endif /* RT_USING_CPU_USAGE */
+
+sysret_t sys_getrusage(int who, struct rusage *ru)
+{
+#ifdef RT_USING_CPU_USAGE
+    struct rusage kru;
+    rt_uint64_t utime, stime;
+
+    if (!lwp_user_accessable((void *)ru, sizeof(struct rusage)))
+    {
+        return -EFAULT;
+    }
+
+    switch (who)
+    {
+    case RUSAGE_SELF:
+        lwp_cpu_time(lwp_self(), &utime, &stime);
+        break;
+    case RUSAGE_CHILDREN:
+        lwp_children_cpu_time(lwp_self(), &utime, &stime);
+        break;
+    case RUSAGE_THREAD:
+        rt_thread_cpu_time(rt_thread_self(), &utime, &stime);
         break;
     default:
         return -EINVAL;
-        break;
     }
-    return (ret < 0 ? GET_ERRNO() : ret);
+
+    rt_memset(&kru, 0, sizeof(kru));
+    _cpu_time_to_timeval(utime, &kru.ru_utime);
+    _cpu_time_to_timeval(stime, &kru.ru_stime);
+    lwp_put_to_user(ru, &kru, sizeof(kru));
+
+    return 0;
+#else
+    return -ENOSYS;
+#endif /* RT_USING_CPU_USAGE */
 }
 
-sysret_t sys_setrlimit(unsigned int resource, struct rlimit *rlim)
+sysret_t sys_times(struct tms *buf)
 {
+#ifdef RT_USING_CPU_USAGE
+    struct tms ktms;
+    rt_uint64_t utime, stime;
+
+    if (buf)
+    {
+        if (!lwp_user_accessable((void *)buf, sizeof(struct tms)))
+        {
+            return -EFAULT;
+        }
+
+        lwp_cpu_time(lwp_self(), &utime, &stime);
+        ktms.tms_utime = _cpu_time_to_clock(utime);
+        ktms.tms_stime = _cpu_time_to_clock(stime);
+        lwp_children_cpu_time(lwp_self(), &utime, &stime);
+        ktms.tms_cutime = _cpu_time_to_clock(utime);
+        ktms.tms_cstime = _cpu_time_to_clock(stime);
+        lwp_put_to_user(buf, &ktms, sizeof(ktms));
+    }
+
+    return (sysret_t)((rt_uint64_t)rt_tick_get() * LWP_CLK_TCK / RT_TICK_PER_SECOND);
+#else
     return -ENOSYS;
+#endif /* RT_USING_CPU_USAGE */
 }
 
 sysret_t sys_setsid(void)
@@ -4237,18 +4981,66 @@ ssize_t sys_readlink(char* path, char *buf, size_t bufsz)
 
 sysret_t sys_setaffinity(pid_t pid, size_t size, void *set)
 {
-    if (!lwp_user_accessable(set, sizeof(cpu_set_t)))
+    cpu_set_t kset;
+    rt_ubase_t cpu_affinity = 0;
+
+    if (size > sizeof(kset))
+    {
+        size = sizeof(kset);
+    }
+    if (!lwp_user_accessable(set, size))
     {
         return -EFAULT;
     }
-    for (int i = 0;i < size * 8; i++)
+
+    CPU_ZERO(&kset);
+    lwp_get_from_user(&kset, set, size);
+
+    for (int i = 0; i < RT_CPUS_NR && i < size * 8; i++)
     {
-        if (CPU_ISSET(i, (cpu_set_t *)set))
+        if (CPU_ISSET(i, &kset))
         {
-            return lwp_setaffinity(pid, i);
+            cpu_affinity |= 1UL << i;
         }
     }
-    return -1;
+    if (cpu_affinity == 0)
+    {
+        return -EINVAL;
+    }
+
+    return lwp_set_cpu_affinity(pid, cpu_affinity) == 0 ? 0 : -ESRCH;
+}
+
+sysret_t sys_getaffinity(pid_t pid, size_t size, void *set)
+{
+    cpu_set_t kset;
+    rt_ubase_t cpu_affinity;
+
+    if (size > sizeof(kset))
+    {
+        size = sizeof(kset);
+    }
+    if (!lwp_user_accessable(set, size))
+    {
+        return -EFAULT;
+    }
+    if (lwp_get_cpu_affinity(pid, &cpu_affinity) != 0)
+    {
+        return -ESRCH;
+    }
+
+    CPU_ZERO(&kset);
+    for (int i = 0; i < RT_CPUS_NR && i < size * 8; i++)
+    {
+        if (cpu_affinity & (1UL << i))
+        {
+            CPU_SET(i, &kset);
+        }
+    }
+    lwp_put_to_user(set, &kset, size);
+
+    /* the size of mask copied, the rest of user mask is cleared by libc */
+    return size;
 }
 
 sysret_t sys_sched_setparam(pid_t pid, void *param)
@@ -4324,6 +5116,42 @@ sysret_t sys_sched_get_priority_min(int policy)
     return 0;
 }
 
+static uint64_t _sched_tick_ns(void)
+{
+    return 1000000000ULL / RT_TICK_PER_SECOND;
+}
+
+#ifdef RT_USING_SCHED_DEADLINE
+/* there are no user credentials, the threads of own and child processes could be set, or any by init */
+static rt_bool_t sched_attr_permitted(rt_thread_t thread)
+{
+    struct rt_lwp *self = lwp_self();
+    struct rt_lwp *lwp = (struct rt_lwp *)thread->lwp;
+
+    if (self == RT_NULL || self->pid == 1 || lwp == self)
+    {
+        return RT_TRUE;
+    }
+
+    return lwp != RT_NULL && lwp->parent == self;
+}
+
+/* round up to ticks, the time out of the range of the deadline class is refused */
+static int _sched_ns_to_tick(uint64_t ns, rt_tick_t *tick)
+{
+    uint64_t tick_ns = _sched_tick_ns();
+    uint64_t ticks = ns / tick_ns + (ns % tick_ns != 0);
+
+    if (ticks >= RT_TICK_MAX / 2)
+    {
+        return -EINVAL;
+    }
+    *tick = (rt_tick_t)ticks;
+
+    return 0;
+}
+#endif /* RT_USING_SCHED_DEADLINE */
+
 sysret_t sys_sched_setscheduler(int tid, int policy, void *param)
 {
     struct sched_param *sched_param = (struct sched_param *)param;
@@ -4333,6 +5161,23 @@ sysret_t sys_sched_setscheduler(int tid, int policy, void *param)
     {
         return -EFAULT;
     }
+#ifdef RT_USING_SCHED_DEADLINE
+    if (!thread)
+    {
+        return -ESRCH;
+    }
+    if (!sched_attr_permitted(thread))
+    {
+        return -EPERM;
+    }
+    /* the deadline parameters are only given by sched_setattr */
+    if (policy == SCHED_DEADLINE)
+    {
+        return -EINVAL;
+    }
+    /* a fixed priority policy takes the thread out of the deadline class */
+    rt_thread_set_deadline(thread, 0, 0, 0);
+#endif /* RT_USING_SCHED_DEADLINE */
     return rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, (void *)&sched_param->sched_priority);
     return 0;
 }
@@ -4347,9 +5192,428 @@ sysret_t sys_sched_getscheduler(int tid, int *policy, void *param)
     }
     sched_param->sched_priority = thread->current_priority;
     *policy = 0;
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->dl.runtime != 0)
+    {
+        *policy = SCHED_DEADLINE;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+    return 0;
+}
+
+sysret_t sys_sched_setattr(pid_t tid, struct sched_attr *attr, unsigned int flags)
+{
+    struct sched_attr kattr;
+    rt_thread_t thread;
+
+    if (!lwp_user_accessable(attr, sizeof(kattr)))
+    {
+        return -EFAULT;
+    }
+    lwp_get_from_user(&kattr, attr, sizeof(kattr));
+
+    thread = tid ? lwp_tid_get_thread(tid) : rt_thread_self();
+    if (!thread)
+    {
+        return -ESRCH;
+    }
+#ifdef RT_USING_SCHED_DEADLINE
+    if (!sched_attr_permitted(thread))
+    {
+        return -EPERM;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
+    if (kattr.sched_policy == SCHED_DEADLINE)
+    {
+#ifdef RT_USING_SCHED_DEADLINE
+        rt_tick_t runtime, deadline, period;
+        rt_err_t err;
+
+        if (_sched_ns_to_tick(kattr.sched_runtime, &runtime) ||
+            _sched_ns_to_tick(kattr.sched_deadline, &deadline) ||
+            _sched_ns_to_tick(kattr.sched_period, &period))
+        {
+            return -EINVAL;
+        }
+
+        err = rt_thread_set_deadline(thread, runtime, deadline, period);
+        if (err == -RT_EBUSY)
+        {
+            return -EBUSY;
+        }
+        return err == RT_EOK ? 0 : -EINVAL;
+#else
+        return -EINVAL;
+#endif /* RT_USING_SCHED_DEADLINE */
+    }
+
+    if (kattr.sched_priority >= RT_THREAD_PRIORITY_MAX)
+    {
+        return -EINVAL;
+    }
+
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_thread_set_deadline(thread, 0, 0, 0);
+#endif /* RT_USING_SCHED_DEADLINE */
+    if (kattr.sched_policy != SCHED_OTHER)
+    {
+        rt_uint8_t priority = (rt_uint8_t)kattr.sched_priority;
+
+        rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+    }
+
     return 0;
 }
 
+sysret_t sys_sched_getattr(pid_t tid, struct sched_attr *attr, unsigned int size, unsigned int flags)
+{
+    struct sched_attr kattr;
+    rt_thread_t thread;
+
+    if (size > sizeof(kattr))
+    {
+        size = sizeof(kattr);
+    }
+    if (!lwp_user_accessable(attr, size))
+    {
+        return -EFAULT;
+    }
+
+    thread = tid ? lwp_tid_get_thread(tid) : rt_thread_self();
+    if (!thread)
+    {
+        return -ESRCH;
+    }
+
+    rt_memset(&kattr, 0, sizeof(kattr));
+    kattr.size = sizeof(kattr);
+    kattr.sched_policy = SCHED_OTHER;
+    kattr.sched_priority = thread->current_priority;
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->dl.runtime != 0)
+    {
+        uint64_t tick_ns = _sched_tick_ns();
+
+        kattr.sched_policy = SCHED_DEADLINE;
+        kattr.sched_runtime = thread->dl.runtime * tick_ns;
+        kattr.sched_deadline = thread->dl.deadline * tick_ns;
+        kattr.sched_period = thread->dl.period * tick_ns;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+    lwp_put_to_user(attr, &kattr, size);
+
+    return 0;
+}
+
+#ifdef RT_USING_SCHED_GROUP
+/* there are no user credentials, the groups are managed by the init process */
+static rt_bool_t sched_group_capable(void)
+{
+    struct rt_lwp *lwp = lwp_self();
+
+    return lwp != RT_NULL && lwp->pid == 1;
+}
+
+static int sched_group_name_from_user(const char *name, char kname[RT_NAME_MAX + 1])
+{
+    int err = 0;
+    size_t len;
+
+    len = lwp_user_strlen(name, &err);
+    if (err)
+    {
+        return -EFAULT;
+    }
+    if (len == 0 || len > RT_NAME_MAX)
+    {
+        return -EINVAL;
+    }
+    lwp_get_from_user(kname, (void *)name, len);
+    kname[len] = '\0';
+
+    return 0;
+}
+
+/* find the group by a user name with a reference, RT_NULL name for the kernel group */
+static int sched_group_get_from_user(const char *name, rt_sched_group_t *group)
+{
+    int ret;
+    rt_base_t level;
+    char kname[RT_NAME_MAX + 1];
+
+    *group = RT_NULL;
+    if (name == RT_NULL)
+    {
+        return 0;
+    }
+
+    ret = sched_group_name_from_user(name, kname);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    level = rt_hw_interrupt_disable();
+    *group = rt_sched_group_get(rt_sched_group_find(kname));
+    rt_hw_interrupt_enable(level);
+
+    return *group ? 0 : -ENOENT;
+}
+
+/* check whether group is top or a descendant of it, any group is under the kernel group here */
+static rt_bool_t sched_group_within(rt_sched_group_t group, rt_sched_group_t top)
+{
+    if (top == RT_NULL)
+    {
+        return RT_TRUE;
+    }
+
+    for (; group != RT_NULL; group = group->parent)
+    {
+        if (group == top)
+        {
+            return RT_TRUE;
+        }
+    }
+
+    return RT_FALSE;
+}
+
+/* move the process pid to group, the caller may only move itself and its children */
+static int sched_group_attach_lwp(pid_t pid, rt_sched_group_t group)
+{
+    struct rt_lwp *self = lwp_self(), *lwp;
+    rt_base_t level;
+    int ret;
+
+    level = rt_hw_interrupt_disable();
+    lwp = pid ? lwp_from_pid(pid) : self;
+    if (lwp == RT_NULL)
+    {
+        ret = -ESRCH;
+    }
+    else if ((lwp != self && lwp->parent != self) || lwp->pid == 1)
+    {
+        ret = -EPERM;
+    }
+    /* an unprivileged process can not leave the subtree of its own group */
+    else if (!sched_group_capable() && !sched_group_within(group, self->sgroup))
+    {
+        ret = -EPERM;
+    }
+    else
+    {
+        ret = lwp_sched_group_attach(lwp->pid, group) == 0 ? 0 : -ESRCH;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+static rt_tick_t sched_group_us_to_tick(unsigned long us)
+{
+    return (rt_tick_t)(((rt_uint64_t)us * RT_TICK_PER_SECOND + 999999) / 1000000);
+}
+#endif /* RT_USING_SCHED_GROUP */
+
+/* syscall: "sched_group_ctl" ret: "int" args: "int" "const char *" "unsigned long" "unsigned long" */
+sysret_t sys_sched_group_ctl(int cmd, const char *name, unsigned long arg0, unsigned long arg1)
+{
+#ifdef RT_USING_SCHED_GROUP
+    int ret = 0;
+    rt_err_t err = RT_EOK;
+    rt_sched_group_t group, parent;
+    char kname[RT_NAME_MAX + 1];
+
+    if (cmd != LWP_SCHED_GROUP_ATTACH && !sched_group_capable())
+    {
+        return -EPERM;
+    }
+
+    switch (cmd)
+    {
+    case LWP_SCHED_GROUP_CREATE:
+        ret = sched_group_name_from_user(name, kname);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        ret = sched_group_get_from_user((const char *)arg0, &parent);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        group = rt_sched_group_create(kname, parent);
+        rt_sched_group_put(parent);
+        if (group == RT_NULL)
+        {
+            return rt_sched_group_find(kname) ? -EEXIST : -EINVAL;
+        }
+        return 0;
+
+    case LWP_SCHED_GROUP_ATTACH:
+        ret = sched_group_get_from_user(name, &group);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        ret = sched_group_attach_lwp((pid_t)arg0, group);
+        rt_sched_group_put(group);
+        return ret;
+
+    case LWP_SCHED_GROUP_DELETE:
+        ret = sched_group_name_from_user(name, kname);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        err = rt_sched_group_delete_by_name(kname);
+        break;
+
+    case LWP_SCHED_GROUP_SET_SHARES:
+    case LWP_SCHED_GROUP_SET_QUOTA:
+        if (name == RT_NULL)
+        {
+            return -EINVAL;
+        }
+        ret = sched_group_get_from_user(name, &group);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        break;
+
+    default:
+        return -EINVAL;
+    }
+
+    if (cmd == LWP_SCHED_GROUP_SET_SHARES)
+    {
+        err = rt_sched_group_set_shares(group, (rt_uint32_t)arg0);
+        rt_sched_group_put(group);
+    }
+    else if (cmd == LWP_SCHED_GROUP_SET_QUOTA)
+    {
+        err = rt_sched_group_set_bandwidth(group, sched_group_us_to_tick(arg0),
+                                           sched_group_us_to_tick(arg1));
+        rt_sched_group_put(group);
+    }
+
+    switch (err)
+    {
+    case RT_EOK:
+        return 0;
+    case -RT_ENOENT:
+        return -ENOENT;
+    case -RT_EBUSY:
+        return -EBUSY;
+    default:
+        return -EINVAL;
+    }
+#else
+    return -ENOSYS;
+#endif /* RT_USING_SCHED_GROUP */
+}
+
+#ifdef RT_USING_POSIX_PIPE_PAGE
+/* the layout of struct iovec in user space */
+struct _vmsplice_iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+
+#define VMSPLICE_IOV_MAX    1024
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+
+/* syscall: "vmsplice" ret: "ssize_t" args: "int" "const struct iovec *" "size_t" "unsigned int" */
+ssize_t sys_vmsplice(int fd, const void *iov, size_t nr_segs, unsigned int flags)
+{
+#ifdef RT_USING_POSIX_PIPE_PAGE
+    struct _vmsplice_iovec *kiov;
+    struct rt_lwp *lwp = lwp_self();
+    struct dfs_file *d;
+    ssize_t ret = 0, len = 0;
+    size_t i;
+
+    d = fd_get(fd);
+    if (!d || !d->vnode || d->vnode->type != FT_DEVICE ||
+        ((rt_device_t)d->vnode->data)->type != RT_Device_Class_Pipe)
+    {
+        return -EBADF;
+    }
+    if (nr_segs == 0 || nr_segs > VMSPLICE_IOV_MAX)
+    {
+        return -EINVAL;
+    }
+    if (!lwp_user_accessable((void *)iov, nr_segs * sizeof(*kiov)))
+    {
+        return -EFAULT;
+    }
+
+    kiov = kmem_get(nr_segs * sizeof(*kiov));
+    if (!kiov)
+    {
+        return -ENOMEM;
+    }
+    lwp_get_from_user(kiov, (void *)iov, nr_segs * sizeof(*kiov));
+
+    for (i = 0; i < nr_segs; i++)
+    {
+        char *base = kiov[i].iov_base;
+        size_t left = kiov[i].iov_len;
+
+        while (left > 0)
+        {
+            void *page = RT_NULL;
+            size_t chunk;
+
+            /* the whole pages are referenced, the rest is copied */
+            if (((rt_ubase_t)base & ARCH_PAGE_MASK) == 0 && left >= ARCH_PAGE_SIZE)
+            {
+                page = lwp_user_page_get(lwp, base);
+            }
+
+            if (page)
+            {
+                chunk = ARCH_PAGE_SIZE;
+                len = rt_pipe_put_page(fd, page, chunk);
+                if (len < 0)
+                {
+                    rt_pages_free(page, 0);
+                }
+            }
+            else
+            {
+                chunk = ARCH_PAGE_SIZE - ((rt_ubase_t)base & ARCH_PAGE_MASK);
+                chunk = chunk < left ? chunk : left;
+                len = sys_write(fd, base, chunk);
+            }
+
+            if (len <= 0)
+            {
+                goto __exit;
+            }
+            ret += len;
+            base += len;
+            left -= len;
+            if (len < chunk)
+            {
+                goto __exit;
+            }
+        }
+    }
+
+__exit:
+    kmem_put(kiov);
+
+    return ret > 0 ? ret : len;
+#else
+    return -ENOSYS;
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+}
+
 sysret_t sys_fsync(int fd)
 {
     int res = fsync(fd);
@@ -4995,6 +6259,16 @@ const static struct rt_syscall_def func_table[] =
     SYSCALL_SIGN(sys_statfs64),
     SYSCALL_SIGN(sys_fstatfs),
     SYSCALL_SIGN(sys_fstatfs64),
+    SYSCALL_SIGN(sys_getrusage),                        /* 175 */
+    SYSCALL_SIGN(sys_times),
+    SYSCALL_SIGN(sys_getaffinity),
+    SYSCALL_SIGN(sys_sched_setattr),
+    SYSCALL_SIGN(sys_sched_getattr),
+    SYSCALL_NET(SYSCALL_SIGN(sys_socketpair)),          /* 180 */
+    SYSCALL_NET(SYSCALL_SIGN(sys_sendmsg)),
+    SYSCALL_NET(SYSCALL_SIGN(sys_recvmsg)),
+    SYSCALL_SIGN(sys_sched_group_ctl),
+    SYSCALL_SIGN(sys_vmsplice),
 };
 
 const void *lwp_get_sys_api(rt_uint32_t number)
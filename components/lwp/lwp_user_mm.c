@@ -28,6 +28,7 @@
 #include <mm_fault.h>
 #include <mm_flag.h>
 #include <mm_page.h>
+#include <mm_private.h>
 #include <mmu.h>
 #include <page.h>
 
@@ -115,12 +116,49 @@ static const char *user_get_name(rt_varea_t varea)
 #define NO_AUTO_FETCH               0x1
 #define VAREA_CAN_AUTO_FETCH(varea) (!((rt_ubase_t)((varea)->data) & NO_AUTO_FETCH))
 
+static void *_user_page_alloc(struct rt_varea *varea)
+{
+    void *page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+
+#ifdef LWP_USING_MEM_GROUP
+    if (!page && lwp_oom_reclaim(varea->aspace) == RT_EOK)
+    {
+        page = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+    }
+#endif /* LWP_USING_MEM_GROUP */
+
+    return page;
+}
+
+static void _user_anon_page_fault(struct rt_varea *varea,
+                                  struct rt_aspace_fault_msg *msg)
+{
+    rt_mm_dummy_mapper.on_page_fault(varea, msg);
+
+#ifdef LWP_USING_MEM_GROUP
+    /* the dummy mapper fails only if it's out of page */
+    if (msg->response.status != MM_FAULT_STATUS_OK &&
+        lwp_oom_reclaim(varea->aspace) == RT_EOK)
+    {
+        rt_mm_dummy_mapper.on_page_fault(varea, msg);
+    }
+#endif /* LWP_USING_MEM_GROUP */
+}
+
 static void _user_do_page_fault(struct rt_varea *varea,
                                 struct rt_aspace_fault_msg *msg)
 {
     struct rt_lwp_objs *lwp_objs;
     lwp_objs = rt_container_of(varea->mem_obj, struct rt_lwp_objs, mem_obj);
 
+#ifdef LWP_USING_MEM_GROUP
+    if (lwp_mem_charge(varea->aspace) != RT_EOK)
+    {
+        LOG_W("%s: memory group limit reached at %p", __func__, msg->fault_vaddr);
+        return;
+    }
+#endif /* LWP_USING_MEM_GROUP */
+
     if (lwp_objs->source)
     {
         char *paddr = rt_hw_mmu_v2p(lwp_objs->source, msg->fault_vaddr);
@@ -131,7 +169,7 @@ static void _user_do_page_fault(struct rt_varea *varea,
 
             if (!(varea->flag & MMF_TEXT))
             {
-                void *cp = rt_pages_alloc_ext(0, PAGE_ANY_AVAILABLE);
+                void *cp = _user_page_alloc(varea);
                 if (cp)
                 {
                     memcpy(cp, vaddr, ARCH_PAGE_SIZE);
@@ -159,13 +197,13 @@ static void _user_do_page_fault(struct rt_varea *varea,
         else if (!(varea->flag & MMF_TEXT))
         {
             /* if data segment not exist in source do a fallback */
-            rt_mm_dummy_mapper.on_page_fault(varea, msg);
+            _user_anon_page_fault(varea, msg);
         }
     }
     else if (VAREA_CAN_AUTO_FETCH(varea))
     {
         /* if (!lwp_objs->source), no aspace as source data */
-        rt_mm_dummy_mapper.on_page_fault(varea, msg);
+        _user_anon_page_fault(varea, msg);
     }
 }
 
@@ -494,7 +532,11 @@ rt_base_t lwp_brk(void *addr)
         {
             size = (((size_t)addr - lwp->end_heap) + ARCH_PAGE_SIZE - 1) &
                    ~ARCH_PAGE_MASK;
-            va = lwp_map_user(lwp, (void *)lwp->end_heap, size, 0);
+            if (lwp_mem_as_check(lwp, size) == RT_EOK &&
+                lwp_mem_data_check(lwp, size) == RT_EOK)
+            {
+                va = lwp_map_user(lwp, (void *)lwp->end_heap, size, 0);
+            }
         }
         if (va)
         {
@@ -515,8 +557,16 @@ void *lwp_mmap2(void *addr, size_t length, int prot, int flags, int fd,
 
     if (fd == -1)
     {
+        struct rt_lwp *lwp = lwp_self();
 
-        ret = lwp_map_user(lwp_self(), addr, length, 0);
+        if (lwp_mem_as_check(lwp, length) == RT_EOK)
+        {
+            ret = lwp_map_user(lwp, addr, length, 0);
+        }
+        else
+        {
+            ret = RT_NULL;
+        }
 
         if (ret)
         {
@@ -535,7 +585,8 @@ void *lwp_mmap2(void *addr, size_t length, int prot, int flags, int fd,
         struct dfs_file *d;
 
         d = fd_get(fd);
-        if (d && d->vnode->type == FT_DEVICE)
+        if (d && d->vnode->type == FT_DEVICE &&
+            lwp_mem_as_check(lwp_self(), length) == RT_EOK)
         {
             struct dfs_mmap2_args mmap2;
 
@@ -680,6 +731,29 @@ int lwp_user_accessable(void *addr, size_t size)
     return 1;
 }
 
+/* reference the page mapped at vaddr, only the pages of the process are counted */
+void *lwp_user_page_get(struct rt_lwp *lwp, void *vaddr)
+{
+    void *page = RT_NULL;
+    void *paddr;
+    rt_varea_t varea;
+
+    RD_LOCK(lwp->aspace);
+    varea = _aspace_bst_search(lwp->aspace, vaddr);
+    if (varea && varea->mem_obj == &lwp->lwp_obj->mem_obj)
+    {
+        paddr = _lwp_v2p(lwp, vaddr);
+        if (paddr != ARCH_MAP_FAILED)
+        {
+            page = (char *)paddr - PV_OFFSET;
+            rt_page_ref_inc(page, 0);
+        }
+    }
+    RD_UNLOCK(lwp->aspace);
+
+    return page;
+}
+
 /* src is in mmu_info space, dst is in current thread space */
 size_t lwp_data_get(struct rt_lwp *lwp, void *dst, void *src, size_t size)
 {
@@ -52,6 +52,7 @@ int lwp_user_accessable(void *addr, size_t size);
 size_t lwp_data_get(struct rt_lwp *lwp, void *dst, void *src, size_t size);
 size_t lwp_data_put(struct rt_lwp *lwp, void *dst, void *src, size_t size);
 void lwp_data_cache_flush(struct rt_lwp *lwp, void *vaddr, size_t size);
+void *lwp_user_page_get(struct rt_lwp *lwp, void *vaddr);
 
 static inline void *_lwp_v2p(struct rt_lwp *lwp, void *vaddr)
 {
@@ -27,6 +27,7 @@
 #include "mm_flag.h"
 #include "mm_page.h"
 #include "mm_private.h"
+#include "mm_tlb.h"
 
 #include <mmu.h>
 #include <tlb.h>
@@ -35,6 +36,8 @@ static void *_find_free(rt_aspace_t aspace, void *prefer, rt_size_t req_size,
                         void *limit_start, rt_size_t limit_size,
                         mm_flag_t flags);
 static void _varea_uninstall(rt_varea_t varea);
+static void _varea_unmap(rt_varea_t varea, struct rt_tlb_batch *batch);
+static void _varea_release(rt_varea_t varea);
 
 struct rt_aspace rt_kernel_space;
 
@@ -56,6 +59,9 @@ rt_err_t rt_aspace_init(rt_aspace_t aspace, void *start, rt_size_t length, void
         aspace->page_table = pgtbl;
         aspace->start = start;
         aspace->size = length;
+        aspace->vsz = 0;
+        aspace->rss = 0;
+        aspace->rss_group = RT_NULL;
 
         err = _aspace_bst_init(aspace);
         if (err == RT_EOK)
@@ -102,12 +108,24 @@ rt_aspace_t rt_aspace_create(void *start, rt_size_t length, void *pgtbl)
 
 void rt_aspace_detach(rt_aspace_t aspace)
 {
+    struct rt_tlb_batch batch;
+    rt_tlb_batch_init(&batch, aspace);
+
     WR_LOCK(aspace);
+    /* invalidate the TLB once for all the vareas, before any frame is freed */
     rt_varea_t varea = ASPACE_VAREA_FIRST(aspace);
     while (varea)
+    {
+        _varea_unmap(varea, &batch);
+        varea = ASPACE_VAREA_NEXT(varea);
+    }
+    rt_tlb_batch_flush(&batch);
+
+    varea = ASPACE_VAREA_FIRST(aspace);
+    while (varea)
     {
         rt_varea_t prev = varea;
-        _varea_uninstall(varea);
+        _varea_release(varea);
 
         varea = ASPACE_VAREA_NEXT(varea);
         if (!(prev->flag & MMF_STATIC_ALLOC))
@@ -163,7 +181,8 @@ rt_inline void _do_page_fault(struct rt_aspace_fault_msg *msg, rt_size_t off,
     mem_obj->on_page_fault(varea, msg);
 }
 
-int _varea_map_with_msg(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
+static int _do_map_with_msg(rt_varea_t varea, struct rt_aspace_fault_msg *msg,
+                            struct rt_tlb_batch *batch)
 {
     int err = -RT_ERROR;
     if (msg->response.status == MM_FAULT_STATUS_OK)
@@ -193,7 +212,7 @@ int _varea_map_with_msg(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
             }
             else
             {
-                rt_hw_tlb_invalidate_range(varea->aspace, v_addr, store_sz, ARCH_PAGE_SIZE);
+                rt_tlb_batch_add(batch, v_addr, store_sz);
                 err = RT_EOK;
             }
         }
@@ -217,24 +236,40 @@ int _varea_map_with_msg(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
     return err;
 }
 
+int _varea_map_with_msg(rt_varea_t varea, struct rt_aspace_fault_msg *msg)
+{
+    int err;
+    struct rt_tlb_batch batch;
+
+    rt_tlb_batch_init(&batch, varea->aspace);
+    err = _do_map_with_msg(varea, msg, &batch);
+    rt_tlb_batch_flush(&batch);
+
+    return err;
+}
+
 /* allocate memory page for mapping range */
 static int _do_prefetch(rt_aspace_t aspace, rt_varea_t varea, void *start,
                         rt_size_t size)
 {
     int err = RT_EOK;
+    struct rt_tlb_batch batch;
 
     /* it's ensured by caller that start & size ara page-aligned */
     char *end = (char *)start + size;
     char *vaddr = start;
     rt_size_t off = varea->offset + ((vaddr - (char *)varea->start) >> ARCH_PAGE_SHIFT);
 
+    /* the pages are mapped one by one, and invalidated at once */
+    rt_tlb_batch_init(&batch, aspace);
+
     while (vaddr != end)
     {
         /* TODO try to map with huge TLB, when flag & HUGEPAGE */
         struct rt_aspace_fault_msg msg;
         _do_page_fault(&msg, off, vaddr, varea->mem_obj, varea);
 
-        if (_varea_map_with_msg(varea, &msg))
+        if (_do_map_with_msg(varea, &msg, &batch))
         {
             err = -RT_ENOMEM;
             break;
@@ -249,6 +284,7 @@ static int _do_prefetch(rt_aspace_t aspace, rt_varea_t varea, void *start,
         vaddr += msg.response.size;
         off += msg.response.size >> ARCH_PAGE_SHIFT;
     }
+    rt_tlb_batch_flush(&batch);
 
     return err;
 }
@@ -273,6 +309,7 @@ static int _varea_install(rt_aspace_t aspace, rt_varea_t varea, rt_mm_va_hint_t
     {
         varea->start = alloc_va;
         _aspace_bst_insert(aspace, varea);
+        aspace->vsz += varea->size;
     }
     else
     {
@@ -298,26 +335,48 @@ static inline void _varea_post_install(rt_varea_t varea, rt_aspace_t aspace,
 }
 
 /**
- * restore context modified by varea install
- * caller must NOT hold the aspace lock
+ * unmap the varea from MMU, the TLB is invalidated when the batch is flushed
  */
-static void _varea_uninstall(rt_varea_t varea)
+static void _varea_unmap(rt_varea_t varea, struct rt_tlb_batch *batch)
 {
-    rt_aspace_t aspace = varea->aspace;
-
     if (varea->mem_obj && varea->mem_obj->on_varea_close)
         varea->mem_obj->on_varea_close(varea);
 
-    rt_hw_mmu_unmap(aspace, varea->start, varea->size);
-    rt_hw_tlb_invalidate_range(aspace, varea->start, varea->size, ARCH_PAGE_SIZE);
+    rt_hw_mmu_unmap(varea->aspace, varea->start, varea->size);
+    rt_tlb_batch_add(batch, varea->start, varea->size);
+}
+
+/**
+ * free the frames of the varea and remove it from aspace,
+ * after its TLB is invalidated
+ */
+static void _varea_release(rt_varea_t varea)
+{
+    rt_aspace_t aspace = varea->aspace;
 
     rt_varea_pgmgr_pop_all(varea);
 
     WR_LOCK(aspace);
     _aspace_bst_remove(aspace, varea);
+    aspace->vsz -= varea->size;
     WR_UNLOCK(aspace);
 }
 
+/**
+ * restore context modified by varea install
+ * caller must NOT hold the aspace lock
+ */
+static void _varea_uninstall(rt_varea_t varea)
+{
+    struct rt_tlb_batch batch;
+
+    rt_tlb_batch_init(&batch, varea->aspace);
+    _varea_unmap(varea, &batch);
+    rt_tlb_batch_flush(&batch);
+
+    _varea_release(varea);
+}
+
 static int _mm_aspace_map(rt_aspace_t aspace, rt_varea_t varea, rt_size_t attr,
                           mm_flag_t flags, rt_mem_obj_t mem_obj,
                           rt_size_t offset)
@@ -56,6 +56,10 @@ typedef struct rt_aspace
     struct rt_mutex bst_lock;
 
     rt_uint64_t asid;
+
+    rt_size_t vsz;          /* bytes of the vareas, protected by the bst_lock */
+    rt_size_t rss;          /* page frames owned by the vareas, protected by the pgtbl_lock */
+    rt_atomic_t *rss_group; /* the counter of a group also charged with the frames, or RT_NULL */
 } *rt_aspace_t;
 
 typedef struct rt_varea
@@ -226,6 +230,26 @@ int rt_varea_map_range(rt_varea_t varea, void *vaddr, void *paddr, rt_size_t len
  */
 void rt_varea_pgmgr_insert(rt_varea_t varea, void *page_addr);
 
+/**
+ * @brief Charge or uncharge the resident set of address space with page
+ * frames not managed by the page manager of varea, like the shared memory
+ *
+ * @param aspace target address space
+ * @param npages number of pages
+ */
+void rt_aspace_rss_charge(rt_aspace_t aspace, rt_size_t npages);
+
+void rt_aspace_rss_uncharge(rt_aspace_t aspace, rt_size_t npages);
+
+/**
+ * @brief Set the counter of a group charged with the resident set of
+ * address space, the pages charged already are moved to the new group
+ *
+ * @param aspace target address space
+ * @param group the counter of the group, RT_NULL for none
+ */
+void rt_aspace_rss_group_set(rt_aspace_t aspace, rt_atomic_t *group);
+
 rt_ubase_t rt_kmem_pvoff(void);
 
 void rt_kmem_pvoff_set(rt_ubase_t pvoff);
@@ -9,6 +9,7 @@
  */
 
 #include <rtthread.h>
+#include <rtatomic.h>
 
 #include "mm_aspace.h"
 #include "mm_fault.h"
@@ -24,10 +25,48 @@ static const char *get_name(rt_varea_t varea)
     return "dummy-mapper";
 }
 
+void rt_aspace_rss_charge(rt_aspace_t aspace, rt_size_t npages)
+{
+    MM_PGTBL_LOCK(aspace);
+    aspace->rss += npages;
+    if (aspace->rss_group)
+    {
+        rt_atomic_add(aspace->rss_group, npages);
+    }
+    MM_PGTBL_UNLOCK(aspace);
+}
+
+void rt_aspace_rss_uncharge(rt_aspace_t aspace, rt_size_t npages)
+{
+    MM_PGTBL_LOCK(aspace);
+    aspace->rss -= npages;
+    if (aspace->rss_group)
+    {
+        rt_atomic_sub(aspace->rss_group, npages);
+    }
+    MM_PGTBL_UNLOCK(aspace);
+}
+
+void rt_aspace_rss_group_set(rt_aspace_t aspace, rt_atomic_t *group)
+{
+    MM_PGTBL_LOCK(aspace);
+    if (aspace->rss_group)
+    {
+        rt_atomic_sub(aspace->rss_group, aspace->rss);
+    }
+    aspace->rss_group = group;
+    if (group)
+    {
+        rt_atomic_add(group, aspace->rss);
+    }
+    MM_PGTBL_UNLOCK(aspace);
+}
+
 void rt_varea_pgmgr_insert(rt_varea_t varea, void *page_addr)
 {
     rt_page_t page = rt_page_addr2page(page_addr);
 
+    page->pre = NULL;
     if (varea->frames == NULL)
     {
         varea->frames = page;
@@ -39,11 +78,14 @@ void rt_varea_pgmgr_insert(rt_varea_t varea, void *page_addr)
         page->next = varea->frames;
         varea->frames = page;
     }
+
+    rt_aspace_rss_charge(varea->aspace, 1);
 }
 
 void rt_varea_pgmgr_pop_all(rt_varea_t varea)
 {
     rt_page_t page = varea->frames;
+    rt_size_t npages = 0;
 
     while (page)
     {
@@ -51,20 +93,33 @@ void rt_varea_pgmgr_pop_all(rt_varea_t varea)
         void *pg_va = rt_page_page2addr(page);
         rt_pages_free(pg_va, 0);
         page = next;
+        npages++;
     }
+    varea->frames = NULL;
+
+    rt_aspace_rss_uncharge(varea->aspace, npages);
 }
 
 void rt_varea_pgmgr_pop(rt_varea_t varea, void *vaddr, rt_size_t size)
 {
     void *vend = (char *)vaddr + size;
+    rt_size_t npages = 0;
+
     while (vaddr != vend)
     {
         rt_page_t page = rt_page_addr2page(vaddr);
-        page->pre->next = page->next;
-        page->next->pre = page->pre;
+        if (page->pre)
+            page->pre->next = page->next;
+        else
+            varea->frames = page->next;
+        if (page->next)
+            page->next->pre = page->pre;
         rt_pages_free(vaddr, 0);
         vaddr = (char *)vaddr + ARCH_PAGE_SIZE;
+        npages++;
     }
+
+    rt_aspace_rss_uncharge(varea->aspace, npages);
 }
 
 static void on_page_fault(struct rt_varea *varea, struct rt_aspace_fault_msg *msg)
@@ -42,6 +42,9 @@ static struct rt_varea mpr_varea;
 
 static struct rt_page *page_list_low[RT_PAGE_MAX_ORDER];
 static struct rt_page *page_list_high[RT_PAGE_MAX_ORDER];
+/* free blocks in each order of the lists, kept for the readers of statistics */
+static rt_size_t page_free_low[RT_PAGE_MAX_ORDER];
+static rt_size_t page_free_high[RT_PAGE_MAX_ORDER];
 
 #define page_start ((rt_page_t)rt_mpr_start)
 
@@ -260,6 +263,11 @@ static inline struct rt_page *_buddy_get(struct rt_page *p,
     return rt_page_addr2page((void *)addr);
 }
 
+rt_inline rt_size_t *_page_free_nr(rt_page_t page_list[])
+{
+    return page_list == page_list_high ? page_free_high : page_free_low;
+}
+
 static void _page_remove(rt_page_t page_list[], struct rt_page *p, rt_uint32_t size_bits)
 {
     if (p->pre)
@@ -276,6 +284,7 @@ static void _page_remove(rt_page_t page_list[], struct rt_page *p, rt_uint32_t s
         p->next->pre = p->pre;
     }
 
+    _page_free_nr(page_list)[size_bits]--;
     p->size_bits = ARCH_ADDRESS_WIDTH_BITS;
 }
 
@@ -288,6 +297,7 @@ static void _page_insert(rt_page_t page_list[], struct rt_page *p, rt_uint32_t s
     }
     p->pre = 0;
     page_list[size_bits] = p;
+    _page_free_nr(page_list)[size_bits]++;
     p->size_bits = size_bits;
 }
 
@@ -412,6 +422,7 @@ static void _early_page_remove(rt_page_t page_list[], rt_page_t page, rt_uint32_
         next_cont->pre = page_cont->pre;
     }
 
+    _page_free_nr(page_list)[size_bits]--;
     page_cont->size_bits = ARCH_ADDRESS_WIDTH_BITS;
 }
 
@@ -429,6 +440,7 @@ static void _early_page_insert(rt_page_t page_list[], rt_page_t page, int size_b
     }
     page_cont->pre = 0;
     page_list[size_bits] = page;
+    _page_free_nr(page_list)[size_bits]++;
     page_cont->size_bits = size_bits;
 }
 
@@ -644,32 +656,37 @@ void rt_page_get_info(rt_size_t *total_nr, rt_size_t *free_nr)
 {
     int i;
     rt_size_t total_free = 0;
-    rt_base_t level;
 
-    level = rt_hw_interrupt_disable();
+    /* the counters are read without lock, the result is a snapshot */
     for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
     {
-        struct rt_page *p = page_list_low[i];
-
-        while (p)
-        {
-            total_free += (1UL << i);
-            p = p->next;
-        }
+        total_free += (page_free_low[i] + page_free_high[i]) << i;
     }
+    *total_nr = page_nr;
+    *free_nr = total_free;
+}
+
+/**
+ * @brief Get the number of free blocks in each order of the buddy system
+ *
+ * @param low the buffer of RT_PAGE_MAX_ORDER counters for the low memory, can be RT_NULL
+ * @param high the buffer of RT_PAGE_MAX_ORDER counters for the high memory, can be RT_NULL
+ */
+void rt_page_get_buddyinfo(rt_size_t *low, rt_size_t *high)
+{
+    int i;
+
     for (i = 0; i < RT_PAGE_MAX_ORDER; i++)
     {
-        struct rt_page *p = page_list_high[i];
-
-        while (p)
+        if (low)
         {
-            total_free += (1UL << i);
-            p = p->next;
+            low[i] = page_free_low[i];
+        }
+        if (high)
+        {
+            high[i] = page_free_high[i];
         }
     }
-    rt_hw_interrupt_enable(level);
-    *total_nr = page_nr;
-    *free_nr = total_free;
 }
 
 static void _install_page(rt_page_t mpr_head, rt_region_t region, void *insert_handler)
@@ -755,6 +772,8 @@ void rt_page_init(rt_region_t reg)
     {
         page_list_low[i] = 0;
         page_list_high[i] = 0;
+        page_free_low[i] = 0;
+        page_free_high[i] = 0;
     }
 
     /* map MPR area */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+
+#include "mm_aspace.h"
+#include "mm_tlb.h"
+
+#include <mmu.h>
+#include <tlb.h>
+
+void rt_tlb_batch_init(struct rt_tlb_batch *batch, rt_aspace_t aspace)
+{
+    RT_ASSERT(batch);
+
+    batch->aspace = aspace;
+    batch->nr_ranges = 0;
+}
+
+void rt_tlb_batch_add(struct rt_tlb_batch *batch, void *start, rt_size_t size)
+{
+    rt_size_t i;
+    char *end = (char *)start + size;
+    struct _mm_tlb_range *range;
+
+    RT_ASSERT(batch);
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < batch->nr_ranges; i++)
+    {
+        range = &batch->ranges[i];
+        if ((char *)start <= range->end && end >= range->start)
+        {
+            range->start = (char *)start < range->start ? (char *)start : range->start;
+            range->end = end > range->end ? end : range->end;
+            return;
+        }
+    }
+
+    if (batch->nr_ranges == MM_TLB_BATCH_RANGES)
+    {
+        /* fold all of them and the new one into the first one */
+        range = &batch->ranges[0];
+        for (i = 1; i < batch->nr_ranges; i++)
+        {
+            if (batch->ranges[i].start < range->start)
+                range->start = batch->ranges[i].start;
+            if (batch->ranges[i].end > range->end)
+                range->end = batch->ranges[i].end;
+        }
+        if ((char *)start < range->start)
+            range->start = start;
+        if (end > range->end)
+            range->end = end;
+        batch->nr_ranges = 1;
+        return;
+    }
+
+    range = &batch->ranges[batch->nr_ranges++];
+    range->start = start;
+    range->end = end;
+}
+
+void rt_tlb_batch_flush(struct rt_tlb_batch *batch)
+{
+    rt_size_t i;
+    struct _mm_tlb_range *range;
+
+    RT_ASSERT(batch);
+
+    for (i = 0; i < batch->nr_ranges; i++)
+    {
+        range = &batch->ranges[i];
+        rt_hw_tlb_invalidate_range(batch->aspace, range->start,
+                                   range->end - range->start, ARCH_PAGE_SIZE);
+    }
+    batch->nr_ranges = 0;
+}
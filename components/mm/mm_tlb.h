@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+#ifndef __MM_TLB_H__
+#define __MM_TLB_H__
+
+#include <rtthread.h>
+#include <stddef.h>
+
+#include "mm_aspace.h"
+
+#define MM_TLB_BATCH_RANGES 4
+
+/**
+ * @brief A batch of the TLB invalidations of an aspace
+ *
+ * The ranges unmapped or changed one by one are gathered in the batch and
+ * the TLB is invalidated once when the batch is flushed, so a teardown of
+ * many vareas interrupts the other cores once instead of once per varea.
+ * The page frames of the ranges must not be freed before the flush.
+ */
+struct rt_tlb_batch
+{
+    rt_aspace_t aspace;
+    rt_size_t nr_ranges;
+    struct _mm_tlb_range
+    {
+        char *start;
+        char *end;
+    } ranges[MM_TLB_BATCH_RANGES];
+};
+
+void rt_tlb_batch_init(struct rt_tlb_batch *batch, rt_aspace_t aspace);
+
+/**
+ * @brief Add a range to invalidate into the batch
+ *
+ * The range adjacent to or overlapping a range in the batch is merged with
+ * it. If the batch is full, all the ranges are merged into the one covering
+ * them, and the architecture chooses how to invalidate it by its size.
+ *
+ * @param batch the batch
+ * @param start the start of the range
+ * @param size the size of the range
+ */
+void rt_tlb_batch_add(struct rt_tlb_batch *batch, void *start, rt_size_t size);
+
+/**
+ * @brief Invalidate the TLB of all the ranges in the batch, and empty it
+ *
+ * @param batch the batch
+ */
+void rt_tlb_batch_flush(struct rt_tlb_batch *batch);
+
+#endif /* __MM_TLB_H__ */
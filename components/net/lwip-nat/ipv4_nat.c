@@ -31,23 +31,34 @@
  * Date           Author       Notes
  * 2015-01-26     Hichard      porting to RT-Thread
  * 2015-01-27     Bernard      code cleanup for lwIP in RT-Thread
+ * 2023-10-18     RT-Thread    hash the connections and expire them by a timer wheel
  */
 
 /*
  * TODOS:
- *  - we should decide if we want to use static tables for NAT or a linked
- *    list.
  *  - we should allocate icmp ping id if multiple clients are sending
  *    ping requests.
- *  - maybe we could hash the identifiers for TCP, ICMP and UDP and use
- *    a single table structure. This would reduce the code amount although
- *    it will cost performance.
  *  - NAT code must check for broadcast addresses and NOT forward
  *    them.
  *
  *  - netif_remove must notify NAT code when a NAT'ed interface is removed
- *  - allocate NAT entries from a new memp pool instead of the heap
- *  - let ttl be ticks, not seconds
+ *
+ * CONNECTION TRACKING:
+ *
+ * A translated flow is an ip_nat_conn_t, allocated from memory pools of
+ * LWIP_NAT_CONN_CHUNK entries, which are created on demand up to
+ * LWIP_NAT_CONN_MAX entries and deleted by the timer when unused.
+ *
+ * A connection is linked in two hash tables, by the 5-tuple of the outgoing
+ * direction (proto, source, dest, sport, dport) and by the one of the incoming
+ * direction (proto, dest, dport, nport), so a packet in either direction is
+ * matched in O(1). The translated port (nport) is taken from a bitmap of the
+ * protocol, it is unique, so the incoming tuple is unique as well.
+ *
+ * The connection is also linked in the slot of the timer wheel for its
+ * expiry tick. A packet only updates the expiry tick, the connection is moved
+ * to the right slot when the timer visits its old slot, so ip_nat_tmr() only
+ * walks one slot per tick instead of all the connections.
  *
  * HOWTO USE:
  *
@@ -81,30 +92,80 @@
 #include "lwip/udp.h"
 #include "lwip/mem.h"
 #include "lwip/sys.h"
+#include "lwip/tcpip.h"
 #include "lwip/timers.h"
 #include "netif/etharp.h"
 
 #include <limits.h>
 #include <string.h>
 
+#ifndef RT_USING_MEMPOOL
+#error "lwIP NAT allocates the connections from memory pools, please enable RT_USING_MEMPOOL"
+#endif
+
 /** Define this to enable debug output of this module */
 #ifndef LWIP_NAT_DEBUG
 #define LWIP_NAT_DEBUG      LWIP_DBG_OFF
 #endif
 
-#define LWIP_NAT_TTL_INFINITE                    (INT_MAX)
+/** The max number of the connections, rounded up to LWIP_NAT_CONN_CHUNK */
+#ifndef LWIP_NAT_CONN_MAX
+#define LWIP_NAT_CONN_MAX                        (1024)
+#endif
+
+/** The number of the connections of a memory pool */
+#ifndef LWIP_NAT_CONN_CHUNK
+#define LWIP_NAT_CONN_CHUNK                      (64)
+#endif
+
+/** The buckets of each hash table, must be a power of 2 */
+#ifndef LWIP_NAT_HASH_SIZE
+#define LWIP_NAT_HASH_SIZE                       (256)
+#endif
+
+/** The slots of the timer wheel, must be a power of 2 */
+#ifndef LWIP_NAT_WHEEL_SIZE
+#define LWIP_NAT_WHEEL_SIZE                      (64)
+#endif
+
+/** The translated ports of TCP and UDP, the range is a multiple of 32 */
+#ifndef LWIP_NAT_PORT_MIN
+#define LWIP_NAT_PORT_MIN                        (40000)
+#endif
+#ifndef LWIP_NAT_PORT_RANGE
+#define LWIP_NAT_PORT_RANGE                      (8192)
+#endif
+
+#if (LWIP_NAT_HASH_SIZE & (LWIP_NAT_HASH_SIZE - 1)) || (LWIP_NAT_WHEEL_SIZE & (LWIP_NAT_WHEEL_SIZE - 1))
+#error "LWIP_NAT_HASH_SIZE and LWIP_NAT_WHEEL_SIZE must be powers of 2"
+#endif
+#if (LWIP_NAT_PORT_RANGE % 32) || (LWIP_NAT_PORT_MIN + LWIP_NAT_PORT_RANGE > 65536)
+#error "LWIP_NAT_PORT_RANGE must be a multiple of 32 and end below 65536"
+#endif
+
 #define LWIP_NAT_DEFAULT_TTL_SECONDS             (128)
+#define LWIP_NAT_DEFAULT_TTL_TICKS               ((LWIP_NAT_DEFAULT_TTL_SECONDS + LWIP_NAT_TMR_INTERVAL_SEC - 1) / \
+                                                  LWIP_NAT_TMR_INTERVAL_SEC)
 #define LWIP_NAT_FORWARD_HEADER_SIZE_MIN         (sizeof(struct eth_hdr))
 
-#define LWIP_NAT_DEFAULT_STATE_TABLES_ICMP       (4)
-#define LWIP_NAT_DEFAULT_STATE_TABLES_TCP        (32)
-#define LWIP_NAT_DEFAULT_STATE_TABLES_UDP        (32)
-
-#define LWIP_NAT_DEFAULT_TCP_SOURCE_PORT         (40000)
-#define LWIP_NAT_DEFAULT_UDP_SOURCE_PORT         (40000)
+#define LWIP_NAT_POOLS                           ((LWIP_NAT_CONN_MAX + LWIP_NAT_CONN_CHUNK - 1) / LWIP_NAT_CONN_CHUNK)
+#define LWIP_NAT_PORT_WORDS                      (LWIP_NAT_PORT_RANGE / 32)
+
+/* link the connection at the head of a hash chain or a slot of the wheel */
+#define IPNAT_LINK(head, conn, field) do { \
+  (conn)->field##_next = *(head); \
+  if (*(head) != NULL) { \
+    (*(head))->field##_pprev = &(conn)->field##_next; \
+  } \
+  (conn)->field##_pprev = (head); \
+  *(head) = (conn); \
+} while(0)
 
-#define IPNAT_ENTRY_RESET(x) do { \
-  (x)->ttl = 0; \
+#define IPNAT_UNLINK(conn, field) do { \
+  *(conn)->field##_pprev = (conn)->field##_next; \
+  if ((conn)->field##_next != NULL) { \
+    (conn)->field##_next->field##_pprev = (conn)->field##_pprev; \
+  } \
 } while(0)
 
 typedef struct ip_nat_conf
@@ -113,54 +174,42 @@ typedef struct ip_nat_conf
   ip_nat_entry_t      entry;
 } ip_nat_conf_t;
 
-typedef struct ip_nat_entry_common
+/** A translated connection, the ports are in network byte order */
+typedef struct ip_nat_conn
 {
-  s32_t           ttl; /* @todo: do we really need this to be signed?? */
-  ip_addr_t       source;
-  ip_addr_t       dest;
-  ip_nat_conf_t   *cfg;
-} ip_nat_entry_common_t;
+  struct ip_nat_conn  *out_next;    /* chain of the outgoing hash table */
+  struct ip_nat_conn **out_pprev;
+  struct ip_nat_conn  *in_next;     /* chain of the incoming hash table */
+  struct ip_nat_conn **in_pprev;
+  struct ip_nat_conn  *tmr_next;    /* slot of the timer wheel */
+  struct ip_nat_conn **tmr_pprev;
+  u32_t                expire;      /* in ticks of ip_nat_tmr() */
+  ip_addr_t            source;
+  ip_addr_t            dest;
+  ip_nat_conf_t       *cfg;
+  u16_t                sport;       /* ICMP: the id */
+  u16_t                dport;       /* ICMP: the seqno */
+  u16_t                nport;       /* ICMP: the id */
+  u8_t                 proto;
+} ip_nat_conn_t;
 
-typedef struct ip_nat_entries_icmp
-{
-  ip_nat_entry_common_t common;
-  u16_t                 id;
-  u16_t                 seqno;
-} ip_nat_entries_icmp_t;
-
-typedef struct ip_nat_entries_tcp
-{
-  ip_nat_entry_common_t common;
-  u16_t                 nport;
-  u16_t                 sport;
-  u16_t                 dport;
-} ip_nat_entries_tcp_t;
+static ip_nat_conf_t *ip_nat_cfg = NULL;
 
-typedef struct ip_nat_entries_udp
-{
-  ip_nat_entry_common_t common;
-  u16_t                 nport;
-  u16_t                 sport;
-  u16_t                 dport;
-} ip_nat_entries_udp_t;
+static ip_nat_conn_t *ip_nat_out_table[LWIP_NAT_HASH_SIZE];
+static ip_nat_conn_t *ip_nat_in_table[LWIP_NAT_HASH_SIZE];
+static ip_nat_conn_t *ip_nat_wheel[LWIP_NAT_WHEEL_SIZE];
+static u32_t ip_nat_ticks;
+static u32_t ip_nat_seed;
 
-typedef union u_nat_entry
-{
-  ip_nat_entry_common_t *cmn;
-  ip_nat_entries_tcp_t  *tcp;
-  ip_nat_entries_icmp_t *icmp;
-  ip_nat_entries_udp_t  *udp;
-} nat_entry_t;
+static rt_mp_t ip_nat_pools[LWIP_NAT_POOLS];
 
-static ip_nat_conf_t *ip_nat_cfg = NULL;
-static ip_nat_entries_icmp_t ip_nat_icmp_table[LWIP_NAT_DEFAULT_STATE_TABLES_ICMP];
-static ip_nat_entries_tcp_t ip_nat_tcp_table[LWIP_NAT_DEFAULT_STATE_TABLES_TCP];
-static ip_nat_entries_udp_t ip_nat_udp_table[LWIP_NAT_DEFAULT_STATE_TABLES_UDP];
+static u32_t ip_nat_tcp_ports[LWIP_NAT_PORT_WORDS];
+static u32_t ip_nat_udp_ports[LWIP_NAT_PORT_WORDS];
+static u16_t ip_nat_tcp_cursor;
+static u16_t ip_nat_udp_cursor;
 
 /* ----------------------- Static functions (COMMON) --------------------*/
 static void     ip_nat_chksum_adjust(u8_t *chksum, const u8_t *optr, s16_t olen, const u8_t *nptr, s16_t nlen);
-static void     ip_nat_cmn_init(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
-                                 ip_nat_entry_common_t *nat_entry);
 static ip_nat_conf_t *ip_nat_shallnat(const struct ip_hdr *iphdr);
 static void     ip_nat_reset_state(ip_nat_conf_t *cfg);
 
@@ -168,32 +217,23 @@ static void     ip_nat_reset_state(ip_nat_conf_t *cfg);
 #if defined(LWIP_DEBUG) && (LWIP_NAT_DEBUG & LWIP_DBG_ON)
 static void     ip_nat_dbg_dump(const char *msg, const struct ip_hdr *iphdr);
 static void     ip_nat_dbg_dump_ip(const ip_addr_t *addr);
-static void     ip_nat_dbg_dump_icmp_nat_entry(const char *msg, const ip_nat_entries_icmp_t *nat_entry);
-static void     ip_nat_dbg_dump_tcp_nat_entry(const char *msg, const ip_nat_entries_tcp_t *nat_entry);
-static void     ip_nat_dbg_dump_udp_nat_entry(const char *msg, const ip_nat_entries_udp_t *nat_entry);
+static void     ip_nat_dbg_dump_conn(const char *msg, const ip_nat_conn_t *conn);
 static void     ip_nat_dbg_dump_init(ip_nat_conf_t *ip_nat_cfg_new);
 static void     ip_nat_dbg_dump_remove(ip_nat_conf_t *cur);
 #else /* defined(LWIP_DEBUG) && (LWIP_NAT_DEBUG & LWIP_DBG_ON) */
 #define ip_nat_dbg_dump(msg, iphdr)
 #define ip_nat_dbg_dump_ip(addr)
-#define ip_nat_dbg_dump_icmp_nat_entry(msg, nat_entry)
-#define ip_nat_dbg_dump_tcp_nat_entry(msg, nat_entry)
-#define ip_nat_dbg_dump_udp_nat_entry(msg, nat_entry)
+#define ip_nat_dbg_dump_conn(msg, conn)
 #define ip_nat_dbg_dump_init(ip_nat_cfg_new)
 #define ip_nat_dbg_dump_remove(cur)
 #endif /* defined(LWIP_DEBUG) && (LWIP_NAT_DEBUG & LWIP_DBG_ON) */
 
-/* ----------------------- Static functions (TCP) -----------------------*/
-static ip_nat_entries_tcp_t *ip_nat_tcp_lookup_incoming(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr);
-static ip_nat_entries_tcp_t *ip_nat_tcp_lookup_outgoing(ip_nat_conf_t *nat_config,
-                                                         const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr,
-                                                         u8_t allocate);
-
-/* ----------------------- Static functions (UDP) -----------------------*/
-static ip_nat_entries_udp_t *ip_nat_udp_lookup_incoming(const struct ip_hdr *iphdr, const struct udp_hdr *udphdr);
-static ip_nat_entries_udp_t *ip_nat_udp_lookup_outgoing(ip_nat_conf_t *nat_config,
-                                                         const struct ip_hdr *iphdr, const struct udp_hdr *udphdr,
-                                                         u8_t allocate);
+/* ----------------------- Static functions (CONNECTIONS) ---------------*/
+static ip_nat_conn_t *ip_nat_lookup_incoming(u8_t proto, const struct ip_hdr *iphdr, u16_t rport, u16_t nport);
+static ip_nat_conn_t *ip_nat_lookup_outgoing(u8_t proto, const struct ip_hdr *iphdr, u16_t sport, u16_t dport);
+static ip_nat_conn_t *ip_nat_conn_new(ip_nat_conf_t *nat_config, u8_t proto, const struct ip_hdr *iphdr,
+                                      u16_t sport, u16_t dport);
+static void     ip_nat_conn_free(ip_nat_conn_t *conn);
 
 /**
  * Timer callback function that calls ip_nat_tmr() and reschedules itself.
@@ -214,20 +254,10 @@ nat_timer(void *arg)
 void
 ip_nat_init(void)
 {
-  int i;
   extern void lwip_ip_input_set_hook(int (*hook)(struct pbuf *p, struct netif *inp));
 
-  /* @todo: this can be omitted since we trust static variables
-            to be initialized to zero */
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
-    IPNAT_ENTRY_RESET(&ip_nat_icmp_table[i].common);
-  }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    IPNAT_ENTRY_RESET(&ip_nat_tcp_table[i].common);
-  }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    IPNAT_ENTRY_RESET(&ip_nat_udp_table[i].common);
-  }
+  /* the seed makes the buckets of the flows unpredictable from outside */
+  ip_nat_seed = (u32_t)rt_tick_get() ^ (u32_t)(rt_ubase_t)&ip_nat_seed;
 
   /* we must lock scheduler to protect following code */
   rt_enter_critical();
@@ -290,7 +320,23 @@ ip_nat_add(const ip_nat_entry_t *new_entry)
   return err;
 }
 
+/** Drop the connections of a removed NAT entry and free it, in the
+ * context of the tcpip thread, which is the owner of the connections.
+ *
+ * @param arg the ip_nat_conf_t removed from the list
+ */
+static void
+ip_nat_remove_cb(void *arg)
+{
+  ip_nat_conf_t *cur = (ip_nat_conf_t *)arg;
+
+  ip_nat_reset_state(cur);
+  /* free 'cur' or there will be a memory leak */
+  ip_nat_free(cur);
+}
+
 /** Remove a NAT entry previously added by 'ip_nat_add()'.
+ * The connections of the entry are dropped later by the tcpip thread.
  *
  * @param remove_entry describes the entry to remove
  */
@@ -312,7 +358,6 @@ ip_nat_remove(const ip_nat_entry_t *remove_entry)
     {
       ip_nat_dbg_dump_remove(cur);
 
-      ip_nat_reset_state(cur);
       next = cur->next;
       if (cur == ip_nat_cfg) {
         ip_nat_cfg = next;
@@ -320,8 +365,9 @@ ip_nat_remove(const ip_nat_entry_t *remove_entry)
         LWIP_ASSERT("NULL != previous", NULL != previous);
         previous->next = next;
       }
-      /* free 'cur' or there will be a memory leak */
-      ip_nat_free(cur);
+      if (tcpip_callback(ip_nat_remove_cb, cur) != ERR_OK) {
+        ip_nat_remove_cb(cur);
+      }
       return;
     } else {
       previous = cur;
@@ -330,8 +376,7 @@ ip_nat_remove(const ip_nat_entry_t *remove_entry)
   }
 }
 
-/** Reset a NAT configured entry to be reused.
- * Effectively calls IPNAT_ENTRY_RESET() on 'cfg'.
+/** Drop all the connections of a NAT configured entry.
  *
  * @param cfg NAT entry to reset
  */
@@ -339,22 +384,15 @@ static void
 ip_nat_reset_state(ip_nat_conf_t *cfg)
 {
   int i;
-
-  /* @todo: optimize this!!!
-     why do we search for it anyway, if we have the pointer??? */
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
-    if(ip_nat_icmp_table[i].common.cfg == cfg) {
-      IPNAT_ENTRY_RESET(&ip_nat_icmp_table[i].common);
-    }
-  }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if(ip_nat_tcp_table[i].common.cfg == cfg) {
-      IPNAT_ENTRY_RESET(&ip_nat_tcp_table[i].common);
-    }
-  }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if(ip_nat_udp_table[i].common.cfg == cfg) {
-      IPNAT_ENTRY_RESET(&ip_nat_udp_table[i].common);
+  ip_nat_conn_t *conn, *next;
+
+  /* all the connections are in the wheel */
+  for (i = 0; i < LWIP_NAT_WHEEL_SIZE; i++) {
+    for (conn = ip_nat_wheel[i]; conn != NULL; conn = next) {
+      next = conn->tmr_next;
+      if (conn->cfg == cfg) {
+        ip_nat_conn_free(conn);
+      }
     }
   }
 }
@@ -421,13 +459,12 @@ ip_nat_input(struct pbuf *p)
   struct tcp_hdr       *tcphdr;
   struct udp_hdr       *udphdr;
   struct icmp_echo_hdr *icmphdr;
-  nat_entry_t           nat_entry;
+  ip_nat_conn_t        *conn = NULL;
   err_t                 err;
   u8_t                  consumed = 0;
-  int                   i;
+  u8_t                  release = 0;
   struct pbuf          *q = NULL;
 
-  nat_entry.cmn = NULL;
   ip_nat_dbg_dump("ip_nat_in: checking nat for", iphdr);
 
   switch (IPH_PROTO(iphdr)) {
@@ -436,18 +473,18 @@ ip_nat_input(struct pbuf *p)
       if (tcphdr == NULL) {
         LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_input: short tcp packet (%" U16_F " bytes) discarded\n", p->tot_len));
       } else {
-        nat_entry.tcp = ip_nat_tcp_lookup_incoming(iphdr, tcphdr);
-        if (nat_entry.tcp != NULL) {
+        conn = ip_nat_lookup_incoming(IP_PROTO_TCP, iphdr, tcphdr->src, tcphdr->dest);
+        if (conn != NULL) {
           /* Refresh TCP entry */
-          nat_entry.tcp->common.ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
-          tcphdr->dest = nat_entry.tcp->sport;
+          conn->expire = ip_nat_ticks + LWIP_NAT_DEFAULT_TTL_TICKS;
+          tcphdr->dest = conn->sport;
           /* Adjust TCP checksum for changed destination port */
           ip_nat_chksum_adjust((u8_t *)&(tcphdr->chksum),
-            (u8_t *)&(nat_entry.tcp->nport), 2, (u8_t *)&(tcphdr->dest), 2);
+            (u8_t *)&(conn->nport), 2, (u8_t *)&(tcphdr->dest), 2);
           /* Adjust TCP checksum for changing dest IP address */
           ip_nat_chksum_adjust((u8_t *)&(tcphdr->chksum),
-            (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4,
-            (u8_t *)&(nat_entry.cmn->source.addr), 4);
+            (u8_t *)&(conn->cfg->entry.out_if->ip_addr.addr), 4,
+            (u8_t *)&(conn->source.addr), 4);
 
           consumed = 1;
         }
@@ -461,18 +498,18 @@ ip_nat_input(struct pbuf *p)
           ("ip_nat_input: short udp packet (%" U16_F " bytes) discarded\n",
           p->tot_len));
       } else {
-        nat_entry.udp = ip_nat_udp_lookup_incoming(iphdr, udphdr);
-        if (nat_entry.udp != NULL) {
+        conn = ip_nat_lookup_incoming(IP_PROTO_UDP, iphdr, udphdr->src, udphdr->dest);
+        if (conn != NULL) {
           /* Refresh UDP entry */
-          nat_entry.udp->common.ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
-          udphdr->dest = nat_entry.udp->sport;
+          conn->expire = ip_nat_ticks + LWIP_NAT_DEFAULT_TTL_TICKS;
+          udphdr->dest = conn->sport;
           /* Adjust UDP checksum for changed destination port */
           ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-            (u8_t *)&(nat_entry.udp->nport), 2, (u8_t *)&(udphdr->dest), 2);
+            (u8_t *)&(conn->nport), 2, (u8_t *)&(udphdr->dest), 2);
           /* Adjust UDP checksum for changing dest IP address */
           ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-            (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4,
-            (u8_t *)&(nat_entry.cmn->source.addr), 4);
+            (u8_t *)&(conn->cfg->entry.out_if->ip_addr.addr), 4,
+            (u8_t *)&(conn->source.addr), 4);
 
           consumed = 1;
         }
@@ -487,17 +524,11 @@ ip_nat_input(struct pbuf *p)
           p->tot_len));
       } else {
         if (ICMP_ER == ICMPH_TYPE(icmphdr)) {
-          for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
-            nat_entry.icmp = &ip_nat_icmp_table[i];
-            if ((nat_entry.icmp->common.ttl) &&
-                (iphdr->src.addr == nat_entry.icmp->common.dest.addr) &&
-                (nat_entry.icmp->id == icmphdr->id) &&
-                (nat_entry.icmp->seqno == icmphdr->seqno)) {
-              ip_nat_dbg_dump_icmp_nat_entry("found existing nat entry: ", nat_entry.icmp);
-              consumed = 1;
-              IPNAT_ENTRY_RESET(nat_entry.cmn);
-              break;
-            }
+          conn = ip_nat_lookup_incoming(IP_PROTO_ICMP, iphdr, icmphdr->seqno, icmphdr->id);
+          if (conn != NULL) {
+            consumed = 1;
+            /* the echo is done, drop it after the reply is sent on */
+            release = 1;
           }
         }
       }
@@ -538,10 +569,10 @@ ip_nat_input(struct pbuf *p)
       else q = p;
     }
     /* if we come here, q is the pbuf to send (either points to p or to a chain) */
-    in_if = nat_entry.cmn->cfg->entry.in_if;
-    iphdr->dest.addr = nat_entry.cmn->source.addr;
+    in_if = conn->cfg->entry.in_if;
+    iphdr->dest.addr = conn->source.addr;
     ip_nat_chksum_adjust((u8_t *) & IPH_CHKSUM(iphdr),
-      (u8_t *) & (nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4,
+      (u8_t *) & (conn->cfg->entry.out_if->ip_addr.addr), 4,
       (u8_t *) & (iphdr->dest.addr), 4);
 
     ip_nat_dbg_dump("ip_nat_input: packet back to source after nat: ", iphdr);
@@ -549,6 +580,10 @@ ip_nat_input(struct pbuf *p)
     ip_nat_dbg_dump_ip(&(in_if->ip_addr));
     LWIP_DEBUGF(LWIP_NAT_DEBUG, (")\n"));
 
+    if (release) {
+      ip_nat_conn_free(conn);
+    }
+
     err = in_if->output(in_if, q, (ip_addr_t *)&(iphdr->dest));
     if(err != ERR_OK) {
       LWIP_DEBUGF(LWIP_NAT_DEBUG,
@@ -563,40 +598,40 @@ ip_nat_input(struct pbuf *p)
   return consumed;
 }
 
-/** Check if one NAT entry timed out */
-static void
-ip_nat_check_timeout(ip_nat_entry_common_t *nat_entry)
-{
-  if(nat_entry->ttl > 0) {
-    if(nat_entry->ttl != LWIP_NAT_TTL_INFINITE) {
-      /* this is not a 'no-timeout' entry */
-      if(nat_entry->ttl > LWIP_NAT_TMR_INTERVAL_SEC) {
-        nat_entry->ttl -= LWIP_NAT_TMR_INTERVAL_SEC;
-      } else {
-        nat_entry->ttl = 0;
-      }
-    }
-  }
-}
-
 /** The NAT timer function, to be called at an interval of
- * LWIP_NAT_TMR_INTERVAL_SEC seconds.
+ * LWIP_NAT_TMR_INTERVAL_SEC seconds. Only the connections in the slot
+ * of this tick are visited, they are either expired, or moved to the
+ * slot of their refreshed expiry tick.
  */
 void
 ip_nat_tmr(void)
 {
   int i;
+  ip_nat_conn_t *conn, *next;
+  u32_t slot;
+
+  ip_nat_ticks++;
+  slot = ip_nat_ticks & (LWIP_NAT_WHEEL_SIZE - 1);
 
   LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_tmr: removing old entries\n"));
 
-  for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
-    ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_icmp_table[i]);
-  }
-  for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_tcp_table[i]);
+  for (conn = ip_nat_wheel[slot]; conn != NULL; conn = next) {
+    next = conn->tmr_next;
+    if ((s32_t)(ip_nat_ticks - conn->expire) >= 0) {
+      ip_nat_conn_free(conn);
+    } else if ((conn->expire & (LWIP_NAT_WHEEL_SIZE - 1)) != slot) {
+      IPNAT_UNLINK(conn, tmr);
+      IPNAT_LINK(&ip_nat_wheel[conn->expire & (LWIP_NAT_WHEEL_SIZE - 1)], conn, tmr);
+    }
   }
-  for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_udp_table[i]);
+
+  /* give the unused pools back to the heap, but keep the first one */
+  for (i = 1; i < LWIP_NAT_POOLS; i++) {
+    if ((ip_nat_pools[i] != RT_NULL) &&
+        (ip_nat_pools[i]->block_free_count == ip_nat_pools[i]->block_total_count)) {
+      rt_mp_delete(ip_nat_pools[i]);
+      ip_nat_pools[i] = RT_NULL;
+    }
   }
 }
 
@@ -617,10 +652,7 @@ ip_nat_out(struct pbuf *p)
   struct tcp_hdr       *tcphdr;
   struct udp_hdr       *udphdr;
   ip_nat_conf_t        *nat_config;
-  nat_entry_t           nat_entry;
-  int             i;
-
-  nat_entry.cmn = NULL;
+  ip_nat_conn_t        *conn = NULL;
 
   ip_nat_dbg_dump("ip_nat_out: checking nat for", iphdr);
 
@@ -638,16 +670,19 @@ ip_nat_out(struct pbuf *p)
           LWIP_DEBUGF(LWIP_NAT_DEBUG,
             ("ip_nat_out: short tcp packet (%" U16_F " bytes) discarded\n", p->tot_len));
         } else {
-          nat_entry.tcp = ip_nat_tcp_lookup_outgoing(nat_config, iphdr, tcphdr, 1);
-          if (nat_entry.tcp != NULL) {
+          conn = ip_nat_lookup_outgoing(IP_PROTO_TCP, iphdr, tcphdr->src, tcphdr->dest);
+          if (conn == NULL) {
+            conn = ip_nat_conn_new(nat_config, IP_PROTO_TCP, iphdr, tcphdr->src, tcphdr->dest);
+          }
+          if (conn != NULL) {
             /* Adjust TCP checksum for changing source port */
-            tcphdr->src = nat_entry.tcp->nport;
+            tcphdr->src = conn->nport;
             ip_nat_chksum_adjust((u8_t *)&(tcphdr->chksum),
-              (u8_t *)&(nat_entry.tcp->sport), 2, (u8_t *)&(tcphdr->src), 2);
+              (u8_t *)&(conn->sport), 2, (u8_t *)&(tcphdr->src), 2);
             /* Adjust TCP checksum for changing source IP address */
             ip_nat_chksum_adjust((u8_t *)&(tcphdr->chksum),
-              (u8_t *)&(nat_entry.cmn->source.addr), 4,
-              (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4);
+              (u8_t *)&(conn->source.addr), 4,
+              (u8_t *)&(conn->cfg->entry.out_if->ip_addr.addr), 4);
           }
         }
         break;
@@ -658,16 +693,19 @@ ip_nat_out(struct pbuf *p)
           LWIP_DEBUGF(LWIP_NAT_DEBUG,
             ("ip_nat_out: short udp packet (%" U16_F " bytes) discarded\n", p->tot_len));
         } else {
-          nat_entry.udp = ip_nat_udp_lookup_outgoing(nat_config, iphdr, udphdr, 1);
-          if (nat_entry.udp != NULL) {
+          conn = ip_nat_lookup_outgoing(IP_PROTO_UDP, iphdr, udphdr->src, udphdr->dest);
+          if (conn == NULL) {
+            conn = ip_nat_conn_new(nat_config, IP_PROTO_UDP, iphdr, udphdr->src, udphdr->dest);
+          }
+          if (conn != NULL) {
             /* Adjust UDP checksum for changing source port */
-            udphdr->src = nat_entry.udp->nport;
+            udphdr->src = conn->nport;
             ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-              (u8_t *)&(nat_entry.udp->sport), 2, (u8_t *) & (udphdr->src), 2);
+              (u8_t *)&(conn->sport), 2, (u8_t *) & (udphdr->src), 2);
             /* Adjust UDP checksum for changing source IP address */
             ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-              (u8_t *)&(nat_entry.cmn->source.addr), 4,
-              (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4);
+              (u8_t *)&(conn->source.addr), 4,
+              (u8_t *)&(conn->cfg->entry.out_if->ip_addr.addr), 4);
           }
         }
         break;
@@ -679,19 +717,10 @@ ip_nat_out(struct pbuf *p)
             ("ip_nat_out: short icmp echo packet (%" U16_F " bytes) discarded\n", p->tot_len));
         } else {
           if (ICMPH_TYPE(icmphdr) == ICMP_ECHO) {
-            for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
-              if (!ip_nat_icmp_table[i].common.ttl) {
-                nat_entry.icmp = &ip_nat_icmp_table[i];
-                ip_nat_cmn_init(nat_config, iphdr, nat_entry.cmn);
-                nat_entry.icmp->id = icmphdr->id;
-                nat_entry.icmp->seqno = icmphdr->seqno;
-                ip_nat_dbg_dump_icmp_nat_entry(" ip_nat_out: created new NAT entry ", nat_entry.icmp);
-                break;
-              }
-            }
-            if (NULL == nat_entry.icmp)
-            {
-              LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_out: no more NAT entries for ICMP available\n"));
+            /* a retransmitted echo reuses the pending entry */
+            conn = ip_nat_lookup_outgoing(IP_PROTO_ICMP, iphdr, icmphdr->id, icmphdr->seqno);
+            if (conn == NULL) {
+              conn = ip_nat_conn_new(nat_config, IP_PROTO_ICMP, iphdr, icmphdr->id, icmphdr->seqno);
             }
           }
         }
@@ -700,15 +729,17 @@ ip_nat_out(struct pbuf *p)
         break;
       }
 
-      if (nat_entry.cmn != NULL) {
-        struct netif *out_if = nat_entry.cmn->cfg->entry.out_if;
+      if (conn != NULL) {
+        struct netif *out_if = conn->cfg->entry.out_if;
+
+        conn->expire = ip_nat_ticks + LWIP_NAT_DEFAULT_TTL_TICKS;
         /* Exchange the IP source address with the address of the interface
         * where the packet will be sent.
         */
-        /* @todo: check nat_config->entry.out_if agains nat_entry.cmn->cfg->entry.out_if */
+        /* @todo: check nat_config->entry.out_if agains conn->cfg->entry.out_if */
         iphdr->src.addr = nat_config->entry.out_if->ip_addr.addr;
         ip_nat_chksum_adjust((u8_t *) & IPH_CHKSUM(iphdr),
-          (u8_t *) & (nat_entry.cmn->source.addr), 4, (u8_t *) & iphdr->src.addr, 4);
+          (u8_t *) & (conn->source.addr), 4, (u8_t *) & iphdr->src.addr, 4);
 
         ip_nat_dbg_dump("ip_nat_out: rewritten packet", iphdr);
         LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_out: sending packet on interface ("));
@@ -730,192 +761,229 @@ ip_nat_out(struct pbuf *p)
   return sent;
 }
 
-/** Initialize common parts of a NAT entry
- *
- * @param nat_config NAT config entry
- * @param iphdr IP header from which to initialize the entry
- * @param nat_entry entry to initialize
+/** Mix the bits of a 32 bit word for the hash of the tuples */
+static u32_t
+ip_nat_mix(u32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352dUL;
+  x ^= x >> 15;
+  x *= 0x846ca68bUL;
+  x ^= x >> 16;
+  return x;
+}
+
+/** Hash a tuple to a bucket of the hash tables, the incoming tuples
+ * have no second address.
  */
-static void
-ip_nat_cmn_init(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr, ip_nat_entry_common_t *nat_entry)
+static u32_t
+ip_nat_hash(u8_t proto, u32_t addr1, u32_t addr2, u16_t port1, u16_t port2)
 {
-  LWIP_ASSERT("NULL != nat_entry", NULL != nat_entry);
-  LWIP_ASSERT("NULL != nat_config", NULL != nat_config);
-  LWIP_ASSERT("NULL != iphdr", NULL != iphdr);
-  nat_entry->cfg = nat_config;
-  nat_entry->dest = *((ip_addr_t *)&iphdr->dest);
-  nat_entry->source = *((ip_addr_t *)&iphdr->src);
-  nat_entry->ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
+  u32_t h = ip_nat_seed ^ proto;
+
+  h = ip_nat_mix(h ^ addr1);
+  h = ip_nat_mix(h ^ addr2);
+  h = ip_nat_mix(h ^ (((u32_t)port1 << 16) | port2));
+  return h & (LWIP_NAT_HASH_SIZE - 1);
 }
 
 /**
- * This function checks for incoming packets if we already have a NAT entry.
- * If yes a pointer to the NAT entry is returned. Otherwise NULL.
+ * Look up the connection of an incoming packet.
  *
+ * @param proto IP_PROTO_TCP, IP_PROTO_UDP or IP_PROTO_ICMP
  * @param iphdr The IP header.
- * @param udphdr The UDP header.
- * @return A pointer to an existing NAT entry or
- *         NULL if none is found.
+ * @param rport The source port of the remote host (ICMP: the seqno).
+ * @param nport The translated port (ICMP: the id).
+ * @return A pointer to an existing connection or NULL if none is found.
  */
-static ip_nat_entries_udp_t *
-ip_nat_udp_lookup_incoming(const struct ip_hdr *iphdr, const struct udp_hdr *udphdr)
+static ip_nat_conn_t *
+ip_nat_lookup_incoming(u8_t proto, const struct ip_hdr *iphdr, u16_t rport, u16_t nport)
 {
-  int i;
-  ip_nat_entries_udp_t *nat_entry = NULL;
-
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if (ip_nat_udp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_udp_table[i].common.dest.addr) &&
-          (udphdr->src == ip_nat_udp_table[i].dport) &&
-          (udphdr->dest == ip_nat_udp_table[i].nport)) {
-        nat_entry = &ip_nat_udp_table[i];
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_incoming: found existing nat entry: ",
-                                      nat_entry);
-        break;
-      }
+  ip_nat_conn_t *conn;
+
+  conn = ip_nat_in_table[ip_nat_hash(proto, iphdr->src.addr, 0, rport, nport)];
+  for (; conn != NULL; conn = conn->in_next) {
+    if ((conn->proto == proto) &&
+        (conn->nport == nport) &&
+        (conn->dport == rport) &&
+        (conn->dest.addr == iphdr->src.addr)) {
+      ip_nat_dbg_dump_conn("ip_nat_lookup_incoming: found existing nat entry: ", conn);
+      break;
     }
   }
-  return nat_entry;
+  return conn;
 }
 
 /**
- * This function checks if we already have a NAT entry for this UDP connection.
- * If yes the a pointer to this NAT entry is returned.
+ * Look up the connection of an outgoing packet.
  *
- * @param nat_config NAT config entry
+ * @param proto IP_PROTO_TCP, IP_PROTO_UDP or IP_PROTO_ICMP
  * @param iphdr The IP header.
- * @param udphdr The UDP header.
- * @param allocate If no existing NAT entry is found and this flag is true
- *        a NAT entry is allocated.
+ * @param sport The source port (ICMP: the id).
+ * @param dport The destination port (ICMP: the seqno).
+ * @return A pointer to an existing connection or NULL if none is found.
  */
-static ip_nat_entries_udp_t *
-ip_nat_udp_lookup_outgoing(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
-                           const struct udp_hdr *udphdr, u8_t allocate)
+static ip_nat_conn_t *
+ip_nat_lookup_outgoing(u8_t proto, const struct ip_hdr *iphdr, u16_t sport, u16_t dport)
 {
-  int i;
-  nat_entry_t nat_entry;
-  int last_free = -1;
-
-  nat_entry.cmn = NULL;
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if (ip_nat_udp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_udp_table[i].common.source.addr) &&
-          (iphdr->dest.addr == ip_nat_udp_table[i].common.dest.addr) &&
-          (udphdr->src == ip_nat_udp_table[i].sport) &&
-          (udphdr->dest == ip_nat_udp_table[i].dport)) {
-        nat_entry.udp = &ip_nat_udp_table[i];
-
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_outgoing: found existing nat entry: ",
-                                      nat_entry.udp);
-        break;
-      }
-    } else {
-        last_free = i;
-    }
-  }
-  if (nat_entry.cmn == NULL) {
-    if (allocate) {
-      if (last_free != -1) {
-        nat_entry.udp = &ip_nat_udp_table[last_free];
-        nat_entry.udp->nport = htons((u16_t) (LWIP_NAT_DEFAULT_UDP_SOURCE_PORT + i));
-        nat_entry.udp->sport = udphdr->src;
-        nat_entry.udp->dport = udphdr->dest;
-        ip_nat_cmn_init(nat_config, iphdr, nat_entry.cmn);
-
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_outgoing: created new nat entry: ",
-                                      nat_entry.udp);
-      } else {
-        LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_udp_lookup_outgoing: no more NAT entries available\n"));
-        // rt_kprintf("ip_nat_udp_lookup_outgoing: no more NAT entries available\n");
-      }
+  ip_nat_conn_t *conn;
+
+  conn = ip_nat_out_table[ip_nat_hash(proto, iphdr->src.addr, iphdr->dest.addr, sport, dport)];
+  for (; conn != NULL; conn = conn->out_next) {
+    if ((conn->proto == proto) &&
+        (conn->sport == sport) &&
+        (conn->dport == dport) &&
+        (conn->source.addr == iphdr->src.addr) &&
+        (conn->dest.addr == iphdr->dest.addr)) {
+      ip_nat_dbg_dump_conn("ip_nat_lookup_outgoing: found existing nat entry: ", conn);
+      break;
     }
   }
-  return nat_entry.udp;
+  return conn;
 }
 
-/**
- * This function checks for incoming packets if we already have a NAT entry.
- * If yes a pointer to the NAT entry is returned. Otherwise NULL.
+/** Take a free port from the bitmap of a protocol.
  *
- * @param iphdr The IP header.
- * @param tcphdr The TCP header.
- * @return A pointer to an existing NAT entry or NULL if none is found.
+ * @param ports the bitmap of the ports
+ * @param cursor the word where the search starts
+ * @return the port in network byte order, 0 if all ports are in use
  */
-static ip_nat_entries_tcp_t *
-ip_nat_tcp_lookup_incoming(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr)
+static u16_t
+ip_nat_port_alloc(u32_t *ports, u16_t *cursor)
 {
-  int i;
-  ip_nat_entries_tcp_t *nat_entry = NULL;
+  u16_t i, word;
+  int bit;
+
+  for (i = 0; i < LWIP_NAT_PORT_WORDS; i++) {
+    word = (u16_t)((*cursor + i) % LWIP_NAT_PORT_WORDS);
+    if (ports[word] != 0xffffffffUL) {
+      bit = __rt_ffs((int)~ports[word]) - 1;
+      ports[word] |= 1UL << bit;
+      *cursor = word;
+      return htons((u16_t)(LWIP_NAT_PORT_MIN + word * 32 + bit));
+    }
+  }
+  return 0;
+}
 
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if (ip_nat_tcp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_tcp_table[i].common.dest.addr) &&
-          (tcphdr->src == ip_nat_tcp_table[i].dport) &&
-          (tcphdr->dest == ip_nat_tcp_table[i].nport)) {
-        nat_entry = &ip_nat_tcp_table[i];
+/** Give a port back to the bitmap of a protocol */
+static void
+ip_nat_port_free(u32_t *ports, u16_t nport)
+{
+  u16_t index = (u16_t)(ntohs(nport) - LWIP_NAT_PORT_MIN);
 
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_incoming: found existing nat entry: ",
-                                      nat_entry);
-        break;
+  ports[index / 32] &= ~(1UL << (index % 32));
+}
+
+/** Allocate a connection from the pools, a pool is created if all are full */
+static ip_nat_conn_t *
+ip_nat_conn_alloc(void)
+{
+  int i;
+  int unused = -1;
+  char name[RT_NAME_MAX];
+
+  for (i = 0; i < LWIP_NAT_POOLS; i++) {
+    if (ip_nat_pools[i] == RT_NULL) {
+      if (unused < 0) {
+        unused = i;
       }
+    } else if (ip_nat_pools[i]->block_free_count > 0) {
+      return (ip_nat_conn_t *)rt_mp_alloc(ip_nat_pools[i], 0);
     }
   }
-  return nat_entry;
+
+  if (unused >= 0) {
+    rt_snprintf(name, sizeof(name), "nat%d", unused);
+    ip_nat_pools[unused] = rt_mp_create(name, LWIP_NAT_CONN_CHUNK, sizeof(ip_nat_conn_t));
+    if (ip_nat_pools[unused] != RT_NULL) {
+      return (ip_nat_conn_t *)rt_mp_alloc(ip_nat_pools[unused], 0);
+    }
+  }
+  return NULL;
 }
 
 /**
- * This function checks if we already have a NAT entry for this TCP connection.
- * If yes the a pointer to this NAT entry is returned.
+ * Create the connection of an outgoing packet, and link it in the hash
+ * tables and the timer wheel.
  *
  * @param nat_config NAT config entry
+ * @param proto IP_PROTO_TCP, IP_PROTO_UDP or IP_PROTO_ICMP
  * @param iphdr The IP header.
- * @param tcphdr The TCP header.
- * @param allocate If no existing NAT entry is found and this flag is true
- *   a NAT entry is allocated.
+ * @param sport The source port (ICMP: the id).
+ * @param dport The destination port (ICMP: the seqno).
+ * @return the new connection, NULL if no port or memory is available
  */
-static ip_nat_entries_tcp_t *
-ip_nat_tcp_lookup_outgoing(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
-                           const struct tcp_hdr *tcphdr, u8_t allocate)
+static ip_nat_conn_t *
+ip_nat_conn_new(ip_nat_conf_t *nat_config, u8_t proto, const struct ip_hdr *iphdr,
+                u16_t sport, u16_t dport)
 {
-  int i;
-  nat_entry_t nat_entry;
-  int last_free = -1;
-
-  nat_entry.cmn = NULL;
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if (ip_nat_tcp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_tcp_table[i].common.source.addr) &&
-          (iphdr->dest.addr == ip_nat_tcp_table[i].common.dest.addr) &&
-          (tcphdr->src == ip_nat_tcp_table[i].sport) &&
-          (tcphdr->dest == ip_nat_tcp_table[i].dport)) {
-        nat_entry.tcp = &ip_nat_tcp_table[i];
-
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_outgoing: found existing nat entry: ",
-                                      nat_entry.tcp);
-        break;
-      }
+  ip_nat_conn_t *conn;
+  u16_t nport;
+  u32_t hash;
+
+  LWIP_ASSERT("NULL != nat_config", NULL != nat_config);
+  LWIP_ASSERT("NULL != iphdr", NULL != iphdr);
+
+  if (proto == IP_PROTO_TCP || proto == IP_PROTO_UDP) {
+    if (proto == IP_PROTO_TCP) {
+      nport = ip_nat_port_alloc(ip_nat_tcp_ports, &ip_nat_tcp_cursor);
     } else {
-        last_free = i;
+      nport = ip_nat_port_alloc(ip_nat_udp_ports, &ip_nat_udp_cursor);
+    }
+    if (nport == 0) {
+      LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_conn_new: no more NAT ports available\n"));
+      return NULL;
     }
+  } else {
+    /* ICMP keeps the echo id, and 0 is a valid id */
+    nport = sport;
   }
-  if (nat_entry.cmn == NULL) {
-    if (allocate) {
-      if (last_free != -1) {
-        nat_entry.tcp = &ip_nat_tcp_table[last_free];
-        nat_entry.tcp->nport = htons((u16_t) (LWIP_NAT_DEFAULT_TCP_SOURCE_PORT + i));
-        nat_entry.tcp->sport = tcphdr->src;
-        nat_entry.tcp->dport = tcphdr->dest;
-        ip_nat_cmn_init(nat_config, iphdr, nat_entry.cmn);
-
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_outgoing: created new nat entry: ",
-                                      nat_entry.tcp);
-      } else {
-        LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_udp_lookup_outgoing: no more NAT entries available\n"));
-        // rt_kprintf("ip_nat_udp_lookup_outgoing: no more NAT entries available\n");
-      }
+
+  conn = ip_nat_conn_alloc();
+  if (conn == NULL) {
+    LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_conn_new: no more NAT entries available\n"));
+    if (proto == IP_PROTO_TCP) {
+      ip_nat_port_free(ip_nat_tcp_ports, nport);
+    } else if (proto == IP_PROTO_UDP) {
+      ip_nat_port_free(ip_nat_udp_ports, nport);
     }
+    return NULL;
+  }
+
+  conn->cfg = nat_config;
+  conn->dest.addr = iphdr->dest.addr;
+  conn->source.addr = iphdr->src.addr;
+  conn->proto = proto;
+  conn->sport = sport;
+  conn->dport = dport;
+  conn->nport = nport;
+  conn->expire = ip_nat_ticks + LWIP_NAT_DEFAULT_TTL_TICKS;
+
+  hash = ip_nat_hash(proto, conn->source.addr, conn->dest.addr, sport, dport);
+  IPNAT_LINK(&ip_nat_out_table[hash], conn, out);
+  hash = ip_nat_hash(proto, conn->dest.addr, 0, dport, nport);
+  IPNAT_LINK(&ip_nat_in_table[hash], conn, in);
+  IPNAT_LINK(&ip_nat_wheel[conn->expire & (LWIP_NAT_WHEEL_SIZE - 1)], conn, tmr);
+
+  ip_nat_dbg_dump_conn("ip_nat_conn_new: created new nat entry: ", conn);
+  return conn;
+}
+
+/** Unlink a connection, give back its port and free it */
+static void
+ip_nat_conn_free(ip_nat_conn_t *conn)
+{
+  IPNAT_UNLINK(conn, out);
+  IPNAT_UNLINK(conn, in);
+  IPNAT_UNLINK(conn, tmr);
+
+  if (conn->proto == IP_PROTO_TCP) {
+    ip_nat_port_free(ip_nat_tcp_ports, conn->nport);
+  } else if (conn->proto == IP_PROTO_UDP) {
+    ip_nat_port_free(ip_nat_udp_ports, conn->nport);
   }
-  return nat_entry.tcp;
+  rt_mp_free(conn);
 }
 
 /** Adjusts the checksum of a NAT'ed packet without having to completely recalculate it
@@ -999,92 +1067,32 @@ ip_nat_dbg_dump(const char *msg, const struct ip_hdr *iphdr)
 }
 
 /**
- * This function dumps an ICMP echo reply/recho request nat entry.
- *
- * @param msg a message to print
- * @param nat_entry the ICMP NAT entry to print
- */
-static void
-ip_nat_dbg_dump_icmp_nat_entry(const char *msg, const ip_nat_entries_icmp_t *nat_entry)
-{
-  LWIP_ASSERT("NULL != msg", NULL != msg);
-  LWIP_ASSERT("NULL != nat_entry", NULL != nat_entry);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg", NULL != nat_entry->common.cfg);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg->entry.out_if",
-    NULL != nat_entry->common.cfg->entry.out_if);
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("%s", msg));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ICMP : ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.source));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" id=%" U16_F, ntohs(nat_entry->id)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (", seq=%" U16_F, ntohs(nat_entry->seqno)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (") mapped at ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.cfg->entry.out_if->ip_addr));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" id=%" U16_F, ntohs(nat_entry->id)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (", seq=%" U16_F, ntohs(nat_entry->seqno)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (")\n"));
-}
-
-/**
- * This function dumps an TCP nat entry.
- *
- * @param msg a message to print
- * @param nat_entry the TCP NAT entry to print
- */
-static void
-ip_nat_dbg_dump_tcp_nat_entry(const char *msg, const ip_nat_entries_tcp_t *nat_entry)
-{
-  LWIP_ASSERT("NULL != msg", NULL != msg);
-  LWIP_ASSERT("NULL != nat_entry", NULL != nat_entry);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg", NULL != nat_entry->common.cfg);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg->entry.out_if",
-    NULL != nat_entry->common.cfg->entry.out_if);
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("%s", msg));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("TCP : ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.source));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->sport)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->dport)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (") mapped at ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.cfg->entry.out_if->ip_addr));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->nport)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->dport)));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (")\n"));
-}
-
-/**
- * This function dumps a UDP NAT entry.
+ * This function dumps a NAT connection.
  *
  * @param msg a message to print
- * @param nat_entry the UDP NAT entry to print
+ * @param conn the connection to print
  */
 static void
-ip_nat_dbg_dump_udp_nat_entry(const char *msg, const ip_nat_entries_udp_t *nat_entry)
+ip_nat_dbg_dump_conn(const char *msg, const ip_nat_conn_t *conn)
 {
   LWIP_ASSERT("NULL != msg", NULL != msg);
-  LWIP_ASSERT("NULL != nat_entry", NULL != nat_entry);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg", NULL != nat_entry->common.cfg);
-  LWIP_ASSERT("NULL != nat_entry->common.cfg->entry.out_if",
-    NULL != nat_entry->common.cfg->entry.out_if);
+  LWIP_ASSERT("NULL != conn", NULL != conn);
+  LWIP_ASSERT("NULL != conn->cfg", NULL != conn->cfg);
+  LWIP_ASSERT("NULL != conn->cfg->entry.out_if", NULL != conn->cfg->entry.out_if);
   LWIP_DEBUGF(LWIP_NAT_DEBUG, ("%s", msg));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("UDP : ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.source));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->sport)));
+  LWIP_DEBUGF(LWIP_NAT_DEBUG, ("%s : (", conn->proto == IP_PROTO_TCP ? "TCP" :
+    (conn->proto == IP_PROTO_UDP ? "UDP" : "ICMP")));
+  ip_nat_dbg_dump_ip(&(conn->source));
+  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(conn->sport)));
   LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->dport)));
+  ip_nat_dbg_dump_ip(&(conn->dest));
+  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(conn->dport)));
   LWIP_DEBUGF(LWIP_NAT_DEBUG, (") mapped at ("));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.cfg->entry.out_if->ip_addr));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->nport)));
+  ip_nat_dbg_dump_ip(&(conn->cfg->entry.out_if->ip_addr));
+  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(conn->nport)));
   LWIP_DEBUGF(LWIP_NAT_DEBUG, (" --> "));
-  ip_nat_dbg_dump_ip(&(nat_entry->common.dest));
-  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(nat_entry->dport)));
+  ip_nat_dbg_dump_ip(&(conn->dest));
+  LWIP_DEBUGF(LWIP_NAT_DEBUG, (":%" U16_F, ntohs(conn->dport)));
   LWIP_DEBUGF(LWIP_NAT_DEBUG, (")\n"));
 }
 
@@ -31,6 +31,7 @@
  * Date           Author       Notes
  * 2015-01-26     Hichard      porting to RT-Thread
  * 2015-01-27     Bernard      code cleanup for lwIP in RT-Thread
+ * 2023-10-18     RT-Thread    tick the timer wheel of the connections every 2 seconds
  */
 
 #ifndef __LWIP_NAT_H__
@@ -44,8 +45,8 @@
 #include "lwip/ip_addr.h"
 #include "lwip/opt.h"
 
-/** Timer interval at which to call ip_nat_tmr() */
-#define LWIP_NAT_TMR_INTERVAL_SEC        (30)
+/** Timer interval at which to call ip_nat_tmr(), a tick of the timer wheel */
+#define LWIP_NAT_TMR_INTERVAL_SEC        (2)
 
 #ifdef __cplusplus
 extern "C" {
@@ -383,7 +383,7 @@ static int netdev_flags_sync(struct netif *lwip_netif)
     return ERR_OK;
 }
 
-static int netdev_add(struct netif *lwip_netif)
+static struct netdev *netdev_add(struct netif *lwip_netif)
 {
 #define LWIP_NETIF_NAME_LEN 2
     int result = 0;
@@ -395,7 +395,7 @@ static int netdev_add(struct netif *lwip_netif)
     netdev = (struct netdev *)rt_calloc(1, sizeof(struct netdev));
     if (netdev == RT_NULL)
     {
-        return -ERR_IF;
+        return RT_NULL;
     }
 
 #ifdef SAL_USING_LWIP
@@ -416,7 +416,7 @@ static int netdev_add(struct netif *lwip_netif)
     netdev->gw = lwip_netif->gw;
     netdev->netmask = lwip_netif->netmask;
 
-    return result;
+    return result == 0 ? netdev : RT_NULL;
 }
 
 static void netdev_del(struct netif *lwip_netif)
@@ -457,8 +457,14 @@ static err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
 
     if (enetif->eth_tx(&(enetif->parent), p) != RT_EOK)
     {
+#ifdef RT_USING_NETDEV
+        netdev_low_level_stats_tx(enetif->netdev, p->tot_len, RT_TRUE);
+#endif
         return ERR_IF;
     }
+#ifdef RT_USING_NETDEV
+    netdev_low_level_stats_tx(enetif->netdev, p->tot_len, RT_FALSE);
+#endif
 #endif
     return ERR_OK;
 }
@@ -474,7 +480,7 @@ static err_t eth_netif_device_init(struct netif *netif)
 
 #ifdef RT_USING_NETDEV
         /* network interface device register */
-        netdev_add(netif);
+        ethif->netdev = netdev_add(netif);
 #endif /* RT_USING_NETDEV */
 
         /* get device object */
@@ -663,7 +669,7 @@ static err_t af_unix_eth_netif_device_init(struct netif *netif)
 
 #ifdef RT_USING_NETDEV
         /* network interface device register */
-        netdev_add(netif);
+        ethif->netdev = netdev_add(netif);
 #endif /* RT_USING_NETDEV */
 
         /* get device object */
@@ -884,7 +890,16 @@ static void eth_tx_thread_entry(void* parameter)
                 if (enetif->eth_tx(&(enetif->parent), msg->buf) != RT_EOK)
                 {
                     /* transmit eth packet failed */
+#ifdef RT_USING_NETDEV
+                    netdev_low_level_stats_tx(enetif->netdev, msg->buf->tot_len, RT_TRUE);
+#endif
                 }
+#ifdef RT_USING_NETDEV
+                else
+                {
+                    netdev_low_level_stats_tx(enetif->netdev, msg->buf->tot_len, RT_FALSE);
+                }
+#endif
             }
 
             /* send ACK */
@@ -936,13 +951,25 @@ static void eth_rx_thread_entry(void* parameter)
                 p = device->eth_rx(&(device->parent));
                 if (p != RT_NULL)
                 {
+#ifdef RT_USING_NETDEV
+                    rt_size_t len = p->tot_len;
+#endif
                     /* notify to upper layer */
                     if( device->netif->input(p, device->netif) != ERR_OK )
                     {
                         LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: Input error\n"));
                         pbuf_free(p);
                         p = NULL;
+#ifdef RT_USING_NETDEV
+                        netdev_low_level_stats_rx(device->netdev, len, RT_TRUE);
+#endif
                     }
+#ifdef RT_USING_NETDEV
+                    else
+                    {
+                        netdev_low_level_stats_rx(device->netdev, len, RT_FALSE);
+                    }
+#endif
                 }
                 else break;
             }
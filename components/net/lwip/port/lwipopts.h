@@ -7,6 +7,8 @@
  * Date           Author       Notes
  * 2022-02-23     Meco Man     integrate v1.4.1 v2.0.3 and v2.1.2 porting layer
  * 2022-02-25     xiangxistu   modify the default config through v1.4.1
+ * 2023-10-18     RT-Thread    add the architecture checksum
+ * 2023-10-18     RT-Thread    add core locking and the per-CPU caches options
  */
 
 #ifndef __LWIPOPTS_H__
@@ -284,7 +286,12 @@
 //#define MEMP_USE_CUSTOM_POOLS       1
 //#define MEM_SIZE                    (1024*64)
 
+/* the memp pools are allocated by mem_malloc(), which is cached on each CPU */
+#ifdef RT_LWIP_USING_PERCPU_CACHE
+#define MEMP_MEM_MALLOC             1
+#else
 #define MEMP_MEM_MALLOC             0
+#endif
 
 /* MEMP_NUM_PBUF: the number of memp struct pbufs. If the application
    sends a lot of data out of ROM (or other static memory), this
@@ -417,6 +424,19 @@
 #define TCPIP_THREAD_NAME           "tcpip"
 #define DEFAULT_TCP_RECVMBOX_SIZE   10
 
+/*
+ * The API calls run in the caller's thread with the core locked, or they are
+ * posted to the tcpip thread. The default of lwIP is kept if neither is set.
+ */
+#if defined(RT_LWIP_USING_CORE_LOCKING)
+#define LWIP_TCPIP_CORE_LOCKING         1
+#ifdef RT_LWIP_USING_CORE_LOCKING_INPUT
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+#endif
+#elif defined(RT_LWIP_USING_TCPIP_MSG)
+#define LWIP_TCPIP_CORE_LOCKING         0
+#endif /* RT_LWIP_USING_CORE_LOCKING */
+
 /* ---------- ARP options ---------- */
 #define LWIP_ARP                    1
 #define ARP_TABLE_SIZE              10
@@ -434,6 +454,12 @@
 #define CHECKSUM_CHECK_ICMP             0
 #endif
 
+#ifdef ARCH_ARMV8_OPTIMIZED_CHECKSUM
+/* The one's complement sum in libcpu/aarch64/common/checksum_gcc.S */
+unsigned short rt_hw_inet_chksum(const void *dataptr, int len);
+#define LWIP_CHKSUM                     rt_hw_inet_chksum
+#endif
+
 /* ---------- IP options ---------- */
 /* Define IP_FORWARD to 1 if you wish to have the ability to forward
    IP packets across network interfaces. If you are going to run lwIP
@@ -29,6 +29,8 @@ extern "C" {
 #define ETHIF_LINK_AUTOUP   0x0000
 #define ETHIF_LINK_PHYUP    0x0100
 
+struct netdev;
+
 struct eth_device
 {
     /* inherit from rt_device */
@@ -45,6 +47,11 @@ struct eth_device
     /* eth device interface */
     struct pbuf* (*eth_rx)(rt_device_t dev);
     rt_err_t (*eth_tx)(rt_device_t dev, struct pbuf* p);
+
+#ifdef RT_USING_NETDEV
+    /* network interface device for the traffic statistics */
+    struct netdev *netdev;
+#endif
 };
 
 int eth_system_device_init(void);
@@ -15,6 +15,7 @@
  * 2021-06-25     liuxianliang port to v2.0.3
  * 2022-01-18     Meco Man     remove v2.0.2
  * 2022-02-20     Meco Man     integrate v1.4.1 v2.0.3 and v2.1.2 porting layer
+ * 2023-10-18     RT-Thread    add the per-CPU caches of mem_malloc()
  */
 
 #include <rtthread.h>
@@ -543,8 +544,198 @@ rt_weak void mem_init(void)
 {
 }
 
+#ifdef RT_LWIP_USING_PERCPU_CACHE
+/* ====================== Per-CPU cache ====================== */
+
+/*
+ * The memp pools and the pbufs are allocated by mem_malloc() with
+ * MEMP_MEM_MALLOC. The blocks of the size classes are cached on the CPU which
+ * frees them, so most of the allocations of the packets take no global lock.
+ */
+#ifdef RT_USING_SMP
+#define LWIP_CACHE_CPUS             RT_CPUS_NR
+#define LWIP_CACHE_CPU_ID()         rt_hw_cpu_id()
+#else
+#define LWIP_CACHE_CPUS             1
+#define LWIP_CACHE_CPU_ID()         0
+#define rt_hw_local_irq_disable     rt_hw_interrupt_disable
+#define rt_hw_local_irq_enable      rt_hw_interrupt_enable
+#endif /* RT_USING_SMP */
+
+#define LWIP_CACHE_CLASSES          3
+#define LWIP_CACHE_HDR_SIZE         LWIP_MEM_ALIGN_SIZE(sizeof(struct lwip_cache_block))
+
+struct lwip_cache_block
+{
+    union
+    {
+        struct lwip_cache_block *next;  /* the next block cached */
+        rt_ubase_t index;               /* the size class of the block allocated */
+    } u;
+};
+
+struct lwip_cache
+{
+    struct lwip_cache_block *blocks[LWIP_CACHE_CLASSES];
+    rt_uint32_t count[LWIP_CACHE_CLASSES];
+    rt_uint32_t hits;
+    rt_uint32_t misses;
+} rt_align(RT_CPU_CACHE_LINE_SZ);
+
+/* the control blocks, the pcbs and the netconns, and the pbufs of the pool */
+static const mem_size_t lwip_cache_sizes[LWIP_CACHE_CLASSES] =
+{
+    128,
+    512,
+    /* the pbuf and the sanity regions of memp are before the buffer */
+    LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE) + 128,
+};
+static struct lwip_cache lwip_caches[LWIP_CACHE_CPUS];
+
+void *mem_malloc(mem_size_t size)
+{
+    rt_base_t level;
+    rt_ubase_t index;
+    struct lwip_cache *cache;
+    struct lwip_cache_block *block = RT_NULL;
+
+    for (index = 0; index < LWIP_CACHE_CLASSES; index++)
+    {
+        if (size <= lwip_cache_sizes[index])
+        {
+            break;
+        }
+    }
+
+    if (index < LWIP_CACHE_CLASSES)
+    {
+        level = rt_hw_local_irq_disable();
+        cache = &lwip_caches[LWIP_CACHE_CPU_ID()];
+        block = cache->blocks[index];
+        if (block != RT_NULL)
+        {
+            cache->blocks[index] = block->u.next;
+            cache->count[index]--;
+            cache->hits++;
+        }
+        else
+        {
+            cache->misses++;
+        }
+        rt_hw_local_irq_enable(level);
+
+        /* the block may be cached by any CPU as it's freed */
+        size = lwip_cache_sizes[index];
+    }
+
+    if (block == RT_NULL)
+    {
+        block = (struct lwip_cache_block *)rt_malloc(LWIP_CACHE_HDR_SIZE + size);
+        if (block == RT_NULL)
+        {
+            return RT_NULL;
+        }
+    }
+    block->u.index = index;
+
+    return (rt_uint8_t *)block + LWIP_CACHE_HDR_SIZE;
+}
+
+void mem_free(void *mem)
+{
+    rt_base_t level;
+    rt_ubase_t index;
+    struct lwip_cache *cache;
+    struct lwip_cache_block *block;
+
+    if (mem == RT_NULL)
+    {
+        return;
+    }
+
+    block = (struct lwip_cache_block *)((rt_uint8_t *)mem - LWIP_CACHE_HDR_SIZE);
+    index = block->u.index;
+
+    if (index < LWIP_CACHE_CLASSES)
+    {
+        level = rt_hw_local_irq_disable();
+        cache = &lwip_caches[LWIP_CACHE_CPU_ID()];
+        if (cache->count[index] < RT_LWIP_PERCPU_CACHE_NUM)
+        {
+            block->u.next = cache->blocks[index];
+            cache->blocks[index] = block;
+            cache->count[index]++;
+            block = RT_NULL;
+        }
+        rt_hw_local_irq_enable(level);
+    }
+
+    if (block != RT_NULL)
+    {
+        rt_free(block);
+    }
+}
+
+void *mem_calloc(mem_size_t count, mem_size_t size)
+{
+    void *mem;
+
+    /* the product overflows mem_size_t */
+    if (count != 0 && size > (mem_size_t)-1 / count)
+    {
+        return RT_NULL;
+    }
+
+    mem = mem_malloc(count * size);
+    if (mem != RT_NULL)
+    {
+        rt_memset(mem, 0, count * size);
+    }
+
+    return mem;
+}
+
+void *mem_trim(void *mem, mem_size_t size)
+{
+    /* not support trim yet */
+    return mem;
+}
+
+#ifdef RT_USING_FINSH
+static void list_lwip_cache(void)
+{
+    int cpu, index;
+
+    rt_kprintf("cpu ");
+    for (index = 0; index < LWIP_CACHE_CLASSES; index++)
+    {
+        rt_kprintf("%6d ", lwip_cache_sizes[index]);
+    }
+    rt_kprintf("      hits     misses\n");
+
+    for (cpu = 0; cpu < LWIP_CACHE_CPUS; cpu++)
+    {
+        rt_kprintf("%3d ", cpu);
+        for (index = 0; index < LWIP_CACHE_CLASSES; index++)
+        {
+            rt_kprintf("%6d ", lwip_caches[cpu].count[index]);
+        }
+        rt_kprintf("%10u %10u\n", lwip_caches[cpu].hits, lwip_caches[cpu].misses);
+    }
+}
+MSH_CMD_EXPORT(list_lwip_cache, list the per-CPU caches of lwIP);
+#endif /* RT_USING_FINSH */
+
+#else
+
 void *mem_calloc(mem_size_t count, mem_size_t size)
 {
+    /* the product overflows mem_size_t */
+    if (count != 0 && size > (mem_size_t)-1 / count)
+    {
+        return RT_NULL;
+    }
+
     return rt_calloc(count, size);
 }
 
@@ -564,6 +755,7 @@ void  mem_free(void *mem)
 {
     rt_free(mem);
 }
+#endif /* RT_LWIP_USING_PERCPU_CACHE */
 
 #ifdef RT_LWIP_PPP
 u32_t sio_read(sio_fd_t fd, u8_t *buf, u32_t size)
@@ -78,6 +78,17 @@ typedef void (*netdev_callback_fn )(struct netdev *netdev, enum netdev_cb_type t
 
 struct netdev_ops;
 
+/* network interface device traffic statistics */
+struct netdev_stats
+{
+    rt_ubase_t rx_bytes;
+    rt_ubase_t rx_packets;
+    rt_ubase_t rx_dropped;                             /* received but refused by the stack */
+    rt_ubase_t tx_bytes;
+    rt_ubase_t tx_packets;
+    rt_ubase_t tx_errors;                              /* failed to transmit by the driver */
+};
+
 /* network interface device object */
 struct netdev
 {
@@ -101,6 +112,8 @@ struct netdev
     netdev_callback_fn status_callback;                /* network interface device flags change callback */
     netdev_callback_fn addr_callback;                  /* network interface device address information change callback */
 
+    struct netdev_stats stats;                         /* traffic statistics, updated by the driver */
+
 #ifdef RT_USING_SAL
     void *sal_user_data;                               /* user-specific data for SAL */
 #endif /* RT_USING_SAL */
@@ -192,6 +205,11 @@ void netdev_low_level_set_status(struct netdev *netdev, rt_bool_t is_up);
 void netdev_low_level_set_link_status(struct netdev *netdev, rt_bool_t is_up);
 void netdev_low_level_set_internet_status(struct netdev *netdev, rt_bool_t is_up);
 void netdev_low_level_set_dhcp_status(struct netdev *netdev, rt_bool_t is_enable);
+void netdev_low_level_stats_rx(struct netdev *netdev, rt_size_t len, rt_bool_t is_dropped);
+void netdev_low_level_stats_tx(struct netdev *netdev, rt_size_t len, rt_bool_t is_error);
+
+/* Get network interface device traffic statistics */
+void netdev_get_stats(struct netdev *netdev, struct netdev_stats *stats);
 
 #ifdef __cplusplus
 }
@@ -35,6 +35,38 @@ struct netdev *netdev_default = RT_NULL;
 static netdev_callback_fn g_netdev_register_callback = RT_NULL;
 static netdev_callback_fn g_netdev_default_change_callback = RT_NULL;
 
+/*
+ * The lookups walk the list in a read-side critical section of RCU instead
+ * of disabling the interrupt. The list is still updated with the interrupt
+ * disabled, and a device is cleared by unregister after a grace period.
+ */
+rt_inline rt_base_t netdev_read_lock(void)
+{
+#ifdef RT_USING_RCU
+    rt_rcu_read_lock();
+    return 0;
+#else
+    return rt_hw_interrupt_disable();
+#endif /* RT_USING_RCU */
+}
+
+rt_inline void netdev_read_unlock(rt_base_t level)
+{
+#ifdef RT_USING_RCU
+    RT_UNUSED(level);
+    rt_rcu_read_unlock();
+#else
+    rt_hw_interrupt_enable(level);
+#endif /* RT_USING_RCU */
+}
+
+rt_inline rt_slist_t *netdev_list_first(void)
+{
+    struct netdev *netdev = rt_rcu_dereference(netdev_list);
+
+    return netdev ? &(netdev->list) : RT_NULL;
+}
+
 /**
  * This function will register network interface device and
  * add it to network interface device list.
@@ -80,6 +112,7 @@ int netdev_register(struct netdev *netdev, const char *name, void *user_data)
     }
     netdev->status_callback = RT_NULL;
     netdev->addr_callback = RT_NULL;
+    rt_memset(&(netdev->stats), 0, sizeof(netdev->stats));
 
     if(rt_strlen(name) > RT_NAME_MAX)
     {
@@ -100,12 +133,12 @@ int netdev_register(struct netdev *netdev, const char *name, void *user_data)
 
     if (netdev_list == RT_NULL)
     {
-        netdev_list = netdev;
+        rt_rcu_assign_pointer(netdev_list, netdev);
     }
     else
     {
         /* tail insertion */
-        rt_slist_append(&(netdev_list->list), &(netdev->list));
+        rt_slist_append_rcu(&(netdev_list->list), &(netdev->list));
     }
 
     rt_hw_interrupt_enable(level);
@@ -156,11 +189,11 @@ int netdev_unregister(struct netdev *netdev)
             /* find this network interface device in network interface device list */
             if (netdev_list == netdev && rt_slist_next(&netdev_list->list) == RT_NULL)
             {
-                netdev_list = RT_NULL;
+                rt_rcu_assign_pointer(netdev_list, RT_NULL);
             }
             else
             {
-                rt_slist_remove(&(netdev_list->list), &(cur_netdev->list));
+                rt_slist_remove_rcu(&(netdev_list->list), &(cur_netdev->list));
             }
             if (netdev_default == netdev)
             {
@@ -178,6 +211,10 @@ int netdev_unregister(struct netdev *netdev)
 
     if (cur_netdev == netdev)
     {
+#ifdef RT_USING_RCU
+        /* wait for the lookups still on the device before clearing it */
+        rt_rcu_synchronize();
+#endif /* RT_USING_RCU */
 #ifdef RT_USING_SAL
         extern int sal_netdev_cleanup(struct netdev *netdev);
         sal_netdev_cleanup(netdev);
@@ -219,19 +256,19 @@ struct netdev *netdev_get_first_by_flags(uint16_t flags)
         return RT_NULL;
     }
 
-    level = rt_hw_interrupt_disable();
+    level = netdev_read_lock();
 
-    for (node = &(netdev_list->list); node; node = rt_slist_next(node))
+    for (node = netdev_list_first(); node; node = rt_slist_next_rcu(node))
     {
         netdev = rt_slist_entry(node, struct netdev, list);
         if (netdev && (netdev->flags & flags) != 0)
         {
-            rt_hw_interrupt_enable(level);
+            netdev_read_unlock(level);
             return netdev;
         }
     }
 
-    rt_hw_interrupt_enable(level);
+    netdev_read_unlock(level);
 
     return RT_NULL;
 }
@@ -256,19 +293,19 @@ struct netdev *netdev_get_by_ipaddr(ip_addr_t *ip_addr)
         return RT_NULL;
     }
 
-    level = rt_hw_interrupt_disable();
+    level = netdev_read_lock();
 
-    for (node = &(netdev_list->list); node; node = rt_slist_next(node))
+    for (node = netdev_list_first(); node; node = rt_slist_next_rcu(node))
     {
         netdev = rt_slist_entry(node, struct netdev, list);
         if (netdev && ip_addr_cmp(&(netdev->ip_addr), ip_addr))
         {
-            rt_hw_interrupt_enable(level);
+            netdev_read_unlock(level);
             return netdev;
         }
     }
 
-    rt_hw_interrupt_enable(level);
+    netdev_read_unlock(level);
 
     return RT_NULL;
 }
@@ -293,19 +330,19 @@ struct netdev *netdev_get_by_name(const char *name)
         return RT_NULL;
     }
 
-    level = rt_hw_interrupt_disable();
+    level = netdev_read_lock();
 
-    for (node = &(netdev_list->list); node; node = rt_slist_next(node))
+    for (node = netdev_list_first(); node; node = rt_slist_next_rcu(node))
     {
         netdev = rt_slist_entry(node, struct netdev, list);
         if (netdev && (rt_strncmp(netdev->name, name, rt_strlen(netdev->name) < RT_NAME_MAX ? rt_strlen(netdev->name) : RT_NAME_MAX) == 0))
         {
-            rt_hw_interrupt_enable(level);
+            netdev_read_unlock(level);
             return netdev;
         }
     }
 
-    rt_hw_interrupt_enable(level);
+    netdev_read_unlock(level);
 
     return RT_NULL;
 }
@@ -332,31 +369,31 @@ struct netdev *netdev_get_by_family(int family)
         return RT_NULL;
     }
 
-    level = rt_hw_interrupt_disable();
+    level = netdev_read_lock();
 
-    for (node = &(netdev_list->list); node; node = rt_slist_next(node))
+    for (node = netdev_list_first(); node; node = rt_slist_next_rcu(node))
     {
         netdev = rt_slist_entry(node, struct netdev, list);
         pf = (struct sal_proto_family *) netdev->sal_user_data;
         if (pf && pf->skt_ops && pf->family == family && netdev_is_up(netdev))
         {
-            rt_hw_interrupt_enable(level);
+            netdev_read_unlock(level);
             return netdev;
         }
     }
 
-    for (node = &(netdev_list->list); node; node = rt_slist_next(node))
+    for (node = netdev_list_first(); node; node = rt_slist_next_rcu(node))
     {
         netdev = rt_slist_entry(node, struct netdev, list);
         pf = (struct sal_proto_family *) netdev->sal_user_data;
         if (pf && pf->skt_ops && pf->sec_family == family && netdev_is_up(netdev))
         {
-            rt_hw_interrupt_enable(level);
+            netdev_read_unlock(level);
             return netdev;
         }
     }
 
-    rt_hw_interrupt_enable(level);
+    netdev_read_unlock(level);
 
     return RT_NULL;
 }
@@ -941,6 +978,74 @@ void netdev_low_level_set_dhcp_status(struct netdev *netdev, rt_bool_t is_enable
     }
 }
 
+/**
+ * This function will account a received packet of network interface device.
+ * @NOTE it can only be called in the network interface device driver.
+ *
+ * @param netdev the network interface device
+ * @param len the bytes of the packet
+ * @param is_dropped the packet is refused by the network stack
+ */
+void netdev_low_level_stats_rx(struct netdev *netdev, rt_size_t len, rt_bool_t is_dropped)
+{
+    if (netdev == RT_NULL)
+    {
+        return;
+    }
+
+    /* only written by the receiving thread of the driver, no lock is needed */
+    if (is_dropped)
+    {
+        netdev->stats.rx_dropped++;
+    }
+    else
+    {
+        netdev->stats.rx_packets++;
+        netdev->stats.rx_bytes += len;
+    }
+}
+
+/**
+ * This function will account a transmitted packet of network interface device.
+ * @NOTE it can only be called in the network interface device driver.
+ *
+ * @param netdev the network interface device
+ * @param len the bytes of the packet
+ * @param is_error the packet is failed to transmit
+ */
+void netdev_low_level_stats_tx(struct netdev *netdev, rt_size_t len, rt_bool_t is_error)
+{
+    if (netdev == RT_NULL)
+    {
+        return;
+    }
+
+    if (is_error)
+    {
+        netdev->stats.tx_errors++;
+    }
+    else
+    {
+        netdev->stats.tx_packets++;
+        netdev->stats.tx_bytes += len;
+    }
+}
+
+/**
+ * This function will get the traffic statistics of network interface device.
+ *
+ * @param netdev the network interface device
+ * @param stats the buffer to store the statistics
+ */
+void netdev_get_stats(struct netdev *netdev, struct netdev_stats *stats)
+{
+    RT_ASSERT(netdev);
+    RT_ASSERT(stats);
+
+    /* the counters are words updated in place, a copy of them is a snapshot */
+    rt_memcpy(stats, &netdev->stats, sizeof(struct netdev_stats));
+}
+
 #ifdef RT_USING_FINSH
 
 #include <finsh.h>
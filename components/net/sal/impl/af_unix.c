@@ -0,0 +1,1843 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The AF_UNIX protocol family of SAL, the data is passed between the sockets
+ * in memory directly, without the loopback interface of the TCP/IP stack.
+ *
+ * - SOCK_STREAM, SOCK_DGRAM and SOCK_SEQPACKET are supported.
+ * - The names are the paths normalized by dfs_normalize_path(), or the
+ *   abstract names which start with '\0'. The namespace is kept in kernel,
+ *   no node is created in the file system.
+ * - The file descriptors are passed by SCM_RIGHTS, the dfs_file is referred
+ *   by the message in flight, and installed to the receiver's fd table.
+ * - The data is copied to the buffer of the blocked reader directly, or
+ *   queued to the receiver, which is limited by SO_RCVBUF.
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <rtdevice.h>
+#include <rtatomic.h>
+
+#include <dfs.h>
+#include <dfs_file.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/errno.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+
+#include <sal_socket.h>
+#include <sal_low_lvl.h>
+
+#define DBG_TAG                 "sal.unix"
+#define DBG_LVL                 DBG_INFO
+#include <rtdbg.h>
+
+#ifdef SAL_USING_AF_UNIX
+
+#define UNIX_SOCKETS_NUM        SAL_SOCKETS_NUM
+#define UNIX_RCVBUF_DEFAULT     SAL_AF_UNIX_RCVBUF
+#define UNIX_RCVBUF_MIN         256
+#define UNIX_BACKLOG_MAX        16
+#define UNIX_FDS_MAX            16      /* the max files passed by a message */
+#define UNIX_PATH_MAX           sizeof(((struct sockaddr_un *)0)->sun_path)
+
+#define UNIX_STATE_UNCONNECTED  0
+#define UNIX_STATE_LISTENING    1
+#define UNIX_STATE_CONNECTED    2
+#define UNIX_STATE_CLOSED       3
+
+#define UNIX_F_NONBLOCK         0x01
+#define UNIX_F_SHUT_RD          0x02    /* no more receptions, the writers get EPIPE */
+#define UNIX_F_SHUT_WR          0x04    /* no more transmissions */
+#define UNIX_F_PEER_SHUT        0x08    /* the peer is closed or shut down the transmissions */
+
+struct unix_msg
+{
+    rt_list_t node;
+
+    rt_size_t len;                      /* the length of the data */
+    rt_size_t offset;                   /* the data consumed by the stream reads */
+    int nfds;                           /* the files passed by SCM_RIGHTS */
+    struct dfs_file **files;
+    rt_size_t namelen;                  /* the name of the sender of the datagram */
+    char *name;
+    char *data;
+};
+
+/* the reader blocked, which the data is handed off to */
+struct unix_reader
+{
+    const struct iovec *iov;
+    int iovcnt;
+    rt_size_t len;
+
+    int done;
+    int flags;                          /* MSG_TRUNC if the datagram is truncated */
+    rt_size_t copied;
+    rt_size_t namelen;
+    char name[UNIX_PATH_MAX];
+    rt_wqueue_t wait;
+};
+
+struct unix_sock
+{
+    int id;                             /* the socket descriptor of the family */
+    int type;
+    rt_atomic_t ref;
+
+    /* the name is protected by unix_lock */
+    char *name;                         /* the normalized path or the abstract name */
+    rt_size_t namelen;
+    rt_list_t name_node;
+
+    struct rt_mutex lock;               /* protects the fields below */
+    int state;
+    int flags;
+    struct unix_sock *peer;             /* the peer holds a reference of the socket */
+    rt_list_t rx_queue;                 /* the messages received */
+    rt_size_t rx_bytes;
+    rt_size_t rcvbuf;
+    rt_size_t sndbuf;
+    struct unix_reader *reader;
+    int rcvtimeo;
+    int sndtimeo;
+
+    rt_list_t accept_queue;             /* the connections not accepted yet */
+    rt_list_t accept_node;
+    int backlog;
+    int pending;
+
+    rt_wqueue_t rx_wait;                /* the readers and the acceptors */
+    rt_wqueue_t tx_wait;                /* the writers waiting for the space of the rx_queue */
+    rt_wqueue_t poll_wait;
+};
+
+static struct rt_mutex unix_lock;       /* protects the table and the namespace */
+static struct unix_sock *unix_table[UNIX_SOCKETS_NUM];
+static rt_list_t unix_names = RT_LIST_OBJECT_INIT(unix_names);
+
+#define UNIX_SOCK_GET(sock, s)                                                    \
+do {                                                                              \
+    (sock) = unix_sock_get(s);                                                    \
+    if ((sock) == RT_NULL) {                                                      \
+        rt_set_errno(-EBADF);                                                     \
+        return -1;                                                                \
+    }                                                                             \
+}while(0)                                                                         \
+
+rt_inline rt_size_t unix_min(rt_size_t a, rt_size_t b)
+{
+    return a < b ? a : b;
+}
+
+static int unix_result(int ret)
+{
+    if (ret < 0)
+    {
+        rt_set_errno(ret);
+        return -1;
+    }
+
+    return ret;
+}
+
+static int unix_wait(rt_wqueue_t *queue, int timeout)
+{
+    int ret;
+
+    ret = rt_wqueue_wait_interruptible(queue, 0, timeout);
+    if (ret == -RT_ETIMEOUT)
+    {
+        return -EAGAIN;
+    }
+
+    return ret == RT_EOK ? 0 : -EINTR;
+}
+
+/* wake up all of the threads on the queue, such as the socket is closed */
+static void unix_wakeup_all(rt_wqueue_t *queue)
+{
+    unsigned int count;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    count = rt_list_len(&queue->waiting_list);
+    rt_hw_interrupt_enable(level);
+
+    do
+    {
+        rt_wqueue_wakeup(queue, RT_NULL);
+    } while (count-- > 1);
+}
+
+/* wake up the readers and the pollers of the socket, with its lock held */
+static void unix_wakeup_rx(struct unix_sock *sock)
+{
+    if (sock->reader)
+    {
+        rt_wqueue_wakeup(&sock->reader->wait, RT_NULL);
+    }
+    rt_wqueue_wakeup(&sock->rx_wait, RT_NULL);
+    rt_wqueue_wakeup(&sock->poll_wait, (void *)POLLIN);
+}
+
+/* wake up all of the threads waiting for the socket, with its lock held */
+static void unix_wakeup_state(struct unix_sock *sock)
+{
+    if (sock->reader)
+    {
+        rt_wqueue_wakeup(&sock->reader->wait, RT_NULL);
+    }
+    unix_wakeup_all(&sock->rx_wait);
+    unix_wakeup_all(&sock->tx_wait);
+    unix_wakeup_all(&sock->poll_wait);
+}
+
+static rt_size_t unix_iov_len(const struct msghdr *message)
+{
+    int idx;
+    rt_size_t len = 0;
+
+    for (idx = 0; idx < message->msg_iovlen; idx++)
+    {
+        len += message->msg_iov[idx].iov_len;
+    }
+
+    return len;
+}
+
+/* copy the data between the buffers of the messages, start at the offsets of them */
+static void unix_iov_copy(const struct iovec *dst, int dst_cnt, rt_size_t dst_off,
+                          const struct iovec *src, int src_cnt, rt_size_t src_off, rt_size_t len)
+{
+    rt_size_t size;
+
+    while (len > 0 && dst_cnt > 0 && src_cnt > 0)
+    {
+        if (dst_off >= dst->iov_len)
+        {
+            dst_off -= dst->iov_len;
+            dst++;
+            dst_cnt--;
+            continue;
+        }
+        if (src_off >= src->iov_len)
+        {
+            src_off -= src->iov_len;
+            src++;
+            src_cnt--;
+            continue;
+        }
+
+        size = unix_min(len, unix_min(dst->iov_len - dst_off, src->iov_len - src_off));
+        rt_memcpy((char *)dst->iov_base + dst_off, (const char *)src->iov_base + src_off, size);
+        dst_off += size;
+        src_off += size;
+        len -= size;
+    }
+}
+
+static void unix_msgs_free(rt_list_t *list)
+{
+    int idx;
+    struct unix_msg *msg;
+
+    while (!rt_list_isempty(list))
+    {
+        msg = rt_list_first_entry(list, struct unix_msg, node);
+        rt_list_remove(&msg->node);
+
+        for (idx = 0; idx < msg->nfds; idx++)
+        {
+            fd_file_put(msg->files[idx]);
+        }
+        rt_free(msg);
+    }
+}
+
+/* move all of the nodes of the list to another one */
+static void unix_list_move(rt_list_t *from, rt_list_t *to)
+{
+    if (!rt_list_isempty(from))
+    {
+        rt_list_insert_before(from, to);
+        rt_list_remove(from);
+    }
+}
+
+static void unix_sock_ref(struct unix_sock *sock)
+{
+    rt_atomic_add(&sock->ref, 1);
+}
+
+/* get the socket of the descriptor with a reference, put it by unix_sock_unref() */
+static struct unix_sock *unix_sock_get(int s)
+{
+    struct unix_sock *sock;
+
+    if (s < 0 || s >= UNIX_SOCKETS_NUM)
+    {
+        return RT_NULL;
+    }
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    sock = unix_table[s];
+    if (sock)
+    {
+        unix_sock_ref(sock);
+    }
+    rt_mutex_release(&unix_lock);
+
+    return sock;
+}
+
+static void unix_sock_unref(struct unix_sock *sock)
+{
+    if (rt_atomic_sub(&sock->ref, 1) != 1)
+    {
+        return;
+    }
+
+    unix_msgs_free(&sock->rx_queue);
+    rt_mutex_detach(&sock->lock);
+    rt_free(sock->name);
+    rt_free(sock);
+}
+
+static int unix_sock_create(int type, int protocol, struct unix_sock **res)
+{
+    int idx;
+    struct unix_sock *sock;
+
+    if (type != SOCK_STREAM && type != SOCK_DGRAM && type != SOCK_SEQPACKET)
+    {
+        return -EPROTOTYPE;
+    }
+    if (protocol != 0)
+    {
+        return -EPROTONOSUPPORT;
+    }
+
+    sock = (struct unix_sock *)rt_calloc(1, sizeof(struct unix_sock));
+    if (sock == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+
+    sock->type = type;
+    sock->ref = 1;
+    rt_list_init(&sock->name_node);
+    rt_mutex_init(&sock->lock, "unix", RT_IPC_FLAG_PRIO);
+    sock->state = UNIX_STATE_UNCONNECTED;
+    rt_list_init(&sock->rx_queue);
+    sock->rcvbuf = UNIX_RCVBUF_DEFAULT;
+    sock->sndbuf = UNIX_RCVBUF_DEFAULT;
+    sock->rcvtimeo = RT_WAITING_FOREVER;
+    sock->sndtimeo = RT_WAITING_FOREVER;
+    rt_list_init(&sock->accept_queue);
+    rt_list_init(&sock->accept_node);
+    rt_wqueue_init(&sock->rx_wait);
+    rt_wqueue_init(&sock->tx_wait);
+    rt_wqueue_init(&sock->poll_wait);
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    for (idx = 0; idx < UNIX_SOCKETS_NUM; idx++)
+    {
+        if (unix_table[idx] == RT_NULL)
+        {
+            sock->id = idx;
+            unix_table[idx] = sock;
+            break;
+        }
+    }
+    rt_mutex_release(&unix_lock);
+
+    if (idx == UNIX_SOCKETS_NUM)
+    {
+        rt_mutex_detach(&sock->lock);
+        rt_free(sock);
+        return -ENFILE;
+    }
+
+    *res = sock;
+    return 0;
+}
+
+/* release the socket as it is closed, the peer sees the end of the stream */
+static void unix_sock_release(struct unix_sock *sock)
+{
+    rt_list_t msgs, pending;
+    struct unix_sock *peer, *child;
+
+    rt_list_init(&msgs);
+    rt_list_init(&pending);
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    if (unix_table[sock->id] != sock)
+    {
+        /* it is released by another closer, which owns the reference of the table */
+        rt_mutex_release(&unix_lock);
+        return;
+    }
+    unix_table[sock->id] = RT_NULL;
+    rt_list_remove(&sock->name_node);
+    rt_mutex_release(&unix_lock);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    sock->state = UNIX_STATE_CLOSED;
+    sock->flags |= UNIX_F_SHUT_RD | UNIX_F_SHUT_WR;
+    peer = sock->peer;
+    sock->peer = RT_NULL;
+    unix_list_move(&sock->rx_queue, &msgs);
+    sock->rx_bytes = 0;
+    unix_list_move(&sock->accept_queue, &pending);
+    sock->pending = 0;
+    unix_wakeup_state(sock);
+    rt_mutex_release(&sock->lock);
+
+    /* the connections not accepted are reset */
+    while (!rt_list_isempty(&pending))
+    {
+        child = rt_list_first_entry(&pending, struct unix_sock, accept_node);
+        rt_list_remove(&child->accept_node);
+        unix_sock_release(child);
+    }
+
+    if (peer)
+    {
+        rt_mutex_take(&peer->lock, RT_WAITING_FOREVER);
+        if (peer->peer == sock)
+        {
+            peer->flags |= UNIX_F_PEER_SHUT;
+            unix_wakeup_state(peer);
+        }
+        rt_mutex_release(&peer->lock);
+        unix_sock_unref(peer);
+    }
+
+    /* the files in flight may be the sockets, drop them without any lock held */
+    unix_msgs_free(&msgs);
+    unix_sock_unref(sock);
+}
+
+/* get the name in the namespace of the address, the path is normalized */
+static int unix_name_get(const struct sockaddr *addr, socklen_t addrlen, char **name, rt_size_t *namelen)
+{
+    rt_size_t len;
+    char path[UNIX_PATH_MAX + 1];
+    const struct sockaddr_un *addr_un = (const struct sockaddr_un *)addr;
+
+    if (addr == RT_NULL || addrlen <= offsetof(struct sockaddr_un, sun_path) || addr->sa_family != AF_UNIX)
+    {
+        return -EINVAL;
+    }
+
+    len = unix_min(addrlen - offsetof(struct sockaddr_un, sun_path), UNIX_PATH_MAX);
+    if (addr_un->sun_path[0] == '\0')
+    {
+        /* the abstract name, which is not a path */
+        *name = (char *)rt_malloc(len);
+        if (*name == RT_NULL)
+        {
+            return -ENOMEM;
+        }
+        rt_memcpy(*name, addr_un->sun_path, len);
+        *namelen = len;
+
+        return 0;
+    }
+
+    rt_memcpy(path, addr_un->sun_path, len);
+    path[len] = '\0';
+
+    *name = dfs_normalize_path(RT_NULL, path);
+    if (*name == RT_NULL)
+    {
+        return -ENOENT;
+    }
+    *namelen = rt_strlen(*name);
+
+    return 0;
+}
+
+static void unix_name_put(const char *name, rt_size_t namelen, struct sockaddr *addr, socklen_t *addrlen)
+{
+    socklen_t len;
+    struct sockaddr_un addr_un;
+
+    if (addr == RT_NULL || addrlen == RT_NULL)
+    {
+        return;
+    }
+
+    rt_memset(&addr_un, 0, sizeof(addr_un));
+    addr_un.sa_family = AF_UNIX;
+    namelen = unix_min(namelen, UNIX_PATH_MAX);
+    rt_memcpy(addr_un.sun_path, name, namelen);
+
+    len = offsetof(struct sockaddr_un, sun_path) + namelen;
+    /* the path is terminated if there is space */
+    if (namelen > 0 && name[0] != '\0' && namelen < UNIX_PATH_MAX)
+    {
+        len++;
+    }
+    addr_un.sa_len = len;
+
+    rt_memcpy(addr, &addr_un, unix_min(*addrlen, len));
+    *addrlen = len;
+}
+
+/* find the socket in the namespace with unix_lock held */
+static struct unix_sock *unix_name_find(const char *name, rt_size_t namelen)
+{
+    struct unix_sock *sock;
+
+    rt_list_for_each_entry(sock, &unix_names, name_node)
+    {
+        if (sock->namelen == namelen && rt_memcmp(sock->name, name, namelen) == 0)
+        {
+            return sock;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* find the socket bound to the address, a reference of it is taken */
+static int unix_lookup(const struct sockaddr *addr, socklen_t addrlen, int type, struct unix_sock **res)
+{
+    int ret = 0;
+    char *name;
+    rt_size_t namelen;
+    struct unix_sock *sock;
+
+    ret = unix_name_get(addr, addrlen, &name, &namelen);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    sock = unix_name_find(name, namelen);
+    if (sock == RT_NULL)
+    {
+        ret = name[0] != '\0' ? -ENOENT : -ECONNREFUSED;
+    }
+    else if (sock->type != type)
+    {
+        ret = -EPROTOTYPE;
+    }
+    else
+    {
+        unix_sock_ref(sock);
+        *res = sock;
+    }
+    rt_mutex_release(&unix_lock);
+
+    rt_free(name);
+    return ret;
+}
+
+/* take the references of the files passed by SCM_RIGHTS */
+static int unix_rights_get(const struct msghdr *message, struct dfs_file **files, int *nfds)
+{
+    int idx, count;
+    int *fds;
+    struct cmsghdr *cmsg;
+    struct dfs_file *file;
+
+    *nfds = 0;
+    if (message->msg_control == RT_NULL)
+    {
+        return 0;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg))
+    {
+        if (cmsg->cmsg_len < CMSG_LEN(0) || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            goto __failed;
+        }
+
+        count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        if (*nfds + count > UNIX_FDS_MAX)
+        {
+            goto __failed;
+        }
+
+        fds = (int *)CMSG_DATA(cmsg);
+        for (idx = 0; idx < count; idx++)
+        {
+            dfs_file_lock();
+            file = fd_get(fds[idx]);
+            if (file)
+            {
+                file->ref_count++;
+            }
+            dfs_file_unlock();
+
+            if (file == RT_NULL)
+            {
+                while (*nfds > 0)
+                {
+                    fd_file_put(files[--(*nfds)]);
+                }
+                return -EBADF;
+            }
+            files[(*nfds)++] = file;
+        }
+    }
+
+    return 0;
+
+__failed:
+    while (*nfds > 0)
+    {
+        fd_file_put(files[--(*nfds)]);
+    }
+    return -EINVAL;
+}
+
+/* install the files received to the fd table, the ones out of the control buffer are closed */
+static void unix_rights_put(struct msghdr *message, struct dfs_file **files, int nfds)
+{
+    int idx, fd, count = 0;
+    int *fds = RT_NULL;
+    struct cmsghdr *cmsg = RT_NULL;
+
+    if (message->msg_control && message->msg_controllen >= CMSG_SPACE(sizeof(int)))
+    {
+        cmsg = (struct cmsghdr *)message->msg_control;
+        fds = (int *)CMSG_DATA(cmsg);
+    }
+
+    for (idx = 0; idx < nfds; idx++)
+    {
+        fd = -1;
+        if (cmsg && CMSG_SPACE((count + 1) * sizeof(int)) <= message->msg_controllen)
+        {
+            fd = fdt_fd_associate_file(dfs_fdtable_get(), DFS_STDIO_OFFSET, files[idx]);
+        }
+
+        if (fd >= 0)
+        {
+            fds[count++] = fd;
+        }
+        else
+        {
+            message->msg_flags |= MSG_CTRUNC;
+        }
+        fd_file_put(files[idx]);
+    }
+
+    if (count > 0)
+    {
+        cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        message->msg_controllen = CMSG_SPACE(count * sizeof(int));
+    }
+    else
+    {
+        message->msg_controllen = 0;
+    }
+}
+
+/*
+ * Deliver the data to the peer with its lock held. The data is copied to the
+ * reader waiting if there is no message queued, or it's queued.
+ *
+ * @return the length of the data delivered, or the negative errno.
+ */
+static int unix_deliver(struct unix_sock *sock, struct unix_sock *peer, const struct msghdr *message,
+                        rt_size_t offset, rt_size_t len, struct dfs_file **files, int nfds)
+{
+    rt_size_t size, namelen;
+    struct unix_msg *msg;
+    struct iovec iov;
+    struct unix_reader *reader = peer->reader;
+
+    /* the name of the sender is received with the datagram only */
+    namelen = sock->type == SOCK_STREAM ? 0 : sock->namelen;
+
+    if (reader && nfds == 0 && rt_list_isempty(&peer->rx_queue))
+    {
+        size = unix_min(len, reader->len);
+        unix_iov_copy(reader->iov, reader->iovcnt, 0, message->msg_iov, message->msg_iovlen, offset, size);
+        reader->copied = size;
+        if (sock->type != SOCK_STREAM)
+        {
+            if (size < len)
+            {
+                reader->flags |= MSG_TRUNC;
+            }
+            reader->namelen = namelen;
+            rt_memcpy(reader->name, sock->name, namelen);
+            size = len;
+        }
+        reader->done = 1;
+
+        peer->reader = RT_NULL;
+        rt_wqueue_wakeup(&reader->wait, RT_NULL);
+
+        return size;
+    }
+
+    msg = (struct unix_msg *)rt_malloc(sizeof(struct unix_msg) + nfds * sizeof(struct dfs_file *) + namelen + len);
+    if (msg == RT_NULL)
+    {
+        return -ENOBUFS;
+    }
+
+    msg->len = len;
+    msg->offset = 0;
+    msg->nfds = nfds;
+    msg->files = (struct dfs_file **)(msg + 1);
+    rt_memcpy(msg->files, files, nfds * sizeof(struct dfs_file *));
+    msg->namelen = namelen;
+    msg->name = (char *)(msg->files + nfds);
+    rt_memcpy(msg->name, sock->name, namelen);
+    msg->data = msg->name + namelen;
+
+    iov.iov_base = msg->data;
+    iov.iov_len = len;
+    unix_iov_copy(&iov, 1, 0, message->msg_iov, message->msg_iovlen, offset, len);
+
+    rt_list_insert_before(&peer->rx_queue, &msg->node);
+    peer->rx_bytes += len;
+    unix_wakeup_rx(peer);
+
+    return len;
+}
+
+static int unix_send(struct unix_sock *sock, const struct msghdr *message, int flags)
+{
+    int ret, nfds;
+    int nonblock;
+    rt_size_t total, space, len, sent = 0;
+    struct dfs_file *files[UNIX_FDS_MAX];
+    struct unix_sock *peer = RT_NULL;
+
+    total = unix_iov_len(message);
+    if (sock->type == SOCK_STREAM && total == 0)
+    {
+        return 0;
+    }
+
+    ret = unix_rights_get(message, files, &nfds);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (message->msg_name && sock->type == SOCK_DGRAM)
+    {
+        ret = unix_lookup((const struct sockaddr *)message->msg_name, message->msg_namelen, sock->type, &peer);
+    }
+    else
+    {
+        rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+        if (sock->flags & UNIX_F_SHUT_WR)
+        {
+            ret = -EPIPE;
+        }
+        else if (sock->peer == RT_NULL)
+        {
+            ret = -ENOTCONN;
+        }
+        else
+        {
+            peer = sock->peer;
+            unix_sock_ref(peer);
+        }
+        rt_mutex_release(&sock->lock);
+    }
+    if (ret < 0)
+    {
+        goto __exit;
+    }
+
+    if (sock->type != SOCK_STREAM && total > peer->rcvbuf)
+    {
+        ret = -EMSGSIZE;
+        goto __exit;
+    }
+
+    nonblock = (sock->flags & UNIX_F_NONBLOCK) || (flags & MSG_DONTWAIT);
+
+    rt_mutex_take(&peer->lock, RT_WAITING_FOREVER);
+    while (1)
+    {
+        if (peer->flags & UNIX_F_SHUT_RD)
+        {
+            ret = sock->type == SOCK_DGRAM ? -ECONNREFUSED : -EPIPE;
+            break;
+        }
+
+        space = peer->rcvbuf > peer->rx_bytes ? peer->rcvbuf - peer->rx_bytes : 0;
+        if (sock->type == SOCK_STREAM ? space > 0 : space >= total)
+        {
+            len = sock->type == SOCK_STREAM ? unix_min(total - sent, space) : total;
+
+            ret = unix_deliver(sock, peer, message, sent, len, files, nfds);
+            if (ret < 0)
+            {
+                break;
+            }
+            /* the files are passed with the first part of the data */
+            nfds = 0;
+            sent += ret;
+            if (sent >= total)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (nonblock)
+        {
+            ret = -EAGAIN;
+            break;
+        }
+
+        rt_mutex_release(&peer->lock);
+        ret = unix_wait(&peer->tx_wait, sock->sndtimeo);
+        rt_mutex_take(&peer->lock, RT_WAITING_FOREVER);
+        if (ret < 0)
+        {
+            break;
+        }
+    }
+    rt_mutex_release(&peer->lock);
+
+    /* the part of the stream sent is returned */
+    if (sent > 0 || ret >= 0)
+    {
+        ret = sent;
+    }
+
+__exit:
+    while (nfds > 0)
+    {
+        fd_file_put(files[--nfds]);
+    }
+    if (peer)
+    {
+        unix_sock_unref(peer);
+    }
+
+    return ret;
+}
+
+/* get the data from the queue with the lock held, the messages consumed are moved to the list */
+static int unix_dequeue(struct unix_sock *sock, struct msghdr *message, rt_size_t len, int flags,
+                        struct dfs_file **files, int *nfds, struct unix_reader *from, rt_list_t *consumed)
+{
+    struct iovec iov;
+    struct unix_msg *msg;
+    rt_size_t size, copied = 0;
+    rt_size_t rx_bytes = sock->rx_bytes;
+
+    while (!rt_list_isempty(&sock->rx_queue))
+    {
+        msg = rt_list_first_entry(&sock->rx_queue, struct unix_msg, node);
+
+        /* the files are received with the first byte of their message */
+        if (copied > 0 && msg->nfds > 0)
+        {
+            break;
+        }
+
+        if (sock->type == SOCK_STREAM)
+        {
+            size = unix_min(len - copied, msg->len - msg->offset);
+        }
+        else
+        {
+            size = unix_min(len, msg->len);
+            if (size < msg->len)
+            {
+                message->msg_flags |= MSG_TRUNC;
+            }
+            from->namelen = msg->namelen;
+            rt_memcpy(from->name, msg->name, msg->namelen);
+        }
+
+        iov.iov_base = msg->data + msg->offset;
+        iov.iov_len = size;
+        unix_iov_copy(message->msg_iov, message->msg_iovlen, copied, &iov, 1, 0, size);
+        copied += size;
+
+        if (flags & MSG_PEEK)
+        {
+            break;
+        }
+
+        if (msg->nfds > 0)
+        {
+            rt_memcpy(files, msg->files, msg->nfds * sizeof(struct dfs_file *));
+            *nfds = msg->nfds;
+            msg->nfds = 0;
+        }
+
+        if (sock->type == SOCK_STREAM)
+        {
+            msg->offset += size;
+            sock->rx_bytes -= size;
+            if (msg->offset < msg->len)
+            {
+                break;
+            }
+        }
+        else
+        {
+            sock->rx_bytes -= msg->len;
+        }
+
+        rt_list_remove(&msg->node);
+        rt_list_insert_before(consumed, &msg->node);
+
+        if (sock->type != SOCK_STREAM || copied == len)
+        {
+            break;
+        }
+    }
+
+    /* the writers wait for the space */
+    if (sock->rx_bytes < rx_bytes)
+    {
+        rt_wqueue_wakeup(&sock->tx_wait, RT_NULL);
+        if (sock->peer)
+        {
+            rt_wqueue_wakeup(&sock->peer->poll_wait, (void *)POLLOUT);
+        }
+    }
+
+    return copied;
+}
+
+static int unix_recv(struct unix_sock *sock, struct msghdr *message, int flags)
+{
+    int ret = 0;
+    int nonblock, nfds = 0;
+    rt_size_t len;
+    rt_list_t consumed;
+    struct dfs_file *files[UNIX_FDS_MAX];
+    struct unix_reader reader;
+
+    len = unix_iov_len(message);
+    nonblock = (sock->flags & UNIX_F_NONBLOCK) || (flags & MSG_DONTWAIT);
+    message->msg_flags = 0;
+    rt_list_init(&consumed);
+
+    reader.iov = message->msg_iov;
+    reader.iovcnt = message->msg_iovlen;
+    reader.len = len;
+    reader.done = 0;
+    reader.flags = 0;
+    reader.copied = 0;
+    reader.namelen = 0;
+    rt_wqueue_init(&reader.wait);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    while (1)
+    {
+        if (sock->state == UNIX_STATE_LISTENING)
+        {
+            ret = -EINVAL;
+            break;
+        }
+
+        if (!rt_list_isempty(&sock->rx_queue))
+        {
+            ret = unix_dequeue(sock, message, len, flags, files, &nfds, &reader, &consumed);
+            break;
+        }
+
+        if ((sock->flags & UNIX_F_SHUT_RD) ||
+            (sock->type != SOCK_DGRAM && (sock->flags & UNIX_F_PEER_SHUT)))
+        {
+            /* the end of the stream */
+            ret = 0;
+            break;
+        }
+
+        if (sock->type != SOCK_DGRAM && sock->state != UNIX_STATE_CONNECTED)
+        {
+            ret = -ENOTCONN;
+            break;
+        }
+
+        if (nonblock)
+        {
+            ret = -EAGAIN;
+            break;
+        }
+
+        if (sock->reader == RT_NULL && !(flags & MSG_PEEK) && len > 0)
+        {
+            /* the writer copies the data to the buffer and wakes up the reader */
+            sock->reader = &reader;
+            rt_mutex_release(&sock->lock);
+            ret = unix_wait(&reader.wait, sock->rcvtimeo);
+            rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+
+            if (sock->reader == &reader)
+            {
+                sock->reader = RT_NULL;
+            }
+            if (reader.done)
+            {
+                message->msg_flags |= reader.flags;
+                ret = reader.copied;
+                break;
+            }
+            /* let another reader wait for the handoff */
+            rt_wqueue_wakeup(&sock->rx_wait, RT_NULL);
+        }
+        else
+        {
+            rt_mutex_release(&sock->lock);
+            ret = unix_wait(&sock->rx_wait, sock->rcvtimeo);
+            rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+        }
+
+        if (ret < 0)
+        {
+            break;
+        }
+    }
+    rt_mutex_release(&sock->lock);
+
+    if (message->msg_name)
+    {
+        unix_name_put(reader.name, reader.namelen, (struct sockaddr *)message->msg_name, &message->msg_namelen);
+    }
+
+    if (nfds > 0)
+    {
+        unix_rights_put(message, files, nfds);
+    }
+    else if (ret >= 0)
+    {
+        message->msg_controllen = 0;
+    }
+
+    unix_msgs_free(&consumed);
+
+    return ret;
+}
+
+static int unix_connect_stream(struct unix_sock *sock, struct unix_sock *listener)
+{
+    int ret = 0;
+    char *name;
+    struct unix_sock *child;
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    if (sock->state != UNIX_STATE_UNCONNECTED)
+    {
+        ret = sock->state == UNIX_STATE_CONNECTED ? -EISCONN : -EINVAL;
+    }
+    rt_mutex_release(&sock->lock);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* the socket accepted by the listener, which has the name of the listener */
+    ret = unix_sock_create(sock->type, 0, &child);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    name = (char *)rt_malloc(listener->namelen);
+    if (name)
+    {
+        rt_memcpy(name, listener->name, listener->namelen);
+        child->name = name;
+        child->namelen = listener->namelen;
+    }
+    rt_mutex_release(&unix_lock);
+
+    unix_sock_ref(sock);
+    child->peer = sock;
+    child->state = UNIX_STATE_CONNECTED;
+
+    rt_mutex_take(&listener->lock, RT_WAITING_FOREVER);
+    while (1)
+    {
+        if (listener->state != UNIX_STATE_LISTENING)
+        {
+            ret = -ECONNREFUSED;
+            break;
+        }
+
+        if (listener->pending < listener->backlog)
+        {
+            rt_list_insert_before(&listener->accept_queue, &child->accept_node);
+            listener->pending++;
+            unix_wakeup_rx(listener);
+            break;
+        }
+
+        if (sock->flags & UNIX_F_NONBLOCK)
+        {
+            ret = -EAGAIN;
+            break;
+        }
+
+        rt_mutex_release(&listener->lock);
+        ret = unix_wait(&listener->tx_wait, sock->sndtimeo);
+        rt_mutex_take(&listener->lock, RT_WAITING_FOREVER);
+        if (ret < 0)
+        {
+            break;
+        }
+    }
+    rt_mutex_release(&listener->lock);
+
+    if (ret < 0)
+    {
+        /* the socket is not visible to any others */
+        child->peer = RT_NULL;
+        unix_sock_unref(sock);
+        unix_sock_release(child);
+        return ret;
+    }
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    unix_sock_ref(child);
+    sock->peer = child;
+    sock->state = UNIX_STATE_CONNECTED;
+    rt_mutex_release(&sock->lock);
+
+    return 0;
+}
+
+static int unix_socket(int domain, int type, int protocol)
+{
+    int ret;
+    int flags = type & SOCK_NONBLOCK;
+    struct unix_sock *sock;
+
+    ret = unix_sock_create(type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC), protocol, &sock);
+    if (ret < 0)
+    {
+        return unix_result(ret);
+    }
+
+    if (flags)
+    {
+        sock->flags |= UNIX_F_NONBLOCK;
+    }
+
+    return sock->id;
+}
+
+static int unix_closesocket(int s)
+{
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    unix_sock_release(sock);
+    unix_sock_unref(sock);
+
+    return 0;
+}
+
+static int unix_bind(int s, const struct sockaddr *name, socklen_t namelen)
+{
+    int ret;
+    char *key;
+    rt_size_t keylen;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_name_get(name, namelen, &key, &keylen);
+    if (ret == 0)
+    {
+        rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+        if (sock->name)
+        {
+            ret = -EINVAL;
+        }
+        else if (unix_name_find(key, keylen))
+        {
+            ret = -EADDRINUSE;
+        }
+        else
+        {
+            sock->name = key;
+            sock->namelen = keylen;
+            rt_list_insert_before(&unix_names, &sock->name_node);
+            key = RT_NULL;
+        }
+        rt_mutex_release(&unix_lock);
+
+        rt_free(key);
+    }
+
+    unix_sock_unref(sock);
+    return unix_result(ret);
+}
+
+static int unix_listen(int s, int backlog)
+{
+    int ret = 0;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    if (sock->type == SOCK_DGRAM)
+    {
+        ret = -EOPNOTSUPP;
+    }
+    else if (sock->state == UNIX_STATE_UNCONNECTED || sock->state == UNIX_STATE_LISTENING)
+    {
+        sock->state = UNIX_STATE_LISTENING;
+        sock->backlog = backlog < 1 ? 1 : unix_min(backlog, UNIX_BACKLOG_MAX);
+        unix_wakeup_all(&sock->tx_wait);
+    }
+    else
+    {
+        ret = -EINVAL;
+    }
+    rt_mutex_release(&sock->lock);
+
+    unix_sock_unref(sock);
+    return unix_result(ret);
+}
+
+static int unix_connect_sock(struct unix_sock *sock, const struct sockaddr *name, socklen_t namelen)
+{
+    int ret;
+    struct unix_sock *peer = RT_NULL, *old;
+
+    if (sock->type == SOCK_DGRAM)
+    {
+        /* the datagram socket is disconnected by AF_UNSPEC */
+        if (name == RT_NULL || name->sa_family != AF_UNSPEC)
+        {
+            ret = unix_lookup(name, namelen, sock->type, &peer);
+            if (ret < 0)
+            {
+                return ret;
+            }
+        }
+
+        rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+        old = sock->peer;
+        sock->peer = peer;
+        rt_mutex_release(&sock->lock);
+
+        if (old)
+        {
+            unix_sock_unref(old);
+        }
+        return 0;
+    }
+
+    ret = unix_lookup(name, namelen, sock->type, &peer);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ret = unix_connect_stream(sock, peer);
+    unix_sock_unref(peer);
+
+    return ret;
+}
+
+static int unix_connect(int s, const struct sockaddr *name, socklen_t namelen)
+{
+    int ret;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_connect_sock(sock, name, namelen);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_accept(int s, struct sockaddr *addr, socklen_t *addrlen)
+{
+    int ret = 0;
+    struct unix_sock *sock, *child = RT_NULL;
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    while (1)
+    {
+        if (sock->state != UNIX_STATE_LISTENING)
+        {
+            ret = -EINVAL;
+            break;
+        }
+
+        if (!rt_list_isempty(&sock->accept_queue))
+        {
+            child = rt_list_first_entry(&sock->accept_queue, struct unix_sock, accept_node);
+            rt_list_remove(&child->accept_node);
+            sock->pending--;
+            /* the connectors wait for the backlog */
+            rt_wqueue_wakeup(&sock->tx_wait, RT_NULL);
+            break;
+        }
+
+        if (sock->flags & UNIX_F_NONBLOCK)
+        {
+            ret = -EAGAIN;
+            break;
+        }
+
+        rt_mutex_release(&sock->lock);
+        ret = unix_wait(&sock->rx_wait, sock->rcvtimeo);
+        rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+        if (ret < 0)
+        {
+            break;
+        }
+    }
+    rt_mutex_release(&sock->lock);
+    unix_sock_unref(sock);
+
+    if (ret < 0)
+    {
+        return unix_result(ret);
+    }
+
+    /* the address of the connector, which is usually unnamed */
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    if (child->peer)
+    {
+        unix_name_put(child->peer->name, child->peer->namelen, addr, addrlen);
+    }
+    else
+    {
+        unix_name_put(RT_NULL, 0, addr, addrlen);
+    }
+    rt_mutex_release(&unix_lock);
+
+    return child->id;
+}
+
+static int unix_sendto(int s, const void *data, size_t size, int flags, const struct sockaddr *to, socklen_t tolen)
+{
+    int ret;
+    struct iovec iov;
+    struct msghdr message;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    iov.iov_base = (void *)data;
+    iov.iov_len = size;
+    rt_memset(&message, 0, sizeof(message));
+    message.msg_name = (void *)to;
+    message.msg_namelen = tolen;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    ret = unix_send(sock, &message, flags);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from, socklen_t *fromlen)
+{
+    int ret;
+    struct iovec iov;
+    struct msghdr message;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    iov.iov_base = mem;
+    iov.iov_len = len;
+    rt_memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    if (from && fromlen)
+    {
+        message.msg_name = from;
+        message.msg_namelen = *fromlen;
+    }
+
+    ret = unix_recv(sock, &message, flags);
+    if (ret >= 0 && from && fromlen)
+    {
+        *fromlen = message.msg_namelen;
+    }
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_sendmsg(int s, const struct msghdr *message, int flags)
+{
+    int ret;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_send(sock, message, flags);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_recvmsg(int s, struct msghdr *message, int flags)
+{
+    int ret;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_recv(sock, message, flags);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_sockopt_get(struct unix_sock *sock, int level, int optname, void *optval, socklen_t *optlen)
+{
+    int value;
+    struct timeval *tv;
+
+    if (level != SOL_SOCKET || optval == RT_NULL || optlen == RT_NULL)
+    {
+        return -ENOPROTOOPT;
+    }
+
+    switch (optname)
+    {
+    case SO_RCVTIMEO:
+    case SO_SNDTIMEO:
+        if (*optlen < sizeof(struct timeval))
+        {
+            return -EINVAL;
+        }
+        value = optname == SO_RCVTIMEO ? sock->rcvtimeo : sock->sndtimeo;
+        tv = (struct timeval *)optval;
+        tv->tv_sec = value < 0 ? 0 : value / 1000;
+        tv->tv_usec = value < 0 ? 0 : (value % 1000) * 1000;
+        *optlen = sizeof(struct timeval);
+        return 0;
+
+    case SO_TYPE:
+        value = sock->type;
+        break;
+    case SO_RCVBUF:
+        value = sock->rcvbuf;
+        break;
+    case SO_SNDBUF:
+        value = sock->sndbuf;
+        break;
+    case SO_ACCEPTCONN:
+        value = sock->state == UNIX_STATE_LISTENING;
+        break;
+    case SO_ERROR:
+        value = 0;
+        break;
+    default:
+        return -ENOPROTOOPT;
+    }
+
+    if (*optlen < sizeof(int))
+    {
+        return -EINVAL;
+    }
+    *(int *)optval = value;
+    *optlen = sizeof(int);
+
+    return 0;
+}
+
+static int unix_getsockopt(int s, int level, int optname, void *optval, socklen_t *optlen)
+{
+    int ret;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_sockopt_get(sock, level, optname, optval, optlen);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_sockopt_set(struct unix_sock *sock, int level, int optname, const void *optval, socklen_t optlen)
+{
+    int value;
+    const struct timeval *tv;
+
+    if (level != SOL_SOCKET || optval == RT_NULL)
+    {
+        return -ENOPROTOOPT;
+    }
+
+    if (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO)
+    {
+        if (optlen < sizeof(struct timeval))
+        {
+            return -EINVAL;
+        }
+        tv = (const struct timeval *)optval;
+        value = tv->tv_sec * 1000 + tv->tv_usec / 1000;
+        /* zero means waiting forever */
+        if (value <= 0)
+        {
+            value = RT_WAITING_FOREVER;
+        }
+        if (optname == SO_RCVTIMEO)
+        {
+            sock->rcvtimeo = value;
+        }
+        else
+        {
+            sock->sndtimeo = value;
+        }
+        return 0;
+    }
+
+    if (optlen < sizeof(int))
+    {
+        return -EINVAL;
+    }
+    value = *(const int *)optval;
+
+    switch (optname)
+    {
+    case SO_RCVBUF:
+        rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+        sock->rcvbuf = value < UNIX_RCVBUF_MIN ? UNIX_RCVBUF_MIN : value;
+        rt_wqueue_wakeup(&sock->tx_wait, RT_NULL);
+        rt_mutex_release(&sock->lock);
+        return 0;
+    case SO_SNDBUF:
+        sock->sndbuf = value < UNIX_RCVBUF_MIN ? UNIX_RCVBUF_MIN : value;
+        return 0;
+    case SO_REUSEADDR:
+    case SO_KEEPALIVE:
+        return 0;
+    default:
+        return -ENOPROTOOPT;
+    }
+}
+
+static int unix_setsockopt(int s, int level, int optname, const void *optval, socklen_t optlen)
+{
+    int ret;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    ret = unix_sockopt_set(sock, level, optname, optval, optlen);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_shutdown(int s, int how)
+{
+    struct unix_sock *sock, *peer;
+
+    if (how != SHUT_RD && how != SHUT_WR && how != SHUT_RDWR)
+    {
+        return unix_result(-EINVAL);
+    }
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    if (how != SHUT_WR)
+    {
+        sock->flags |= UNIX_F_SHUT_RD;
+    }
+    if (how != SHUT_RD)
+    {
+        sock->flags |= UNIX_F_SHUT_WR;
+    }
+    peer = sock->peer;
+    if (peer)
+    {
+        unix_sock_ref(peer);
+    }
+    unix_wakeup_state(sock);
+    rt_mutex_release(&sock->lock);
+
+    if (peer)
+    {
+        if (how != SHUT_RD && sock->type != SOCK_DGRAM)
+        {
+            rt_mutex_take(&peer->lock, RT_WAITING_FOREVER);
+            peer->flags |= UNIX_F_PEER_SHUT;
+            unix_wakeup_state(peer);
+            rt_mutex_release(&peer->lock);
+        }
+        unix_sock_unref(peer);
+    }
+    unix_sock_unref(sock);
+
+    return 0;
+}
+
+static int unix_getpeername(int s, struct sockaddr *name, socklen_t *namelen)
+{
+    int ret = 0;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    if (sock->peer)
+    {
+        unix_name_put(sock->peer->name, sock->peer->namelen, name, namelen);
+    }
+    else
+    {
+        ret = -ENOTCONN;
+    }
+    rt_mutex_release(&sock->lock);
+    rt_mutex_release(&unix_lock);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_getsockname(int s, struct sockaddr *name, socklen_t *namelen)
+{
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&unix_lock, RT_WAITING_FOREVER);
+    unix_name_put(sock->name, sock->namelen, name, namelen);
+    rt_mutex_release(&unix_lock);
+    unix_sock_unref(sock);
+
+    return 0;
+}
+
+static int unix_ioctlsocket(int s, long cmd, void *arg)
+{
+    int ret = 0;
+    struct unix_sock *sock;
+
+    UNIX_SOCK_GET(sock, s);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    switch (cmd)
+    {
+    case F_GETFL:
+        ret = O_RDWR | ((sock->flags & UNIX_F_NONBLOCK) ? O_NONBLOCK : 0);
+        break;
+
+    case F_SETFL:
+        if ((int)(rt_base_t)arg & O_NONBLOCK)
+        {
+            sock->flags |= UNIX_F_NONBLOCK;
+        }
+        else
+        {
+            sock->flags &= ~UNIX_F_NONBLOCK;
+        }
+        break;
+
+    case FIONBIO:
+        if (arg && *(int *)arg)
+        {
+            sock->flags |= UNIX_F_NONBLOCK;
+        }
+        else
+        {
+            sock->flags &= ~UNIX_F_NONBLOCK;
+        }
+        break;
+
+    case FIONREAD:
+        if (arg == RT_NULL)
+        {
+            ret = -EINVAL;
+        }
+        else if (sock->type == SOCK_STREAM || rt_list_isempty(&sock->rx_queue))
+        {
+            *(int *)arg = sock->rx_bytes;
+        }
+        else
+        {
+            /* the length of the next datagram */
+            *(int *)arg = rt_list_first_entry(&sock->rx_queue, struct unix_msg, node)->len;
+        }
+        break;
+
+    default:
+        ret = -EINVAL;
+        break;
+    }
+    rt_mutex_release(&sock->lock);
+    unix_sock_unref(sock);
+
+    return unix_result(ret);
+}
+
+static int unix_poll(struct dfs_file *file, struct rt_pollreq *req)
+{
+    int mask = 0;
+    struct unix_sock *sock, *peer;
+    struct sal_socket *sal_sock;
+
+    sal_sock = sal_get_socket((int)(size_t)file->vnode->data);
+    if (sal_sock == RT_NULL)
+    {
+        return -1;
+    }
+
+    sock = unix_sock_get((int)(size_t)sal_sock->user_data);
+    if (sock == RT_NULL)
+    {
+        return -1;
+    }
+
+    rt_poll_add(&sock->poll_wait, req);
+
+    rt_mutex_take(&sock->lock, RT_WAITING_FOREVER);
+    if (sock->state == UNIX_STATE_LISTENING)
+    {
+        if (sock->pending > 0)
+        {
+            mask |= POLLIN;
+        }
+    }
+    else
+    {
+        if (!rt_list_isempty(&sock->rx_queue) || (sock->flags & UNIX_F_SHUT_RD))
+        {
+            mask |= POLLIN;
+        }
+        if (sock->type != SOCK_DGRAM && (sock->flags & UNIX_F_PEER_SHUT))
+        {
+            mask |= POLLIN | POLLHUP;
+        }
+
+        /* the space of the peer is read without its lock, it's a hint only */
+        peer = sock->peer;
+        if (peer)
+        {
+            if (peer->flags & UNIX_F_SHUT_RD)
+            {
+                mask |= POLLOUT | POLLERR;
+            }
+            else if (peer->rx_bytes < peer->rcvbuf)
+            {
+                mask |= POLLOUT;
+            }
+        }
+        else if (sock->type == SOCK_DGRAM)
+        {
+            mask |= POLLOUT;
+        }
+    }
+    rt_mutex_release(&sock->lock);
+
+    unix_sock_unref(sock);
+
+    return mask;
+}
+
+static int unix_socketpair(int domain, int type, int protocol, int *fds)
+{
+    int ret;
+    int flags = type & SOCK_NONBLOCK;
+    struct unix_sock *sock[2];
+
+    type &= ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    ret = unix_sock_create(type, protocol, &sock[0]);
+    if (ret < 0)
+    {
+        return unix_result(ret);
+    }
+    ret = unix_sock_create(type, protocol, &sock[1]);
+    if (ret < 0)
+    {
+        unix_sock_release(sock[0]);
+        return unix_result(ret);
+    }
+
+    for (ret = 0; ret < 2; ret++)
+    {
+        unix_sock_ref(sock[1 - ret]);
+        sock[ret]->peer = sock[1 - ret];
+        sock[ret]->state = UNIX_STATE_CONNECTED;
+        if (flags)
+        {
+            sock[ret]->flags |= UNIX_F_NONBLOCK;
+        }
+        fds[ret] = sock[ret]->id;
+    }
+
+    return 0;
+}
+
+static const struct sal_socket_ops unix_socket_ops =
+{
+    unix_socket,
+    unix_closesocket,
+    unix_bind,
+    unix_listen,
+    unix_connect,
+    unix_accept,
+    unix_sendto,
+    unix_recvfrom,
+    unix_getsockopt,
+    unix_setsockopt,
+    unix_shutdown,
+    unix_getpeername,
+    unix_getsockname,
+    unix_ioctlsocket,
+    unix_poll,
+    unix_socketpair,
+    unix_sendmsg,
+    unix_recvmsg,
+};
+
+static const struct sal_proto_family unix_family =
+{
+    AF_UNIX,
+    AF_UNIX,
+    &unix_socket_ops,
+    RT_NULL,
+};
+
+int sal_unix_init(void)
+{
+    rt_mutex_init(&unix_lock, "unix_lock", RT_IPC_FLAG_PRIO);
+
+    return sal_proto_family_register(&unix_family);
+}
+INIT_COMPONENT_EXPORT(sal_unix_init);
+
+#endif /* SAL_USING_AF_UNIX */
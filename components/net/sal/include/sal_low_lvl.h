@@ -8,6 +8,7 @@
  * 2018-05-17     ChenYong     First version
  * 2022-05-15     Meco Man     rename sal.h as sal_low_lvl.h to avoid conflicts
  *                             with Microsoft Visual Studio header file
+ * 2023-10-18     RT-Thread    Add the local protocol families
  */
 
 #ifndef SAL_LOW_LEVEL_H__
@@ -82,6 +83,9 @@ struct sal_socket_ops
 #ifdef SAL_USING_POSIX
     int (*poll)       (struct dfs_file *file, struct rt_pollreq *req);
 #endif
+    int (*socketpair) (int domain, int type, int protocol, int *fds);
+    int (*sendmsg)    (int s, const struct msghdr *message, int flags);
+    int (*recvmsg)    (int s, struct msghdr *message, int flags);
 };
 
 /* sal network database name resolving */
@@ -103,6 +107,8 @@ struct sal_proto_family
 
 /* SAL(Socket Abstraction Layer) initialize */
 int sal_init(void);
+/* Register a protocol family which is not bound to a network interface device, such as AF_UNIX */
+int sal_proto_family_register(const struct sal_proto_family *pf);
 /* Get SAL socket object by socket descriptor */
 struct sal_socket *sal_get_socket(int sock);
 
@@ -6,12 +6,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-05-24     ChenYong     First version
+ * 2023-10-18     RT-Thread    Add SOCK_SEQPACKET and the message header
  */
 
 #ifndef SAL_SOCKET_H__
 #define SAL_SOCKET_H__
 
 #include <stddef.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 
 #ifdef __cplusplus
@@ -36,6 +38,7 @@ typedef uint16_t in_port_t;
 #define SOCK_STREAM     1
 #define SOCK_DGRAM      2
 #define SOCK_RAW        3
+#define SOCK_SEQPACKET  5
 #define SOCK_PACKET     10
 
 #define SOCK_NONBLOCK   04000
@@ -104,6 +107,10 @@ typedef uint16_t in_port_t;
 #define MSG_DONTWAIT    0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE        0x10    /* Sender will send more */
 
+/* Flags of the received message in msghdr.msg_flags */
+#define MSG_TRUNC       0x20    /* The datagram is truncated */
+#define MSG_CTRUNC      0x40    /* The control data is truncated */
+
 /* Options for level IPPROTO_IP */
 #define IP_TOS             1
 #define IP_TTL             2
@@ -172,6 +179,43 @@ struct sockaddr_un
     char sun_path[108];         /* Path name.  */
 };
 
+struct msghdr
+{
+    void          *msg_name;
+    socklen_t      msg_namelen;
+    struct iovec  *msg_iov;
+    int            msg_iovlen;
+    void          *msg_control;
+    socklen_t      msg_controllen;
+    int            msg_flags;
+};
+
+/* The ancillary data, the data of it follows the header */
+struct cmsghdr
+{
+    socklen_t      cmsg_len;   /* number of bytes, including header */
+    int            cmsg_level; /* originating protocol */
+    int            cmsg_type;  /* protocol-specific type */
+};
+
+/* Types of the ancillary data of the level SOL_SOCKET */
+#define SCM_RIGHTS      0x01    /* The file descriptors passed by AF_UNIX socket */
+
+#define CMSG_ALIGN(len)         (((len) + sizeof(long) - 1) & ~(sizeof(long) - 1))
+#define CMSG_DATA(cmsg)         ((unsigned char *)(cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+#define CMSG_SPACE(len)         (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(len))
+#define CMSG_LEN(len)           (CMSG_ALIGN(sizeof(struct cmsghdr)) + (len))
+
+#define CMSG_FIRSTHDR(mhdr)                                                     \
+    ((mhdr)->msg_controllen >= sizeof(struct cmsghdr) ?                         \
+     (struct cmsghdr *)(mhdr)->msg_control : (struct cmsghdr *)NULL)
+
+#define CMSG_NXTHDR(mhdr, cmsg)                                                 \
+    (((unsigned char *)(cmsg) + CMSG_ALIGN((cmsg)->cmsg_len) +                  \
+      CMSG_ALIGN(sizeof(struct cmsghdr)) >                                      \
+      (unsigned char *)(mhdr)->msg_control + (mhdr)->msg_controllen) ?         \
+     (struct cmsghdr *)NULL :                                                   \
+     (struct cmsghdr *)((unsigned char *)(cmsg) + CMSG_ALIGN((cmsg)->cmsg_len)))
 
 #if NETDEV_IPV4
 /* members are in network byte order */
@@ -259,6 +303,9 @@ int sal_sendto(int socket, const void *dataptr, size_t size, int flags,
 int sal_socket(int domain, int type, int protocol);
 int sal_closesocket(int socket);
 int sal_ioctlsocket(int socket, long cmd, void *arg);
+int sal_socketpair(int domain, int type, int protocol, int *fds);
+int sal_sendmsg(int socket, const struct msghdr *message, int flags);
+int sal_recvmsg(int socket, struct msghdr *message, int flags);
 
 #ifdef __cplusplus
 }
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2015-02-17     Bernard      First version
  * 2018-05-17     ChenYong     Add socket abstraction layer
+ * 2023-10-18     RT-Thread    Add socketpair/sendmsg/recvmsg
  */
 
 #ifndef SYS_SOCKET_H_
@@ -39,6 +40,9 @@ int send(int s, const void *dataptr, size_t size, int flags);
 int sendto(int s, const void *dataptr, size_t size, int flags,
     const struct sockaddr *to, socklen_t tolen);
 int socket(int domain, int type, int protocol);
+int socketpair(int domain, int type, int protocol, int *sv);
+int sendmsg(int s, const struct msghdr *message, int flags);
+int recvmsg(int s, struct msghdr *message, int flags);
 int closesocket(int s);
 int ioctlsocket(int s, long cmd, void *arg);
 #else
@@ -56,6 +60,9 @@ int ioctlsocket(int s, long cmd, void *arg);
 #define send(s, dataptr, size, flags)                      sal_sendto(s, dataptr, size, flags, NULL, NULL)
 #define sendto(s, dataptr, size, flags, to, tolen)         sal_sendto(s, dataptr, size, flags, to, tolen)
 #define socket(domain, type, protocol)                     sal_socket(domain, type, protocol)
+#define socketpair(domain, type, protocol, sv)             sal_socketpair(domain, type, protocol, sv)
+#define sendmsg(s, message, flags)                         sal_sendmsg(s, message, flags)
+#define recvmsg(s, message, flags)                         sal_recvmsg(s, message, flags)
 #define closesocket(s)                                     sal_closesocket(s)
 #define ioctlsocket(s, cmd, arg)                           sal_ioctlsocket(s, cmd, arg)
 #endif /* SAL_USING_POSIX */
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2015-02-17     Bernard      First version
  * 2018-05-17     ChenYong     Add socket abstraction layer
+ * 2023-10-18     RT-Thread    Add socketpair/sendmsg/recvmsg and the native AF_UNIX
  */
 
 #include <dfs.h>
@@ -16,39 +17,26 @@
 #include <sys/errno.h>
 #include <sys/socket.h>
 
-int accept(int s, struct sockaddr *addr, socklen_t *addrlen)
+/* create the fd of the socket in file system, the socket is not closed on failure */
+static int socket_fd_new(int socket)
 {
-    int new_socket = -1;
-    int socket = dfs_net_getsocket(s);
+    int fd;
+    struct dfs_file *d;
 
-    new_socket = sal_accept(socket, addr, addrlen);
-    if (new_socket != -1)
+    /* allocate a fd */
+    fd = fd_new();
+    if (fd < 0)
     {
-        /* this is a new socket, create it in file system fd */
-        int fd;
-        struct dfs_file *d;
-
-        /* allocate a fd */
-        fd = fd_new();
-        if (fd < 0)
-        {
-            rt_set_errno(-ENOMEM);
-            sal_closesocket(new_socket);
-            return -1;
-        }
+        return -1;
+    }
 
-        d = fd_get(fd);
-        if(d)
+    d = fd_get(fd);
+    if (d)
+    {
+        /* this is a socket fd */
+        d->vnode = (struct dfs_vnode *)rt_malloc(sizeof(struct dfs_vnode));
+        if (d->vnode)
         {
-            /* this is a socket fd */
-            d->vnode = (struct dfs_vnode *)rt_malloc(sizeof(struct dfs_vnode));
-            if (!d->vnode)
-            {
-                /* release fd */
-                fd_release(fd);
-                rt_set_errno(-ENOMEM);
-                return -1;
-            }
             rt_memset(d->vnode, 0, sizeof(struct dfs_vnode));
             rt_list_init(&d->vnode->list);
 
@@ -62,34 +50,45 @@ int accept(int s, struct sockaddr *addr, socklen_t *addrlen)
             d->pos = 0;
 
             /* set socket to the data of dfs_file */
-            d->vnode->data = (void *)(size_t)new_socket;
+            d->vnode->data = (void *)(size_t)socket;
 
             return fd;
         }
-
-        rt_set_errno(-ENOMEM);
-        sal_closesocket(new_socket);
-        return -1;
     }
 
+    /* release fd */
+    fd_release(fd);
     return -1;
 }
-RTM_EXPORT(accept);
 
-int bind(int s, const struct sockaddr *name, socklen_t namelen)
+int accept(int s, struct sockaddr *addr, socklen_t *addrlen)
 {
+    int fd;
+    int new_socket = -1;
     int socket = dfs_net_getsocket(s);
 
-#ifdef SAL_USING_AF_UNIX
-    struct sockaddr_in server_addr = {0};
-    if (name->sa_family == AF_UNIX)
+    new_socket = sal_accept(socket, addr, addrlen);
+    if (new_socket != -1)
     {
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(514);
-        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-        return sal_bind(socket, (struct sockaddr *)&server_addr, namelen);
+        /* this is a new socket, create it in file system fd */
+        fd = socket_fd_new(new_socket);
+        if (fd < 0)
+        {
+            rt_set_errno(-ENOMEM);
+            sal_closesocket(new_socket);
+            return -1;
+        }
+
+        return fd;
     }
-#endif /* SAL_USING_AF_UNIX */
+
+    return -1;
+}
+RTM_EXPORT(accept);
+
+int bind(int s, const struct sockaddr *name, socklen_t namelen)
+{
+    int socket = dfs_net_getsocket(s);
 
     return sal_bind(socket, name, namelen);
 }
@@ -165,17 +164,6 @@ int connect(int s, const struct sockaddr *name, socklen_t namelen)
 {
     int socket = dfs_net_getsocket(s);
 
-#ifdef SAL_USING_AF_UNIX
-    struct sockaddr_in server_addr = {0};
-    if (name->sa_family == AF_UNIX)
-    {
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(514);
-        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-        return sal_connect(socket, (struct sockaddr *)&server_addr, namelen);
-    }
-#endif /* SAL_USING_AF_UNIX */
-
     return sal_connect(socket, name, namelen);
 }
 RTM_EXPORT(connect);
@@ -222,6 +210,22 @@ int sendto(int s, const void *dataptr, size_t size, int flags,
 }
 RTM_EXPORT(sendto);
 
+int recvmsg(int s, struct msghdr *message, int flags)
+{
+    int socket = dfs_net_getsocket(s);
+
+    return sal_recvmsg(socket, message, flags);
+}
+RTM_EXPORT(recvmsg);
+
+int sendmsg(int s, const struct msghdr *message, int flags)
+{
+    int socket = dfs_net_getsocket(s);
+
+    return sal_sendmsg(socket, message, flags);
+}
+RTM_EXPORT(sendmsg);
+
 int socket(int domain, int type, int protocol)
 {
     /* create a BSD socket */
@@ -247,13 +251,6 @@ int socket(int domain, int type, int protocol)
         return -1;
     }
 
-#ifdef SAL_USING_AF_UNIX
-    if (domain == AF_UNIX)
-    {
-        domain = AF_INET;
-    }
-#endif /* SAL_USING_AF_UNIX */
-
     /* create socket  and then put it to the dfs_file */
     socket = sal_socket(domain, type, protocol);
     if (socket >= 0)
@@ -287,6 +284,45 @@ int socket(int domain, int type, int protocol)
 }
 RTM_EXPORT(socket);
 
+int socketpair(int domain, int type, int protocol, int *sv)
+{
+    int idx;
+    int sockets[2];
+
+    if (sv == RT_NULL)
+    {
+        rt_set_errno(-EFAULT);
+        return -1;
+    }
+
+    if (sal_socketpair(domain, type, protocol, sockets) < 0)
+    {
+        return -1;
+    }
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        sv[idx] = socket_fd_new(sockets[idx]);
+        if (sv[idx] < 0)
+        {
+            if (idx > 0)
+            {
+                closesocket(sv[0]);
+            }
+            else
+            {
+                sal_closesocket(sockets[0]);
+            }
+            sal_closesocket(sockets[1]);
+            rt_set_errno(-ENOMEM);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+RTM_EXPORT(socketpair);
+
 int closesocket(int s)
 {
     int error = 0;
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2018-05-23     ChenYong     First version
  * 2018-11-12     ChenYong     Add TLS support
+ * 2023-10-18     RT-Thread    Add the local protocol families
  */
 
 #include <rtthread.h>
@@ -56,6 +57,9 @@ struct sal_netdev_res_table
 static struct sal_proto_tls *proto_tls;
 #endif
 
+/* The protocol families of the local sockets, which have no network interface device */
+static const struct sal_proto_family *proto_local[SAL_PROTO_FAMILIES_NUM];
+
 /* The global socket table */
 static struct sal_socket_table socket_table;
 static struct rt_mutex sal_core_lock;
@@ -83,7 +87,7 @@ do {
 
 #define SAL_NETDEV_IS_UP(netdev)                                                  \
 do {                                                                              \
-    if (!netdev_is_up(netdev)) {                                                  \
+    if ((netdev) && !netdev_is_up(netdev)) {                                      \
         return -1;                                                                \
     }                                                                             \
 }while(0)                                                                         \
@@ -96,6 +100,14 @@ do {
     }                                                                             \
 }while(0)                                                                         \
 
+#define SAL_SOCKET_OPS_VALID(sock, pf, ops)                                       \
+do {                                                                              \
+    (pf) = sal_socket_proto_family(sock);                                         \
+    if ((pf) == RT_NULL || (pf)->skt_ops->ops == RT_NULL){                        \
+        return -1;                                                                \
+    }                                                                             \
+}while(0)                                                                         \
+
 #define SAL_NETDEV_NETDBOPS_VALID(netdev, pf, ops)                                \
     ((netdev) && netdev_is_up(netdev) &&                                          \
     ((pf) = (struct sal_proto_family *) (netdev)->sal_user_data) != RT_NULL &&    \
@@ -321,6 +333,68 @@ int sal_proto_tls_register(const struct sal_proto_tls *pt)
 }
 #endif
 
+/**
+ * This function will register a protocol family of the local sockets, which
+ * is not bound to a network interface device, such as AF_UNIX.
+ *
+ * @param pf protocol family object
+ *
+ * @return  0: protocol family register success
+ *         -1: protocol family table is full
+ */
+int sal_proto_family_register(const struct sal_proto_family *pf)
+{
+    int idx;
+    rt_base_t level;
+
+    RT_ASSERT(pf && pf->skt_ops);
+
+    level = rt_hw_interrupt_disable();
+    for (idx = 0; idx < SAL_PROTO_FAMILIES_NUM; idx++)
+    {
+        if (proto_local[idx] == RT_NULL || proto_local[idx] == pf)
+        {
+            proto_local[idx] = pf;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (idx == SAL_PROTO_FAMILIES_NUM)
+    {
+        LOG_E("No space to register protocol family(%d).", pf->family);
+        return -1;
+    }
+
+    return 0;
+}
+
+static const struct sal_proto_family *sal_proto_local_get(int family)
+{
+    int idx;
+
+    for (idx = 0; idx < SAL_PROTO_FAMILIES_NUM && proto_local[idx]; idx++)
+    {
+        if (proto_local[idx]->family == family || proto_local[idx]->sec_family == family)
+        {
+            return proto_local[idx];
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* get the protocol family of the socket by its network interface device or its domain */
+static struct sal_proto_family *sal_socket_proto_family(struct sal_socket *sock)
+{
+    if (sock->netdev)
+    {
+        return (struct sal_proto_family *) sock->netdev->sal_user_data;
+    }
+
+    return (struct sal_proto_family *) sal_proto_local_get(sock->domain);
+}
+
 /**
  * This function will get sal socket object by sal socket descriptor.
  *
@@ -441,6 +515,13 @@ static int socket_init(int family, int type, int protocol, struct sal_socket **r
     sock->type = type;
     sock->protocol = protocol;
 
+    /* the local sockets are not bound to any network interface device */
+    if (sal_proto_local_get(family) != RT_NULL)
+    {
+        sock->netdev = RT_NULL;
+        return 0;
+    }
+
     if (netdv_def && netdev_is_up(netdv_def))
     {
         /* check default network interface device protocol family */
@@ -593,7 +674,7 @@ int sal_accept(int socket, struct sockaddr *addr, socklen_t *addrlen)
     SAL_NETDEV_IS_UP(sock->netdev);
 
     /* check the network interface socket operations */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, accept);
+    SAL_SOCKET_OPS_VALID(sock, pf, accept);
 
     new_socket = pf->skt_ops->accept((int)(size_t)sock->user_data, addr, addrlen);
     if (new_socket != -1)
@@ -659,10 +740,13 @@ int sal_bind(int socket, const struct sockaddr *name, socklen_t namelen)
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* bind network interface by ip address */
-    sal_sockaddr_to_ipaddr(name, &input_ipaddr);
+    if (sock->netdev)
+    {
+        sal_sockaddr_to_ipaddr(name, &input_ipaddr);
+    }
 
     /* check input ipaddr is default netdev ipaddr */
-    if (!ip_addr_isany_val(input_ipaddr))
+    if (sock->netdev && !ip_addr_isany_val(input_ipaddr))
     {
         struct sal_proto_family *input_pf = RT_NULL, *local_pf = RT_NULL;
         struct netdev *new_netdev = RT_NULL;
@@ -674,7 +758,7 @@ int sal_bind(int socket, const struct sockaddr *name, socklen_t namelen)
         }
 
         /* get input and local ip address proto_family */
-        SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, local_pf, bind);
+        SAL_SOCKET_OPS_VALID(sock, local_pf, bind);
         SAL_NETDEV_SOCKETOPS_VALID(new_netdev, input_pf, bind);
 
         /* check the network interface protocol family type */
@@ -696,7 +780,7 @@ int sal_bind(int socket, const struct sockaddr *name, socklen_t namelen)
     }
 
     /* check and get protocol families by the network interface device */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, bind);
+    SAL_SOCKET_OPS_VALID(sock, pf, bind);
     return pf->skt_ops->bind((int)(size_t)sock->user_data, name, namelen);
 }
 
@@ -711,7 +795,7 @@ int sal_shutdown(int socket, int how)
 
     /* shutdown operation not need to check network interface status */
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, shutdown);
+    SAL_SOCKET_OPS_VALID(sock, pf, shutdown);
 
     if (pf->skt_ops->shutdown((int)(size_t)sock->user_data, how) == 0)
     {
@@ -744,7 +828,7 @@ int sal_getpeername(int socket, struct sockaddr *name, socklen_t *namelen)
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, getpeername);
+    SAL_SOCKET_OPS_VALID(sock, pf, getpeername);
 
     return pf->skt_ops->getpeername((int)(size_t)sock->user_data, name, namelen);
 }
@@ -758,7 +842,7 @@ int sal_getsockname(int socket, struct sockaddr *name, socklen_t *namelen)
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, getsockname);
+    SAL_SOCKET_OPS_VALID(sock, pf, getsockname);
 
     return pf->skt_ops->getsockname((int)(size_t)sock->user_data, name, namelen);
 }
@@ -772,7 +856,7 @@ int sal_getsockopt(int socket, int level, int optname, void *optval, socklen_t *
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, getsockopt);
+    SAL_SOCKET_OPS_VALID(sock, pf, getsockopt);
 
     return pf->skt_ops->getsockopt((int)(size_t)sock->user_data, level, optname, optval, optlen);
 }
@@ -786,7 +870,7 @@ int sal_setsockopt(int socket, int level, int optname, const void *optval, sockl
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, setsockopt);
+    SAL_SOCKET_OPS_VALID(sock, pf, setsockopt);
 
 #ifdef SAL_USING_TLS
     if (level == SOL_TLS)
@@ -836,7 +920,7 @@ int sal_connect(int socket, const struct sockaddr *name, socklen_t namelen)
     /* check the network interface is up status */
     SAL_NETDEV_IS_UP(sock->netdev);
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, connect);
+    SAL_SOCKET_OPS_VALID(sock, pf, connect);
 
     ret = pf->skt_ops->connect((int)(size_t)sock->user_data, name, namelen);
 #ifdef SAL_USING_TLS
@@ -863,7 +947,7 @@ int sal_listen(int socket, int backlog)
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, listen);
+    SAL_SOCKET_OPS_VALID(sock, pf, listen);
 
     return pf->skt_ops->listen((int)(size_t)sock->user_data, backlog);
 }
@@ -880,7 +964,7 @@ int sal_recvfrom(int socket, void *mem, size_t len, int flags,
     /* check the network interface is up status  */
     SAL_NETDEV_IS_UP(sock->netdev);
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, recvfrom);
+    SAL_SOCKET_OPS_VALID(sock, pf, recvfrom);
 
 #ifdef SAL_USING_TLS
     if (SAL_SOCKOPS_PROTO_TLS_VALID(sock, recv))
@@ -914,7 +998,7 @@ int sal_sendto(int socket, const void *dataptr, size_t size, int flags,
     /* check the network interface is up status  */
     SAL_NETDEV_IS_UP(sock->netdev);
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, sendto);
+    SAL_SOCKET_OPS_VALID(sock, pf, sendto);
 
 #ifdef SAL_USING_TLS
     if (SAL_SOCKOPS_PROTO_TLS_VALID(sock, send))
@@ -968,7 +1052,7 @@ int sal_socket(int domain, int type, int protocol)
     }
 
     /* valid the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, socket);
+    SAL_SOCKET_OPS_VALID(sock, pf, socket);
 
     proto_socket = pf->skt_ops->socket(domain, type, protocol);
     if (proto_socket >= 0)
@@ -1002,7 +1086,7 @@ int sal_closesocket(int socket)
 
     /* clsoesocket operation not need to vaild network interface status */
     /* valid the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, closesocket);
+    SAL_SOCKET_OPS_VALID(sock, pf, closesocket);
 
     if (pf->skt_ops->closesocket((int)(size_t)sock->user_data) == 0)
     {
@@ -1039,7 +1123,7 @@ int sal_ioctlsocket(int socket, long cmd, void *arg)
     SAL_SOCKET_OBJ_GET(sock, socket);
 
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, ioctlsocket);
+    SAL_SOCKET_OPS_VALID(sock, pf, ioctlsocket);
 
     struct sal_ifreq *ifr = (struct sal_ifreq *)arg;
 
@@ -1097,6 +1181,127 @@ int sal_ioctlsocket(int socket, long cmd, void *arg)
     return pf->skt_ops->ioctlsocket((int)(size_t)sock->user_data, cmd, arg);
 }
 
+/**
+ * This function will create a pair of connected sockets of a local protocol family.
+ *
+ * @param domain    protocol family, such as AF_UNIX
+ * @param type      socket type
+ * @param protocol  transfer Protocol
+ * @param fds       the SAL socket descriptors of the pair
+ *
+ * @return  0: create success
+ *         -1: create failed
+ */
+int sal_socketpair(int domain, int type, int protocol, int *fds)
+{
+    int idx;
+    int socket[2] = {-1, -1};
+    int proto_socket[2];
+    struct sal_socket *sock[2];
+    const struct sal_proto_family *pf;
+
+    RT_ASSERT(fds);
+
+    pf = sal_proto_local_get(domain);
+    if (pf == RT_NULL || pf->skt_ops->socketpair == RT_NULL)
+    {
+        return -1;
+    }
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        socket[idx] = socket_new();
+        sock[idx] = sal_get_socket(socket[idx]);
+        if (sock[idx] == RT_NULL || socket_init(domain, type, protocol, &sock[idx]) < 0)
+        {
+            goto __failed;
+        }
+    }
+
+    if (pf->skt_ops->socketpair(domain, type, protocol, proto_socket) < 0)
+    {
+        goto __failed;
+    }
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        sock[idx]->user_data = (void *)(size_t)proto_socket[idx];
+        fds[idx] = sock[idx]->socket;
+    }
+
+    return 0;
+
+__failed:
+    for (idx = 0; idx < 2; idx++)
+    {
+        if (sal_get_socket(socket[idx]) != RT_NULL)
+        {
+            socket_delete(socket[idx]);
+        }
+    }
+    return -1;
+}
+
+int sal_sendmsg(int socket, const struct msghdr *message, int flags)
+{
+    struct sal_socket *sock;
+    struct sal_proto_family *pf;
+
+    RT_ASSERT(message);
+
+    /* get the socket object by socket descriptor */
+    SAL_SOCKET_OBJ_GET(sock, socket);
+
+    /* check the network interface is up status  */
+    SAL_NETDEV_IS_UP(sock->netdev);
+
+    pf = sal_socket_proto_family(sock);
+    if (pf != RT_NULL && pf->skt_ops->sendmsg)
+    {
+        return pf->skt_ops->sendmsg((int)(size_t)sock->user_data, message, flags);
+    }
+
+    /* the protocol family without sendmsg sends the simple message only */
+    if (message->msg_iovlen != 1 || message->msg_controllen != 0)
+    {
+        return -1;
+    }
+
+    return sal_sendto(socket, message->msg_iov[0].iov_base, message->msg_iov[0].iov_len, flags,
+                      (const struct sockaddr *)message->msg_name, message->msg_namelen);
+}
+
+int sal_recvmsg(int socket, struct msghdr *message, int flags)
+{
+    struct sal_socket *sock;
+    struct sal_proto_family *pf;
+
+    RT_ASSERT(message);
+
+    /* get the socket object by socket descriptor */
+    SAL_SOCKET_OBJ_GET(sock, socket);
+
+    /* check the network interface is up status  */
+    SAL_NETDEV_IS_UP(sock->netdev);
+
+    pf = sal_socket_proto_family(sock);
+    if (pf != RT_NULL && pf->skt_ops->recvmsg)
+    {
+        return pf->skt_ops->recvmsg((int)(size_t)sock->user_data, message, flags);
+    }
+
+    /* the protocol family without recvmsg receives the simple message only */
+    if (message->msg_iovlen != 1)
+    {
+        return -1;
+    }
+
+    message->msg_flags = 0;
+    message->msg_controllen = 0;
+    return sal_recvfrom(socket, message->msg_iov[0].iov_base, message->msg_iov[0].iov_len, flags,
+                        (struct sockaddr *)message->msg_name, message->msg_name ? &message->msg_namelen : RT_NULL);
+}
+
 #ifdef SAL_USING_POSIX
 int sal_poll(struct dfs_file *file, struct rt_pollreq *req)
 {
@@ -1110,7 +1315,7 @@ int sal_poll(struct dfs_file *file, struct rt_pollreq *req)
     /* check the network interface is up status  */
     SAL_NETDEV_IS_UP(sock->netdev);
     /* check the network interface socket opreation */
-    SAL_NETDEV_SOCKETOPS_VALID(sock->netdev, pf, poll);
+    SAL_SOCKET_OPS_VALID(sock, pf, poll);
 
     return pf->skt_ops->poll(file, req);
 }
@@ -70,14 +70,15 @@ static rt_bool_t ulog_file_rotate(struct ulog_file_be *be)
 __exit:
     /* reopen the file */
     be->cur_log_file_fd = open(be->cur_log_file_path, O_CREAT | O_RDWR | O_APPEND);
+    be->cur_log_file_size = be->cur_log_file_fd >= 0 ? lseek(be->cur_log_file_fd, 0, SEEK_END) : 0;
 
     return result;
 }
 
-static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
+/* write all buffered logs to the file in one batch, sync the file when it's flushing */
+static void ulog_file_backend_write_buf(struct ulog_file_be *be, rt_bool_t sync)
 {
-    struct ulog_file_be *be = (struct ulog_file_be *) backend;
-    rt_size_t file_size = 0, write_size = 0;
+    rt_size_t write_size = 0;
 
     if (be->enable == RT_FALSE || be->buf_ptr_now == be->file_buf)
     {
@@ -98,10 +99,11 @@ static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
             rt_kprintf("ulog file(%s) open failed.", be->cur_log_file_path);
             return;
         }
+        be->cur_log_file_size = lseek(be->cur_log_file_fd, 0, SEEK_END);
     }
 
-    file_size = lseek(be->cur_log_file_fd, 0, SEEK_END);
-    if (file_size >= (be->file_max_size - be->buf_size * 2))
+    /* the file size is tracked by the backend, no seek for every batch */
+    if (be->cur_log_file_size >= (be->file_max_size - be->buf_size * 2))
     {
         if (!ulog_file_rotate(be))
         {
@@ -115,13 +117,23 @@ static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
     {
         return;
     }
-    /* flush file cache */
-    fsync(be->cur_log_file_fd);
+    be->cur_log_file_size += write_size;
+
+    if (sync)
+    {
+        /* flush file cache */
+        fsync(be->cur_log_file_fd);
+    }
 
     /* point be->buf_ptr_now at the head of be->file_buf[be->buf_size] */
     be->buf_ptr_now = be->file_buf;
 }
 
+static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
+{
+    ulog_file_backend_write_buf((struct ulog_file_be *)backend, RT_TRUE);
+}
+
 static void ulog_file_backend_output_with_buf(struct ulog_backend *backend, rt_uint32_t level,
             const char *tag, rt_bool_t is_raw, const char *log, rt_size_t len)
 {
@@ -152,7 +164,8 @@ static void ulog_file_backend_output_with_buf(struct ulog_backend *backend, rt_u
         /* check the log buffer remain size */
         if (buf_ptr_end == be->buf_ptr_now)
         {
-            ulog_file_backend_flush_with_buf(backend);
+            /* the buffer is full, write the batch but sync it until flushing */
+            ulog_file_backend_write_buf(be, RT_FALSE);
             if (buf_ptr_end == be->buf_ptr_now)
             {
                 /* There is no space, indicating that the data cannot be refreshed
@@ -176,6 +189,7 @@ int ulog_file_backend_init(struct ulog_file_be *be, const char *name, const char
     /* temporarily store the start address of the ulog file buffer */
     be->buf_ptr_now = be->file_buf;
     be->cur_log_file_fd = -1;
+    be->cur_log_file_size = 0;
     be->file_max_num = max_num;
     be->file_max_size = max_size;
     be->buf_size = buf_size;
@@ -22,6 +22,7 @@ struct ulog_file_be
 {
     struct ulog_backend parent;
     int cur_log_file_fd;
+    rt_size_t cur_log_file_size;
     rt_size_t file_max_num;
     rt_size_t file_max_size;
     rt_size_t buf_size;
@@ -24,6 +24,10 @@
 #include <rtdevice.h>
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+#include <rtatomic.h>
+#endif
+
 #ifdef RT_USING_ULOG
 
 /* the number which is max stored line logs */
@@ -70,6 +74,54 @@
 #error "the log line buffer size must more than 80"
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+#define ULOG_DEFERRED_SIZE             RT_ALIGN(ULOG_DEFERRED_BUF_SIZE, sizeof(rt_uint64_t))
+
+#if ULOG_DEFERRED_BUF_SIZE > 65528
+#error "the deferred log buffer size must not more than 65528"
+#endif
+
+#ifdef RT_USING_SMP
+#define ULOG_CPU_ID()                  rt_hw_cpu_id()
+#else
+#define ULOG_CPU_ID()                  0
+#define rt_hw_local_irq_disable        rt_hw_interrupt_disable
+#define rt_hw_local_irq_enable         rt_hw_interrupt_enable
+#endif
+
+#define ULOG_DEFERRED_NEWLINE          0x01
+#define ULOG_DEFERRED_ISR              0x02
+#define ULOG_DEFERRED_PAD              0x80
+
+/* the log record which is formatted by the async output */
+struct ulog_deferred_rec
+{
+    /* the record size, the padding record fills the buffer to end */
+    rt_uint16_t size;
+    rt_uint8_t level;
+    rt_uint8_t flags;
+    rt_tick_t tick;
+#ifdef ULOG_TIME_USING_TIMESTAMP
+    struct timeval tv;
+#endif
+#ifdef ULOG_OUTPUT_THREAD_NAME
+    char thread_name[RT_NAME_MAX];
+#endif
+    const char *tag;
+    const char *format;
+    /* the raw arguments, a string is stored as length and the characters */
+    rt_uint64_t args[];
+};
+
+/* single producer (the CPU owns it), single consumer (the async output) ring */
+struct ulog_deferred_buf
+{
+    rt_atomic_t head;
+    rt_atomic_t tail;
+    rt_uint8_t buf[ULOG_DEFERRED_SIZE];
+};
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 struct rt_ulog
 {
     rt_bool_t init_ok;
@@ -95,6 +147,16 @@ struct rt_ulog
     struct rt_semaphore async_notice;
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    rt_bool_t deferred_enabled;
+    struct ulog_deferred_buf *deferred_bufs;
+    /* the consumer's locker and line buffer */
+    struct rt_mutex deferred_locker;
+    char log_buf_deferred[ULOG_LINE_BUF_SIZE + 1];
+    /* the record is formatting, the head uses its time and thread */
+    const struct ulog_deferred_rec *deferred_rec;
+#endif
+
 #ifdef ULOG_USING_FILTER
     struct
     {
@@ -277,6 +339,14 @@ rt_weak rt_size_t ulog_head_formater(char *log_buf, rt_uint32_t level, const cha
         static rt_bool_t check_usec_support = RT_FALSE, usec_is_support = RT_FALSE;
         time_t t = (time_t)0;
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        if (ulog.deferred_rec)
+        {
+            now = ulog.deferred_rec->tv;
+            t = now.tv_sec;
+        }
+        else
+#endif
         if (gettimeofday(&now, RT_NULL) >= 0)
         {
             t = now.tv_sec;
@@ -308,7 +378,11 @@ rt_weak rt_size_t ulog_head_formater(char *log_buf, rt_uint32_t level, const cha
         static rt_size_t tick_len = 0;
 
         log_buf[log_len] = '[';
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        tick_len = ulog_ultoa(log_buf + log_len + 1, ulog.deferred_rec ? ulog.deferred_rec->tick : rt_tick_get());
+#else
         tick_len = ulog_ultoa(log_buf + log_len + 1, rt_tick_get());
+#endif
         log_buf[log_len + 1 + tick_len] = ']';
         log_buf[log_len + 1 + tick_len + 1] = '\0';
 #endif /* ULOG_TIME_USING_TIMESTAMP */
@@ -345,6 +419,22 @@ rt_weak rt_size_t ulog_head_formater(char *log_buf, rt_uint32_t level, const cha
         log_len += ulog_strcpy(log_len, log_buf + log_len, " ");
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+        if (ulog.deferred_rec)
+        {
+            if (ulog.deferred_rec->flags & ULOG_DEFERRED_ISR)
+            {
+                log_len += ulog_strcpy(log_len, log_buf + log_len, "ISR");
+            }
+            else
+            {
+                rt_size_t name_len = rt_strnlen(ulog.deferred_rec->thread_name, RT_NAME_MAX);
+                rt_strncpy(log_buf + log_len, ulog.deferred_rec->thread_name, name_len);
+                log_len += name_len;
+            }
+        }
+        else
+#endif
         /* is not in interrupt context */
         if (rt_interrupt_get_nest() == 0)
         {
@@ -621,6 +711,498 @@ static void do_output(rt_uint32_t level, const char *tag, rt_bool_t is_raw, cons
 #endif /* ULOG_USING_ASYNC_OUTPUT */
 }
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+struct ulog_deferred_spec
+{
+    const char *start;
+    rt_size_t len;
+    rt_size_t stars;
+    /* 0: int, 'l': long, 'q': long long */
+    char qualifier;
+    char conv;
+};
+
+/* find the next conversion specification, the "%%" is skipped */
+static const char *ulog_deferred_spec_next(const char *format, struct ulog_deferred_spec *spec)
+{
+    const char *p;
+
+    for (; *format; ++format)
+    {
+        if (*format != '%')
+        {
+            continue;
+        }
+        if (format[1] == '%')
+        {
+            ++format;
+            continue;
+        }
+
+        p = format + 1;
+        spec->stars = 0;
+        spec->qualifier = 0;
+
+        /* flags */
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+        {
+            ++p;
+        }
+        /* width */
+        if (*p == '*')
+        {
+            ++spec->stars;
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9')
+        {
+            ++p;
+        }
+        /* precision */
+        if (*p == '.')
+        {
+            ++p;
+            if (*p == '*')
+            {
+                ++spec->stars;
+                ++p;
+            }
+            while (*p >= '0' && *p <= '9')
+            {
+                ++p;
+            }
+        }
+        /* length */
+        if (*p == 'h')
+        {
+            ++p;
+            if (*p == 'h')
+            {
+                ++p;
+            }
+        }
+        else if (*p == 'l')
+        {
+            spec->qualifier = 'l';
+            ++p;
+            if (*p == 'l')
+            {
+                spec->qualifier = 'q';
+                ++p;
+            }
+        }
+        else if (*p == 'z' || *p == 't')
+        {
+            spec->qualifier = 'l';
+            ++p;
+        }
+        else if (*p == 'j')
+        {
+            spec->qualifier = 'q';
+            ++p;
+        }
+
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        spec->conv = *p;
+        spec->start = format;
+        spec->len = p + 1 - format;
+
+        return format;
+    }
+
+    return RT_NULL;
+}
+
+/* pack the raw arguments to slots, return the used slots or -1 if it's not supported */
+static int ulog_deferred_pack(rt_uint64_t *slot, rt_size_t slots, const char *format, va_list args)
+{
+    rt_size_t used = 0, i, len;
+    struct ulog_deferred_spec spec;
+    const char *str;
+    double dval;
+
+    while ((format = ulog_deferred_spec_next(format, &spec)) != RT_NULL)
+    {
+        format += spec.len;
+
+        if (used + spec.stars + 1 > slots)
+        {
+            return -1;
+        }
+
+        /* the '*' width and precision */
+        for (i = 0; i < spec.stars; ++i)
+        {
+            slot[used++] = (rt_uint64_t)(rt_int64_t)va_arg(args, int);
+        }
+
+        switch (spec.conv)
+        {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            if (spec.qualifier == 'q')
+            {
+                slot[used++] = (rt_uint64_t)va_arg(args, long long);
+            }
+            else if (spec.qualifier == 'l')
+            {
+                slot[used++] = (rt_uint64_t)va_arg(args, long);
+            }
+            else
+            {
+                slot[used++] = (rt_uint64_t)va_arg(args, int);
+            }
+            break;
+
+        case 'p':
+            slot[used++] = (rt_uint64_t)(rt_ubase_t)va_arg(args, void *);
+            break;
+
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            dval = va_arg(args, double);
+            rt_memcpy(&slot[used++], &dval, sizeof(dval));
+            break;
+
+        case 's':
+            /* the string may be released after return, copy it */
+            str = va_arg(args, const char *);
+            if (str == RT_NULL)
+            {
+                str = "(NULL)";
+            }
+            len = rt_strnlen(str, ULOG_LINE_BUF_SIZE);
+            if (used + 1 + RT_ALIGN(len + 1, sizeof(rt_uint64_t)) / sizeof(rt_uint64_t) > slots)
+            {
+                return -1;
+            }
+            slot[used++] = len;
+            rt_memcpy(&slot[used], str, len);
+            ((char *)&slot[used])[len] = '\0';
+            used += RT_ALIGN(len + 1, sizeof(rt_uint64_t)) / sizeof(rt_uint64_t);
+            break;
+
+        default:
+            /* such as "%n" */
+            return -1;
+        }
+    }
+
+    return (int)used;
+}
+
+#define ULOG_DEFERRED_SNPRINTF(value)                                                               \
+    (spec.stars == 0 ? rt_snprintf(log_buf + len, size - len, spec_buf, value) :                    \
+     spec.stars == 1 ? rt_snprintf(log_buf + len, size - len, spec_buf, star[0], value) :           \
+                       rt_snprintf(log_buf + len, size - len, spec_buf, star[0], star[1], value))
+
+/* format the log content by the packed arguments */
+static rt_size_t ulog_deferred_vformat(char *log_buf, rt_size_t size, const char *format, const rt_uint64_t *slot)
+{
+    rt_size_t len = 0, i, str_len;
+    struct ulog_deferred_spec spec;
+    const char *next;
+    char spec_buf[32];
+    int star[2], result;
+    double dval;
+
+    while (len < size)
+    {
+        next = ulog_deferred_spec_next(format, &spec);
+
+        /* the literal text */
+        while (*format && format != next && len < size)
+        {
+            if (format[0] == '%' && format[1] == '%')
+            {
+                ++format;
+            }
+            log_buf[len++] = *format++;
+        }
+
+        if (next == RT_NULL || len >= size || spec.len >= sizeof(spec_buf))
+        {
+            break;
+        }
+
+        format = next + spec.len;
+        rt_memcpy(spec_buf, spec.start, spec.len);
+        spec_buf[spec.len] = '\0';
+
+        for (i = 0; i < spec.stars; ++i)
+        {
+            star[i] = (int)*slot++;
+        }
+
+        switch (spec.conv)
+        {
+        case 's':
+            str_len = (rt_size_t)*slot++;
+            result = ULOG_DEFERRED_SNPRINTF((const char *)slot);
+            slot += RT_ALIGN(str_len + 1, sizeof(rt_uint64_t)) / sizeof(rt_uint64_t);
+            break;
+
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            rt_memcpy(&dval, slot++, sizeof(dval));
+            result = ULOG_DEFERRED_SNPRINTF(dval);
+            break;
+
+        case 'p':
+            result = ULOG_DEFERRED_SNPRINTF((void *)(rt_ubase_t)*slot++);
+            break;
+
+        default:
+            if (spec.qualifier == 'q')
+            {
+                result = ULOG_DEFERRED_SNPRINTF((long long)*slot++);
+            }
+            else if (spec.qualifier == 'l')
+            {
+                result = ULOG_DEFERRED_SNPRINTF((long)*slot++);
+            }
+            else
+            {
+                result = ULOG_DEFERRED_SNPRINTF((int)*slot++);
+            }
+            break;
+        }
+
+        if (result < 0 || (rt_size_t)result >= size - len)
+        {
+            /* using max length */
+            len = size;
+            break;
+        }
+        len += result;
+    }
+
+    return len;
+}
+
+static rt_size_t ulog_deferred_formater(char *log_buf, const struct ulog_deferred_rec *rec)
+{
+    rt_size_t log_len;
+
+    /* log head */
+    log_len = ulog_head_formater(log_buf, rec->level, rec->tag);
+    /* log content */
+    log_len += ulog_deferred_vformat(log_buf + log_len, ULOG_LINE_BUF_SIZE - log_len, rec->format, rec->args);
+    /* log tail */
+    return ulog_tail_formater(log_buf, log_len, rec->flags & ULOG_DEFERRED_NEWLINE, rec->level);
+}
+
+static rt_size_t ulog_deferred_fill(rt_uint8_t *mem, rt_size_t size, rt_uint32_t level, const char *tag,
+        rt_bool_t newline, const char *format, va_list args)
+{
+    int slots;
+    struct ulog_deferred_rec *rec = (struct ulog_deferred_rec *)mem;
+
+    if (size < sizeof(*rec))
+    {
+        return 0;
+    }
+
+    slots = ulog_deferred_pack(rec->args, (size - sizeof(*rec)) / sizeof(rt_uint64_t), format, args);
+    if (slots < 0)
+    {
+        return 0;
+    }
+
+    rec->size = sizeof(*rec) + slots * sizeof(rt_uint64_t);
+    rec->level = level;
+    rec->flags = newline ? ULOG_DEFERRED_NEWLINE : 0;
+    rec->tick = rt_tick_get();
+#ifdef ULOG_TIME_USING_TIMESTAMP
+    gettimeofday(&rec->tv, RT_NULL);
+#endif
+#ifdef ULOG_OUTPUT_THREAD_NAME
+    if (rt_interrupt_get_nest() != 0)
+    {
+        rec->flags |= ULOG_DEFERRED_ISR;
+    }
+    else
+    {
+        rt_strncpy(rec->thread_name, rt_thread_self() ? rt_thread_self()->parent.name : "N/A", RT_NAME_MAX);
+    }
+#endif
+    rec->tag = tag;
+    rec->format = format;
+
+    return rec->size;
+}
+
+/**
+ * record the log into the buffer of current CPU without formatting
+ *
+ * @return RT_TRUE if the log is recorded, RT_FALSE means the caller should output it directly
+ */
+static rt_bool_t ulog_deferred_put(rt_uint32_t level, const char *tag, rt_bool_t newline, const char *format,
+        va_list args)
+{
+    rt_base_t irq_level;
+    rt_size_t head, tail, offset, contig, free_size, rec_size;
+    struct ulog_deferred_buf *dbuf;
+    va_list args_copy;
+
+    if (!ulog.deferred_enabled || !ulog.async_enabled || !ulog.deferred_bufs)
+    {
+        return RT_FALSE;
+    }
+
+    /* the buffer is only written by this CPU, disable local interrupt is enough */
+    irq_level = rt_hw_local_irq_disable();
+
+    dbuf = &ulog.deferred_bufs[ULOG_CPU_ID()];
+    head = rt_atomic_load(&dbuf->head);
+    tail = rt_atomic_load(&dbuf->tail);
+    free_size = ULOG_DEFERRED_SIZE - (head - tail);
+    offset = head % ULOG_DEFERRED_SIZE;
+    contig = ULOG_DEFERRED_SIZE - offset;
+
+    va_copy(args_copy, args);
+    rec_size = ulog_deferred_fill(&dbuf->buf[offset], contig < free_size ? contig : free_size,
+            level, tag, newline, format, args_copy);
+    va_end(args_copy);
+
+    if (rec_size == 0 && contig < free_size)
+    {
+        /* wrap around, the tail of buffer is filled by a padding record */
+        va_copy(args_copy, args);
+        rec_size = ulog_deferred_fill(&dbuf->buf[0], free_size - contig, level, tag, newline, format, args_copy);
+        va_end(args_copy);
+
+        if (rec_size)
+        {
+            struct ulog_deferred_rec *pad = (struct ulog_deferred_rec *)&dbuf->buf[offset];
+
+            pad->size = contig;
+            pad->flags = ULOG_DEFERRED_PAD;
+            rec_size += contig;
+        }
+    }
+
+    if (rec_size)
+    {
+        rt_atomic_add(&dbuf->head, rec_size);
+    }
+
+    rt_hw_local_irq_enable(irq_level);
+
+    /* notice the async output if the buffer was empty */
+    if (rec_size && rt_atomic_load(&dbuf->tail) == head)
+    {
+        rt_sem_release(&ulog.async_notice);
+    }
+
+    return rec_size != 0;
+}
+
+static struct ulog_deferred_rec *ulog_deferred_peek(struct ulog_deferred_buf *dbuf)
+{
+    rt_size_t tail = rt_atomic_load(&dbuf->tail);
+    struct ulog_deferred_rec *rec;
+
+    while (tail != (rt_size_t)rt_atomic_load(&dbuf->head))
+    {
+        rec = (struct ulog_deferred_rec *)&dbuf->buf[tail % ULOG_DEFERRED_SIZE];
+
+        if (!(rec->flags & ULOG_DEFERRED_PAD))
+        {
+            return rec;
+        }
+
+        rt_atomic_add(&dbuf->tail, rec->size);
+        tail += rec->size;
+    }
+
+    return RT_NULL;
+}
+
+static rt_bool_t ulog_deferred_pending(void)
+{
+    int cpu;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        if (rt_atomic_load(&ulog.deferred_bufs[cpu].head) != rt_atomic_load(&ulog.deferred_bufs[cpu].tail))
+        {
+            return RT_TRUE;
+        }
+    }
+
+    return RT_FALSE;
+}
+
+/* format and output the deferred logs of all CPUs in time order */
+static void ulog_deferred_output(void)
+{
+    int cpu;
+    rt_size_t log_len;
+    struct ulog_deferred_rec *rec, *oldest;
+    struct ulog_deferred_buf *dbuf = RT_NULL;
+
+    if (!ulog.deferred_bufs || rt_interrupt_get_nest() != 0 || rt_thread_self() == RT_NULL)
+    {
+        return;
+    }
+
+    rt_mutex_take(&ulog.deferred_locker, RT_WAITING_FOREVER);
+
+    while (1)
+    {
+        oldest = RT_NULL;
+
+        for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+        {
+            rec = ulog_deferred_peek(&ulog.deferred_bufs[cpu]);
+
+            if (rec && (!oldest || (rt_int32_t)(rec->tick - oldest->tick) < 0))
+            {
+                oldest = rec;
+                dbuf = &ulog.deferred_bufs[cpu];
+            }
+        }
+
+        if (oldest == RT_NULL)
+        {
+            break;
+        }
+
+        /* the head formatter uses static variables */
+        output_lock();
+        ulog.deferred_rec = oldest;
+        log_len = ulog_deferred_formater(ulog.log_buf_deferred, oldest);
+        ulog.deferred_rec = RT_NULL;
+        output_unlock();
+
+#ifdef ULOG_USING_FILTER
+        /* keyword filter */
+        if (ulog.filter.keyword[0] == '\0' || rt_strstr(ulog.log_buf_deferred, ulog.filter.keyword))
+#endif
+        {
+            ulog_output_to_all_backend(oldest->level, oldest->tag, RT_FALSE, ulog.log_buf_deferred, log_len);
+        }
+
+        rt_atomic_add(&dbuf->tail, oldest->size);
+    }
+
+    rt_mutex_release(&ulog.deferred_locker);
+}
+
+/**
+ * enable or disable the deferred format mode
+ * the log will be formatted by the caller when mode is disabled
+ *
+ * @param enabled RT_TRUE: enabled, RT_FALSE: disabled
+ */
+void ulog_deferred_enabled(rt_bool_t enabled)
+{
+    ulog.deferred_enabled = enabled;
+}
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 /**
  * output the log by variable argument list
  *
@@ -675,6 +1257,13 @@ void ulog_voutput(rt_uint32_t level, const char *tag, rt_bool_t newline, const r
     }
 #endif /* ULOG_USING_FILTER */
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    if (hex_buf == RT_NULL && ulog_deferred_put(level, tag, newline, format, args))
+    {
+        return;
+    }
+#endif
+
     /* get log buffer */
     log_buf = get_log_buf();
 
@@ -1347,6 +1936,10 @@ void ulog_async_output(void)
         return;
     }
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    ulog_deferred_output();
+#endif
+
     while ((log_blk = rt_rbb_blk_get(ulog.async_rbb)) != RT_NULL)
     {
         log_frame = (ulog_frame_t) log_blk->buf;
@@ -1394,6 +1987,13 @@ void ulog_async_output_enabled(rt_bool_t enabled)
 rt_err_t ulog_async_waiting_log(rt_int32_t time)
 {
     rt_sem_control(&ulog.async_notice, RT_IPC_CMD_RESET, RT_NULL);
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    /* the notice may be sent before reset */
+    if (ulog.deferred_bufs && ulog_deferred_pending())
+    {
+        return RT_EOK;
+    }
+#endif
     return rt_sem_take(&ulog.async_notice, time);
 }
 
@@ -1477,6 +2077,17 @@ int ulog_init(void)
     rt_sem_init(&ulog.async_notice, "ulog", 0, RT_IPC_FLAG_FIFO);
 #endif /* ULOG_USING_ASYNC_OUTPUT */
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    /* deferred format buffer for each CPU */
+    ulog.deferred_bufs = rt_calloc(RT_CPUS_NR, sizeof(struct ulog_deferred_buf));
+    if (ulog.deferred_bufs == RT_NULL)
+    {
+        rt_kprintf("Warning: No memory for ulog deferred buffer, the logs will be formatted directly.\n");
+    }
+    rt_mutex_init(&ulog.deferred_locker, "ulog_dfr", RT_IPC_FLAG_PRIO);
+    ulog.deferred_enabled = RT_TRUE;
+#endif /* ULOG_USING_DEFERRED_FORMAT */
+
 #ifdef ULOG_USING_FILTER
     ulog_global_filter_lvl_set(LOG_FILTER_LVL_ALL);
 #endif
@@ -1547,6 +2158,12 @@ void ulog_deinit(void)
         rt_ringbuffer_destroy(ulog.async_rb);
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    rt_mutex_detach(&ulog.deferred_locker);
+    rt_free(ulog.deferred_bufs);
+    ulog.deferred_bufs = RT_NULL;
+#endif
+
     ulog.init_ok = RT_FALSE;
 }
 
@@ -84,6 +84,10 @@ void ulog_async_output_enabled(rt_bool_t enabled);
 rt_err_t ulog_async_waiting_log(rt_int32_t time);
 #endif
 
+#ifdef ULOG_USING_DEFERRED_FORMAT
+void ulog_deferred_enabled(rt_bool_t enabled);
+#endif
+
 /*
  * dump the hex format data to log
  */
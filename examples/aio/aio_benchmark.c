@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The aio throughput benchmark: each round writes (then reads) one block of
+ * each file with aio_write() (aio_read()), and waits for all of them. It runs
+ * with 1, 2, 4 and 8 files in flight. The throughput scales with the files
+ * only if the requests blocked on I/O do not hold the others, as they do not
+ * in the worker pools (RT_USING_WORKQUEUE_POOL). The last pass writes the
+ * blocks of a round with one lio_listio().
+ *
+ * msh> aio_bench [dir] [block size] [blocks]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#if defined(RT_USING_POSIX_FS) && defined(RT_USING_FINSH)
+#include <aio.h>
+
+#define BENCH_FILES_MAX     8
+#define BENCH_PRIORITY      (RT_THREAD_PRIORITY_MAX / 2)
+#define BENCH_STACK_SIZE    4096
+
+static struct rt_semaphore bench_done;
+static const char *bench_dir;
+static rt_uint32_t bench_block_size;
+static rt_uint32_t bench_blocks;
+static int bench_files;
+static rt_uint32_t bench_ms[3];
+static int bench_errors;
+
+static int fd[BENCH_FILES_MAX];
+static struct aiocb cb[BENCH_FILES_MAX];
+static rt_uint8_t *buf[BENCH_FILES_MAX];
+
+/* submit one block of each file and wait for all of them */
+static void bench_round(rt_uint32_t block, int pass)
+{
+    int i, busy;
+    struct aiocb *list[BENCH_FILES_MAX];
+
+    for (i = 0; i < bench_files; i++)
+    {
+        rt_memset(&cb[i], 0, sizeof(cb[i]));
+        cb[i].aio_fildes = fd[i];
+        cb[i].aio_offset = block * bench_block_size;
+        cb[i].aio_buf = buf[i];
+        cb[i].aio_nbytes = bench_block_size;
+        cb[i].aio_lio_opcode = LIO_WRITE;
+        list[i] = &cb[i];
+
+        if (pass == 2)
+        {
+            continue;
+        }
+        if ((pass == 0 ? aio_write(&cb[i]) : aio_read(&cb[i])) != 0)
+        {
+            cb[i].aio_result = -1;
+        }
+    }
+
+    if (pass == 2 && lio_listio(LIO_NOWAIT, list, bench_files, RT_NULL) != 0)
+    {
+        bench_errors++;
+        return;
+    }
+
+    do
+    {
+        busy = 0;
+        for (i = 0; i < bench_files; i++)
+        {
+            if (aio_error(&cb[i]) == -EINPROGRESS)
+            {
+                busy = 1;
+                aio_suspend((const struct aiocb *const *)&list[i], 1, RT_NULL);
+            }
+        }
+    } while (busy);
+
+    for (i = 0; i < bench_files; i++)
+    {
+        if (aio_return(&cb[i]) != bench_block_size)
+        {
+            bench_errors++;
+        }
+    }
+}
+
+static void bench_entry(void *param)
+{
+    rt_uint32_t block;
+    rt_tick_t start;
+    int pass;
+
+    for (pass = 0; pass < 3; pass++)
+    {
+        start = rt_tick_get();
+        for (block = 0; block < bench_blocks; block++)
+        {
+            bench_round(block, pass);
+        }
+        bench_ms[pass] = (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND;
+    }
+
+    rt_sem_release(&bench_done);
+}
+
+static rt_uint32_t bench_rate(rt_uint32_t ms)
+{
+    rt_uint64_t bytes = (rt_uint64_t)bench_files * bench_blocks * bench_block_size;
+
+    return ms ? (rt_uint32_t)(bytes / 1024 * 1000 / ms) : 0;
+}
+
+static void bench_run(int files)
+{
+    int i;
+    char path[64];
+    rt_thread_t thread;
+
+    bench_files = files;
+    bench_errors = 0;
+
+    for (i = 0; i < files; i++)
+    {
+        rt_snprintf(path, sizeof(path), "%s/aio_bench%d.dat", bench_dir, i);
+        fd[i] = open(path, O_RDWR | O_CREAT | O_TRUNC, 0);
+        buf[i] = rt_malloc(bench_block_size);
+        if (fd[i] < 0 || buf[i] == RT_NULL)
+        {
+            rt_kprintf("%5d     failed to open %s\n", files, path);
+            files = i + 1;
+            goto __exit;
+        }
+        rt_memset(buf[i], i, bench_block_size);
+    }
+
+    thread = rt_thread_create("aio_b", bench_entry, RT_NULL, BENCH_STACK_SIZE, BENCH_PRIORITY, 10);
+    if (thread == RT_NULL)
+    {
+        goto __exit;
+    }
+    rt_thread_startup(thread);
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+
+    rt_kprintf("%5d %12d %12d %12d%s\n", files, bench_rate(bench_ms[0]), bench_rate(bench_ms[1]),
+            bench_rate(bench_ms[2]), bench_errors ? " (error)" : "");
+
+__exit:
+    for (i = 0; i < files; i++)
+    {
+        if (fd[i] >= 0)
+        {
+            close(fd[i]);
+            rt_snprintf(path, sizeof(path), "%s/aio_bench%d.dat", bench_dir, i);
+            unlink(path);
+        }
+        rt_free(buf[i]);
+        buf[i] = RT_NULL;
+    }
+}
+
+static int aio_bench(int argc, char **argv)
+{
+    int files;
+
+    bench_dir = "";
+    bench_block_size = 4096;
+    bench_blocks = 256;
+
+    if (argc > 1)
+    {
+        bench_dir = argv[1];
+    }
+    if (argc > 2)
+    {
+        bench_block_size = atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        bench_blocks = atoi(argv[3]);
+    }
+    if (bench_block_size == 0 || bench_blocks == 0)
+    {
+        rt_kprintf("Usage: aio_bench [dir] [block size] [blocks]\n");
+        return -RT_EINVAL;
+    }
+
+    rt_sem_init(&bench_done, "aio_b", 0, RT_IPC_FLAG_FIFO);
+
+    rt_kprintf("%d blocks of %d bytes for each file\n", bench_blocks, bench_block_size);
+    rt_kprintf("files  write KiB/s   read KiB/s listio KiB/s\n");
+    rt_kprintf("----- ------------ ------------ ------------\n");
+
+    for (files = 1; files <= BENCH_FILES_MAX; files <<= 1)
+    {
+        bench_run(files);
+    }
+
+    rt_sem_detach(&bench_done);
+
+    return 0;
+}
+MSH_CMD_EXPORT(aio_bench, aio throughput benchmark with the files in flight);
+
+#endif /* defined(RT_USING_POSIX_FS) && defined(RT_USING_FINSH) */
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The benchmark of the memory and string routines of the architecture
+ * (ARCH_ARMV8_OPTIMIZED_STRING, ARCH_ARMV8_OPTIMIZED_CHECKSUM) against the
+ * generic C versions of kservice and lwIP, which are copied here as they are
+ * replaced in the kernel. The sizes are from 8 bytes to 1 MiB, the result is
+ * the MiB/s of the C version, the architecture version and the speedup.
+ *
+ * msh> string_bench [offset]
+ *
+ * The offset misaligns the source (and the destination by offset / 2).
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+
+#if defined(ARCH_ARMV8) && defined(ARCH_CPU_64BIT) && defined(RT_USING_FINSH)
+#include <cpuport.h>
+
+#define BENCH_SIZE_MIN      8
+#define BENCH_SIZE_MAX      (1024 * 1024)
+#define BENCH_BYTES         (16 * 1024 * 1024)  /* the bytes of each measurement */
+#define BENCH_ROUNDS_MIN    16
+
+typedef rt_ubase_t (*bench_func_t)(void *dst, void *src, rt_size_t size);
+
+static rt_uint64_t bench_freq;
+
+rt_inline rt_uint64_t bench_clock(void)
+{
+    rt_uint64_t cycles;
+
+    rt_hw_isb();
+    sysreg_read(cntvct_el0, cycles);
+
+    return cycles;
+}
+
+/* the generic C versions in kservice */
+static void *c_memset(void *s, int c, rt_ubase_t count)
+{
+    char *m = (char *)s;
+    unsigned long buffer, *aligned_addr;
+    unsigned char d = (unsigned int)c & (unsigned char)(-1);
+
+    if (count >= sizeof(long) && !((long)s & (sizeof(long) - 1)))
+    {
+        aligned_addr = (unsigned long *)s;
+        rt_memset(&buffer, d, sizeof(buffer));
+
+        while (count >= sizeof(long) * 4)
+        {
+            *aligned_addr++ = buffer;
+            *aligned_addr++ = buffer;
+            *aligned_addr++ = buffer;
+            *aligned_addr++ = buffer;
+            count -= 4 * sizeof(long);
+        }
+        while (count >= sizeof(long))
+        {
+            *aligned_addr++ = buffer;
+            count -= sizeof(long);
+        }
+        m = (char *)aligned_addr;
+    }
+
+    while (count--)
+    {
+        *m++ = (char)d;
+    }
+
+    return s;
+}
+
+static void *c_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    char *dst_ptr = (char *)dst;
+    char *src_ptr = (char *)src;
+    long *aligned_dst, *aligned_src;
+
+    if (count >= sizeof(long) * 4 &&
+        !(((long)src_ptr | (long)dst_ptr) & (sizeof(long) - 1)))
+    {
+        aligned_dst = (long *)dst_ptr;
+        aligned_src = (long *)src_ptr;
+
+        while (count >= sizeof(long) * 4)
+        {
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            count -= sizeof(long) * 4;
+        }
+        while (count >= sizeof(long))
+        {
+            *aligned_dst++ = *aligned_src++;
+            count -= sizeof(long);
+        }
+        dst_ptr = (char *)aligned_dst;
+        src_ptr = (char *)aligned_src;
+    }
+
+    while (count--)
+    {
+        *dst_ptr++ = *src_ptr++;
+    }
+
+    return dst;
+}
+
+static rt_int32_t c_memcmp(const void *cs, const void *ct, rt_size_t count)
+{
+    const unsigned char *su1, *su2;
+    int res = 0;
+
+    for (su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+    {
+        if ((res = *su1 - *su2) != 0)
+        {
+            break;
+        }
+    }
+
+    return res;
+}
+
+static rt_size_t c_strlen(const char *s)
+{
+    const char *sc;
+
+    for (sc = s; *sc != '\0'; ++sc)
+    {
+    }
+
+    return sc - s;
+}
+
+/* lwip_standard_chksum() of LWIP_CHKSUM_ALGORITHM 2 */
+static rt_uint16_t c_chksum(const void *dataptr, int len)
+{
+    const rt_uint8_t *pb = (const rt_uint8_t *)dataptr;
+    const rt_uint16_t *ps;
+    rt_uint16_t t = 0;
+    rt_uint32_t sum = 0;
+    int odd = ((rt_ubase_t)pb & 1);
+
+    if (odd && len > 0)
+    {
+        ((rt_uint8_t *)&t)[1] = *pb++;
+        len--;
+    }
+
+    ps = (const rt_uint16_t *)(const void *)pb;
+    while (len > 1)
+    {
+        sum += *ps++;
+        len -= 2;
+    }
+
+    if (len > 0)
+    {
+        ((rt_uint8_t *)&t)[0] = *(const rt_uint8_t *)ps;
+    }
+
+    sum += t;
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+
+    if (odd)
+    {
+        sum = ((sum & 0xff) << 8) | ((sum & 0xff00) >> 8);
+    }
+
+    return (rt_uint16_t)sum;
+}
+
+static rt_ubase_t bench_c_memcpy(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)c_memcpy(dst, src, size);
+}
+
+static rt_ubase_t bench_c_memset(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)c_memset(dst, 0, size);
+}
+
+static rt_ubase_t bench_c_memcmp(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)c_memcmp(dst, src, size);
+}
+
+static rt_ubase_t bench_c_strlen(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)c_strlen(src);
+}
+
+static rt_ubase_t bench_c_chksum(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)c_chksum(src, size);
+}
+
+static rt_ubase_t bench_memcpy(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)rt_memcpy(dst, src, size);
+}
+
+static rt_ubase_t bench_memset(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)rt_memset(dst, 0, size);
+}
+
+static rt_ubase_t bench_memcmp(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)rt_memcmp(dst, src, size);
+}
+
+static rt_ubase_t bench_strlen(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)rt_strlen(src);
+}
+
+#ifdef ARCH_ARMV8_OPTIMIZED_CHECKSUM
+rt_uint16_t rt_hw_inet_chksum(const void *dataptr, int len);
+
+static rt_ubase_t bench_chksum(void *dst, void *src, rt_size_t size)
+{
+    return (rt_ubase_t)rt_hw_inet_chksum(src, size);
+}
+#endif /* ARCH_ARMV8_OPTIMIZED_CHECKSUM */
+
+struct bench_case
+{
+    const char *name;
+    bench_func_t c_func;
+    bench_func_t func;
+    rt_bool_t string;
+};
+
+static const struct bench_case bench_cases[] =
+{
+    { "memcpy", bench_c_memcpy, bench_memcpy, RT_FALSE },
+    { "memset", bench_c_memset, bench_memset, RT_FALSE },
+    { "memcmp", bench_c_memcmp, bench_memcmp, RT_FALSE },
+    { "strlen", bench_c_strlen, bench_strlen, RT_TRUE },
+#ifdef ARCH_ARMV8_OPTIMIZED_CHECKSUM
+    { "chksum", bench_c_chksum, bench_chksum, RT_FALSE },
+#else
+    { "chksum", bench_c_chksum, bench_c_chksum, RT_FALSE },
+#endif
+};
+
+/* return the MiB/s */
+static rt_uint32_t bench_run(bench_func_t func, void *dst, void *src, rt_size_t size)
+{
+    rt_uint32_t i, rounds;
+    rt_uint64_t start, cycles;
+    volatile rt_ubase_t sink = 0;
+
+    rounds = BENCH_BYTES / size;
+    if (rounds < BENCH_ROUNDS_MIN)
+    {
+        rounds = BENCH_ROUNDS_MIN;
+    }
+
+    /* warm up the cache */
+    sink += func(dst, src, size);
+
+    start = bench_clock();
+    for (i = 0; i < rounds; i++)
+    {
+        sink += func(dst, src, size);
+    }
+    cycles = bench_clock() - start;
+    (void)sink;
+
+    if (cycles == 0)
+    {
+        cycles = 1;
+    }
+
+    return (rt_uint32_t)((rt_uint64_t)size * rounds * bench_freq / cycles / (1024 * 1024));
+}
+
+static int string_bench(int argc, char **argv)
+{
+    int i;
+    rt_size_t size, offset = 0;
+    rt_uint8_t *dst, *src;
+    rt_uint32_t c_speed, speed;
+
+    if (argc > 1)
+    {
+        offset = atoi(argv[1]) & 63;
+    }
+
+    sysreg_read(cntfrq_el0, bench_freq);
+
+    dst = rt_malloc_align(BENCH_SIZE_MAX + 64, 64);
+    src = rt_malloc_align(BENCH_SIZE_MAX + 64, 64);
+    if (dst == RT_NULL || src == RT_NULL)
+    {
+        rt_free_align(dst);
+        rt_free_align(src);
+        return -RT_ENOMEM;
+    }
+
+    rt_kprintf("offset: src %d dst %d, MiB/s of C / arch (speedup x100)\n", offset, offset / 2);
+    rt_kprintf("%-8s", "size");
+    for (i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+    {
+        rt_kprintf(" %22s", bench_cases[i].name);
+    }
+    rt_kprintf("\n");
+
+    for (size = BENCH_SIZE_MIN; size <= BENCH_SIZE_MAX; size <<= 1)
+    {
+        rt_kprintf("%-8d", size);
+
+        for (i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+        {
+            /* the same bytes make memcmp compare the whole size */
+            rt_memset(src, 'a', BENCH_SIZE_MAX + 64);
+            rt_memset(dst, 'a', BENCH_SIZE_MAX + 64);
+
+            if (bench_cases[i].string)
+            {
+                src[offset + size - 1] = '\0';
+            }
+
+            c_speed = bench_run(bench_cases[i].c_func, dst + offset / 2, src + offset, size);
+            speed = bench_run(bench_cases[i].func, dst + offset / 2, src + offset, size);
+
+            rt_kprintf(" %7d / %7d (%4d)", c_speed, speed, c_speed ? speed * 100 / c_speed : 0);
+        }
+        rt_kprintf("\n");
+    }
+
+    rt_free_align(dst);
+    rt_free_align(src);
+
+    return 0;
+}
+MSH_CMD_EXPORT(string_bench, memory and string routines benchmark);
+
+#endif /* defined(ARCH_ARMV8) && defined(ARCH_CPU_64BIT) && defined(RT_USING_FINSH) */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The round-trip latency benchmark of the channel IPC: a client thread calls
+ * a server thread through a channel with rt_channel_send_recv(), the server
+ * replies with rt_channel_reply(). The syscalls of the lwp channel are thin
+ * wrappers of the same path. It runs with both threads on one cpu, and on
+ * two cpus if SMP is enabled.
+ *
+ * msh> channel_bench [rounds]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include <fcntl.h>
+
+#if defined(RT_USING_LWP) && defined(RT_USING_FINSH)
+#include <lwp_ipc.h>
+
+#define BENCH_CHANNEL_NAME  "ch_bench"
+#define BENCH_PRIORITY      (RT_THREAD_PRIORITY_MAX / 2)
+#define BENCH_STACK_SIZE    4096
+
+static struct rt_semaphore bench_done;
+static rt_uint32_t bench_rounds;
+static rt_tick_t bench_ticks;
+static rt_err_t bench_err;
+
+static void bench_server(void *param)
+{
+    int fd;
+    struct rt_channel_msg msg;
+
+    fd = rt_channel_open(BENCH_CHANNEL_NAME, 0);
+    if (fd < 0)
+    {
+        bench_err = -RT_ERROR;
+        rt_sem_release(&bench_done);
+        return;
+    }
+    rt_sem_release(&bench_done);
+
+    while (rt_channel_recv(fd, &msg) == RT_EOK)
+    {
+        /* the last message stops the server */
+        if (msg.u.d == RT_NULL)
+        {
+            break;
+        }
+        msg.u.d = (void *)((rt_ubase_t)msg.u.d + 1);
+        rt_channel_reply(fd, &msg);
+    }
+
+    rt_channel_close(fd);
+    rt_sem_release(&bench_done);
+}
+
+static void bench_client(void *param)
+{
+    int fd = (int)(rt_ubase_t)param;
+    rt_uint32_t i;
+    rt_tick_t start;
+    struct rt_channel_msg msg, msg_ret;
+
+    msg.type = RT_CHANNEL_RAW;
+    start = rt_tick_get();
+
+    for (i = 1; i <= bench_rounds; i++)
+    {
+        msg.u.d = (void *)(rt_ubase_t)i;
+        if (rt_channel_send_recv(fd, &msg, &msg_ret) != RT_EOK ||
+            (rt_ubase_t)msg_ret.u.d != i + 1)
+        {
+            bench_err = -RT_ERROR;
+            break;
+        }
+    }
+
+    bench_ticks = rt_tick_get() - start;
+
+    msg.u.d = RT_NULL;
+    rt_channel_send(fd, &msg);
+
+    rt_sem_release(&bench_done);
+}
+
+static void bench_run(const char *mode, int client_cpu, int server_cpu)
+{
+    int fd;
+    rt_thread_t server, client;
+    rt_uint64_t ns = 0;
+
+    bench_err = RT_EOK;
+    bench_ticks = 0;
+
+    fd = rt_channel_open(BENCH_CHANNEL_NAME, O_CREAT);
+    if (fd < 0)
+    {
+        rt_kprintf("%-10s failed to open the channel\n", mode);
+        return;
+    }
+
+    server = rt_thread_create("ch_srv", bench_server, RT_NULL, BENCH_STACK_SIZE, BENCH_PRIORITY, 10);
+    client = rt_thread_create("ch_cli", bench_client, (void *)(rt_ubase_t)fd, BENCH_STACK_SIZE, BENCH_PRIORITY, 10);
+    if (server == RT_NULL || client == RT_NULL)
+    {
+        if (server)
+        {
+            rt_thread_delete(server);
+        }
+        if (client)
+        {
+            rt_thread_delete(client);
+        }
+        rt_channel_close(fd);
+        rt_kprintf("%-10s failed to create threads\n", mode);
+        return;
+    }
+
+#ifdef RT_USING_SMP
+    rt_thread_control(server, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)server_cpu);
+    rt_thread_control(client, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)client_cpu);
+#endif /* RT_USING_SMP */
+
+    /* the server is ready */
+    rt_thread_startup(server);
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+    if (bench_err != RT_EOK)
+    {
+        rt_thread_delete(client);
+        rt_channel_close(fd);
+        rt_kprintf("%-10s failed to open the channel\n", mode);
+        return;
+    }
+
+    rt_thread_startup(client);
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+
+    rt_channel_close(fd);
+
+    if (bench_ticks)
+    {
+        ns = (rt_uint64_t)bench_ticks * (1000000000 / RT_TICK_PER_SECOND) / bench_rounds;
+    }
+
+    rt_kprintf("%-10s %9d %9d %12d %12d%s\n", mode, bench_rounds,
+            bench_ticks * 1000 / RT_TICK_PER_SECOND, (rt_uint32_t)ns,
+            bench_ticks ? (rt_uint32_t)((rt_uint64_t)bench_rounds * RT_TICK_PER_SECOND / bench_ticks) : 0,
+            bench_err != RT_EOK ? " (error)" : "");
+}
+
+static int channel_bench(int argc, char **argv)
+{
+    bench_rounds = 100000;
+
+    if (argc > 1)
+    {
+        bench_rounds = atoi(argv[1]);
+    }
+    if (bench_rounds == 0)
+    {
+        rt_kprintf("Usage: channel_bench [rounds]\n");
+        return -RT_EINVAL;
+    }
+
+    rt_sem_init(&bench_done, "ch_bench", 0, RT_IPC_FLAG_FIFO);
+
+    rt_kprintf("mode          rounds  time(ms)      ns/trip      trips/s\n");
+    rt_kprintf("---------- --------- --------- ------------ ------------\n");
+
+    bench_run("same-cpu", 0, 0);
+#ifdef RT_USING_SMP
+    bench_run("cross-cpu", 0, 1);
+#endif /* RT_USING_SMP */
+
+    rt_sem_detach(&bench_done);
+
+    return 0;
+}
+MSH_CMD_EXPORT(channel_bench, channel IPC round-trip latency benchmark);
+
+#endif /* defined(RT_USING_LWP) && defined(RT_USING_FINSH) */
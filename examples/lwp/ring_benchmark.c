@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The bulk IPC throughput benchmark: a producer thread streams frames to a
+ * consumer thread through
+ *
+ *   channel: rt_channel_send() with a buffer, the frame is copied to a buffer
+ *            allocated for each message, the consumer frees it.
+ *   ring:    the frame is filled and read in place in a ring channel slot.
+ *
+ * msh> ring_bench [frame size] [frames]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include <fcntl.h>
+
+#if defined(RT_USING_LWP) && defined(ARCH_MM_MMU) && defined(RT_USING_FINSH)
+#include <lwp_ipc.h>
+#include <lwp_ring.h>
+
+#define BENCH_RING_NAME     "ring_bench"
+#define BENCH_RING_SLOTS    64
+#define BENCH_PRIORITY      (RT_THREAD_PRIORITY_MAX / 2)
+#define BENCH_STACK_SIZE    4096
+
+static struct rt_semaphore bench_done;
+static rt_uint32_t bench_frame_size;
+static rt_uint32_t bench_frames;
+static rt_uint32_t bench_received;
+static rt_uint8_t *bench_frame;
+static struct lwp_ring bench_ring;
+static int bench_fd;
+
+/* the consumer reads the frame */
+static rt_bool_t bench_frame_check(const rt_uint8_t *data, rt_uint32_t length, rt_uint32_t seq)
+{
+    return length == bench_frame_size && data[0] == (rt_uint8_t)seq && data[length - 1] == (rt_uint8_t)seq;
+}
+
+static void channel_producer(void *param)
+{
+    rt_uint32_t i;
+    rt_uint8_t *buf;
+    struct rt_channel_msg msg;
+
+    for (i = 0; i < bench_frames; i++)
+    {
+        rt_memset(bench_frame, (rt_uint8_t)i, bench_frame_size);
+
+        buf = rt_malloc(bench_frame_size);
+        if (buf == RT_NULL)
+        {
+            break;
+        }
+        rt_memcpy(buf, bench_frame, bench_frame_size);
+
+        msg.type = RT_CHANNEL_BUFFER;
+        msg.u.b.buf = buf;
+        msg.u.b.length = bench_frame_size;
+        while (rt_channel_send(bench_fd, &msg) == -RT_ENOMEM)
+        {
+            rt_thread_yield();
+        }
+    }
+
+    /* the last message stops the consumer */
+    msg.type = RT_CHANNEL_RAW;
+    msg.u.d = RT_NULL;
+    rt_channel_send(bench_fd, &msg);
+
+    rt_sem_release(&bench_done);
+}
+
+static void channel_consumer(void *param)
+{
+    struct rt_channel_msg msg;
+
+    while (rt_channel_recv(bench_fd, &msg) == RT_EOK && msg.type == RT_CHANNEL_BUFFER)
+    {
+        if (bench_frame_check(msg.u.b.buf, msg.u.b.length, bench_received))
+        {
+            bench_received++;
+        }
+        rt_free(msg.u.b.buf);
+    }
+
+    rt_sem_release(&bench_done);
+}
+
+static void ring_producer(void *param)
+{
+    rt_uint32_t i;
+    void *slot;
+
+    for (i = 0; i < bench_frames; i++)
+    {
+        while ((slot = lwp_ring_produce_prepare(&bench_ring)) == RT_NULL)
+        {
+            lwp_ring_produce_wait(&bench_ring, RT_WAITING_FOREVER);
+        }
+        rt_memset(slot, (rt_uint8_t)i, bench_frame_size);
+        lwp_ring_produce_commit(&bench_ring, bench_frame_size);
+    }
+
+    /* the empty frame stops the consumer */
+    while ((slot = lwp_ring_produce_prepare(&bench_ring)) == RT_NULL)
+    {
+        lwp_ring_produce_wait(&bench_ring, RT_WAITING_FOREVER);
+    }
+    lwp_ring_produce_commit(&bench_ring, 0);
+
+    rt_sem_release(&bench_done);
+}
+
+static void ring_consumer(void *param)
+{
+    void *slot;
+    rt_uint32_t length;
+
+    for (;;)
+    {
+        while ((slot = lwp_ring_consume_peek(&bench_ring, &length)) == RT_NULL)
+        {
+            lwp_ring_consume_wait(&bench_ring, RT_WAITING_FOREVER);
+        }
+        if (length == 0)
+        {
+            lwp_ring_consume_release(&bench_ring);
+            break;
+        }
+        if (bench_frame_check(slot, length, bench_received))
+        {
+            bench_received++;
+        }
+        lwp_ring_consume_release(&bench_ring);
+    }
+
+    rt_sem_release(&bench_done);
+}
+
+static void bench_run(const char *mode, void (*producer)(void *), void (*consumer)(void *))
+{
+    rt_tick_t start, ticks;
+    rt_thread_t thread;
+    rt_uint32_t ms;
+
+    bench_received = 0;
+    start = rt_tick_get();
+
+    thread = rt_thread_create("bench_c", consumer, RT_NULL, BENCH_STACK_SIZE, BENCH_PRIORITY, 10);
+    if (thread == RT_NULL)
+    {
+        return;
+    }
+    rt_thread_startup(thread);
+
+    thread = rt_thread_create("bench_p", producer, RT_NULL, BENCH_STACK_SIZE, BENCH_PRIORITY, 10);
+    if (thread == RT_NULL)
+    {
+        /* nothing will stop the consumer */
+        return;
+    }
+    rt_thread_startup(thread);
+
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+    rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+
+    ticks = rt_tick_get() - start;
+    ms = ticks * 1000 / RT_TICK_PER_SECOND;
+
+    rt_kprintf("%-10s %9d %9d %9d %12d\n", mode, bench_received, bench_frames - bench_received, ms,
+            ms ? (rt_uint32_t)((rt_uint64_t)bench_received * bench_frame_size / 1024 * 1000 / ms) : 0);
+}
+
+static int ring_bench(int argc, char **argv)
+{
+    bench_frame_size = 4096;
+    bench_frames = 10000;
+
+    if (argc > 1)
+    {
+        bench_frame_size = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        bench_frames = atoi(argv[2]);
+    }
+    if (bench_frame_size == 0 || bench_frames == 0)
+    {
+        rt_kprintf("Usage: ring_bench [frame size] [frames]\n");
+        return -RT_EINVAL;
+    }
+
+    bench_frame = rt_malloc(bench_frame_size);
+    if (bench_frame == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+    rt_sem_init(&bench_done, "ring_b", 0, RT_IPC_FLAG_FIFO);
+
+    rt_kprintf("%d frames of %d bytes\n", bench_frames, bench_frame_size);
+    rt_kprintf("mode          frames   dropped  time(ms)       KiB/s\n");
+    rt_kprintf("---------- --------- --------- --------- ------------\n");
+
+    bench_fd = rt_channel_open(BENCH_RING_NAME, O_CREAT);
+    if (bench_fd >= 0)
+    {
+        bench_run("channel", channel_producer, channel_consumer);
+        rt_channel_close(bench_fd);
+    }
+
+    if (lwp_ring_open(&bench_ring, BENCH_RING_NAME,
+            sizeof(struct lwp_ring_hdr) + BENCH_RING_SLOTS * RT_ALIGN(sizeof(struct lwp_ring_slot) + bench_frame_size, LWP_RING_CACHE_LINE),
+            bench_frame_size, O_CREAT) == RT_EOK)
+    {
+        bench_run("ring", ring_producer, ring_consumer);
+        lwp_ring_close(&bench_ring);
+        lwp_ring_unlink(BENCH_RING_NAME);
+    }
+    else
+    {
+        rt_kprintf("ring       failed to open the ring\n");
+    }
+
+    rt_sem_detach(&bench_done);
+    rt_free(bench_frame);
+
+    return 0;
+}
+MSH_CMD_EXPORT(ring_bench, ring channel and channel throughput benchmark);
+
+#endif /* defined(RT_USING_LWP) && defined(ARCH_MM_MMU) && defined(RT_USING_FINSH) */
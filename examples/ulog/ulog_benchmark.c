@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The logging throughput benchmark: N producer threads output logs at the
+ * same time, the logs are counted by a null backend. The console backend is
+ * silent while running.
+ *
+ * msh> ulog_bench [producers] [logs of each producer]
+ */
+
+#include <rtthread.h>
+#include <rtatomic.h>
+#include <stdlib.h>
+
+#define LOG_TAG              "bench"
+#define LOG_LVL              LOG_LVL_DBG
+#include <ulog.h>
+
+#if defined(RT_USING_ULOG) && defined(RT_USING_FINSH)
+
+#define BENCH_PRODUCERS_MAX  16
+
+static struct ulog_backend bench_backend;
+static rt_atomic_t bench_lines;
+static struct rt_semaphore bench_done;
+static rt_uint32_t bench_count;
+
+static void bench_backend_output(struct ulog_backend *backend, rt_uint32_t level, const char *tag, rt_bool_t is_raw,
+        const char *log, rt_size_t len)
+{
+    rt_atomic_add(&bench_lines, 1);
+}
+
+static void bench_producer(void *param)
+{
+    rt_uint32_t i;
+    rt_ubase_t id = (rt_ubase_t)param;
+
+    for (i = 0; i < bench_count; i++)
+    {
+        LOG_I("producer %d log %d: %s 0x%08x", id, i, "payload", i * 31);
+    }
+
+    rt_sem_release(&bench_done);
+}
+
+static rt_tick_t bench_run(int producers)
+{
+    int i;
+    rt_tick_t start;
+    rt_thread_t thread;
+    char name[RT_NAME_MAX];
+
+    start = rt_tick_get();
+
+    for (i = 0; i < producers; i++)
+    {
+        rt_snprintf(name, sizeof(name), "ulog_b%d", i);
+        thread = rt_thread_create(name, bench_producer, (void *)(rt_ubase_t)i, 2048, RT_THREAD_PRIORITY_MAX / 2, 10);
+
+        if (thread == RT_NULL)
+        {
+            rt_sem_release(&bench_done);
+            continue;
+        }
+        rt_thread_startup(thread);
+    }
+
+    for (i = 0; i < producers; i++)
+    {
+        rt_sem_take(&bench_done, RT_WAITING_FOREVER);
+    }
+
+    return rt_tick_get() - start;
+}
+
+static void bench_report(const char *mode, int producers, rt_tick_t produce_ticks, rt_tick_t total_ticks)
+{
+    rt_uint32_t total = producers * bench_count;
+    rt_uint32_t produce_ms = produce_ticks * 1000 / RT_TICK_PER_SECOND;
+    rt_uint32_t total_ms = total_ticks * 1000 / RT_TICK_PER_SECOND;
+
+    rt_kprintf("%-10s %9d %9d %9d %12d %12d\n", mode, rt_atomic_load(&bench_lines), total - rt_atomic_load(&bench_lines),
+            produce_ms, produce_ms ? (rt_uint32_t)((rt_uint64_t)total * 1000 / produce_ms) : 0,
+            total_ms ? (rt_uint32_t)((rt_uint64_t)rt_atomic_load(&bench_lines) * 1000 / total_ms) : 0);
+}
+
+static void bench_mode(const char *mode, int producers)
+{
+    rt_tick_t start, produce_ticks;
+
+    rt_atomic_store(&bench_lines, 0);
+
+    start = rt_tick_get();
+    produce_ticks = bench_run(producers);
+    ulog_flush();
+
+    bench_report(mode, producers, produce_ticks, rt_tick_get() - start);
+}
+
+static int ulog_bench(int argc, char **argv)
+{
+    int producers = RT_CPUS_NR;
+    rt_uint32_t console_level = 0;
+    ulog_backend_t console;
+
+    bench_count = 1000;
+
+    if (argc > 1)
+    {
+        producers = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        bench_count = atoi(argv[2]);
+    }
+    if (producers <= 0 || producers > BENCH_PRODUCERS_MAX || bench_count == 0)
+    {
+        rt_kprintf("Usage: ulog_bench [producers (1-%d)] [logs of each producer]\n", BENCH_PRODUCERS_MAX);
+        return -RT_EINVAL;
+    }
+
+    /* silent the console backend */
+    console = ulog_backend_find("console");
+    if (console)
+    {
+        console_level = console->out_level;
+        console->out_level = LOG_FILTER_LVL_SILENT;
+    }
+
+    rt_sem_init(&bench_done, "ulog_b", 0, RT_IPC_FLAG_FIFO);
+    bench_backend.output = bench_backend_output;
+    ulog_backend_register(&bench_backend, "bench", RT_FALSE);
+
+    rt_kprintf("%d producers, %d logs of each producer\n", producers, bench_count);
+    rt_kprintf("mode           lines   dropped  prod(ms)    logs/s(p)  logs/s(all)\n");
+    rt_kprintf("---------- --------- --------- --------- ------------ ------------\n");
+
+#ifdef ULOG_USING_DEFERRED_FORMAT
+    ulog_deferred_enabled(RT_FALSE);
+    bench_mode("formatted", producers);
+    ulog_deferred_enabled(RT_TRUE);
+    bench_mode("deferred", producers);
+#else
+    bench_mode("formatted", producers);
+#endif
+
+    ulog_backend_unregister(&bench_backend);
+    rt_sem_detach(&bench_done);
+
+    if (console)
+    {
+        console->out_level = console_level;
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(ulog_bench, ulog throughput benchmark with concurrent producers);
+
+#endif /* defined(RT_USING_ULOG) && defined(RT_USING_FINSH) */
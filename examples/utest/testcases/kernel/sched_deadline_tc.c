@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "utest.h"
+
+#ifdef RT_USING_SMP
+#define DL_CPUS_NR              RT_CPUS_NR
+#else
+#define DL_CPUS_NR              1
+#endif /* RT_USING_SMP */
+
+#define THREAD_STACKSIZE        2048
+#define THREAD_TIMESLICE        10
+#define HOG_PRIORITY            0
+
+#define DL_TEST_TICKS           (RT_TICK_PER_SECOND * 2)
+#define DL_PERIOD               (RT_TICK_PER_SECOND / 5)
+#define DL_RUNTIME              (DL_PERIOD / 5)
+#define DL_WORK                 (DL_PERIOD / 10)
+#define DL_WORKERS_NR           2
+
+struct dl_worker
+{
+    rt_thread_t thread;
+    rt_uint32_t jobs;
+    rt_uint32_t misses;
+};
+
+static struct rt_semaphore dl_done;
+static rt_tick_t dl_start;
+static struct dl_worker dl_workers[DL_WORKERS_NR];
+static rt_uint32_t dl_rogue_ticks;
+
+/* spin until the thread has run for ticks, the ticks it is preempted are not counted */
+static rt_uint32_t dl_burn(rt_tick_t ticks, rt_bool_t forever)
+{
+    rt_tick_t last = rt_tick_get(), now;
+    rt_uint32_t burned = 0;
+
+    while (burned < ticks || forever)
+    {
+        now = rt_tick_get();
+        if (now - dl_start >= DL_TEST_TICKS)
+        {
+            break;
+        }
+        if (now != last)
+        {
+            last = now;
+            burned++;
+        }
+    }
+
+    return burned;
+}
+
+static void dl_worker_entry(void *param)
+{
+    struct dl_worker *worker = (struct dl_worker *)param;
+    rt_tick_t release = rt_tick_get();
+    rt_tick_t deadline, late;
+
+    while (release - dl_start < DL_TEST_TICKS - DL_PERIOD)
+    {
+        /*
+         * the deadline assigned by the scheduler to the job, which is later
+         * than release + DL_PERIOD if the worker is woken up a tick late
+         */
+        deadline = worker->thread->dl.abs_deadline;
+        dl_burn(DL_WORK, RT_FALSE);
+
+        /* the job should be finished before the deadline, the tick it ends on is allowed */
+        late = rt_tick_get() - deadline;
+        if (late > 1 && late < RT_TICK_MAX / 2)
+        {
+            worker->misses++;
+        }
+        worker->jobs++;
+
+        rt_thread_delay_until(&release, DL_PERIOD);
+    }
+
+    rt_sem_release(&dl_done);
+}
+
+static void dl_rogue_entry(void *param)
+{
+    /* never finishes the job, runs only in its budget */
+    dl_rogue_ticks = dl_burn(0, RT_TRUE);
+
+    rt_sem_release(&dl_done);
+}
+
+static void dl_hog_entry(void *param)
+{
+    while (rt_tick_get() - dl_start < DL_TEST_TICKS)
+    {
+    }
+
+    rt_sem_release(&dl_done);
+}
+
+static rt_uint32_t dl_bandwidth(void)
+{
+    int cpu;
+    rt_uint32_t bw = 0;
+
+    for (cpu = 0; cpu < DL_CPUS_NR; cpu++)
+    {
+        bw += rt_sched_deadline_bandwidth(cpu);
+    }
+
+    return bw;
+}
+
+static void test_deadline_admission(void)
+{
+    rt_thread_t thread;
+    rt_uint32_t bw;
+
+    bw = dl_bandwidth();
+
+    thread = rt_thread_create("dl_adm", dl_hog_entry, RT_NULL, THREAD_STACKSIZE, 20, THREAD_TIMESLICE);
+    uassert_not_null(thread);
+
+    /* runtime <= deadline <= period */
+    uassert_int_equal(rt_thread_set_deadline(thread, 5, 4, 10), -RT_EINVAL);
+    uassert_int_equal(rt_thread_set_deadline(thread, 5, 10, 8), -RT_EINVAL);
+
+#if RT_SCHED_DEADLINE_BW_LIMIT < 100
+    /* the full bandwidth of a cpu exceeds the limit */
+    uassert_int_equal(rt_thread_set_deadline(thread, 10, 10, 10), -RT_EBUSY);
+#endif
+
+#ifdef RT_USING_SMP
+    uassert_int_equal(rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)RT_CPU_MASK), RT_EOK);
+#endif /* RT_USING_SMP */
+    uassert_int_equal(rt_thread_set_deadline(thread, 2, 10, 10), RT_EOK);
+    uassert_int_equal(thread->current_priority, RT_SCHED_DEADLINE_PRIORITY);
+    uassert_int_equal(thread->dl.runtime, 2);
+    uassert_int_equal(dl_bandwidth() - bw, (2 << RT_SCHED_DEADLINE_BW_SHIFT) / 10);
+
+    /* back to the fixed priority scheduling */
+    uassert_int_equal(rt_thread_set_deadline(thread, 0, 0, 0), RT_EOK);
+    uassert_int_equal(thread->current_priority, 20);
+#ifdef RT_USING_SMP
+    /* the affinity is not lost by running on the cpu reserved */
+    uassert_int_equal(thread->cpu_affinity, RT_CPU_MASK);
+#endif /* RT_USING_SMP */
+    uassert_int_equal(thread->dl.runtime, 0);
+    uassert_int_equal(dl_bandwidth(), bw);
+
+    rt_thread_delete(thread);
+}
+
+static void test_deadline_overload(void)
+{
+    int i;
+    rt_thread_t thread;
+    char name[RT_NAME_MAX];
+    int threads_nr = 0;
+
+    rt_memset(dl_workers, 0, sizeof(dl_workers));
+    dl_rogue_ticks = 0;
+    dl_start = rt_tick_get();
+
+    for (i = 0; i < DL_WORKERS_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "dl_w%d", i);
+        thread = rt_thread_create(name, dl_worker_entry, &dl_workers[i], THREAD_STACKSIZE, 20, THREAD_TIMESLICE);
+        uassert_not_null(thread);
+        uassert_int_equal(rt_thread_set_deadline(thread, DL_RUNTIME, DL_PERIOD, DL_PERIOD), RT_EOK);
+        dl_workers[i].thread = thread;
+    }
+
+    thread = rt_thread_create("dl_rogue", dl_rogue_entry, RT_NULL, THREAD_STACKSIZE, 20, THREAD_TIMESLICE);
+    uassert_not_null(thread);
+    uassert_int_equal(rt_thread_set_deadline(thread, DL_RUNTIME, DL_PERIOD, DL_PERIOD), RT_EOK);
+    rt_thread_startup(thread);
+    threads_nr++;
+
+    for (i = 0; i < DL_WORKERS_NR; i++)
+    {
+        rt_thread_startup(dl_workers[i].thread);
+        threads_nr++;
+    }
+
+    /* the normal threads on the level of the deadline class overload all the cpus */
+    for (i = 0; i < DL_CPUS_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "dl_hog%d", i);
+        thread = rt_thread_create(name, dl_hog_entry, RT_NULL, THREAD_STACKSIZE, HOG_PRIORITY, THREAD_TIMESLICE);
+        uassert_not_null(thread);
+        rt_thread_startup(thread);
+        threads_nr++;
+    }
+
+    for (i = 0; i < threads_nr; i++)
+    {
+        rt_sem_take(&dl_done, RT_WAITING_FOREVER);
+    }
+
+    for (i = 0; i < DL_WORKERS_NR; i++)
+    {
+        LOG_I("worker %d: %d jobs, %d deadline misses", i, dl_workers[i].jobs, dl_workers[i].misses);
+        uassert_true(dl_workers[i].jobs >= DL_TEST_TICKS / DL_PERIOD - 2);
+        uassert_int_equal(dl_workers[i].misses, 0);
+    }
+
+    /* the rogue thread is throttled to its budget, one more tick of each period is allowed for the tick accounting */
+    LOG_I("rogue: %d ticks in %d ticks", dl_rogue_ticks, DL_TEST_TICKS);
+    uassert_true(dl_rogue_ticks > 0);
+    uassert_true(dl_rogue_ticks <= (DL_TEST_TICKS / DL_PERIOD + 1) * (DL_RUNTIME + 1));
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&dl_done, "dl_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    /* the bandwidth is released as the deadline threads exit */
+    if (dl_bandwidth() != 0)
+    {
+        LOG_W("bandwidth of deadline threads is not released");
+    }
+
+    rt_sem_detach(&dl_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_deadline_admission);
+    UTEST_UNIT_RUN(test_deadline_overload);
+}
+UTEST_TC_EXPORT(testcase, "testcases.kernel.sched_deadline_tc", utest_tc_init, utest_tc_cleanup, 10);
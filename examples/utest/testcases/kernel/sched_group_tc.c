@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "utest.h"
+
+#define THREAD_STACKSIZE        2048
+#define THREAD_TIMESLICE        5
+#define HOG_PRIORITY            10
+#define HOG_CPU                 (RT_CPUS_NR - 1)
+
+#define SG_TEST_TICKS           (RT_TICK_PER_SECOND * 2)
+#define SG_PERIOD               (RT_TICK_PER_SECOND / 5)
+#define SG_QUOTA                (SG_PERIOD / 4)
+
+static struct rt_semaphore sg_done;
+static rt_tick_t sg_start;
+
+static void sg_hog_entry(void *param)
+{
+    while (rt_tick_get() - sg_start < SG_TEST_TICKS)
+    {
+    }
+
+    rt_sem_release(&sg_done);
+}
+
+/* start the hogs of a group, all on the same cpu */
+static int sg_hog_start(rt_sched_group_t group, int nr)
+{
+    int i;
+    rt_thread_t thread;
+    char name[RT_NAME_MAX];
+
+    for (i = 0; i < nr; i++)
+    {
+        rt_snprintf(name, sizeof(name), "%.*s%d", RT_NAME_MAX - 3, group->name, i);
+        thread = rt_thread_create(name, sg_hog_entry, RT_NULL, THREAD_STACKSIZE, HOG_PRIORITY, THREAD_TIMESLICE);
+        uassert_not_null(thread);
+        if (thread == RT_NULL)
+        {
+            return i;
+        }
+        rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)(1UL << HOG_CPU));
+        uassert_int_equal(rt_sched_group_attach(group, thread), RT_EOK);
+        rt_thread_startup(thread);
+    }
+
+    return nr;
+}
+
+/* the references of the exiting threads are released a bit later */
+static void sg_delete(rt_sched_group_t group)
+{
+    int retry;
+
+    for (retry = 0; retry < 100 && rt_sched_group_delete(group) == -RT_EBUSY; retry++)
+    {
+        rt_thread_mdelay(10);
+    }
+    uassert_true(retry < 100);
+}
+
+static void test_group_manage(void)
+{
+    rt_sched_group_t parent, child, kernel;
+    rt_thread_t thread;
+
+    kernel = rt_sched_group_find("kernel");
+    uassert_not_null(kernel);
+    uassert_int_equal(rt_sched_group_delete(kernel), -RT_EINVAL);
+    uassert_int_equal(rt_sched_group_set_bandwidth(kernel, 1, 10), -RT_EINVAL);
+
+    parent = rt_sched_group_create("sg_p", RT_NULL);
+    uassert_not_null(parent);
+    uassert_null(rt_sched_group_create("sg_p", RT_NULL));
+    uassert_true(rt_sched_group_find("sg_p") == parent);
+
+    child = rt_sched_group_create("sg_c", parent);
+    uassert_not_null(child);
+    uassert_int_equal(child->depth, parent->depth + 1);
+
+    uassert_int_equal(rt_sched_group_set_shares(child, 1), -RT_EINVAL);
+    uassert_int_equal(rt_sched_group_set_shares(child, 512), RT_EOK);
+    uassert_int_equal(child->shares, 512);
+
+    /* the groups in use can't be deleted */
+    thread = rt_thread_create("sg_t", sg_hog_entry, RT_NULL, THREAD_STACKSIZE, HOG_PRIORITY, THREAD_TIMESLICE);
+    uassert_not_null(thread);
+    uassert_int_equal(rt_sched_group_attach(child, thread), RT_EOK);
+    uassert_true(thread->sgroup == child);
+    uassert_int_equal(rt_sched_group_delete(parent), -RT_EBUSY);
+    uassert_int_equal(rt_sched_group_delete(child), -RT_EBUSY);
+
+    /* the reference is released by the thread */
+    rt_thread_delete(thread);
+    uassert_int_equal(rt_sched_group_delete(child), RT_EOK);
+    uassert_int_equal(rt_sched_group_delete_by_name("sg_p"), RT_EOK);
+    uassert_null(rt_sched_group_find("sg_p"));
+    uassert_int_equal(rt_sched_group_delete_by_name("sg_p"), -RT_ENOENT);
+}
+
+static void test_group_shares(void)
+{
+    int i, threads_nr = 0;
+    rt_sched_group_t group_a, group_b;
+    rt_uint64_t usage_a, usage_b;
+
+    /* one thread in a with double shares, two threads in b */
+    group_a = rt_sched_group_create("sg_a", RT_NULL);
+    group_b = rt_sched_group_create("sg_b", RT_NULL);
+    uassert_not_null(group_a);
+    uassert_not_null(group_b);
+    uassert_int_equal(rt_sched_group_set_shares(group_a, RT_SCHED_GROUP_SHARES_DEFAULT * 2), RT_EOK);
+
+    usage_a = group_a->usage;
+    usage_b = group_b->usage;
+    sg_start = rt_tick_get();
+    threads_nr += sg_hog_start(group_a, 1);
+    threads_nr += sg_hog_start(group_b, 2);
+
+    for (i = 0; i < threads_nr; i++)
+    {
+        rt_sem_take(&sg_done, RT_WAITING_FOREVER);
+    }
+
+    usage_a = group_a->usage - usage_a;
+    usage_b = group_b->usage - usage_b;
+    LOG_I("group a: %d ticks, group b: %d ticks", (int)usage_a, (int)usage_b);
+
+    /* a gets about 2/3 of the cpu, no matter how many threads b has */
+    uassert_true(usage_a + usage_b >= SG_TEST_TICKS * 9 / 10);
+    uassert_true(usage_a * 2 >= usage_b * 3);
+    uassert_true(usage_a * 2 <= usage_b * 5);
+
+    sg_delete(group_a);
+    sg_delete(group_b);
+}
+
+static void test_group_quota(void)
+{
+    rt_sched_group_t group;
+    rt_uint64_t usage;
+    rt_uint32_t periods;
+
+    group = rt_sched_group_create("sg_q", RT_NULL);
+    uassert_not_null(group);
+    uassert_int_equal(rt_sched_group_set_bandwidth(group, SG_QUOTA, SG_PERIOD), RT_EOK);
+
+    usage = group->usage;
+    periods = group->nr_throttled;
+    sg_start = rt_tick_get();
+    if (sg_hog_start(group, 1) == 1)
+    {
+        rt_sem_take(&sg_done, RT_WAITING_FOREVER);
+    }
+
+    usage = group->usage - usage;
+    periods = group->nr_throttled - periods;
+    LOG_I("group q: %d ticks in %d ticks, throttled %d times", (int)usage, SG_TEST_TICKS, periods);
+
+    /* the quota is used up in each period, one more period is started when the thread exits */
+    uassert_true(periods >= SG_TEST_TICKS / SG_PERIOD - 1);
+    uassert_true(usage >= (SG_TEST_TICKS / SG_PERIOD - 1) * SG_QUOTA);
+    uassert_true(usage <= (SG_TEST_TICKS / SG_PERIOD + 1) * (SG_QUOTA + 1));
+
+    sg_delete(group);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&sg_done, "sg_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&sg_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_group_manage);
+    UTEST_UNIT_RUN(test_group_shares);
+    UTEST_UNIT_RUN(test_group_quota);
+}
+UTEST_TC_EXPORT(testcase, "testcases.kernel.sched_group_tc", utest_tc_init, utest_tc_cleanup, 10);
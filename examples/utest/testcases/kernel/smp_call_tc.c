@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtatomic.h>
+#include "utest.h"
+
+#define THREAD_STACKSIZE        2048
+#define THREAD_PRIORITY         10
+#define THREAD_TIMESLICE        10
+#define CROSS_CALLS             1000
+
+static struct rt_semaphore call_done;
+static rt_atomic_t call_hits[RT_CPUS_NR];
+static rt_atomic_t call_count;
+static int call_failed;
+
+static rt_ubase_t online_mask(void)
+{
+    int cpu;
+    rt_ubase_t mask = 0;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (rt_cpu_index(cpu)->current_thread != RT_NULL)
+        {
+            mask |= 1ul << cpu;
+        }
+    }
+
+    return mask;
+}
+
+static void record_cpu(void *data)
+{
+    *(int *)data = rt_hw_cpu_id();
+}
+
+static void count_cpu(void *data)
+{
+    rt_atomic_add(&call_hits[rt_hw_cpu_id()], 1);
+}
+
+static void count_call(void *data)
+{
+    rt_atomic_add(&call_count, 1);
+}
+
+static void reset_hits(void)
+{
+    int cpu;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        rt_atomic_store(&call_hits[cpu], 0);
+    }
+}
+
+static void test_call_cpu(void)
+{
+    int cpu, ran_on;
+    rt_ubase_t online = online_mask();
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (!(online & (1ul << cpu)))
+        {
+            continue;
+        }
+        ran_on = -1;
+        uassert_int_equal(rt_smp_call_cpu(cpu, record_cpu, &ran_on), RT_EOK);
+        uassert_int_equal(ran_on, cpu);
+    }
+
+    uassert_int_equal(rt_smp_call_cpu(RT_CPUS_NR, record_cpu, &ran_on), -RT_EINVAL);
+}
+
+static void test_call_mask(void)
+{
+    int cpu;
+    rt_ubase_t online = online_mask();
+
+    reset_hits();
+    uassert_int_equal(rt_smp_call_cpu_mask(RT_CPU_MASK, count_cpu, RT_NULL), RT_EOK);
+
+    /* each online cpu runs it exactly once */
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        uassert_int_equal(rt_atomic_load(&call_hits[cpu]), (online & (1ul << cpu)) ? 1 : 0);
+    }
+}
+
+static void test_call_async(void)
+{
+    int i, cpu, others_nr = 0;
+    rt_err_t err;
+    rt_base_t level;
+    rt_ubase_t others;
+    struct rt_smp_call_req req;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (online_mask() & (1ul << cpu))
+        {
+            others_nr++;
+        }
+    }
+    others_nr--;
+
+    rt_smp_call_req_init(&req, count_call, RT_NULL);
+    rt_atomic_store(&call_count, 0);
+
+    for (i = 0; i < CROSS_CALLS; i++)
+    {
+        /* the local cpu is not in the mask, so the request is pending */
+        level = rt_hw_local_irq_disable();
+        others = online_mask() & ~(1ul << rt_hw_cpu_id());
+        err = rt_smp_call_request(&req, others);
+        rt_hw_local_irq_enable(level);
+        uassert_int_equal(err, RT_EOK);
+
+        rt_smp_call_req_wait(&req);
+        uassert_true(rt_smp_call_req_done(&req));
+    }
+
+    uassert_int_equal(rt_atomic_load(&call_count), CROSS_CALLS * others_nr);
+}
+
+static void cross_entry(void *parameter)
+{
+    int i, target, ran_on;
+    rt_base_t level;
+
+    target = (int)(rt_ubase_t)parameter;
+
+    /* two cpus call each other with the interrupt disabled */
+    for (i = 0; i < CROSS_CALLS; i++)
+    {
+        level = rt_hw_local_irq_disable();
+        ran_on = -1;
+        if (rt_smp_call_cpu(target, record_cpu, &ran_on) != RT_EOK || ran_on != target)
+        {
+            call_failed++;
+        }
+        rt_hw_local_irq_enable(level);
+    }
+
+    rt_sem_release(&call_done);
+}
+
+static void test_call_irq_disabled(void)
+{
+    int i;
+    rt_thread_t tids[2];
+    char name[RT_NAME_MAX];
+
+    if ((online_mask() & 0x3) != 0x3)
+    {
+        rt_kprintf("smp_call: cpu 1 is offline, skipped\n");
+        return;
+    }
+
+    call_failed = 0;
+    for (i = 0; i < 2; i++)
+    {
+        rt_snprintf(name, sizeof(name), "x_call%d", i);
+        tids[i] = rt_thread_create(name, cross_entry, (void *)(rt_ubase_t)(1 - i),
+                                   THREAD_STACKSIZE, THREAD_PRIORITY, THREAD_TIMESLICE);
+        uassert_not_null(tids[i]);
+        if (tids[i] == RT_NULL)
+        {
+            return;
+        }
+        rt_thread_control(tids[i], RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)i);
+        rt_thread_startup(tids[i]);
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        uassert_int_equal(rt_sem_take(&call_done, RT_TICK_PER_SECOND * 10), RT_EOK);
+    }
+    uassert_int_equal(call_failed, 0);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&call_done, "call_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&call_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_call_cpu);
+    UTEST_UNIT_RUN(test_call_mask);
+    UTEST_UNIT_RUN(test_call_async);
+    UTEST_UNIT_RUN(test_call_irq_disabled);
+}
+UTEST_TC_EXPORT(testcase, "testcases.kernel.smp_call_tc", utest_tc_init, utest_tc_cleanup, 30);
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "utest.h"
+
+#define WORKS_NR                8
+
+static struct rt_semaphore wq_block;
+static struct rt_semaphore wq_done;
+static struct rt_work wq_works[WORKS_NR];
+static volatile int wq_order[WORKS_NR];
+static volatile int wq_seq;
+static volatile int wq_running;
+static volatile int wq_running_max;
+
+static void ordered_work(struct rt_work *work, void *work_data)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    wq_running++;
+    if (wq_running > wq_running_max)
+    {
+        wq_running_max = wq_running;
+    }
+    wq_order[wq_seq++] = (int)(rt_ubase_t)work_data;
+    rt_hw_interrupt_enable(level);
+
+    rt_thread_delay(1);
+
+    level = rt_hw_interrupt_disable();
+    wq_running--;
+    rt_hw_interrupt_enable(level);
+
+    rt_sem_release(&wq_done);
+}
+
+static void blocking_work(struct rt_work *work, void *work_data)
+{
+    rt_sem_take(&wq_block, RT_WAITING_FOREVER);
+    rt_sem_release(&wq_done);
+}
+
+static void quick_work(struct rt_work *work, void *work_data)
+{
+    rt_sem_release(&wq_done);
+}
+
+static void test_workqueue_ordered(void)
+{
+    int i;
+    struct rt_workqueue *queue;
+
+    queue = rt_workqueue_alloc(0, 0);
+    uassert_not_null(queue);
+
+    wq_seq = 0;
+    wq_running = 0;
+    wq_running_max = 0;
+    for (i = 0; i < WORKS_NR; i++)
+    {
+        rt_work_init(&wq_works[i], ordered_work, (void *)(rt_ubase_t)i);
+        uassert_int_equal(rt_workqueue_dowork(queue, &wq_works[i]), RT_EOK);
+    }
+
+    for (i = 0; i < WORKS_NR; i++)
+    {
+        uassert_int_equal(rt_sem_take(&wq_done, RT_TICK_PER_SECOND), RT_EOK);
+    }
+
+    /* one by one in the submitting order */
+    uassert_int_equal(wq_running_max, 1);
+    for (i = 0; i < WORKS_NR; i++)
+    {
+        uassert_int_equal(wq_order[i], i);
+    }
+
+    uassert_int_equal(rt_workqueue_destroy(queue), RT_EOK);
+}
+
+static void test_workqueue_blocked(void)
+{
+    struct rt_workqueue *queue;
+
+    queue = rt_workqueue_alloc(RT_WORKQUEUE_UNORDERED, 0);
+    uassert_not_null(queue);
+
+    rt_work_init(&wq_works[0], blocking_work, RT_NULL);
+    rt_work_init(&wq_works[1], quick_work, RT_NULL);
+
+    /* the blocked work does not hold the next one on the same cpu */
+    rt_enter_critical();
+    rt_workqueue_dowork(queue, &wq_works[0]);
+    rt_workqueue_dowork(queue, &wq_works[1]);
+    rt_exit_critical();
+    uassert_int_equal(rt_sem_take(&wq_done, RT_TICK_PER_SECOND), RT_EOK);
+
+    /* the running work is waited for */
+    uassert_int_equal(rt_workqueue_cancel_work(queue, &wq_works[0]), -RT_EBUSY);
+    rt_sem_release(&wq_block);
+    uassert_int_equal(rt_workqueue_cancel_work_sync(queue, &wq_works[0]), RT_EOK);
+    uassert_int_equal(rt_sem_take(&wq_done, 0), RT_EOK);
+
+    uassert_int_equal(rt_workqueue_destroy(queue), RT_EOK);
+}
+
+static void test_workqueue_cancel(void)
+{
+    struct rt_workqueue *queue;
+
+    queue = rt_workqueue_alloc(RT_WORKQUEUE_UNBOUND, 0);
+    uassert_not_null(queue);
+
+    rt_work_init(&wq_works[0], blocking_work, RT_NULL);
+    rt_work_init(&wq_works[1], quick_work, RT_NULL);
+    rt_work_init(&wq_works[2], quick_work, RT_NULL);
+
+    /* the ordered queue keeps the works behind the blocked one */
+    rt_workqueue_dowork(queue, &wq_works[0]);
+    rt_workqueue_dowork(queue, &wq_works[1]);
+    rt_workqueue_submit_work(queue, &wq_works[2], RT_TICK_PER_SECOND);
+    rt_thread_delay(RT_TICK_PER_SECOND / 10);
+
+    uassert_int_equal(rt_workqueue_cancel_work(queue, &wq_works[1]), RT_EOK);
+    uassert_int_equal(rt_workqueue_cancel_work(queue, &wq_works[2]), RT_EOK);
+    uassert_false(wq_works[1].flags & RT_WORK_STATE_PENDING);
+
+    rt_sem_release(&wq_block);
+    uassert_int_equal(rt_sem_take(&wq_done, RT_TICK_PER_SECOND), RT_EOK);
+    uassert_int_equal(rt_workqueue_destroy(queue), RT_EOK);
+
+    /* the cancelled works never run */
+    uassert_int_equal(rt_sem_take(&wq_done, RT_TICK_PER_SECOND * 2), -RT_ETIMEOUT);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&wq_block, "wq_block", 0, RT_IPC_FLAG_PRIO);
+    rt_sem_init(&wq_done, "wq_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&wq_block);
+    rt_sem_detach(&wq_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_workqueue_ordered);
+    UTEST_UNIT_RUN(test_workqueue_blocked);
+    UTEST_UNIT_RUN(test_workqueue_cancel);
+}
+UTEST_TC_EXPORT(testcase, "testcases.kernel.workqueue_pool_tc", utest_tc_init, utest_tc_cleanup, 10);
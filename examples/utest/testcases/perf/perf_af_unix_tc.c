@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <sal_socket.h>
+#include "perf_common.h"
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_WARMUP             (PERF_ITERATIONS / 10)
+#define PERF_MSG_SIZE           64
+#define PERF_BULK_SIZE          4096
+
+static struct rt_semaphore perf_done;
+static int perf_sockets[2];
+static rt_size_t perf_size;
+static int perf_failed;
+
+/* receive the whole message of the stream */
+static int perf_recv_all(int s, char *buf, rt_size_t len)
+{
+    int ret;
+    rt_size_t received = 0;
+
+    while (received < len)
+    {
+        ret = sal_recvfrom(s, buf + received, len - received, 0, RT_NULL, RT_NULL);
+        if (ret <= 0)
+        {
+            return -1;
+        }
+        received += ret;
+    }
+
+    return received;
+}
+
+/* echo the messages until the peer is closed */
+static void echo_entry(void *parameter)
+{
+    int ret;
+    char buf[PERF_MSG_SIZE];
+    int s = perf_sockets[1];
+
+    while ((ret = sal_recvfrom(s, buf, sizeof(buf), 0, RT_NULL, RT_NULL)) > 0)
+    {
+        if (sal_sendto(s, buf, ret, 0, RT_NULL, 0) != ret)
+        {
+            perf_failed++;
+            break;
+        }
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void perf_pingpong(const char *name, int type)
+{
+    int i;
+    int ret;
+    rt_uint64_t start;
+    rt_thread_t tid;
+    struct perf_stat stat;
+    char buf[PERF_MSG_SIZE];
+
+    uassert_int_equal(sal_socketpair(AF_UNIX, type, 0, perf_sockets), 0);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+
+    tid = perf_thread_create("p_echo", echo_entry, RT_NULL, -1);
+    uassert_not_null(tid);
+    perf_failed = 0;
+    rt_thread_startup(tid);
+
+    rt_memset(buf, 0x5a, sizeof(buf));
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        ret = sal_sendto(perf_sockets[0], buf, sizeof(buf), 0, RT_NULL, 0);
+        if (ret != sizeof(buf) || perf_recv_all(perf_sockets[0], buf, sizeof(buf)) != sizeof(buf))
+        {
+            perf_failed++;
+            break;
+        }
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(&stat, perf_clock() - start);
+        }
+    }
+
+    /* the echo thread sees the end of the stream, or an empty datagram */
+    if (type == SOCK_DGRAM)
+    {
+        sal_sendto(perf_sockets[0], buf, 0, 0, RT_NULL, 0);
+    }
+    sal_closesocket(perf_sockets[0]);
+    rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+    sal_closesocket(perf_sockets[1]);
+    uassert_int_equal(perf_failed, 0);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_stream_pingpong(void)
+{
+    perf_pingpong("af_unix.stream.pingpong_64", SOCK_STREAM);
+}
+
+static void test_dgram_pingpong(void)
+{
+    perf_pingpong("af_unix.dgram.pingpong_64", SOCK_DGRAM);
+}
+
+static void writer_entry(void *parameter)
+{
+    int ret;
+    char *buf;
+    rt_size_t sent = 0;
+
+    buf = (char *)rt_malloc(PERF_BULK_SIZE);
+    if (buf != RT_NULL)
+    {
+        rt_memset(buf, 0xa5, PERF_BULK_SIZE);
+        while (sent < perf_size)
+        {
+            ret = sal_sendto(perf_sockets[1], buf, PERF_BULK_SIZE, 0, RT_NULL, 0);
+            if (ret <= 0)
+            {
+                perf_failed++;
+                break;
+            }
+            sent += ret;
+        }
+        rt_free(buf);
+    }
+    else
+    {
+        perf_failed++;
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void test_stream_bulk(void)
+{
+    int i;
+    char *buf;
+    rt_uint64_t start;
+    rt_thread_t tid;
+    struct perf_stat stat;
+
+    buf = (char *)rt_malloc(PERF_BULK_SIZE);
+    uassert_not_null(buf);
+    uassert_int_equal(sal_socketpair(AF_UNIX, SOCK_STREAM, 0, perf_sockets), 0);
+    /* a sample is a chunk received, ops_s is the chunks per second */
+    uassert_int_equal(perf_stat_init(&stat, "af_unix.stream.bulk_4k", PERF_ITERATIONS, 1), RT_EOK);
+
+    perf_size = (PERF_WARMUP + PERF_ITERATIONS) * PERF_BULK_SIZE;
+    tid = perf_thread_create("p_write", writer_entry, RT_NULL, -1);
+    uassert_not_null(tid);
+    perf_failed = 0;
+    rt_thread_startup(tid);
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        if (perf_recv_all(perf_sockets[0], buf, PERF_BULK_SIZE) != PERF_BULK_SIZE)
+        {
+            perf_failed++;
+            break;
+        }
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(&stat, perf_clock() - start);
+        }
+    }
+
+    sal_closesocket(perf_sockets[0]);
+    rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+    sal_closesocket(perf_sockets[1]);
+    rt_free(buf);
+    uassert_int_equal(perf_failed, 0);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&perf_done, "p_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&perf_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_stream_pingpong);
+    UTEST_UNIT_RUN(test_dgram_pingpong);
+    UTEST_UNIT_RUN(test_stream_bulk);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.af_unix_tc", utest_tc_init, utest_tc_cleanup, 60);
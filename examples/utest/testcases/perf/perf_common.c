@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtatomic.h>
+#include <stdlib.h>
+#include "perf_common.h"
+
+rt_err_t perf_stat_init(struct perf_stat *stat, const char *name, rt_uint32_t size, rt_uint32_t ops)
+{
+    stat->name = name;
+    stat->ops = ops;
+    stat->size = size;
+    stat->count = 0;
+    stat->wall = 0;
+    stat->samples = (rt_uint64_t *)rt_malloc(size * sizeof(rt_uint64_t));
+
+    return stat->samples != RT_NULL ? RT_EOK : -RT_ENOMEM;
+}
+
+void perf_stat_detach(struct perf_stat *stat)
+{
+    rt_free(stat->samples);
+    stat->samples = RT_NULL;
+}
+
+/**
+ * @brief Add a sample, it may be called by the threads in parallel.
+ *
+ * @param stat is the statistics of the benchmark.
+ *
+ * @param clocks is the time of the sample in the counts of perf_clock().
+ */
+void perf_stat_add(struct perf_stat *stat, rt_uint64_t clocks)
+{
+    rt_atomic_t index = rt_atomic_add(&stat->count, 1);
+
+    if (index < stat->size)
+    {
+        stat->samples[index] = clocks;
+    }
+}
+
+static int perf_sample_cmp(const void *a, const void *b)
+{
+    rt_uint64_t x = *(const rt_uint64_t *)a;
+    rt_uint64_t y = *(const rt_uint64_t *)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* the latency of one operation in the sample at the percentile */
+static rt_uint64_t perf_percentile_ns(struct perf_stat *stat, rt_uint32_t count, rt_uint32_t percent)
+{
+    rt_uint32_t index = (rt_uint32_t)(((rt_uint64_t)count * percent + 99) / 100);
+
+    index = index > 0 ? index - 1 : 0;
+
+    return rt_cpu_usage_to_ns(stat->samples[index]) / stat->ops;
+}
+
+/**
+ * @brief Print the result of the benchmark as a line of key=value.
+ *
+ * @param stat is the statistics of the benchmark.
+ */
+void perf_stat_report(struct perf_stat *stat)
+{
+    rt_uint32_t i;
+    rt_uint32_t count;
+    rt_uint64_t ops, total, total_ns, elapsed_ns;
+
+    count = stat->count < stat->size ? stat->count : stat->size;
+    if (count == 0)
+    {
+        rt_kprintf("perf: name=%s ops=0\n", stat->name);
+        return;
+    }
+
+    total = 0;
+    for (i = 0; i < count; i++)
+    {
+        total += stat->samples[i];
+    }
+
+    qsort(stat->samples, count, sizeof(rt_uint64_t), perf_sample_cmp);
+
+    ops = (rt_uint64_t)count * stat->ops;
+    total_ns = rt_cpu_usage_to_ns(total);
+    elapsed_ns = stat->wall ? rt_cpu_usage_to_ns(stat->wall) : total_ns;
+
+    rt_kprintf("perf: name=%s ops=%llu cycles_op=%llu ns_op=%llu ops_s=%llu "
+               "p50_ns=%llu p90_ns=%llu p99_ns=%llu max_ns=%llu\n",
+               stat->name, ops, total / ops, total_ns / ops,
+               elapsed_ns ? ops * 1000000000ULL / elapsed_ns : 0,
+               perf_percentile_ns(stat, count, 50),
+               perf_percentile_ns(stat, count, 90),
+               perf_percentile_ns(stat, count, 99),
+               rt_cpu_usage_to_ns(stat->samples[count - 1]) / stat->ops);
+}
+
+/**
+ * @brief Create a thread of the benchmark, which runs with the priority above
+ *        the utest and the shell.
+ *
+ * @param cpu is the CPU the thread is bound to, or -1 for any CPU.
+ *
+ * @return the thread, which is not started, or RT_NULL on failure.
+ */
+rt_thread_t perf_thread_create(const char *name, void (*entry)(void *parameter), void *parameter, int cpu)
+{
+    rt_thread_t tid;
+
+    tid = rt_thread_create(name, entry, parameter, PERF_THREAD_STACK_SIZE, PERF_THREAD_PRIORITY, 10);
+#ifdef RT_USING_SMP
+    if (tid != RT_NULL && cpu >= 0)
+    {
+        rt_thread_control(tid, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)(cpu % RT_CPUS_NR));
+    }
+#endif /* RT_USING_SMP */
+
+    return tid;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __PERF_COMMON_H__
+#define __PERF_COMMON_H__
+
+#include <rtthread.h>
+#include "utest.h"
+
+/*
+ * Each benchmark takes UTEST_PERF_ITERATIONS samples, a sample is the time of
+ * `ops` operations measured by rt_cpu_usage_clock(), the cycle counter or the
+ * system counter of the architecture. The result is printed as one line:
+ *
+ *   perf: name=sem.pingpong.cross ops=2000 cycles_op=512 ns_op=8533 \
+ *         ops_s=117187 p50_ns=8400 p90_ns=9100 p99_ns=12300 max_ns=40100
+ *
+ * The cycles are the counts of rt_cpu_usage_clock(), and the percentiles are
+ * of the latency of one operation in a sample.
+ */
+
+#define PERF_THREAD_PRIORITY        (RT_THREAD_PRIORITY_MAX / 4)
+#define PERF_THREAD_STACK_SIZE      4096
+
+struct perf_stat
+{
+    const char *name;
+
+    rt_uint32_t ops;                    /**< the operations in a sample */
+    rt_uint32_t size;                   /**< the max number of the samples */
+    rt_atomic_t count;                  /**< the number of the samples taken */
+    rt_uint64_t *samples;
+
+    /* the elapsed time of the parallel samples, 0 to use the sum of them */
+    rt_uint64_t wall;
+};
+
+rt_inline rt_uint64_t perf_clock(void)
+{
+    return rt_cpu_usage_clock();
+}
+
+rt_err_t perf_stat_init(struct perf_stat *stat, const char *name, rt_uint32_t size, rt_uint32_t ops);
+void perf_stat_detach(struct perf_stat *stat);
+void perf_stat_add(struct perf_stat *stat, rt_uint64_t clocks);
+void perf_stat_report(struct perf_stat *stat);
+
+rt_thread_t perf_thread_create(const char *name, void (*entry)(void *parameter), void *parameter, int cpu);
+
+#endif /* __PERF_COMMON_H__ */
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtm.h>
+#include <dlmodule.h>
+#include <dlfcn.h>
+#include "perf_common.h"
+
+/*
+ * A sample resolves PERF_RELOCS undefined symbols of a module, which is the
+ * work of the kernel symbol table when a module with 2k relocations against
+ * the kernel is loaded. The linear scan of the table is measured as well, for
+ * the comparison with the hash index.
+ *
+ * If UTEST_PERF_DLMODULE_PATH is a module in the file system, the time of
+ * dlopen() and dlclose() of it is measured too.
+ */
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_RELOCS             2048
+
+extern int __rtmsymtab_start;
+extern int __rtmsymtab_end;
+
+static struct rt_module_symtab *symtab_begin;
+static rt_size_t symtab_count;
+
+static rt_ubase_t linear_symbol_find(const char *name)
+{
+    struct rt_module_symtab *index;
+
+    for (index = symtab_begin; index != symtab_begin + symtab_count; index++)
+    {
+        if (rt_strcmp(index->name, name) == 0)
+        {
+            return (rt_ubase_t)index->addr;
+        }
+    }
+
+    return 0;
+}
+
+static void perf_symbol_find(const char *name, rt_ubase_t (*find)(const char *name))
+{
+    int i, j;
+    int failed = 0;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    rt_uint32_t next = 0;
+
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, PERF_RELOCS), RT_EOK);
+
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        for (j = 0; j < PERF_RELOCS; j++)
+        {
+            /* walk the table with a stride, so the names are not in order */
+            next = (next + 7919) % symtab_count;
+            failed += find(symtab_begin[next].name) == 0;
+        }
+        perf_stat_add(&stat, perf_clock() - start);
+    }
+
+    uassert_int_equal(failed, 0);
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_symbol_find(void)
+{
+    symtab_begin = (struct rt_module_symtab *)&__rtmsymtab_start;
+    symtab_count = (struct rt_module_symtab *)&__rtmsymtab_end - symtab_begin;
+    uassert_true(symtab_count > 0);
+    if (symtab_count == 0)
+    {
+        return;
+    }
+
+    rt_kprintf("perf: %d kernel symbols\n", (int)symtab_count);
+    perf_symbol_find("dlmodule.symbol_find.relocs_2k", dlmodule_symbol_find);
+    perf_symbol_find("dlmodule.symbol_find_linear.relocs_2k", linear_symbol_find);
+    uassert_int_equal(dlmodule_symbol_find("__perf_no_such_symbol"), 0);
+}
+
+static void test_module_load(void)
+{
+    int i;
+    void *handle;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    const char *path = UTEST_PERF_DLMODULE_PATH;
+
+    if (path[0] == '\0')
+    {
+        return;
+    }
+
+    /* loading takes much longer than the others, take fewer samples */
+    uassert_int_equal(perf_stat_init(&stat, "dlmodule.dlopen_dlclose", PERF_ITERATIONS / 10 + 1, 1), RT_EOK);
+
+    for (i = 0; i < PERF_ITERATIONS / 10 + 1; i++)
+    {
+        start = perf_clock();
+        handle = dlopen(path, 0);
+        if (handle == RT_NULL)
+        {
+            rt_kprintf("perf: can't load %s\n", path);
+            break;
+        }
+        dlclose(handle);
+        perf_stat_add(&stat, perf_clock() - start);
+    }
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_symbol_find);
+    UTEST_UNIT_RUN(test_module_load);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.dlmodule_tc", utest_tc_init, utest_tc_cleanup, 60);
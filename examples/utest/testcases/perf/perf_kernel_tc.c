@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtatomic.h>
+#include "perf_common.h"
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+/* the samples discarded before the threads settle */
+#define PERF_WARMUP             (PERF_ITERATIONS / 10)
+#define PERF_FANOUT_NR          4
+#define PERF_TIMERS_NR          64
+
+#ifdef RT_USING_SMP
+#define PERF_CONTENDERS_NR      (RT_CPUS_NR > 2 ? RT_CPUS_NR : 2)
+#define PERF_CPU_A              (RT_CPUS_NR - 1)
+#define PERF_CPU_B              (RT_CPUS_NR - 2)
+#else
+#define PERF_CONTENDERS_NR      2
+#define PERF_CPU_A              0
+#define PERF_CPU_B              0
+#endif /* RT_USING_SMP */
+
+static struct rt_semaphore perf_done;
+static struct rt_semaphore perf_start;
+static volatile int perf_stop;
+
+static struct rt_semaphore sem_ping;
+static struct rt_semaphore sem_pong;
+static struct rt_mutex perf_mutex;
+static volatile rt_ubase_t perf_shared;
+static struct rt_event fanout_event;
+static struct rt_semaphore fanout_ack;
+static rt_atomic_t fanout_acked;
+
+/* start the threads at the same time, then wait for all of them to finish */
+static rt_bool_t perf_run(rt_thread_t *tids, int nr)
+{
+    int i;
+
+    for (i = 0; i < nr; i++)
+    {
+        if (tids[i] == RT_NULL)
+        {
+            while (--nr >= 0)
+            {
+                if (tids[nr] != RT_NULL)
+                {
+                    rt_thread_delete(tids[nr]);
+                }
+            }
+            return RT_FALSE;
+        }
+    }
+
+    perf_stop = 0;
+
+    rt_enter_critical();
+    for (i = 0; i < nr; i++)
+    {
+        rt_thread_startup(tids[i]);
+    }
+    rt_exit_critical();
+
+    for (i = 0; i < nr; i++)
+    {
+        rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+    }
+
+    return RT_TRUE;
+}
+
+static void yield_peer_entry(void *parameter)
+{
+    while (!perf_stop)
+    {
+        rt_thread_yield();
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void yield_entry(void *parameter)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat *stat = (struct perf_stat *)parameter;
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_thread_yield();
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(stat, perf_clock() - start);
+        }
+    }
+
+    perf_stop = 1;
+    rt_sem_release(&perf_done);
+}
+
+static void test_context_switch(void)
+{
+    struct perf_stat stat;
+    rt_thread_t tids[2];
+
+    /* a sample is switched out and back by the peer */
+    uassert_int_equal(perf_stat_init(&stat, "thread.switch", PERF_ITERATIONS, 2), RT_EOK);
+
+    tids[0] = perf_thread_create("p_yield", yield_entry, &stat, PERF_CPU_A);
+    tids[1] = perf_thread_create("p_peer", yield_peer_entry, RT_NULL, PERF_CPU_A);
+    uassert_true(perf_run(tids, 2));
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void pong_entry(void *parameter)
+{
+    int i;
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        rt_sem_take(&sem_ping, RT_WAITING_FOREVER);
+        rt_sem_release(&sem_pong);
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void ping_entry(void *parameter)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat *stat = (struct perf_stat *)parameter;
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_sem_release(&sem_ping);
+        rt_sem_take(&sem_pong, RT_WAITING_FOREVER);
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(stat, perf_clock() - start);
+        }
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void sem_pingpong(const char *name, int cpu_ping, int cpu_pong)
+{
+    struct perf_stat stat;
+    rt_thread_t tids[2];
+
+    /* a sample is a round trip */
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+
+    rt_sem_init(&sem_ping, "p_ping", 0, RT_IPC_FLAG_PRIO);
+    rt_sem_init(&sem_pong, "p_pong", 0, RT_IPC_FLAG_PRIO);
+
+    tids[0] = perf_thread_create("p_ping", ping_entry, &stat, cpu_ping);
+    tids[1] = perf_thread_create("p_pong", pong_entry, RT_NULL, cpu_pong);
+    uassert_true(perf_run(tids, 2));
+
+    rt_sem_detach(&sem_ping);
+    rt_sem_detach(&sem_pong);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_sem_pingpong(void)
+{
+    sem_pingpong("sem.pingpong.same", PERF_CPU_A, PERF_CPU_A);
+#ifdef RT_USING_SMP
+    sem_pingpong("sem.pingpong.cross", PERF_CPU_A, PERF_CPU_B);
+#endif /* RT_USING_SMP */
+}
+
+static void mutex_entry(void *parameter)
+{
+    int i, j;
+    rt_uint64_t start;
+    struct perf_stat *stat = (struct perf_stat *)parameter;
+
+    rt_sem_take(&perf_start, RT_WAITING_FOREVER);
+
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_mutex_take(&perf_mutex, RT_WAITING_FOREVER);
+        /* a short critical section */
+        for (j = 0; j < 16; j++)
+        {
+            perf_shared++;
+        }
+        rt_mutex_release(&perf_mutex);
+        perf_stat_add(stat, perf_clock() - start);
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void test_mutex(void)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    rt_thread_t tids[PERF_CONTENDERS_NR];
+    char name[RT_NAME_MAX];
+
+    rt_mutex_init(&perf_mutex, "p_mutex", RT_IPC_FLAG_PRIO);
+
+    /* uncontended, in the thread of utest */
+    uassert_int_equal(perf_stat_init(&stat, "mutex.take_release", PERF_ITERATIONS, 1), RT_EOK);
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_mutex_take(&perf_mutex, RT_WAITING_FOREVER);
+        rt_mutex_release(&perf_mutex);
+        perf_stat_add(&stat, perf_clock() - start);
+    }
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+
+    /* contended by the threads on all the CPUs */
+    uassert_int_equal(perf_stat_init(&stat, "mutex.contention", PERF_ITERATIONS * PERF_CONTENDERS_NR, 1), RT_EOK);
+    for (i = 0; i < PERF_CONTENDERS_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "p_mtx%d", i);
+        tids[i] = perf_thread_create(name, mutex_entry, &stat, i);
+    }
+
+    /* they block on perf_start until all of them are started */
+    rt_sem_init(&perf_start, "p_start", 0, RT_IPC_FLAG_FIFO);
+    for (i = 0; i < PERF_CONTENDERS_NR; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_thread_startup(tids[i]);
+        }
+    }
+    start = perf_clock();
+    for (i = 0; i < PERF_CONTENDERS_NR; i++)
+    {
+        rt_sem_release(&perf_start);
+    }
+    for (i = 0; i < PERF_CONTENDERS_NR; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+        }
+    }
+    stat.wall = perf_clock() - start;
+    rt_sem_detach(&perf_start);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+
+    rt_mutex_detach(&perf_mutex);
+}
+
+static void test_mq(void)
+{
+    int i, j;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    struct rt_messagequeue mq;
+    static rt_uint8_t pool[4 * (256 + sizeof(void *) * 2)];
+    static rt_uint8_t msg[256];
+    static const struct
+    {
+        rt_size_t size;
+        const char *name;
+    } cases[] =
+    {
+        {16, "mq.send_recv.16"},
+        {256, "mq.send_recv.256"},
+    };
+
+    for (j = 0; j < sizeof(cases) / sizeof(cases[0]); j++)
+    {
+        uassert_int_equal(rt_mq_init(&mq, "p_mq", pool, cases[j].size, sizeof(pool), RT_IPC_FLAG_PRIO), RT_EOK);
+        uassert_int_equal(perf_stat_init(&stat, cases[j].name, PERF_ITERATIONS, 1), RT_EOK);
+
+        for (i = 0; i < PERF_ITERATIONS; i++)
+        {
+            start = perf_clock();
+            rt_mq_send(&mq, msg, cases[j].size);
+            rt_mq_recv(&mq, msg, cases[j].size, RT_WAITING_FOREVER);
+            perf_stat_add(&stat, perf_clock() - start);
+        }
+
+        perf_stat_report(&stat);
+        perf_stat_detach(&stat);
+        rt_mq_detach(&mq);
+    }
+}
+
+static void test_malloc(void)
+{
+    int i, j;
+    void *ptr;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    static const struct
+    {
+        rt_size_t size;
+        const char *name;
+    } cases[] =
+    {
+        {16, "malloc.free.16"},
+        {64, "malloc.free.64"},
+        {256, "malloc.free.256"},
+        {1024, "malloc.free.1024"},
+        {4096, "malloc.free.4096"},
+    };
+
+    for (j = 0; j < sizeof(cases) / sizeof(cases[0]); j++)
+    {
+        uassert_int_equal(perf_stat_init(&stat, cases[j].name, PERF_ITERATIONS, 1), RT_EOK);
+
+        for (i = 0; i < PERF_ITERATIONS; i++)
+        {
+            start = perf_clock();
+            ptr = rt_malloc(cases[j].size);
+            rt_free(ptr);
+            perf_stat_add(&stat, perf_clock() - start);
+
+            if (ptr == RT_NULL)
+            {
+                uassert_true(RT_FALSE);
+                break;
+            }
+        }
+
+        perf_stat_report(&stat);
+        perf_stat_detach(&stat);
+    }
+}
+
+static void perf_timeout(void *parameter)
+{
+}
+
+static void timer_start_stop(const char *name, int armed_nr)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    struct rt_timer timer;
+    struct rt_timer *armed;
+
+    armed = (struct rt_timer *)rt_malloc(sizeof(struct rt_timer) * (armed_nr ? armed_nr : 1));
+    uassert_not_null(armed);
+    if (armed == RT_NULL)
+    {
+        return;
+    }
+
+    /* the timers already in the list, which never expire during the test */
+    for (i = 0; i < armed_nr; i++)
+    {
+        rt_timer_init(&armed[i], "p_armed", perf_timeout, RT_NULL,
+                      RT_TICK_PER_SECOND * 100 + i * 7 % armed_nr, RT_TIMER_FLAG_ONE_SHOT);
+        rt_timer_start(&armed[i]);
+    }
+
+    rt_timer_init(&timer, "p_timer", perf_timeout, RT_NULL, RT_TICK_PER_SECOND * 50, RT_TIMER_FLAG_ONE_SHOT);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_timer_start(&timer);
+        rt_timer_stop(&timer);
+        perf_stat_add(&stat, perf_clock() - start);
+    }
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+    rt_timer_detach(&timer);
+
+    for (i = 0; i < armed_nr; i++)
+    {
+        rt_timer_stop(&armed[i]);
+        rt_timer_detach(&armed[i]);
+    }
+    rt_free(armed);
+}
+
+static void test_timer(void)
+{
+    timer_start_stop("timer.start_stop", 0);
+    timer_start_stop("timer.start_stop.armed64", PERF_TIMERS_NR);
+}
+
+static void fanout_entry(void *parameter)
+{
+    rt_uint32_t recved;
+    rt_uint32_t set = 1U << (rt_ubase_t)parameter;
+
+    for (;;)
+    {
+        rt_event_recv(&fanout_event, set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                      RT_WAITING_FOREVER, &recved);
+        if (perf_stop)
+        {
+            break;
+        }
+
+        if (rt_atomic_add(&fanout_acked, 1) + 1 == PERF_FANOUT_NR)
+        {
+            rt_sem_release(&fanout_ack);
+        }
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void test_event_fanout(void)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    rt_thread_t tids[PERF_FANOUT_NR];
+    char name[RT_NAME_MAX];
+    const rt_uint32_t all = (1U << PERF_FANOUT_NR) - 1;
+
+    rt_event_init(&fanout_event, "p_fanout", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&fanout_ack, "p_ack", 0, RT_IPC_FLAG_PRIO);
+
+    /* a sample is from the send to the last of the receivers woken up */
+    uassert_int_equal(perf_stat_init(&stat, "event.fanout.4", PERF_ITERATIONS, 1), RT_EOK);
+
+    for (i = 0; i < PERF_FANOUT_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "p_fan%d", i);
+        tids[i] = perf_thread_create(name, fanout_entry, (void *)(rt_ubase_t)i, -1);
+        if (tids[i] != RT_NULL)
+        {
+            rt_thread_startup(tids[i]);
+        }
+        else
+        {
+            uassert_true(RT_FALSE);
+        }
+    }
+
+    /* let the receivers block on the event */
+    rt_thread_mdelay(10);
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        rt_atomic_store(&fanout_acked, 0);
+        start = perf_clock();
+        rt_event_send(&fanout_event, all);
+        rt_sem_take(&fanout_ack, RT_WAITING_FOREVER);
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(&stat, perf_clock() - start);
+        }
+    }
+
+    perf_stop = 1;
+    rt_event_send(&fanout_event, all);
+    for (i = 0; i < PERF_FANOUT_NR; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+        }
+    }
+
+    rt_sem_detach(&fanout_ack);
+    rt_event_detach(&fanout_event);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    perf_stop = 0;
+    rt_sem_init(&perf_done, "p_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&perf_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_context_switch);
+    UTEST_UNIT_RUN(test_sem_pingpong);
+    UTEST_UNIT_RUN(test_mutex);
+    UTEST_UNIT_RUN(test_mq);
+    UTEST_UNIT_RUN(test_malloc);
+    UTEST_UNIT_RUN(test_timer);
+    UTEST_UNIT_RUN(test_event_fanout);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.kernel_tc", utest_tc_init, utest_tc_cleanup, 60);
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "lwip/tcpip.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip.h"
+#include "lwip/tcp_impl.h"
+#include "ipv4_nat.h"
+#include "perf_common.h"
+
+/*
+ * The packets are forwarded between two netifs which only count them, by
+ * calling the hooks of the NAT in ip_input() directly, in the context of the
+ * tcpip thread which owns the connections.
+ */
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_NAT_FLOWS          UTEST_PERF_LWIP_NAT_FLOWS
+#define PERF_NAT_BATCH          16
+
+struct perf_nat_flow
+{
+    struct pbuf *p;
+    u32_t host;                         /* the host in the LAN */
+    u32_t server;                       /* the server in the WAN */
+    u16_t sport;
+    u16_t nport;                        /* the translated port */
+};
+
+static struct rt_semaphore perf_done;
+static struct netif perf_lan;
+static struct netif perf_wan;
+static ip_nat_entry_t perf_entry;
+static struct perf_nat_flow *perf_flows;
+static rt_uint32_t perf_sent;
+static int perf_failed;
+
+static struct perf_stat stat_new;
+static struct perf_stat stat_out;
+static struct perf_stat stat_in;
+
+static err_t perf_nat_output(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr)
+{
+    perf_sent++;
+    return ERR_OK;
+}
+
+/* build the TCP segment of a flow in the direction to the WAN or back */
+static void perf_nat_fill(struct perf_nat_flow *flow, int incoming)
+{
+    struct ip_hdr *iphdr = (struct ip_hdr *)flow->p->payload;
+    struct tcp_hdr *tcphdr = (struct tcp_hdr *)((u8_t *)iphdr + IP_HLEN);
+
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_TOS_SET(iphdr, 0);
+    IPH_LEN_SET(iphdr, htons(IP_HLEN + TCP_HLEN));
+    IPH_ID_SET(iphdr, 0);
+    IPH_OFFSET_SET(iphdr, 0);
+    IPH_TTL_SET(iphdr, 64);
+    IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+    IPH_CHKSUM_SET(iphdr, 0);
+
+    rt_memset(tcphdr, 0, TCP_HLEN);
+    TCPH_HDRLEN_FLAGS_SET(tcphdr, TCP_HLEN / 4, TCP_ACK);
+    if (incoming)
+    {
+        iphdr->src.addr = flow->server;
+        iphdr->dest.addr = perf_wan.ip_addr.addr;
+        tcphdr->src = htons(80);
+        tcphdr->dest = flow->nport;
+    }
+    else
+    {
+        iphdr->src.addr = flow->host;
+        iphdr->dest.addr = flow->server;
+        tcphdr->src = flow->sport;
+        tcphdr->dest = htons(80);
+    }
+}
+
+static void perf_nat_forward(struct perf_stat *stat, int incoming)
+{
+    int i, j;
+    u8_t taken;
+    rt_uint64_t start;
+    struct perf_nat_flow *flow;
+    rt_uint32_t next = 0;
+
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        for (j = 0; j < PERF_NAT_BATCH; j++)
+        {
+            perf_nat_fill(&perf_flows[(next + j) % PERF_NAT_FLOWS], incoming);
+        }
+
+        taken = 1;
+        start = perf_clock();
+        for (j = 0; j < PERF_NAT_BATCH; j++)
+        {
+            flow = &perf_flows[(next + j) % PERF_NAT_FLOWS];
+            if (incoming)
+            {
+                /* the translated packet is freed by the NAT */
+                pbuf_ref(flow->p);
+                taken &= ip_nat_input(flow->p);
+            }
+            else
+            {
+                taken &= ip_nat_out(flow->p);
+            }
+        }
+        perf_stat_add(stat, perf_clock() - start);
+
+        perf_failed += !taken;
+        next = (next + PERF_NAT_BATCH) % PERF_NAT_FLOWS;
+    }
+}
+
+static void perf_nat_entry(void *parameter)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_nat_flow *flow;
+
+    /* the first packet of a flow creates the connection */
+    for (i = 0; i < PERF_NAT_FLOWS; i++)
+    {
+        flow = &perf_flows[i];
+        perf_nat_fill(flow, 0);
+
+        start = perf_clock();
+        perf_failed += !ip_nat_out(flow->p);
+        perf_stat_add(&stat_new, perf_clock() - start);
+
+        flow->nport = ((struct tcp_hdr *)((u8_t *)flow->p->payload + IP_HLEN))->src;
+    }
+
+    perf_nat_forward(&stat_out, 0);
+    perf_nat_forward(&stat_in, 1);
+
+    rt_sem_release(&perf_done);
+}
+
+static void test_nat_forward(void)
+{
+    int i;
+    rt_uint32_t expected;
+
+    perf_flows = (struct perf_nat_flow *)rt_calloc(PERF_NAT_FLOWS, sizeof(struct perf_nat_flow));
+    uassert_not_null(perf_flows);
+
+    /* 192.168.x.y:sport -> 10.x.y.z:80, the hosts and servers are spread */
+    for (i = 0; i < PERF_NAT_FLOWS; i++)
+    {
+        perf_flows[i].p = pbuf_alloc(PBUF_IP, IP_HLEN + TCP_HLEN, PBUF_RAM);
+        uassert_not_null(perf_flows[i].p);
+        perf_flows[i].host = PP_HTONL(0xc0a80000UL | (2 + i % 250));
+        perf_flows[i].server = PP_HTONL(0x0a000000UL | (1 + i * 7919 % 0xfffffe));
+        perf_flows[i].sport = htons((u16_t)(1024 + i / 250));
+    }
+
+    uassert_int_equal(perf_stat_init(&stat_new, "lwip_nat.tcp.new_flow", PERF_NAT_FLOWS, 1), RT_EOK);
+    uassert_int_equal(perf_stat_init(&stat_out, "lwip_nat.tcp.forward_out", PERF_ITERATIONS, PERF_NAT_BATCH), RT_EOK);
+    uassert_int_equal(perf_stat_init(&stat_in, "lwip_nat.tcp.forward_in", PERF_ITERATIONS, PERF_NAT_BATCH), RT_EOK);
+
+    IP4_ADDR(&perf_lan.ip_addr, 192, 168, 0, 1);
+    IP4_ADDR(&perf_wan.ip_addr, 172, 16, 0, 1);
+    perf_lan.output = perf_nat_output;
+    perf_wan.output = perf_nat_output;
+
+    perf_entry.in_if = &perf_lan;
+    perf_entry.out_if = &perf_wan;
+    IP4_ADDR(&perf_entry.source_net, 192, 168, 0, 0);
+    IP4_ADDR(&perf_entry.source_netmask, 255, 255, 0, 0);
+    IP4_ADDR(&perf_entry.dest_net, 10, 0, 0, 0);
+    IP4_ADDR(&perf_entry.dest_netmask, 255, 0, 0, 0);
+    uassert_int_equal(ip_nat_add(&perf_entry), ERR_OK);
+
+    perf_sent = 0;
+    perf_failed = 0;
+    if (tcpip_callback(perf_nat_entry, RT_NULL) == ERR_OK)
+    {
+        rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+    }
+    else
+    {
+        perf_failed++;
+    }
+
+    /* the connections are dropped by the tcpip thread */
+    ip_nat_remove(&perf_entry);
+
+    expected = PERF_NAT_FLOWS + 2 * PERF_ITERATIONS * PERF_NAT_BATCH;
+    uassert_int_equal(perf_failed, 0);
+    uassert_int_equal(perf_sent, expected);
+
+    perf_stat_report(&stat_new);
+    perf_stat_report(&stat_out);
+    perf_stat_report(&stat_in);
+    perf_stat_detach(&stat_new);
+    perf_stat_detach(&stat_out);
+    perf_stat_detach(&stat_in);
+
+    for (i = 0; i < PERF_NAT_FLOWS; i++)
+    {
+        pbuf_free(perf_flows[i].p);
+    }
+    rt_free(perf_flows);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&perf_done, "p_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&perf_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_nat_forward);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.lwip_nat_tc", utest_tc_init, utest_tc_cleanup, 60);
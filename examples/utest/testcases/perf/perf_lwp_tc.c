@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <lwp.h>
+#include <lwp_pid.h>
+#include "perf_common.h"
+
+/*
+ * The syscalls, the page faults of user space and fork/exec can not be
+ * measured by a kernel thread, so they are measured by the user program built
+ * from user/perf_lwp.c, which prints the results in the same format.
+ */
+
+#define PERF_LWP_TIMEOUT_MS     (60 * 1000)
+
+static rt_bool_t perf_lwp_exited(pid_t pid)
+{
+    rt_base_t level;
+    struct rt_lwp *lwp;
+
+    level = rt_hw_interrupt_disable();
+    lwp = lwp_from_pid(pid);
+    rt_hw_interrupt_enable(level);
+
+    return lwp == RT_NULL;
+}
+
+static void test_lwp(void)
+{
+    pid_t pid;
+    int elapsed;
+    char iterations[12];
+    char *argv[] = {UTEST_PERF_LWP_APP, "all", iterations};
+
+    rt_snprintf(iterations, sizeof(iterations), "%d", UTEST_PERF_ITERATIONS);
+
+    pid = lwp_execve(UTEST_PERF_LWP_APP, 0, 3, argv, RT_NULL);
+    if (pid <= 0)
+    {
+        LOG_W("%s is not found, skip the benchmarks of user space", UTEST_PERF_LWP_APP);
+        return;
+    }
+
+    /* a kernel thread can not wait the process, poll it until it exits */
+    for (elapsed = 0; elapsed < PERF_LWP_TIMEOUT_MS && !perf_lwp_exited(pid); elapsed += 10)
+    {
+        rt_thread_mdelay(10);
+    }
+
+    uassert_true(elapsed < PERF_LWP_TIMEOUT_MS);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_lwp);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.lwp_tc", utest_tc_init, utest_tc_cleanup, 90);
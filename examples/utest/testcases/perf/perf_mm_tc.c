@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <mm_page.h>
+#include "perf_common.h"
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_PAGES_BATCH        16
+
+static void test_pages_alloc(void)
+{
+    int i, j;
+    int failed = 0;
+    rt_uint32_t order;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    void *pages[PERF_PAGES_BATCH];
+    static const char *const names[] =
+    {
+        "pages.alloc_free.order0",
+        "pages.alloc_free.order1",
+        "pages.alloc_free.order2",
+        "pages.alloc_free.order3",
+    };
+
+    for (order = 0; order < sizeof(names) / sizeof(names[0]); order++)
+    {
+        /* a sample allocates a batch, so the buddies are split and merged */
+        uassert_int_equal(perf_stat_init(&stat, names[order], PERF_ITERATIONS, PERF_PAGES_BATCH * 2), RT_EOK);
+
+        for (i = 0; i < PERF_ITERATIONS; i++)
+        {
+            start = perf_clock();
+            for (j = 0; j < PERF_PAGES_BATCH; j++)
+            {
+                pages[j] = rt_pages_alloc(order);
+            }
+            for (j = 0; j < PERF_PAGES_BATCH; j++)
+            {
+                if (pages[j] != RT_NULL)
+                {
+                    rt_pages_free(pages[j], order);
+                }
+            }
+            perf_stat_add(&stat, perf_clock() - start);
+
+            for (j = 0; j < PERF_PAGES_BATCH; j++)
+            {
+                failed += pages[j] == RT_NULL;
+            }
+        }
+
+        perf_stat_report(&stat);
+        perf_stat_detach(&stat);
+    }
+
+    uassert_int_equal(failed, 0);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_pages_alloc);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.mm_tc", utest_tc_init, utest_tc_cleanup, 60);
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "perf_common.h"
+
+#ifdef RT_USING_POSIX_PIPE_PAGE
+#include <mm_page.h>
+#include <mmu.h>
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+
+/*
+ * The throughput of `dd bs=N | cat`: a writer thread writes blocks of N bytes
+ * to a pipe, and the reader reads it by PERF_READ_SIZE like cat. A sample is
+ * a block read, so the bytes per second is ops_s * N.
+ *
+ * The byte at the offset n of the stream is (n & 0xff), so the reader checks
+ * that nothing is lost, duplicated or reordered, also when a write is partial
+ * or wraps around the ring of the pipe.
+ */
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_WARMUP             (PERF_ITERATIONS / 10)
+#define PERF_READ_SIZE          65536
+#define PERF_PATTERN(n)         ((char)((n) & 0xff))
+
+static struct rt_semaphore perf_done;
+static int perf_fds[2];
+static rt_size_t perf_block;
+static rt_size_t perf_size;
+static int perf_failed;
+
+static void dd_entry(void *parameter)
+{
+    int ret;
+    char *buf;
+    rt_size_t i;
+    rt_size_t sent = 0;
+
+    /* buf + (n & 0xff) is the stream from the offset n */
+    buf = (char *)rt_malloc(perf_block + 256);
+    if (buf != RT_NULL)
+    {
+        for (i = 0; i < perf_block + 256; i++)
+        {
+            buf[i] = PERF_PATTERN(i);
+        }
+        while (sent < perf_size)
+        {
+            /* the rest of a block after a partial write */
+            ret = write(perf_fds[1], buf + (sent & 0xff), perf_block - sent % perf_block);
+            if (ret <= 0)
+            {
+                perf_failed++;
+                break;
+            }
+            sent += ret;
+        }
+        rt_free(buf);
+    }
+    else
+    {
+        perf_failed++;
+    }
+    close(perf_fds[1]);
+    rt_sem_release(&perf_done);
+}
+
+static void perf_dd_cat(const char *name, rt_size_t block)
+{
+    int i, ret;
+    char *buf;
+    rt_size_t len, k;
+    rt_size_t received = 0;
+    rt_uint64_t start;
+    rt_thread_t tid;
+    struct perf_stat stat;
+
+    buf = (char *)rt_malloc(PERF_READ_SIZE);
+    uassert_not_null(buf);
+    uassert_int_equal(pipe(perf_fds), 0);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+
+    perf_block = block;
+    perf_size = (PERF_WARMUP + PERF_ITERATIONS) * block;
+    tid = perf_thread_create("p_dd", dd_entry, RT_NULL, -1);
+    uassert_not_null(tid);
+    perf_failed = 0;
+    rt_thread_startup(tid);
+
+    for (i = 0; i < PERF_WARMUP + PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        for (len = 0; len < block; len += ret)
+        {
+            ret = read(perf_fds[0], buf + len, block - len);
+            if (ret <= 0)
+            {
+                break;
+            }
+        }
+        if (len != block)
+        {
+            perf_failed++;
+            break;
+        }
+        if (i >= PERF_WARMUP)
+        {
+            perf_stat_add(&stat, perf_clock() - start);
+        }
+
+        for (k = 0; k < block; k++)
+        {
+            if (buf[k] != PERF_PATTERN(received + k))
+            {
+                break;
+            }
+        }
+        if (k != block)
+        {
+            perf_failed++;
+            break;
+        }
+        received += block;
+    }
+
+    /* the writer has closed its end, so the end of file is seen */
+    rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+    uassert_int_equal(read(perf_fds[0], buf, PERF_READ_SIZE), 0);
+    close(perf_fds[0]);
+    rt_free(buf);
+    uassert_int_equal(perf_failed, 0);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_dd_cat_512(void)
+{
+    perf_dd_cat("pipe.dd_cat.bs_512", 512);
+}
+
+static void test_dd_cat_1000(void)
+{
+    /* not a divisor of the page, the blocks straddle the pages of the ring */
+    perf_dd_cat("pipe.dd_cat.bs_1000", 1000);
+}
+
+static void test_dd_cat_4k(void)
+{
+    perf_dd_cat("pipe.dd_cat.bs_4k", 4096);
+}
+
+static void test_dd_cat_64k(void)
+{
+    perf_dd_cat("pipe.dd_cat.bs_64k", 65536);
+}
+
+#ifdef RT_USING_POSIX_PIPE_PAGE
+static void *pipe_page_create(rt_size_t from)
+{
+    char *page;
+    rt_size_t i;
+
+    page = (char *)rt_pages_alloc(0);
+    if (page != RT_NULL)
+    {
+        for (i = 0; i < ARCH_PAGE_SIZE; i++)
+        {
+            page[i] = PERF_PATTERN(from + i);
+        }
+    }
+    return page;
+}
+
+static int pipe_check(int fd, rt_size_t from, rt_size_t size)
+{
+    char buf[256];
+    rt_size_t i, len;
+    int ret;
+
+    for (len = 0; len < size; len += ret)
+    {
+        ret = read(fd, buf, size - len < sizeof(buf) ? size - len : sizeof(buf));
+        if (ret <= 0)
+        {
+            return -1;
+        }
+        for (i = 0; i < (rt_size_t)ret; i++)
+        {
+            if (buf[i] != PERF_PATTERN(from + len + i))
+            {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* the pages put by rt_pipe_put_page(), as vmsplice() gifts the user pages */
+static void test_put_page(void)
+{
+    int fds[2];
+    char buf[512];
+    void *page;
+    rt_size_t i, nr;
+    int ret;
+
+    for (i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = PERF_PATTERN(i);
+    }
+    uassert_int_equal(pipe(fds), 0);
+
+    /* a partial page, a gifted page and the data after it keep their order */
+    uassert_int_equal(write(fds[1], buf, 100), 100);
+    page = pipe_page_create(100);
+    uassert_not_null(page);
+    uassert_int_equal(rt_pipe_put_page(fds[1], page, 3000), 3000);
+    /* the gifted page is not appended, the write takes a new page */
+    uassert_int_equal(write(fds[1], buf + (3100 & 0xff), 200), 200);
+    uassert_int_equal(pipe_check(fds[0], 0, 3300), 0);
+
+    /* the page is not taken over on errors */
+    page = pipe_page_create(0);
+    uassert_not_null(page);
+    uassert_int_equal(rt_pipe_put_page(fds[1], page, 0), -EINVAL);
+    uassert_int_equal(rt_pipe_put_page(fds[1], page, ARCH_PAGE_SIZE + 1), -EINVAL);
+    uassert_int_equal(rt_pipe_put_page(fds[0], page, ARCH_PAGE_SIZE), -EBADF);
+
+    /* a full pipe is not waited for with O_NONBLOCK */
+    uassert_int_equal(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+    for (nr = 0; ; nr++)
+    {
+        ret = rt_pipe_put_page(fds[1], page, ARCH_PAGE_SIZE);
+        if (ret != ARCH_PAGE_SIZE)
+        {
+            break;
+        }
+        page = pipe_page_create((nr + 1) * ARCH_PAGE_SIZE);
+        if (page == RT_NULL)
+        {
+            break;
+        }
+    }
+    uassert_int_equal(ret, -EAGAIN);
+    uassert_int_equal(nr, RT_USING_POSIX_PIPE_SIZE / ARCH_PAGE_SIZE);
+    if (page != RT_NULL)
+    {
+        rt_pages_free(page, 0);
+    }
+    uassert_int_equal(write(fds[1], buf, 1), -1);
+    uassert_int_equal(pipe_check(fds[0], 0, nr * ARCH_PAGE_SIZE), 0);
+
+    close(fds[1]);
+    uassert_int_equal(read(fds[0], buf, sizeof(buf)), 0);
+    close(fds[0]);
+}
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+
+static rt_err_t utest_tc_init(void)
+{
+    rt_sem_init(&perf_done, "p_done", 0, RT_IPC_FLAG_PRIO);
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    rt_sem_detach(&perf_done);
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+#ifdef RT_USING_POSIX_PIPE_PAGE
+    UTEST_UNIT_RUN(test_put_page);
+#endif /* RT_USING_POSIX_PIPE_PAGE */
+    UTEST_UNIT_RUN(test_dd_cat_512);
+    UTEST_UNIT_RUN(test_dd_cat_1000);
+    UTEST_UNIT_RUN(test_dd_cat_4k);
+    UTEST_UNIT_RUN(test_dd_cat_64k);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.pipe_tc", utest_tc_init, utest_tc_cleanup, 60);
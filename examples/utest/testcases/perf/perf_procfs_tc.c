@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <dfs_fs.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "perf_common.h"
+
+/*
+ * A collector reads the files of procfs every second, either by opening the
+ * file each time or by keeping it opened and reading it again from the
+ * offset 0. Both ways are measured for each file, a file not enabled in the
+ * configuration is skipped.
+ */
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_PROCFS_PATH        UTEST_PERF_PROCFS_PATH
+#define PERF_BUF_SIZE           4096
+
+static const char *const perf_files[] =
+{
+    "meminfo",
+    "uptime",
+    "stat",
+    "interrupts",
+    "slabinfo",
+    "buddyinfo",
+    "net/dev",
+};
+
+static char perf_buf[PERF_BUF_SIZE];
+static rt_bool_t perf_mounted;
+
+/* read the whole file, return the length */
+static int perf_read_all(int fd)
+{
+    int ret, len = 0;
+
+    while ((ret = read(fd, perf_buf, sizeof(perf_buf))) > 0)
+    {
+        len += ret;
+    }
+
+    return ret < 0 ? ret : len;
+}
+
+static void perf_procfs_file(const char *file)
+{
+    int i, fd, len;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    char path[64];
+    char name[48];
+
+    rt_snprintf(path, sizeof(path), "%s/%s", PERF_PROCFS_PATH, file);
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        rt_kprintf("perf: %s is not enabled, skipped\n", path);
+        return;
+    }
+    len = perf_read_all(fd);
+    close(fd);
+    uassert_true(len > 0);
+    rt_kprintf("perf: %s is %d bytes\n", path, len);
+
+    /* open, read and close each time */
+    rt_snprintf(name, sizeof(name), "procfs.open_read.%s", file);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            break;
+        }
+        len = perf_read_all(fd);
+        close(fd);
+        perf_stat_add(&stat, perf_clock() - start);
+        if (len <= 0)
+        {
+            break;
+        }
+    }
+    uassert_int_equal(i, PERF_ITERATIONS);
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+
+    /* keep the file opened, and read it again from the start */
+    rt_snprintf(name, sizeof(name), "procfs.lseek_read.%s", file);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS, 1), RT_EOK);
+    fd = open(path, O_RDONLY);
+    uassert_true(fd >= 0);
+    for (i = 0; fd >= 0 && i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        lseek(fd, 0, SEEK_SET);
+        len = perf_read_all(fd);
+        perf_stat_add(&stat, perf_clock() - start);
+        if (len <= 0)
+        {
+            break;
+        }
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    uassert_int_equal(i, PERF_ITERATIONS);
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_procfs_read(void)
+{
+    int i;
+
+    for (i = 0; i < sizeof(perf_files) / sizeof(perf_files[0]); i++)
+    {
+        perf_procfs_file(perf_files[i]);
+    }
+}
+
+static void test_procfs_write(void)
+{
+    char path[64];
+
+    /* the files are read only */
+    rt_snprintf(path, sizeof(path), "%s/meminfo", PERF_PROCFS_PATH);
+    uassert_true(open(path, O_WRONLY) < 0);
+    rt_snprintf(path, sizeof(path), "%s/no_such_file", PERF_PROCFS_PATH);
+    uassert_true(open(path, O_RDONLY) < 0);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    struct stat st;
+    char path[64];
+
+    rt_snprintf(path, sizeof(path), "%s/meminfo", PERF_PROCFS_PATH);
+    if (stat(path, &st) == 0)
+    {
+        return RT_EOK;
+    }
+
+    mkdir(PERF_PROCFS_PATH, 0777);
+    if (dfs_mount(RT_NULL, PERF_PROCFS_PATH, "procfs", 0, 0) != 0)
+    {
+        rt_kprintf("perf: mount procfs on %s failed\n", PERF_PROCFS_PATH);
+        return -RT_ERROR;
+    }
+    perf_mounted = RT_TRUE;
+
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    if (perf_mounted)
+    {
+        dfs_unmount(PERF_PROCFS_PATH);
+        perf_mounted = RT_FALSE;
+    }
+
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_procfs_read);
+    UTEST_UNIT_RUN(test_procfs_write);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.procfs_tc", utest_tc_init, utest_tc_cleanup, 60);
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtatomic.h>
+#include "perf_common.h"
+#ifdef RT_USING_DFS
+#include <dfs_fs.h>
+#endif /* RT_USING_DFS */
+
+/*
+ * The lookup of a name in a list of PERF_NODES_NR nodes by the threads on
+ * 1 to RT_CPUS_NR cpus at the same time, with the list protected by a
+ * spinlock, by the scheduler lock like rt_object_find(), and by RCU. The
+ * ops_s is the total of all the cpus, which grows with the cpus only if the
+ * readers do not contend. The nodes are also replaced by a writer under the
+ * lookups of RCU, freed by rt_rcu_call(), to check that a lookup never
+ * misses a name or sees a freed node.
+ */
+
+#define PERF_ITERATIONS         UTEST_PERF_ITERATIONS
+#define PERF_LOOKUPS            16
+#define PERF_NODES_NR           16
+#define PERF_NODE_MAGIC         0x52435521
+#define PERF_SYNC_ITERATIONS    20
+
+enum perf_mode
+{
+    PERF_MODE_SPINLOCK,
+    PERF_MODE_CRITICAL,
+    PERF_MODE_RCU,
+#ifdef RT_USING_DFS
+    PERF_MODE_DFS,
+#endif /* RT_USING_DFS */
+    PERF_MODE_NR,
+};
+
+static const char *const perf_mode_names[] =
+{
+    "spinlock",
+    "critical",
+    "rcu",
+#ifdef RT_USING_DFS
+    "dfs_lookup",
+#endif /* RT_USING_DFS */
+};
+
+struct perf_node
+{
+    rt_list_t list;
+    char name[RT_NAME_MAX];
+    rt_uint32_t magic;
+    struct rt_rcu_head rcu;
+};
+
+static rt_list_t perf_list = RT_LIST_OBJECT_INIT(perf_list);
+static struct rt_spinlock perf_lock;
+static struct rt_semaphore perf_start;
+static struct rt_semaphore perf_done;
+static enum perf_mode perf_mode;
+static volatile int perf_stop;
+static int perf_failed;
+static rt_atomic_t perf_freed;
+
+static struct perf_node *perf_node_alloc(int index)
+{
+    struct perf_node *node;
+
+    node = (struct perf_node *)rt_malloc(sizeof(struct perf_node));
+    if (node != RT_NULL)
+    {
+        rt_snprintf(node->name, sizeof(node->name), "p_node%d", index);
+        node->magic = PERF_NODE_MAGIC;
+    }
+
+    return node;
+}
+
+static void perf_node_free(struct rt_rcu_head *head)
+{
+    struct perf_node *node = rt_container_of(head, struct perf_node, rcu);
+
+    /* a reader still on the node would see the magic cleared */
+    node->magic = 0;
+    rt_free(node);
+    rt_atomic_add(&perf_freed, 1);
+}
+
+/* find the node of the name, with the list protected as perf_mode */
+static struct perf_node *perf_lookup(const char *name)
+{
+    rt_base_t level;
+    struct perf_node *node, *found = RT_NULL;
+
+    switch (perf_mode)
+    {
+    case PERF_MODE_SPINLOCK:
+        level = rt_spin_lock_irqsave(&perf_lock);
+        rt_list_for_each_entry(node, &perf_list, list)
+        {
+            if (rt_strncmp(node->name, name, RT_NAME_MAX) == 0)
+            {
+                found = node;
+                break;
+            }
+        }
+        rt_spin_unlock_irqrestore(&perf_lock, level);
+        break;
+
+    case PERF_MODE_CRITICAL:
+        rt_enter_critical();
+        rt_list_for_each_entry(node, &perf_list, list)
+        {
+            if (rt_strncmp(node->name, name, RT_NAME_MAX) == 0)
+            {
+                found = node;
+                break;
+            }
+        }
+        rt_exit_critical();
+        break;
+
+    default:
+        rt_rcu_read_lock();
+        rt_list_for_each_entry_rcu(node, &perf_list, list)
+        {
+            if (rt_strncmp(node->name, name, RT_NAME_MAX) == 0)
+            {
+                if (node->magic != PERF_NODE_MAGIC)
+                {
+                    perf_failed++;
+                }
+                found = node;
+                break;
+            }
+        }
+        rt_rcu_read_unlock();
+        break;
+    }
+
+    return found;
+}
+
+static void lookup_entry(void *parameter)
+{
+    int i, j;
+    rt_uint64_t start;
+    struct perf_stat *stat = (struct perf_stat *)parameter;
+    char name[RT_NAME_MAX];
+
+    /* the last node is looked up, so every lookup walks the whole list */
+    rt_snprintf(name, sizeof(name), "p_node%d", PERF_NODES_NR - 1);
+    rt_sem_take(&perf_start, RT_WAITING_FOREVER);
+
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        for (j = 0; j < PERF_LOOKUPS; j++)
+        {
+#ifdef RT_USING_DFS
+            if (perf_mode == PERF_MODE_DFS)
+            {
+                if (dfs_filesystem_lookup("/") == RT_NULL)
+                {
+                    perf_failed++;
+                }
+                continue;
+            }
+#endif /* RT_USING_DFS */
+            if (perf_lookup(name) == RT_NULL)
+            {
+                perf_failed++;
+            }
+        }
+        perf_stat_add(stat, perf_clock() - start);
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void perf_lookup_cpus(enum perf_mode mode, int nr)
+{
+    int i;
+    rt_uint64_t start;
+    struct perf_stat stat;
+    rt_thread_t tids[RT_CPUS_NR];
+    char name[48];
+
+    rt_snprintf(name, sizeof(name), "rcu.%s.cpus_%d", perf_mode_names[mode], nr);
+    uassert_int_equal(perf_stat_init(&stat, name, PERF_ITERATIONS * nr, PERF_LOOKUPS), RT_EOK);
+
+    perf_mode = mode;
+    perf_failed = 0;
+    for (i = 0; i < nr; i++)
+    {
+        rt_snprintf(name, RT_NAME_MAX, "p_rcu%d", i);
+        tids[i] = perf_thread_create(name, lookup_entry, &stat, i);
+        uassert_not_null(tids[i]);
+    }
+
+    /* they block on perf_start until all of them are started */
+    for (i = 0; i < nr; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_thread_startup(tids[i]);
+        }
+    }
+    start = perf_clock();
+    for (i = 0; i < nr; i++)
+    {
+        rt_sem_release(&perf_start);
+    }
+    for (i = 0; i < nr; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+        }
+    }
+    stat.wall = perf_clock() - start;
+    uassert_int_equal(perf_failed, 0);
+
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+}
+
+static void test_lookup_scaling(void)
+{
+    int mode, nr;
+
+    for (mode = 0; mode < PERF_MODE_NR; mode++)
+    {
+#ifdef RT_USING_DFS
+        if (mode == PERF_MODE_DFS && dfs_filesystem_lookup("/") == RT_NULL)
+        {
+            rt_kprintf("perf: no root filesystem, dfs_lookup skipped\n");
+            continue;
+        }
+#endif /* RT_USING_DFS */
+        for (nr = 1; nr <= RT_CPUS_NR; nr++)
+        {
+            perf_lookup_cpus((enum perf_mode)mode, nr);
+        }
+    }
+}
+
+static void reader_entry(void *parameter)
+{
+    int i, passes = 0;
+    char name[RT_NAME_MAX];
+
+    while (!perf_stop)
+    {
+        for (i = 0; i < PERF_NODES_NR; i++)
+        {
+            rt_snprintf(name, sizeof(name), "p_node%d", i);
+            if (perf_lookup(name) == RT_NULL)
+            {
+                perf_failed++;
+            }
+        }
+
+        /* leave the cpu to the writer and the rcu thread now and then */
+        if (++passes % 64 == 0)
+        {
+            rt_thread_delay(1);
+        }
+    }
+    rt_sem_release(&perf_done);
+}
+
+static void test_update(void)
+{
+    int i, replaced = 0;
+    rt_base_t level;
+    rt_uint64_t start;
+    rt_thread_t tids[RT_CPUS_NR];
+    struct perf_node *node, *old;
+    struct perf_stat stat;
+    char name[RT_NAME_MAX];
+
+    perf_mode = PERF_MODE_RCU;
+    perf_failed = 0;
+    perf_stop = 0;
+    rt_atomic_store(&perf_freed, 0);
+    for (i = 0; i < RT_CPUS_NR; i++)
+    {
+        rt_snprintf(name, sizeof(name), "p_rd%d", i);
+        tids[i] = perf_thread_create(name, reader_entry, RT_NULL, i);
+        uassert_not_null(tids[i]);
+        if (tids[i] != RT_NULL)
+        {
+            rt_thread_startup(tids[i]);
+        }
+    }
+
+    /* replace each node in place, the old one is freed after a grace period */
+    uassert_int_equal(perf_stat_init(&stat, "rcu.call", PERF_ITERATIONS, 1), RT_EOK);
+    for (i = 0; i < PERF_ITERATIONS; i++)
+    {
+        node = perf_node_alloc(i % PERF_NODES_NR);
+        if (node == RT_NULL)
+        {
+            break;
+        }
+
+        start = perf_clock();
+        level = rt_spin_lock_irqsave(&perf_lock);
+        rt_list_for_each_entry(old, &perf_list, list)
+        {
+            if (rt_strncmp(old->name, node->name, RT_NAME_MAX) == 0)
+            {
+                break;
+            }
+        }
+        rt_list_insert_before_rcu(&old->list, &node->list);
+        rt_list_remove_rcu(&old->list);
+        rt_spin_unlock_irqrestore(&perf_lock, level);
+        rt_rcu_call(&old->rcu, perf_node_free);
+        perf_stat_add(&stat, perf_clock() - start);
+        replaced++;
+
+        if (i % PERF_NODES_NR == 0)
+        {
+            rt_thread_yield();
+        }
+    }
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+
+    /* the grace period of a synchronous update, under the readers */
+    uassert_int_equal(perf_stat_init(&stat, "rcu.synchronize", PERF_SYNC_ITERATIONS, 1), RT_EOK);
+    for (i = 0; i < PERF_SYNC_ITERATIONS; i++)
+    {
+        start = perf_clock();
+        rt_rcu_synchronize();
+        perf_stat_add(&stat, perf_clock() - start);
+    }
+    perf_stat_report(&stat);
+    perf_stat_detach(&stat);
+
+    perf_stop = 1;
+    for (i = 0; i < RT_CPUS_NR; i++)
+    {
+        if (tids[i] != RT_NULL)
+        {
+            rt_sem_take(&perf_done, RT_WAITING_FOREVER);
+        }
+    }
+
+    rt_rcu_barrier();
+    uassert_int_equal(rt_atomic_load(&perf_freed), replaced);
+    uassert_int_equal(perf_failed, 0);
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    int i;
+    struct perf_node *node;
+
+    rt_spin_lock_init(&perf_lock);
+    rt_sem_init(&perf_start, "p_start", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&perf_done, "p_done", 0, RT_IPC_FLAG_PRIO);
+
+    for (i = 0; i < PERF_NODES_NR; i++)
+    {
+        node = perf_node_alloc(i);
+        if (node == RT_NULL)
+        {
+            return -RT_ENOMEM;
+        }
+        rt_list_insert_before_rcu(&perf_list, &node->list);
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    struct perf_node *node, *next;
+
+    rt_list_for_each_entry_safe(node, next, &perf_list, list)
+    {
+        rt_list_remove(&node->list);
+        rt_free(node);
+    }
+
+    rt_sem_detach(&perf_start);
+    rt_sem_detach(&perf_done);
+
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_lookup_scaling);
+    UTEST_UNIT_RUN(test_update);
+}
+UTEST_TC_EXPORT(testcase, "testcases.perf.rcu_tc", utest_tc_init, utest_tc_cleanup, 60);
@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * The benchmarks of the user space of RT-Smart, it is built by the toolchain
+ * of the userapps, and run by testcases.perf.lwp_tc or from the shell:
+ *
+ *   perf_lwp [all|syscall|fault|fork|exec|pipe] [iterations]
+ *
+ * The results are printed in the same format as the kernel benchmarks, but
+ * without cycles_op, since the time is measured by clock_gettime().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#define PERF_SYSCALL_BATCH      64
+#define PERF_FAULT_PAGES        64
+#define PERF_PAGE_SIZE          4096
+#define PERF_PIPE_BLOCK         65536
+
+/* the number of vmsplice in the syscall table of RT-Smart */
+#define PERF_SYS_VMSPLICE       184
+
+struct perf_stat
+{
+    const char *name;
+    unsigned int ops;
+    unsigned int count;
+    unsigned int size;
+    uint64_t *samples;
+};
+
+static uint64_t perf_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int perf_stat_init(struct perf_stat *stat, const char *name, unsigned int size, unsigned int ops)
+{
+    stat->name = name;
+    stat->ops = ops;
+    stat->count = 0;
+    stat->size = size;
+    stat->samples = malloc(size * sizeof(uint64_t));
+
+    return stat->samples != NULL ? 0 : -1;
+}
+
+static void perf_stat_add(struct perf_stat *stat, uint64_t ns)
+{
+    if (stat->count < stat->size)
+    {
+        stat->samples[stat->count++] = ns;
+    }
+}
+
+static int perf_sample_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static uint64_t perf_percentile_ns(struct perf_stat *stat, unsigned int percent)
+{
+    unsigned int index = (unsigned int)(((uint64_t)stat->count * percent + 99) / 100);
+
+    index = index > 0 ? index - 1 : 0;
+
+    return stat->samples[index] / stat->ops;
+}
+
+static void perf_stat_report(struct perf_stat *stat)
+{
+    unsigned int i;
+    uint64_t ops, total = 0;
+
+    if (stat->count == 0)
+    {
+        printf("perf: name=%s ops=0\n", stat->name);
+        free(stat->samples);
+        return;
+    }
+
+    for (i = 0; i < stat->count; i++)
+    {
+        total += stat->samples[i];
+    }
+    qsort(stat->samples, stat->count, sizeof(uint64_t), perf_sample_cmp);
+
+    ops = (uint64_t)stat->count * stat->ops;
+    printf("perf: name=%s ops=%llu ns_op=%llu ops_s=%llu "
+           "p50_ns=%llu p90_ns=%llu p99_ns=%llu max_ns=%llu\n",
+           stat->name, (unsigned long long)ops,
+           (unsigned long long)(total / ops),
+           (unsigned long long)(total ? ops * 1000000000ULL / total : 0),
+           (unsigned long long)perf_percentile_ns(stat, 50),
+           (unsigned long long)perf_percentile_ns(stat, 90),
+           (unsigned long long)perf_percentile_ns(stat, 99),
+           (unsigned long long)(stat->samples[stat->count - 1] / stat->ops));
+    fflush(stdout);
+
+    free(stat->samples);
+}
+
+/* the clock is read by a syscall as well, so the syscalls are timed in batches */
+static void perf_syscall(unsigned int iterations)
+{
+    unsigned int i, j;
+    uint64_t start;
+    struct perf_stat stat;
+
+    if (perf_stat_init(&stat, "lwp.syscall.getppid", iterations, PERF_SYSCALL_BATCH) != 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < iterations; i++)
+    {
+        start = perf_now_ns();
+        for (j = 0; j < PERF_SYSCALL_BATCH; j++)
+        {
+            /* getppid() is not cached by the libc */
+            (void)getppid();
+        }
+        perf_stat_add(&stat, perf_now_ns() - start);
+    }
+
+    perf_stat_report(&stat);
+}
+
+static void perf_fault(unsigned int iterations)
+{
+    unsigned int i, j;
+    uint64_t start;
+    volatile char *mem;
+    struct perf_stat stat;
+
+    if (perf_stat_init(&stat, "lwp.fault.anon", iterations, PERF_FAULT_PAGES) != 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < iterations; i++)
+    {
+        mem = mmap(NULL, PERF_FAULT_PAGES * PERF_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+        {
+            printf("perf_lwp: mmap failed\n");
+            break;
+        }
+
+        start = perf_now_ns();
+        for (j = 0; j < PERF_FAULT_PAGES; j++)
+        {
+            mem[j * PERF_PAGE_SIZE] = 1;
+        }
+        perf_stat_add(&stat, perf_now_ns() - start);
+
+        munmap((void *)mem, PERF_FAULT_PAGES * PERF_PAGE_SIZE);
+    }
+
+    perf_stat_report(&stat);
+}
+
+static void perf_fork(const char *self, unsigned int iterations, int exec)
+{
+    unsigned int i;
+    pid_t pid;
+    int status;
+    uint64_t start;
+    struct perf_stat stat;
+    char *const argv[] = {(char *)self, "exit", NULL};
+
+    if (perf_stat_init(&stat, exec ? "lwp.fork_exec_wait" : "lwp.fork_wait", iterations, 1) != 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < iterations; i++)
+    {
+        start = perf_now_ns();
+        pid = fork();
+        if (pid == 0)
+        {
+            if (exec)
+            {
+                execv(self, argv);
+            }
+            _exit(0);
+        }
+        else if (pid < 0)
+        {
+            printf("perf_lwp: fork failed\n");
+            break;
+        }
+
+        waitpid(pid, &status, 0);
+        perf_stat_add(&stat, perf_now_ns() - start);
+    }
+
+    perf_stat_report(&stat);
+}
+
+/*
+ * The data vmspliced to a child process is read out as it is, the range starts
+ * and ends in the middle of a page, so it is copied, gifted by whole pages and
+ * copied again. The pages are not touched until the child has read them.
+ */
+static int perf_pipe_check(void)
+{
+    int fds[2];
+    pid_t pid;
+    int status = -1;
+    char *buf;
+    size_t i, len, sent;
+    ssize_t ret;
+    struct iovec iov;
+
+    len = PERF_PAGE_SIZE * 3;
+    buf = mmap(NULL, PERF_PAGE_SIZE * 4, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED || pipe(fds) != 0)
+    {
+        printf("perf_lwp: pipe setup failed\n");
+        return -1;
+    }
+    for (i = 0; i < PERF_PAGE_SIZE * 4; i++)
+    {
+        buf[i] = (char)(i * 7);
+    }
+
+    pid = fork();
+    if (pid == 0)
+    {
+        char rbuf[512];
+        size_t recv = 0;
+
+        close(fds[1]);
+        while ((ret = read(fds[0], rbuf, sizeof(rbuf))) > 0)
+        {
+            for (i = 0; i < (size_t)ret; i++)
+            {
+                if (recv + i >= len || rbuf[i] != buf[100 + recv + i])
+                {
+                    _exit(1);
+                }
+            }
+            recv += ret;
+        }
+        _exit(recv == len ? 0 : 1);
+    }
+    close(fds[0]);
+
+    for (sent = 0; pid > 0 && sent < len; sent += ret)
+    {
+        iov.iov_base = buf + 100 + sent;
+        iov.iov_len = len - sent;
+        ret = syscall(PERF_SYS_VMSPLICE, fds[1], &iov, 1, 0);
+        if (ret <= 0)
+        {
+            break;
+        }
+    }
+    close(fds[1]);
+    if (pid > 0)
+    {
+        waitpid(pid, &status, 0);
+    }
+    munmap(buf, PERF_PAGE_SIZE * 4);
+
+    if (sent != len || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        printf("perf_lwp: vmsplice check failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* `dd bs=64k | cat` to a child process, the blocks are written or vmspliced */
+static void perf_pipe(unsigned int iterations, int splice)
+{
+    unsigned int i;
+    int fds[2];
+    pid_t pid;
+    int status;
+    char *buf;
+    ssize_t ret;
+    size_t sent;
+    uint64_t start;
+    struct iovec iov;
+    struct perf_stat stat;
+
+    if (perf_stat_init(&stat, splice ? "lwp.pipe.vmsplice_64k" : "lwp.pipe.write_64k", iterations, 1) != 0)
+    {
+        return;
+    }
+
+    /* page aligned, so the whole pages can be spliced */
+    buf = mmap(NULL, PERF_PIPE_BLOCK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED || pipe(fds) != 0)
+    {
+        printf("perf_lwp: pipe setup failed\n");
+        free(stat.samples);
+        return;
+    }
+    memset(buf, 0xa5, PERF_PIPE_BLOCK);
+
+    pid = fork();
+    if (pid == 0)
+    {
+        close(fds[1]);
+        while (read(fds[0], buf, PERF_PIPE_BLOCK) > 0)
+        {
+        }
+        _exit(0);
+    }
+    close(fds[0]);
+
+    for (i = 0; pid > 0 && i < iterations; i++)
+    {
+        start = perf_now_ns();
+        for (sent = 0; sent < PERF_PIPE_BLOCK; sent += ret)
+        {
+            if (splice)
+            {
+                iov.iov_base = buf + sent;
+                iov.iov_len = PERF_PIPE_BLOCK - sent;
+                ret = syscall(PERF_SYS_VMSPLICE, fds[1], &iov, 1, 0);
+            }
+            else
+            {
+                ret = write(fds[1], buf + sent, PERF_PIPE_BLOCK - sent);
+            }
+            if (ret <= 0)
+            {
+                break;
+            }
+        }
+        if (sent != PERF_PIPE_BLOCK)
+        {
+            printf("perf_lwp: %s failed\n", splice ? "vmsplice" : "write");
+            break;
+        }
+        perf_stat_add(&stat, perf_now_ns() - start);
+    }
+
+    close(fds[1]);
+    if (pid > 0)
+    {
+        waitpid(pid, &status, 0);
+    }
+    munmap(buf, PERF_PIPE_BLOCK);
+
+    perf_stat_report(&stat);
+}
+
+int main(int argc, char **argv)
+{
+    const char *test = argc > 1 ? argv[1] : "all";
+    unsigned int iterations = argc > 2 ? (unsigned int)atoi(argv[2]) : 1000;
+    int all = strcmp(test, "all") == 0;
+
+    /* the program exec'ed by the benchmark of fork/exec */
+    if (strcmp(test, "exit") == 0)
+    {
+        return 0;
+    }
+
+    if (iterations == 0)
+    {
+        iterations = 1;
+    }
+
+    if (all || strcmp(test, "syscall") == 0)
+    {
+        perf_syscall(iterations);
+    }
+    if (all || strcmp(test, "fault") == 0)
+    {
+        perf_fault(iterations);
+    }
+    /* a fork takes much longer than the others, take fewer samples */
+    if (all || strcmp(test, "fork") == 0)
+    {
+        perf_fork(argv[0], iterations / 10 + 1, 0);
+    }
+    if (all || strcmp(test, "exec") == 0)
+    {
+        perf_fork(argv[0], iterations / 10 + 1, 1);
+    }
+    if (all || strcmp(test, "pipe") == 0)
+    {
+        perf_pipe(iterations, 0);
+        if (perf_pipe_check() != 0)
+        {
+            return 1;
+        }
+        perf_pipe(iterations, 1);
+    }
+
+    return 0;
+}
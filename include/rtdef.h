@@ -663,6 +663,7 @@ enum
 #define RT_THREAD_CTRL_CHANGE_PRIORITY  0x02                /**< Change thread priority. */
 #define RT_THREAD_CTRL_INFO             0x03                /**< Get thread information. */
 #define RT_THREAD_CTRL_BIND_CPU         0x04                /**< Set thread bind cpu. */
+#define RT_THREAD_CTRL_SET_AFFINITY     0x05                /**< Set the mask of cpus thread could run on. */
 
 #ifdef RT_USING_SMP
 
@@ -677,6 +678,25 @@ enum
 #define RT_STOP_IPI                     1
 #endif /* RT_STOP_IPI */
 
+#ifndef RT_SMP_CALL_IPI
+#define RT_SMP_CALL_IPI                 2
+#endif /* RT_SMP_CALL_IPI */
+
+typedef void (*rt_smp_call_func_t)(void *data);
+
+/**
+ * The request of calling a function on other CPUs, queued to each target
+ * CPU and served by the IPI of RT_SMP_CALL_IPI.
+ */
+struct rt_smp_call_req
+{
+    rt_smp_call_func_t func;
+    void *data;
+
+    rt_atomic_t pending;                                /**< the number of CPUs not done yet */
+    struct rt_smp_call_req *next[RT_CPUS_NR];           /**< the link in the queue of each CPU */
+};
+
 /**
  * CPUs definitions
  *
@@ -687,6 +707,7 @@ struct rt_cpu
 
     rt_uint16_t irq_nest;
     rt_uint8_t  irq_switch_flag;
+    rt_uint8_t  critical_switch_flag;                   /**< a switch is delayed by the scheduler lock */
 
     rt_uint8_t current_priority;
     rt_list_t priority_table[RT_THREAD_PRIORITY_MAX];
@@ -704,6 +725,93 @@ struct rt_cpu
 
 struct rt_thread;
 
+#ifdef RT_USING_RCU
+/**
+ * The callback of RCU, called after a grace period by rt_rcu_call(). It is
+ * embedded in the data to free, which is got by rt_container_of().
+ */
+struct rt_rcu_head
+{
+    struct rt_rcu_head *next;
+    void (*func)(struct rt_rcu_head *head);
+};
+#endif /* RT_USING_RCU */
+
+#ifdef RT_USING_CPU_USAGE
+/**
+ * CPU time statistics, in cpu usage clock
+ */
+struct rt_cpu_usage
+{
+    rt_uint64_t user;                                   /**< time running threads in user mode */
+    rt_uint64_t system;                                 /**< time running threads in kernel mode */
+    rt_uint64_t irq;                                    /**< time serving interrupts */
+    rt_uint64_t idle;                                   /**< time running the idle thread */
+};
+#endif /* RT_USING_CPU_USAGE */
+
+#ifdef RT_USING_SCHED_DEADLINE
+#define RT_SCHED_DEADLINE_PRIORITY      0                   /**< priority level of deadline threads */
+#define RT_SCHED_DEADLINE_BW_SHIFT      20                  /**< fixed point shift of bandwidth */
+
+/**
+ * Deadline scheduling entity of thread, in ticks
+ */
+struct rt_thread_deadline
+{
+    rt_tick_t   runtime;                                /**< runtime budget of each period, 0 if not deadline thread */
+    rt_tick_t   deadline;                               /**< relative deadline from the start of period */
+    rt_tick_t   period;                                 /**< period */
+
+    rt_tick_t   abs_deadline;                           /**< absolute deadline of current job */
+    rt_tick_t   runtime_left;                           /**< runtime budget left of current job */
+    rt_uint32_t bw;                                     /**< reserved bandwidth, runtime / period */
+    rt_uint8_t  cpu;                                    /**< cpu the bandwidth is reserved on */
+    rt_uint8_t  throttled;                              /**< waiting for the replenishment */
+    rt_uint8_t  priority;                               /**< priority before entering deadline class */
+#ifdef RT_USING_SMP
+    rt_ubase_t  cpu_affinity;                           /**< cpu affinity before entering deadline class */
+#endif /* RT_USING_SMP */
+
+    struct rt_timer timer;                              /**< replenishment timer */
+};
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+#define RT_SCHED_GROUP_SHARES_DEFAULT   1024                /**< shares of a group by default */
+#define RT_SCHED_GROUP_DEPTH_MAX        8                   /**< max levels of the group hierarchy */
+
+/**
+ * Scheduling group, the threads of the same priority are served in the order
+ * of the virtual runtime of their groups, and a group with the quota is
+ * throttled if it runs out of the quota in a period.
+ */
+struct rt_sched_group
+{
+    char        name[RT_NAME_MAX];                      /**< name of group */
+    struct rt_sched_group *parent;                      /**< parent group */
+    rt_list_t   list;                                   /**< node in the list of all groups */
+
+    rt_uint32_t shares;                                 /**< weight relative to the sibling groups */
+    rt_uint16_t depth;                                  /**< level in the hierarchy, 0 for the root */
+    rt_uint16_t ref;                                    /**< threads, processes and child groups refer to it */
+
+    rt_uint64_t vruntime;                               /**< cpu time weighted by the shares */
+    rt_uint64_t min_vruntime;                           /**< floor of the virtual runtime of child groups */
+
+    rt_tick_t   quota;                                  /**< cpu time allowed in each period, 0 for unlimited */
+    rt_tick_t   period;                                 /**< period of the quota */
+    rt_tick_t   runtime;                                /**< cpu time used in current period */
+    rt_uint8_t  throttled;                              /**< out of the quota in current period */
+    rt_uint32_t nr_throttled;                           /**< number of periods throttled */
+    rt_uint64_t usage;                                  /**< total cpu time, in ticks */
+
+    rt_list_t   throttled_threads;                      /**< threads parked until the next period */
+    struct rt_timer timer;                              /**< period timer */
+};
+typedef struct rt_sched_group *rt_sched_group_t;
+#endif /* RT_USING_SCHED_GROUP */
+
 #ifdef RT_USING_SMART
 typedef rt_err_t (*rt_wakeup_func_t)(void *object, struct rt_thread *thread);
 
@@ -774,6 +882,8 @@ struct rt_thread
     rt_uint16_t scheduler_lock_nest;                    /**< scheduler lock count */
     rt_uint16_t cpus_lock_nest;                         /**< cpus lock count */
     rt_uint16_t critical_lock_nest;                     /**< critical lock count */
+
+    rt_ubase_t  cpu_affinity;                           /**< mask of cpus thread could run on */
 #endif /*RT_USING_SMP*/
 
     /* priority */
@@ -816,9 +926,18 @@ struct rt_thread
     rt_ubase_t  remaining_tick;                         /**< remaining tick */
 
 #ifdef RT_USING_CPU_USAGE
-    rt_uint64_t  duration_tick;                         /**< cpu usage tick */
+    rt_uint64_t  user_time;                             /**< cpu time in user mode, in cpu usage clock */
+    rt_uint64_t  system_time;                           /**< cpu time in kernel mode, in cpu usage clock */
 #endif /* RT_USING_CPU_USAGE */
 
+#ifdef RT_USING_SCHED_DEADLINE
+    struct rt_thread_deadline dl;                       /**< deadline scheduling entity */
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    struct rt_sched_group *sgroup;                      /**< scheduling group, RT_NULL for the kernel group */
+#endif /* RT_USING_SCHED_GROUP */
+
 #ifdef RT_USING_PTHREADS
     void  *pthread_data;                                /**< the handle of pthread data, adapt 32/64bit */
 #endif /* RT_USING_PTHREADS */
@@ -924,6 +1043,12 @@ struct rt_mutex
 
     struct rt_thread    *owner;                         /**< current owner of mutex */
     rt_list_t            taken_list;                    /**< the object list taken by thread */
+
+#ifdef RT_USING_MUTEX_STAT
+    rt_uint32_t          contended;                     /**< times the mutex is found taken by another thread */
+    rt_uint32_t          spun;                          /**< times the mutex is taken after spinning */
+    rt_uint32_t          slept;                         /**< times the taker is suspended */
+#endif /* RT_USING_MUTEX_STAT */
 };
 typedef struct rt_mutex *rt_mutex_t;
 #endif /* RT_USING_MUTEX */
@@ -1028,6 +1153,17 @@ typedef rt_mem_t rt_smem_t;
 
 #ifdef RT_USING_SLAB
 typedef rt_mem_t rt_slab_t;
+
+/**
+ * slab usage of a chunk size
+ */
+struct rt_slab_info
+{
+    rt_uint32_t chunk_size;                             /**< bytes of a chunk */
+    rt_uint32_t zones;                                  /**< zones of the chunk size */
+    rt_uint32_t chunks;                                 /**< chunks in the zones */
+    rt_uint32_t inuse;                                  /**< chunks allocated */
+};
 #endif /* RT_USING_SLAB */
 
 #ifdef RT_USING_MEMHEAP
@@ -1229,6 +1365,8 @@ struct rt_channel
     rt_wqueue_t reader_queue;                           /**< channel poll queue */
     rt_uint8_t  stat;                                   /**< the status of this channel */
     rt_ubase_t  ref;
+    void       *msg_slots;                              /**< the message slots of this channel */
+    void       *msg_free;                               /**< the free message slots */
 };
 typedef struct rt_channel *rt_channel_t;
 #endif
@@ -174,6 +174,11 @@ void rt_hw_spin_unlock(rt_hw_spinlock_t *lock);
 
 int rt_hw_cpu_id(void);
 
+#ifndef rt_hw_cpu_relax
+/* the busy-waiting loops read the memory again on each iteration */
+#define rt_hw_cpu_relax()       __asm__ volatile ("" ::: "memory")
+#endif /* rt_hw_cpu_relax */
+
 extern rt_hw_spinlock_t _cpus_lock;
 extern rt_hw_spinlock_t _rt_critical_lock;
 
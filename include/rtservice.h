@@ -33,6 +33,23 @@ extern "C" {
 #define rt_container_of(ptr, type, member) \
     ((type *)((char *)(ptr) - (unsigned long)(&((type *)0)->member)))
 
+/**
+ * rt_rcu_assign_pointer - publish a pointer to the RCU readers, the
+ * initialization of the pointed data is visible before the pointer.
+ * rt_rcu_dereference - load a pointer published by rt_rcu_assign_pointer()
+ * in a read-side critical section.
+ *
+ * The toolchains without the atomic builtins are only used on uniprocessor,
+ * where the ordering of the compiler is enough.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define rt_rcu_assign_pointer(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#define rt_rcu_dereference(p)       __atomic_load_n(&(p), __ATOMIC_CONSUME)
+#else
+#define rt_rcu_assign_pointer(p, v) (*(void * volatile *)&(p) = (void *)(v))
+#define rt_rcu_dereference(p)       (p)
+#endif
+
 
 /**
  * @brief initialize a list object
@@ -91,6 +108,50 @@ rt_inline void rt_list_remove(rt_list_t *n)
     n->next = n->prev = n;
 }
 
+/**
+ * @brief insert a node after a list, the readers of RCU may walk the list
+ *        at the same time. The writers are serialized by the caller.
+ *
+ * @param l list to insert it
+ * @param n new node to be inserted
+ */
+rt_inline void rt_list_insert_after_rcu(rt_list_t *l, rt_list_t *n)
+{
+    n->next = l->next;
+    n->prev = l;
+    l->next->prev = n;
+
+    rt_rcu_assign_pointer(l->next, n);
+}
+
+/**
+ * @brief insert a node before a list, the readers of RCU may walk the list
+ *        at the same time. The writers are serialized by the caller.
+ *
+ * @param n new node to be inserted
+ * @param l list to insert it
+ */
+rt_inline void rt_list_insert_before_rcu(rt_list_t *l, rt_list_t *n)
+{
+    n->next = l;
+    n->prev = l->prev;
+
+    rt_rcu_assign_pointer(l->prev->next, n);
+    l->prev = n;
+}
+
+/**
+ * @brief remove node from list, the readers of RCU may walk the list at the
+ *        same time. The next of the node is kept for the readers on it, so
+ *        the node is reused or freed only after a grace period.
+ * @param n the node to remove from the list.
+ */
+rt_inline void rt_list_remove_rcu(rt_list_t *n)
+{
+    n->next->prev = n->prev;
+    rt_rcu_assign_pointer(n->prev->next, n->next);
+}
+
 /**
  * @brief tests whether a list is empty
  * @param l the list to test.
@@ -155,6 +216,18 @@ rt_inline unsigned int rt_list_len(const rt_list_t *l)
          &pos->member != (head); \
          pos = rt_list_entry(pos->member.next, typeof(*pos), member))
 
+/**
+ * rt_list_for_each_entry_rcu - iterate over list of given type in a
+ * read-side critical section of RCU
+ * @param pos the type * to use as a loop cursor.
+ * @param head the head for your list.
+ * @param member the name of the list_struct within the struct.
+ */
+#define rt_list_for_each_entry_rcu(pos, head, member) \
+    for (pos = rt_list_entry(rt_rcu_dereference((head)->next), typeof(*pos), member); \
+         &pos->member != (head); \
+         pos = rt_list_entry(rt_rcu_dereference(pos->member.next), typeof(*pos), member))
+
 /**
  * rt_list_for_each_entry_safe - iterate over list of given type safe against removal of list entry
  * @param pos the type * to use as a loop cursor.
@@ -234,6 +307,46 @@ rt_inline rt_slist_t *rt_slist_remove(rt_slist_t *l, rt_slist_t *n)
     return l;
 }
 
+/**
+ * @brief append a node to the tail of a single list, the readers of RCU may
+ *        walk the list at the same time. The writers are serialized by the
+ *        caller.
+ */
+rt_inline void rt_slist_append_rcu(rt_slist_t *l, rt_slist_t *n)
+{
+    struct rt_slist_node *node;
+
+    node = l;
+    while (node->next) node = node->next;
+
+    n->next = RT_NULL;
+    rt_rcu_assign_pointer(node->next, n);
+}
+
+/**
+ * @brief remove a node from a single list, the readers of RCU may walk the
+ *        list at the same time. The next of the node is kept for the readers
+ *        on it, so the node is reused or freed only after a grace period.
+ */
+rt_inline rt_slist_t *rt_slist_remove_rcu(rt_slist_t *l, rt_slist_t *n)
+{
+    struct rt_slist_node *node = l;
+    while (node->next && node->next != n) node = node->next;
+
+    if (node->next != (rt_slist_t *)0) rt_rcu_assign_pointer(node->next, n->next);
+
+    return l;
+}
+
+/**
+ * @brief get the next node of a single list in a read-side critical section
+ *        of RCU.
+ */
+rt_inline rt_slist_t *rt_slist_next_rcu(rt_slist_t *n)
+{
+    return rt_rcu_dereference(n->next);
+}
+
 rt_inline rt_slist_t *rt_slist_first(rt_slist_t *l)
 {
     return l->next;
@@ -203,6 +203,7 @@ void rt_system_scheduler_start(void);
 void rt_schedule(void);
 void rt_schedule_insert_thread(struct rt_thread *thread);
 void rt_schedule_remove_thread(struct rt_thread *thread);
+rt_err_t rt_schedule_switch_to(struct rt_thread *to_thread);
 
 void rt_enter_critical(void);
 void rt_exit_critical(void);
@@ -210,6 +211,7 @@ rt_uint16_t rt_critical_level(void);
 
 #ifdef RT_USING_HOOK
 void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to));
+void (*rt_scheduler_gethook(void))(rt_thread_t from, rt_thread_t to);
 void rt_scheduler_switch_sethook(void (*hook)(struct rt_thread *tid));
 #endif
 
@@ -218,6 +220,74 @@ void rt_secondary_cpu_entry(void);
 void rt_scheduler_ipi_handler(int vector, void *param);
 #endif
 
+#ifdef RT_USING_SCHED_DEADLINE
+/*
+ * deadline scheduling class interface
+ */
+rt_err_t rt_thread_set_deadline(rt_thread_t thread, rt_tick_t runtime, rt_tick_t deadline, rt_tick_t period);
+rt_uint32_t rt_sched_deadline_bandwidth(int cpu);
+rt_bool_t rt_sched_deadline_preempt(struct rt_thread *current, struct rt_thread *thread);
+void rt_sched_deadline_enqueue(rt_list_t *queue, struct rt_thread *thread);
+void rt_sched_deadline_wakeup(struct rt_thread *thread);
+void rt_sched_deadline_tick(struct rt_thread *thread);
+void rt_sched_deadline_yield(struct rt_thread *thread);
+void rt_sched_deadline_exit(struct rt_thread *thread);
+#ifdef RT_USING_SMP
+rt_err_t rt_sched_deadline_affinity(struct rt_thread *thread, rt_ubase_t cpu_affinity);
+#endif /* RT_USING_SMP */
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+/*
+ * group scheduling interface
+ */
+rt_sched_group_t rt_sched_group_create(const char *name, rt_sched_group_t parent);
+rt_err_t rt_sched_group_delete(rt_sched_group_t group);
+rt_err_t rt_sched_group_delete_by_name(const char *name);
+rt_sched_group_t rt_sched_group_find(const char *name);
+rt_err_t rt_sched_group_set_shares(rt_sched_group_t group, rt_uint32_t shares);
+rt_err_t rt_sched_group_set_bandwidth(rt_sched_group_t group, rt_tick_t quota, rt_tick_t period);
+rt_err_t rt_sched_group_attach(rt_sched_group_t group, rt_thread_t thread);
+rt_sched_group_t rt_sched_group_get(rt_sched_group_t group);
+void rt_sched_group_put(rt_sched_group_t group);
+rt_bool_t rt_sched_group_before(struct rt_thread *thread, struct rt_thread *other);
+rt_bool_t rt_sched_group_throttled(struct rt_thread *thread);
+void rt_sched_group_park(struct rt_thread *thread);
+void rt_sched_group_wakeup(struct rt_thread *thread);
+rt_bool_t rt_sched_group_tick(struct rt_thread *thread);
+void rt_sched_group_exit(struct rt_thread *thread);
+#endif /* RT_USING_SCHED_GROUP */
+
+#ifdef RT_USING_RCU
+/*
+ * rcu interface
+ */
+void rt_rcu_read_lock(void);
+void rt_rcu_read_unlock(void);
+void rt_rcu_synchronize(void);
+void rt_rcu_call(struct rt_rcu_head *head, void (*func)(struct rt_rcu_head *head));
+void rt_rcu_barrier(void);
+void rt_rcu_quiescent(void);
+void rt_rcu_tick(void);
+void rt_rcu_init(void);
+#endif /* RT_USING_RCU */
+
+#ifdef RT_USING_CPU_USAGE
+/*
+ * cpu time accounting interface
+ */
+rt_uint64_t rt_cpu_usage_clock(void);
+rt_uint64_t rt_cpu_usage_clock_freq(void);
+rt_uint64_t rt_cpu_usage_to_ns(rt_uint64_t clock);
+void rt_cpu_usage_switch(struct rt_thread *to);
+void rt_cpu_usage_irq_enter(void);
+void rt_cpu_usage_irq_leave(void);
+void rt_cpu_usage_user_enter(void);
+void rt_cpu_usage_user_exit(void);
+rt_err_t rt_cpu_usage_get(int cpu, struct rt_cpu_usage *usage);
+void rt_thread_cpu_time(rt_thread_t thread, rt_uint64_t *utime, rt_uint64_t *stime);
+#endif /* RT_USING_CPU_USAGE */
+
 /**@}*/
 
 /**
@@ -340,6 +410,7 @@ void rt_slab_page_free(rt_slab_t m, void *addr, rt_size_t npages);
 void *rt_slab_alloc(rt_slab_t m, rt_size_t size);
 void *rt_slab_realloc(rt_slab_t m, void *ptr, rt_size_t size);
 void rt_slab_free(rt_slab_t m, void *ptr);
+rt_err_t rt_slab_get_info(rt_slab_t m, int index, struct rt_slab_info *info);
 #endif
 
 /**@}*/
@@ -597,6 +668,18 @@ void rt_cpus_unlock(rt_base_t level);
 struct rt_cpu *rt_cpu_self(void);
 struct rt_cpu *rt_cpu_index(int index);
 
+/*
+ * cross cpu function call service
+ */
+
+void rt_smp_call_req_init(struct rt_smp_call_req *req, rt_smp_call_func_t func, void *data);
+rt_err_t rt_smp_call_request(struct rt_smp_call_req *req, rt_ubase_t cpu_mask);
+rt_bool_t rt_smp_call_req_done(struct rt_smp_call_req *req);
+void rt_smp_call_req_wait(struct rt_smp_call_req *req);
+rt_err_t rt_smp_call_cpu(int cpu, rt_smp_call_func_t func, void *data);
+rt_err_t rt_smp_call_cpu_mask(rt_ubase_t cpu_mask, rt_smp_call_func_t func, void *data);
+void rt_smp_call_ipi_handler(int vector, void *param);
+
 #endif
 
 /*
@@ -65,6 +65,7 @@ struct rt_hw_exp_stack
 #define PSTATE_EL2 ((unsigned long)0x08)
 #define PSTATE_EL3 ((unsigned long)0x0c)
 
+struct rt_hw_exp_stack *rt_hw_trap_irq_regs(void);
 rt_ubase_t rt_hw_get_current_el(void);
 void rt_hw_set_elx_env(void);
 void rt_hw_set_current_vbar(rt_ubase_t addr);
@@ -13,6 +13,7 @@
 #include <rthw.h>
 #include <rtthread.h>
 #include <rtdevice.h>
+#include <cpuport.h>
 
 #ifdef RT_USING_SMP
 void rt_hw_spin_lock_init(rt_hw_spinlock_t *lock)
@@ -74,4 +75,26 @@ const char *rt_hw_cpu_arch(void)
     return "aarch64";
 }
 
+#ifdef RT_USING_CPU_USAGE
+/* use the virtual count of generic timer, which is synchronized in all cores */
+rt_uint64_t rt_cpu_usage_clock(void)
+{
+    rt_uint64_t cycles;
+
+    rt_hw_isb();
+    sysreg_read(cntvct_el0, cycles);
+
+    return cycles;
+}
+
+rt_uint64_t rt_cpu_usage_clock_freq(void)
+{
+    rt_uint64_t freq;
+
+    sysreg_read(cntfrq_el0, freq);
+
+    return freq;
+}
+#endif /* RT_USING_CPU_USAGE */
+
 /*@}*/
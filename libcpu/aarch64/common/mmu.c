@@ -340,6 +340,17 @@ void rt_hw_mmu_unmap(rt_aspace_t aspace, void *v_addr, size_t size)
     }
 }
 
+/* the range of more pages is invalidated as a whole */
+#define TLB_RANGE_PAGES_MAX 64
+
+#ifdef RT_USING_SMP
+/* the I bit of DAIF, in the level of rt_hw_local_irq_disable() */
+#define TLB_DAIF_IRQ_MASKED (1ul << 7)
+
+/* the user aspace in TTBR0 of each cpu, whose entries may be in its TLB */
+static rt_aspace_t _loaded_aspace[RT_CPUS_NR];
+#endif /* RT_USING_SMP */
+
 void rt_hw_aspace_switch(rt_aspace_t aspace)
 {
     if (aspace != &rt_kernel_space)
@@ -348,6 +359,12 @@ void rt_hw_aspace_switch(rt_aspace_t aspace)
         pgtbl = rt_kmem_v2p(pgtbl);
         rt_ubase_t tcr;
 
+#ifdef RT_USING_SMP
+        /* seen by the invalidation before this cpu walks the page table */
+        _loaded_aspace[rt_hw_cpu_id()] = aspace;
+        __asm__ volatile("dsb ish" ::: "memory");
+#endif /* RT_USING_SMP */
+
         __asm__ volatile("msr ttbr0_el1, %0" ::"r"(pgtbl) : "memory");
 
         __asm__ volatile("mrs %0, tcr_el1" : "=r"(tcr));
@@ -360,6 +377,140 @@ void rt_hw_aspace_switch(rt_aspace_t aspace)
     }
 }
 
+static void _tlb_invalidate_pages(void *start, rt_size_t npages, rt_bool_t local)
+{
+    rt_ubase_t arg = (rt_ubase_t)TLBI_ARG(start, 0);
+
+    if (local)
+    {
+        __asm__ volatile("dsb nshst" ::: "memory");
+        while (npages--)
+        {
+            __asm__ volatile("tlbi vaae1, %0" ::"r"(arg) : "memory");
+            arg++;
+        }
+        __asm__ volatile("dsb nsh\n"
+                         "isb" ::: "memory");
+    }
+    else
+    {
+        __asm__ volatile("dsb ishst" ::: "memory");
+        while (npages--)
+        {
+            __asm__ volatile("tlbi vaae1is, %0" ::"r"(arg) : "memory");
+            arg++;
+        }
+        __asm__ volatile("dsb ish\n"
+                         "isb" ::: "memory");
+    }
+}
+
+#ifdef RT_USING_SMP
+static void _tlb_invalidate_local(void *data)
+{
+    rt_hw_tlb_invalidate_all_local();
+}
+
+/**
+ * Invalidate the pages of a user aspace, interrupt must be disabled. Return
+ * RT_FALSE if the cpus of the aspace can not be told apart from the others.
+ */
+static rt_bool_t _tlb_invalidate_user(rt_aspace_t aspace, void *start,
+                                      rt_size_t npages, rt_base_t level)
+{
+    int cpu;
+    rt_ubase_t cpus = 0, self = 1ul << rt_hw_cpu_id();
+
+    /* the page table is updated before the loaded aspaces are checked */
+    __asm__ volatile("dsb ish" ::: "memory");
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (_loaded_aspace[cpu] == aspace)
+        {
+            cpus |= 1ul << cpu;
+        }
+    }
+
+    if (cpus == 0)
+    {
+        /* no TLB has any entry of it */
+    }
+    else if (cpus == self)
+    {
+        if (npages <= TLB_RANGE_PAGES_MAX)
+        {
+            _tlb_invalidate_pages(start, npages, RT_TRUE);
+        }
+        else
+        {
+            rt_hw_tlb_invalidate_all_local();
+        }
+    }
+    else if (npages <= TLB_RANGE_PAGES_MAX)
+    {
+        _tlb_invalidate_pages(start, npages, RT_FALSE);
+    }
+    else if (!(level & TLB_DAIF_IRQ_MASKED) && !rt_interrupt_get_nest())
+    {
+        /*
+         * a large range of an aspace running on some of the cpus, which is
+         * invalidated by them alone instead of all the TLBs of the system.
+         * The IPI is not sent with the interrupt disabled by the caller, who
+         * may hold a lock the target cpus are spinning on.
+         */
+        rt_smp_call_cpu_mask(cpus, _tlb_invalidate_local, RT_NULL);
+    }
+    else
+    {
+        return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+#endif /* RT_USING_SMP */
+
+void rt_hw_tlb_invalidate_range(rt_aspace_t aspace, void *start,
+                                size_t size, size_t stride)
+{
+    rt_size_t npages;
+    char *va = (char *)((rt_ubase_t)start & ~ARCH_PAGE_MASK);
+
+    npages = ((char *)start + size - va + ARCH_PAGE_MASK) >> ARCH_PAGE_SHIFT;
+
+#ifdef RT_USING_SMP
+    if (aspace != &rt_kernel_space)
+    {
+        rt_bool_t done;
+        rt_base_t level;
+
+        level = rt_hw_local_irq_disable();
+        done = _tlb_invalidate_user(aspace, va, npages, level);
+        rt_hw_local_irq_enable(level);
+
+        if (done)
+        {
+            return;
+        }
+    }
+#endif /* RT_USING_SMP */
+
+    /* the kernel space is shared by all the cpus */
+    if (npages <= TLB_RANGE_PAGES_MAX)
+    {
+        _tlb_invalidate_pages(va, npages, RT_FALSE);
+    }
+    else
+    {
+        rt_hw_tlb_invalidate_all();
+    }
+}
+
+void rt_hw_tlb_invalidate_aspace(rt_aspace_t aspace)
+{
+    rt_hw_tlb_invalidate_range(aspace, aspace->start, aspace->size, ARCH_PAGE_SIZE);
+}
+
 void rt_hw_mmu_ktbl_set(unsigned long tbl)
 {
 #ifdef RT_USING_SMART
@@ -0,0 +1,796 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef ARCH_ARMV8_PMU_PROFILER
+#include <stdlib.h>
+#include <string.h>
+
+#include <cpuport.h>
+#include <mmu.h>
+#include <pmu.h>
+
+#ifdef RT_USING_SMART
+#include <lwp.h>
+#include <lwp_arch.h>
+#endif
+
+#ifdef RT_USING_DFS
+#include <dfs_file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define PERF_SAMPLE_NR          ARCH_ARMV8_PMU_PROFILER_SAMPLES
+#define PERF_SAMPLE_DEPTH       ARCH_ARMV8_PMU_PROFILER_STACK_DEPTH
+#define PERF_STAT_THREADS_NR    ARCH_ARMV8_PMU_PROFILER_STAT_THREADS
+#define PERF_DEFAULT_PERIOD     1000000
+
+#ifdef RT_USING_SMP
+#define _perf_cpu_id()          rt_hw_cpu_id()
+#else
+#define _perf_cpu_id()          0
+#define rt_hw_local_irq_disable rt_hw_interrupt_disable
+#define rt_hw_local_irq_enable  rt_hw_interrupt_enable
+#endif
+
+/*
+ * One sample: the pc and the return addresses from the frame records,
+ * ip[0] is the leaf. The frames are from user space if user is set.
+ */
+struct perf_sample
+{
+    char name[RT_NAME_MAX];
+    rt_uint16_t depth;
+    rt_uint16_t user;
+    rt_ubase_t ip[PERF_SAMPLE_DEPTH];
+};
+
+struct perf_cpu_buffer
+{
+    rt_size_t count;
+    rt_size_t lost;
+    struct perf_sample *samples;
+};
+
+static struct perf_cpu_buffer perf_buffers[RT_CPUS_NR];
+static int perf_counter_idx = ARMV8_PMU_CYCLE_IDX;
+static rt_uint64_t perf_period = PERF_DEFAULT_PERIOD;
+static struct rt_mutex perf_lock;
+
+static void perf_on_each_cpu(void (*func)(void *), void *data)
+{
+#ifdef RT_USING_SMP
+    int cpu;
+    rt_thread_t self = rt_thread_self();
+    rt_ubase_t cpu_affinity = self->cpu_affinity;
+
+    /* migrate to every cpu to program the cpu local registers */
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        rt_thread_control(self, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)cpu);
+
+        func(data);
+    }
+
+    rt_thread_control(self, RT_THREAD_CTRL_SET_AFFINITY, (void *)cpu_affinity);
+#else
+    func(data);
+#endif /* RT_USING_SMP */
+}
+
+static rt_uint64_t perf_counter_reload_value(int idx)
+{
+    rt_uint64_t value = -perf_period;
+
+    return idx == ARMV8_PMU_CYCLE_IDX ? value : (value & RT_UINT32_MAX);
+}
+
+rt_inline rt_bool_t perf_kernel_frame_valid(rt_thread_t thread, rt_ubase_t fp)
+{
+    rt_ubase_t stack = (rt_ubase_t)thread->stack_addr;
+
+    return !(fp & 0x7) && fp >= stack && fp + 16 <= stack + thread->stack_size;
+}
+
+static int perf_kernel_unwind(rt_thread_t thread, rt_ubase_t fp, rt_ubase_t *ip, int max)
+{
+    int depth = 0;
+    rt_ubase_t prev_fp = 0;
+
+    while (depth < max && fp > prev_fp && perf_kernel_frame_valid(thread, fp))
+    {
+        ip[depth++] = ((rt_ubase_t *)fp)[1];
+
+        prev_fp = fp;
+        fp = ((rt_ubase_t *)fp)[0];
+    }
+
+    return depth;
+}
+
+#ifdef RT_USING_SMART
+rt_inline rt_bool_t perf_user_frame_valid(struct rt_lwp *lwp, rt_ubase_t fp)
+{
+    if ((fp & 0x7) || fp < USER_VADDR_START || fp + 16 > USER_VADDR_TOP)
+    {
+        return RT_FALSE;
+    }
+
+    /* never fault in interrupt, the frame record must be mapped */
+    if (rt_hw_mmu_v2p(lwp->aspace, (void *)fp) == ARCH_MAP_FAILED)
+    {
+        return RT_FALSE;
+    }
+
+    if (((fp + 15) & ~(rt_ubase_t)ARCH_PAGE_MASK) != (fp & ~(rt_ubase_t)ARCH_PAGE_MASK) &&
+        rt_hw_mmu_v2p(lwp->aspace, (void *)(fp + 15)) == ARCH_MAP_FAILED)
+    {
+        return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+
+static int perf_user_unwind(rt_thread_t thread, rt_ubase_t fp, rt_ubase_t *ip, int max)
+{
+    int depth = 0;
+    rt_ubase_t prev_fp = 0;
+    struct rt_lwp *lwp = thread->lwp;
+
+    if (!lwp || !lwp->aspace)
+    {
+        return 0;
+    }
+
+    /* interrupted from EL0, TTBR0 is the space of this lwp */
+    while (depth < max && fp > prev_fp && perf_user_frame_valid(lwp, fp))
+    {
+        ip[depth++] = ((rt_ubase_t *)fp)[1];
+
+        prev_fp = fp;
+        fp = ((rt_ubase_t *)fp)[0];
+    }
+
+    return depth;
+}
+#endif /* RT_USING_SMART */
+
+static void perf_overflow(rt_uint32_t overflow, struct rt_hw_exp_stack *regs)
+{
+    rt_thread_t thread;
+    struct perf_sample *sample;
+    struct perf_cpu_buffer *buffer = &perf_buffers[_perf_cpu_id()];
+
+    if (!(overflow & (1U << perf_counter_idx)))
+    {
+        return;
+    }
+
+    rt_hw_pmu_counter_write(perf_counter_idx, perf_counter_reload_value(perf_counter_idx));
+
+    if (!regs || !buffer->samples)
+    {
+        return;
+    }
+
+    if (buffer->count >= PERF_SAMPLE_NR)
+    {
+        ++buffer->lost;
+        return;
+    }
+
+    thread = rt_thread_self();
+    sample = &buffer->samples[buffer->count++];
+
+    sample->ip[0] = regs->pc;
+    sample->depth = 1;
+    sample->user = (regs->cpsr & 0x1f) == 0;
+
+    if (!thread)
+    {
+        rt_strncpy(sample->name, "-", RT_NAME_MAX);
+        return;
+    }
+
+    rt_strncpy(sample->name, thread->parent.name, RT_NAME_MAX);
+
+    if (sample->user)
+    {
+#ifdef RT_USING_SMART
+        sample->depth += perf_user_unwind(thread, regs->x29, &sample->ip[1], PERF_SAMPLE_DEPTH - 1);
+#endif
+    }
+    else
+    {
+        sample->depth += perf_kernel_unwind(thread, regs->x29, &sample->ip[1], PERF_SAMPLE_DEPTH - 1);
+    }
+}
+
+static void perf_record_start(void *data)
+{
+    int idx = perf_counter_idx;
+    rt_base_t level = rt_hw_local_irq_disable();
+
+    rt_hw_pmu_reset();
+
+    if (idx == ARMV8_PMU_CYCLE_IDX)
+    {
+        rt_hw_pmu_counter_config(idx, 0);
+    }
+    else
+    {
+        rt_hw_pmu_counter_config(idx, (rt_uint32_t)(rt_ubase_t)data);
+    }
+
+    rt_hw_pmu_counter_write(idx, perf_counter_reload_value(idx));
+    rt_hw_pmu_counter_irq_enable(idx, RT_TRUE);
+    rt_hw_pmu_counter_enable(idx, RT_TRUE);
+    rt_hw_pmu_start();
+
+    rt_hw_local_irq_enable(level);
+}
+
+static void perf_record_stop(void *data)
+{
+    rt_base_t level = rt_hw_local_irq_disable();
+
+    rt_hw_pmu_stop();
+    rt_hw_pmu_counter_enable(perf_counter_idx, RT_FALSE);
+    rt_hw_pmu_counter_irq_enable(perf_counter_idx, RT_FALSE);
+
+    rt_hw_local_irq_enable(level);
+}
+
+static rt_err_t perf_record(rt_uint32_t event, rt_uint64_t period, rt_int32_t ms)
+{
+    int cpu;
+    rt_err_t err;
+    rt_size_t total = 0, lost = 0;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        if (!perf_buffers[cpu].samples)
+        {
+            perf_buffers[cpu].samples = rt_malloc(sizeof(struct perf_sample) * PERF_SAMPLE_NR);
+
+            if (!perf_buffers[cpu].samples)
+            {
+                return -RT_ENOMEM;
+            }
+        }
+
+        perf_buffers[cpu].count = 0;
+        perf_buffers[cpu].lost = 0;
+    }
+
+    perf_period = period;
+    perf_counter_idx = event == ARMV8_PMU_EVT_CPU_CYCLES ? ARMV8_PMU_CYCLE_IDX : 0;
+
+    if ((err = rt_hw_pmu_set_overflow_handler(perf_overflow)))
+    {
+        return err;
+    }
+
+    perf_on_each_cpu(perf_record_start, (void *)(rt_ubase_t)event);
+
+    rt_thread_mdelay(ms);
+
+    perf_on_each_cpu(perf_record_stop, RT_NULL);
+
+    rt_hw_pmu_set_overflow_handler(RT_NULL);
+
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        rt_kprintf("cpu%d: %lu samples, %lu lost\n", cpu,
+                (rt_ubase_t)perf_buffers[cpu].count, (rt_ubase_t)perf_buffers[cpu].lost);
+
+        total += perf_buffers[cpu].count;
+        lost += perf_buffers[cpu].lost;
+    }
+    rt_kprintf("total: %lu samples, %lu lost, period %lu\n", (rt_ubase_t)total, (rt_ubase_t)lost, (rt_ubase_t)period);
+
+    return RT_EOK;
+}
+
+static rt_bool_t perf_sample_equal(struct perf_sample *a, struct perf_sample *b)
+{
+    return a->depth == b->depth && a->user == b->user &&
+            !rt_strncmp(a->name, b->name, RT_NAME_MAX) &&
+            !rt_memcmp(a->ip, b->ip, sizeof(a->ip[0]) * a->depth);
+}
+
+static void perf_report_output(int fd, const char *buf, int len)
+{
+#ifdef RT_USING_DFS
+    if (fd >= 0)
+    {
+        write(fd, buf, len);
+        return;
+    }
+#endif
+    rt_kputs(buf);
+}
+
+/*
+ * Folded stacks, one line of "thread;outermost;...;leaf count" per stack,
+ * kernel addresses are suffixed with "_[k]" and could be symbolized with
+ * addr2line before feeding into flamegraph.pl.
+ */
+static void perf_report(int fd)
+{
+    int cpu, i, len;
+    rt_size_t idx, count;
+    struct perf_sample *sample;
+    char line[RT_NAME_MAX + 24 * PERF_SAMPLE_DEPTH + 16];
+
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        if (!perf_buffers[cpu].samples)
+        {
+            continue;
+        }
+
+        for (idx = 0; idx < perf_buffers[cpu].count; idx += count)
+        {
+            sample = &perf_buffers[cpu].samples[idx];
+
+            /* merge the adjacent same stacks */
+            for (count = 1; idx + count < perf_buffers[cpu].count; ++count)
+            {
+                if (!perf_sample_equal(sample, &perf_buffers[cpu].samples[idx + count]))
+                {
+                    break;
+                }
+            }
+
+            len = rt_snprintf(line, sizeof(line), "%.*s", RT_NAME_MAX, sample->name);
+
+            for (i = sample->depth - 1; i >= 0; --i)
+            {
+                len += rt_snprintf(&line[len], sizeof(line) - len, ";0x%lx%s",
+                        sample->ip[i], sample->user ? "" : "_[k]");
+            }
+
+            len += rt_snprintf(&line[len], sizeof(line) - len, " %lu\n", (rt_ubase_t)count);
+
+            perf_report_output(fd, line, len);
+        }
+    }
+}
+
+#if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
+enum
+{
+    PERF_STAT_INSTRUCTIONS,
+    PERF_STAT_L1D_ACCESS,
+    PERF_STAT_L1D_REFILL,
+    PERF_STAT_BRANCHES,
+    PERF_STAT_BRANCH_MISSES,
+    PERF_STAT_CYCLES,
+
+    PERF_STAT_NR,
+};
+
+static const rt_uint32_t perf_stat_events[PERF_STAT_CYCLES] =
+{
+    [PERF_STAT_INSTRUCTIONS]    = ARMV8_PMU_EVT_INST_RETIRED,
+    [PERF_STAT_L1D_ACCESS]      = ARMV8_PMU_EVT_L1D_CACHE,
+    [PERF_STAT_L1D_REFILL]      = ARMV8_PMU_EVT_L1D_CACHE_REFILL,
+    [PERF_STAT_BRANCHES]        = ARMV8_PMU_EVT_BR_PRED,
+    [PERF_STAT_BRANCH_MISSES]   = ARMV8_PMU_EVT_BR_MIS_PRED,
+};
+
+struct perf_stat_thread
+{
+    rt_thread_t thread;
+    char name[RT_NAME_MAX];
+    rt_uint64_t count[PERF_STAT_NR];
+};
+
+struct perf_stat_cpu
+{
+    rt_uint64_t last[PERF_STAT_NR];
+    rt_size_t dropped;
+    struct perf_stat_thread threads[PERF_STAT_THREADS_NR];
+};
+
+static int perf_stat_events_nr;
+/* the hook installed before perf stat, it is chained and restored */
+static void (*perf_stat_prev_hook)(struct rt_thread *from, struct rt_thread *to);
+static struct perf_stat_cpu *perf_stat_cpus;
+
+static int perf_stat_counter_idx(int stat)
+{
+    return stat == PERF_STAT_CYCLES ? ARMV8_PMU_CYCLE_IDX : stat;
+}
+
+static struct perf_stat_thread *perf_stat_thread_find(struct perf_stat_cpu *stat_cpu, rt_thread_t thread)
+{
+    int i, hash = ((rt_ubase_t)thread >> 4) % PERF_STAT_THREADS_NR;
+    struct perf_stat_thread *entry;
+
+    for (i = 0; i < PERF_STAT_THREADS_NR; ++i)
+    {
+        entry = &stat_cpu->threads[(hash + i) % PERF_STAT_THREADS_NR];
+
+        if (entry->thread == thread)
+        {
+            return entry;
+        }
+
+        if (!entry->thread)
+        {
+            entry->thread = thread;
+            rt_strncpy(entry->name, thread->parent.name, RT_NAME_MAX);
+
+            return entry;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/* charge the counters since the last switch on this cpu to the thread */
+static void perf_stat_charge(rt_thread_t thread)
+{
+    int i, idx;
+    rt_uint64_t now, delta;
+    struct perf_stat_thread *entry;
+    struct perf_stat_cpu *stat_cpu = &perf_stat_cpus[_perf_cpu_id()];
+
+    entry = thread ? perf_stat_thread_find(stat_cpu, thread) : RT_NULL;
+
+    if (!entry)
+    {
+        ++stat_cpu->dropped;
+    }
+
+    for (i = 0; i < PERF_STAT_NR; ++i)
+    {
+        if (i < PERF_STAT_CYCLES && i >= perf_stat_events_nr)
+        {
+            continue;
+        }
+
+        idx = perf_stat_counter_idx(i);
+        now = rt_hw_pmu_counter_read(idx);
+        delta = now - stat_cpu->last[i];
+
+        if (idx != ARMV8_PMU_CYCLE_IDX)
+        {
+            delta &= RT_UINT32_MAX;
+        }
+
+        stat_cpu->last[i] = now;
+
+        if (entry)
+        {
+            entry->count[i] += delta;
+        }
+    }
+}
+
+static void perf_stat_switch_hook(struct rt_thread *from, struct rt_thread *to)
+{
+    perf_stat_charge(from);
+
+    if (perf_stat_prev_hook)
+    {
+        perf_stat_prev_hook(from, to);
+    }
+}
+
+static void perf_stat_start(void *data)
+{
+    int i;
+    rt_base_t level = rt_hw_local_irq_disable();
+    struct perf_stat_cpu *stat_cpu = &perf_stat_cpus[_perf_cpu_id()];
+
+    rt_hw_pmu_reset();
+
+    for (i = 0; i < perf_stat_events_nr; ++i)
+    {
+        rt_hw_pmu_counter_config(i, perf_stat_events[i]);
+        rt_hw_pmu_counter_enable(i, RT_TRUE);
+    }
+    rt_hw_pmu_counter_config(ARMV8_PMU_CYCLE_IDX, 0);
+    rt_hw_pmu_counter_enable(ARMV8_PMU_CYCLE_IDX, RT_TRUE);
+
+    rt_memset(stat_cpu->last, 0, sizeof(stat_cpu->last));
+    rt_hw_pmu_start();
+
+    rt_hw_local_irq_enable(level);
+}
+
+static void perf_stat_stop(void *data)
+{
+    int i;
+    rt_base_t level = rt_hw_local_irq_disable();
+
+    perf_stat_charge(rt_thread_self());
+
+    rt_hw_pmu_stop();
+
+    for (i = 0; i < perf_stat_events_nr; ++i)
+    {
+        rt_hw_pmu_counter_enable(i, RT_FALSE);
+    }
+    rt_hw_pmu_counter_enable(ARMV8_PMU_CYCLE_IDX, RT_FALSE);
+
+    rt_hw_local_irq_enable(level);
+}
+
+static void perf_stat_print_ratio(rt_uint64_t part, rt_uint64_t total, const char *unit)
+{
+    rt_uint64_t ratio = total ? part * 100 * 100 / total : 0;
+
+    rt_kprintf(" %5lu.%02lu%s", (rt_ubase_t)(ratio / 100), (rt_ubase_t)(ratio % 100), unit);
+}
+
+static void perf_stat_print(struct perf_stat_thread *entry)
+{
+    rt_uint64_t *count = entry->count;
+
+    rt_kprintf("%-*.*s %12lu %12lu", RT_NAME_MAX, RT_NAME_MAX, entry->name,
+            (rt_ubase_t)count[PERF_STAT_CYCLES], (rt_ubase_t)count[PERF_STAT_INSTRUCTIONS]);
+
+    /* instructions per cycle */
+    perf_stat_print_ratio(count[PERF_STAT_INSTRUCTIONS], count[PERF_STAT_CYCLES] * 100, " ");
+    rt_kprintf(" %10lu", (rt_ubase_t)count[PERF_STAT_L1D_REFILL]);
+    perf_stat_print_ratio(count[PERF_STAT_L1D_REFILL], count[PERF_STAT_L1D_ACCESS], "%");
+    rt_kprintf(" %10lu", (rt_ubase_t)count[PERF_STAT_BRANCH_MISSES]);
+    perf_stat_print_ratio(count[PERF_STAT_BRANCH_MISSES], count[PERF_STAT_BRANCHES], "%");
+    rt_kprintf("\n");
+}
+
+static rt_err_t perf_stat(rt_int32_t ms)
+{
+    int cpu, i, j, k, merged_nr = 0;
+    rt_size_t dropped = 0;
+    struct perf_stat_thread *merged, *entry, total;
+
+    perf_stat_cpus = rt_calloc(RT_CPUS_NR, sizeof(*perf_stat_cpus));
+    merged = rt_calloc(PERF_STAT_THREADS_NR, sizeof(*merged));
+
+    if (!perf_stat_cpus || !merged)
+    {
+        rt_free(perf_stat_cpus);
+        rt_free(merged);
+        perf_stat_cpus = RT_NULL;
+
+        return -RT_ENOMEM;
+    }
+
+    perf_stat_events_nr = rt_hw_pmu_counters_nr();
+    if (perf_stat_events_nr > PERF_STAT_CYCLES)
+    {
+        perf_stat_events_nr = PERF_STAT_CYCLES;
+    }
+
+    perf_on_each_cpu(perf_stat_start, RT_NULL);
+    perf_stat_prev_hook = rt_scheduler_gethook();
+    rt_scheduler_sethook(perf_stat_switch_hook);
+
+    rt_thread_mdelay(ms);
+
+    rt_scheduler_sethook(perf_stat_prev_hook);
+    perf_on_each_cpu(perf_stat_stop, RT_NULL);
+
+    /* merge the threads from all cpus */
+    rt_memset(&total, 0, sizeof(total));
+    rt_strncpy(total.name, "total", RT_NAME_MAX);
+
+    for (cpu = 0; cpu < RT_CPUS_NR; ++cpu)
+    {
+        dropped += perf_stat_cpus[cpu].dropped;
+
+        for (i = 0; i < PERF_STAT_THREADS_NR; ++i)
+        {
+            entry = &perf_stat_cpus[cpu].threads[i];
+
+            if (!entry->thread)
+            {
+                continue;
+            }
+
+            for (j = 0; j < merged_nr; ++j)
+            {
+                if (merged[j].thread == entry->thread)
+                {
+                    break;
+                }
+            }
+
+            if (j == merged_nr)
+            {
+                if (merged_nr == PERF_STAT_THREADS_NR)
+                {
+                    ++dropped;
+                    continue;
+                }
+
+                rt_memcpy(&merged[merged_nr++], entry, sizeof(*entry));
+            }
+            else
+            {
+                for (k = 0; k < PERF_STAT_NR; ++k)
+                {
+                    merged[j].count[k] += entry->count[k];
+                }
+            }
+
+            for (k = 0; k < PERF_STAT_NR; ++k)
+            {
+                total.count[k] += entry->count[k];
+            }
+        }
+    }
+
+    rt_kprintf("%-*s       cycles instructions    IPC  l1d-miss  l1d-miss%% br-miss   br-miss%%\n", RT_NAME_MAX, "thread");
+
+    for (i = 0; i < merged_nr; ++i)
+    {
+        perf_stat_print(&merged[i]);
+    }
+    perf_stat_print(&total);
+
+    if (perf_stat_events_nr < PERF_STAT_CYCLES)
+    {
+        rt_kprintf("only %d event counters, the missing events read as 0\n", perf_stat_events_nr);
+    }
+
+    if (dropped)
+    {
+        rt_kprintf("%lu switches are not charged, thread table is full\n", (rt_ubase_t)dropped);
+    }
+
+    rt_free(merged);
+    rt_free(perf_stat_cpus);
+    perf_stat_cpus = RT_NULL;
+
+    return RT_EOK;
+}
+#endif /* RT_USING_HOOK && RT_HOOK_USING_FUNC_PTR */
+
+static void perf_usage(void)
+{
+    rt_kprintf("Usage:\n");
+    rt_kprintf("perf record [-e cycles|instructions] [-c period] [ms]\n");
+    rt_kprintf("perf report [file]     - dump folded stacks of the last record\n");
+#if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
+    rt_kprintf("perf stat [ms]         - count ipc, cache and branch misses per thread\n");
+#endif
+}
+
+static int cmd_perf(int argc, char **argv)
+{
+    int i;
+    rt_err_t err = RT_EOK;
+    rt_int32_t ms = 1000;
+    rt_uint64_t period = PERF_DEFAULT_PERIOD;
+    rt_uint32_t event = ARMV8_PMU_EVT_CPU_CYCLES;
+
+    if (argc < 2)
+    {
+        perf_usage();
+        return -RT_EINVAL;
+    }
+
+    if (!rt_hw_pmu_probed())
+    {
+        rt_kprintf("PMU is not available\n");
+        return -RT_ENOSYS;
+    }
+
+    if (!rt_strcmp(argv[1], "report"))
+    {
+        int fd = -1;
+
+        rt_mutex_take(&perf_lock, RT_WAITING_FOREVER);
+
+#ifdef RT_USING_DFS
+        if (argc > 2 && (fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0)) < 0)
+        {
+            rt_kprintf("open %s failed\n", argv[2]);
+            rt_mutex_release(&perf_lock);
+
+            return -RT_EIO;
+        }
+#endif
+
+        perf_report(fd);
+
+#ifdef RT_USING_DFS
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+#endif
+
+        rt_mutex_release(&perf_lock);
+
+        return 0;
+    }
+
+    for (i = 2; i < argc; ++i)
+    {
+        if (!rt_strcmp(argv[i], "-e") && i + 1 < argc)
+        {
+            ++i;
+
+            if (!rt_strcmp(argv[i], "cycles"))
+            {
+                event = ARMV8_PMU_EVT_CPU_CYCLES;
+            }
+            else if (!rt_strcmp(argv[i], "instructions"))
+            {
+                event = ARMV8_PMU_EVT_INST_RETIRED;
+            }
+            else
+            {
+                event = strtoul(argv[i], RT_NULL, 0);
+            }
+        }
+        else if (!rt_strcmp(argv[i], "-c") && i + 1 < argc)
+        {
+            period = strtoul(argv[++i], RT_NULL, 0);
+        }
+        else
+        {
+            ms = atoi(argv[i]);
+        }
+    }
+
+    if (ms <= 0 || period == 0 || (event != ARMV8_PMU_EVT_CPU_CYCLES && period > RT_UINT32_MAX))
+    {
+        perf_usage();
+        return -RT_EINVAL;
+    }
+
+    rt_mutex_take(&perf_lock, RT_WAITING_FOREVER);
+
+    if (!rt_strcmp(argv[1], "record"))
+    {
+        err = perf_record(event, period, ms);
+    }
+#if defined(RT_USING_HOOK) && defined(RT_HOOK_USING_FUNC_PTR)
+    else if (!rt_strcmp(argv[1], "stat"))
+    {
+        err = perf_stat(ms);
+    }
+#endif
+    else
+    {
+        perf_usage();
+        err = -RT_EINVAL;
+    }
+
+    rt_mutex_release(&perf_lock);
+
+    if (err && err != -RT_EINVAL)
+    {
+        rt_kprintf("perf %s failed, error = %d\n", argv[1], err);
+    }
+
+    return err;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_perf, perf, sampling profiler and counters of pmu);
+
+static int perf_init(void)
+{
+    rt_mutex_init(&perf_lock, "perf", RT_IPC_FLAG_PRIO);
+
+    return 0;
+}
+INIT_PREV_EXPORT(perf_init);
+#endif /* ARCH_ARMV8_PMU_PROFILER */
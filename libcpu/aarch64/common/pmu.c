@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef ARCH_ARMV8_PMU
+#include <rtdevice.h>
+
+#define DBG_TAG "cpu.pmu"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#include <cpuport.h>
+#include <pmu.h>
+
+static int armv8_pmu_irq = -1;
+static int armv8_pmu_counters = 0;
+static rt_hw_pmu_overflow_handler_t armv8_pmu_overflow_handler = RT_NULL;
+
+rt_bool_t rt_hw_pmu_probed(void)
+{
+    return armv8_pmu_counters > 0;
+}
+
+/**
+ * @brief Get the number of the generic event counters, the cycle counter is
+ *        not included.
+ */
+int rt_hw_pmu_counters_nr(void)
+{
+    return armv8_pmu_counters;
+}
+
+void rt_hw_pmu_reset(void)
+{
+    rt_uint64_t mask = RT_UINT32_MAX;
+
+    sysreg_write(PMCNTENCLR_EL0, mask);
+    sysreg_write(PMINTENCLR_EL1, mask);
+    sysreg_write(PMOVSCLR_EL0, mask);
+    sysreg_write(PMCR_EL0, ARMV8_PMU_PMCR_P | ARMV8_PMU_PMCR_C | ARMV8_PMU_PMCR_LC);
+    rt_hw_isb();
+}
+
+void rt_hw_pmu_start(void)
+{
+    rt_uint64_t pmcr;
+
+    sysreg_read(PMCR_EL0, pmcr);
+    sysreg_write(PMCR_EL0, pmcr | ARMV8_PMU_PMCR_E | ARMV8_PMU_PMCR_LC);
+    rt_hw_isb();
+}
+
+void rt_hw_pmu_stop(void)
+{
+    rt_uint64_t pmcr;
+
+    sysreg_read(PMCR_EL0, pmcr);
+    sysreg_write(PMCR_EL0, pmcr & ~(rt_uint64_t)ARMV8_PMU_PMCR_E);
+    rt_hw_isb();
+}
+
+/**
+ * @brief Select the event and the exception level filter of a counter.
+ *
+ * @param idx is the event counter index, or ARMV8_PMU_CYCLE_IDX.
+ *
+ * @param evtype is the event number with the ARMV8_PMU_EXCLUDE_* flags, the
+ *        event number is ignored by the cycle counter.
+ */
+void rt_hw_pmu_counter_config(int idx, rt_uint32_t evtype)
+{
+    if (idx == ARMV8_PMU_CYCLE_IDX)
+    {
+        sysreg_write(PMCCFILTR_EL0, evtype & ~ARMV8_PMU_EVTYPE_EVENT);
+    }
+    else
+    {
+        sysreg_write(PMSELR_EL0, idx);
+        rt_hw_isb();
+        sysreg_write(PMXEVTYPER_EL0, evtype);
+    }
+    rt_hw_isb();
+}
+
+void rt_hw_pmu_counter_enable(int idx, rt_bool_t enable)
+{
+    if (enable)
+    {
+        sysreg_write(PMCNTENSET_EL0, 1UL << idx);
+    }
+    else
+    {
+        sysreg_write(PMCNTENCLR_EL0, 1UL << idx);
+    }
+    rt_hw_isb();
+}
+
+void rt_hw_pmu_counter_irq_enable(int idx, rt_bool_t enable)
+{
+    if (enable)
+    {
+        sysreg_write(PMINTENSET_EL1, 1UL << idx);
+    }
+    else
+    {
+        sysreg_write(PMINTENCLR_EL1, 1UL << idx);
+        sysreg_write(PMOVSCLR_EL0, 1UL << idx);
+    }
+    rt_hw_isb();
+}
+
+/**
+ * @brief Read a counter, the event counters are 32 bits and the cycle
+ *        counter is 64 bits.
+ */
+rt_uint64_t rt_hw_pmu_counter_read(int idx)
+{
+    rt_uint64_t value;
+
+    if (idx == ARMV8_PMU_CYCLE_IDX)
+    {
+        sysreg_read(PMCCNTR_EL0, value);
+    }
+    else
+    {
+        sysreg_write(PMSELR_EL0, idx);
+        rt_hw_isb();
+        sysreg_read(PMXEVCNTR_EL0, value);
+        value &= RT_UINT32_MAX;
+    }
+
+    return value;
+}
+
+void rt_hw_pmu_counter_write(int idx, rt_uint64_t value)
+{
+    if (idx == ARMV8_PMU_CYCLE_IDX)
+    {
+        sysreg_write(PMCCNTR_EL0, value);
+    }
+    else
+    {
+        sysreg_write(PMSELR_EL0, idx);
+        rt_hw_isb();
+        sysreg_write(PMXEVCNTR_EL0, value & RT_UINT32_MAX);
+    }
+    rt_hw_isb();
+}
+
+/**
+ * @brief Set the handler called in the overflow interrupt on the cpu which
+ *        counter overflowed. Only one user could own the interrupt.
+ *
+ * @param handler is the overflow handler, RT_NULL to release it.
+ *
+ * @return RT_EOK on success, -RT_ENOSYS without the interrupt, -RT_EBUSY if
+ *         the interrupt is owned by other.
+ */
+rt_err_t rt_hw_pmu_set_overflow_handler(rt_hw_pmu_overflow_handler_t handler)
+{
+    rt_err_t err = RT_EOK;
+    rt_base_t level;
+
+    if (armv8_pmu_irq < 0)
+    {
+        return -RT_ENOSYS;
+    }
+
+    level = rt_hw_interrupt_disable();
+
+    if (handler && armv8_pmu_overflow_handler)
+    {
+        err = -RT_EBUSY;
+    }
+    else
+    {
+        armv8_pmu_overflow_handler = handler;
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    return err;
+}
+
+static void armv8_pmu_isr(int vector, void *param)
+{
+    rt_uint64_t overflow;
+    rt_hw_pmu_overflow_handler_t handler;
+
+    sysreg_read(PMOVSCLR_EL0, overflow);
+    overflow &= RT_UINT32_MAX;
+    sysreg_write(PMOVSCLR_EL0, overflow);
+    rt_hw_isb();
+
+    handler = armv8_pmu_overflow_handler;
+
+    if (overflow && handler)
+    {
+        handler((rt_uint32_t)overflow, rt_hw_trap_irq_regs());
+    }
+}
+
+static int armv8_pmu_local_init(void)
+{
+    if (armv8_pmu_counters > 0)
+    {
+        rt_hw_pmu_reset();
+
+        if (armv8_pmu_irq >= 0)
+        {
+            rt_hw_interrupt_umask(armv8_pmu_irq);
+        }
+    }
+
+    return 0;
+}
+INIT_SECONDARY_CPU_EXPORT(armv8_pmu_local_init);
+
+static rt_err_t armv8_pmu_probe(struct rt_platform_device *pdev)
+{
+    rt_uint64_t dfr0, pmcr;
+    rt_uint32_t pmuver;
+
+    sysreg_read(ID_AA64DFR0_EL1, dfr0);
+    pmuver = (dfr0 >> 8) & 0xf;
+
+    /* 0x0: not implemented, 0xf: IMPLEMENTATION DEFINED */
+    if (pmuver == 0 || pmuver == 0xf)
+    {
+        LOG_W("PMUv3 is not implemented");
+
+        return -RT_ENOSYS;
+    }
+
+    sysreg_read(PMCR_EL0, pmcr);
+    armv8_pmu_counters = (pmcr >> ARMV8_PMU_PMCR_N_SHIFT) & ARMV8_PMU_PMCR_N_MASK;
+
+    armv8_pmu_irq = rt_dm_dev_get_irq(&pdev->parent, 0);
+
+    if (armv8_pmu_irq >= 0)
+    {
+        rt_hw_interrupt_install(armv8_pmu_irq, armv8_pmu_isr, RT_NULL, "pmu");
+    }
+    else
+    {
+        LOG_W("No overflow interrupt, only counting mode is available");
+    }
+
+    armv8_pmu_local_init();
+
+    LOG_I("PMUv3 with %d counters", armv8_pmu_counters);
+
+    return RT_EOK;
+}
+
+static const struct rt_ofw_node_id armv8_pmu_ofw_ids[] =
+{
+    { .compatible = "arm,armv8-pmuv3", },
+    { .compatible = "arm,cortex-a35-pmu", },
+    { .compatible = "arm,cortex-a53-pmu", },
+    { .compatible = "arm,cortex-a55-pmu", },
+    { .compatible = "arm,cortex-a57-pmu", },
+    { .compatible = "arm,cortex-a72-pmu", },
+    { .compatible = "arm,cortex-a73-pmu", },
+    { .compatible = "arm,cortex-a75-pmu", },
+    { .compatible = "arm,cortex-a76-pmu", },
+    { /* sentinel */ }
+};
+
+static struct rt_platform_driver armv8_pmu_driver =
+{
+    .name = "arm-pmu",
+    .ids = armv8_pmu_ofw_ids,
+
+    .probe = armv8_pmu_probe,
+};
+
+static int armv8_pmu_drv_register(void)
+{
+    rt_platform_driver_register(&armv8_pmu_driver);
+
+    return 0;
+}
+INIT_SUBSYS_EXPORT(armv8_pmu_drv_register);
+#endif /* ARCH_ARMV8_PMU */
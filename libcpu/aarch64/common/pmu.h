@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __ARMV8_PMU_H__
+#define __ARMV8_PMU_H__
+
+#include <rtdef.h>
+#include <armv8.h>
+
+/* PMCR_EL0 */
+#define ARMV8_PMU_PMCR_E            (1 << 0)    /* Enable all counters */
+#define ARMV8_PMU_PMCR_P            (1 << 1)    /* Reset all event counters */
+#define ARMV8_PMU_PMCR_C            (1 << 2)    /* Cycle counter reset */
+#define ARMV8_PMU_PMCR_LC           (1 << 6)    /* Overflow on 64 bit cycle counter */
+#define ARMV8_PMU_PMCR_N_SHIFT      11
+#define ARMV8_PMU_PMCR_N_MASK       0x1f
+
+/* PMXEVTYPER_EL0, PMCCFILTR_EL0 */
+#define ARMV8_PMU_EXCLUDE_EL1       (1U << 31)
+#define ARMV8_PMU_EXCLUDE_EL0       (1U << 30)
+#define ARMV8_PMU_INCLUDE_EL2       (1U << 27)
+#define ARMV8_PMU_EVTYPE_EVENT      0xffff
+
+/* Common architectural and microarchitectural events */
+#define ARMV8_PMU_EVT_SW_INCR           0x00
+#define ARMV8_PMU_EVT_L1I_CACHE_REFILL  0x01
+#define ARMV8_PMU_EVT_L1D_CACHE_REFILL  0x03
+#define ARMV8_PMU_EVT_L1D_CACHE         0x04
+#define ARMV8_PMU_EVT_INST_RETIRED      0x08
+#define ARMV8_PMU_EVT_BR_MIS_PRED       0x10
+#define ARMV8_PMU_EVT_CPU_CYCLES        0x11
+#define ARMV8_PMU_EVT_BR_PRED           0x12
+#define ARMV8_PMU_EVT_L2D_CACHE_REFILL  0x17
+
+/* The cycle counter uses the bit 31 of the set/clear registers */
+#define ARMV8_PMU_CYCLE_IDX         31
+#define ARMV8_PMU_MAX_COUNTERS      31
+
+typedef void (*rt_hw_pmu_overflow_handler_t)(rt_uint32_t overflow, struct rt_hw_exp_stack *regs);
+
+rt_bool_t rt_hw_pmu_probed(void);
+int rt_hw_pmu_counters_nr(void);
+
+void rt_hw_pmu_reset(void);
+void rt_hw_pmu_start(void);
+void rt_hw_pmu_stop(void);
+
+void rt_hw_pmu_counter_config(int idx, rt_uint32_t evtype);
+void rt_hw_pmu_counter_enable(int idx, rt_bool_t enable);
+void rt_hw_pmu_counter_irq_enable(int idx, rt_bool_t enable);
+rt_uint64_t rt_hw_pmu_counter_read(int idx);
+void rt_hw_pmu_counter_write(int idx, rt_uint64_t value);
+
+rt_err_t rt_hw_pmu_set_overflow_handler(rt_hw_pmu_overflow_handler_t handler);
+
+#endif /* __ARMV8_PMU_H__ */
@@ -602,8 +602,10 @@ void rt_hw_common_setup(void)
     /* Install the IPI handle */
     rt_hw_ipi_handler_install(RT_SCHEDULE_IPI, rt_scheduler_ipi_handler);
     rt_hw_ipi_handler_install(RT_STOP_IPI, rt_scheduler_ipi_handler);
+    rt_hw_ipi_handler_install(RT_SMP_CALL_IPI, rt_smp_call_ipi_handler);
     rt_hw_interrupt_umask(RT_SCHEDULE_IPI);
     rt_hw_interrupt_umask(RT_STOP_IPI);
+    rt_hw_interrupt_umask(RT_SMP_CALL_IPI);
 #endif
 }
 
@@ -805,6 +807,7 @@ rt_weak void secondary_cpu_c_start(void)
     rt_dm_secondary_cpu_init();
     rt_hw_interrupt_umask(RT_SCHEDULE_IPI);
     rt_hw_interrupt_umask(RT_STOP_IPI);
+    rt_hw_interrupt_umask(RT_SMP_CALL_IPI);
 
     read_cpuid(cpuid, midr);
     LOG_I("Call CPU%d [%s] on success", cpu_id, cpuid);
@@ -41,18 +41,13 @@ static inline void rt_hw_tlb_invalidate_all_local(void)
     __asm__ volatile(
         // ensure updates to pte completed
         "dsb nshst\n"
-        "tlbi vmalle1is\n"
+        "tlbi vmalle1\n"
         "dsb nsh\n"
         // after tlb in new context, refresh inst
         "isb\n" ::
             : "memory");
 }
 
-static inline void rt_hw_tlb_invalidate_aspace(rt_aspace_t aspace)
-{
-    rt_hw_tlb_invalidate_all();
-}
-
 static inline void rt_hw_tlb_invalidate_page(rt_aspace_t aspace, void *start)
 {
     start = TLBI_ARG(start, 0);
@@ -64,17 +59,15 @@ static inline void rt_hw_tlb_invalidate_page(rt_aspace_t aspace, void *start)
         : "memory");
 }
 
-static inline void rt_hw_tlb_invalidate_range(rt_aspace_t aspace, void *start,
-                                              size_t size, size_t stride)
-{
-    if (size <= ARCH_PAGE_SIZE)
-    {
-        rt_hw_tlb_invalidate_page(aspace, start);
-    }
-    else
-    {
-        rt_hw_tlb_invalidate_aspace(aspace);
-    }
-}
+/**
+ * Invalidate the TLB of the aspace on the cores which may hold its entries.
+ * A user aspace is only cached by the cores which loaded it after their last
+ * invalidation, so a range of it is invalidated on the local core only, or
+ * on the few cores running it, instead of the whole system.
+ */
+void rt_hw_tlb_invalidate_aspace(rt_aspace_t aspace);
+
+void rt_hw_tlb_invalidate_range(rt_aspace_t aspace, void *start,
+                                size_t size, size_t stride);
 
 #endif /* __TLB_H__ */
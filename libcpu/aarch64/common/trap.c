@@ -139,9 +139,32 @@ void rt_hw_show_register(struct rt_hw_exp_stack *regs)
     rt_kprintf("EPC   :0x%16.16p\n", (void *)regs->pc);
 }
 
-void rt_hw_trap_irq(void)
+#ifdef RT_USING_SMP
+#define _irq_cpu_id() rt_hw_cpu_id()
+#else
+#define _irq_cpu_id() 0
+#endif
+
+static struct rt_hw_exp_stack *_irq_regs[RT_CPUS_NR];
+
+/**
+ * @brief Get the exception frame of the interrupt being handled on this cpu.
+ *
+ * @return the interrupted context, or RT_NULL outside of interrupt handling.
+ */
+struct rt_hw_exp_stack *rt_hw_trap_irq_regs(void)
 {
+    return _irq_regs[_irq_cpu_id()];
+}
+
+void rt_hw_trap_irq(struct rt_hw_exp_stack *regs)
+{
+    int cpu_id = _irq_cpu_id();
+    struct rt_hw_exp_stack *prev_regs = _irq_regs[cpu_id];
+
+    _irq_regs[cpu_id] = regs;
     rt_pic_do_traps();
+    _irq_regs[cpu_id] = prev_regs;
 }
 
 void rt_hw_trap_fiq(void)
@@ -159,6 +182,14 @@ void rt_hw_trap_exception(struct rt_hw_exp_stack *regs)
     asm volatile("mrs %0, esr_el1":"=r"(esr));
     ec = (unsigned char)((esr >> 26) & 0x3fU);
 
+#ifdef RT_USING_CPU_USAGE
+    if ((regs->cpsr & 0x1f) == 0)
+    {
+        /* exception from user mode */
+        rt_cpu_usage_user_exit();
+    }
+#endif /* RT_USING_CPU_USAGE */
+
 #ifdef RT_USING_LWP
     if (dbg_check_event(regs, esr))
     {
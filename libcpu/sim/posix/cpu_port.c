@@ -1,564 +1,697 @@
 /*
- * author : prife (goprife@gmail.com)
- * date   : 2013/01/14 01:18:50
- * version: v 0.2.0
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-14     prife        the first version
+ * 2023-10-18     RT-Thread    rewrite for the 64-bit hosts and SMP
  */
+
+/*
+ * Each thread of RT-Thread runs in a host thread, which waits on its own
+ * semaphore when it is not running. The context switch posts the semaphore
+ * of the next thread and waits on the one of the previous thread.
+ *
+ * The CPUs are virtual: a CPU is the running thread and the interrupt state,
+ * the threads running on the different CPUs run in parallel on the host. The
+ * boot host thread of each CPU becomes its tick source when the scheduler has
+ * started on it.
+ *
+ * An interrupt is raised by setting the pending bit of the CPU and sending
+ * SIM_IRQ_SIGNAL to the thread running on it. The signal handler runs the
+ * ISRs as the IRQ vector if the interrupt is enabled, or they are left to
+ * rt_hw_local_irq_enable().
+ *
+ * The host library calls which may take the locks (such as malloc and
+ * pthread_create) are made with the interrupt disabled, so a thread is never
+ * switched out with them held.
+ */
+
+#include <rthw.h>
 #include <rtthread.h>
-#include <stdio.h>
-#include <stdlib.h>
+#include <cpuport.h>
+
+#include <errno.h>
 #include <pthread.h>
-#include <signal.h>
-#include <unistd.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <signal.h>
+#include <stdlib.h>
 #include <time.h>
-#include <sys/time.h>
 
-//#define TRACE       printf
-#define TRACE(...)
+#define SIM_IRQ_SIGNAL              SIGUSR1
+
+#ifndef SIM_THREAD_HOST_STACK_SIZE
+#define SIM_THREAD_HOST_STACK_SIZE  (256 * 1024)
+#endif
 
-typedef struct _thread
+#define SIM_SPIN_YIELD_LOOPS        1000
+
+#ifndef RT_USING_SMP
+#define RT_CPUS_NR                  1
+#define rt_hw_local_irq_disable     rt_hw_interrupt_disable
+#define rt_hw_local_irq_enable      rt_hw_interrupt_enable
+#endif /* RT_USING_SMP */
+
+struct sim_thread
 {
     pthread_t pthread;
-    void (*task)(void *);
-    void *para;
-    void (*exit)(void);
     sem_t sem;
-    rt_thread_t rtthread;
-    int status;
-    void *data;
-} thread_t;
 
-#define THREAD_T(thread)  ((thread_t *)thread)
+    void (*entry)(void *parameter);
+    void *parameter;
+    void (*exit)(void);
 
-#define MSG_SUSPEND  SIGUSR1    /* 10 */
-#define MSG_RESUME   SIGUSR2
-#define MSG_TICK     SIGALRM    /* 14 */
-#define TIMER_TYPE   ITIMER_REAL
-#define MAX_INTERRUPT_NUM ((unsigned int)sizeof(unsigned int) * 8)
+    /* the CPU it is resumed on, set by the switcher before posting */
+    int cpu;
+    /* the interrupt state is changing, the signal must not run the ISRs */
+    volatile int irq_atomic;
+};
 
-#define INTERRUPT_ENABLE   0
-#define INTERRUPT_DISABLE  1
+struct sim_cpu
+{
+    struct sim_thread *volatile current;
+    /* the current is changed and signaled with the lock */
+    pthread_mutex_t lock;
 
-/* 线程挂起状态，共两种取值 */
-#define SUSPEND_LOCK      0
-#define SUSPEND_SIGWAIT   1
-#define THREAD_RUNNING    2
+    volatile rt_base_t irq_disabled;
+    volatile rt_uint32_t irq_pending;
+};
 
-/* interrupt flag, if 1, disable, if 0, enable */
-static long interrupt_disable_flag;
-//static int systick_signal_flag;
+/* the sp of the thread points to the pointer to its host thread */
+#define SIM_THREAD(sp_addr)         (*(struct sim_thread **)(*(rt_ubase_t *)(sp_addr)))
 
-/* flag in interrupt handling */
-rt_uint32_t rt_interrupt_from_thread, rt_interrupt_to_thread;
-rt_uint32_t rt_thread_switch_interrupt_flag;
+static struct sim_cpu sim_cpus[RT_CPUS_NR] =
+{
+    [0 ... RT_CPUS_NR - 1] =
+    {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .irq_disabled = 1,
+    },
+};
 
-/* interrupt event mutex */
-static pthread_mutex_t *ptr_int_mutex;
-static pthread_cond_t cond_int_hit; /* interrupt occured! */
-static volatile unsigned int  cpu_pending_interrupts;
-static int (* cpu_isr_table[MAX_INTERRUPT_NUM])(void) = {0};
+static struct rt_irq_desc sim_irq_desc[SIM_IRQ_MAX];
+static volatile rt_uint32_t sim_irq_masked;
 
-static pthread_t mainthread_pid;
+static __thread struct sim_thread *sim_self;
+static __thread int sim_cpu_id;
 
-/* function definition */
-static void start_sys_timer(void);
-static int tick_interrupt_isr(void);
-static void mthread_signal_tick(int sig);
-static int mainthread_scheduler(void);
+#ifdef RT_USING_SMP
+extern void rt_cpus_lock_status_restore(struct rt_thread *thread);
+extern void rt_scheduler_do_irq_switch(void *context);
+#else
+/* the switch in the interrupt is done when leaving it */
+static rt_ubase_t sim_switch_from, sim_switch_to;
+static rt_uint32_t sim_switch_flag;
+#endif /* RT_USING_SMP */
 
-int signal_install(int sig, void (*func)(int))
+rt_inline struct sim_cpu *sim_cpu_self(void)
 {
-    struct sigaction act;
-
-    /* set the signal handler */
-    act.sa_handler = func ;
-    sigemptyset(&act.sa_mask);
-    act.sa_flags = 0;
-    sigaction(sig, &act, 0);
+    return &sim_cpus[sim_cpu_id];
 }
 
-int signal_mask(void)
+rt_inline rt_uint32_t sim_irq_ready(struct sim_cpu *cpu)
 {
-    sigset_t  sigmask, oldmask;
-
-    /* set signal mask */
-    sigemptyset(&sigmask);
-    sigaddset(&sigmask, SIGALRM);
-    pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
+    return cpu->irq_pending & ~sim_irq_masked;
 }
-static void thread_suspend_signal_handler(int sig)
+
+static rt_base_t sim_host_enter(void)
 {
-    sigset_t sigmask;
-    pthread_t pid = pthread_self();
-    thread_t *thread_from;
-    thread_t *thread_to;
-    rt_thread_t tid;
+    /* the host threads out of RT-Thread are never interrupted */
+    return sim_self != RT_NULL ? rt_hw_local_irq_disable() : 1;
+}
 
-    if (sig != MSG_SUSPEND)
+static void sim_host_leave(rt_base_t level)
+{
+    if (sim_self != RT_NULL)
     {
-        printf("get an unexpected signal <%d>, exit\n", sig);
-        exit(EXIT_FAILURE);
+        rt_hw_local_irq_enable(level);
     }
+}
 
-    thread_from = (thread_t *) rt_interrupt_from_thread;
-    thread_to = (thread_t *) rt_interrupt_to_thread;
-
-    /* 注意！此时 rt_thread_self的值是to线程的值！ */
-    tid = rt_thread_self();
-    /* FIXME RT_ASSERT(thread_from->pthread == pid); */
-    RT_ASSERT((thread_t *)(tid->sp) == thread_to);
+static void sim_cpu_set_current(struct sim_cpu *cpu, struct sim_thread *thread)
+{
+    thread->cpu = cpu - sim_cpus;
 
-    TRACE("signal: SIGSUSPEND suspend <%s>\n", thread_from->rtthread->name);
+    pthread_mutex_lock(&cpu->lock);
+    cpu->current = thread;
+    pthread_mutex_unlock(&cpu->lock);
+}
 
-    /* 使用sigwait或者sigsuspend来挂起from线程  */
-    //sem_wait(&thread_from->sem);
-    sigemptyset(&sigmask);
-    sigaddset(&sigmask, MSG_RESUME);
+static void sim_cpu_kick(struct sim_cpu *cpu)
+{
+    pthread_mutex_lock(&cpu->lock);
+    if (cpu->current != RT_NULL)
+    {
+        pthread_kill(cpu->current->pthread, SIM_IRQ_SIGNAL);
+    }
+    pthread_mutex_unlock(&cpu->lock);
+}
 
-    /* Beginnig Linux Programming上说，当信号处理函数运行中，此信号就会被屏蔽，
-     * 以防止重复执行信号处理函数
-     */
-    thread_from->status = SUSPEND_SIGWAIT;
-    if (sigwait(&sigmask, &sig) != 0)
+static void sim_thread_wait(struct sim_thread *thread)
+{
+    while (sem_wait(&thread->sem) != 0)
     {
-        printf("sigwait faild, %d\n", sig);
+        /* interrupted by a signal sent before it was switched out */
     }
-    thread_to = (thread_t *) rt_interrupt_to_thread;
-    RT_ASSERT(thread_to == thread_from);
-    thread_to->status = THREAD_RUNNING;
-    TRACE("signal: SIGSUSPEND resume  <%s>\n", thread_from->rtthread->name);
+
+    sim_cpu_id = thread->cpu;
+}
+
+static rt_bool_t sim_thread_closed(rt_ubase_t from)
+{
+    struct rt_thread *thread = rt_container_of((void *)from, struct rt_thread, sp);
+
+    return (thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_CLOSE;
 }
 
-static void thread_resume_signal_handler(int sig)
+static void sim_thread_exit(struct sim_thread *thread)
 {
-    sigset_t sigmask;
-    pthread_t pid = pthread_self();
-    thread_t *thread_from;
-    thread_t *thread_to;
-    rt_thread_t tid;
+    sem_destroy(&thread->sem);
+    free(thread);
 
-    thread_from = (thread_t *) rt_interrupt_from_thread;
-    thread_to = (thread_t *) rt_interrupt_to_thread;
+    pthread_exit(RT_NULL);
+}
 
-    /* 注意！此时 rt_thread_self的值是to线程的值！ */
-    tid = rt_thread_self();
-    RT_ASSERT((thread_t *)(tid->sp) == thread_to);
+static void sim_thread_setname(struct rt_thread *thread)
+{
+    char name[16];
 
-    TRACE("signal: SIGRESUME resume  <%s>\n", thread_to->rtthread->name);
+    /* for the tools of the host, such as top and gdb */
+    rt_strncpy(name, thread->parent.name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    pthread_setname_np(pthread_self(), name);
 }
 
-static void *thread_run(void *parameter)
+static void sim_irq_dispatch(void)
 {
-    rt_thread_t tid;
-    thread_t *thread;
-    thread = THREAD_T(parameter);
-    int res;
+    int vector;
+    rt_uint32_t pending;
+    struct sim_cpu *cpu = sim_cpu_self();
 
-    /* set signal mask, mask the timer! */
-    signal_mask();
+    while ((pending = sim_irq_ready(cpu)) != 0)
+    {
+        __atomic_fetch_and(&cpu->irq_pending, ~pending, __ATOMIC_ACQ_REL);
 
-    thread->status = SUSPEND_LOCK;
-    TRACE("pid <%08x> stop on sem...\n", (unsigned int)(thread->pthread));
-    sem_wait(&thread->sem);
+        rt_interrupt_enter();
 
-    tid = rt_thread_self();
-    TRACE("pid <%08x> tid <%s> starts...\n", (unsigned int)(thread->pthread),
-          tid->parent.name);
-    thread->rtthread = tid;
-    thread->task(thread->para);
-    TRACE("pid <%08x> tid <%s> exit...\n", (unsigned int)(thread->pthread),
-          tid->parent.name);
-    thread->exit();
+        while (pending != 0)
+        {
+            vector = __builtin_ctz(pending);
+            pending &= pending - 1;
+
+            if (sim_irq_desc[vector].handler != RT_NULL)
+            {
+                sim_irq_desc[vector].handler(vector, sim_irq_desc[vector].param);
+#ifdef RT_USING_INTERRUPT_INFO
+                sim_irq_desc[vector].counter++;
+#endif
+            }
+        }
 
-    /*TODO:
-     * 最后一行的pthread_exit永远没有机会执行，这是因为在threead->exit函数中
-     * 会发生线程切换，并永久将此pthread线程挂起，所以更完美的解决方案是在这
-     * 里发送信号给主线程，主线程中再次唤醒此线程令其自动退出。
-     */
-    //sem_destroy(&thread->sem);
+        rt_interrupt_leave();
+
+#ifdef RT_USING_SMP
+        rt_scheduler_do_irq_switch(RT_NULL);
+#else
+        if (sim_switch_flag)
+        {
+            sim_switch_flag = 0;
+            rt_hw_context_switch(sim_switch_from, sim_switch_to);
+        }
+#endif /* RT_USING_SMP */
 
-    pthread_exit(NULL);
+        /* it may be resumed on another CPU */
+        cpu = sim_cpu_self();
+    }
 }
-static int thread_create(
-    thread_t *thread, void *task, void *parameter, void *pexit)
-{
-    int res;
-    pthread_attr_t attr;
 
-    thread->task = task;
-    thread->para = parameter;
-    thread->exit = pexit;
+static void sim_irq_signal(int sig)
+{
+    int saved_errno;
+    struct sim_cpu *cpu;
+    struct sim_thread *self = sim_self;
 
-    if (sem_init(&thread->sem, 0, 0) != 0)
+    if (self == RT_NULL || self->irq_atomic)
     {
-        printf("init thread->sem failed, exit \n");
-        exit(EXIT_FAILURE);
+        return;
     }
-    /* No need to join the threads. */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 
-    /* create a posix thread */
-    res = pthread_create(&thread->pthread, &attr, &thread_run, (void *)thread);
-    if (res)
+    cpu = sim_cpu_self();
+    if (cpu->current != self || cpu->irq_disabled)
     {
-        printf("pthread create faild, <%d>\n", res);
-        exit(EXIT_FAILURE);
+        return;
     }
 
-    return 0;
+    saved_errno = errno;
+
+    cpu->irq_disabled = 1;
+    sim_irq_dispatch();
+    sim_cpu_self()->irq_disabled = 0;
+
+    errno = saved_errno;
 }
 
-/* resume the thread */
-static int thread_resume(thread_t *thread)
+static void sim_tick_isr(int vector, void *param)
 {
-    sem_post(& thread->sem);
+    rt_tick_increase();
 }
 
-
-rt_uint8_t *rt_hw_stack_init(
-    void *pEntry,
-    void *pParam,
-    rt_uint8_t *pStackAddr,
-    void *pExit)
+static void sim_cpu_tick(int cpu)
 {
-    thread_t *thread;
+    struct timespec next;
+    const long period = 1000000000L / RT_TICK_PER_SECOND;
 
-    thread = (thread_t *)(pStackAddr - sizeof(thread_t));
+    clock_gettime(CLOCK_MONOTONIC, &next);
 
-    /* set the filed to zero */
-    memset(thread, 0x00, sizeof(thread_t));
+    for (;;)
+    {
+        next.tv_nsec += period;
+        if (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
 
-    thread_create(thread, pEntry, pParam, pExit);
-    //TRACE("thread %x created\n", (unsigned int)thread_table[t].pthread);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, RT_NULL) == EINTR)
+        {
+        }
 
-    return (rt_uint8_t *) thread;
+        rt_hw_interrupt_raise(SIM_IRQ_TICK, 1U << cpu);
+    }
 }
 
-rt_base_t rt_hw_interrupt_disable(void)
+static void *sim_thread_entry(void *parameter)
 {
-    long back;
+    sigset_t set;
+    struct sim_thread *thread = (struct sim_thread *)parameter;
 
-    if (ptr_int_mutex == NULL)
-    {
-        return 0;
-    }
+    sim_self = thread;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_UNBLOCK, &set, RT_NULL);
+
+    /* wait for the first switch to it, it starts with the interrupt enabled */
+    sim_thread_wait(thread);
+    sim_thread_setname(rt_thread_self());
+    rt_hw_local_irq_enable(0);
 
-    pthread_mutex_lock(ptr_int_mutex);
-    back = interrupt_disable_flag;
-    interrupt_disable_flag = INTERRUPT_DISABLE;
+    thread->entry(thread->parameter);
+    thread->exit();
 
-    /*TODO: It may need to unmask the signal */
-    return back;
+    /* never come back */
+    return RT_NULL;
 }
 
-void rt_hw_interrupt_enable(rt_base_t level)
+rt_uint8_t *rt_hw_stack_init(void *entry, void *parameter, rt_uint8_t *stack_addr, void *texit)
 {
-    struct rt_thread * tid;
-    pthread_t pid;
-    thread_t *thread_from;
-    thread_t *thread_to;
-
-    if (ptr_int_mutex == NULL)
-        return;
+    int err;
+    rt_base_t level;
+    pthread_attr_t attr;
+    struct sim_thread **sp;
+    struct sim_thread *thread;
 
-    interrupt_disable_flag = level;
+    level = sim_host_enter();
 
-    pthread_mutex_unlock(ptr_int_mutex);
-    /* 如果已经中断仍然关闭 */
-    if (interrupt_disable_flag)
+    thread = (struct sim_thread *)calloc(1, sizeof(*thread));
+    if (thread == RT_NULL)
     {
-        return;
+        sim_host_leave(level);
+        rt_kprintf("no memory for the host thread\n");
+        abort();
     }
 
-    /* 表示当前中断打开, 检查是否有挂起的中断 */
-    pthread_mutex_lock(ptr_int_mutex);
-    if (!cpu_pending_interrupts)
+    thread->entry = (void (*)(void *))entry;
+    thread->parameter = parameter;
+    thread->exit = (void (*)(void))texit;
+    sem_init(&thread->sem, 0, 0);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, SIM_THREAD_HOST_STACK_SIZE);
+    err = pthread_create(&thread->pthread, &attr, sim_thread_entry, thread);
+    pthread_attr_destroy(&attr);
+
+    sim_host_leave(level);
+
+    if (err != 0)
     {
-        pthread_mutex_unlock(ptr_int_mutex);
-        return;
+        rt_kprintf("create the host thread failed: %d\n", err);
+        abort();
     }
 
-    thread_from = (thread_t *) rt_interrupt_from_thread;
-    thread_to = (thread_t *) rt_interrupt_to_thread;
-    tid = rt_thread_self();
-    pid = pthread_self();
+    sp = (struct sim_thread **)RT_ALIGN_DOWN((rt_ubase_t)stack_addr, sizeof(rt_ubase_t));
+    *sp = thread;
 
-    //pid != mainthread_pid &&
-    if (thread_from->pthread == pid)
-    {
-        /* 注意这段代码是在RTT普通线程函数总函数中执行的，
-         * from线程就是当前rtt线程 */
-        /* 需要检查是否有挂起的中断需要处理 */
-        TRACE("conswitch: P in pid<%x> ,suspend <%s>, resume <%s>!\n",
-              (unsigned int)pid,
-              thread_from->rtthread->name,
-              thread_to->rtthread->name);
-
-        cpu_pending_interrupts --;
-        thread_from->status = SUSPEND_LOCK;
-        pthread_mutex_unlock(ptr_int_mutex);
-        /* 唤醒被挂起的线程 */
-        if (thread_to->status == SUSPEND_SIGWAIT)
-        {
-            pthread_kill(thread_to->pthread, MSG_RESUME);
-        }
-        else if (thread_to->status == SUSPEND_LOCK)
-        {
-            sem_post(& thread_to->sem);
-        }
-        else
-        {
-            printf("conswitch: should not be here! %d\n", __LINE__);
-            exit(EXIT_FAILURE);
-        }
+    return (rt_uint8_t *)sp;
+}
 
-        /* 挂起当前的线程 */
-        sem_wait(& thread_from->sem);
-        pthread_mutex_lock(ptr_int_mutex);
-        thread_from->status = THREAD_RUNNING;
-        pthread_mutex_unlock(ptr_int_mutex);
+rt_base_t rt_hw_local_irq_disable(void)
+{
+    rt_base_t level;
+    struct sim_cpu *cpu;
+    struct sim_thread *self = sim_self;
+
+    /* it must not be switched to another CPU between reading and writing */
+    if (self != RT_NULL)
+    {
+        self->irq_atomic = 1;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
     }
-    else
+
+    cpu = sim_cpu_self();
+    level = cpu->irq_disabled;
+    cpu->irq_disabled = 1;
+
+    if (self != RT_NULL)
     {
-        /* 注意这段代码可能在多种情况下运行：
-         * 1. 在system tick中执行， 即主线程的SIGALRM信号处理函数中执行
-         * 2. 其他线程中调用，比如用于获取按键输入的线程中调用
-         */
-        TRACE("conswitch: S in pid<%x>  ,suspend <%s>, resume <%s>!\n",
-              (unsigned int)pid,
-              thread_from->rtthread->name,
-              thread_to->rtthread->name);
-
-        cpu_pending_interrupts --;
-
-        /* 需要把解锁函数放在前面,以防止死锁？？ */
-        pthread_mutex_unlock(ptr_int_mutex);
-
-        /* 挂起from线程 */
-        pthread_kill(thread_from->pthread, MSG_SUSPEND);
-        /* 注意：这里需要确保线程被挂起了, 否则312行就很可能就会报错退出
-         * 因为这里挂起线程是通过信号实现的，所以一定要确保线程挂起才行 */
-        while (thread_from->status != SUSPEND_SIGWAIT)
-        {
-            sched_yield();
-        }
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        self->irq_atomic = 0;
+    }
 
-        /* 唤醒to线程 */
-        if (thread_to->status == SUSPEND_SIGWAIT)
-        {
-            pthread_kill(thread_to->pthread, MSG_RESUME);
-        }
-        else if (thread_to->status == SUSPEND_LOCK)
-        {
-            sem_post(& thread_to->sem);
-        }
-        else
-        {
-            printf("conswitch: should not be here! %d\n", __LINE__);
-            exit(EXIT_FAILURE);
-        }
+    return level;
+}
+
+void rt_hw_local_irq_enable(rt_base_t level)
+{
+    sim_cpu_self()->irq_disabled = level;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
 
+    /* take the interrupts raised while it was disabled */
+    if (!level && sim_self != RT_NULL && sim_irq_ready(sim_cpu_self()))
+    {
+        pthread_kill(pthread_self(), SIM_IRQ_SIGNAL);
     }
-    /*TODO: It may need to unmask the signal */
 }
 
-void rt_hw_context_switch(rt_uint32_t from,
-                          rt_uint32_t to)
+#ifdef RT_USING_SMP
+void rt_hw_context_switch(rt_ubase_t from, rt_ubase_t to, struct rt_thread *to_thread)
 {
-    struct rt_thread * tid;
-    pthread_t pid;
-    thread_t *thread_from;
-    thread_t *thread_to;
+    struct sim_thread *thread_from = SIM_THREAD(from);
+    struct sim_thread *thread_to = SIM_THREAD(to);
+    rt_bool_t closed = sim_thread_closed(from);
 
-    RT_ASSERT(from != to);
+    sim_cpu_set_current(sim_cpu_self(), thread_to);
+    rt_cpus_lock_status_restore(to_thread);
+    sem_post(&thread_to->sem);
 
-#if 0
-    //TODO: 可能还需要考虑嵌套切换的情况
-    if (rt_thread_switch_interrupt_flag != 1)
+    if (closed)
     {
-        rt_thread_switch_interrupt_flag = 1;
-
-        // set rt_interrupt_from_thread
-        rt_interrupt_from_thread = *((rt_uint32_t *)from);
+        sim_thread_exit(thread_from);
     }
-#endif
-    pthread_mutex_lock(ptr_int_mutex);
-    rt_interrupt_from_thread = *((rt_uint32_t *)from);
-    rt_interrupt_to_thread = *((rt_uint32_t *)to);
 
-    /* 这个函数只是并不会真正执行中断处理函数，而只是简单的
-     * 设置一下中断挂起标志位
-     */
-    cpu_pending_interrupts ++;
-    pthread_mutex_unlock(ptr_int_mutex);
+    sim_thread_wait(thread_from);
 }
 
-void rt_hw_context_switch_interrupt(rt_uint32_t from,
-                                    rt_uint32_t to)
+void rt_hw_context_switch_interrupt(void *context, rt_ubase_t from, rt_ubase_t to, struct rt_thread *to_thread)
 {
-    rt_hw_context_switch(from, to);
+    struct rt_thread *thread;
+
+    rt_hw_context_switch(from, to, to_thread);
+
+    /*
+     * The lock was released for it as it is left by rt_scheduler_do_irq_switch(),
+     * take it back for the rt_hw_interrupt_enable() there.
+     */
+    thread = rt_thread_self();
+    thread->cpus_lock_nest++;
+    thread->scheduler_lock_nest++;
+    rt_hw_spin_lock(&_cpus_lock);
 }
 
-void rt_hw_context_switch_to(rt_uint32_t to)
+void rt_hw_context_switch_to(rt_ubase_t to, struct rt_thread *to_thread)
 {
-    //set to thread
-    rt_interrupt_to_thread = *((rt_uint32_t *)(to));
+    struct sim_cpu *cpu = sim_cpu_self();
+    struct sim_thread *thread_to = SIM_THREAD(to);
 
-    //clear from thread
-    rt_interrupt_from_thread = 0;
+    sim_cpu_set_current(cpu, thread_to);
+    rt_cpus_lock_status_restore(to_thread);
+    sem_post(&thread_to->sem);
 
-    //set interrupt to 1
-    rt_thread_switch_interrupt_flag = 0; //TODO: 还需要考虑这个嵌套切换的情况
+    sim_cpu_tick(sim_cpu_id);
+}
+#else
+void rt_hw_context_switch(rt_ubase_t from, rt_ubase_t to)
+{
+    struct sim_thread *thread_from = SIM_THREAD(from);
+    struct sim_thread *thread_to = SIM_THREAD(to);
+    rt_bool_t closed = sim_thread_closed(from);
 
-    /* enable interrupt
-     * note: NOW, there are only one interrupt in simposix: system tick */
-    rt_hw_interrupt_enable(0);
+    sim_cpu_set_current(sim_cpu_self(), thread_to);
+    sem_post(&thread_to->sem);
 
-    //start the main thread scheduler
-    mainthread_scheduler();
+    if (closed)
+    {
+        sim_thread_exit(thread_from);
+    }
 
-    //never reach here!
-    return;
+    sim_thread_wait(thread_from);
 }
 
-static int mainthread_scheduler(void)
+void rt_hw_context_switch_interrupt(rt_ubase_t from, rt_ubase_t to, rt_thread_t from_thread, rt_thread_t to_thread)
 {
-    int i, res, sig;
-    thread_t *thread_from;
-    thread_t *thread_to;
-    pthread_mutex_t mutex;
-    pthread_mutexattr_t mutexattr;
-    sigset_t  sigmask, oldmask;
+    if (!sim_switch_flag)
+    {
+        sim_switch_flag = 1;
+        sim_switch_from = from;
+    }
+    sim_switch_to = to;
+}
 
-    /* save the main thread id */
-    mainthread_pid = pthread_self();
-    TRACE("pid <%08x> mainthread\n", (unsigned int)(mainthread_pid));
+void rt_hw_context_switch_to(rt_ubase_t to)
+{
+    struct sim_thread *thread_to = SIM_THREAD(to);
 
-    /* 屏蔽suspend信号和resume信号 */
-    sigemptyset(&sigmask);
-    sigaddset(&sigmask, MSG_SUSPEND);
-    sigaddset(&sigmask, MSG_RESUME);
-    pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
+    sim_cpu_set_current(sim_cpu_self(), thread_to);
+    sem_post(&thread_to->sem);
 
-    sigemptyset(&sigmask);
-    sigaddset(&sigmask, SIGALRM);
+    sim_cpu_tick(0);
+}
+#endif /* RT_USING_SMP */
 
-    /* install signal handler of system tick */
-    signal_install(SIGALRM, mthread_signal_tick);
-    /* install signal handler used to suspend/resume threads */
-    signal_install(MSG_SUSPEND, thread_suspend_signal_handler);
-    signal_install(MSG_RESUME, thread_resume_signal_handler);
+void rt_hw_host_thread_init(void)
+{
+    sigset_t set;
 
-    /* create a mutex and condition val, used to indicate interrupts occrue */
-    ptr_int_mutex = &mutex;
-    pthread_mutexattr_init(&mutexattr);
-    pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE_NP);
-    pthread_mutex_init(ptr_int_mutex, &mutexattr);
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &set, RT_NULL);
+}
 
-    /* start timer */
-    start_sys_timer();
+void rt_hw_interrupt_init(void)
+{
+    struct sigaction act;
 
-    thread_to = (thread_t *) rt_interrupt_to_thread;
-    thread_resume(thread_to);
-    for (;;)
+    rt_memset(&act, 0, sizeof(act));
+    act.sa_handler = sim_irq_signal;
+    act.sa_flags = SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    sigaction(SIM_IRQ_SIGNAL, &act, RT_NULL);
+
+    /* the boot thread of CPU 0 */
+    rt_hw_host_thread_init();
+
+    rt_hw_interrupt_install(SIM_IRQ_TICK, sim_tick_isr, RT_NULL, "tick");
+#ifdef RT_USING_SMP
+    rt_hw_interrupt_install(RT_SCHEDULE_IPI, rt_scheduler_ipi_handler, RT_NULL, "ipi");
+    rt_hw_interrupt_install(RT_SMP_CALL_IPI, rt_smp_call_ipi_handler, RT_NULL, "ipi_call");
+#endif
+}
+
+rt_isr_handler_t rt_hw_interrupt_install(int vector, rt_isr_handler_t handler,
+        void *param, const char *name)
+{
+    rt_isr_handler_t old_handler = RT_NULL;
+
+    if (vector >= 0 && vector < SIM_IRQ_MAX)
     {
-#if 1
-        if (sigwait(&sigmask, &sig) != 0)
-        {
-            printf("mthread: sigwait get unexpected sig %d\n", sig);
-        }
-#else
-        pause();
+        old_handler = sim_irq_desc[vector].handler;
+        sim_irq_desc[vector].param = param;
+#ifdef RT_USING_INTERRUPT_INFO
+        rt_strncpy(sim_irq_desc[vector].name, name ? name : "", RT_NAME_MAX - 1);
+        sim_irq_desc[vector].counter = 0;
 #endif
-        TRACE("mthread:got sig %d\n", sig);
-        /* signal mask sigalrm  屏蔽SIGALRM信号 */
-        pthread_sigmask(SIG_BLOCK, &sigmask, &oldmask);
+        __atomic_store_n(&sim_irq_desc[vector].handler, handler, __ATOMIC_RELEASE);
+    }
+
+    return old_handler;
+}
 
-        // if (systick_signal_flag != 0)
-        if (pthread_mutex_trylock(ptr_int_mutex) == 0)
+void rt_hw_interrupt_mask(int vector)
+{
+    __atomic_fetch_or(&sim_irq_masked, 1U << vector, __ATOMIC_RELEASE);
+}
+
+void rt_hw_interrupt_umask(int vector)
+{
+    int i;
+
+    __atomic_fetch_and(&sim_irq_masked, ~(1U << vector), __ATOMIC_RELEASE);
+
+    for (i = 0; i < RT_CPUS_NR; i++)
+    {
+        if (sim_cpus[i].irq_pending & (1U << vector))
         {
-            tick_interrupt_isr();
-            // systick_signal_flag = 0;
-            pthread_mutex_unlock(ptr_int_mutex);
+            rt_hw_interrupt_raise(vector, 1U << i);
         }
-        else
+    }
+}
+
+void rt_hw_interrupt_raise(int vector, rt_uint32_t cpu_mask)
+{
+    int i;
+    rt_base_t level;
+
+    level = sim_host_enter();
+
+    for (i = 0; i < RT_CPUS_NR; i++)
+    {
+        if (cpu_mask & (1U << i))
         {
-            TRACE("try lock failed.\n");
-        }
+            __atomic_fetch_or(&sim_cpus[i].irq_pending, 1U << vector, __ATOMIC_RELEASE);
 
-        /* 开启SIGALRM信号 */
-        pthread_sigmask(SIG_UNBLOCK, &sigmask, &oldmask);
+            if (!(sim_irq_masked & (1U << vector)))
+            {
+                sim_cpu_kick(&sim_cpus[i]);
+            }
+        }
     }
 
-    return 0;
+    sim_host_leave(level);
 }
 
-/*
- * Setup the systick timer to generate the tick interrupts at the required
- * frequency.
- */
-static void start_sys_timer(void)
+void rt_hw_cpu_idle(void)
 {
-    struct itimerval itimer, oitimer;
-    int us;
+    sigset_t set, old;
 
-    us = 1000000 / RT_TICK_PER_SECOND - 1;
+    sigemptyset(&set);
+    sigaddset(&set, SIM_IRQ_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &set, &old);
 
-    TRACE("start system tick!\n");
-    /* Initialise the structure with the current timer information. */
-    if (0 != getitimer(TIMER_TYPE, &itimer))
+    /* the signal is blocked, so the check and the wait are atomic */
+    if (!sim_irq_ready(sim_cpu_self()))
     {
-        TRACE("get timer failed.\n");
-        exit(EXIT_FAILURE);
+        sigsuspend(&old);
     }
 
-    /* Set the interval between timer events. */
-    itimer.it_interval.tv_sec = 0;
-    itimer.it_interval.tv_usec = us;
-    /* Set the current count-down. */
-    itimer.it_value.tv_sec = 0;
-    itimer.it_value.tv_usec = us;
+    pthread_sigmask(SIG_SETMASK, &old, RT_NULL);
+}
+
+void rt_hw_us_delay(rt_uint32_t us)
+{
+    struct timespec start, now;
 
-    /* Set-up the timer interrupt. */
-    if (0 != setitimer(TIMER_TYPE, &itimer, &oitimer))
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do
     {
-        TRACE("set timer failed.\n");
-        exit(EXIT_FAILURE);
-    }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000000L + (now.tv_nsec - start.tv_nsec) / 1000L < (long)us);
 }
 
-static void mthread_signal_tick(int sig)
+#ifdef RT_USING_CPU_USAGE
+rt_uint64_t rt_cpu_usage_clock(void)
 {
-    int res;
-    pthread_t pid = pthread_self();
+    struct timespec now;
 
-    if (sig == SIGALRM)
-    {
-        TRACE("pid <%x> signal: SIGALRM enter!\n", (unsigned int)pid);
-        //systick_signal_flag = 1;
-        TRACE("pid <%x> signal: SIGALRM leave!\n", (unsigned int)pid);
-    }
-    else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (rt_uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+rt_uint64_t rt_cpu_usage_clock_freq(void)
+{
+    return 1000000000ULL;
+}
+#endif /* RT_USING_CPU_USAGE */
+
+#ifdef RT_USING_SMP
+int rt_hw_cpu_id(void)
+{
+    return sim_cpu_id;
+}
+
+void rt_hw_spin_lock_init(rt_hw_spinlock_t *lock)
+{
+    lock->slock = 0;
+}
+
+void rt_hw_spin_lock(rt_hw_spinlock_t *lock)
+{
+    int loops = 0;
+
+    /*
+     * Not a ticket lock: the virtual CPUs may be more than the host ones, and
+     * the waiter whose turn it is may not be running on the host.
+     */
+    while (__atomic_exchange_n(&lock->slock, 1, __ATOMIC_ACQUIRE) != 0)
     {
-        TRACE("got an unexpected signal <%d>\n", sig);
-        exit(EXIT_FAILURE);
+        while (__atomic_load_n(&lock->slock, __ATOMIC_RELAXED) != 0)
+        {
+            /* the owner may be preempted by the host */
+            if (++loops == SIM_SPIN_YIELD_LOOPS)
+            {
+                loops = 0;
+                sched_yield();
+            }
+            else
+            {
+                rt_hw_cpu_relax();
+            }
+        }
     }
 }
 
-/* isr return value: 1, should not be masked, if 0, can be masked */
-static int tick_interrupt_isr(void)
+void rt_hw_spin_unlock(rt_hw_spinlock_t *lock)
 {
-    TRACE("isr: systick enter!\n");
-    /* enter interrupt */
-    rt_interrupt_enter();
+    __atomic_store_n(&lock->slock, 0, __ATOMIC_RELEASE);
+}
 
-    rt_tick_increase();
+void rt_hw_ipi_send(int ipi_vector, unsigned int cpu_mask)
+{
+    rt_hw_interrupt_raise(ipi_vector, cpu_mask);
+}
+
+static void *sim_secondary_cpu_entry(void *parameter)
+{
+    rt_hw_host_thread_init();
+
+    sim_cpu_id = (int)(rt_ubase_t)parameter;
+
+    rt_hw_spin_lock(&_cpus_lock);
+    rt_system_scheduler_start();
 
-    /* leave interrupt */
-    rt_interrupt_leave();
+    /* never come back */
+    return RT_NULL;
+}
+
+void rt_hw_secondary_cpu_up(void)
+{
+    int i, err;
+    pthread_t pthread;
+    rt_base_t level;
 
-    TRACE("isr: systick leave!\n");
-    return 0;
+    for (i = 1; i < RT_CPUS_NR; i++)
+    {
+        level = sim_host_enter();
+        err = pthread_create(&pthread, RT_NULL, sim_secondary_cpu_entry, (void *)(rt_ubase_t)i);
+        if (err == 0)
+        {
+            pthread_detach(pthread);
+        }
+        sim_host_leave(level);
+
+        if (err != 0)
+        {
+            rt_kprintf("Call CPU%d on failed: %d\n", i, err);
+        }
+    }
 }
 
+void rt_hw_secondary_cpu_idle_exec(void)
+{
+    rt_hw_cpu_idle();
+}
+#endif /* RT_USING_SMP */
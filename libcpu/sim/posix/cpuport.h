@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#ifndef __CPUPORT_H__
+#define __CPUPORT_H__
+
+#include <rtdef.h>
+
+/*
+ * The simulated interrupts. The vectors below SIM_IRQ_TICK are the IPIs
+ * (RT_SCHEDULE_IPI, RT_STOP_IPI, RT_SMP_CALL_IPI), SIM_IRQ_TICK is the tick
+ * of each CPU, and the others are free for the devices of the BSP.
+ */
+#define SIM_IRQ_MAX             32
+#define SIM_IRQ_TICK            8
+#define SIM_IRQ_DEVICE_BASE     (SIM_IRQ_TICK + 1)
+
+#ifdef RT_USING_SMP
+typedef struct {
+    volatile unsigned long slock;
+} rt_hw_spinlock_t;
+#endif /* RT_USING_SMP */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define rt_hw_cpu_relax()       __asm__ volatile ("pause" ::: "memory")
+#elif defined(__aarch64__)
+#define rt_hw_cpu_relax()       __asm__ volatile ("yield" ::: "memory")
+#else
+#define rt_hw_cpu_relax()       __asm__ volatile ("" ::: "memory")
+#endif
+
+#define rt_hw_wmb()             __atomic_thread_fence(__ATOMIC_RELEASE)
+#define rt_hw_rmb()             __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+/* raise the interrupt on the CPUs in the mask, it is safe in the host threads */
+void rt_hw_interrupt_raise(int vector, rt_uint32_t cpu_mask);
+
+/* wait for the interrupt as the WFI, for the idle hook of the BSP */
+void rt_hw_cpu_idle(void);
+
+/* make the host thread not interrupted by the simulated interrupts */
+void rt_hw_host_thread_init(void);
+
+#endif /* __CPUPORT_H__ */
@@ -95,6 +95,11 @@ void rt_tick_increase(void)
 
     RT_OBJECT_HOOK_CALL(rt_tick_hook, ());
 
+#ifdef RT_USING_RCU
+    /* before the lock below, which disables the preemption */
+    rt_rcu_tick();
+#endif /* RT_USING_RCU */
+
     level = rt_hw_interrupt_disable();
 
     /* increase the global tick */
@@ -107,6 +112,32 @@ void rt_tick_increase(void)
     /* check time slice */
     thread = rt_thread_self();
 
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->dl.runtime != 0)
+    {
+        /* deadline thread consumes the runtime budget instead of time slice */
+        rt_sched_deadline_tick(thread);
+        rt_hw_interrupt_enable(level);
+
+        /* check timer */
+        rt_timer_check();
+        return;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    if (rt_sched_group_tick(thread))
+    {
+        /* the group is out of the quota, the thread is parked */
+        rt_hw_interrupt_enable(level);
+        rt_schedule();
+
+        /* check timer */
+        rt_timer_check();
+        return;
+    }
+#endif /* RT_USING_SCHED_GROUP */
+
     -- thread->remaining_tick;
     if (thread->remaining_tick == 0)
     {
@@ -265,6 +265,11 @@ int rtthread_startup(void)
     /* idle thread initialization */
     rt_thread_idle_init();
 
+#ifdef RT_USING_RCU
+    /* rcu thread initialization */
+    rt_rcu_init();
+#endif /* RT_USING_RCU */
+
 #ifdef RT_USING_SMP
     rt_hw_spin_lock(&_cpus_lock);
 #endif /* RT_USING_SMP */
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_SMP
+#define CPU_USAGE_NR            RT_CPUS_NR
+#define CPU_USAGE_ID()          rt_hw_cpu_id()
+#else
+#define CPU_USAGE_NR            1
+#define CPU_USAGE_ID()          0
+#define rt_hw_local_irq_disable rt_hw_interrupt_disable
+#define rt_hw_local_irq_enable  rt_hw_interrupt_enable
+#endif /* RT_USING_SMP */
+
+enum
+{
+    CPU_USAGE_STATE_SYSTEM = 0,
+    CPU_USAGE_STATE_USER,
+    CPU_USAGE_STATE_IRQ,
+    CPU_USAGE_STATE_IDLE,
+};
+
+struct cpu_usage_data
+{
+    struct rt_cpu_usage usage;
+
+    struct rt_thread *thread;                           /**< the thread being charged */
+    rt_uint64_t stamp;                                  /**< clock of the last accounting */
+    rt_uint8_t  state;                                  /**< where the time goes now */
+    rt_uint8_t  task_state;                             /**< state to restore when leaving irq */
+};
+
+static struct cpu_usage_data _cpu_usage[CPU_USAGE_NR];
+
+/**
+ * @brief This function will return the clock used for CPU time accounting.
+ *
+ * @note The default implementation is tick granular. The architecture should
+ *       override it with a free running cycle or system counter, together
+ *       with rt_cpu_usage_clock_freq().
+ *
+ * @return the current value of the clock.
+ */
+rt_weak rt_uint64_t rt_cpu_usage_clock(void)
+{
+    return rt_tick_get();
+}
+
+/**
+ * @brief This function will return the frequency of rt_cpu_usage_clock().
+ *
+ * @return the counts of the clock per second.
+ */
+rt_weak rt_uint64_t rt_cpu_usage_clock_freq(void)
+{
+    return RT_TICK_PER_SECOND;
+}
+
+/**
+ * @brief This function will convert a cpu usage clock value to nanoseconds.
+ *
+ * @param clock is the value in cpu usage clock.
+ *
+ * @return the value in nanoseconds.
+ */
+rt_uint64_t rt_cpu_usage_to_ns(rt_uint64_t clock)
+{
+    rt_uint64_t freq = rt_cpu_usage_clock_freq();
+
+    return (clock / freq) * 1000000000ULL + (clock % freq) * 1000000000ULL / freq;
+}
+
+/* charge the time since the last accounting to the current state */
+static void _cpu_usage_charge(struct cpu_usage_data *data)
+{
+    rt_uint64_t now, delta;
+
+    now = rt_cpu_usage_clock();
+    delta = now - data->stamp;
+    data->stamp = now;
+
+    switch (data->state)
+    {
+    case CPU_USAGE_STATE_USER:
+        data->usage.user += delta;
+        if (data->thread)
+        {
+            data->thread->user_time += delta;
+        }
+        break;
+    case CPU_USAGE_STATE_SYSTEM:
+        data->usage.system += delta;
+        if (data->thread)
+        {
+            data->thread->system_time += delta;
+        }
+        break;
+    case CPU_USAGE_STATE_IRQ:
+        data->usage.irq += delta;
+        break;
+    case CPU_USAGE_STATE_IDLE:
+        data->usage.idle += delta;
+        if (data->thread)
+        {
+            data->thread->system_time += delta;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief This function will be invoked by scheduler when switching to a new thread.
+ *
+ * @param to is the thread to be switched to.
+ *
+ * @note Please don't invoke this routine in application
+ */
+void rt_cpu_usage_switch(struct rt_thread *to)
+{
+    rt_base_t level;
+    rt_uint8_t state;
+    struct cpu_usage_data *data;
+
+    level = rt_hw_local_irq_disable();
+    data = &_cpu_usage[CPU_USAGE_ID()];
+
+    _cpu_usage_charge(data);
+    data->thread = to;
+
+    /* the thread is always resumed in kernel, returning to user is accounted later */
+    state = (to == rt_thread_idle_gethandler()) ? CPU_USAGE_STATE_IDLE : CPU_USAGE_STATE_SYSTEM;
+    if (data->state == CPU_USAGE_STATE_IRQ)
+    {
+        data->task_state = state;
+    }
+    else
+    {
+        data->state = state;
+    }
+    rt_hw_local_irq_enable(level);
+}
+
+/**
+ * @brief This function will be invoked by BSP when the outermost interrupt
+ *        service routine is entered.
+ *
+ * @note Please don't invoke this routine in application
+ */
+void rt_cpu_usage_irq_enter(void)
+{
+    struct cpu_usage_data *data = &_cpu_usage[CPU_USAGE_ID()];
+
+    _cpu_usage_charge(data);
+    data->task_state = data->state;
+    data->state = CPU_USAGE_STATE_IRQ;
+}
+
+/**
+ * @brief This function will be invoked by BSP when the outermost interrupt
+ *        service routine is left.
+ *
+ * @note Please don't invoke this routine in application
+ */
+void rt_cpu_usage_irq_leave(void)
+{
+    struct cpu_usage_data *data = &_cpu_usage[CPU_USAGE_ID()];
+
+    _cpu_usage_charge(data);
+    data->state = data->task_state;
+}
+
+/**
+ * @brief This function will be invoked by architecture before returning to user mode.
+ *
+ * @note Please don't invoke this routine in application
+ */
+void rt_cpu_usage_user_enter(void)
+{
+    rt_base_t level;
+    struct cpu_usage_data *data;
+
+    level = rt_hw_local_irq_disable();
+    data = &_cpu_usage[CPU_USAGE_ID()];
+    if (data->state == CPU_USAGE_STATE_SYSTEM)
+    {
+        _cpu_usage_charge(data);
+        data->state = CPU_USAGE_STATE_USER;
+    }
+    rt_hw_local_irq_enable(level);
+}
+
+/**
+ * @brief This function will be invoked by architecture when an exception
+ *        is taken from user mode.
+ *
+ * @note Please don't invoke this routine in application
+ */
+void rt_cpu_usage_user_exit(void)
+{
+    rt_base_t level;
+    struct cpu_usage_data *data;
+
+    level = rt_hw_local_irq_disable();
+    data = &_cpu_usage[CPU_USAGE_ID()];
+    if (data->state == CPU_USAGE_STATE_USER)
+    {
+        _cpu_usage_charge(data);
+        data->state = CPU_USAGE_STATE_SYSTEM;
+    }
+    rt_hw_local_irq_enable(level);
+}
+
+/**
+ * @brief This function will get the CPU time statistics of a CPU.
+ *
+ * @param cpu is the index of the CPU.
+ *
+ * @param usage is the buffer to store the statistics.
+ *
+ * @return Return the operation status. If the return value is RT_EOK, the function is successfully executed.
+ *         If the return value is any other values, it means this operation failed.
+ */
+rt_err_t rt_cpu_usage_get(int cpu, struct rt_cpu_usage *usage)
+{
+    rt_base_t level;
+    rt_uint64_t delta;
+    struct cpu_usage_data *data;
+
+    if (cpu < 0 || cpu >= CPU_USAGE_NR || usage == RT_NULL)
+    {
+        return -RT_EINVAL;
+    }
+
+    level = rt_hw_interrupt_disable();
+    data = &_cpu_usage[cpu];
+    *usage = data->usage;
+
+    /* add the time not yet accounted, the CPU may be busy in other place */
+    delta = rt_cpu_usage_clock() - data->stamp;
+    switch (data->state)
+    {
+    case CPU_USAGE_STATE_USER:
+        usage->user += delta;
+        break;
+    case CPU_USAGE_STATE_SYSTEM:
+        usage->system += delta;
+        break;
+    case CPU_USAGE_STATE_IRQ:
+        usage->irq += delta;
+        break;
+    case CPU_USAGE_STATE_IDLE:
+        usage->idle += delta;
+        break;
+    default:
+        break;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_cpu_usage_get);
+
+/**
+ * @brief This function will get the CPU time of a thread, including the time
+ *        it has been running since the last accounting.
+ *
+ * @param thread is the thread to be queried.
+ *
+ * @param utime is the buffer to store the time in user mode, can be RT_NULL.
+ *
+ * @param stime is the buffer to store the time in kernel mode, can be RT_NULL.
+ */
+void rt_thread_cpu_time(rt_thread_t thread, rt_uint64_t *utime, rt_uint64_t *stime)
+{
+    int cpu;
+    rt_base_t level;
+    rt_uint64_t user, system;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    user = thread->user_time;
+    system = thread->system_time;
+
+    for (cpu = 0; cpu < CPU_USAGE_NR; cpu++)
+    {
+        struct cpu_usage_data *data = &_cpu_usage[cpu];
+
+        if (data->thread == thread)
+        {
+            rt_uint64_t delta = rt_cpu_usage_clock() - data->stamp;
+
+            if (data->state == CPU_USAGE_STATE_USER)
+            {
+                user += delta;
+            }
+            else if (data->state != CPU_USAGE_STATE_IRQ)
+            {
+                system += delta;
+            }
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (utime)
+    {
+        *utime = user;
+    }
+    if (stime)
+    {
+        *stime = system;
+    }
+}
+RTM_EXPORT(rt_thread_cpu_time);
+
+#ifdef RT_USING_FINSH
+#include <stdlib.h>
+#include <finsh.h>
+
+#define TOP_THREAD_NR   32
+
+struct top_thread_sample
+{
+    rt_thread_t thread;
+    rt_uint64_t time;
+};
+
+static int _top_sample_threads(struct top_thread_sample *samples, int nr)
+{
+    int count = 0;
+    rt_base_t level;
+    struct rt_list_node *node;
+    struct rt_object_information *info;
+
+    info = rt_object_get_information(RT_Object_Class_Thread);
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &info->object_list)
+    {
+        rt_uint64_t utime, stime;
+        rt_thread_t thread = rt_list_entry(node, struct rt_thread, parent.list);
+
+        if (count >= nr)
+        {
+            break;
+        }
+        rt_thread_cpu_time(thread, &utime, &stime);
+        samples[count].thread = thread;
+        samples[count].time = utime + stime;
+        count++;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return count;
+}
+
+/* print permille as a percentage with one decimal */
+static void _top_print_ratio(rt_uint64_t part, rt_uint64_t total)
+{
+    rt_uint32_t permille = total ? (rt_uint32_t)(part * 1000 / total) : 0;
+
+    rt_kprintf(" %3d.%d%%", permille / 10, permille % 10);
+}
+
+static int cmd_top(int argc, char **argv)
+{
+    int cpu, i, j, count;
+    rt_int32_t ms = 1000;
+    rt_uint64_t start, elapsed;
+    struct rt_cpu_usage before[CPU_USAGE_NR], after[CPU_USAGE_NR];
+    struct top_thread_sample *samples;
+
+    if (argc > 1)
+    {
+        ms = atoi(argv[1]);
+        if (ms <= 0)
+        {
+            rt_kprintf("Usage: top [interval ms]\n");
+            return -RT_EINVAL;
+        }
+    }
+
+    samples = rt_malloc(sizeof(*samples) * TOP_THREAD_NR);
+    if (samples == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    for (cpu = 0; cpu < CPU_USAGE_NR; cpu++)
+    {
+        rt_cpu_usage_get(cpu, &before[cpu]);
+    }
+    count = _top_sample_threads(samples, TOP_THREAD_NR);
+    start = rt_cpu_usage_clock();
+
+    rt_thread_mdelay(ms);
+
+    elapsed = rt_cpu_usage_clock() - start;
+    for (cpu = 0; cpu < CPU_USAGE_NR; cpu++)
+    {
+        rt_cpu_usage_get(cpu, &after[cpu]);
+    }
+
+    rt_kprintf("cpu     user  system     irq    idle\n");
+    rt_kprintf("---  ------- ------- ------- -------\n");
+    for (cpu = 0; cpu < CPU_USAGE_NR; cpu++)
+    {
+        rt_uint64_t user = after[cpu].user - before[cpu].user;
+        rt_uint64_t system = after[cpu].system - before[cpu].system;
+        rt_uint64_t irq = after[cpu].irq - before[cpu].irq;
+        rt_uint64_t idle = after[cpu].idle - before[cpu].idle;
+        rt_uint64_t total = user + system + irq + idle;
+
+        rt_kprintf("%3d", cpu);
+        _top_print_ratio(user, total);
+        _top_print_ratio(system, total);
+        _top_print_ratio(irq, total);
+        _top_print_ratio(idle, total);
+        rt_kprintf("\n");
+    }
+
+    rt_kprintf("\n%-*.*s    cpu%%     user(ms)   system(ms)\n", RT_NAME_MAX, RT_NAME_MAX, "thread");
+    for (i = 0; i < count; i++)
+    {
+        rt_base_t level;
+        rt_uint64_t utime = 0, stime = 0;
+        struct rt_list_node *node;
+        struct rt_object_information *info;
+        char name[RT_NAME_MAX];
+
+        /* the thread may have gone during sampling, look it up again */
+        info = rt_object_get_information(RT_Object_Class_Thread);
+        j = 0;
+        level = rt_hw_interrupt_disable();
+        rt_list_for_each(node, &info->object_list)
+        {
+            if (rt_list_entry(node, struct rt_thread, parent.list) == samples[i].thread)
+            {
+                rt_thread_cpu_time(samples[i].thread, &utime, &stime);
+                rt_strncpy(name, samples[i].thread->parent.name, RT_NAME_MAX);
+                j = 1;
+                break;
+            }
+        }
+        rt_hw_interrupt_enable(level);
+
+        if (!j)
+        {
+            continue;
+        }
+
+        rt_kprintf("%-*.*s", RT_NAME_MAX, RT_NAME_MAX, name);
+        _top_print_ratio(utime + stime - samples[i].time, elapsed);
+        rt_kprintf(" %12d %12d\n", (rt_uint32_t)(rt_cpu_usage_to_ns(utime) / 1000000),
+                   (rt_uint32_t)(rt_cpu_usage_to_ns(stime) / 1000000));
+    }
+
+    rt_free(samples);
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_top, top, show cpu usage of cpus and threads);
+#endif /* RT_USING_FINSH */
@@ -257,6 +257,9 @@ static void idle_thread_entry(void *parameter)
     {
         while (1)
         {
+#ifdef RT_USING_RCU
+            rt_rcu_quiescent();
+#endif /* RT_USING_RCU */
             rt_hw_secondary_cpu_idle_exec();
         }
     }
@@ -264,6 +267,10 @@ static void idle_thread_entry(void *parameter)
 
     while (1)
     {
+#ifdef RT_USING_RCU
+        rt_rcu_quiescent();
+#endif /* RT_USING_RCU */
+
 #ifdef RT_USING_IDLE_HOOK
         rt_size_t i;
         void (*idle_hook)(void);
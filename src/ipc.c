@@ -44,6 +44,7 @@
  * 2022-04-08     Stanley      Correct descriptions
  * 2022-10-15     Bernard      add nested mutex feature
  * 2022-10-16     Bernard      add prioceiling feature in mutex
+ * 2023-10-18     RT-Thread    add optimistic spinning and statistics of mutex
  */
 
 #include <rtthread.h>
@@ -766,6 +767,14 @@ rt_inline rt_uint8_t _thread_get_mutex_priority(struct rt_thread* thread)
     struct rt_mutex *mutex = RT_NULL;
     rt_uint8_t priority = thread->init_priority;
 
+#ifdef RT_USING_SCHED_DEADLINE
+    /* a deadline thread stays on the level of the deadline class */
+    if (thread->dl.runtime != 0)
+    {
+        priority = RT_SCHED_DEADLINE_PRIORITY;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
     rt_list_for_each(node, &(thread->taken_object_list))
     {
         mutex = rt_list_entry(node, struct rt_mutex, taken_list);
@@ -881,6 +890,11 @@ rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
     mutex->hold     = 0;
     mutex->ceiling_priority = 0xFF;
     rt_list_init(&(mutex->taken_list));
+#ifdef RT_USING_MUTEX_STAT
+    mutex->contended = 0;
+    mutex->spun      = 0;
+    mutex->slept     = 0;
+#endif /* RT_USING_MUTEX_STAT */
 
     /* flag can only be RT_IPC_FLAG_PRIO. RT_IPC_FLAG_FIFO cannot solve the unbounded priority inversion problem */
     mutex->parent.parent.flag = RT_IPC_FLAG_PRIO;
@@ -1079,6 +1093,11 @@ rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
     mutex->hold     = 0;
     mutex->ceiling_priority = 0xFF;
     rt_list_init(&(mutex->taken_list));
+#ifdef RT_USING_MUTEX_STAT
+    mutex->contended = 0;
+    mutex->spun      = 0;
+    mutex->slept     = 0;
+#endif /* RT_USING_MUTEX_STAT */
 
     /* flag can only be RT_IPC_FLAG_PRIO. RT_IPC_FLAG_FIFO cannot solve the unbounded priority inversion problem */
     mutex->parent.parent.flag = RT_IPC_FLAG_PRIO;
@@ -1132,6 +1151,47 @@ rt_err_t rt_mutex_delete(rt_mutex_t mutex)
 RTM_EXPORT(rt_mutex_delete);
 #endif /* RT_USING_HEAP */
 
+#ifdef RT_USING_MUTEX_SPIN
+/* the owner is running on another CPU and nobody waits for the mutex */
+rt_inline rt_bool_t _mutex_can_spin(rt_mutex_t mutex, struct rt_thread *thread)
+{
+    struct rt_thread *owner = mutex->owner;
+
+    return rt_list_isempty(&mutex->parent.suspend_thread) &&
+           (owner->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING &&
+           owner->oncpu != RT_CPU_DETACHED && owner->oncpu != thread->oncpu;
+}
+
+/**
+ * @brief    This function spins without the lock while the owner of the mutex keeps running.
+ *
+ * @param    mutex is a pointer to a mutex object.
+ *
+ * @param    owner is the owner of the mutex when the spinning starts.
+ *
+ * @note     It returns when the owner releases the mutex, the owner is switched out, or the
+ *           budget RT_MUTEX_SPIN_COUNT is used up, the caller takes the mutex again anyway.
+ *           The owner is checked under the lock, while it still owns the mutex, so a thread
+ *           released and freed in the meantime is never touched.
+ */
+static void _mutex_spin_on_owner(rt_mutex_t mutex, struct rt_thread *owner)
+{
+    rt_uint32_t count;
+    rt_base_t level;
+    rt_bool_t running = RT_TRUE;
+
+    for (count = 0; count < RT_MUTEX_SPIN_COUNT && running; count++)
+    {
+        rt_hw_cpu_relax();
+
+        level = rt_hw_interrupt_disable();
+        running = mutex->owner == owner &&
+                  (owner->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING;
+        rt_hw_interrupt_enable(level);
+    }
+}
+#endif /* RT_USING_MUTEX_SPIN */
+
 
 /**
  * @brief    This function will take a mutex, if the mutex is unavailable, the thread shall wait for
@@ -1161,6 +1221,9 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
     rt_base_t level;
     struct rt_thread *thread;
     rt_err_t ret;
+#ifdef RT_USING_MUTEX_SPIN
+    rt_bool_t spun = RT_FALSE;
+#endif /* RT_USING_MUTEX_SPIN */
 
     /* this function must not be used in interrupt even if time = 0 */
     /* current context checking */
@@ -1185,6 +1248,9 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
     /* reset thread error */
     thread->error = RT_EOK;
 
+#ifdef RT_USING_MUTEX_SPIN
+__retry:
+#endif /* RT_USING_MUTEX_SPIN */
     if (mutex->owner == thread)
     {
         if(mutex->hold < RT_MUTEX_HOLD_MAX)
@@ -1208,6 +1274,13 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
             mutex->priority = 0xff;
             mutex->hold     = 1;
 
+#if defined(RT_USING_MUTEX_SPIN) && defined(RT_USING_MUTEX_STAT)
+            if (spun)
+            {
+                mutex->spun ++;
+            }
+#endif /* RT_USING_MUTEX_SPIN && RT_USING_MUTEX_STAT */
+
             if (mutex->ceiling_priority != 0xFF)
             {
                 /* set the priority of thread to the ceiling priority */
@@ -1220,6 +1293,31 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
         }
         else
         {
+#ifdef RT_USING_MUTEX_STAT
+#ifdef RT_USING_MUTEX_SPIN
+            if (!spun)
+#endif /* RT_USING_MUTEX_SPIN */
+            {
+                mutex->contended ++;
+            }
+#endif /* RT_USING_MUTEX_STAT */
+
+#ifdef RT_USING_MUTEX_SPIN
+            /* spin once before the suspension, the owner may release it soon */
+            if (timeout != 0 && !spun && _mutex_can_spin(mutex, thread))
+            {
+                struct rt_thread *owner = mutex->owner;
+
+                spun = RT_TRUE;
+
+                rt_hw_interrupt_enable(level);
+                _mutex_spin_on_owner(mutex, owner);
+                level = rt_hw_interrupt_disable();
+
+                goto __retry;
+            }
+#endif /* RT_USING_MUTEX_SPIN */
+
             /* no waiting, return with timeout */
             if (timeout == 0)
             {
@@ -1253,6 +1351,10 @@ static rt_err_t _rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout, int suspend
                 /* set pending object in thread to this mutex */
                 thread->pending_object = &(mutex->parent.parent);
 
+#ifdef RT_USING_MUTEX_STAT
+                mutex->slept ++;
+#endif /* RT_USING_MUTEX_STAT */
+
                 /* update the priority level of mutex */
                 if (priority < mutex->priority)
                 {
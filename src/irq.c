@@ -84,6 +84,12 @@ rt_weak void rt_interrupt_enter(void)
 
     level = rt_hw_interrupt_disable();
     rt_interrupt_nest ++;
+#ifdef RT_USING_CPU_USAGE
+    if (rt_interrupt_nest == 1)
+    {
+        rt_cpu_usage_irq_enter();
+    }
+#endif /* RT_USING_CPU_USAGE */
     RT_OBJECT_HOOK_CALL(rt_interrupt_enter_hook,());
     rt_hw_interrupt_enable(level);
 
@@ -109,6 +115,12 @@ rt_weak void rt_interrupt_leave(void)
 
     level = rt_hw_interrupt_disable();
     RT_OBJECT_HOOK_CALL(rt_interrupt_leave_hook,());
+#ifdef RT_USING_CPU_USAGE
+    if (rt_interrupt_nest == 1)
+    {
+        rt_cpu_usage_irq_leave();
+    }
+#endif /* RT_USING_CPU_USAGE */
     rt_interrupt_nest --;
     rt_hw_interrupt_enable(level);
 }
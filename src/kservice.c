@@ -24,6 +24,7 @@
  * 2022-08-24     Yunjie       make rt_memset word-independent to adapt to ti c28x (16bit word)
  * 2022-08-30     Yunjie       make rt_vsnprintf adapt to ti c28x (16bit int)
  * 2023-02-02     Bernard      add Smart ID for logo version show
+ * 2023-10-18     RT-Thread    make rt_memcmp and rt_strlen weak for the arch routines
  */
 
 #include <rtthread.h>
@@ -394,7 +395,7 @@ RTM_EXPORT(rt_memmove);
  *         If the result > 0, cs is greater than ct.
  *         If the result = 0, cs is equal to ct.
  */
-rt_int32_t rt_memcmp(const void *cs, const void *ct, rt_size_t count)
+rt_weak rt_int32_t rt_memcmp(const void *cs, const void *ct, rt_size_t count)
 {
     const unsigned char *su1 = RT_NULL, *su2 = RT_NULL;
     int res = 0;
@@ -602,7 +603,7 @@ RTM_EXPORT(rt_strcmp);
  *
  * @return The length of string.
  */
-rt_size_t rt_strlen(const char *s)
+rt_weak rt_size_t rt_strlen(const char *s)
 {
     const char *sc = RT_NULL;
 
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * RCU (read-copy-update).
+ *
+ * A reader only disables the preemption of the local cpu, without taking any
+ * shared lock, so the lookups of read-mostly data scale with the cpus. An
+ * updater publishes the new version of the data by rt_rcu_assign_pointer(),
+ * and the old version is freed after a grace period, when every reader which
+ * may still see it has left its read-side critical section.
+ *
+ * On SMP, the grace periods are numbered by a global sequence. A cpu reports
+ * a quiescent state, that it is out of any read-side critical section, by
+ * recording the current sequence when it switches the context, runs the idle
+ * loop, or is ticked with the preemption enabled. rt_rcu_synchronize() starts
+ * a new grace period and waits until all the online cpus have recorded it.
+ * On UP, a reader is never preempted and an updater in thread context never
+ * runs while a reader is inside the section, so the grace period is empty.
+ *
+ * rt_rcu_call() queues a callback, the callbacks are run in batches by the
+ * rcu thread, one grace period for each batch.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_RCU
+
+#ifdef RT_USING_SMP
+/* the sequence of the last started grace period */
+static volatile rt_ubase_t _rcu_gp_seq;
+/* the sequence of the grace period seen by each cpu in a quiescent state */
+static volatile rt_ubase_t _rcu_qs_seq[RT_CPUS_NR];
+#endif /* RT_USING_SMP */
+
+/* the callbacks waiting for the next batch */
+#ifdef RT_USING_SMP
+static struct rt_spinlock _rcu_lock;
+#endif /* RT_USING_SMP */
+static struct rt_rcu_head *_rcu_pending;
+static struct rt_rcu_head **_rcu_tail = &_rcu_pending;
+
+static struct rt_semaphore _rcu_sem;
+static struct rt_thread _rcu_thread;
+rt_align(RT_ALIGN_SIZE)
+static rt_uint8_t _rcu_thread_stack[RT_RCU_THREAD_STACK_SIZE];
+
+/**
+ * @brief   Enter a read-side critical section. The data got by
+ *          rt_rcu_dereference() in the section is valid until
+ *          rt_rcu_read_unlock(). The sections can be nested, and be used
+ *          in interrupt, but the reader must not block in the section.
+ */
+void rt_rcu_read_lock(void)
+{
+#ifdef RT_USING_SMP
+    rt_base_t level;
+    struct rt_thread *thread;
+
+    level = rt_hw_local_irq_disable();
+
+    thread = rt_cpu_self()->current_thread;
+    if (thread)
+    {
+        /* the cpu is not preempted, so no quiescent state until unlock */
+        thread->scheduler_lock_nest++;
+    }
+
+    rt_hw_local_irq_enable(level);
+#else
+    rt_enter_critical();
+#endif /* RT_USING_SMP */
+}
+RTM_EXPORT(rt_rcu_read_lock);
+
+/**
+ * @brief   Leave a read-side critical section.
+ */
+void rt_rcu_read_unlock(void)
+{
+#ifdef RT_USING_SMP
+    rt_base_t level;
+    struct rt_cpu *pcpu;
+    struct rt_thread *thread;
+    rt_bool_t need_schedule = RT_FALSE;
+
+    level = rt_hw_local_irq_disable();
+
+    pcpu = rt_cpu_self();
+    thread = pcpu->current_thread;
+    if (thread)
+    {
+        RT_ASSERT(thread->scheduler_lock_nest > 0);
+        thread->scheduler_lock_nest--;
+
+        /*
+         * unlike rt_exit_critical(), the scheduler is only called if a switch
+         * is delayed by the section, by an interrupt or by a thread woken up
+         * in it, so the readers never take _cpus_lock otherwise
+         */
+        if (thread->scheduler_lock_nest == 0 &&
+            (pcpu->irq_switch_flag || pcpu->critical_switch_flag))
+        {
+            need_schedule = RT_TRUE;
+        }
+    }
+
+    rt_hw_local_irq_enable(level);
+
+    if (need_schedule)
+    {
+        rt_schedule();
+    }
+#else
+    rt_exit_critical();
+#endif /* RT_USING_SMP */
+}
+RTM_EXPORT(rt_rcu_read_unlock);
+
+/**
+ * @brief   Report a quiescent state of the local cpu. It is called by the
+ *          scheduler on the context switch and by the idle loop, where the
+ *          cpu is out of any read-side critical section.
+ */
+void rt_rcu_quiescent(void)
+{
+#ifdef RT_USING_SMP
+    int cpu = rt_hw_cpu_id();
+    rt_ubase_t seq = _rcu_gp_seq;
+
+    if (_rcu_qs_seq[cpu] != seq)
+    {
+        /* the accesses of the previous readers are done before the report */
+        rt_hw_dmb();
+        _rcu_qs_seq[cpu] = seq;
+    }
+#endif /* RT_USING_SMP */
+}
+
+/**
+ * @brief   Check the quiescent state on the tick of the local cpu. The
+ *          interrupted thread is out of any read-side critical section if
+ *          the preemption is enabled.
+ */
+void rt_rcu_tick(void)
+{
+#ifdef RT_USING_SMP
+    struct rt_thread *thread = rt_cpu_self()->current_thread;
+
+    if (thread && thread->scheduler_lock_nest == 0)
+    {
+        rt_rcu_quiescent();
+    }
+#endif /* RT_USING_SMP */
+}
+
+/**
+ * @brief   Wait for a grace period, after which all the read-side critical
+ *          sections started before the call are finished, so the data
+ *          unpublished before the call can be freed.
+ *
+ * @note    It blocks for a few ticks on SMP, so it must be called in thread
+ *          context and out of any read-side critical section.
+ */
+void rt_rcu_synchronize(void)
+{
+#ifdef RT_USING_SMP
+    int cpu;
+    rt_base_t level;
+    rt_ubase_t seq;
+    struct rt_cpu *pcpu;
+
+    RT_DEBUG_SCHEDULER_AVAILABLE(RT_TRUE);
+
+    /* the unpublishing is visible before the grace period starts */
+    rt_hw_dmb();
+
+    level = rt_hw_interrupt_disable();
+    seq = ++_rcu_gp_seq;
+    rt_hw_interrupt_enable(level);
+
+    /* the caller is in a quiescent state itself */
+    level = rt_hw_local_irq_disable();
+    rt_rcu_quiescent();
+    rt_hw_local_irq_enable(level);
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        pcpu = rt_cpu_index(cpu);
+
+        /* an offline cpu has no reader */
+        while (pcpu->current_thread != RT_NULL &&
+               (rt_base_t)(_rcu_qs_seq[cpu] - seq) < 0)
+        {
+            rt_thread_delay(1);
+        }
+    }
+
+    /* the frees by the caller are after the readers of the grace period */
+    rt_hw_dmb();
+#else
+    RT_DEBUG_SCHEDULER_AVAILABLE(RT_TRUE);
+#endif /* RT_USING_SMP */
+}
+RTM_EXPORT(rt_rcu_synchronize);
+
+/**
+ * @brief   Call the function after a grace period, to free the unpublished
+ *          data without blocking the caller. The callbacks are called in
+ *          the order of queuing by the rcu thread. It can be called in
+ *          interrupt.
+ *
+ * @param   head is the rcu head embedded in the data.
+ *
+ * @param   func is the function to call with the head.
+ */
+void rt_rcu_call(struct rt_rcu_head *head, void (*func)(struct rt_rcu_head *head))
+{
+    rt_base_t level;
+    rt_bool_t wakeup;
+
+    RT_ASSERT(head != RT_NULL);
+    RT_ASSERT(func != RT_NULL);
+
+    head->next = RT_NULL;
+    head->func = func;
+
+    level = rt_spin_lock_irqsave(&_rcu_lock);
+    /* the thread is woken up by the first callback of a batch */
+    wakeup = (_rcu_pending == RT_NULL);
+    *_rcu_tail = head;
+    _rcu_tail = &head->next;
+    rt_spin_unlock_irqrestore(&_rcu_lock, level);
+
+    if (wakeup)
+    {
+        rt_sem_release(&_rcu_sem);
+    }
+}
+RTM_EXPORT(rt_rcu_call);
+
+struct _rcu_barrier
+{
+    struct rt_rcu_head head;
+    struct rt_semaphore sem;
+};
+
+static void _rcu_barrier_func(struct rt_rcu_head *head)
+{
+    struct _rcu_barrier *barrier = rt_container_of(head, struct _rcu_barrier, head);
+
+    rt_sem_release(&barrier->sem);
+}
+
+/**
+ * @brief   Wait until all the callbacks queued before are called, e.g. before
+ *          unloading the code of the callbacks.
+ */
+void rt_rcu_barrier(void)
+{
+    struct _rcu_barrier barrier;
+
+    RT_DEBUG_SCHEDULER_AVAILABLE(RT_TRUE);
+
+    rt_sem_init(&barrier.sem, "rcu_bar", 0, RT_IPC_FLAG_PRIO);
+    rt_rcu_call(&barrier.head, _rcu_barrier_func);
+    rt_sem_take(&barrier.sem, RT_WAITING_FOREVER);
+    rt_sem_detach(&barrier.sem);
+}
+RTM_EXPORT(rt_rcu_barrier);
+
+static void _rcu_thread_entry(void *parameter)
+{
+    rt_base_t level;
+    struct rt_rcu_head *head, *next;
+
+    while (1)
+    {
+        rt_sem_take(&_rcu_sem, RT_WAITING_FOREVER);
+
+        level = rt_spin_lock_irqsave(&_rcu_lock);
+        head = _rcu_pending;
+        _rcu_pending = RT_NULL;
+        _rcu_tail = &_rcu_pending;
+        rt_spin_unlock_irqrestore(&_rcu_lock, level);
+
+        if (head == RT_NULL)
+        {
+            continue;
+        }
+
+        /* one grace period for all the callbacks queued in the meantime */
+        rt_rcu_synchronize();
+
+        while (head != RT_NULL)
+        {
+            next = head->next;
+            head->func(head);
+            head = next;
+        }
+    }
+}
+
+/**
+ * @brief   Initialize RCU and start the rcu thread.
+ *
+ * @note    This function must be invoked when system init.
+ */
+void rt_rcu_init(void)
+{
+    rt_spin_lock_init(&_rcu_lock);
+    rt_sem_init(&_rcu_sem, "rcu", 0, RT_IPC_FLAG_PRIO);
+
+    rt_thread_init(&_rcu_thread,
+                   "rcu",
+                   _rcu_thread_entry,
+                   RT_NULL,
+                   &_rcu_thread_stack[0],
+                   sizeof(_rcu_thread_stack),
+                   RT_RCU_THREAD_PRIO,
+                   10);
+
+    rt_thread_startup(&_rcu_thread);
+}
+
+#endif /* RT_USING_RCU */
@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * Deadline scheduling class.
+ *
+ * The deadline threads run on the priority level RT_SCHED_DEADLINE_PRIORITY,
+ * and are sorted by the absolute deadline in the ready queue of that level
+ * (EDF), ahead of the normal threads of the same level, so they run above all
+ * the normal threads. Each thread reserves the bandwidth
+ * runtime / period on one cpu, the reservation is refused if the bandwidth of
+ * that cpu would exceed RT_SCHED_DEADLINE_BW_LIMIT percent, so the deadline
+ * threads of a cpu are always schedulable.
+ *
+ * The budget is enforced by the Constant Bandwidth Server: the runtime is
+ * consumed on each tick, a thread runs out of the budget is throttled until
+ * the start of the next period, and a woken up thread gets a new deadline if
+ * the budget left could not be consumed before the old one with its bandwidth.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_SCHED_DEADLINE
+
+#define DBG_TAG           "kernel.dl"
+#define DBG_LVL           DBG_INFO
+#include <rtdbg.h>
+
+#ifdef RT_USING_SMP
+#define DL_CPUS_NR        RT_CPUS_NR
+#else
+#define DL_CPUS_NR        1
+#endif /* RT_USING_SMP */
+
+#define DL_BW_LIMIT       (((rt_uint64_t)RT_SCHED_DEADLINE_BW_LIMIT << RT_SCHED_DEADLINE_BW_SHIFT) / 100)
+
+/* tick a is before tick b */
+#define DL_TICK_BEFORE(a, b)    ((rt_tick_t)((a) - (b)) >= RT_TICK_MAX / 2)
+
+/* the bandwidth reserved on each cpu */
+static rt_uint32_t _dl_cpu_bw[DL_CPUS_NR];
+
+static void _dl_replenish(void *parameter)
+{
+    struct rt_thread *thread = (struct rt_thread *)parameter;
+    struct rt_thread_deadline *dl = &thread->dl;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+
+    if (!dl->throttled)
+    {
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+
+    /* a new period starts */
+    dl->throttled = 0;
+    dl->abs_deadline += dl->period;
+    dl->runtime_left = dl->runtime;
+
+    rt_hw_interrupt_enable(level);
+
+    rt_thread_resume(thread);
+    rt_schedule();
+}
+
+/* the current job of thread is out of the budget or finished, should be called with interrupt disabled */
+static void _dl_throttle(struct rt_thread *thread)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+    rt_tick_t now, next_period;
+
+    now = rt_tick_get();
+    next_period = dl->abs_deadline - dl->deadline + dl->period;
+
+    /* the thread is being suspended, the budget is checked when it wakes up */
+    if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_RUNNING)
+    {
+        return;
+    }
+
+    if (!DL_TICK_BEFORE(now, next_period))
+    {
+        /* the job overran into the next period, replenish at once with a new deadline */
+        dl->abs_deadline = now + dl->deadline;
+        dl->runtime_left = dl->runtime;
+    }
+    else if (rt_thread_suspend_with_flag(thread, RT_UNINTERRUPTIBLE) == RT_EOK)
+    {
+        rt_tick_t timeout = next_period - now;
+
+        dl->throttled = 1;
+        rt_timer_control(&dl->timer, RT_TIMER_CTRL_SET_TIME, &timeout);
+        rt_timer_start(&dl->timer);
+    }
+
+    rt_schedule();
+}
+
+/* reserve the bandwidth for thread, return the cpu reserved on or -1 */
+static int _dl_admit(struct rt_thread *thread, rt_uint32_t bw, rt_ubase_t cpu_affinity)
+{
+    int cpu, best = -1;
+    rt_uint32_t used, best_used = 0;
+
+    for (cpu = 0; cpu < DL_CPUS_NR; cpu++)
+    {
+        if ((cpu_affinity & (1UL << cpu)) == 0)
+        {
+            continue;
+        }
+
+        used = _dl_cpu_bw[cpu];
+        if (thread->dl.runtime != 0 && thread->dl.cpu == cpu)
+        {
+            used -= thread->dl.bw;
+        }
+
+        /* worst fit: the cpu with the least bandwidth reserved */
+        if ((rt_uint64_t)used + bw <= DL_BW_LIMIT && (best < 0 || used < best_used))
+        {
+            best = cpu;
+            best_used = used;
+        }
+    }
+
+    if (best >= 0)
+    {
+        if (thread->dl.runtime != 0)
+        {
+            _dl_cpu_bw[thread->dl.cpu] -= thread->dl.bw;
+        }
+        _dl_cpu_bw[best] += bw;
+    }
+
+    return best;
+}
+
+static rt_err_t _dl_leave(struct rt_thread *thread)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+    rt_uint8_t priority;
+    rt_uint8_t throttled;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+
+    if (dl->runtime == 0)
+    {
+        rt_hw_interrupt_enable(level);
+        return RT_EOK;
+    }
+
+    _dl_cpu_bw[dl->cpu] -= dl->bw;
+    dl->runtime = 0;
+    throttled = dl->throttled;
+    dl->throttled = 0;
+    rt_timer_detach(&dl->timer);
+    priority = dl->priority;
+
+    rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+#ifdef RT_USING_SMP
+    rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)dl->cpu_affinity);
+#endif /* RT_USING_SMP */
+
+    rt_hw_interrupt_enable(level);
+
+    if (throttled)
+    {
+        rt_thread_resume(thread);
+        rt_schedule();
+    }
+
+    return RT_EOK;
+}
+
+/**
+ * @brief This function will set the deadline scheduling parameters of a
+ *        thread. The thread gets the runtime in each period, and the runtime
+ *        is guaranteed to be served before the relative deadline.
+ *
+ * @param thread is the thread to be set.
+ *
+ * @param runtime is the runtime budget in ticks, 0 to return the thread to
+ *        the fixed priority scheduling.
+ *
+ * @param deadline is the relative deadline in ticks, 0 for the same as period.
+ *
+ * @param period is the period in ticks, 0 for the same as deadline.
+ *
+ * @return RT_EOK on success, -RT_EINVAL if runtime <= deadline <= period is
+ *         not satisfied, -RT_EBUSY if no cpu could reserve the bandwidth.
+ */
+rt_err_t rt_thread_set_deadline(rt_thread_t thread, rt_tick_t runtime, rt_tick_t deadline, rt_tick_t period)
+{
+    struct rt_thread_deadline *dl;
+    rt_ubase_t cpu_affinity = 1;
+    rt_uint8_t priority = RT_SCHED_DEADLINE_PRIORITY;
+    rt_uint32_t bw;
+    rt_base_t level;
+    int cpu;
+
+    RT_ASSERT(thread != RT_NULL);
+    RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
+
+    if (runtime == 0)
+    {
+        return _dl_leave(thread);
+    }
+
+    if (deadline == 0)
+    {
+        deadline = period;
+    }
+    if (period == 0)
+    {
+        period = deadline;
+    }
+    if (runtime > deadline || deadline > period || period >= RT_TICK_MAX / 2)
+    {
+        return -RT_EINVAL;
+    }
+
+    dl = &thread->dl;
+    bw = (rt_uint32_t)(((rt_uint64_t)runtime << RT_SCHED_DEADLINE_BW_SHIFT) / period);
+
+    level = rt_hw_interrupt_disable();
+
+#ifdef RT_USING_SMP
+    cpu_affinity = dl->runtime ? dl->cpu_affinity : thread->cpu_affinity;
+#endif /* RT_USING_SMP */
+
+    cpu = _dl_admit(thread, bw, cpu_affinity);
+    if (cpu < 0)
+    {
+        rt_hw_interrupt_enable(level);
+
+        LOG_D("%.*s: bandwidth %d/%d is not admitted", RT_NAME_MAX, thread->parent.name, runtime, period);
+        return -RT_EBUSY;
+    }
+
+    if (dl->runtime == 0)
+    {
+        dl->priority = thread->current_priority;
+#ifdef RT_USING_SMP
+        dl->cpu_affinity = thread->cpu_affinity;
+#endif /* RT_USING_SMP */
+        dl->throttled = 0;
+        rt_timer_init(&dl->timer, thread->parent.name, _dl_replenish, thread,
+                      0, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+    }
+
+    dl->runtime = runtime;
+    dl->deadline = deadline;
+    dl->period = period;
+    dl->bw = bw;
+    dl->cpu = cpu;
+
+    /* the new parameters take effect from a new job */
+    dl->abs_deadline = rt_tick_get() + deadline;
+    dl->runtime_left = runtime;
+
+    rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+#ifdef RT_USING_SMP
+    /* placed on the cpu reserved, the affinity asked is kept in dl */
+    rt_thread_control(thread, RT_THREAD_CTRL_SET_AFFINITY, (void *)dl->cpu_affinity);
+#endif /* RT_USING_SMP */
+
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_thread_set_deadline);
+
+#ifdef RT_USING_SMP
+/**
+ * @brief Set the cpu affinity of a deadline thread. The mask is kept and
+ *        applied when the thread leaves the deadline class, the bandwidth is
+ *        moved to another cpu if the cpu reserved is not in the mask.
+ *
+ * @note  Should be called by rt_thread_control() with interrupt disabled.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if no cpu in the mask could reserve
+ *         the bandwidth.
+ */
+rt_err_t rt_sched_deadline_affinity(struct rt_thread *thread, rt_ubase_t cpu_affinity)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+    int cpu;
+
+    if ((cpu_affinity & (1UL << dl->cpu)) == 0)
+    {
+        cpu = _dl_admit(thread, dl->bw, cpu_affinity);
+        if (cpu < 0)
+        {
+            return -RT_EBUSY;
+        }
+        dl->cpu = cpu;
+    }
+    dl->cpu_affinity = cpu_affinity;
+
+    return RT_EOK;
+}
+#endif /* RT_USING_SMP */
+
+/**
+ * @brief Get the bandwidth reserved by the deadline threads on a cpu.
+ *
+ * @return the bandwidth, in 1 << RT_SCHED_DEADLINE_BW_SHIFT.
+ */
+rt_uint32_t rt_sched_deadline_bandwidth(int cpu)
+{
+    if (cpu < 0 || cpu >= DL_CPUS_NR)
+    {
+        return 0;
+    }
+
+    return _dl_cpu_bw[cpu];
+}
+
+/**
+ * @brief Check whether a ready thread should preempt the current thread at
+ *        the same priority level.
+ */
+rt_bool_t rt_sched_deadline_preempt(struct rt_thread *current, struct rt_thread *thread)
+{
+    if (thread->dl.runtime == 0)
+    {
+        return RT_FALSE;
+    }
+    if (current->dl.runtime == 0)
+    {
+        return RT_TRUE;
+    }
+
+    return DL_TICK_BEFORE(thread->dl.abs_deadline, current->dl.abs_deadline);
+}
+
+/**
+ * @brief Insert a thread to the ready queue of RT_SCHED_DEADLINE_PRIORITY.
+ *        The deadline threads are sorted by the absolute deadline and are
+ *        ahead of the normal threads.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+void rt_sched_deadline_enqueue(rt_list_t *queue, struct rt_thread *thread)
+{
+    rt_list_t *node;
+    struct rt_thread *entry;
+
+    if (thread->dl.runtime == 0 && (thread->stat & RT_THREAD_STAT_YIELD_MASK) != 0)
+    {
+        /* no time slices left, at the tail of queue */
+        rt_list_insert_before(queue, &thread->tlist);
+        return;
+    }
+
+    rt_list_for_each(node, queue)
+    {
+        entry = rt_list_entry(node, struct rt_thread, tlist);
+
+        if (entry->dl.runtime == 0)
+        {
+            break;
+        }
+        if (thread->dl.runtime != 0 && DL_TICK_BEFORE(thread->dl.abs_deadline, entry->dl.abs_deadline))
+        {
+            break;
+        }
+    }
+
+    rt_list_insert_before(node, &thread->tlist);
+}
+
+/**
+ * @brief The CBS wake up rule: a new deadline is assigned if the budget left
+ *        could not be consumed before the current deadline in the reserved
+ *        bandwidth.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+void rt_sched_deadline_wakeup(struct rt_thread *thread)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+    rt_tick_t now;
+
+    if (dl->runtime == 0 || dl->throttled)
+    {
+        return;
+    }
+
+    now = rt_tick_get();
+
+    /* runtime_left / (abs_deadline - now) > runtime / period */
+    if (!DL_TICK_BEFORE(now, dl->abs_deadline) ||
+        (rt_uint64_t)dl->runtime_left * dl->period > (rt_uint64_t)(dl->abs_deadline - now) * dl->runtime)
+    {
+        dl->abs_deadline = now + dl->deadline;
+        dl->runtime_left = dl->runtime;
+    }
+}
+
+/**
+ * @brief Consume the budget of a running deadline thread.
+ *
+ * @note  Should be called on tick with interrupt disabled.
+ */
+void rt_sched_deadline_tick(struct rt_thread *thread)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+
+    if (dl->runtime_left > 0)
+    {
+        dl->runtime_left--;
+    }
+
+    if (dl->runtime_left == 0)
+    {
+        _dl_throttle(thread);
+    }
+}
+
+/**
+ * @brief The current job of the deadline thread is finished, the thread
+ *        sleeps until the start of the next period.
+ */
+void rt_sched_deadline_yield(struct rt_thread *thread)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+
+    thread->dl.runtime_left = 0;
+    _dl_throttle(thread);
+
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Release the bandwidth of a closing thread.
+ *
+ * @note  Should be called with interrupt disabled.
+ */
+void rt_sched_deadline_exit(struct rt_thread *thread)
+{
+    struct rt_thread_deadline *dl = &thread->dl;
+
+    if (dl->runtime != 0)
+    {
+        _dl_cpu_bw[dl->cpu] -= dl->bw;
+        dl->runtime = 0;
+        dl->throttled = 0;
+        rt_timer_detach(&dl->timer);
+    }
+}
+
+#ifdef RT_USING_FINSH
+static int list_deadline(void)
+{
+    int cpu;
+    rt_base_t level;
+    struct rt_object_information *info;
+    struct rt_list_node *node;
+    struct rt_thread *thread;
+
+    for (cpu = 0; cpu < DL_CPUS_NR; cpu++)
+    {
+        rt_kprintf("cpu %d bandwidth %3d%%\n", cpu,
+                   (int)(((rt_uint64_t)_dl_cpu_bw[cpu] * 100) >> RT_SCHED_DEADLINE_BW_SHIFT));
+    }
+
+    rt_kprintf("%-*s cpu  runtime deadline   period throttled\n", RT_NAME_MAX, "thread");
+
+    info = rt_object_get_information(RT_Object_Class_Thread);
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &info->object_list)
+    {
+        thread = rt_list_entry(node, struct rt_thread, parent.list);
+        if (thread->dl.runtime == 0)
+        {
+            continue;
+        }
+
+        rt_kprintf("%-*.*s %3d %8d %8d %8d %9d\n", RT_NAME_MAX, RT_NAME_MAX, thread->parent.name,
+                   thread->dl.cpu, thread->dl.runtime, thread->dl.deadline, thread->dl.period,
+                   thread->dl.throttled);
+    }
+    rt_hw_interrupt_enable(level);
+
+    return 0;
+}
+MSH_CMD_EXPORT(list_deadline, list deadline threads and the reserved bandwidth);
+#endif /* RT_USING_FINSH */
+
+#endif /* RT_USING_SCHED_DEADLINE */
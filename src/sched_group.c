@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * Group scheduling.
+ *
+ * The groups form a tree under an internal root group, the threads not put
+ * into any group belong to the "kernel" group. The cpu time of a running
+ * thread is charged on each tick to its group and all the ancestors, weighted
+ * by the shares of each group as the virtual runtime. Among the ready threads
+ * of the same priority, the scheduler takes the thread whose group has the
+ * least virtual runtime compared with the sibling group on the path of the
+ * other thread, so the siblings share the cpu in proportion to their shares.
+ * The threads of the same group are still served in the order of the ready
+ * queue. The priorities are never crossed: the groups only share the cpu time
+ * left by the higher priorities.
+ *
+ * A group with a quota may use the quota of cpu time in each period, summed
+ * over all cpus. Once the quota is used up, the group is throttled and its
+ * threads are parked when they are picked or on the next tick, until the
+ * period timer of the group refills the quota.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_SCHED_GROUP
+
+#define DBG_TAG           "kernel.sg"
+#define DBG_LVL           DBG_INFO
+#include <rtdbg.h>
+
+#define SG_SHARES_MIN     2
+#define SG_SHARES_MAX     (1UL << 18)
+
+/* the virtual runtime of one tick of a group */
+#define SG_VTICK(shares)  (((rt_uint64_t)RT_SCHED_GROUP_SHARES_DEFAULT << 16) / (shares))
+
+/* a woken up group is placed this much before the siblings, about 20ms */
+#define SG_WAKEUP_CREDIT  (SG_VTICK(RT_SCHED_GROUP_SHARES_DEFAULT) * (RT_TICK_PER_SECOND / 50 + 1))
+
+static struct rt_sched_group _sg_root;
+static struct rt_sched_group _sg_kernel;
+
+/* all the groups except the root */
+static rt_list_t _sg_list = {&_sg_kernel.list, &_sg_kernel.list};
+
+static struct rt_sched_group _sg_root =
+{
+    .name = "root",
+    .shares = RT_SCHED_GROUP_SHARES_DEFAULT,
+    .ref = 1,
+    .throttled_threads = RT_LIST_OBJECT_INIT(_sg_root.throttled_threads),
+};
+
+static struct rt_sched_group _sg_kernel =
+{
+    .name = "kernel",
+    .parent = &_sg_root,
+    .list = {&_sg_list, &_sg_list},
+    .shares = RT_SCHED_GROUP_SHARES_DEFAULT,
+    .depth = 1,
+    .period = RT_SCHED_GROUP_PERIOD,
+    .throttled_threads = RT_LIST_OBJECT_INIT(_sg_kernel.throttled_threads),
+};
+
+rt_inline struct rt_sched_group *_sg_of(struct rt_thread *thread)
+{
+    return thread->sgroup ? thread->sgroup : &_sg_kernel;
+}
+
+/* the highest throttled group on the path of thread */
+static struct rt_sched_group *_sg_throttled_group(struct rt_thread *thread)
+{
+    struct rt_sched_group *group, *throttled = RT_NULL;
+
+    for (group = _sg_of(thread); group != &_sg_root; group = group->parent)
+    {
+        if (group->throttled)
+        {
+            throttled = group;
+        }
+    }
+
+    return throttled;
+}
+
+static void _sg_resume_all(struct rt_sched_group *group)
+{
+    struct rt_thread *thread;
+
+    while (!rt_list_isempty(&group->throttled_threads))
+    {
+        thread = rt_list_first_entry(&group->throttled_threads, struct rt_thread, tlist);
+        rt_thread_resume(thread);
+    }
+}
+
+/* a new period starts, refill the quota */
+static void _sg_period(void *parameter)
+{
+    struct rt_sched_group *group = (struct rt_sched_group *)parameter;
+    rt_bool_t resumed = RT_FALSE;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+
+    group->runtime = 0;
+    if (group->throttled)
+    {
+        group->throttled = 0;
+        resumed = !rt_list_isempty(&group->throttled_threads);
+        _sg_resume_all(group);
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    if (resumed)
+    {
+        rt_schedule();
+    }
+}
+
+/**
+ * @brief This function will create a scheduling group.
+ *
+ * @param name is the name of the group.
+ *
+ * @param parent is the parent group, RT_NULL for a top level group.
+ *
+ * @return the group, or RT_NULL if the name is in use, the hierarchy is too
+ *         deep or no memory.
+ */
+rt_sched_group_t rt_sched_group_create(const char *name, rt_sched_group_t parent)
+{
+    struct rt_sched_group *group;
+    rt_base_t level;
+
+    RT_ASSERT(name != RT_NULL);
+
+    if (parent == RT_NULL)
+    {
+        parent = &_sg_root;
+    }
+    if (parent == &_sg_kernel || parent->depth >= RT_SCHED_GROUP_DEPTH_MAX)
+    {
+        return RT_NULL;
+    }
+
+    group = (struct rt_sched_group *)rt_calloc(1, sizeof(struct rt_sched_group));
+    if (group == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    rt_strncpy(group->name, name, RT_NAME_MAX);
+    group->shares = RT_SCHED_GROUP_SHARES_DEFAULT;
+    group->period = RT_SCHED_GROUP_PERIOD;
+    rt_list_init(&group->throttled_threads);
+    rt_timer_init(&group->timer, group->name, _sg_period, group, group->period,
+                  RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+
+    level = rt_hw_interrupt_disable();
+    if (rt_sched_group_find(name) != RT_NULL)
+    {
+        rt_hw_interrupt_enable(level);
+        rt_timer_detach(&group->timer);
+        rt_free(group);
+        return RT_NULL;
+    }
+
+    group->parent = parent;
+    group->depth = parent->depth + 1;
+    group->vruntime = parent->min_vruntime;
+    group->min_vruntime = 0;
+    parent->ref++;
+    rt_list_insert_before(&_sg_list, &group->list);
+    rt_hw_interrupt_enable(level);
+
+    return group;
+}
+RTM_EXPORT(rt_sched_group_create);
+
+/* unlink a group to be freed, should be called with interrupt disabled */
+static rt_err_t _sg_unlink(struct rt_sched_group *group)
+{
+    if (group == &_sg_kernel || group == &_sg_root)
+    {
+        return -RT_EINVAL;
+    }
+    if (group->ref != 0)
+    {
+        return -RT_EBUSY;
+    }
+
+    rt_list_remove(&group->list);
+    group->parent->ref--;
+    rt_timer_detach(&group->timer);
+
+    /* the threads moved to other groups may be still parked here */
+    _sg_resume_all(group);
+
+    return RT_EOK;
+}
+
+/**
+ * @brief This function will delete a scheduling group.
+ *
+ * @param group is the group to be deleted.
+ *
+ * @return RT_EOK on success, -RT_EBUSY if any thread, process or child group
+ *         refers to the group, -RT_EINVAL for the kernel group.
+ *
+ * @note  The caller should own the group, a group found by name may be deleted
+ *        by others at the same time, use rt_sched_group_delete_by_name() then.
+ */
+rt_err_t rt_sched_group_delete(rt_sched_group_t group)
+{
+    rt_base_t level;
+    rt_err_t err;
+
+    RT_ASSERT(group != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    err = _sg_unlink(group);
+    rt_hw_interrupt_enable(level);
+
+    if (err == RT_EOK)
+    {
+        rt_free(group);
+    }
+
+    return err;
+}
+RTM_EXPORT(rt_sched_group_delete);
+
+/**
+ * @brief This function will find a scheduling group by name and delete it,
+ *        the lookup and the deletion are done under the same lock.
+ *
+ * @param name is the name of the group.
+ *
+ * @return RT_EOK on success, -RT_ENOENT if not found, or the errors of
+ *         rt_sched_group_delete().
+ */
+rt_err_t rt_sched_group_delete_by_name(const char *name)
+{
+    struct rt_sched_group *group;
+    rt_base_t level;
+    rt_err_t err;
+
+    RT_ASSERT(name != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    group = rt_sched_group_find(name);
+    err = group ? _sg_unlink(group) : -RT_ENOENT;
+    rt_hw_interrupt_enable(level);
+
+    if (err == RT_EOK)
+    {
+        rt_free(group);
+    }
+
+    return err;
+}
+RTM_EXPORT(rt_sched_group_delete_by_name);
+
+/**
+ * @brief This function will find a scheduling group by name.
+ *
+ * @return the group, or RT_NULL if not found.
+ */
+rt_sched_group_t rt_sched_group_find(const char *name)
+{
+    struct rt_sched_group *group, *found = RT_NULL;
+    rt_list_t *node;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &_sg_list)
+    {
+        group = rt_list_entry(node, struct rt_sched_group, list);
+        if (rt_strncmp(group->name, name, RT_NAME_MAX) == 0)
+        {
+            found = group;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return found;
+}
+RTM_EXPORT(rt_sched_group_find);
+
+/**
+ * @brief This function will set the shares of a scheduling group, the ready
+ *        sibling groups get the cpu in proportion to their shares.
+ *
+ * @param shares is the weight, from 2 to 262144.
+ *
+ * @return RT_EOK on success, -RT_EINVAL if the shares is out of range.
+ */
+rt_err_t rt_sched_group_set_shares(rt_sched_group_t group, rt_uint32_t shares)
+{
+    rt_base_t level;
+
+    RT_ASSERT(group != RT_NULL);
+
+    if (shares < SG_SHARES_MIN || shares > SG_SHARES_MAX)
+    {
+        return -RT_EINVAL;
+    }
+
+    level = rt_hw_interrupt_disable();
+    group->shares = shares;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_sched_group_set_shares);
+
+/**
+ * @brief This function will set the cpu bandwidth of a scheduling group. The
+ *        group may use the quota of cpu time, summed over all cpus, in each
+ *        period, and is throttled for the rest of the period then.
+ *
+ * @param quota is the cpu time in ticks, 0 for unlimited.
+ *
+ * @param period is the period in ticks, 0 for RT_SCHED_GROUP_PERIOD.
+ *
+ * @return RT_EOK on success, -RT_EINVAL for the kernel group.
+ */
+rt_err_t rt_sched_group_set_bandwidth(rt_sched_group_t group, rt_tick_t quota, rt_tick_t period)
+{
+    rt_base_t level;
+
+    RT_ASSERT(group != RT_NULL);
+
+    /* the idle threads are in the kernel group */
+    if (group == &_sg_kernel)
+    {
+        return -RT_EINVAL;
+    }
+    if (period == 0)
+    {
+        period = RT_SCHED_GROUP_PERIOD;
+    }
+    if (period >= RT_TICK_MAX / 2)
+    {
+        return -RT_EINVAL;
+    }
+
+    level = rt_hw_interrupt_disable();
+
+    rt_timer_stop(&group->timer);
+    group->quota = quota;
+    group->period = period;
+    group->runtime = 0;
+    if (quota != 0)
+    {
+        rt_timer_control(&group->timer, RT_TIMER_CTRL_SET_TIME, &period);
+        rt_timer_start(&group->timer);
+    }
+
+    if (group->throttled)
+    {
+        group->throttled = 0;
+        _sg_resume_all(group);
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    rt_schedule();
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_sched_group_set_bandwidth);
+
+/**
+ * @brief This function will move a thread to a scheduling group.
+ *
+ * @param group is the group, RT_NULL for the kernel group.
+ *
+ * @param thread is the thread to be moved.
+ *
+ * @return RT_EOK.
+ *
+ * @note  A thread parked by the throttled group before stays parked until
+ *        the next period of that group.
+ */
+rt_err_t rt_sched_group_attach(rt_sched_group_t group, rt_thread_t thread)
+{
+    struct rt_sched_group *old;
+    rt_base_t level;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    if (group == &_sg_kernel)
+    {
+        group = RT_NULL;
+    }
+
+    level = rt_hw_interrupt_disable();
+    old = thread->sgroup;
+    thread->sgroup = rt_sched_group_get(group);
+    rt_sched_group_put(old);
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_sched_group_attach);
+
+/**
+ * @brief This function will take a reference of a scheduling group, which
+ *        prevents it from being deleted.
+ *
+ * @return the group.
+ */
+rt_sched_group_t rt_sched_group_get(rt_sched_group_t group)
+{
+    rt_base_t level;
+
+    if (group != RT_NULL)
+    {
+        level = rt_hw_interrupt_disable();
+        group->ref++;
+        rt_hw_interrupt_enable(level);
+    }
+
+    return group;
+}
+
+/**
+ * @brief This function will release a reference of a scheduling group.
+ */
+void rt_sched_group_put(rt_sched_group_t group)
+{
+    rt_base_t level;
+
+    if (group != RT_NULL)
+    {
+        level = rt_hw_interrupt_disable();
+        RT_ASSERT(group->ref > 0);
+        group->ref--;
+        rt_hw_interrupt_enable(level);
+    }
+}
+
+/**
+ * @brief Check whether a ready thread should run before another one of the
+ *        same priority, by the virtual runtime of the sibling groups on their
+ *        paths.
+ *
+ * @return RT_TRUE if the group of thread has less virtual runtime, RT_FALSE
+ *         for the same group, then the order of the ready queue is kept.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+rt_bool_t rt_sched_group_before(struct rt_thread *thread, struct rt_thread *other)
+{
+    struct rt_sched_group *group, *other_group;
+
+    if (other == RT_NULL)
+    {
+        return RT_FALSE;
+    }
+
+#ifdef RT_USING_SCHED_DEADLINE
+    /* the deadline threads are sorted by the absolute deadline */
+    if (thread->dl.runtime != 0 || other->dl.runtime != 0)
+    {
+        return RT_FALSE;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
+    group = _sg_of(thread);
+    other_group = _sg_of(other);
+
+    while (group->depth > other_group->depth)
+    {
+        group = group->parent;
+    }
+    while (other_group->depth > group->depth)
+    {
+        other_group = other_group->parent;
+    }
+    if (group == other_group)
+    {
+        return RT_FALSE;
+    }
+
+    while (group->parent != other_group->parent)
+    {
+        group = group->parent;
+        other_group = other_group->parent;
+    }
+
+    return (rt_int64_t)(group->vruntime - other_group->vruntime) < 0;
+}
+
+/**
+ * @brief Check whether the group of a thread or any ancestor of it is
+ *        throttled.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+rt_bool_t rt_sched_group_throttled(struct rt_thread *thread)
+{
+#ifdef RT_USING_SCHED_DEADLINE
+    /* the deadline threads are limited by their own bandwidth */
+    if (thread->dl.runtime != 0)
+    {
+        return RT_FALSE;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
+    return _sg_throttled_group(thread) != RT_NULL;
+}
+
+/**
+ * @brief Park a ready or running thread of a throttled group, the thread is
+ *        resumed by the period timer of the group.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+void rt_sched_group_park(struct rt_thread *thread)
+{
+    struct rt_sched_group *group = _sg_throttled_group(thread);
+
+    RT_ASSERT(group != RT_NULL);
+
+    if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
+    {
+        rt_schedule_remove_thread(thread);
+    }
+
+    thread->stat = RT_THREAD_SUSPEND_UNINTERRUPTIBLE | (thread->stat & ~RT_THREAD_STAT_MASK);
+    rt_list_insert_before(&group->throttled_threads, &thread->tlist);
+}
+
+/**
+ * @brief Place the groups of a woken up thread not too far before the
+ *        siblings, so a group never builds up credit by sleeping.
+ *
+ * @note  Should be called by the scheduler with interrupt disabled.
+ */
+void rt_sched_group_wakeup(struct rt_thread *thread)
+{
+    struct rt_sched_group *group;
+    rt_uint64_t floor;
+
+    for (group = _sg_of(thread); group != &_sg_root; group = group->parent)
+    {
+        floor = group->parent->min_vruntime - SG_WAKEUP_CREDIT;
+        if ((rt_int64_t)(group->vruntime - floor) < 0)
+        {
+            group->vruntime = floor;
+        }
+    }
+}
+
+/**
+ * @brief Charge a tick of the running thread to its groups.
+ *
+ * @return RT_TRUE if the thread is parked as its group is throttled, then a
+ *         scheduling is needed.
+ *
+ * @note  Should be called on tick with interrupt disabled.
+ */
+rt_bool_t rt_sched_group_tick(struct rt_thread *thread)
+{
+    struct rt_sched_group *group;
+
+    if (thread == rt_thread_idle_gethandler())
+    {
+        return RT_FALSE;
+    }
+
+    for (group = _sg_of(thread); group != &_sg_root; group = group->parent)
+    {
+        group->vruntime += SG_VTICK(group->shares);
+        group->usage++;
+
+        /* the running group is about the least of the ready siblings */
+        if ((rt_int64_t)(group->vruntime - group->parent->min_vruntime) > 0)
+        {
+            group->parent->min_vruntime = group->vruntime;
+        }
+
+        if (group->quota != 0 && !group->throttled && ++group->runtime >= group->quota)
+        {
+            group->throttled = 1;
+            group->nr_throttled++;
+        }
+    }
+
+    if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING && rt_sched_group_throttled(thread))
+    {
+        rt_sched_group_park(thread);
+        return RT_TRUE;
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * @brief Release the group of a closing thread.
+ *
+ * @note  Should be called with interrupt disabled.
+ */
+void rt_sched_group_exit(struct rt_thread *thread)
+{
+    rt_sched_group_put(thread->sgroup);
+    thread->sgroup = RT_NULL;
+}
+
+#ifdef RT_USING_FINSH
+#include <stdlib.h>
+
+static void _sg_list_show(void)
+{
+    struct rt_sched_group *group;
+    rt_list_t *node;
+    rt_base_t level;
+
+    rt_kprintf("%-*s %-*s shares  quota period  usage(tick) throttled\n",
+               RT_NAME_MAX, "group", RT_NAME_MAX, "parent");
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &_sg_list)
+    {
+        group = rt_list_entry(node, struct rt_sched_group, list);
+        rt_kprintf("%-*.*s %-*.*s %6d %6d %6d %12d %5d%s\n",
+                   RT_NAME_MAX, RT_NAME_MAX, group->name,
+                   RT_NAME_MAX, RT_NAME_MAX, group->parent->name,
+                   group->shares, group->quota, group->period,
+                   (int)group->usage, group->nr_throttled,
+                   group->throttled ? "*" : "");
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static void cmd_sgroup(int argc, char **argv)
+{
+    rt_sched_group_t group = RT_NULL;
+    rt_err_t err = RT_EOK;
+    rt_base_t level;
+
+    if (argc < 2)
+    {
+        _sg_list_show();
+        return;
+    }
+
+    if (argc == 3 && rt_strcmp(argv[1], "delete") == 0)
+    {
+        err = rt_sched_group_delete_by_name(argv[2]);
+        if (err == -RT_ENOENT)
+        {
+            rt_kprintf("group %s not found\n", argv[2]);
+        }
+        else if (err != RT_EOK)
+        {
+            rt_kprintf("sgroup %s failed: %d\n", argv[1], err);
+        }
+        return;
+    }
+
+    if (argc >= 3)
+    {
+        const char *name = rt_strcmp(argv[1], "create") == 0 ? (argc > 3 ? argv[3] : RT_NULL) : argv[2];
+
+        /* the group is held by a reference, which keeps it from being deleted */
+        if (name != RT_NULL)
+        {
+            level = rt_hw_interrupt_disable();
+            group = rt_sched_group_get(rt_sched_group_find(name));
+            rt_hw_interrupt_enable(level);
+            if (group == RT_NULL)
+            {
+                rt_kprintf("group %s not found\n", name);
+                return;
+            }
+        }
+    }
+
+    if (argc >= 3 && rt_strcmp(argv[1], "create") == 0)
+    {
+        if (rt_sched_group_create(argv[2], group) == RT_NULL)
+        {
+            rt_kprintf("create group %s failed\n", argv[2]);
+        }
+    }
+    else if (argc == 4 && rt_strcmp(argv[1], "shares") == 0)
+    {
+        err = rt_sched_group_set_shares(group, (rt_uint32_t)atoi(argv[3]));
+    }
+    else if ((argc == 4 || argc == 5) && rt_strcmp(argv[1], "quota") == 0)
+    {
+        err = rt_sched_group_set_bandwidth(group, (rt_tick_t)atoi(argv[3]),
+                                           argc == 5 ? (rt_tick_t)atoi(argv[4]) : 0);
+    }
+    else if (argc == 4 && rt_strcmp(argv[1], "attach") == 0)
+    {
+        rt_thread_t thread = rt_thread_find(argv[3]);
+
+        if (thread == RT_NULL)
+        {
+            rt_kprintf("thread %s not found\n", argv[3]);
+        }
+        else
+        {
+            err = rt_sched_group_attach(group, thread);
+        }
+    }
+    else
+    {
+        rt_kprintf("Usage: sgroup                               list the groups\n");
+        rt_kprintf("       sgroup create <name> [parent]        create a group\n");
+        rt_kprintf("       sgroup delete <name>                 delete a group\n");
+        rt_kprintf("       sgroup shares <name> <shares>        set the shares of a group\n");
+        rt_kprintf("       sgroup quota <name> <quota> [period] set the quota in ticks, 0 for unlimited\n");
+        rt_kprintf("       sgroup attach <name> <thread>        move a thread to a group\n");
+    }
+    rt_sched_group_put(group);
+
+    if (err != RT_EOK)
+    {
+        rt_kprintf("sgroup %s failed: %d\n", argv[1], err);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(cmd_sgroup, sgroup, manage the scheduling groups);
+#endif /* RT_USING_FINSH */
+
+#endif /* RT_USING_SCHED_GROUP */
@@ -29,6 +29,8 @@
  *                             new task directly
  * 2022-01-07     Gabriel      Moving __on_rt_xxxxx_hook to scheduler.c
  * 2023-03-27     rose_man     Split into scheduler upc and scheduler_mp.c
+ * 2023-10-18     RT-Thread    pick the ready thread by the cpu affinity mask
+ * 2023-10-18     RT-Thread    pick the ready thread by the scheduling group
  */
 
 #include <rtthread.h>
@@ -69,6 +71,17 @@ void rt_scheduler_sethook(void (*hook)(struct rt_thread *from, struct rt_thread
     rt_scheduler_hook = hook;
 }
 
+/**
+ * @brief This function will get the hook function invoked when thread switch
+ *        happens, so a temporary hook can restore it later.
+ *
+ * @return Return the hook function, or RT_NULL if there is none.
+ */
+void (*rt_scheduler_gethook(void))(struct rt_thread *from, struct rt_thread *to)
+{
+    return rt_scheduler_hook;
+}
+
 /**
  * @brief This function will set a hook function, which will be invoked when context
  *        switch happens.
@@ -83,6 +96,31 @@ void rt_scheduler_switch_sethook(void (*hook)(struct rt_thread *tid))
 /**@}*/
 #endif /* RT_USING_HOOK */
 
+#ifdef RT_USING_SIGNALS
+/* handle the signals that became pending while the thread was switched out */
+static void _scheduler_handle_sig(struct rt_thread *thread)
+{
+    extern void rt_thread_handle_sig(rt_bool_t clean_state);
+    rt_base_t level;
+
+    /* check stat of thread for signal */
+    level = rt_hw_interrupt_disable();
+    if (thread->stat & RT_THREAD_STAT_SIGNAL_PENDING)
+    {
+        thread->stat &= ~RT_THREAD_STAT_SIGNAL_PENDING;
+
+        rt_hw_interrupt_enable(level);
+
+        /* check signal status */
+        rt_thread_handle_sig(RT_TRUE);
+    }
+    else
+    {
+        rt_hw_interrupt_enable(level);
+    }
+}
+#endif /* RT_USING_SIGNALS */
+
 #ifdef RT_USING_OVERFLOW_CHECK
 static void _scheduler_stack_check(struct rt_thread *thread)
 {
@@ -133,41 +171,162 @@ static void _scheduler_stack_check(struct rt_thread *thread)
 }
 #endif /* RT_USING_OVERFLOW_CHECK */
 
+/*
+ * find the first thread could run on the cpu in the global ready queue, the
+ * priority of it should be higher than the limit.
+ */
+#ifdef RT_USING_SCHED_GROUP
+/*
+ * find the thread could run on the cpu in a ready list, whose group has the
+ * least virtual runtime. The threads of the same group are taken in order.
+ */
+static struct rt_thread* _scheduler_get_group_thread(rt_list_t *queue, int cpu_id)
+{
+    rt_list_t *node;
+    struct rt_thread *thread;
+    struct rt_thread *best = RT_NULL;
+
+    rt_list_for_each(node, queue)
+    {
+        thread = rt_list_entry(node, struct rt_thread, tlist);
+
+        if ((thread->cpu_affinity & (1U << cpu_id)) &&
+            (best == RT_NULL || rt_sched_group_before(thread, best)))
+        {
+            best = thread;
+        }
+    }
+
+    return best;
+}
+#endif /* RT_USING_SCHED_GROUP */
+
+static struct rt_thread* _scheduler_get_affinity_thread(int cpu_id, rt_ubase_t *prio, rt_ubase_t limit)
+{
+    rt_ubase_t priority;
+    struct rt_thread *thread;
+#ifndef RT_USING_SCHED_GROUP
+    rt_list_t *node;
+#endif /* RT_USING_SCHED_GROUP */
+
+    for (priority = *prio; priority < limit; priority++)
+    {
+#ifdef RT_USING_SCHED_GROUP
+        thread = _scheduler_get_group_thread(&rt_thread_priority_table[priority], cpu_id);
+        if (thread != RT_NULL)
+        {
+            *prio = priority;
+            return thread;
+        }
+#else
+        rt_list_for_each(node, &rt_thread_priority_table[priority])
+        {
+            thread = rt_list_entry(node, struct rt_thread, tlist);
+
+            if (thread->cpu_affinity & (1U << cpu_id))
+            {
+                *prio = priority;
+                return thread;
+            }
+        }
+#endif /* RT_USING_SCHED_GROUP */
+    }
+
+    return RT_NULL;
+}
+
 /*
  * get the highest priority thread in ready queue
  */
 static struct rt_thread* _scheduler_get_highest_priority_thread(rt_ubase_t *highest_prio)
 {
-    struct rt_thread *highest_priority_thread;
+    struct rt_thread *highest_priority_thread = RT_NULL;
     rt_ubase_t highest_ready_priority, local_highest_ready_priority;
-    struct rt_cpu* pcpu = rt_cpu_self();
+    int cpu_id = rt_hw_cpu_id();
+    struct rt_cpu* pcpu = rt_cpu_index(cpu_id);
 #if RT_THREAD_PRIORITY_MAX > 32
     rt_ubase_t number;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+
+#ifdef RT_USING_SCHED_GROUP
+__retry:
+    highest_priority_thread = RT_NULL;
+#endif /* RT_USING_SCHED_GROUP */
+    highest_ready_priority = RT_THREAD_PRIORITY_MAX;
+    local_highest_ready_priority = RT_THREAD_PRIORITY_MAX;
 
-    number = __rt_ffs(rt_thread_ready_priority_group) - 1;
-    highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
-    number = __rt_ffs(pcpu->priority_group) - 1;
-    local_highest_ready_priority = (number << 3) + __rt_ffs(pcpu->ready_table[number]) - 1;
+#if RT_THREAD_PRIORITY_MAX > 32
+    if (rt_thread_ready_priority_group != 0)
+    {
+        number = __rt_ffs(rt_thread_ready_priority_group) - 1;
+        highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
+    }
+    if (pcpu->priority_group != 0)
+    {
+        number = __rt_ffs(pcpu->priority_group) - 1;
+        local_highest_ready_priority = (number << 3) + __rt_ffs(pcpu->ready_table[number]) - 1;
+    }
 #else
-    highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group) - 1;
-    local_highest_ready_priority = __rt_ffs(pcpu->priority_group) - 1;
+    if (rt_thread_ready_priority_group != 0)
+    {
+        highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group) - 1;
+    }
+    if (pcpu->priority_group != 0)
+    {
+        local_highest_ready_priority = __rt_ffs(pcpu->priority_group) - 1;
+    }
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
 
     /* get highest ready priority thread */
     if (highest_ready_priority < local_highest_ready_priority)
     {
-        *highest_prio = highest_ready_priority;
+#ifdef RT_USING_SCHED_GROUP
+        /* the groups are compared in the priority */
+        highest_priority_thread = _scheduler_get_affinity_thread(cpu_id,
+                &highest_ready_priority, local_highest_ready_priority);
+#else
         highest_priority_thread = rt_list_entry(rt_thread_priority_table[highest_ready_priority].next,
                                   struct rt_thread,
                                   tlist);
+
+        /* walk the global queue only if the first thread could not run on this cpu */
+        if ((highest_priority_thread->cpu_affinity & (1U << cpu_id)) == 0)
+        {
+            highest_priority_thread = _scheduler_get_affinity_thread(cpu_id,
+                    &highest_ready_priority, local_highest_ready_priority);
+        }
+#endif /* RT_USING_SCHED_GROUP */
+    }
+
+    if (highest_priority_thread != RT_NULL)
+    {
+        *highest_prio = highest_ready_priority;
     }
     else
     {
         *highest_prio = local_highest_ready_priority;
-        highest_priority_thread = rt_list_entry(pcpu->priority_table[local_highest_ready_priority].next,
-                                  struct rt_thread,
-                                  tlist);
+
+        if (local_highest_ready_priority < RT_THREAD_PRIORITY_MAX)
+        {
+#ifdef RT_USING_SCHED_GROUP
+            highest_priority_thread = _scheduler_get_group_thread(&pcpu->priority_table[local_highest_ready_priority], cpu_id);
+            RT_ASSERT(highest_priority_thread != RT_NULL);
+#else
+            highest_priority_thread = rt_list_entry(pcpu->priority_table[local_highest_ready_priority].next,
+                                      struct rt_thread,
+                                      tlist);
+#endif /* RT_USING_SCHED_GROUP */
+        }
+    }
+
+#ifdef RT_USING_SCHED_GROUP
+    if (highest_priority_thread != RT_NULL && rt_sched_group_throttled(highest_priority_thread))
+    {
+        /* the threads of a throttled group are parked until its next period */
+        rt_sched_group_park(highest_priority_thread);
+        goto __retry;
     }
+#endif /* RT_USING_SCHED_GROUP */
 
     return highest_priority_thread;
 }
@@ -197,6 +356,7 @@ void rt_system_scheduler_init(void)
         }
 
         pcpu->irq_switch_flag = 0;
+        pcpu->critical_switch_flag = 0;
         pcpu->current_priority = RT_THREAD_PRIORITY_MAX - 1;
         pcpu->current_thread = RT_NULL;
         pcpu->priority_group = 0;
@@ -231,6 +391,10 @@ void rt_system_scheduler_start(void)
     rt_schedule_remove_thread(to_thread);
     to_thread->stat = RT_THREAD_RUNNING;
 
+#ifdef RT_USING_CPU_USAGE
+    rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
     /* switch to new thread */
     rt_hw_context_switch_to((rt_ubase_t)&to_thread->sp, to_thread);
 
@@ -306,19 +470,30 @@ void rt_schedule(void)
     {
         rt_ubase_t highest_ready_priority;
 
+        pcpu->critical_switch_flag = 0;
+
         if (rt_thread_ready_priority_group != 0 || pcpu->priority_group != 0)
         {
             to_thread = _scheduler_get_highest_priority_thread(&highest_ready_priority);
             current_thread->oncpu = RT_CPU_DETACHED;
             if ((current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
             {
-                if (current_thread->bind_cpu == RT_CPUS_NR || current_thread->bind_cpu == cpu_id)
+                if (current_thread->cpu_affinity & (1U << cpu_id))
                 {
                     if (current_thread->current_priority < highest_ready_priority)
                     {
                         to_thread = current_thread;
                     }
-                    else if (current_thread->current_priority == highest_ready_priority && (current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0)
+                    else if (current_thread->current_priority == highest_ready_priority && ((current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0
+#ifdef RT_USING_SCHED_GROUP
+                        /* the slice is used up, but the group is still behind */
+                        || rt_sched_group_before(current_thread, to_thread)
+#endif /* RT_USING_SCHED_GROUP */
+                        )
+#ifdef RT_USING_SCHED_DEADLINE
+                        && !rt_sched_deadline_preempt(current_thread, to_thread)
+#endif /* RT_USING_SCHED_DEADLINE */
+                        )
                     {
                         to_thread = current_thread;
                     }
@@ -333,6 +508,8 @@ void rt_schedule(void)
                 }
                 current_thread->stat &= ~RT_THREAD_STAT_YIELD_MASK;
             }
+            /* the idle thread of this cpu is always ready if it is not running */
+            RT_ASSERT(to_thread != RT_NULL);
             to_thread->oncpu = cpu_id;
             if (to_thread != current_thread)
             {
@@ -359,37 +536,170 @@ void rt_schedule(void)
 
                 RT_OBJECT_HOOK_CALL(rt_scheduler_switch_hook, (current_thread));
 
+#ifdef RT_USING_CPU_USAGE
+                rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
+#ifdef RT_USING_RCU
+                rt_rcu_quiescent();
+#endif /* RT_USING_RCU */
+
                 rt_hw_context_switch((rt_ubase_t)&current_thread->sp,
                         (rt_ubase_t)&to_thread->sp, to_thread);
             }
         }
     }
+    else
+    {
+        /* the scheduler is locked, the switch is done when it is unlocked */
+        pcpu->critical_switch_flag = 1;
+    }
 
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
 
 #ifdef RT_USING_SIGNALS
-    /* check stat of thread for signal */
-    level = rt_hw_interrupt_disable();
-    if (current_thread->stat & RT_THREAD_STAT_SIGNAL_PENDING)
-    {
-        extern void rt_thread_handle_sig(rt_bool_t clean_state);
+    _scheduler_handle_sig(current_thread);
+#endif /* RT_USING_SIGNALS */
+
+__exit:
+    return ;
+}
+
+/**
+ * @brief This function will switch to a suspended thread directly from the
+ *        current thread, the ready queue is bypassed. It is used by the
+ *        synchronous IPC to hand the cpu over to the blocked receiver.
+ *
+ * @param to_thread is the suspended thread to switch to.
+ *
+ * @return Return the operation status. If the return value is RT_EOK, the
+ *         current thread has been switched out and is switched back now.
+ *         If the return value is -RT_EBUSY, the direct switch is not allowed
+ *         and nothing is done, the thread should be resumed in the normal way.
+ *
+ * @note   The interrupt should be disabled and the current thread should have
+ *         been suspended by the caller. The thread is only switched to if it
+ *         could run on this cpu and no ready thread has a higher priority.
+ */
+rt_err_t rt_schedule_switch_to(struct rt_thread *to_thread)
+{
+    rt_base_t level;
+    struct rt_thread *current_thread;
+    struct rt_cpu    *pcpu;
+    rt_ubase_t highest_ready_priority;
+    int cpu_id;
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_ubase_t number;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+
+    RT_ASSERT(to_thread != RT_NULL);
+
+    level  = rt_hw_interrupt_disable();
+
+    cpu_id = rt_hw_cpu_id();
+    pcpu   = rt_cpu_index(cpu_id);
+    current_thread = pcpu->current_thread;
 
-        current_thread->stat &= ~RT_THREAD_STAT_SIGNAL_PENDING;
+    RT_ASSERT((current_thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK);
 
+    /* the thread may be still running on the other cpu before it switches out */
+    if (pcpu->irq_nest || current_thread->scheduler_lock_nest != 1 ||
+        (to_thread->stat & RT_THREAD_SUSPEND_MASK) != RT_THREAD_SUSPEND_MASK ||
+        to_thread->oncpu != RT_CPU_DETACHED || !(to_thread->cpu_affinity & (1U << cpu_id))
+#ifdef RT_USING_SCHED_GROUP
+        || rt_sched_group_throttled(to_thread)
+#endif /* RT_USING_SCHED_GROUP */
+        )
+    {
         rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
 
-        /* check signal status */
-        rt_thread_handle_sig(RT_TRUE);
+    highest_ready_priority = RT_THREAD_PRIORITY_MAX;
+#if RT_THREAD_PRIORITY_MAX > 32
+    if (rt_thread_ready_priority_group != 0)
+    {
+        number = __rt_ffs(rt_thread_ready_priority_group) - 1;
+        highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
     }
-    else
+    if (pcpu->priority_group != 0)
+    {
+        number = __rt_ffs(pcpu->priority_group) - 1;
+        number = (number << 3) + __rt_ffs(pcpu->ready_table[number]) - 1;
+        if (number < highest_ready_priority)
+        {
+            highest_ready_priority = number;
+        }
+    }
+#else
+    if ((rt_thread_ready_priority_group | pcpu->priority_group) != 0)
+    {
+        highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group | pcpu->priority_group) - 1;
+    }
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+
+    /* the woken up thread is put at the head of its priority in the ready queue too */
+    if (to_thread->current_priority > highest_ready_priority
+#ifdef RT_USING_SCHED_DEADLINE
+        || (to_thread->current_priority == highest_ready_priority &&
+            highest_ready_priority == RT_SCHED_DEADLINE_PRIORITY)
+#endif /* RT_USING_SCHED_DEADLINE */
+        )
     {
         rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
     }
+
+    /* remove from suspend list */
+    rt_list_remove(&(to_thread->tlist));
+    rt_timer_stop(&to_thread->thread_timer);
+#ifdef RT_USING_SMART
+    to_thread->wakeup.func = RT_NULL;
+#endif /* RT_USING_SMART */
+
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_sched_deadline_wakeup(to_thread);
+#endif /* RT_USING_SCHED_DEADLINE */
+
+    current_thread->oncpu = RT_CPU_DETACHED;
+    to_thread->oncpu = cpu_id;
+    to_thread->stat = RT_THREAD_RUNNING | (to_thread->stat & ~RT_THREAD_STAT_MASK);
+    pcpu->current_priority = (rt_uint8_t)to_thread->current_priority;
+
+    RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (current_thread, to_thread));
+
+    RT_DEBUG_LOG(RT_DEBUG_SCHEDULER,
+            ("switch directly to priority#%d thread:%.*s(sp:0x%08x), "
+             "from thread:%.*s(sp: 0x%08x)\n",
+             to_thread->current_priority,
+             RT_NAME_MAX, to_thread->parent.name, to_thread->sp,
+             RT_NAME_MAX, current_thread->parent.name, current_thread->sp));
+
+#ifdef RT_USING_OVERFLOW_CHECK
+    _scheduler_stack_check(to_thread);
+#endif /* RT_USING_OVERFLOW_CHECK */
+
+    RT_OBJECT_HOOK_CALL(rt_scheduler_switch_hook, (current_thread));
+
+#ifdef RT_USING_CPU_USAGE
+    rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
+#ifdef RT_USING_RCU
+    rt_rcu_quiescent();
+#endif /* RT_USING_RCU */
+
+    rt_hw_context_switch((rt_ubase_t)&current_thread->sp,
+            (rt_ubase_t)&to_thread->sp, to_thread);
+
+    rt_hw_interrupt_enable(level);
+
+#ifdef RT_USING_SIGNALS
+    _scheduler_handle_sig(current_thread);
 #endif /* RT_USING_SIGNALS */
 
-__exit:
-    return ;
+    return RT_EOK;
 }
 
 /**
@@ -446,13 +756,22 @@ void rt_scheduler_do_irq_switch(void *context)
             current_thread->oncpu = RT_CPU_DETACHED;
             if ((current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
             {
-                if (current_thread->bind_cpu == RT_CPUS_NR || current_thread->bind_cpu == cpu_id)
+                if (current_thread->cpu_affinity & (1U << cpu_id))
                 {
                     if (current_thread->current_priority < highest_ready_priority)
                     {
                         to_thread = current_thread;
                     }
-                    else if (current_thread->current_priority == highest_ready_priority && (current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0)
+                    else if (current_thread->current_priority == highest_ready_priority && ((current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0
+#ifdef RT_USING_SCHED_GROUP
+                        /* the slice is used up, but the group is still behind */
+                        || rt_sched_group_before(current_thread, to_thread)
+#endif /* RT_USING_SCHED_GROUP */
+                        )
+#ifdef RT_USING_SCHED_DEADLINE
+                        && !rt_sched_deadline_preempt(current_thread, to_thread)
+#endif /* RT_USING_SCHED_DEADLINE */
+                        )
                     {
                         to_thread = current_thread;
                     }
@@ -467,6 +786,8 @@ void rt_scheduler_do_irq_switch(void *context)
                 }
                 current_thread->stat &= ~RT_THREAD_STAT_YIELD_MASK;
             }
+            /* the idle thread of this cpu is always ready if it is not running */
+            RT_ASSERT(to_thread != RT_NULL);
             to_thread->oncpu = cpu_id;
             if (to_thread != current_thread)
             {
@@ -490,6 +811,14 @@ void rt_scheduler_do_irq_switch(void *context)
 
                 RT_OBJECT_HOOK_CALL(rt_scheduler_switch_hook, (current_thread));
 
+#ifdef RT_USING_CPU_USAGE
+                rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
+#ifdef RT_USING_RCU
+                rt_rcu_quiescent();
+#endif /* RT_USING_RCU */
+
                 rt_hw_context_switch_interrupt(context, (rt_ubase_t)&current_thread->sp,
                         (rt_ubase_t)&to_thread->sp, to_thread);
             }
@@ -525,6 +854,22 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
         goto __exit;
     }
 
+#ifdef RT_USING_SCHED_DEADLINE
+    if ((thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK)
+    {
+        /* the woken up deadline thread may get a new deadline */
+        rt_sched_deadline_wakeup(thread);
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    if ((thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK)
+    {
+        /* the group doesn't build up credit by sleeping */
+        rt_sched_group_wakeup(thread);
+    }
+#endif /* RT_USING_SCHED_GROUP */
+
     /* READY thread, insert to ready queue */
     thread->stat = RT_THREAD_READY | (thread->stat & ~RT_THREAD_STAT_MASK);
 
@@ -539,6 +884,14 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
         rt_thread_ready_priority_group |= thread->number_mask;
 
+#ifdef RT_USING_SCHED_DEADLINE
+        if (thread->current_priority == RT_SCHED_DEADLINE_PRIORITY)
+        {
+            /* deadline threads are sorted by the absolute deadline */
+            rt_sched_deadline_enqueue(&(rt_thread_priority_table[thread->current_priority]), thread);
+        }
+        else
+#endif /* RT_USING_SCHED_DEADLINE */
         /* there is no time slices left(YIELD), inserting thread before ready list*/
         if((thread->stat & RT_THREAD_STAT_YIELD_MASK) != 0)
         {
@@ -552,8 +905,12 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
                                 &(thread->tlist));
         }
 
-        cpu_mask = RT_CPU_MASK ^ (1 << cpu_id);
-        rt_hw_ipi_send(RT_SCHEDULE_IPI, cpu_mask);
+        /* only the other cpus the thread could run on need to reschedule */
+        cpu_mask = (RT_CPU_MASK ^ (1 << cpu_id)) & thread->cpu_affinity;
+        if (cpu_mask)
+        {
+            rt_hw_ipi_send(RT_SCHEDULE_IPI, cpu_mask);
+        }
     }
     else
     {
@@ -564,6 +921,14 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
 #endif /* RT_THREAD_PRIORITY_MAX > 32 */
         pcpu->priority_group |= thread->number_mask;
 
+#ifdef RT_USING_SCHED_DEADLINE
+        if (thread->current_priority == RT_SCHED_DEADLINE_PRIORITY)
+        {
+            /* deadline threads are sorted by the absolute deadline */
+            rt_sched_deadline_enqueue(&(rt_cpu_index(bind_cpu)->priority_table[thread->current_priority]), thread);
+        }
+        else
+#endif /* RT_USING_SCHED_DEADLINE */
         /* there is no time slices left(YIELD), inserting thread before ready list*/
         if((thread->stat & RT_THREAD_STAT_YIELD_MASK) != 0)
         {
@@ -74,6 +74,17 @@ void rt_scheduler_sethook(void (*hook)(struct rt_thread *from, struct rt_thread
     rt_scheduler_hook = hook;
 }
 
+/**
+ * @brief This function will get the hook function invoked when thread switch
+ *        happens, so a temporary hook can restore it later.
+ *
+ * @return Return the hook function, or RT_NULL if there is none.
+ */
+void (*rt_scheduler_gethook(void))(struct rt_thread *from, struct rt_thread *to)
+{
+    return rt_scheduler_hook;
+}
+
 /**
  * @brief This function will set a hook function, which will be invoked when context
  *        switch happens.
@@ -88,6 +99,31 @@ void rt_scheduler_switch_sethook(void (*hook)(struct rt_thread *tid))
 /**@}*/
 #endif /* RT_USING_HOOK */
 
+#ifdef RT_USING_SIGNALS
+/* handle the signals that became pending while the thread was switched out */
+static void _scheduler_handle_sig(struct rt_thread *thread)
+{
+    extern void rt_thread_handle_sig(rt_bool_t clean_state);
+    rt_base_t level;
+
+    /* check stat of thread for signal */
+    level = rt_hw_interrupt_disable();
+    if (thread->stat & RT_THREAD_STAT_SIGNAL_PENDING)
+    {
+        thread->stat &= ~RT_THREAD_STAT_SIGNAL_PENDING;
+
+        rt_hw_interrupt_enable(level);
+
+        /* check signal status */
+        rt_thread_handle_sig(RT_TRUE);
+    }
+    else
+    {
+        rt_hw_interrupt_enable(level);
+    }
+}
+#endif /* RT_USING_SIGNALS */
+
 #ifdef RT_USING_OVERFLOW_CHECK
 static void _scheduler_stack_check(struct rt_thread *thread)
 {
@@ -203,6 +239,10 @@ void rt_system_scheduler_start(void)
     rt_schedule_remove_thread(to_thread);
     to_thread->stat = RT_THREAD_RUNNING;
 
+#ifdef RT_USING_CPU_USAGE
+    rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
     /* switch to new thread */
 
     rt_hw_context_switch_to((rt_ubase_t)&to_thread->sp);
@@ -248,7 +288,11 @@ void rt_schedule(void)
                 {
                     to_thread = rt_current_thread;
                 }
-                else if (rt_current_thread->current_priority == highest_ready_priority && (rt_current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0)
+                else if (rt_current_thread->current_priority == highest_ready_priority && (rt_current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0
+#ifdef RT_USING_SCHED_DEADLINE
+                        && !rt_sched_deadline_preempt(rt_current_thread, to_thread)
+#endif /* RT_USING_SCHED_DEADLINE */
+                        )
                 {
                     to_thread = rt_current_thread;
                 }
@@ -289,10 +333,12 @@ void rt_schedule(void)
                 _scheduler_stack_check(to_thread);
 #endif /* RT_USING_OVERFLOW_CHECK */
 
+#ifdef RT_USING_CPU_USAGE
+                rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
                 if (rt_interrupt_nest == 0)
                 {
-                    extern void rt_thread_handle_sig(rt_bool_t clean_state);
-
                     RT_OBJECT_HOOK_CALL(rt_scheduler_switch_hook, (from_thread));
 
                     rt_hw_context_switch((rt_ubase_t)&from_thread->sp,
@@ -302,23 +348,7 @@ void rt_schedule(void)
                     rt_hw_interrupt_enable(level);
 
 #ifdef RT_USING_SIGNALS
-                    /* check stat of thread for signal */
-                    level = rt_hw_interrupt_disable();
-                    if (rt_current_thread->stat & RT_THREAD_STAT_SIGNAL_PENDING)
-                    {
-                        extern void rt_thread_handle_sig(rt_bool_t clean_state);
-
-                        rt_current_thread->stat &= ~RT_THREAD_STAT_SIGNAL_PENDING;
-
-                        rt_hw_interrupt_enable(level);
-
-                        /* check signal status */
-                        rt_thread_handle_sig(RT_TRUE);
-                    }
-                    else
-                    {
-                        rt_hw_interrupt_enable(level);
-                    }
+                    _scheduler_handle_sig(rt_current_thread);
 #endif /* RT_USING_SIGNALS */
                     goto __exit;
                 }
@@ -345,6 +375,114 @@ __exit:
     return;
 }
 
+/**
+ * @brief This function will switch to a suspended thread directly from the
+ *        current thread, the ready queue is bypassed. It is used by the
+ *        synchronous IPC to hand the cpu over to the blocked receiver.
+ *
+ * @param to_thread is the suspended thread to switch to.
+ *
+ * @return Return the operation status. If the return value is RT_EOK, the
+ *         current thread has been switched out and is switched back now.
+ *         If the return value is -RT_EBUSY, the direct switch is not allowed
+ *         and nothing is done, the thread should be resumed in the normal way.
+ *
+ * @note   The interrupt should be disabled and the current thread should have
+ *         been suspended by the caller. The thread is only switched to if no
+ *         ready thread has a higher priority.
+ */
+rt_err_t rt_schedule_switch_to(struct rt_thread *to_thread)
+{
+    rt_base_t level;
+    struct rt_thread *from_thread;
+    rt_ubase_t highest_ready_priority;
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_ubase_t number;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+
+    RT_ASSERT(to_thread != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+
+    RT_ASSERT((rt_current_thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK);
+
+    if (rt_interrupt_nest || rt_scheduler_lock_nest != 0 ||
+        (to_thread->stat & RT_THREAD_SUSPEND_MASK) != RT_THREAD_SUSPEND_MASK)
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+
+    highest_ready_priority = RT_THREAD_PRIORITY_MAX;
+    if (rt_thread_ready_priority_group != 0)
+    {
+#if RT_THREAD_PRIORITY_MAX > 32
+        number = __rt_ffs(rt_thread_ready_priority_group) - 1;
+        highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
+#else
+        highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group) - 1;
+#endif /* RT_THREAD_PRIORITY_MAX > 32 */
+    }
+
+    /* the woken up thread is put at the head of its priority in the ready queue too */
+    if (to_thread->current_priority > highest_ready_priority
+#ifdef RT_USING_SCHED_DEADLINE
+        || (to_thread->current_priority == highest_ready_priority &&
+            highest_ready_priority == RT_SCHED_DEADLINE_PRIORITY)
+#endif /* RT_USING_SCHED_DEADLINE */
+        )
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+
+    /* remove from suspend list */
+    rt_list_remove(&(to_thread->tlist));
+    rt_timer_stop(&to_thread->thread_timer);
+#ifdef RT_USING_SMART
+    to_thread->wakeup.func = RT_NULL;
+#endif /* RT_USING_SMART */
+
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_sched_deadline_wakeup(to_thread);
+#endif /* RT_USING_SCHED_DEADLINE */
+
+    from_thread         = rt_current_thread;
+    rt_current_thread   = to_thread;
+    rt_current_priority = (rt_uint8_t)to_thread->current_priority;
+    to_thread->stat = RT_THREAD_RUNNING | (to_thread->stat & ~RT_THREAD_STAT_MASK);
+
+    RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (from_thread, to_thread));
+
+    RT_DEBUG_LOG(RT_DEBUG_SCHEDULER,
+            ("switch directly to priority#%d thread:%.*s(sp:0x%08x), "
+             "from thread:%.*s(sp: 0x%08x)\n",
+             to_thread->current_priority,
+             RT_NAME_MAX, to_thread->parent.name, to_thread->sp,
+             RT_NAME_MAX, from_thread->parent.name, from_thread->sp));
+
+#ifdef RT_USING_OVERFLOW_CHECK
+    _scheduler_stack_check(to_thread);
+#endif /* RT_USING_OVERFLOW_CHECK */
+
+    RT_OBJECT_HOOK_CALL(rt_scheduler_switch_hook, (from_thread));
+
+#ifdef RT_USING_CPU_USAGE
+    rt_cpu_usage_switch(to_thread);
+#endif /* RT_USING_CPU_USAGE */
+
+    rt_hw_context_switch((rt_ubase_t)&from_thread->sp,
+            (rt_ubase_t)&to_thread->sp);
+
+    rt_hw_interrupt_enable(level);
+
+#ifdef RT_USING_SIGNALS
+    _scheduler_handle_sig(from_thread);
+#endif /* RT_USING_SIGNALS */
+
+    return RT_EOK;
+}
+
 /**
  * @brief This function will insert a thread to the system ready queue. The state of
  *        thread will be set as READY and the thread will be removed from suspend queue.
@@ -369,8 +507,24 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
         goto __exit;
     }
 
+#ifdef RT_USING_SCHED_DEADLINE
+    if ((thread->stat & RT_THREAD_SUSPEND_MASK) == RT_THREAD_SUSPEND_MASK)
+    {
+        /* the woken up deadline thread may get a new deadline */
+        rt_sched_deadline_wakeup(thread);
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
     /* READY thread, insert to ready queue */
     thread->stat = RT_THREAD_READY | (thread->stat & ~RT_THREAD_STAT_MASK);
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->current_priority == RT_SCHED_DEADLINE_PRIORITY)
+    {
+        /* deadline threads are sorted by the absolute deadline */
+        rt_sched_deadline_enqueue(&(rt_thread_priority_table[thread->current_priority]), thread);
+    }
+    else
+#endif /* RT_USING_SCHED_DEADLINE */
     /* there is no time slices left(YIELD), inserting thread before ready list*/
     if((thread->stat & RT_THREAD_STAT_YIELD_MASK) != 0)
     {
@@ -199,6 +199,7 @@ struct rt_slab
     rt_uint32_t                 zone_limit;
     rt_uint32_t                 zone_page_cnt;
     struct rt_slab_page        *page_list;
+    struct rt_slab_info         zone_info[RT_SLAB_NZONES];      /* usage of each zone index */
 };
 
 /**
@@ -567,6 +568,7 @@ void *rt_slab_alloc(rt_slab_t m, rt_size_t size)
             z->z_freechunk = z->z_freechunk->c_next;
         }
         /* mem stats */
+        slab->zone_info[zi].inuse ++;
         slab->parent.used += z->z_chunksize;
         if (slab->parent.used > slab->parent.max)
             slab->parent.max = slab->parent.used;
@@ -642,6 +644,10 @@ void *rt_slab_alloc(rt_slab_t m, rt_size_t size)
         z->z_next = slab->zone_array[zi];
         slab->zone_array[zi] = z;
         /* mem stats */
+        slab->zone_info[zi].chunk_size = size;
+        slab->zone_info[zi].zones ++;
+        slab->zone_info[zi].chunks += z->z_nmax;
+        slab->zone_info[zi].inuse ++;
         slab->parent.used += z->z_chunksize;
         if (slab->parent.used > slab->parent.max)
             slab->parent.max = slab->parent.used;
@@ -785,6 +791,7 @@ void rt_slab_free(rt_slab_t m, void *ptr)
     chunk->c_next  = z->z_freechunk;
     z->z_freechunk = chunk;
     /* mem stats */
+    slab->zone_info[z->z_zoneindex].inuse --;
     slab->parent.used -= z->z_chunksize;
 
     /*
@@ -816,6 +823,10 @@ void rt_slab_free(rt_slab_t m, void *ptr)
             ;
         *pz = z->z_next;
 
+        /* the zone is no longer owned by the index */
+        slab->zone_info[z->z_zoneindex].zones --;
+        slab->zone_info[z->z_zoneindex].chunks -= z->z_nmax;
+
         /* reset zone */
         z->z_magic = RT_UINT32_MAX;
 
@@ -851,4 +862,37 @@ void rt_slab_free(rt_slab_t m, void *ptr)
 }
 RTM_EXPORT(rt_slab_free);
 
+/**
+ * @brief This function will get the usage of a zone index.
+ *
+ * @note  The counters are read without the lock of the allocator, so the
+ *        result is a snapshot which may be changed in the meanwhile.
+ *
+ * @param m the slab memory management object.
+ *
+ * @param index the zone index, starts from 0.
+ *
+ * @param info the buffer to store the usage.
+ *
+ * @return RT_EOK on success, -RT_EEMPTY if the zone index is never used,
+ *         -RT_EINVAL if the index is out of range.
+ */
+rt_err_t rt_slab_get_info(rt_slab_t m, int index, struct rt_slab_info *info)
+{
+    struct rt_slab *slab = (struct rt_slab *)m;
+
+    RT_ASSERT(slab != RT_NULL);
+
+    if (index < 0 || index >= RT_SLAB_NZONES || info == RT_NULL)
+        return -RT_EINVAL;
+
+    if (slab->zone_info[index].chunk_size == 0)
+        return -RT_EEMPTY;
+
+    *info = slab->zone_info[index];
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_slab_get_info);
+
 #endif /* defined (RT_USING_SLAB) */
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2023-10-18     RT-Thread    the first version
+ */
+
+/*
+ * Cross-CPU function call.
+ *
+ * Each cpu has a FIFO queue of the requests to run. A caller links its
+ * request into the queue of each target cpu and sends RT_SMP_CALL_IPI to the
+ * cpus whose queue was empty, the others have an IPI on the way already. The
+ * handler takes the whole queue at once and runs the functions in interrupt
+ * context. The pending count of a request is the number of cpus which have
+ * not run it yet, the request is done and can be reused when it drops to 0.
+ *
+ * A caller waiting for its request also runs the queue of its own cpu, so two
+ * cpus calling each other with the interrupt disabled do not deadlock.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtatomic.h>
+
+struct _smp_call_queue
+{
+    rt_hw_spinlock_t lock;
+    struct rt_smp_call_req *head;
+    struct rt_smp_call_req *tail;
+};
+
+/* the unlocked state of rt_hw_spinlock_t is all zero, like the empty queue */
+static struct _smp_call_queue _smp_call_queues[RT_CPUS_NR];
+
+/* link the request into the queue of the cpu, return RT_TRUE if it was empty */
+static rt_bool_t _smp_call_enqueue(int cpu, struct rt_smp_call_req *req)
+{
+    rt_bool_t kick;
+    struct _smp_call_queue *queue = &_smp_call_queues[cpu];
+
+    req->next[cpu] = RT_NULL;
+
+    rt_hw_spin_lock(&queue->lock);
+    kick = (queue->head == RT_NULL);
+    if (kick)
+    {
+        queue->head = req;
+    }
+    else
+    {
+        queue->tail->next[cpu] = req;
+    }
+    queue->tail = req;
+    rt_hw_spin_unlock(&queue->lock);
+
+    return kick;
+}
+
+/* run all the requests queued to the local cpu, with the interrupt disabled */
+static void _smp_call_run(int cpu)
+{
+    rt_smp_call_func_t func;
+    void *data;
+    struct rt_smp_call_req *req, *next;
+    struct _smp_call_queue *queue = &_smp_call_queues[cpu];
+
+    if (queue->head == RT_NULL)
+    {
+        return;
+    }
+
+    rt_hw_spin_lock(&queue->lock);
+    req = queue->head;
+    queue->head = RT_NULL;
+    queue->tail = RT_NULL;
+    rt_hw_spin_unlock(&queue->lock);
+
+    while (req != RT_NULL)
+    {
+        /* the request may be reused by its owner as soon as it is done */
+        next = req->next[cpu];
+        func = req->func;
+        data = req->data;
+
+        func(data);
+
+        rt_hw_dmb();
+        rt_atomic_sub(&req->pending, 1);
+        req = next;
+    }
+}
+
+/**
+ * @brief   The handler of RT_SMP_CALL_IPI, which runs the requests queued to
+ *          the local cpu.
+ *
+ * @param   vector is the IPI vector.
+ *
+ * @param   param is not used.
+ */
+void rt_smp_call_ipi_handler(int vector, void *param)
+{
+    RT_UNUSED(vector);
+    RT_UNUSED(param);
+
+    _smp_call_run(rt_hw_cpu_id());
+}
+
+/**
+ * @brief   Initialize a request of calling a function on other cpus.
+ *
+ * @param   req is the request.
+ *
+ * @param   func is the function to call, which runs in interrupt context on
+ *          the remote cpus and with the interrupt disabled on the caller's
+ *          cpu, so it must not block.
+ *
+ * @param   data is the parameter of the function.
+ */
+void rt_smp_call_req_init(struct rt_smp_call_req *req, rt_smp_call_func_t func, void *data)
+{
+    RT_ASSERT(req != RT_NULL);
+    RT_ASSERT(func != RT_NULL);
+
+    req->func = func;
+    req->data = data;
+    rt_atomic_store(&req->pending, 0);
+}
+RTM_EXPORT(rt_smp_call_req_init);
+
+/**
+ * @brief   Call the function of the request on the cpus of the mask without
+ *          waiting for them. The offline cpus in the mask are skipped, and
+ *          the function is called at once if the local cpu is in the mask.
+ *
+ * @param   req is the request, which must be kept until it is done.
+ *
+ * @param   cpu_mask is the mask of the target cpus.
+ *
+ * @return  Return the operation status. When the return value is RT_EOK, the
+ *          request is queued. If the return value is -RT_EBUSY, the request
+ *          is not done yet by the previous call.
+ */
+rt_err_t rt_smp_call_request(struct rt_smp_call_req *req, rt_ubase_t cpu_mask)
+{
+    int cpu, self;
+    rt_base_t level;
+    rt_ubase_t targets = 0;
+    unsigned int kick = 0;
+
+    RT_ASSERT(req != RT_NULL);
+    RT_ASSERT(req->func != RT_NULL);
+
+    if (!rt_smp_call_req_done(req))
+    {
+        return -RT_EBUSY;
+    }
+
+    /* the caller stays on the cpu until the local call is done */
+    level = rt_hw_local_irq_disable();
+    self = rt_hw_cpu_id();
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if (cpu != self && (cpu_mask & (1ul << cpu)) &&
+            rt_cpu_index(cpu)->current_thread != RT_NULL)
+        {
+            targets |= 1ul << cpu;
+            rt_atomic_add(&req->pending, 1);
+        }
+    }
+
+    /* the data of the caller is visible before the request is seen */
+    rt_hw_dmb();
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu++)
+    {
+        if ((targets & (1ul << cpu)) && _smp_call_enqueue(cpu, req))
+        {
+            kick |= 1u << cpu;
+        }
+    }
+
+    if (kick)
+    {
+        rt_hw_ipi_send(RT_SMP_CALL_IPI, kick);
+    }
+
+    /* the local call runs while the remote cpus are interrupted */
+    if (cpu_mask & (1ul << self))
+    {
+        req->func(req->data);
+    }
+
+    rt_hw_local_irq_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_smp_call_request);
+
+/**
+ * @brief   Check whether the request is done by all the target cpus.
+ *
+ * @param   req is the request.
+ *
+ * @return  Return RT_TRUE if the request is done.
+ */
+rt_bool_t rt_smp_call_req_done(struct rt_smp_call_req *req)
+{
+    RT_ASSERT(req != RT_NULL);
+
+    return rt_atomic_load(&req->pending) == 0;
+}
+RTM_EXPORT(rt_smp_call_req_done);
+
+/**
+ * @brief   Wait until the request is done by all the target cpus. It spins
+ *          without blocking, so it can be called with the interrupt disabled.
+ *
+ * @param   req is the request.
+ */
+void rt_smp_call_req_wait(struct rt_smp_call_req *req)
+{
+    rt_base_t level;
+
+    RT_ASSERT(req != RT_NULL);
+
+    while (!rt_smp_call_req_done(req))
+    {
+        /* a target cpu may be waiting for the local cpu as well */
+        level = rt_hw_local_irq_disable();
+        _smp_call_run(rt_hw_cpu_id());
+        rt_hw_local_irq_enable(level);
+
+        rt_hw_cpu_relax();
+    }
+
+    /* the results of the function are visible to the caller */
+    rt_hw_dmb();
+}
+RTM_EXPORT(rt_smp_call_req_wait);
+
+/**
+ * @brief   Call the function on the cpus of the mask, and wait until all of
+ *          them return.
+ *
+ * @param   cpu_mask is the mask of the target cpus.
+ *
+ * @param   func is the function to call.
+ *
+ * @param   data is the parameter of the function.
+ *
+ * @return  Return the operation status. When the return value is RT_EOK, the
+ *          function is done on all the online cpus of the mask.
+ */
+rt_err_t rt_smp_call_cpu_mask(rt_ubase_t cpu_mask, rt_smp_call_func_t func, void *data)
+{
+    rt_err_t err;
+    struct rt_smp_call_req req;
+
+    rt_smp_call_req_init(&req, func, data);
+
+    err = rt_smp_call_request(&req, cpu_mask);
+    if (err == RT_EOK)
+    {
+        rt_smp_call_req_wait(&req);
+    }
+
+    return err;
+}
+RTM_EXPORT(rt_smp_call_cpu_mask);
+
+/**
+ * @brief   Call the function on the cpu, and wait until it returns.
+ *
+ * @param   cpu is the index of the target cpu.
+ *
+ * @param   func is the function to call.
+ *
+ * @param   data is the parameter of the function.
+ *
+ * @return  Return the operation status. If the return value is -RT_EINVAL,
+ *          the cpu index is out of range.
+ */
+rt_err_t rt_smp_call_cpu(int cpu, rt_smp_call_func_t func, void *data)
+{
+    if (cpu < 0 || cpu >= RT_CPUS_NR)
+    {
+        return -RT_EINVAL;
+    }
+
+    return rt_smp_call_cpu_mask(1ul << cpu, func, data);
+}
+RTM_EXPORT(rt_smp_call_cpu);
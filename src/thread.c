@@ -38,6 +38,10 @@
 #include <rtthread.h>
 #include <stddef.h>
 
+#ifdef RT_USING_WORKQUEUE_POOL
+#include <ipc/workqueue.h>
+#endif /* RT_USING_WORKQUEUE_POOL */
+
 #ifndef __on_rt_thread_inited_hook
     #define __on_rt_thread_inited_hook(thread)      __ON_HOOK_ARGS(rt_thread_inited_hook, (thread))
 #endif
@@ -105,6 +109,14 @@ static void _thread_exit(void)
     /* remove it from timer list */
     rt_timer_detach(&thread->thread_timer);
 
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_sched_deadline_exit(thread);
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_exit(thread);
+#endif /* RT_USING_SCHED_GROUP */
+
     /* change stat */
     thread->stat = RT_THREAD_CLOSE;
 
@@ -223,6 +235,7 @@ static rt_err_t _thread_init(struct rt_thread *thread,
 #ifdef RT_USING_SMP
     /* not bind on any cpu */
     thread->bind_cpu = RT_CPUS_NR;
+    thread->cpu_affinity = RT_CPU_MASK;
     thread->oncpu = RT_CPU_DETACHED;
 
     /* lock init */
@@ -231,6 +244,16 @@ static rt_err_t _thread_init(struct rt_thread *thread,
     thread->critical_lock_nest = 0;
 #endif /* RT_USING_SMP */
 
+#ifdef RT_USING_SCHED_DEADLINE
+    /* fixed priority thread */
+    rt_memset(&thread->dl, 0, sizeof(thread->dl));
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    /* in the kernel group */
+    thread->sgroup = RT_NULL;
+#endif /* RT_USING_SCHED_GROUP */
+
     /* initialize cleanup function and user data */
     thread->cleanup   = 0;
     thread->user_data = 0;
@@ -266,7 +289,8 @@ static rt_err_t _thread_init(struct rt_thread *thread,
 #endif
 
 #ifdef RT_USING_CPU_USAGE
-    thread->duration_tick = 0;
+    thread->user_time = 0;
+    thread->system_time = 0;
 #endif /* RT_USING_CPU_USAGE */
 
 #ifdef RT_USING_PTHREADS
@@ -434,6 +458,14 @@ rt_err_t rt_thread_detach(rt_thread_t thread)
     /* release thread timer */
     rt_timer_detach(&(thread->thread_timer));
 
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_sched_deadline_exit(thread);
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_exit(thread);
+#endif /* RT_USING_SCHED_GROUP */
+
     /* change stat */
     thread->stat = RT_THREAD_CLOSE;
 
@@ -547,6 +579,14 @@ rt_err_t rt_thread_delete(rt_thread_t thread)
     /* release thread timer */
     rt_timer_detach(&(thread->thread_timer));
 
+#ifdef RT_USING_SCHED_DEADLINE
+    rt_sched_deadline_exit(thread);
+#endif /* RT_USING_SCHED_DEADLINE */
+
+#ifdef RT_USING_SCHED_GROUP
+    rt_sched_group_exit(thread);
+#endif /* RT_USING_SCHED_GROUP */
+
     /* change stat */
     thread->stat = RT_THREAD_CLOSE;
 
@@ -585,6 +625,16 @@ rt_err_t rt_thread_yield(void)
     rt_base_t level;
 
     thread = rt_thread_self();
+
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->dl.runtime != 0)
+    {
+        /* the job of deadline thread is finished, wait for the next period */
+        rt_sched_deadline_yield(thread);
+        return RT_EOK;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
+
     level = rt_hw_interrupt_disable();
     thread->remaining_tick = thread->init_tick;
     thread->stat |= RT_THREAD_STAT_YIELD;
@@ -755,23 +805,48 @@ rt_err_t rt_thread_mdelay(rt_int32_t ms)
 RTM_EXPORT(rt_thread_mdelay);
 
 #ifdef RT_USING_SMP
-static void rt_thread_cpu_bind(rt_thread_t thread, int cpu)
+static rt_err_t rt_thread_cpu_affinity(rt_thread_t thread, rt_ubase_t cpu_affinity)
 {
+    int bind_cpu;
     rt_base_t level;
 
-    if (cpu >= RT_CPUS_NR)
+    cpu_affinity &= RT_CPU_MASK;
+    if (cpu_affinity == 0)
+    {
+        return -RT_EINVAL;
+    }
+
+    /* the thread could run on only one cpu is queued in the ready queue of that cpu */
+    if ((cpu_affinity & (cpu_affinity - 1)) == 0)
+    {
+        bind_cpu = __rt_ffs(cpu_affinity) - 1;
+    }
+    else
     {
-        cpu = RT_CPUS_NR;
+        bind_cpu = RT_CPUS_NR;
     }
 
     level = rt_hw_interrupt_disable();
+#ifdef RT_USING_SCHED_DEADLINE
+    if (thread->dl.runtime != 0)
+    {
+        /* the mask is kept for the deadline class, the thread runs on the cpu reserved */
+        if (rt_sched_deadline_affinity(thread, cpu_affinity) != RT_EOK)
+        {
+            rt_hw_interrupt_enable(level);
+            return -RT_EBUSY;
+        }
+        cpu_affinity = 1U << thread->dl.cpu;
+        bind_cpu = thread->dl.cpu;
+    }
+#endif /* RT_USING_SCHED_DEADLINE */
     if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
     {
-        /* unbind */
         /* remove from old ready queue */
         rt_schedule_remove_thread(thread);
-        /* change thread bind cpu */
-        thread->bind_cpu = cpu;
+        /* change thread affinity */
+        thread->bind_cpu = bind_cpu;
+        thread->cpu_affinity = cpu_affinity;
         /* add to new ready queue */
         rt_schedule_insert_thread(thread);
         if (rt_thread_self() != RT_NULL)
@@ -781,36 +856,31 @@ static void rt_thread_cpu_bind(rt_thread_t thread, int cpu)
     }
     else
     {
-        thread->bind_cpu = cpu;
-        if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
+        thread->bind_cpu = bind_cpu;
+        thread->cpu_affinity = cpu_affinity;
+        if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING &&
+            (cpu_affinity & (1U << thread->oncpu)) == 0)
         {
-            /* thread is running on a cpu */
-            int current_cpu = rt_hw_cpu_id();
-
-            if (cpu != RT_CPUS_NR)
+            /* thread is running on a cpu it could not run on any more */
+            if (thread->oncpu == rt_hw_cpu_id())
             {
-                if (thread->oncpu == current_cpu)
-                {
-                    /* current thread on current cpu */
-                    if (cpu != current_cpu)
-                    {
-                        /* bind to other cpu */
-                        rt_hw_ipi_send(RT_SCHEDULE_IPI, 1U << cpu);
-                        /* self cpu need reschedule */
-                        rt_schedule();
-                    }
-                    /* else do nothing */
-                }
-                else
-                {
-                    /* no running on self cpu, but dest cpu can be itself */
-                    rt_hw_ipi_send(RT_SCHEDULE_IPI, 1U << thread->oncpu);
-                }
+                /* self cpu need reschedule, the thread is queued to the allowed cpus */
+                rt_schedule();
+            }
+            else
+            {
+                rt_hw_ipi_send(RT_SCHEDULE_IPI, 1U << thread->oncpu);
             }
-            /* else do nothing */
         }
     }
     rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+static void rt_thread_cpu_bind(rt_thread_t thread, int cpu)
+{
+    rt_thread_cpu_affinity(thread, cpu < RT_CPUS_NR ? (1U << cpu) : RT_CPU_MASK);
 }
 #endif
 
@@ -829,6 +899,8 @@ static void rt_thread_cpu_bind(rt_thread_t thread, int cpu)
  *
  *              RT_THREAD_CTRL_BIND_CPU for bind the thread to a CPU.
  *
+ *              RT_THREAD_CTRL_SET_AFFINITY for setting the mask of CPUs the thread could run on.
+ *
  * @param   arg is the argument of control command.
  *
  * @return  Return the operation status. If the return value is RT_EOK, the function is successfully executed.
@@ -921,6 +993,11 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
         rt_thread_cpu_bind(thread, cpu);
         break;
     }
+
+    case RT_THREAD_CTRL_SET_AFFINITY:
+    {
+        return rt_thread_cpu_affinity(thread, (rt_ubase_t)arg);
+    }
 #endif /*RT_USING_SMP*/
     default:
         break;
@@ -1016,6 +1093,11 @@ rt_err_t rt_thread_suspend_with_flag(rt_thread_t thread, int suspend_flag)
     /* stop thread timer anyway */
     rt_timer_stop(&(thread->thread_timer));
 
+#ifdef RT_USING_WORKQUEUE_POOL
+    /* a blocked worker leaves its pending works to the other workers */
+    rt_workqueue_worker_sleeping(thread);
+#endif /* RT_USING_WORKQUEUE_POOL */
+
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
 